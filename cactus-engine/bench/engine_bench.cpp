@@ -0,0 +1,677 @@
+#include "cactus_engine.h"
+#include "cactus_graph.h"
+#include "../src/engine.h"
+#include "picojson.h"
+#include "synthetic_model.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct BenchOptions {
+    std::vector<std::string> archs;
+    std::string bundle;
+    std::string out_dir;
+    std::string json_path;
+    std::string label;
+    std::vector<size_t> prompt_lens = {32, 128, 512};
+    size_t decode_tokens = 64;
+    size_t repeat = 3;
+    size_t hidden_dim = 0;
+    size_t num_layers = 0;
+    size_t kv_trigger = 0;
+    std::vector<size_t> kv_bits;
+    std::vector<size_t> kv_contexts = {8192, 32768, 131072};
+    std::string kv_spill_dir;
+    bool keep = false;
+    bool generate_only = false;
+};
+
+struct RunResult {
+    size_t prompt_len = 0;
+    double ttft_ms = 0.0;
+    double prefill_tps = 0.0;
+    double decode_tps = 0.0;
+};
+
+struct LatencyResult {
+    std::string mode;
+    size_t tokens = 0;
+    size_t compactions = 0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+struct KvBitsResult {
+    size_t context = 0;
+    size_t bits = 0;
+    size_t tokens = 0;
+    double decode_tps = 0.0;
+    double ppl = 0.0;
+};
+
+struct KvTierResult {
+    std::string mode;
+    size_t context = 0;
+    double rss_mb = 0.0;
+    double decode_ms = 0.0;
+};
+
+struct ModelResult {
+    std::string name;
+    std::string dir;
+    size_t params = 0;
+    size_t weight_bytes = 0;
+    size_t source_len = 0;
+    double load_ms = 0.0;
+    long load_major_faults = 0;
+    std::vector<RunResult> runs;
+    std::vector<LatencyResult> latency;
+    std::vector<KvBitsResult> kv_bits;
+    std::vector<KvTierResult> kv_tier;
+    double peak_rss_mb = 0.0;
+    long major_faults = 0;
+    std::string error;
+};
+
+std::vector<std::string> split(const std::string& text, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, sep)) {
+        if (!item.empty()) parts.push_back(item);
+    }
+    return parts;
+}
+
+double median(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+double peak_rss_mb(const rusage& usage) {
+#ifdef __APPLE__
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+}
+
+double current_rss_mb() {
+#ifdef __APPLE__
+    mach_task_basic_info info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0.0;
+    }
+    return static_cast<double>(info.resident_size) / (1024.0 * 1024.0);
+#else
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return static_cast<double>(resident * sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+#endif
+}
+
+// Drops the bundle from the page cache so the load measures cold mmap faults rather than
+// a warm copy left by the generator or a previous run. Best effort: not all platforms honour it.
+void evict_from_page_cache(const std::string& dir) {
+#ifdef POSIX_FADV_DONTNEED
+    std::error_code ec;
+    for (const auto& entry : fs::recursive_directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file()) continue;
+        int fd = ::open(entry.path().c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#else
+    (void)dir;
+#endif
+}
+
+std::vector<uint32_t> make_prompt(size_t len) {
+    std::vector<uint32_t> prompt(len);
+    for (size_t i = 0; i < len; ++i) prompt[i] = static_cast<uint32_t>(32 + (i * 37) % 95);
+    return prompt;
+}
+
+double percentile(std::vector<double> values, double q) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t idx = static_cast<size_t>(q * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(idx, values.size() - 1)];
+}
+
+// Inter-token latency while decoding through two rolling KV compactions (trigger -> trigger / 2),
+// once with compaction inline at the trigger and once with background scoring.
+bool measure_inter_token(ModelResult& r, size_t trigger, const std::string& mode, const char* lead) {
+    setenv("CACTUS_KV_COMPRESS_AT", std::to_string(trigger).c_str(), 1);
+    setenv("CACTUS_KV_COMPRESS_TO", std::to_string(trigger / 2).c_str(), 1);
+    if (lead) setenv("CACTUS_KV_COMPRESS_ASYNC_LEAD", lead, 1);
+    else unsetenv("CACTUS_KV_COMPRESS_ASYNC_LEAD");
+    auto model = cactus::engine::create_model(r.dir);
+    const bool ok = model && model->init(r.dir, 4 * trigger, "", false);
+    unsetenv("CACTUS_KV_COMPRESS_AT");
+    unsetenv("CACTUS_KV_COMPRESS_TO");
+    unsetenv("CACTUS_KV_COMPRESS_ASYNC_LEAD");
+    if (!ok) {
+        r.error = "init failed for inter-token latency run";
+        return false;
+    }
+    const auto prompt = make_prompt(64);
+    model->prefill(std::vector<uint32_t>(prompt.begin(), prompt.end() - 1), model->get_prefill_chunk_size());
+    uint32_t token = prompt.back();
+    LatencyResult out;
+    out.mode = mode;
+    std::vector<double> samples;
+    size_t previous = model->get_cache_size();
+    for (size_t step = 0; step < 2 * trigger; ++step) {
+        auto start = std::chrono::steady_clock::now();
+        token = model->decode({token});
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        size_t len = model->get_cache_size();
+        if (len < previous) ++out.compactions;
+        previous = len;
+    }
+    out.tokens = samples.size();
+    out.p50_ms = percentile(samples, 0.50);
+    out.p99_ms = percentile(samples, 0.99);
+    out.max_ms = percentile(samples, 1.0);
+    r.latency.push_back(out);
+    return true;
+}
+
+// Decode throughput and perplexity of `scored` teacher-forced tokens after a `context`-token
+// prefill, with the KV cache stored at `bits` (8 = the default INT8 cache).
+bool measure_kv_bits(ModelResult& r, size_t context, size_t bits, size_t scored) {
+    if (bits == 8) unsetenv("CACTUS_KV_CACHE_BITS");
+    else setenv("CACTUS_KV_CACHE_BITS", std::to_string(bits).c_str(), 1);
+    // Compaction only runs on the INT8 cache; off for every width so all of them keep the full context.
+    setenv("CACTUS_KV_COMPRESS_AT", "0", 1);
+    auto model = cactus::engine::create_model(r.dir);
+    const bool ok = model && model->init(r.dir, context + scored + 8, "", false);
+    unsetenv("CACTUS_KV_COMPRESS_AT");
+    if (!ok) {
+        r.error = "init failed for kv-bits run";
+        return false;
+    }
+    const auto tokens = make_prompt(context + scored);
+    model->prefill(std::vector<uint32_t>(tokens.begin(), tokens.begin() + context - 1), model->get_prefill_chunk_size());
+    double seconds = 0.0, logprob = 0.0;
+    for (size_t i = context; i < context + scored; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        model->decode({tokens[i - 1]});
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        logprob += model->last_token_logprob(tokens[i]);
+    }
+    r.kv_bits.push_back({context, bits, scored, seconds > 0.0 ? scored / seconds : 0.0,
+                         std::exp(-logprob / static_cast<double>(scored))});
+    return true;
+}
+
+// One session grows through `contexts`; at each length the median decode step and the current
+// resident set are recorded. With `spill_dir` the KV cache lives in a file there instead of RAM.
+bool measure_kv_tier(ModelResult& r, std::vector<size_t> contexts, size_t decode, const std::string& spill_dir) {
+    if (spill_dir.empty()) unsetenv("CACTUS_KV_SPILL_DIR");
+    else setenv("CACTUS_KV_SPILL_DIR", spill_dir.c_str(), 1);
+    // A spilled cache is never compacted; the resident run must not be either, or it holds fewer rows.
+    setenv("CACTUS_KV_COMPRESS_AT", "0", 1);
+    std::sort(contexts.begin(), contexts.end());
+    auto model = cactus::engine::create_model(r.dir);
+    const size_t total = contexts.back() + decode * contexts.size() + 8;
+    const bool ok = model && model->init(r.dir, total, "", false);
+    unsetenv("CACTUS_KV_COMPRESS_AT");
+    unsetenv("CACTUS_KV_SPILL_DIR");
+    if (!ok) {
+        r.error = "init failed for kv-spill run";
+        return false;
+    }
+    const auto tokens = make_prompt(total);
+    size_t fed = 0;
+    for (size_t context : contexts) {
+        if (context > fed) {
+            model->prefill(std::vector<uint32_t>(tokens.begin() + fed, tokens.begin() + context), model->get_prefill_chunk_size());
+            fed = context;
+        }
+        std::vector<double> steps;
+        for (size_t i = 0; i < decode; ++i, ++fed) {
+            auto start = std::chrono::steady_clock::now();
+            model->decode({tokens[fed]});
+            steps.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        r.kv_tier.push_back({spill_dir.empty() ? "resident" : "spill", context, current_rss_mb(), median(steps)});
+    }
+    return true;
+}
+
+// Runs in a forked child so ru_maxrss and ru_majflt describe this model alone.
+std::string measure(ModelResult r, const BenchOptions& opts) {
+    evict_from_page_cache(r.dir);
+    rusage before{};
+    getrusage(RUSAGE_SELF, &before);
+    auto start = std::chrono::steady_clock::now();
+    cactus_model_t model = cactus_init(r.dir.c_str(), nullptr, false);
+    r.load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    rusage loaded{};
+    getrusage(RUSAGE_SELF, &loaded);
+    r.load_major_faults = loaded.ru_majflt - before.ru_majflt;
+    if (!model) {
+        const char* err = cactus_get_last_error();
+        r.error = err ? err : "cactus_init failed";
+    }
+
+    std::vector<char> buffer(1 << 20);
+    for (size_t len : opts.prompt_lens) {
+        if (!model) break;
+        if (r.source_len && len > r.source_len) len = r.source_len;
+        const auto prompt = make_prompt(len);
+        std::vector<double> ttft, prefill, decode;
+        for (size_t rep = 0; rep < opts.repeat; ++rep) {
+            if (cactus_benchmark_tokens(model, prompt.data(), prompt.size(), opts.decode_tokens,
+                                        buffer.data(), buffer.size()) < 0) {
+                r.error = buffer.data();
+                break;
+            }
+            picojson::value json;
+            picojson::parse(json, std::string(buffer.data()));
+            ttft.push_back(json.get("time_to_first_token_ms").get<double>());
+            prefill.push_back(json.get("prefill_tps").get<double>());
+            decode.push_back(json.get("decode_tps").get<double>());
+        }
+        if (!r.error.empty()) break;
+        r.runs.push_back({len, median(ttft), median(prefill), median(decode)});
+    }
+    if (model) cactus_destroy(model);
+    if (r.error.empty() && opts.kv_trigger > 0) {
+        if (measure_inter_token(r, opts.kv_trigger, "sync", "0")) {
+            measure_inter_token(r, opts.kv_trigger, "async", nullptr);
+        }
+    }
+    // Whisper's decoder context is capped by its fixed source window.
+    if (r.error.empty() && !r.source_len && !opts.kv_spill_dir.empty()) {
+        const size_t decode = std::max<size_t>(opts.decode_tokens, 1);
+        if (measure_kv_tier(r, opts.kv_contexts, decode, "")) {
+            measure_kv_tier(r, opts.kv_contexts, decode, opts.kv_spill_dir);
+        }
+    }
+    for (size_t context : opts.kv_contexts) {
+        if (!r.error.empty() || r.source_len) break;
+        for (size_t bits : opts.kv_bits) {
+            if (!measure_kv_bits(r, context, bits, std::max<size_t>(opts.decode_tokens, 1))) break;
+        }
+    }
+
+    rusage after{};
+    getrusage(RUSAGE_SELF, &after);
+    r.peak_rss_mb = peak_rss_mb(after);
+    r.major_faults = after.ru_majflt - before.ru_majflt;
+
+    picojson::array runs;
+    for (const auto& run : r.runs) {
+        picojson::object o;
+        o["prompt_tokens"] = picojson::value(static_cast<double>(run.prompt_len));
+        o["ttft_ms"] = picojson::value(run.ttft_ms);
+        o["prefill_tps"] = picojson::value(run.prefill_tps);
+        o["decode_tps"] = picojson::value(run.decode_tps);
+        runs.emplace_back(o);
+    }
+    picojson::array latency;
+    for (const auto& l : r.latency) {
+        picojson::object o;
+        o["mode"] = picojson::value(l.mode);
+        o["tokens"] = picojson::value(static_cast<double>(l.tokens));
+        o["compactions"] = picojson::value(static_cast<double>(l.compactions));
+        o["p50_ms"] = picojson::value(l.p50_ms);
+        o["p99_ms"] = picojson::value(l.p99_ms);
+        o["max_ms"] = picojson::value(l.max_ms);
+        latency.emplace_back(o);
+    }
+    picojson::array kv_bits;
+    for (const auto& k : r.kv_bits) {
+        picojson::object o;
+        o["context"] = picojson::value(static_cast<double>(k.context));
+        o["bits"] = picojson::value(static_cast<double>(k.bits));
+        o["tokens"] = picojson::value(static_cast<double>(k.tokens));
+        o["decode_tps"] = picojson::value(k.decode_tps);
+        o["ppl"] = picojson::value(k.ppl);
+        kv_bits.emplace_back(o);
+    }
+    picojson::array kv_tier;
+    for (const auto& t : r.kv_tier) {
+        picojson::object o;
+        o["mode"] = picojson::value(t.mode);
+        o["context"] = picojson::value(static_cast<double>(t.context));
+        o["rss_mb"] = picojson::value(t.rss_mb);
+        o["decode_ms"] = picojson::value(t.decode_ms);
+        kv_tier.emplace_back(o);
+    }
+    picojson::object o;
+    o["kv_bits"] = picojson::value(kv_bits);
+    o["kv_tier"] = picojson::value(kv_tier);
+    o["latency"] = picojson::value(latency);
+    o["load_ms"] = picojson::value(r.load_ms);
+    o["load_major_faults"] = picojson::value(static_cast<double>(r.load_major_faults));
+    o["peak_rss_mb"] = picojson::value(r.peak_rss_mb);
+    o["major_faults"] = picojson::value(static_cast<double>(r.major_faults));
+    o["runs"] = picojson::value(runs);
+    if (!r.error.empty()) o["error"] = picojson::value(r.error);
+    return picojson::value(o).serialize();
+}
+
+void run_isolated(ModelResult& r, const BenchOptions& opts) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        r.error = "pipe failed";
+        return;
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        r.error = std::string("fork failed: ") + std::strerror(errno);
+        return;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        std::string payload = measure(r, opts);
+        size_t written = 0;
+        while (written < payload.size()) {
+            ssize_t n = write(fds[1], payload.data() + written, payload.size() - written);
+            if (n <= 0) break;
+            written += static_cast<size_t>(n);
+        }
+        close(fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    std::string payload;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = read(fds[0], chunk, sizeof(chunk))) > 0) payload.append(chunk, static_cast<size_t>(n));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    picojson::value json;
+    if (!picojson::parse(json, payload).empty() || !json.is<picojson::object>()) {
+        r.error = "benchmark process exited with status " + std::to_string(status);
+        return;
+    }
+    r.load_ms = json.get("load_ms").get<double>();
+    r.load_major_faults = static_cast<long>(json.get("load_major_faults").get<double>());
+    r.peak_rss_mb = json.get("peak_rss_mb").get<double>();
+    r.major_faults = static_cast<long>(json.get("major_faults").get<double>());
+    if (json.contains("error")) r.error = json.get("error").to_str();
+    for (const auto& run : json.get("runs").get<picojson::array>()) {
+        r.runs.push_back({static_cast<size_t>(run.get("prompt_tokens").get<double>()),
+                          run.get("ttft_ms").get<double>(), run.get("prefill_tps").get<double>(),
+                          run.get("decode_tps").get<double>()});
+    }
+    for (const auto& l : json.get("latency").get<picojson::array>()) {
+        r.latency.push_back({l.get("mode").to_str(), static_cast<size_t>(l.get("tokens").get<double>()),
+                             static_cast<size_t>(l.get("compactions").get<double>()), l.get("p50_ms").get<double>(),
+                             l.get("p99_ms").get<double>(), l.get("max_ms").get<double>()});
+    }
+    for (const auto& k : json.get("kv_bits").get<picojson::array>()) {
+        r.kv_bits.push_back({static_cast<size_t>(k.get("context").get<double>()),
+                             static_cast<size_t>(k.get("bits").get<double>()),
+                             static_cast<size_t>(k.get("tokens").get<double>()),
+                             k.get("decode_tps").get<double>(), k.get("ppl").get<double>()});
+    }
+    for (const auto& t : json.get("kv_tier").get<picojson::array>()) {
+        r.kv_tier.push_back({t.get("mode").get<std::string>(), static_cast<size_t>(t.get("context").get<double>()),
+                             t.get("rss_mb").get<double>(), t.get("decode_ms").get<double>()});
+    }
+}
+
+// Perplexity of the same context at 8 bits, the baseline low-bit runs are compared against.
+double baseline_ppl(const ModelResult& r, size_t context) {
+    for (const auto& k : r.kv_bits) {
+        if (k.context == context && k.bits == 8) return k.ppl;
+    }
+    return 0.0;
+}
+
+std::string json_escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+    return out;
+}
+
+void write_json(const std::string& path, const BenchOptions& opts, const std::vector<ModelResult>& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open " << path << "\n";
+        return;
+    }
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"label\": \"" << json_escape(opts.label) << "\",\n"
+        << "  \"threads\": " << CactusThreading::get_thread_pool().num_workers() << ",\n"
+        << "  \"decode_tokens\": " << opts.decode_tokens << ",\n"
+        << "  \"repeat\": " << opts.repeat << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\"model\": \"" << json_escape(r.name) << "\", \"params\": " << r.params
+            << ", \"weight_bytes\": " << r.weight_bytes << ", \"load_ms\": " << r.load_ms
+            << ", \"load_major_faults\": " << r.load_major_faults
+            << ", \"peak_rss_mb\": " << r.peak_rss_mb << ", \"major_faults\": " << r.major_faults;
+        if (!r.error.empty()) out << ", \"error\": \"" << json_escape(r.error) << "\"";
+        out << ",\n     \"runs\": [";
+        for (size_t j = 0; j < r.runs.size(); ++j) {
+            const auto& run = r.runs[j];
+            out << (j ? ", " : "") << "{\"prompt_tokens\": " << run.prompt_len << ", \"ttft_ms\": " << run.ttft_ms
+                << ", \"prefill_tps\": " << run.prefill_tps << ", \"decode_tps\": " << run.decode_tps << "}";
+        }
+        out << "]";
+        if (!r.latency.empty()) {
+            out << ",\n     \"inter_token\": {\"kv_trigger\": " << opts.kv_trigger << ", \"modes\": [";
+            for (size_t j = 0; j < r.latency.size(); ++j) {
+                const auto& l = r.latency[j];
+                out << (j ? ", " : "") << "{\"mode\": \"" << l.mode << "\", \"tokens\": " << l.tokens
+                    << ", \"compactions\": " << l.compactions << ", \"p50_ms\": " << l.p50_ms
+                    << ", \"p99_ms\": " << l.p99_ms << ", \"max_ms\": " << l.max_ms << "}";
+            }
+            out << "]}";
+        }
+        if (!r.kv_bits.empty()) {
+            out << ",\n     \"kv_bits\": [";
+            for (size_t j = 0; j < r.kv_bits.size(); ++j) {
+                const auto& k = r.kv_bits[j];
+                const double base = baseline_ppl(r, k.context);
+                out << (j ? ", " : "") << "{\"context\": " << k.context << ", \"bits\": " << k.bits
+                    << ", \"tokens\": " << k.tokens << ", \"decode_tps\": " << k.decode_tps
+                    << ", \"ppl\": " << k.ppl << ", \"ppl_delta\": " << (base > 0.0 ? k.ppl - base : 0.0) << "}";
+            }
+            out << "]";
+        }
+        if (!r.kv_tier.empty()) {
+            out << ",\n     \"kv_tier\": [";
+            for (size_t j = 0; j < r.kv_tier.size(); ++j) {
+                const auto& t = r.kv_tier[j];
+                out << (j ? ", " : "") << "{\"mode\": \"" << t.mode << "\", \"context\": " << t.context
+                    << ", \"rss_mb\": " << t.rss_mb << ", \"decode_ms\": " << t.decode_ms << "}";
+            }
+            out << "]";
+        }
+        out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+void print_usage() {
+    std::cout << "usage: cactus_engine_bench [--arch dense,moe,hybrid,whisper] [--bundle DIR]\n"
+              << "                           [--out DIR] [--keep] [--generate-only]\n"
+              << "                           [--prompt-lens 32,128,512] [--decode-tokens N] [--repeat N]\n"
+              << "                           [--hidden N] [--layers N] [--kv-trigger N]\n"
+              << "                           [--kv-bits 8,4,2] [--kv-contexts 8192,32768,131072]\n"
+              << "                           [--kv-spill DIR]\n"
+              << "                           [--json FILE] [--label TEXT]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                print_usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        auto next_size = [&]() { return static_cast<size_t>(std::max(0L, std::atol(next().c_str()))); };
+        if (arg == "--arch") opts.archs = split(next(), ',');
+        else if (arg == "--bundle") opts.bundle = next();
+        else if (arg == "--out") opts.out_dir = next();
+        else if (arg == "--keep") opts.keep = true;
+        else if (arg == "--generate-only") opts.generate_only = opts.keep = true;
+        else if (arg == "--prompt-lens") {
+            opts.prompt_lens.clear();
+            for (const auto& s : split(next(), ',')) opts.prompt_lens.push_back(std::max(1L, std::atol(s.c_str())));
+        }
+        else if (arg == "--decode-tokens") opts.decode_tokens = next_size();
+        else if (arg == "--repeat") opts.repeat = std::max<size_t>(1, next_size());
+        else if (arg == "--hidden") opts.hidden_dim = next_size();
+        else if (arg == "--layers") opts.num_layers = next_size();
+        else if (arg == "--kv-trigger") opts.kv_trigger = next_size();
+        else if (arg == "--kv-bits" || arg == "--kv-contexts") {
+            auto& list = arg == "--kv-bits" ? opts.kv_bits : opts.kv_contexts;
+            list.clear();
+            for (const auto& s : split(next(), ',')) list.push_back(std::max(1L, std::atol(s.c_str())));
+        }
+        else if (arg == "--kv-spill") opts.kv_spill_dir = next();
+        else if (arg == "--json") opts.json_path = next();
+        else if (arg == "--label") opts.label = next();
+        else {
+            print_usage();
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    std::vector<ModelResult> results;
+    const bool generated = opts.bundle.empty();
+    if (generated) {
+        if (opts.archs.empty()) opts.archs = cactus::synthetic::architectures();
+        if (opts.out_dir.empty()) {
+            opts.out_dir = (fs::temp_directory_path() / ("cactus_engine_bench_" + std::to_string(getpid()))).string();
+        }
+        for (const auto& arch : opts.archs) {
+            ModelResult r;
+            r.name = arch;
+            try {
+                auto spec = cactus::synthetic::preset(arch);
+                if (opts.hidden_dim) {
+                    spec.hidden_dim = opts.hidden_dim;
+                    spec.ffn_dim = opts.hidden_dim * 3;
+                }
+                if (opts.num_layers) spec.num_layers = opts.num_layers;
+                spec.context_length = std::max(spec.context_length, 2 * opts.kv_trigger);
+                if (!opts.kv_bits.empty() || !opts.kv_spill_dir.empty()) {
+                    const size_t longest = *std::max_element(opts.kv_contexts.begin(), opts.kv_contexts.end());
+                    spec.context_length = std::max(spec.context_length,
+                                                   longest + opts.decode_tokens * opts.kv_contexts.size() + 8);
+                }
+                if (arch == "whisper") r.source_len = spec.source_len;
+                auto info = cactus::synthetic::write_bundle(spec, opts.out_dir + "/" + arch);
+                r.dir = info.dir;
+                r.params = info.parameter_count;
+                r.weight_bytes = info.weight_bytes;
+            } catch (const std::exception& e) {
+                r.error = e.what();
+            }
+            results.push_back(std::move(r));
+        }
+    } else {
+        ModelResult r;
+        r.name = fs::path(opts.bundle).filename().string();
+        r.dir = opts.bundle;
+        std::error_code ec;
+        for (const auto& entry : fs::recursive_directory_iterator(opts.bundle, ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".weights") r.weight_bytes += entry.file_size();
+        }
+        results.push_back(std::move(r));
+    }
+
+    if (opts.generate_only) {
+        for (const auto& r : results) {
+            std::cout << r.name << " " << (r.error.empty() ? r.dir : "error: " + r.error) << "\n";
+        }
+        return 0;
+    }
+
+    std::cout << std::left << std::setw(12) << "model" << std::right << std::setw(10) << "load ms"
+              << std::setw(8) << "prompt" << std::setw(10) << "ttft ms" << std::setw(12) << "prefill/s"
+              << std::setw(10) << "decode/s" << std::setw(10) << "rss MB" << std::setw(8) << "majflt" << "\n";
+    for (auto& r : results) {
+        if (r.error.empty()) run_isolated(r, opts);
+        for (const auto& run : r.runs) {
+            std::cout << std::left << std::setw(12) << r.name << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(10) << r.load_ms << std::setw(8) << run.prompt_len
+                      << std::setw(10) << run.ttft_ms << std::setw(12) << run.prefill_tps
+                      << std::setw(10) << run.decode_tps << std::setw(10) << r.peak_rss_mb
+                      << std::setw(8) << r.major_faults << "\n";
+        }
+        for (const auto& l : r.latency) {
+            std::cout << std::left << std::setw(12) << r.name << " inter-token " << std::setw(6) << l.mode
+                      << std::fixed << std::setprecision(2) << " p50 " << l.p50_ms << " ms  p99 " << l.p99_ms
+                      << " ms  max " << l.max_ms << " ms  (" << l.compactions << " compactions over "
+                      << l.tokens << " tokens)\n";
+        }
+        for (const auto& k : r.kv_bits) {
+            const double base = baseline_ppl(r, k.context);
+            std::cout << std::left << std::setw(12) << r.name << " kv " << k.bits << "-bit ctx " << std::setw(7)
+                      << k.context << std::fixed << std::setprecision(2) << " decode/s " << k.decode_tps
+                      << "  ppl " << std::setprecision(4) << k.ppl;
+            if (base > 0.0 && k.bits != 8) std::cout << "  (delta " << std::showpos << k.ppl - base << std::noshowpos << ")";
+            std::cout << "\n";
+        }
+        for (const auto& t : r.kv_tier) {
+            std::cout << std::left << std::setw(12) << r.name << " kv " << std::setw(8) << t.mode << " ctx "
+                      << std::setw(7) << t.context << std::fixed << std::setprecision(2) << " rss "
+                      << t.rss_mb << " MB  decode " << t.decode_ms << " ms/token\n";
+        }
+        if (!r.error.empty()) std::cout << std::left << std::setw(12) << r.name << " error: " << r.error << "\n";
+    }
+
+    if (!opts.json_path.empty()) write_json(opts.json_path, opts, results);
+    if (generated && !opts.keep) fs::remove_all(opts.out_dir);
+    bool ok = std::all_of(results.begin(), results.end(), [](const ModelResult& r) { return r.error.empty(); });
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,465 @@
+#include "synthetic_model.h"
+
+#include "cactus_graph.h"
+#include "picojson.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace cactus {
+namespace synthetic {
+
+namespace {
+
+constexpr size_t AUTO_POSITION = std::numeric_limits<size_t>::max();
+constexpr size_t CACHE_ONLY_POSITION = std::numeric_limits<size_t>::max() - 1;
+
+struct CacheState {
+    std::string layer_key;
+    size_t key = 0;
+    size_t value = 0;
+};
+
+struct Component {
+    std::string name;
+    CactusGraph graph;
+    std::vector<std::pair<std::string, size_t>> inputs;
+    std::vector<std::pair<std::string, size_t>> outputs;
+    std::vector<std::pair<size_t, std::string>> bindings;
+    std::vector<CacheState> cache_states;
+    std::map<std::string, std::string> metadata;
+
+    explicit Component(std::string n) : name(std::move(n)) {}
+
+    size_t input(const std::string& logical, const std::vector<size_t>& shape, Precision precision) {
+        size_t id = graph.input(shape, precision);
+        inputs.emplace_back(logical, id);
+        return id;
+    }
+
+    void output(const std::string& logical, size_t id) { outputs.emplace_back(logical, id); }
+};
+
+uint64_t fnv1a(const std::string& s) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+class BundleWriter {
+public:
+    BundleWriter(const ModelSpec& spec, const fs::path& dir) : spec_(spec), dir_(dir) {
+        fs::create_directories(dir_ / "components");
+        fs::create_directories(dir_ / "weights");
+    }
+
+    // Weights are shared between the step and chunk graphs of a component family,
+    // so each named tensor is written once and bound wherever it is used.
+    size_t weight(Component& c, const std::string& name, const std::vector<size_t>& shape, float scale) {
+        const std::string rel = "weights/" + name + ".weights";
+        if (!written_.count(name)) {
+            size_t count = 1;
+            for (size_t d : shape) count *= d;
+            std::vector<__fp16> data(count);
+            uint64_t state = fnv1a(name) ^ (static_cast<uint64_t>(spec_.seed) << 32) ^ 0x9e3779b97f4a7c15ull;
+            for (size_t i = 0; i < count; ++i) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                float u = static_cast<float>(state >> 40) / static_cast<float>(1ull << 24);
+                data[i] = static_cast<__fp16>(scale < 0.0f ? -scale : (2.0f * u - 1.0f) * scale);
+            }
+            CactusGraph tmp;
+            size_t id = tmp.input(shape, Precision::FP16);
+            tmp.set_input(id, data.data(), Precision::FP16);
+            GraphFile::save_node(tmp, id, (dir_ / rel).string());
+            written_.insert(name);
+            info_.parameter_count += count;
+            info_.weight_bytes += count * sizeof(__fp16);
+        }
+        size_t node = c.graph.input(shape, Precision::FP16);
+        c.bindings.emplace_back(node, rel);
+        return node;
+    }
+
+    size_t linear(Component& c, size_t x, const std::string& name, size_t out_dim, size_t in_dim) {
+        size_t w = weight(c, name, {out_dim, in_dim}, 1.0f / std::sqrt(static_cast<float>(in_dim)));
+        return c.graph.matmul(x, w, true);
+    }
+
+    size_t norm(Component& c, size_t x, const std::string& name) {
+        return c.graph.rms_norm(x, weight(c, name, {spec_.hidden_dim}, -1.0f), 1e-6f);
+    }
+
+    void finish(Component& c) {
+        const std::string rel = "components/" + c.name + ".cg";
+        c.graph.save((dir_ / rel).string());
+
+        picojson::array input_ids, input_names, output_ids, output_names, bindings, caches;
+        for (const auto& [name, id] : c.inputs) {
+            input_ids.emplace_back(static_cast<double>(id));
+            input_names.emplace_back(name);
+        }
+        for (const auto& [name, id] : c.outputs) {
+            output_ids.emplace_back(static_cast<double>(id));
+            output_names.emplace_back(name);
+        }
+        for (const auto& [id, path] : c.bindings) {
+            picojson::object b;
+            b["node_id"] = picojson::value(static_cast<double>(id));
+            b["path"] = picojson::value(path);
+            bindings.emplace_back(b);
+        }
+        for (const auto& cs : c.cache_states) {
+            picojson::object s;
+            s["layer_key"] = picojson::value(cs.layer_key);
+            s["key"] = picojson::value(static_cast<double>(cs.key));
+            s["value"] = picojson::value(static_cast<double>(cs.value));
+            caches.emplace_back(s);
+        }
+        picojson::object meta;
+        meta["family"] = picojson::value("synthetic_" + spec_.arch);
+        for (const auto& [k, v] : c.metadata) meta[k] = picojson::value(v);
+
+        picojson::object entry;
+        entry["component"] = picojson::value(c.name);
+        entry["graph"] = picojson::value(rel);
+        entry["runtime_input_node_ids"] = picojson::value(input_ids);
+        entry["logical_inputs"] = picojson::value(input_names);
+        entry["output_node_ids"] = picojson::value(output_ids);
+        entry["logical_outputs"] = picojson::value(output_names);
+        entry["metadata"] = picojson::value(meta);
+        entry["bound_constant_bindings"] = picojson::value(bindings);
+        entry["cache_state_node_ids"] = picojson::value(caches);
+        components_.emplace_back(entry);
+        info_.components.push_back(c.name);
+    }
+
+    BundleInfo close() {
+        picojson::object root;
+        root["family"] = picojson::value("synthetic_" + spec_.arch);
+        root["components"] = picojson::value(components_);
+        std::ofstream out(dir_ / "components" / "manifest.json");
+        out << picojson::value(root).serialize(true);
+        if (!out) throw std::runtime_error("failed to write manifest under " + dir_.string());
+        info_.dir = dir_.string();
+        return info_;
+    }
+
+private:
+    const ModelSpec& spec_;
+    fs::path dir_;
+    std::unordered_set<std::string> written_;
+    picojson::array components_;
+    BundleInfo info_;
+};
+
+bool is_attention_layer(const ModelSpec& s, size_t layer) {
+    if (s.arch != "hybrid") return true;
+    size_t every = s.attention_every ? s.attention_every : 1;
+    return layer % every == every - 1;
+}
+
+// [1, T] token ids -> [1, T, H] embeddings, mirroring lm_encoder_step / lm_encoder_text_chunk.
+void build_token_encoder(BundleWriter& w, const ModelSpec& s, const std::string& name, size_t tokens) {
+    Component c(name);
+    size_t ids = c.input("input_ids", {1, tokens}, Precision::FP32);
+    c.input("position_ids", {1, tokens}, Precision::FP32);
+    size_t table = w.weight(c, "embed_tokens", {s.vocab_size, s.hidden_dim}, 0.5f);
+    c.output("inputs_embeds", c.graph.embedding(table, ids));
+    w.finish(c);
+}
+
+size_t self_attention(BundleWriter& w, Component& c, const ModelSpec& s, size_t x, size_t tokens,
+                      const std::string& prefix) {
+    auto& g = c.graph;
+    const size_t H = s.hidden_dim, D = s.head_dim;
+    size_t q = g.reshape(w.linear(c, x, prefix + "q_proj", s.num_heads * D, H), {1, tokens, s.num_heads, D});
+    size_t k = g.reshape(w.linear(c, x, prefix + "k_proj", s.num_kv_heads * D, H), {1, tokens, s.num_kv_heads, D});
+    size_t v = g.reshape(w.linear(c, x, prefix + "v_proj", s.num_kv_heads * D, H), {1, tokens, s.num_kv_heads, D});
+    q = g.rope(q, s.rope_theta);
+    k = g.rope(k, s.rope_theta);
+    size_t k_cache = g.kv_cache_state(s.context_length, s.num_kv_heads, D);
+    size_t v_cache = g.kv_cache_state(s.context_length, s.num_kv_heads, D);
+    c.cache_states.push_back({prefix + "self_attn", k_cache, v_cache});
+    g.kv_cache_append(k, k_cache);
+    g.kv_cache_append(v, v_cache);
+    size_t attn = g.attention_cached(q, k, v, k_cache, v_cache, 1.0f / std::sqrt(static_cast<float>(D)), AUTO_POSITION);
+    return w.linear(c, g.reshape(attn, {tokens, s.num_heads * D}), prefix + "o_proj", H, s.num_heads * D);
+}
+
+// LFM2-style gated short convolution with a rolling conv cache; the step graph
+// convolves the cached window, the chunk graph convolves the chunk and refreshes the cache.
+size_t short_conv(BundleWriter& w, Component& c, const ModelSpec& s, size_t x, size_t tokens,
+                  const std::string& prefix) {
+    auto& g = c.graph;
+    const size_t H = s.hidden_dim, K = s.conv_kernel;
+    size_t b = w.linear(c, x, prefix + "conv.b_proj", H, H);
+    size_t gate = w.linear(c, x, prefix + "conv.c_proj", H, H);
+    size_t xv = w.linear(c, x, prefix + "conv.x_proj", H, H);
+    size_t bx = g.multiply(b, xv);
+    size_t kernel = w.weight(c, prefix + "conv.weight", {H, 1, K}, 1.0f / std::sqrt(static_cast<float>(K)));
+    size_t cache = g.conv_cache_state(K, H);
+    c.cache_states.push_back({"conv:" + prefix + "conv", cache, cache});
+    size_t conv;
+    if (tokens > 1) {
+        g.conv_cache_append(bx, cache);
+        conv = g.conv1d_causal(g.reshape(bx, {1, tokens, H}), kernel, K);
+    } else {
+        size_t window = g.conv_cache_append(bx, cache);
+        conv = g.conv1d_causal(g.reshape(window, {1, K, H}), kernel, K);
+        conv = g.slice(conv, 1, K - 1, 1);
+    }
+    size_t y = g.multiply(gate, g.reshape(conv, {tokens, H}));
+    return w.linear(c, y, prefix + "conv.out_proj", H, H);
+}
+
+size_t feed_forward(BundleWriter& w, Component& c, const ModelSpec& s, size_t x, const std::string& prefix) {
+    auto& g = c.graph;
+    const size_t H = s.hidden_dim;
+    if (s.arch == "moe") {
+        const size_t E = s.num_experts, I = s.moe_ffn_dim;
+        size_t probs = g.softmax(w.linear(c, x, prefix + "router", E, H), -1);
+        size_t topk = g.index(g.topk(probs, s.experts_per_tok), 0, 0);
+        std::vector<size_t> w1, w3, w2;
+        for (size_t e = 0; e < E; ++e) {
+            const std::string ep = prefix + "experts." + std::to_string(e) + ".";
+            w1.push_back(w.weight(c, ep + "w1", {I, H}, 1.0f / std::sqrt(static_cast<float>(H))));
+            w3.push_back(w.weight(c, ep + "w3", {I, H}, 1.0f / std::sqrt(static_cast<float>(H))));
+            w2.push_back(w.weight(c, ep + "w2", {H, I}, 1.0f / std::sqrt(static_cast<float>(I))));
+        }
+        return g.moe_layer(x, probs, topk, w1, w3, w2, E, s.experts_per_tok, true, 1e-6f, 1.0f);
+    }
+    size_t gate = w.linear(c, x, prefix + "mlp.gate_proj", s.ffn_dim, H);
+    size_t up = w.linear(c, x, prefix + "mlp.up_proj", s.ffn_dim, H);
+    return w.linear(c, g.multiply(g.silu(gate), up), prefix + "mlp.down_proj", H, s.ffn_dim);
+}
+
+// inputs_embeds [1, T, H] -> logits [T, V]; shared by decoder_step and decoder_prefill_chunk.
+void build_decoder(BundleWriter& w, const ModelSpec& s, const std::string& name, size_t tokens) {
+    Component c(name);
+    auto& g = c.graph;
+    size_t h = g.reshape(c.input("inputs_embeds", {1, tokens, s.hidden_dim}, Precision::FP16), {tokens, s.hidden_dim});
+    for (size_t l = 0; l < s.num_layers; ++l) {
+        const std::string prefix = "layers." + std::to_string(l) + ".";
+        size_t x = w.norm(c, h, prefix + "input_norm");
+        size_t mixed = is_attention_layer(s, l) ? self_attention(w, c, s, x, tokens, prefix)
+                                                : short_conv(w, c, s, x, tokens, prefix);
+        h = g.add(h, mixed);
+        h = g.add(h, feed_forward(w, c, s, w.norm(c, h, prefix + "post_attention_norm"), prefix));
+    }
+    size_t logits = w.linear(c, w.norm(c, h, "norm"), "lm_head", s.vocab_size, s.hidden_dim);
+    c.output("logits", logits);
+    w.finish(c);
+}
+
+size_t cross_kv_cache_bytes(size_t max_seq, size_t kv_heads, size_t head_dim) {
+    size_t groups = (head_dim + KV_QUANT_GROUP_SIZE - 1) / KV_QUANT_GROUP_SIZE;
+    return 64 + max_seq * kv_heads * head_dim + max_seq * kv_heads * groups * sizeof(float);
+}
+
+size_t gelu_mlp(BundleWriter& w, Component& c, const ModelSpec& s, size_t x, const std::string& prefix) {
+    size_t hidden = c.graph.gelu(w.linear(c, x, prefix + "fc1", s.ffn_dim, s.hidden_dim));
+    return w.linear(c, hidden, prefix + "fc2", s.hidden_dim, s.ffn_dim);
+}
+
+// Encoder/decoder split used by the encoder_cross_kv_decoder_step route: a fixed-window
+// bidirectional encoder, a component that projects its states to per-layer cross K/V,
+// and a cached decoder step that attends over its own KV cache plus the cross cache.
+void build_whisper(BundleWriter& w, const ModelSpec& s) {
+    const size_t S = s.source_len, H = s.hidden_dim, D = s.head_dim;
+    const float scale = 1.0f / std::sqrt(static_cast<float>(D));
+    const std::string route = "encoder_cross_kv_decoder_step";
+    {
+        Component c("source_encoder");
+        auto& g = c.graph;
+        c.metadata = {{"runtime_route", route}, {"runtime_role", "source_encoder"}, {"source_kind", "text_tokens"}};
+        size_t ids = c.input("input_ids", {1, S}, Precision::FP32);
+        size_t h = g.reshape(g.embedding(w.weight(c, "encoder.embed_tokens", {s.vocab_size, H}, 0.5f), ids), {S, H});
+        for (size_t l = 0; l < s.encoder_layers; ++l) {
+            const std::string p = "encoder.layers." + std::to_string(l) + ".";
+            size_t x = w.norm(c, h, p + "self_attn_norm");
+            size_t q = g.reshape(w.linear(c, x, p + "q_proj", s.num_heads * D, H), {1, S, s.num_heads, D});
+            size_t k = g.reshape(w.linear(c, x, p + "k_proj", s.num_heads * D, H), {1, S, s.num_heads, D});
+            size_t v = g.reshape(w.linear(c, x, p + "v_proj", s.num_heads * D, H), {1, S, s.num_heads, D});
+            size_t attn = g.reshape(g.attention(q, k, v, scale, false), {S, s.num_heads * D});
+            h = g.add(h, w.linear(c, attn, p + "o_proj", H, s.num_heads * D));
+            h = g.add(h, gelu_mlp(w, c, s, w.norm(c, h, p + "final_norm"), p));
+        }
+        c.output("encoder_hidden_states", g.reshape(w.norm(c, h, "encoder.norm"), {1, S, H}));
+        w.finish(c);
+    }
+    {
+        Component c("decoder_cross_kv");
+        auto& g = c.graph;
+        c.metadata = {{"runtime_route", route}, {"runtime_role", "decoder_cross_kv"}};
+        size_t enc = g.reshape(c.input("encoder_hidden_states", {1, S, H}, Precision::FP16), {S, H});
+        for (size_t l = 0; l < s.num_layers; ++l) {
+            const std::string p = "decoder.layers." + std::to_string(l) + ".cross_attn.";
+            const std::string idx = std::to_string(l);
+            c.output("cross_k_" + idx, g.reshape(w.linear(c, enc, p + "k_proj", s.num_kv_heads * D, H), {1, S, s.num_kv_heads, D}));
+            c.output("cross_v_" + idx, g.reshape(w.linear(c, enc, p + "v_proj", s.num_kv_heads * D, H), {1, S, s.num_kv_heads, D}));
+        }
+        w.finish(c);
+    }
+    {
+        Component c("decoder_step");
+        auto& g = c.graph;
+        c.metadata = {{"runtime_route", route}, {"runtime_role", "decoder_step"}};
+        size_t ids = c.input("decoder_input_ids", {1, 1}, Precision::FP32);
+        c.input("position_ids", {1, 1}, Precision::FP32);
+        const size_t cross_bytes = cross_kv_cache_bytes(S, s.num_kv_heads, D);
+        std::vector<std::pair<size_t, size_t>> cross;
+        for (size_t l = 0; l < s.num_layers; ++l) {
+            const std::string idx = std::to_string(l);
+            size_t k = c.input("cross_k_" + idx, {cross_bytes}, Precision::INT8);
+            size_t v = c.input("cross_v_" + idx, {cross_bytes}, Precision::INT8);
+            cross.emplace_back(k, v);
+        }
+        size_t h = g.reshape(g.embedding(w.weight(c, "decoder.embed_tokens", {s.vocab_size, H}, 0.5f), ids), {1, H});
+        for (size_t l = 0; l < s.num_layers; ++l) {
+            const std::string p = "decoder.layers." + std::to_string(l) + ".";
+            h = g.add(h, self_attention(w, c, s, w.norm(c, h, p + "self_attn_norm"), 1, p));
+            size_t x = w.norm(c, h, p + "cross_attn_norm");
+            size_t q = g.reshape(w.linear(c, x, p + "cross_attn.q_proj", s.num_heads * D, H), {1, 1, s.num_heads, D});
+            size_t attn = g.attention_cached(q, q, q, cross[l].first, cross[l].second, scale, CACHE_ONLY_POSITION);
+            h = g.add(h, w.linear(c, g.reshape(attn, {1, s.num_heads * D}), p + "cross_attn.o_proj", H, s.num_heads * D));
+            h = g.add(h, gelu_mlp(w, c, s, w.norm(c, h, p + "final_norm"), p));
+        }
+        c.output("logits", w.linear(c, w.norm(c, h, "decoder.norm"), "proj_out", s.vocab_size, H));
+        w.finish(c);
+    }
+}
+
+// Byte-level BPE with no merges: every byte is a token, and the ids above 256 are
+// unreachable fillers that only exist so the vocabulary matches vocab_size.
+void write_tokenizer(const ModelSpec& s, const fs::path& dir) {
+    std::vector<std::string> byte_tokens(256);
+    int extra = 256;
+    for (int b = 0; b < 256; ++b) {
+        int cp = ((b >= 33 && b <= 126) || (b >= 161 && b <= 255)) ? b : extra++;
+        std::string u;
+        if (cp < 0x80) {
+            u += static_cast<char>(cp);
+        } else {
+            u += static_cast<char>(0xC0 | (cp >> 6));
+            u += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        byte_tokens[b] = u;
+    }
+    const size_t eos = s.vocab_size - 1;
+    const size_t bos = s.vocab_size - 2;
+    std::ofstream vocab(dir / "vocab.txt", std::ios::binary);
+    for (size_t id = 0; id < s.vocab_size; ++id) {
+        vocab << id << '\t';
+        if (id < 256) vocab << byte_tokens[id];
+        else if (id == eos) vocab << "<|endoftext|>";
+        else if (id == bos) vocab << "<|startoftext|>";
+        else vocab << "<|synthetic_" << id << "|>";
+        vocab << '\n';
+    }
+    std::ofstream(dir / "merges.txt") << "#version: 0.2\n";
+    std::ofstream(dir / "special_tokens.json")
+        << "{\n  \"special_tokens\": {\n    \"" << bos << "\": \"<|startoftext|>\",\n    \""
+        << eos << "\": \"<|endoftext|>\"\n  }\n}\n";
+    std::ofstream(dir / "tokenizer_config.txt")
+        << "tokenizer_type=bpe\nvocab_format=id_tab_token\nnormalizer=byte_level\ndecoder=byte_level\nunk_token_id=0\n";
+}
+
+void write_config(const ModelSpec& s, const fs::path& dir) {
+    std::ofstream cfg(dir / "config.txt");
+    cfg << "model_type=" << (s.arch == "whisper" ? "whisper" : s.arch == "hybrid" ? "lfm2" : "qwen") << "\n"
+        << "model_variant=default\nprecision=FP16\n"
+        << "vocab_size=" << s.vocab_size << "\n"
+        << "bos_token_id=" << s.vocab_size - 2 << "\n"
+        << "eos_token_id=" << s.vocab_size - 1 << "\n"
+        << "num_layers=" << s.num_layers << "\n"
+        << "hidden_dim=" << s.hidden_dim << "\n"
+        << "ffn_intermediate_dim=" << s.ffn_dim << "\n"
+        << "attention_heads=" << s.num_heads << "\n"
+        << "attention_kv_heads=" << s.num_kv_heads << "\n"
+        << "attention_head_dim=" << s.head_dim << "\n"
+        << "rope_theta=" << s.rope_theta << "\n"
+        << "context_length=" << s.context_length << "\n";
+    if (s.arch == "moe") {
+        cfg << "num_experts=" << s.num_experts << "\nnum_experts_per_tok=" << s.experts_per_tok
+            << "\nmoe_intermediate_dim=" << s.moe_ffn_dim << "\nnorm_topk_prob=true\n";
+    }
+    if (s.arch == "hybrid") {
+        cfg << "conv_L_cache=" << s.conv_kernel << "\nlayer_types=";
+        for (size_t l = 0; l < s.num_layers; ++l) {
+            cfg << (l ? "," : "") << (is_attention_layer(s, l) ? "full_attention" : "conv");
+        }
+        cfg << "\n";
+    }
+    if (s.arch == "whisper") {
+        cfg << "num_encoder_layers=" << s.encoder_layers << "\nnum_decoder_layers=" << s.num_layers
+            << "\ndecoder_start_token_id=" << s.vocab_size - 2 << "\n";
+    }
+}
+
+}  // namespace
+
+const std::vector<std::string>& architectures() {
+    static const std::vector<std::string> names = {"dense", "moe", "hybrid", "whisper"};
+    return names;
+}
+
+ModelSpec preset(const std::string& arch) {
+    ModelSpec s;
+    s.arch = arch;
+    if (arch == "dense") return s;
+    if (arch == "moe") {
+        s.ffn_dim = 512;
+        return s;
+    }
+    if (arch == "hybrid") {
+        s.num_layers = 6;
+        return s;
+    }
+    if (arch == "whisper") {
+        s.num_heads = 4;
+        s.num_kv_heads = 4;
+        s.ffn_dim = 1024;
+        return s;
+    }
+    throw std::invalid_argument("unknown synthetic architecture: " + arch);
+}
+
+BundleInfo write_bundle(const ModelSpec& spec, const std::string& bundle_dir) {
+    if (spec.hidden_dim == 0 || spec.num_layers == 0 || spec.vocab_size <= 258) {
+        throw std::runtime_error("synthetic model needs hidden_dim, num_layers and vocab_size > 258");
+    }
+    if (spec.num_kv_heads == 0 || spec.num_heads % spec.num_kv_heads != 0) {
+        throw std::runtime_error("synthetic model num_heads must be a multiple of num_kv_heads");
+    }
+    fs::path dir(bundle_dir);
+    fs::remove_all(dir);
+    BundleWriter writer(spec, dir);
+    if (spec.arch == "whisper") {
+        build_whisper(writer, spec);
+    } else if (spec.arch == "dense" || spec.arch == "moe" || spec.arch == "hybrid") {
+        build_token_encoder(writer, spec, "lm_encoder_step", 1);
+        build_token_encoder(writer, spec, "lm_encoder_text_chunk", spec.prefill_chunk);
+        build_decoder(writer, spec, "decoder_step", 1);
+        build_decoder(writer, spec, "decoder_prefill_chunk", spec.prefill_chunk);
+    } else {
+        throw std::runtime_error("unknown synthetic architecture: " + spec.arch);
+    }
+    write_tokenizer(spec, dir);
+    write_config(spec, dir);
+    return writer.close();
+}
+
+}  // namespace synthetic
+}  // namespace cactus
@@ -0,0 +1,56 @@
+#ifndef CACTUS_SYNTHETIC_MODEL_H
+#define CACTUS_SYNTHETIC_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cactus {
+namespace synthetic {
+
+// Shape of a random-weight bundle. Weights are FP16 and carry no meaning; the
+// bundle only has to load and run through the same component routes as a real
+// transpiled model so engine-level timings are representative.
+struct ModelSpec {
+    std::string arch = "dense";     // dense | moe | hybrid | whisper
+    size_t vocab_size = 4096;
+    size_t hidden_dim = 256;
+    size_t num_layers = 4;
+    size_t num_heads = 4;
+    size_t num_kv_heads = 2;
+    size_t head_dim = 64;
+    size_t ffn_dim = 768;
+    size_t num_experts = 8;
+    size_t experts_per_tok = 2;
+    size_t moe_ffn_dim = 256;
+    size_t conv_kernel = 3;
+    size_t attention_every = 3;     // hybrid: every Nth layer is attention, the rest short conv
+    size_t encoder_layers = 2;      // whisper
+    size_t source_len = 512;        // whisper: fixed encoder window
+    size_t context_length = 2048;
+    size_t prefill_chunk = 64;
+    float rope_theta = 10000.0f;
+    uint32_t seed = 0x5eed;
+};
+
+struct BundleInfo {
+    std::string dir;
+    size_t parameter_count = 0;
+    size_t weight_bytes = 0;
+    std::vector<std::string> components;
+};
+
+const std::vector<std::string>& architectures();
+
+// Default tiny spec for an architecture; throws std::invalid_argument for unknown names.
+ModelSpec preset(const std::string& arch);
+
+// Writes config.txt, tokenizer files, component graphs, weights and
+// components/manifest.json under bundle_dir. Throws std::runtime_error on failure.
+BundleInfo write_bundle(const ModelSpec& spec, const std::string& bundle_dir);
+
+}  // namespace synthetic
+}  // namespace cactus
+
+#endif
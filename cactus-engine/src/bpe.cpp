@@ -1,8 +1,12 @@
 #include "engine.h"
 #include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <cctype>
 #include <cstdio>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <string_view>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -13,13 +17,160 @@ namespace engine {
 
 namespace {
 constexpr const char* kMetaspace = "\xE2\x96\x81";
+constexpr size_t kWordCacheCapacity = 16384;
+constexpr size_t kMaxCachedRunBytes = 256;
+
+inline size_t utf8_char_len(unsigned char byte) {
+    if ((byte & 0x80) == 0) return 1;
+    if ((byte & 0xE0) == 0xC0) return 2;
+    if ((byte & 0xF0) == 0xE0) return 3;
+    if ((byte & 0xF8) == 0xF0) return 4;
+    return 1;
+}
+
+template <typename Fn>
+bool for_each_utf8_char(std::string_view text, Fn&& fn) {
+    size_t i = 0;
+    while (i < text.size()) {
+        size_t len = utf8_char_len(static_cast<unsigned char>(text[i]));
+        if (i + len > text.size()) return false;
+        fn(text.substr(i, len));
+        i += len;
+    }
+    return true;
+}
+
+inline uint64_t pack_char(std::string_view c) {
+    uint64_t key = static_cast<uint64_t>(c.size()) << 32;
+    for (size_t i = 0; i < c.size(); ++i) {
+        key |= static_cast<uint64_t>(static_cast<unsigned char>(c[i])) << (8 * i);
+    }
+    return key;
+}
+
+inline uint64_t pack_pair(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+inline size_t hash_pair(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
+}
+
+class LineReader {
+public:
+    LineReader(const void* data, size_t size) : text_(static_cast<const char*>(data), size) {}
+
+    bool next(std::string_view& line) {
+        if (pos_ >= text_.size()) return false;
+        size_t end = text_.find('\n', pos_);
+        if (end == std::string_view::npos) end = text_.size();
+        line = text_.substr(pos_, end - pos_);
+        pos_ = end + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        return true;
+    }
+
+    size_t tell() const { return pos_; }
+    void seek(size_t pos) { pos_ = pos; }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+};
+
+inline bool is_stream_space(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+bool parse_leading_id(std::string_view line, uint32_t& id, std::string_view& rest) {
+    size_t i = 0;
+    while (i < line.size() && is_stream_space(line[i])) ++i;
+    if (i < line.size() && line[i] == '+') ++i;
+    size_t digits_begin = i;
+    uint64_t value = 0;
+    while (i < line.size() && line[i] >= '0' && line[i] <= '9') {
+        value = value * 10 + static_cast<uint64_t>(line[i] - '0');
+        if (value > UINT32_MAX) return false;
+        ++i;
+    }
+    if (i == digits_begin) return false;
+    id = static_cast<uint32_t>(value);
+    rest = line.substr(i);
+    return true;
+}
+
+bool next_field(std::string_view line, size_t& pos, std::string_view& field) {
+    while (pos < line.size() && is_stream_space(line[pos])) ++pos;
+    if (pos >= line.size()) return false;
+    size_t begin = pos;
+    while (pos < line.size() && !is_stream_space(line[pos])) ++pos;
+    field = line.substr(begin, pos - begin);
+    return true;
+}
 }  // namespace
 
+struct BPETokenizer::WordCache {
+    struct Entry {
+        std::string key;
+        std::vector<uint32_t> ids;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    };
+
+    static constexpr size_t kShards = 16;
+    Shard shards[kShards];
+
+    Shard& shard_for(std::string_view key) {
+        return shards[std::hash<std::string_view>{}(key) % kShards];
+    }
+
+    bool lookup(std::string_view key, std::vector<uint32_t>& out) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) return false;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        out.insert(out.end(), it->second->ids.begin(), it->second->ids.end());
+        return true;
+    }
+
+    void insert(std::string_view key, const uint32_t* ids, size_t count) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.index.count(key)) return;
+        shard.entries.push_front(Entry{std::string(key), std::vector<uint32_t>(ids, ids + count)});
+        shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+        if (shard.entries.size() > kWordCacheCapacity / kShards) {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+        }
+    }
+
+    void clear() {
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.index.clear();
+            shard.entries.clear();
+        }
+    }
+};
+
 BPETokenizer::BPETokenizer()
-    : vocab_size_(0), unk_token_id_(0), bos_token_id_(1), eos_token_id_(2),
+    : word_cache_(std::make_unique<WordCache>()),
+      vocab_size_(0), unk_token_id_(0), bos_token_id_(1), eos_token_id_(2),
       vocab_mmap_ptr_(nullptr), vocab_mmap_size_(0),
       merges_mmap_ptr_(nullptr), merges_mmap_size_(0) {
     has_chat_template_ = false;
+    std::fill(std::begin(byte_symbol_), std::end(byte_symbol_), NO_SYMBOL);
+    byte_joinable_.assign(256 * 256, 0);
+    init_byte_mappings();
 }
 
 BPETokenizer::~BPETokenizer() {
@@ -37,6 +188,125 @@ void BPETokenizer::cleanup_mmap() {
     }
 }
 
+uint32_t BPETokenizer::symbol_id(const std::string& token) {
+    auto it = token_to_id_.find(token);
+    if (it != token_to_id_.end()) return it->second;
+    auto extra = extra_symbols_.find(token);
+    if (extra != extra_symbols_.end()) return extra->second;
+    uint32_t id = static_cast<uint32_t>(id_to_token_.size() + extra_symbols_.size());
+    extra_symbols_.emplace(token, id);
+    return id;
+}
+
+const BPETokenizer::MergeSlot* BPETokenizer::find_merge(uint32_t left, uint32_t right) const {
+    if (merge_table_.empty()) return nullptr;
+    const uint64_t key = pack_pair(left, right);
+    const size_t mask = merge_table_.size() - 1;
+    for (size_t i = hash_pair(key) & mask;; i = (i + 1) & mask) {
+        const MergeSlot& slot = merge_table_[i];
+        if (slot.pair == key) return &slot;
+        if (slot.pair == UINT64_MAX) return nullptr;
+    }
+}
+
+bool BPETokenizer::add_merge(uint32_t left, uint32_t right, uint32_t rank, uint32_t merged) {
+    if ((merge_count_ + 1) * 2 > merge_table_.size()) {
+        std::vector<MergeSlot> old = std::move(merge_table_);
+        merge_table_.assign(std::max<size_t>(1024, old.size() * 2), MergeSlot{});
+        const size_t mask = merge_table_.size() - 1;
+        for (const auto& slot : old) {
+            if (slot.pair == UINT64_MAX) continue;
+            size_t i = hash_pair(slot.pair) & mask;
+            while (merge_table_[i].pair != UINT64_MAX) i = (i + 1) & mask;
+            merge_table_[i] = slot;
+        }
+    }
+
+    const uint64_t key = pack_pair(left, right);
+    const size_t mask = merge_table_.size() - 1;
+    size_t i = hash_pair(key) & mask;
+    while (merge_table_[i].pair != UINT64_MAX) {
+        if (merge_table_[i].pair == key) {
+            if (rank < merge_table_[i].rank) merge_table_[i].rank = rank;
+            return false;
+        }
+        i = (i + 1) & mask;
+    }
+    merge_table_[i] = MergeSlot{key, rank, merged};
+    ++merge_count_;
+    return true;
+}
+
+void BPETokenizer::build_symbol_tables(const std::vector<std::string>& merged_tokens) {
+    std::fill(std::begin(byte_symbol_), std::end(byte_symbol_), NO_SYMBOL);
+    byte_joinable_.assign(256 * 256, 0);
+    char_info_.clear();
+    char_joinable_.clear();
+
+    if (runtime_config_.normalizer == TokenizerRuntimeConfig::Normalizer::METASPACE) {
+        std::vector<uint64_t> chars;
+        uint32_t next_joint = 0;
+        for (const auto& merged : merged_tokens) {
+            chars.clear();
+            if (!for_each_utf8_char(merged, [&](std::string_view c) { chars.push_back(pack_char(c)); })) continue;
+            uint32_t prev_joint = NO_SYMBOL;
+            size_t offset = 0;
+            for (uint64_t key : chars) {
+                size_t len = static_cast<size_t>(key >> 32);
+                auto it = char_info_.find(key);
+                if (it == char_info_.end()) {
+                    it = char_info_.emplace(key, CharInfo{}).first;
+                }
+                if (it->second.joint == NO_SYMBOL) {
+                    it->second.symbol = symbol_id(merged.substr(offset, len));
+                    it->second.joint = next_joint++;
+                }
+                if (prev_joint != NO_SYMBOL) char_joinable_.insert(pack_pair(prev_joint, it->second.joint));
+                prev_joint = it->second.joint;
+                offset += len;
+            }
+        }
+        for (uint32_t id = 0; id < id_to_token_.size(); ++id) {
+            const std::string& token = id_to_token_[id];
+            if (token.empty() || token.size() != utf8_char_len(static_cast<unsigned char>(token[0]))) continue;
+            auto it = token_to_id_.find(token);
+            if (it == token_to_id_.end() || it->second != id) continue;
+            CharInfo& info = char_info_[pack_char(token)];
+            info.symbol = id;
+        }
+        return;
+    }
+
+    for (int b = 0; b < 256; ++b) {
+        const std::string& unicode_char = byte_to_unicode_.at(static_cast<uint8_t>(b));
+        auto it = token_to_id_.find(unicode_char);
+        if (it != token_to_id_.end()) {
+            byte_symbol_[b] = it->second;
+        } else {
+            auto extra = extra_symbols_.find(unicode_char);
+            if (extra != extra_symbols_.end()) byte_symbol_[b] = extra->second;
+        }
+    }
+
+    std::vector<uint8_t> bytes;
+    for (const auto& merged : merged_tokens) {
+        bytes.clear();
+        bool mappable = true;
+        bool complete = for_each_utf8_char(merged, [&](std::string_view c) {
+            auto it = unicode_to_byte_.find(std::string(c));
+            if (it == unicode_to_byte_.end()) {
+                mappable = false;
+            } else {
+                bytes.push_back(it->second);
+            }
+        });
+        if (!complete || !mappable) continue;
+        for (size_t i = 1; i < bytes.size(); ++i) {
+            byte_joinable_[bytes[i - 1] * 256 + bytes[i]] = 1;
+        }
+    }
+}
+
 bool BPETokenizer::load_vocabulary_mmap(const std::string& vocab_file, const std::string& merges_file) {
     int vocab_fd = open(vocab_file.c_str(), O_RDONLY);
     if (vocab_fd == -1) return false;
@@ -53,44 +323,36 @@ bool BPETokenizer::load_vocabulary_mmap(const std::string& vocab_file, const std
 
     if (vocab_mmap_ptr_ == MAP_FAILED) return false;
 
-    std::string vocab_content(static_cast<char*>(vocab_mmap_ptr_), vocab_mmap_size_);
-    std::istringstream vocab_stream(vocab_content);
-
-    auto rtrim_cr = [](std::string& s) {
-        if (!s.empty() && s.back() == '\r') s.pop_back();
-    };
-
-    std::string line;
+    LineReader vocab_lines(vocab_mmap_ptr_, vocab_mmap_size_);
+    std::string_view line;
     token_to_id_.clear();
     id_to_token_.clear();
     special_tokens_.clear();
+    extra_symbols_.clear();
+    merge_table_.clear();
+    merge_count_ = 0;
+    word_cache_->clear();
     const bool use_id_tab_vocab =
         runtime_config_.vocab_format == TokenizerRuntimeConfig::VocabFormat::ID_TAB_TOKEN;
 
     if (use_id_tab_vocab) {
-        while (std::getline(vocab_stream, line)) {
-            rtrim_cr(line);
-
+        while (vocab_lines.next(line)) {
             std::string token;
             uint32_t id = UINT32_MAX;
+            std::string_view rest;
 
-            std::istringstream iss(line);
-            if (iss >> id) {
-                if (std::getline(iss, token) && !token.empty() && token[0] == '\t') {
-                    token = token.substr(1);
-                }
+            if (parse_leading_id(line, id, rest)) {
+                if (!rest.empty() && rest[0] == '\t') rest.remove_prefix(1);
+                token.assign(rest);
 
                 if (token.empty()) {
-                    auto last_pos = vocab_stream.tellg();
-                    while (std::getline(vocab_stream, line)) {
-                        rtrim_cr(line);
-                        if (!line.empty()) {
-                            break;
-                        }
+                    size_t last_pos = vocab_lines.tell();
+                    while (vocab_lines.next(line)) {
+                        if (!line.empty()) break;
                         token += '\n';
-                        last_pos = vocab_stream.tellg();
+                        last_pos = vocab_lines.tell();
                     }
-                    vocab_stream.seekg(last_pos);
+                    vocab_lines.seek(last_pos);
                 }
             }
 
@@ -99,16 +361,15 @@ bool BPETokenizer::load_vocabulary_mmap(const std::string& vocab_file, const std
                 if (id >= id_to_token_.size()) {
                     id_to_token_.resize(id + 1);
                 }
-                id_to_token_[id] = token;
+                id_to_token_[id] = std::move(token);
             }
         }
         vocab_size_ = static_cast<uint32_t>(id_to_token_.size());
     } else {
         uint32_t id = 0;
-        while (std::getline(vocab_stream, line)) {
-            rtrim_cr(line);
-            token_to_id_[line] = id;
-            id_to_token_.push_back(line);
+        while (vocab_lines.next(line)) {
+            token_to_id_[std::string(line)] = id;
+            id_to_token_.emplace_back(line);
             ++id;
         }
         vocab_size_ = id;
@@ -129,34 +390,29 @@ bool BPETokenizer::load_vocabulary_mmap(const std::string& vocab_file, const std
 
     if (merges_mmap_ptr_ == MAP_FAILED) return false;
 
-    std::string merges_content(static_cast<char*>(merges_mmap_ptr_), merges_mmap_size_);
-    std::istringstream merges_stream(merges_content);
-
-    merge_rules_.clear();
+    LineReader merge_lines(merges_mmap_ptr_, merges_mmap_size_);
+    std::vector<std::string> merged_tokens;
     uint32_t priority = 0;
+    std::string first, second;
 
-    while (std::getline(merges_stream, line)) {
-        rtrim_cr(line);
+    while (merge_lines.next(line)) {
         if (line.empty() || line[0] == '#') continue;
 
-        std::istringstream iss(line);
-        std::string first, second;
-        if (iss >> first >> second) {
-            rtrim_cr(first);
-            rtrim_cr(second);
-
+        size_t pos = 0;
+        std::string_view first_view, second_view;
+        if (next_field(line, pos, first_view) && next_field(line, pos, second_view)) {
+            first.assign(first_view);
+            second.assign(second_view);
             std::string merged = first + second;
-            merge_rules_.emplace_back(first, second, merged, priority);
-
-            std::string key = first + '\0' + second;
-            auto it = merge_map_.find(key);
-            if (it == merge_map_.end() || priority < it->second) {
-                merge_map_[key] = priority;
+            uint32_t left = symbol_id(first);
+            uint32_t right = symbol_id(second);
+            if (add_merge(left, right, priority, symbol_id(merged))) {
+                merged_tokens.push_back(std::move(merged));
             }
             priority++;
         }
     }
-    
+
     auto is_whitespace_only = [](const std::string& s) {
         if (s.empty()) return false;
         for (char c : s) {
@@ -172,24 +428,19 @@ bool BPETokenizer::load_vocabulary_mmap(const std::string& vocab_file, const std
               [](const std::string& a, const std::string& b) { return a.size() < b.size(); });
     for (const auto& tok : ws_tokens) {
         for (size_t i = 1; i < tok.size(); i++) {
-            std::string first = tok.substr(0, i);
-            std::string second = tok.substr(i);
-            if (!token_to_id_.count(first) || !token_to_id_.count(second)) continue;
-            std::string key = first + '\0' + second;
-            if (merge_map_.find(key) == merge_map_.end()) {
-                merge_rules_.emplace_back(first, second, tok, priority);
-                merge_map_[key] = priority;
+            auto first_it = token_to_id_.find(tok.substr(0, i));
+            auto second_it = token_to_id_.find(tok.substr(i));
+            if (first_it == token_to_id_.end() || second_it == token_to_id_.end()) continue;
+            if (!find_merge(first_it->second, second_it->second)) {
+                add_merge(first_it->second, second_it->second, priority, symbol_id(tok));
+                merged_tokens.push_back(tok);
                 priority++;
             }
             break;
         }
     }
 
-    std::sort(merge_rules_.begin(), merge_rules_.end(),
-              [](const MergeRule& a, const MergeRule& b) {
-                  return a.priority < b.priority;
-              });
-
+    build_symbol_tables(merged_tokens);
     return true;
 }
 
@@ -256,7 +507,7 @@ std::vector<std::string> BPETokenizer::split_with_special_tokens(const std::stri
     return cactus::engine::split_with_special_tokens(text, special_tokens_);
 }
 
-void BPETokenizer::init_byte_mappings() const {
+void BPETokenizer::init_byte_mappings() {
     if (!byte_to_unicode_.empty()) return;
 
     std::vector<int> bytes;
@@ -310,19 +561,7 @@ void BPETokenizer::init_byte_mappings() const {
     }
 }
 
-std::string BPETokenizer::bytes_to_unicode(const std::string& text) const {
-    init_byte_mappings();
-
-    std::string result;
-    for (uint8_t byte : text) {
-        result += byte_to_unicode_.at(byte);
-    }
-    return result;
-}
-
 std::string BPETokenizer::unicode_to_bytes(const std::string& text) const {
-    init_byte_mappings();
-
     std::string result;
     size_t i = 0;
     while (i < text.length()) {
@@ -354,105 +593,205 @@ std::string BPETokenizer::unicode_to_bytes(const std::string& text) const {
     return result;
 }
 
-std::vector<std::string> BPETokenizer::byte_level_split(const std::string& text) const {
-    std::string unicode_text = bytes_to_unicode(text);
+void BPETokenizer::append_token_ids(const std::string& token, std::vector<uint32_t>& out) const {
+    auto it = token_to_id_.find(token);
+    if (it != token_to_id_.end()) {
+        out.push_back(it->second);
+        return;
+    }
+    if (!runtime_config_.byte_fallback) {
+        out.push_back(unk_token_id_);
+        return;
+    }
 
-    std::vector<std::string> chars;
-    size_t i = 0;
-    while (i < unicode_text.length()) {
-        size_t char_len = 1;
-
-        if ((unicode_text[i] & 0x80) == 0) {
-            char_len = 1;
-        } else if ((unicode_text[i] & 0xE0) == 0xC0) {
-            char_len = 2;
-        } else if ((unicode_text[i] & 0xF0) == 0xE0) {
-            char_len = 3;
-        } else if ((unicode_text[i] & 0xF8) == 0xF0) {
-            char_len = 4;
+    const size_t mark = out.size();
+    for (unsigned char byte : token) {
+        char fallback_token[7];
+        std::snprintf(fallback_token, sizeof(fallback_token), "<0x%02X>", byte);
+        auto fallback_it = token_to_id_.find(fallback_token);
+        if (fallback_it == token_to_id_.end()) {
+            out.resize(mark);
+            out.push_back(unk_token_id_);
+            return;
         }
+        out.push_back(fallback_it->second);
+    }
+    if (out.size() == mark) out.push_back(unk_token_id_);
+}
 
-        if (i + char_len <= unicode_text.length()) {
-            chars.push_back(unicode_text.substr(i, char_len));
+void BPETokenizer::encode_run(const std::string& text, const std::vector<Symbol>& initial, size_t begin, size_t end,
+                              std::vector<uint32_t>& out) const {
+    const bool byte_level = runtime_config_.normalizer != TokenizerRuntimeConfig::Normalizer::METASPACE;
+    const uint32_t vocab_limit = static_cast<uint32_t>(id_to_token_.size());
+
+    auto emit = [&](const Symbol& sym) {
+        if (sym.id < vocab_limit) {
+            out.push_back(sym.id);
+            return;
         }
-        i += char_len;
+        std::string token;
+        if (byte_level) {
+            for (uint32_t i = 0; i < sym.len; ++i) {
+                token += byte_to_unicode_.at(static_cast<uint8_t>(text[sym.start + i]));
+            }
+        } else {
+            token.assign(text, sym.start, sym.len);
+        }
+        append_token_ids(token, out);
+    };
+
+    if (end - begin == 1) {
+        emit(initial[begin]);
+        return;
     }
 
-    return chars;
-}
+    const size_t run_start = initial[begin].start;
+    const size_t run_bytes = initial[end - 1].start + initial[end - 1].len - run_start;
+    const std::string_view key(text.data() + run_start, run_bytes);
+    const bool cacheable = run_bytes <= kMaxCachedRunBytes;
+    if (cacheable && word_cache_->lookup(key, out)) return;
+
+    std::vector<Symbol> symbols(initial.begin() + begin, initial.begin() + end);
+    const int32_t count = static_cast<int32_t>(symbols.size());
+    for (int32_t i = 0; i < count; ++i) {
+        symbols[i].prev = i - 1;
+        symbols[i].next = i + 1 < count ? i + 1 : -1;
+    }
 
-std::vector<std::string> BPETokenizer::utf8_split(const std::string& text) const {
-    std::vector<std::string> chars;
-    size_t i = 0;
-    while (i < text.length()) {
-        size_t char_len = 1;
-        const unsigned char byte = static_cast<unsigned char>(text[i]);
-
-        if ((byte & 0x80) == 0) {
-            char_len = 1;
-        } else if ((byte & 0xE0) == 0xC0) {
-            char_len = 2;
-        } else if ((byte & 0xF0) == 0xE0) {
-            char_len = 3;
-        } else if ((byte & 0xF8) == 0xF0) {
-            char_len = 4;
+    struct Candidate {
+        uint32_t rank;
+        int32_t left;
+        int32_t right;
+        uint32_t left_id;
+        uint32_t right_id;
+        bool operator>(const Candidate& other) const {
+            return rank != other.rank ? rank > other.rank : left > other.left;
         }
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+
+    auto push_pair = [&](int32_t left, int32_t right) {
+        if (left < 0 || right < 0) return;
+        const Symbol& a = symbols[left];
+        const Symbol& b = symbols[right];
+        if (a.id == NO_SYMBOL || b.id == NO_SYMBOL) return;
+        const MergeSlot* slot = find_merge(a.id, b.id);
+        if (slot) queue.push(Candidate{slot->rank, left, right, a.id, b.id});
+    };
 
-        if (i + char_len <= text.length()) {
-            chars.push_back(text.substr(i, char_len));
+    for (int32_t i = 0; i + 1 < count; ++i) push_pair(i, i + 1);
+
+    while (!queue.empty()) {
+        Candidate top = queue.top();
+        queue.pop();
+        Symbol& left = symbols[top.left];
+        Symbol& right = symbols[top.right];
+        if (left.len == 0 || right.len == 0 || left.next != top.right ||
+            left.id != top.left_id || right.id != top.right_id) {
+            continue;
         }
-        i += char_len;
+
+        left.id = find_merge(left.id, right.id)->merged;
+        left.len += right.len;
+        left.next = right.next;
+        if (right.next >= 0) symbols[right.next].prev = top.left;
+        right.len = 0;
+
+        push_pair(left.prev, top.left);
+        push_pair(top.left, left.next);
     }
 
-    return chars;
+    const size_t mark = out.size();
+    for (int32_t i = 0; i >= 0; i = symbols[i].next) {
+        emit(symbols[i]);
+    }
+    if (cacheable) word_cache_->insert(key, out.data() + mark, out.size() - mark);
 }
 
+std::string BPETokenizer::normalize_segment(const std::string& segment) const {
+    if (runtime_config_.normalizer != TokenizerRuntimeConfig::Normalizer::METASPACE) return segment;
 
-std::pair<int, uint32_t> BPETokenizer::find_best_merge_fast(const std::vector<std::string>& tokens) const {
-    int best_pos = -1;
-    uint32_t best_priority = UINT32_MAX;
+    std::string normalized;
+    normalized.reserve(segment.size() + segment.size() / 2);
+    for (char c : segment) {
+        if (c == ' ') {
+            normalized += kMetaspace;
+        } else {
+            normalized += c;
+        }
+    }
+    return normalized;
+}
 
-    for (size_t i = 0; i < tokens.size() - 1; ++i) {
-        std::string key = tokens[i] + '\0' + tokens[i + 1];
-        auto it = merge_map_.find(key);
-        if (it != merge_map_.end()) {
-            if (it->second < best_priority) {
-                best_priority = it->second;
-                best_pos = static_cast<int>(i);
+void BPETokenizer::encode_segment(const std::string& text, size_t begin, size_t end, std::vector<uint32_t>& out) const {
+    std::vector<Symbol> symbols;
+    size_t run_begin = 0;
+
+    if (runtime_config_.normalizer == TokenizerRuntimeConfig::Normalizer::METASPACE) {
+        const std::string_view view(text.data() + begin, end - begin);
+        uint32_t prev_joint = NO_SYMBOL;
+        for_each_utf8_char(view, [&](std::string_view c) {
+            CharInfo info;
+            auto it = char_info_.find(pack_char(c));
+            if (it != char_info_.end()) info = it->second;
+            uint32_t start = static_cast<uint32_t>(c.data() - text.data());
+            if (!symbols.empty() &&
+                (prev_joint == NO_SYMBOL || info.joint == NO_SYMBOL ||
+                 !char_joinable_.count(pack_pair(prev_joint, info.joint)))) {
+                encode_run(text, symbols, run_begin, symbols.size(), out);
+                run_begin = symbols.size();
+            }
+            symbols.push_back(Symbol{info.symbol, start, static_cast<uint32_t>(c.size()), -1, -1});
+            prev_joint = info.joint;
+        });
+    } else {
+        symbols.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            const uint8_t byte = static_cast<uint8_t>(text[i]);
+            if (i > begin && !byte_joinable_[static_cast<uint8_t>(text[i - 1]) * 256 + byte]) {
+                encode_run(text, symbols, run_begin, symbols.size(), out);
+                run_begin = symbols.size();
             }
+            symbols.push_back(Symbol{byte_symbol_[byte], static_cast<uint32_t>(i), 1, -1, -1});
         }
     }
 
-    return {best_pos, best_priority};
+    if (run_begin < symbols.size()) {
+        encode_run(text, symbols, run_begin, symbols.size(), out);
+    }
 }
 
-std::vector<std::string> BPETokenizer::apply_bpe(const std::vector<std::string>& tokens) const {
-    if (tokens.size() <= 1) return tokens;
-
-    std::vector<std::string> current_tokens = tokens;
-
-
-    while (true) {
-        auto [merge_pos, priority] = find_best_merge_fast(current_tokens);
-        if (merge_pos == -1) break;
-
-
-        std::vector<std::string> new_tokens;
-        new_tokens.reserve(current_tokens.size() - 1);
-
-        for (int i = 0; i < static_cast<int>(current_tokens.size()); ++i) {
-            if (i == merge_pos) {
-                std::string merged = current_tokens[i] + current_tokens[i + 1];
-                new_tokens.push_back(merged);
-                i++;
-            } else {
-                new_tokens.push_back(current_tokens[i]);
+void BPETokenizer::split_segment(const std::string& text, size_t chunk_bytes,
+                                 std::vector<std::pair<size_t, size_t>>& ranges) const {
+    size_t last = 0;
+
+    if (runtime_config_.normalizer == TokenizerRuntimeConfig::Normalizer::METASPACE) {
+        std::string_view prev;
+        for_each_utf8_char(text, [&](std::string_view c) {
+            const size_t pos = static_cast<size_t>(c.data() - text.data());
+            if (pos - last >= chunk_bytes) {
+                auto a = char_info_.find(pack_char(prev));
+                auto b = char_info_.find(pack_char(c));
+                if (a == char_info_.end() || b == char_info_.end() ||
+                    a->second.joint == NO_SYMBOL || b->second.joint == NO_SYMBOL ||
+                    !char_joinable_.count(pack_pair(a->second.joint, b->second.joint))) {
+                    ranges.emplace_back(last, pos);
+                    last = pos;
+                }
+            }
+            prev = c;
+        });
+    } else {
+        for (size_t pos = chunk_bytes; pos < text.size(); ++pos) {
+            if (pos - last < chunk_bytes) continue;
+            if (!byte_joinable_[static_cast<uint8_t>(text[pos - 1]) * 256 + static_cast<uint8_t>(text[pos])]) {
+                ranges.emplace_back(last, pos);
+                last = pos;
             }
         }
-        current_tokens = std::move(new_tokens);
     }
 
-    return current_tokens;
+    ranges.emplace_back(last, text.size());
 }
 
 std::vector<uint32_t> BPETokenizer::encode(const std::string& text) const {
@@ -469,54 +808,48 @@ std::vector<uint32_t> BPETokenizer::encode(const std::string& text) const {
         if (special_it != special_tokens_.end()) {
             token_ids.push_back(special_it->second);
         } else {
-            std::string normalized_segment = segment;
-            std::vector<std::string> chars;
-            if (runtime_config_.normalizer == TokenizerRuntimeConfig::Normalizer::METASPACE) {
-                size_t pos = 0;
-                while ((pos = normalized_segment.find(' ', pos)) != std::string::npos) {
-                    normalized_segment.replace(pos, 1, kMetaspace);
-                    pos += 3;
-                }
-                chars = utf8_split(normalized_segment);
-            } else {
-                chars = byte_level_split(segment);
-            }
-            auto bpe_tokens = apply_bpe(chars);
-
-            for (const auto& token : bpe_tokens) {
-                auto it = token_to_id_.find(token);
-                if (it != token_to_id_.end()) {
-                    token_ids.push_back(it->second);
-                } else {
-                    if (!runtime_config_.byte_fallback) {
-                        token_ids.push_back(unk_token_id_);
-                        continue;
-                    }
+            const std::string normalized_segment = normalize_segment(segment);
+            encode_segment(normalized_segment, 0, normalized_segment.size(), token_ids);
+        }
+    }
 
-                    std::vector<uint32_t> fallback_ids;
-                    fallback_ids.reserve(token.size());
-                    for (unsigned char byte : token) {
-                        char fallback_token[7];
-                        std::snprintf(fallback_token, sizeof(fallback_token), "<0x%02X>", byte);
-                        auto fallback_it = token_to_id_.find(fallback_token);
-                        if (fallback_it == token_to_id_.end()) {
-                            fallback_ids.clear();
-                            break;
-                        }
-                        fallback_ids.push_back(fallback_it->second);
-                    }
+    return token_ids;
+}
 
-                    if (fallback_ids.empty()) {
-                        token_ids.push_back(unk_token_id_);
-                    } else {
-                        token_ids.insert(token_ids.end(), fallback_ids.begin(), fallback_ids.end());
-                    }
-                }
-            }
+std::vector<uint32_t> BPETokenizer::encode_parallel(const std::string& text) const {
+    if (text.size() < 2 * kParallelEncodeChunkBytes) return encode(text);
+
+    const auto text_segments = split_with_special_tokens(text);
+    std::vector<std::string> normalized(text_segments.size());
+    struct Chunk {
+        size_t segment;
+        size_t begin;
+        size_t end;
+        uint32_t special;
+    };
+    std::vector<Chunk> chunks;
+    std::vector<std::pair<size_t, size_t>> ranges;
+
+    for (size_t i = 0; i < text_segments.size(); ++i) {
+        auto special_it = special_tokens_.find(text_segments[i]);
+        if (special_it != special_tokens_.end()) {
+            chunks.push_back(Chunk{i, 0, 0, special_it->second});
+            continue;
         }
+        normalized[i] = normalize_segment(text_segments[i]);
+        ranges.clear();
+        split_segment(normalized[i], kParallelEncodeChunkBytes, ranges);
+        for (const auto& [begin, end] : ranges) chunks.push_back(Chunk{i, begin, end, NO_SYMBOL});
     }
 
-    return token_ids;
+    return encode_chunks_parallel(chunks.size(), [&](size_t c, std::vector<uint32_t>& out) {
+        const Chunk& chunk = chunks[c];
+        if (chunk.special != NO_SYMBOL) {
+            out.push_back(chunk.special);
+        } else {
+            encode_segment(normalized[chunk.segment], chunk.begin, chunk.end, out);
+        }
+    });
 }
 
 std::string BPETokenizer::decode(const std::vector<uint32_t>& tokens) const {
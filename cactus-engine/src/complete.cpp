@@ -95,6 +95,22 @@ void setup_tool_constraints(CactusModelHandle* handle, const std::vector<ToolFun
     }
 }
 
+void setup_grammar(CactusModelHandle* handle, const InferenceOptions& options, float& temperature) {
+    const std::string grammar = options.json_schema.empty()
+        ? options.grammar
+        : TokenGrammar::json_schema_to_grammar(options.json_schema);
+    if (grammar.empty()) {
+        handle->model->clear_grammar();
+        return;
+    }
+
+    handle->model->set_grammar(grammar);
+
+    if (temperature == 0.0f) {
+        temperature = 0.01f;
+    }
+}
+
 size_t find_json_block_end(const std::string& json, size_t start) {
     if (start >= json.size() || json[start] != '{') {
         return std::string::npos;
@@ -626,6 +642,7 @@ PreparedPrompt prepare_prompt(
 
     if (apply_tool_constraints) {
         setup_tool_constraints(handle, prompt.tools, prompt.options.force_tools, prompt.options.temperature);
+        setup_grammar(handle, prompt.options, prompt.options.temperature);
     }
 
     prompt.rendered = tokenizer->format_chat_prompt(
@@ -637,7 +654,7 @@ PreparedPrompt prepare_prompt(
     if (prompt.rendered.find("ERROR:") == 0) {
         throw std::runtime_error(prompt.rendered.substr(6));
     }
-    prompt.tokens = tokenizer->encode(prompt.rendered);
+    prompt.tokens = tokenizer->encode_parallel(prompt.rendered);
     prompt.context_token_count = prompt.tokens.size();
     prompt.images = images_from_message(prompt.messages);
     return prompt;
@@ -960,104 +977,148 @@ int cactus_complete(
             }
         }
 
-        bool first_token_from_prefill = false;
-        if (!has_images && !has_audio && handle->processed_tokens.empty()) {
-            reset_cache(handle);
-            first_token_from_prefill = handle->model->prefill_and_sample_first_token(prompt.tokens, next_token, &first_token_entropy);
-            if (first_token_from_prefill) {
-                prompt_tokens = prompt.tokens.size();
+        EntropyState entropy;
+        float confidence = 1.0f;
+        std::string cloud_error;
+        std::vector<std::string> n_best_texts;
+        std::vector<Model::BeamHypothesis> beams;
+        if (wants_beam_search(prompt.options) && !has_images && !has_audio && prompt.tools.empty() &&
+            prompt.options.grammar.empty() && prompt.options.json_schema.empty()) {
+            std::vector<uint32_t> beam_tokens = prompt.tokens;
+            if (prompt_context_matches(handle, prompt) && handle->processed_tokens.size() < prompt.tokens.size()) {
+                beam_tokens.erase(beam_tokens.begin(), beam_tokens.begin() + handle->processed_tokens.size());
+            } else {
+                reset_cache(handle);
+            }
+            beams = handle->model->beam_search(beam_tokens, beam_search_options(prompt.options),
+                                               stop_token_sequences, &handle->should_stop);
+            if (beams.empty()) {
+                CACTUS_LOG_WARN("complete", "Beam search needs a KV-cache decoder step; decoding greedily");
+            } else {
+                handle->processed_tokens = prompt.tokens;
+                handle->processed_images = prompt.images;
             }
-        }
-        if (!first_token_from_prefill) {
-            auto prefill_result = do_prefill(handle, prompt, prompt.tokens);
-            prompt_tokens = prefill_result.prefilled_count + prefill_result.remaining_tokens.size();
-            next_token = generate_first_token(handle, prefill_result, prompt, &first_token_entropy);
         }
 
-        handle->processed_tokens = prompt.tokens;
-        handle->processed_images = prompt.images;
+        if (!beams.empty()) {
+            // Nothing streams until the search settles, so the whole search counts as time to first token.
+            prompt_tokens = prompt.tokens.size();
+            for (const auto& hyp : beams) {
+                std::vector<uint32_t> hyp_tokens = hyp.tokens;
+                trim_stop_suffix(hyp_tokens, stop_token_sequences, prompt.options.include_stop_sequences);
+                if (n_best_texts.empty()) generated_tokens = hyp_tokens;
+                n_best_texts.push_back(tokenizer->decode(hyp_tokens));
+            }
+            const auto& best = beams.front();
+            confidence = best.tokens.empty() ? 1.0f
+                : std::exp(best.logprob / static_cast<float>(best.tokens.size()));
+            entropy.add(1.0f - confidence);
+            auto token_end = std::chrono::high_resolution_clock::now();
+            time_to_first_token = std::chrono::duration_cast<std::chrono::microseconds>(token_end - start_time).count() / 1000.0;
+            if (callback && !defer_local_stream_until_probe && !generated_tokens.empty()) {
+                callback(n_best_texts.front().c_str(), generated_tokens.back(), user_data);
+            }
+        } else {
+            bool first_token_from_prefill = false;
+            if (!has_images && !has_audio && handle->processed_tokens.empty()) {
+                reset_cache(handle);
+                first_token_from_prefill = handle->model->prefill_and_sample_first_token(prompt.tokens, next_token, &first_token_entropy);
+                if (first_token_from_prefill) {
+                    prompt_tokens = prompt.tokens.size();
+                }
+            }
+            if (!first_token_from_prefill) {
+                auto prefill_result = do_prefill(handle, prompt, prompt.tokens);
+                prompt_tokens = prefill_result.prefilled_count + prefill_result.remaining_tokens.size();
+                next_token = generate_first_token(handle, prefill_result, prompt, &first_token_entropy);
+            }
 
-        auto token_end = std::chrono::high_resolution_clock::now();
-        time_to_first_token = std::chrono::duration_cast<std::chrono::microseconds>(token_end - start_time).count() / 1000.0;
+            handle->processed_tokens = prompt.tokens;
+            handle->processed_images = prompt.images;
 
-        float confidence = 1.0f - first_token_entropy;
-        std::string cloud_error;
+            auto token_end = std::chrono::high_resolution_clock::now();
+            time_to_first_token = std::chrono::duration_cast<std::chrono::microseconds>(token_end - start_time).count() / 1000.0;
 
-        generated_tokens.push_back(next_token);
-        handle->processed_tokens.push_back(next_token);
+            confidence = 1.0f - first_token_entropy;
 
-        if (prompt.options.force_tools && !prompt.tools.empty()) {
-            handle->model->update_tool_constraints(next_token);
-        }
+            generated_tokens.push_back(next_token);
+            handle->processed_tokens.push_back(next_token);
 
-        EntropyState entropy;
-        entropy.add(first_token_entropy);
-
-        if (!matches_stop_sequence(generated_tokens, stop_token_sequences)) {
-            if (cloud_eligible
-                && !defer_local_stream_until_probe
-                && !pre_generation_cloud_attempted
-                && confidence < prompt.options.confidence_threshold) {
-                CACTUS_LOG_INFO("cloud_handoff", "Cloud handoff triggered before local streaming; waiting up to "
-                    << prompt.options.cloud_timeout_ms << " ms before falling back");
-                CloudCompletionResult cloud_result = cloud_complete_request(
-                    make_cloud_request("", {}),
-                    static_cast<long>(prompt.options.cloud_timeout_ms));
-                auto now = std::chrono::high_resolution_clock::now();
-                double elapsed_ms = std::chrono::duration_cast<std::chrono::microseconds>(now - start_time).count() / 1000.0;
-                if (cloud_result.ok && (!cloud_result.response.empty() || !cloud_result.function_calls.empty())) {
-                    if (prompt.options.force_tools && !prompt.tools.empty()) {
-                        handle->model->clear_tool_constraints();
+            if (prompt.options.force_tools && !prompt.tools.empty()) {
+                handle->model->update_tool_constraints(next_token);
+            }
+            handle->model->update_grammar(next_token);
+
+            entropy.add(first_token_entropy);
+
+            if (!matches_stop_sequence(generated_tokens, stop_token_sequences)) {
+                if (cloud_eligible
+                    && !defer_local_stream_until_probe
+                    && !pre_generation_cloud_attempted
+                    && confidence < prompt.options.confidence_threshold) {
+                    CACTUS_LOG_INFO("cloud_handoff", "Cloud handoff triggered before local streaming; waiting up to "
+                        << prompt.options.cloud_timeout_ms << " ms before falling back");
+                    CloudCompletionResult cloud_result = cloud_complete_request(
+                        make_cloud_request("", {}),
+                        static_cast<long>(prompt.options.cloud_timeout_ms));
+                    auto now = std::chrono::high_resolution_clock::now();
+                    double elapsed_ms = std::chrono::duration_cast<std::chrono::microseconds>(now - start_time).count() / 1000.0;
+                    if (cloud_result.ok && (!cloud_result.response.empty() || !cloud_result.function_calls.empty())) {
+                        if (prompt.options.force_tools && !prompt.tools.empty()) {
+                            handle->model->clear_tool_constraints();
+                        }
+                        handle->model->clear_grammar();
+                        return return_cloud_completion(cloud_result, elapsed_ms, elapsed_ms, confidence, prompt_tokens,
+                                                       "low confidence");
                     }
-                    return return_cloud_completion(cloud_result, elapsed_ms, elapsed_ms, confidence, prompt_tokens,
-                                                   "low confidence");
+                    cloud_error = cloud_result.error.empty() ? "cloud completion failed" : cloud_result.error;
+                    CACTUS_LOG_WARN("cloud_handoff", "Cloud completion failed before local streaming, falling back to local output: " << cloud_error);
+                    disable_handoff_on_auth_failure(cloud_error);
+                    handoff_reason = "handoff failed: " + friendly_cloud_error(cloud_error);
                 }
-                cloud_error = cloud_result.error.empty() ? "cloud completion failed" : cloud_result.error;
-                CACTUS_LOG_WARN("cloud_handoff", "Cloud completion failed before local streaming, falling back to local output: " << cloud_error);
-                disable_handoff_on_auth_failure(cloud_error);
-                handoff_reason = "handoff failed: " + friendly_cloud_error(cloud_error);
-            }
 
-            if (callback && !defer_local_stream_until_probe) {
-                std::string new_text = tokenizer->decode({next_token});
-                callback(new_text.c_str(), next_token, user_data);
-            }
-
-            for (size_t i = 1; i < prompt.options.max_tokens; i++) {
-                if (handle->should_stop) break;
-
-                float token_entropy = 0.0f;
-                if (has_audio) {
-                    uint32_t last_token = handle->processed_tokens.empty() ? next_token : handle->processed_tokens.back();
-                    next_token = handle->model->decode_with_audio(
-                        {last_token}, prompt.audio_features,
-                        prompt.options.temperature, prompt.options.top_p, prompt.options.top_k,
-                        "", &token_entropy,
-                        prompt.options.min_p, prompt.options.repetition_penalty);
-                } else {
-                    next_token = decode(handle->model, {next_token}, prompt.options, &token_entropy);
+                if (callback && !defer_local_stream_until_probe) {
+                    std::string new_text = tokenizer->decode({next_token});
+                    callback(new_text.c_str(), next_token, user_data);
                 }
-                handle->processed_tokens.push_back(next_token);
-                generated_tokens.push_back(next_token);
 
-                entropy.add(token_entropy);
+                for (size_t i = 1; i < prompt.options.max_tokens; i++) {
+                    if (handle->should_stop) break;
+
+                    float token_entropy = 0.0f;
+                    if (has_audio) {
+                        uint32_t last_token = handle->processed_tokens.empty() ? next_token : handle->processed_tokens.back();
+                        next_token = handle->model->decode_with_audio(
+                            {last_token}, prompt.audio_features,
+                            prompt.options.temperature, prompt.options.top_p, prompt.options.top_k,
+                            "", &token_entropy,
+                            prompt.options.min_p, prompt.options.repetition_penalty);
+                    } else {
+                        next_token = decode(handle->model, {next_token}, prompt.options, &token_entropy);
+                    }
+                    handle->processed_tokens.push_back(next_token);
+                    generated_tokens.push_back(next_token);
+
+                    entropy.add(token_entropy);
 
-                if (prompt.options.force_tools && !prompt.tools.empty()) {
-                    handle->model->update_tool_constraints(next_token);
-                }
+                    if (prompt.options.force_tools && !prompt.tools.empty()) {
+                        handle->model->update_tool_constraints(next_token);
+                    }
+                    handle->model->update_grammar(next_token);
 
-                if (matches_stop_sequence(generated_tokens, stop_token_sequences)) {
-                    trim_stop_suffix(generated_tokens, stop_token_sequences, prompt.options.include_stop_sequences);
-                    break;
-                }
+                    if (matches_stop_sequence(generated_tokens, stop_token_sequences)) {
+                        trim_stop_suffix(generated_tokens, stop_token_sequences, prompt.options.include_stop_sequences);
+                        break;
+                    }
 
-                if (callback && !defer_local_stream_until_probe) {
-                    std::string new_text = tokenizer->decode({next_token});
-                    callback(new_text.c_str(), next_token, user_data);
+                    if (callback && !defer_local_stream_until_probe) {
+                        std::string new_text = tokenizer->decode({next_token});
+                        callback(new_text.c_str(), next_token, user_data);
+                    }
                 }
+            } else {
+                trim_stop_suffix(generated_tokens, stop_token_sequences, prompt.options.include_stop_sequences);
             }
-        } else {
-            trim_stop_suffix(generated_tokens, stop_token_sequences, prompt.options.include_stop_sequences);
         }
 
         if (defer_local_stream_until_probe) {
@@ -1075,6 +1136,7 @@ int cactus_complete(
         if (prompt.options.force_tools && !prompt.tools.empty()) {
             handle->model->clear_tool_constraints();
         }
+        handle->model->clear_grammar();
 
         auto end_time = std::chrono::high_resolution_clock::now();
         double total_time_ms = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count() / 1000.0;
@@ -1130,6 +1192,7 @@ int cactus_complete(
                 if (prompt.options.force_tools && !prompt.tools.empty()) {
                     handle->model->clear_tool_constraints();
                 }
+                handle->model->clear_grammar();
                 return return_cloud_completion(cloud_result, elapsed_ms, elapsed_ms, confidence, prompt_tokens,
                                                trigger_reason);
             }
@@ -1160,7 +1223,8 @@ int cactus_complete(
                                                      total_time_ms, prefill_tps, decode_tps, prompt_tokens,
                                                      completion_tokens, confidence, handoff_succeeded,
                                                      thinking_text, {}, response_text,
-                                                     prompt.options.confidence_threshold, handoff_reason);
+                                                     prompt.options.confidence_threshold, handoff_reason,
+                                                     n_best_texts.size() > 1 ? n_best_texts : std::vector<std::string>{});
 
         if (result.length() >= buffer_size) {
             handle_error_response("Response buffer too small", response_buffer, buffer_size);
@@ -1339,7 +1403,7 @@ int cactus_tokenize(
         auto* handle = static_cast<CactusModelHandle*>(model);
         auto* tokenizer = handle->model->get_tokenizer();
 
-        std::vector<uint32_t> toks = tokenizer->encode(std::string(text));
+        std::vector<uint32_t> toks = tokenizer->encode_parallel(std::string(text));
         *out_token_len = toks.size();
 
         if (!token_buffer || token_buffer_len == 0) return 0;
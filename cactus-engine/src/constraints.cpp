@@ -5,7 +5,7 @@ namespace engine {
 
 constexpr float FORCE_BIAS = 500.0f;
 constexpr float BLOCK_BIAS = -500.0f;
-constexpr float TRIE_BLOCK_BIAS = -1e9f;
+constexpr size_t kMaxCachedTrieMasks = 256;
 
 static constexpr const char* kEscapeTag = "<|\"|>";
 static constexpr size_t kEscapeTagLen = 5;
@@ -84,17 +84,31 @@ void ToolCallConstrainer::mark_trie_bias(const TrieNode* node, char terminator,
                                          int32_t terminal_token, bool exact_terminator) {
     if (!node) return;
 
-    std::vector<bool> valid(token_strings_.size(), false);
+    TrieMaskKey key{node, terminator, std::string(extra_allowed.begin(), extra_allowed.end()),
+                    terminal_token, exact_terminator};
+    auto cached = mask_cache_.find(key);
+    if (cached != mask_cache_.end()) {
+        if (!cached->second.empty()) active_mask_ = cached->second.data();
+        return;
+    }
+    if (mask_cache_.size() >= kMaxCachedTrieMasks) {
+        active_mask_ = nullptr;  // points into the cache being dropped
+        mask_cache_.clear();
+    }
+
+    std::vector<uint64_t> mask((token_strings_.size() + 63) / 64, 0);
     bool has_valid = false;
+    auto is_set = [&](uint32_t token_id) { return (mask[token_id >> 6] >> (token_id & 63)) & 1; };
+    auto set = [&](uint32_t token_id) {
+        mask[token_id >> 6] |= 1ULL << (token_id & 63);
+        has_valid = true;
+    };
     auto mark = [&](char first_char, bool unconditional) {
         auto idx_it = token_index_.find(first_char);
         if (idx_it == token_index_.end()) return;
         for (uint32_t token_id : idx_it->second) {
-            if (valid[token_id]) continue;
-            if (unconditional || trie_token_valid(token_strings_[token_id], node, terminator)) {
-                valid[token_id] = true;
-                has_valid = true;
-            }
+            if (is_set(token_id)) continue;
+            if (unconditional || trie_token_valid(token_strings_[token_id], node, terminator)) set(token_id);
         }
     };
 
@@ -104,10 +118,7 @@ void ToolCallConstrainer::mark_trie_bias(const TrieNode* node, char terminator,
             auto idx_it = token_index_.find(terminator);
             if (idx_it != token_index_.end()) {
                 for (uint32_t token_id : idx_it->second) {
-                    if (!valid[token_id] && token_strings_[token_id].size() == 1) {
-                        valid[token_id] = true;
-                        has_valid = true;
-                    }
+                    if (!is_set(token_id) && token_strings_[token_id].size() == 1) set(token_id);
                 }
             }
         } else {
@@ -117,21 +128,17 @@ void ToolCallConstrainer::mark_trie_bias(const TrieNode* node, char terminator,
     for (char c : extra_allowed) mark(c, true);
     if (node->is_terminal && terminal_token >= 0) {
         uint32_t tid = static_cast<uint32_t>(terminal_token);
-        if (tid < valid.size() && !valid[tid]) {
-            valid[tid] = true;
-            has_valid = true;
-        }
+        if (tid < token_strings_.size() && !is_set(tid)) set(tid);
     }
-    if (!has_valid) return;
+    if (!has_valid) mask.clear();
 
-    for (size_t token_id = 0; token_id < valid.size(); ++token_id) {
-        if (!valid[token_id]) {
-            current_bias_[static_cast<uint32_t>(token_id)] = TRIE_BLOCK_BIAS;
-        }
-    }
+    auto& stored = mask_cache_.emplace(std::move(key), std::move(mask)).first->second;
+    if (!stored.empty()) active_mask_ = stored.data();
 }
 
 void ToolCallConstrainer::reset_constraint_state() {
+    active_mask_ = nullptr;
+    mask_cache_.clear();
     region_ = Region::FREE;
     constraint_buffer_.clear();
     constrained_buf_.clear();
@@ -149,6 +156,8 @@ void ToolCallConstrainer::reset_constraint_state() {
 }
 
 void ToolCallConstrainer::rebuild_remaining_keys() {
+    active_mask_ = nullptr;
+    mask_cache_.clear();
     remaining_key_trie_ = std::make_unique<TrieNode>();
     for (const auto& tool : tool_specs_) {
         if (tool.name != current_function_) continue;
@@ -520,6 +529,7 @@ void ToolCallConstrainer::update(uint32_t token_id, const std::string& decoded_t
 
 void ToolCallConstrainer::compute_bias() {
     current_bias_.clear();
+    active_mask_ = nullptr;
 
     if (!active_) return;
 
@@ -2,16 +2,20 @@
 
 #include <vector>
 #include <string>
+#include <functional>
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
+#include <tuple>
 #include <cstdint>
 #include <atomic>
+#include <thread>
 #include <limits>
 
 #include "cactus_graph.h"
 #include "kv_compress.h"
+#include "vision_cache.h"
 
 class CactusGraph;
 
@@ -186,6 +190,10 @@ struct Config {
     int32_t kv_compress_trigger_len = 4096;
     int32_t kv_compress_target_len = 2048;
     bool kv_compress_preserve_special = true;
+    // Start KeyDiff scoring this many tokens before the trigger on a background thread and swap the
+    // compacted cache in at a step boundary; 0 compacts synchronously at the trigger.
+    // Override with CACTUS_KV_COMPRESS_ASYNC_LEAD.
+    int32_t kv_compress_async_lead = 256;
 
     uint32_t altup_num_inputs = 4;
     uint32_t laurel_rank = 64;
@@ -252,17 +260,6 @@ struct Config {
 
 
 
-struct MergeRule {
-    std::string first;
-    std::string second;
-    std::string merged;
-    uint32_t priority;
-    
-    MergeRule(const std::string& f, const std::string& s, const std::string& m, uint32_t p)
-        : first(f), second(s), merged(m), priority(p) {}
-};
-
-
 struct ToolCallInfo {
     std::string name;
     std::string arguments;
@@ -329,6 +326,8 @@ public:
 
     virtual std::vector<uint32_t> encode(const std::string& text) const = 0;
     virtual std::string decode(const std::vector<uint32_t>& tokens) const = 0;
+    // Same ids as encode(); long inputs are cut where no merge can cross and encoded on the thread pool.
+    virtual std::vector<uint32_t> encode_parallel(const std::string& text) const { return encode(text); }
 
     virtual std::vector<uint32_t> apply_chat_template(const std::vector<ChatMessage>& messages, bool add_generation_prompt = true) const;
     virtual std::string format_chat_prompt(const std::vector<ChatMessage>& messages, bool add_generation_prompt = true, const std::string& tools_json = "", bool enable_thinking_if_supported = false) const;
@@ -377,6 +376,10 @@ protected:
     bool has_lfm2_vision_config_ = false;
     TokenizerRuntimeConfig runtime_config_;
 
+    static constexpr size_t kParallelEncodeChunkBytes = 16 * 1024;
+    static std::vector<uint32_t> encode_chunks_parallel(size_t num_chunks,
+        const std::function<void(size_t, std::vector<uint32_t>&)>& encode_chunk);
+
     void detect_model_type(const std::string& config_path);
     void load_chat_template(const std::string& template_file);
     std::string format_gemma4_style(const std::vector<ChatMessage>& messages, bool add_generation_prompt, const std::string& tools_json, bool enable_thinking_if_supported = false) const;
@@ -395,6 +398,7 @@ public:
     bool load_vocabulary_with_config(const std::string& vocab_file, const std::string& merges_file, const std::string& config_file) override;
 
     std::vector<uint32_t> encode(const std::string& text) const override;
+    std::vector<uint32_t> encode_parallel(const std::string& text) const override;
     std::string decode(const std::vector<uint32_t>& tokens) const override;
 
     uint32_t get_vocab_size() const override { return vocab_size_; }
@@ -408,10 +412,42 @@ public:
     }
 
 private:
+    static constexpr uint32_t NO_SYMBOL = UINT32_MAX;
+
+    struct MergeSlot {
+        uint64_t pair = UINT64_MAX;
+        uint32_t rank = 0;
+        uint32_t merged = NO_SYMBOL;
+    };
+
+    struct CharInfo {
+        uint32_t symbol = NO_SYMBOL;
+        uint32_t joint = NO_SYMBOL;
+    };
+
+    struct Symbol {
+        uint32_t id;
+        uint32_t start;
+        uint32_t len;
+        int32_t prev;
+        int32_t next;
+    };
+
+    struct WordCache;
+
     std::unordered_map<std::string, uint32_t> token_to_id_;
     std::vector<std::string> id_to_token_;
-    std::vector<MergeRule> merge_rules_;
-    std::unordered_map<std::string, uint32_t> merge_map_;  
+
+    std::vector<MergeSlot> merge_table_;
+    size_t merge_count_ = 0;
+    std::unordered_map<std::string, uint32_t> extra_symbols_;
+
+    uint32_t byte_symbol_[256];
+    std::vector<uint8_t> byte_joinable_;
+    std::unordered_map<uint64_t, CharInfo> char_info_;
+    std::unordered_set<uint64_t> char_joinable_;
+
+    std::unique_ptr<WordCache> word_cache_;
 
     uint32_t vocab_size_;
     uint32_t unk_token_id_;
@@ -424,20 +460,25 @@ private:
     void* merges_mmap_ptr_;
     size_t merges_mmap_size_;
 
-    std::vector<std::string> apply_bpe(const std::vector<std::string>& tokens) const;
-    std::pair<int, uint32_t> find_best_merge_fast(const std::vector<std::string>& tokens) const;
-    
-    std::string bytes_to_unicode(const std::string& text) const;
+    uint32_t symbol_id(const std::string& token);
+    const MergeSlot* find_merge(uint32_t left, uint32_t right) const;
+    bool add_merge(uint32_t left, uint32_t right, uint32_t rank, uint32_t merged);
+    void build_symbol_tables(const std::vector<std::string>& merged_tokens);
+    void encode_run(const std::string& text, const std::vector<Symbol>& initial, size_t begin, size_t end,
+                    std::vector<uint32_t>& out) const;
+    void append_token_ids(const std::string& token, std::vector<uint32_t>& out) const;
+    std::string normalize_segment(const std::string& segment) const;
+    void encode_segment(const std::string& text, size_t begin, size_t end, std::vector<uint32_t>& out) const;
+    void split_segment(const std::string& text, size_t chunk_bytes, std::vector<std::pair<size_t, size_t>>& ranges) const;
+
     std::string unicode_to_bytes(const std::string& text) const;
-    std::vector<std::string> byte_level_split(const std::string& text) const;
-    std::vector<std::string> utf8_split(const std::string& text) const;
 
     void cleanup_mmap();
-    
+
 private:
-    mutable std::unordered_map<uint8_t, std::string> byte_to_unicode_;
-    mutable std::unordered_map<std::string, uint8_t> unicode_to_byte_;
-    void init_byte_mappings() const;
+    std::unordered_map<uint8_t, std::string> byte_to_unicode_;
+    std::unordered_map<std::string, uint8_t> unicode_to_byte_;
+    void init_byte_mappings();
 
     std::unordered_map<std::string, uint32_t> special_tokens_;
     std::vector<std::string> split_with_special_tokens(const std::string& text) const;
@@ -452,6 +493,7 @@ public:
     bool load_vocabulary_with_config(const std::string& vocab_file, const std::string& merges_file, const std::string& config_file) override;
 
     std::vector<uint32_t> encode(const std::string& text) const override;
+    std::vector<uint32_t> encode_parallel(const std::string& text) const override;
     std::string decode(const std::vector<uint32_t>& tokens) const override;
 
     uint32_t get_vocab_size() const override { return vocab_size_; }
@@ -465,13 +507,15 @@ public:
     }
 
 private:
-    struct TrieNode {
-        std::unordered_map<char32_t, std::unique_ptr<TrieNode>> children;
-        int32_t token_id = -1;
-        float score = 0.0f;
+    struct DoubleArrayUnit {
+        int32_t base = 0;
+        int32_t check = -1;
+        int32_t value = -1;
     };
 
-    std::unique_ptr<TrieNode> trie_root_;
+    std::vector<DoubleArrayUnit> trie_;
+    std::unordered_set<char32_t> space_joiners_;
+    float unk_score_ = 0.0f;
     std::unordered_map<std::string, uint32_t> token_to_id_;
     std::vector<std::string> id_to_token_;
     std::vector<float> token_scores_;
@@ -483,6 +527,7 @@ private:
     uint32_t pad_token_id_;
 
     bool sp_bpe_mode_ = false;
+    bool sp_unigram_mode_ = false;
     bool sp_add_dummy_prefix_ = false;
     bool sp_byte_fallback_ = false;
 
@@ -490,11 +535,15 @@ private:
     size_t vocab_mmap_size_;
 
     void build_trie();
-    std::vector<std::pair<std::string, uint32_t>> tokenize_with_trie(const std::string& text) const;
-    std::vector<uint32_t> tokenize_with_bpe(const std::string& text) const;
+    void tokenize_with_trie(const std::string& text, std::vector<uint32_t>& out) const;
+    void tokenize_with_viterbi(const std::string& text, std::vector<uint32_t>& out) const;
+    void tokenize_with_bpe(const std::string& text, std::vector<uint32_t>& out) const;
+    void append_unknown(const char* bytes, size_t len, std::vector<uint32_t>& out) const;
     std::string preprocess_text(const std::string& text) const;
     std::string postprocess_text(const std::string& text) const;
     std::vector<std::string> split_by_unicode_spaces(const std::string& text) const;
+    void encode_processed(const std::string& processed, std::vector<uint32_t>& out) const;
+    void split_processed(const std::string& processed, size_t chunk_bytes, std::vector<std::pair<size_t, size_t>>& ranges) const;
 
     void cleanup_mmap();
 
@@ -522,6 +571,7 @@ public:
               Tokenizer* tokenizer);
 
     const std::unordered_map<uint32_t, float>& get_bias() const { return current_bias_; }
+    const uint64_t* get_token_mask() const { return active_mask_; }
 
     void update(uint32_t token_id, const std::string& decoded_text);
 
@@ -561,6 +611,10 @@ private:
     std::unordered_set<uint32_t> close_brace_tokens_;
 
     std::unordered_map<uint32_t, float> current_bias_;
+    const uint64_t* active_mask_ = nullptr;
+
+    using TrieMaskKey = std::tuple<const TrieNode*, char, std::string, int32_t, bool>;
+    std::map<TrieMaskKey, std::vector<uint64_t>> mask_cache_;
 
     void compute_bias();
     void tokenize_grammar_elements();
@@ -612,6 +666,73 @@ private:
     void feed_gemma_char(char ch);
 };
 
+class TokenGrammar {
+public:
+    static std::string json_schema_to_grammar(const std::string& schema_json);
+
+    void init(const std::string& grammar, const Tokenizer* tokenizer);
+    void clear();
+    void reset();
+
+    bool is_active() const { return active_; }
+    bool is_complete() const;
+    const uint64_t* get_token_mask();
+    void accept(uint32_t token_id);
+
+private:
+    struct Element {
+        enum class Kind : uint8_t { END, CHARSET, RULE };
+        Kind kind = Kind::END;
+        bool negated = false;
+        uint32_t rule = 0;
+        uint32_t range_begin = 0;
+        uint32_t range_count = 0;
+    };
+    using Stack = std::vector<uint32_t>;
+
+    struct MatchState {
+        std::vector<Stack> stacks;
+        uint32_t partial_codepoint = 0;
+        uint8_t partial_remaining = 0;
+    };
+
+    struct VocabNode {
+        std::vector<std::pair<uint8_t, uint32_t>> children;
+        std::vector<uint32_t> tokens;
+    };
+
+    bool active_ = false;
+    const Tokenizer* tokenizer_ = nullptr;
+    uint32_t eos_token_ = 0;
+    uint32_t vocab_size_ = 0;
+
+    std::string source_;
+    std::vector<Element> elements_;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges_;
+    std::vector<std::vector<uint32_t>> rule_alternatives_;
+    uint32_t root_rule_ = 0;
+
+    std::vector<std::string> token_strings_;
+    std::vector<VocabNode> vocab_trie_;
+
+    MatchState state_;
+    bool finished_ = false;
+    std::unordered_map<std::string, std::vector<uint64_t>> mask_cache_;
+    std::vector<uint64_t> fallback_mask_;
+
+    void parse(const std::string& grammar);
+    void check_left_recursion() const;
+    void build_vocab_trie();
+
+    bool charset_matches(const Element& element, uint32_t codepoint) const;
+    bool charset_accepts_multibyte(const Element& element) const;
+    void expand_stack(Stack& stack, std::vector<Stack>& out) const;
+    std::vector<Stack> advance_codepoint(const std::vector<Stack>& stacks, uint32_t codepoint) const;
+    bool advance_byte(const MatchState& state, uint8_t byte, MatchState& out) const;
+    void fill_mask(uint32_t node, const MatchState& state, std::vector<uint64_t>& mask) const;
+    std::string state_key() const;
+};
+
 class Model {
 public:
     struct DebugNode {
@@ -646,6 +767,31 @@ public:
     void set_decode_slots(size_t num_slots);
     std::vector<uint32_t> batch_stop_token_ids() const;
 
+    // Beams live in KV cache slots: a beam that keeps its parent's slot decodes in place and only
+    // extra children of one parent fork its slot. Each temperature in `temperatures` is one attempt;
+    // 0 runs beam search, anything higher samples `beam_size` candidates, and the next attempt runs
+    // only while the best hypothesis averages below `logprob_threshold` per token.
+    struct BeamSearchOptions {
+        size_t beam_size = 4;
+        size_t n_best = 1;
+        size_t max_tokens = 100;
+        float length_penalty = 1.0f;
+        std::vector<float> temperatures = {0.0f};
+        float logprob_threshold = -std::numeric_limits<float>::infinity();
+    };
+    struct BeamHypothesis {
+        std::vector<uint32_t> tokens;
+        float logprob = 0.0f;
+        float score = 0.0f;
+        float temperature = 0.0f;
+        bool finished = false;
+    };
+
+    std::vector<BeamHypothesis> beam_search(const std::vector<uint32_t>& prompt_tokens,
+                                            const BeamSearchOptions& options,
+                                            const std::vector<std::vector<uint32_t>>& stop_token_sequences,
+                                            const std::atomic<bool>* should_stop = nullptr);
+
     void prefill(const std::vector<uint32_t>& tokens, size_t chunk_size = 128, const std::string& profile_file = "",
                  bool prepare_decode = true);
 
@@ -695,6 +841,12 @@ public:
                                                      const std::vector<std::vector<uint32_t>>& stop_token_sequences,
                                                      const std::atomic<bool>* should_stop = nullptr,
                                                      int64_t suppress_token_id = -1);
+    std::vector<BeamHypothesis> transcribe_whisper_beam(const std::vector<float>& audio_features,
+                                                        const std::vector<uint32_t>& decoder_prompt_tokens,
+                                                        const BeamSearchOptions& options,
+                                                        const std::vector<std::vector<uint32_t>>& stop_token_sequences,
+                                                        const std::atomic<bool>* should_stop = nullptr,
+                                                        int64_t suppress_token_id = -1);
 
     std::vector<float> get_embeddings(const std::vector<uint32_t>& tokens, bool pooled = true,
                                        bool normalize = false, const std::string& profile_file = "");
@@ -723,6 +875,8 @@ public:
 
     double score_tokens_window_logprob(const std::vector<uint32_t>& tokens, size_t start, size_t end,
                                         size_t context, size_t* tokens_scored);
+    // Log-softmax of the last decoder logits at `token`; -inf when no logits are available.
+    double last_token_logprob(uint32_t token);
 
     void set_cache_window(size_t window_size, size_t sink_size = 4);
     size_t get_cache_size() const { return cache_total_seq_len_; }
@@ -755,6 +909,11 @@ public:
     void clear_tool_constraints();
     void update_tool_constraints(uint32_t token_id);
 
+    void set_grammar(const std::string& grammar);
+    void clear_grammar();
+    void update_grammar(uint32_t token_id);
+    bool has_grammar() const { return grammar_.is_active(); }
+
     void set_vocab_bias(const std::unordered_map<uint32_t, float>& bias) { vocab_bias_ = bias; }
     void clear_vocab_bias() { vocab_bias_.clear(); }
     bool has_vocab_bias() const { return !vocab_bias_.empty(); }
@@ -809,8 +968,20 @@ private:
     bool bind_runtime_buffers(Component& comp);
     void run_step(uint32_t token_id, size_t position, bool read_logits);
     void run_step_batch(const std::vector<uint32_t>& token_ids, const std::vector<size_t>& positions);
-    void set_component_batch(Component& comp, size_t batch);
+    void set_component_batch(Component& comp, size_t batch, bool tile_first_row = false);
     size_t decoder_cache_num_slots();
+    static bool has_dynamic_batch_input(const Component& comp);
+    bool decoder_supports_cache_slots();
+    void fork_decoder_cache_slot(size_t src_slot, size_t dst_slot);
+    void share_decoder_cache_prefix(size_t num_slots, size_t tail_rows);
+    void reslot_decoder_cache(size_t num_slots, size_t src_slot, size_t dst_slot);
+    void beam_row_logprobs(size_t row, size_t rows, std::vector<float>& out);
+    using BeamStepFn = std::function<bool(const std::vector<uint32_t>& tokens, size_t position,
+                                          std::vector<std::vector<float>>& logprobs)>;
+    std::vector<BeamHypothesis> run_beam_search(size_t start_position, const std::vector<float>& prompt_logprobs,
+                                                size_t prompt_slot, const BeamSearchOptions& options,
+                                                const std::vector<std::vector<uint32_t>>& stop_token_sequences,
+                                                const std::atomic<bool>* should_stop, const BeamStepFn& step);
     void run_encoder_step(uint32_t token_id, size_t position);
     void run_media_step(size_t position, const uint8_t* feature_row, size_t feature_row_bytes,
                         Precision feature_precision);
@@ -822,6 +993,7 @@ private:
     bool prepare_encoder_cross_kv_from_text(const std::vector<uint32_t>& tokens);
     bool prepare_encoder_cross_kv_from_audio(const std::vector<float>& audio_features);
     bool run_encoder_cross_kv_decoder_step(uint32_t token_id, size_t position);
+    bool run_encoder_cross_kv_decoder_step(const std::vector<uint32_t>& token_ids, size_t position);
     std::vector<uint32_t> run_encoder_cross_kv_decode_loop(
         const std::vector<uint32_t>& decoder_prompt_tokens,
         size_t max_tokens,
@@ -837,6 +1009,63 @@ private:
     void set_cache_current_len(Component& comp, size_t len);
     void reset_component_cache_states(Component& comp);
     void reset_prefill_stats();
+
+    // Rolling compaction is split so the expensive part can run off the decode thread: prepare
+    // (main thread) records the compressible caches, score (any thread) builds per-head keep-sets
+    // over rows [0, snapshot_len), which single-token decode steps never rewrite, and apply
+    // (main thread) gathers the kept rows plus everything appended since the snapshot.
+    struct KvCompactionLayer {
+        size_t cache_index = 0;
+        Precision precision = Precision::INT8;
+        const void* key_rows = nullptr;
+        const float* key_scales = nullptr;
+        size_t rows = 0;
+        size_t kv_heads = 0;
+        size_t head_dim = 0;
+        std::vector<std::vector<int>> protect;
+        std::vector<std::vector<int>> kept;
+    };
+    struct KvCompactionPlan {
+        cactus::kvcompress::Params params;
+        size_t snapshot_len = 0;
+        size_t rope_len = 0;
+        double rope_theta = 0.0;
+        bool per_head_protect = false;
+        std::vector<int> appended_special;
+        std::vector<KvCompactionLayer> layers;
+        std::vector<cactus::kvcompress::RopeRotation> unrope;
+    };
+    struct KvCompactionJob {
+        KvCompactionPlan plan;
+        std::thread worker;
+        std::atomic<bool> done{false};
+        ~KvCompactionJob() { if (worker.joinable()) worker.join(); }
+    };
+    bool prepare_kv_compaction(const cactus::kvcompress::Params& params, size_t rope_len, KvCompactionPlan& plan);
+    static void score_kv_compaction(KvCompactionPlan& plan);
+    bool apply_kv_compaction(KvCompactionPlan& plan);
+    void start_kv_compaction();
+    void settle_kv_compaction();
+
+    // Everything reset_cache() clears, set aside so a scratch pass can run on an empty cache and the
+    // caller's conversation comes back untouched. Cache buffers are moved, not copied.
+    struct CacheStash {
+        std::vector<std::tuple<Component*, size_t, BufferDesc>> buffers;
+        std::unique_ptr<KvCompactionJob> compaction;
+        size_t total_seq_len = 0;
+        size_t last_logit_position = 0;
+        bool encoder_cross_kv_ready = false;
+        std::vector<uint32_t> context_tokens;
+        std::vector<uint32_t> cache_token_ids;
+        std::vector<uint32_t> token_history;
+        cactus::kvcompress::SpecialRowTracker special_rows;
+        std::map<std::string, std::vector<uint8_t>> media_features;
+        std::map<std::string, std::vector<size_t>> media_feature_shapes;
+        std::map<std::string, Precision> media_feature_precisions;
+    };
+    CacheStash stash_cache();
+    void restore_cache(CacheStash& stash);
+
     size_t component_chunk_tokens(const Component& comp, const std::string& input_name) const;
     size_t component_output_tokens(const Component& comp, const std::string& output_name) const;
     ChunkedPrefillResult run_chunked_prefill(const std::vector<uint32_t>& tokens, size_t start_position,
@@ -847,6 +1076,7 @@ private:
     void run_full_context_text();
     uint32_t argmax_component_logits(Component& comp, size_t logit_row = std::numeric_limits<size_t>::max(),
                                      float* out_uncertainty = nullptr);
+    const uint64_t* prepare_logit_mask(size_t vocab);
     uint32_t argmax_logits_at(const BufferDesc& desc, void* ptr, size_t row_off, float* out_uncertainty);
     std::vector<uint32_t> argmax_component_logits_batch(Component& comp, size_t batch);
     void write_int_input(Component& comp, const std::string& name, int64_t value);
@@ -855,9 +1085,23 @@ private:
     int input_index(const Component& comp, const std::string& name) const;
     int output_index(const Component& comp, const std::string& name) const;
     uint32_t argmax_last_logits(float* out_uncertainty = nullptr);
+    size_t default_logit_row(size_t seq) const;
     bool load_handoff_probe();
     void maybe_capture_handoff_probe_hidden(const Component& comp, const std::string& output_name = "probe_hidden");
+    struct VisionFeatureMark {
+        size_t bytes = 0;
+        size_t rows = 0;
+    };
+    using VisionFeatureMarks = std::map<std::string, VisionFeatureMark>;
+
+    void configure_vision_cache();
+    std::vector<std::string> vision_feature_names() const;
+    VisionFeatureMarks mark_vision_features() const;
+    VisionCacheEntry capture_vision_features(const VisionFeatureMarks& marks) const;
+    void append_vision_features(const VisionCacheEntry& entry);
+    void clear_vision_features();
     void run_vision_encoder(const std::string& image_path);
+    void run_vision_encoder_uncached(const std::string& image_path);
     void run_vision_encoder_lfm2_vl(const std::string& image_path);
     void encode_lfm2_vl_image_into_features(const std::string& image_path);
     bool load_lfm2_vl_position_grid();
@@ -917,6 +1161,7 @@ private:
     std::map<std::string, std::vector<uint8_t>> media_features_;
     std::map<std::string, std::vector<size_t>> media_feature_shapes_;
     std::map<std::string, Precision> media_feature_precisions_;
+    VisionFeatureCache vision_cache_;
 
     std::vector<float> lfm2_pos_grid_;
     int lfm2_pos_grid_h_ = 0;
@@ -931,6 +1176,7 @@ private:
     std::vector<uint32_t> cache_token_ids_;        // token id per cache row (canonical head-0 view)
     std::unordered_set<uint32_t> special_ids_;     // special-token ids force-kept during compaction
     cactus::kvcompress::SpecialRowTracker special_rows_;  // per-(layer,head) special rows for compaction protect
+    std::unique_ptr<KvCompactionJob> kv_compaction_;      // in-flight background keep-set scoring
     size_t cache_max_seq_len_ = 4096;
     size_t last_logit_position_ = 0;
     double last_prefill_cache_copy_ms_ = 0.0;
@@ -944,6 +1190,10 @@ private:
     std::vector<uint32_t> token_history_;
 
     ToolCallConstrainer tool_constrainer_;
+    TokenGrammar grammar_;
+    std::vector<uint64_t> logit_mask_;
+    std::vector<uint64_t> logit_mask_scratch_;
+    std::vector<size_t> masked_bias_tokens_;
     std::unordered_map<uint32_t, float> vocab_bias_;
     int64_t suppressed_token_id_ = -1;
 
@@ -1072,11 +1322,7 @@ private:
     std::pair<int, int> find_closest_aspect_ratio(float aspect_ratio, int width, int height);
     std::vector<float> resize_image(const unsigned char* img_data, int src_width, int src_height,
                                     int dst_width, int dst_height, int channels);
-    std::vector<float> normalize_image(const float* img_data, int width, int height, int channels);
-    std::vector<std::vector<float>> convert_image_to_patches(
-        const std::vector<float>& image, int width, int height, int channels, int patch_size);
-    PreprocessedImage pad_patches(const std::vector<std::vector<float>>& tile_patches,
-                                  const std::vector<std::pair<int, int>>& spatial_shapes,
+    PreprocessedImage pad_patches(const std::vector<std::pair<int, int>>& spatial_shapes,
                                   int patch_dim,
                                   int max_patches_per_tile);
     int round_by_factor(int number, int factor);
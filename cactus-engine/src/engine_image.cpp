@@ -9,6 +9,7 @@
 #include "stb_image.h"
 #include "stb_image_resize2.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring>
 #include <limits>
@@ -16,12 +17,17 @@
 #include <vector>
 #include <iostream>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace cactus {
 namespace engine {
 
 namespace {
 
 constexpr int kPillowResizePrecisionBits = 22;
+constexpr CactusThreading::ParallelConfig kImageRowParallel{64, 32};
 
 static unsigned char pillow_clip8(int64_t value) {
     int shifted = static_cast<int>(value >> kPillowResizePrecisionBits);
@@ -90,42 +96,198 @@ static std::vector<unsigned char> resize_rgb_uint8_pillow_bilinear(const unsigne
     const int y_last = y_bounds[static_cast<size_t>(dst_h - 1) * 2] +
                        y_bounds[static_cast<size_t>(dst_h - 1) * 2 + 1];
     const int temp_h = y_last - y_first;
-    std::vector<unsigned char> temp(static_cast<size_t>(dst_w) * temp_h * 3);
-
-    for (int ty = 0; ty < temp_h; ++ty) {
-        const int sy = y_first + ty;
-        for (int dx = 0; dx < dst_w; ++dx) {
-            const int xmin = x_bounds[static_cast<size_t>(dx) * 2];
-            const int count = x_bounds[static_cast<size_t>(dx) * 2 + 1];
-            const int32_t* k = x_coeffs.data() + static_cast<size_t>(dx) * x_ksize;
-            for (int c = 0; c < 3; ++c) {
-                int64_t sum = static_cast<int64_t>(1) << (kPillowResizePrecisionBits - 1);
-                for (int x = 0; x < count; ++x) {
-                    sum += static_cast<int64_t>(src[(static_cast<size_t>(sy) * src_w + xmin + x) * 3 + c]) * k[x];
+    const size_t row_len = static_cast<size_t>(dst_w) * 3;
+    std::vector<unsigned char> temp(row_len * temp_h);
+
+    // Bilinear weights are non-negative and sum to 2^22, so 255 * 2^22 + 2^21 fits int32 exactly.
+    CactusThreading::parallel_for(static_cast<size_t>(temp_h), kImageRowParallel, [&](size_t start, size_t end) {
+        for (size_t ty = start; ty < end; ++ty) {
+            const int sy = y_first + static_cast<int>(ty);
+            const unsigned char* src_row = src + static_cast<size_t>(sy) * src_w * 3;
+            unsigned char* out = temp.data() + ty * row_len;
+            for (int dx = 0; dx < dst_w; ++dx) {
+                const int xmin = x_bounds[static_cast<size_t>(dx) * 2];
+                const int count = x_bounds[static_cast<size_t>(dx) * 2 + 1];
+                const int32_t* k = x_coeffs.data() + static_cast<size_t>(dx) * x_ksize;
+                const unsigned char* px = src_row + static_cast<size_t>(xmin) * 3;
+#if defined(__ARM_NEON)
+                if (sy != src_h - 1 || xmin + count < src_w) {
+                    int32x4_t acc = vdupq_n_s32(1 << (kPillowResizePrecisionBits - 1));
+                    for (int x = 0; x < count; ++x) {
+                        uint32_t rgbx;
+                        std::memcpy(&rgbx, px + x * 3, sizeof(rgbx));
+                        const uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(rgbx)));
+                        acc = vmlaq_n_s32(acc, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(wide))), k[x]);
+                    }
+                    const uint16x4_t clipped = vqmovun_s32(vshrq_n_s32(acc, kPillowResizePrecisionBits));
+                    const uint8x8_t packed = vqmovn_u16(vcombine_u16(clipped, clipped));
+                    out[dx * 3 + 0] = vget_lane_u8(packed, 0);
+                    out[dx * 3 + 1] = vget_lane_u8(packed, 1);
+                    out[dx * 3 + 2] = vget_lane_u8(packed, 2);
+                    continue;
+                }
+#endif
+                for (int c = 0; c < 3; ++c) {
+                    int64_t sum = static_cast<int64_t>(1) << (kPillowResizePrecisionBits - 1);
+                    for (int x = 0; x < count; ++x) {
+                        sum += static_cast<int64_t>(px[x * 3 + c]) * k[x];
+                    }
+                    out[dx * 3 + c] = pillow_clip8(sum);
                 }
-                temp[(static_cast<size_t>(ty) * dst_w + dx) * 3 + c] = pillow_clip8(sum);
             }
         }
-    }
+    });
 
-    std::vector<unsigned char> dst(static_cast<size_t>(dst_w) * dst_h * 3);
-    for (int dy = 0; dy < dst_h; ++dy) {
-        const int ymin = y_bounds[static_cast<size_t>(dy) * 2] - y_first;
-        const int count = y_bounds[static_cast<size_t>(dy) * 2 + 1];
-        const int32_t* k = y_coeffs.data() + static_cast<size_t>(dy) * y_ksize;
-        for (int dx = 0; dx < dst_w; ++dx) {
-            for (int c = 0; c < 3; ++c) {
+    std::vector<unsigned char> dst(row_len * dst_h);
+    CactusThreading::parallel_for(static_cast<size_t>(dst_h), kImageRowParallel, [&](size_t start, size_t end) {
+        for (size_t dy = start; dy < end; ++dy) {
+            const int ymin = y_bounds[dy * 2] - y_first;
+            const int count = y_bounds[dy * 2 + 1];
+            const int32_t* k = y_coeffs.data() + dy * y_ksize;
+            const unsigned char* in = temp.data() + static_cast<size_t>(ymin) * row_len;
+            unsigned char* out = dst.data() + dy * row_len;
+            size_t i = 0;
+#if defined(__ARM_NEON)
+            for (; i + 16 <= row_len; i += 16) {
+                int32x4_t acc[4];
+                for (int q = 0; q < 4; ++q) acc[q] = vdupq_n_s32(1 << (kPillowResizePrecisionBits - 1));
+                for (int y = 0; y < count; ++y) {
+                    const uint8x16_t v = vld1q_u8(in + static_cast<size_t>(y) * row_len + i);
+                    const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+                    const uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+                    acc[0] = vmlaq_n_s32(acc[0], vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(lo))), k[y]);
+                    acc[1] = vmlaq_n_s32(acc[1], vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(lo))), k[y]);
+                    acc[2] = vmlaq_n_s32(acc[2], vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(hi))), k[y]);
+                    acc[3] = vmlaq_n_s32(acc[3], vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(hi))), k[y]);
+                }
+                const uint16x8_t n0 = vcombine_u16(vqmovun_s32(vshrq_n_s32(acc[0], kPillowResizePrecisionBits)),
+                                                   vqmovun_s32(vshrq_n_s32(acc[1], kPillowResizePrecisionBits)));
+                const uint16x8_t n1 = vcombine_u16(vqmovun_s32(vshrq_n_s32(acc[2], kPillowResizePrecisionBits)),
+                                                   vqmovun_s32(vshrq_n_s32(acc[3], kPillowResizePrecisionBits)));
+                vst1q_u8(out + i, vcombine_u8(vqmovn_u16(n0), vqmovn_u16(n1)));
+            }
+#endif
+            for (; i < row_len; ++i) {
                 int64_t sum = static_cast<int64_t>(1) << (kPillowResizePrecisionBits - 1);
                 for (int y = 0; y < count; ++y) {
-                    sum += static_cast<int64_t>(temp[(static_cast<size_t>(ymin + y) * dst_w + dx) * 3 + c]) * k[y];
+                    sum += static_cast<int64_t>(in[static_cast<size_t>(y) * row_len + i]) * k[y];
                 }
-                dst[(static_cast<size_t>(dy) * dst_w + dx) * 3 + c] = pillow_clip8(sum);
+                out[i] = pillow_clip8(sum);
             }
         }
-    }
+    });
     return dst;
 }
 
+static void widen_u8_to_f32(const unsigned char* src, float* dst, size_t count) {
+    CactusThreading::parallel_for(count, CactusThreading::Thresholds::ELEMENT_WISE, [&](size_t start, size_t end) {
+        size_t i = start;
+#if defined(__ARM_NEON)
+        for (; i + 16 <= end; i += 16) {
+            const uint8x16_t v = vld1q_u8(src + i);
+            const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+            const uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+            vst1q_f32(dst + i, vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))));
+            vst1q_f32(dst + i + 4, vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))));
+            vst1q_f32(dst + i + 8, vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))));
+            vst1q_f32(dst + i + 12, vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))));
+        }
+#endif
+        for (; i < end; ++i) dst[i] = static_cast<float>(src[i]);
+    });
+}
+
+// Same result as stbir_resize_float_linear; stbir splits the output rows into independent jobs.
+static bool resize_float_linear_parallel(const float* src, int src_w, int src_h,
+                                         float* dst, int dst_w, int dst_h, stbir_pixel_layout layout) {
+    STBIR_RESIZE resize;
+    stbir_resize_init(&resize, src, src_w, src_h, 0, dst, dst_w, dst_h, 0, layout, STBIR_TYPE_FLOAT);
+    const size_t workers = CactusThreading::get_optimal_thread_count(static_cast<size_t>(dst_h), kImageRowParallel);
+    const int splits = stbir_build_samplers_with_splits(&resize, static_cast<int>(workers));
+    if (splits <= 0) return false;
+    std::atomic<bool> ok{true};
+    CactusThreading::parallel_for(static_cast<size_t>(splits), CactusThreading::ParallelConfig{2, 1},
+        [&](size_t start, size_t end) {
+            if (!stbir_resize_extended_split(&resize, static_cast<int>(start), static_cast<int>(end - start))) {
+                ok = false;
+            }
+        });
+    stbir_free_samplers(&resize);
+    return ok;
+}
+
+// Rescales then normalizes interleaved RGB as ((v * scale) - mean[c]) / std[c], matching the scalar op order.
+static void normalize_rgb_run(const float* src, float* dst, int pixels,
+                              float scale, const float* mean, const float* std_dev) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t vmean[3] = {vdupq_n_f32(mean[0]), vdupq_n_f32(mean[1]), vdupq_n_f32(mean[2])};
+    const float32x4_t vstd[3] = {vdupq_n_f32(std_dev[0]), vdupq_n_f32(std_dev[1]), vdupq_n_f32(std_dev[2])};
+    for (; i + 4 <= pixels; i += 4) {
+        float32x4x3_t v = vld3q_f32(src + i * 3);
+        for (int c = 0; c < 3; ++c) {
+            v.val[c] = vdivq_f32(vsubq_f32(vmulq_f32(v.val[c], vscale), vmean[c]), vstd[c]);
+        }
+        vst3q_f32(dst + i * 3, v);
+    }
+#endif
+    for (; i < pixels; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            float v = src[i * 3 + c] * scale;
+            dst[i * 3 + c] = (v - mean[c]) / std_dev[c];
+        }
+    }
+}
+
+static void normalize_rgb_run(const unsigned char* src, float* dst, int pixels,
+                              float scale, const float* mean, const float* std_dev) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t vmean[3] = {vdupq_n_f32(mean[0]), vdupq_n_f32(mean[1]), vdupq_n_f32(mean[2])};
+    const float32x4_t vstd[3] = {vdupq_n_f32(std_dev[0]), vdupq_n_f32(std_dev[1]), vdupq_n_f32(std_dev[2])};
+    for (; i + 8 <= pixels; i += 8) {
+        const uint8x8x3_t rgb = vld3_u8(src + i * 3);
+        float32x4x3_t lo, hi;
+        for (int c = 0; c < 3; ++c) {
+            const uint16x8_t wide = vmovl_u8(rgb.val[c]);
+            lo.val[c] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide)));
+            hi.val[c] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(wide)));
+            lo.val[c] = vdivq_f32(vsubq_f32(vmulq_f32(lo.val[c], vscale), vmean[c]), vstd[c]);
+            hi.val[c] = vdivq_f32(vsubq_f32(vmulq_f32(hi.val[c], vscale), vmean[c]), vstd[c]);
+        }
+        vst3q_f32(dst + i * 3, lo);
+        vst3q_f32(dst + i * 3 + 12, hi);
+    }
+#endif
+    for (; i < pixels; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            float v = static_cast<float>(src[i * 3 + c]) * scale;
+            dst[i * 3 + c] = (v - mean[c]) / std_dev[c];
+        }
+    }
+}
+
+// Normalizes an interleaved RGB image (row stride in pixels) straight into row-major [patch][y][x][c] patches.
+template <typename T>
+static void normalize_rgb_into_patches(const T* image, int stride, int width, int height, int patch,
+                                       float* dst, float scale, const float* mean, const float* std_dev) {
+    const int patches_w = width / patch;
+    const size_t patch_dim = static_cast<size_t>(patch) * patch * 3;
+    CactusThreading::parallel_for(static_cast<size_t>(height), kImageRowParallel, [&](size_t start, size_t end) {
+        for (size_t row = start; row < end; ++row) {
+            const T* src_row = image + row * stride * 3;
+            const size_t ph = row / patch;
+            const size_t y = row % patch;
+            for (int pw = 0; pw < patches_w; ++pw) {
+                float* out = dst + (ph * patches_w + pw) * patch_dim + y * patch * 3;
+                normalize_rgb_run(src_row + static_cast<size_t>(pw) * patch * 3, out, patch, scale, mean, std_dev);
+            }
+        }
+    });
+}
+
 } // namespace
 
 Siglip2Preprocessor::PreprocessedImage::~PreprocessedImage() {
@@ -390,93 +552,86 @@ Siglip2Preprocessor::PreprocessedImage Siglip2Preprocessor::preprocess_from_memo
         expected_tiles += 1;
     }
 
-    std::vector<std::vector<float>> tile_patches;
-    tile_patches.reserve(expected_tiles);
+    struct TileSource {
+        const float* pixels;
+        const unsigned char* raw;
+        int stride;
+        int width;
+        int height;
+    };
+    std::vector<TileSource> tiles;
+    tiles.reserve(expected_tiles);
     std::vector<std::pair<int, int>> spatial_shapes;
     spatial_shapes.reserve(expected_tiles);
 
-    auto normalize_and_patchify = [&](const float* data_ptr, int img_width, int img_height) {
+    auto add_tile = [&](const float* pixels, const unsigned char* raw, int stride, int img_width, int img_height) {
         if (img_height % patch != 0 || img_width % patch != 0) {
             throw std::runtime_error("Image dimensions must be divisible by patch size");
         }
-        std::vector<float> normalized = normalize_image(data_ptr, img_width, img_height, expected_channels);
-        auto patches = convert_image_to_patches(normalized, img_width, img_height, expected_channels, patch);
-        std::vector<float> flattened(patches.size() * patch_dim);
-        for (size_t idx = 0; idx < patches.size(); ++idx) {
-            std::copy(patches[idx].begin(), patches[idx].end(), flattened.begin() + idx * patch_dim);
-        }
-        tile_patches.push_back(std::move(flattened));
+        tiles.push_back({pixels, raw, stride, img_width, img_height});
         spatial_shapes.emplace_back(img_height / patch, img_width / patch);
     };
 
     int grid_rows = 1;
     int grid_cols = 1;
     bool thumbnail_added = false;
+    std::vector<float> resized_grid;
+    std::vector<float> resized_image;
 
     if (should_split) {
         auto [grid_target_width, grid_target_height] = get_grid_layout(height, width);
         grid_cols = grid_target_width / config_.tile_size;
         grid_rows = grid_target_height / config_.tile_size;
 
-        std::vector<float> resized_grid = resize_image(
+        resized_grid = resize_image(
             source_data, width, height, grid_target_width, grid_target_height, expected_channels);
 
-        std::vector<float> tile_buffer(
-            static_cast<size_t>(config_.tile_size) * config_.tile_size * expected_channels);
-
         for (int row = 0; row < grid_rows; ++row) {
             for (int col = 0; col < grid_cols; ++col) {
-                for (int y = 0; y < config_.tile_size; ++y) {
-                    const float* src_row = resized_grid.data() +
-                        ((row * config_.tile_size + y) * grid_target_width + col * config_.tile_size) *
-                        expected_channels;
-                    float* dst_row = tile_buffer.data() + (y * config_.tile_size) * expected_channels;
-                    std::copy_n(src_row,
-                                static_cast<size_t>(config_.tile_size) * expected_channels,
-                                dst_row);
-                }
-                normalize_and_patchify(tile_buffer.data(), config_.tile_size, config_.tile_size);
-                
+                const float* tile_origin = resized_grid.data() +
+                    (static_cast<size_t>(row) * config_.tile_size * grid_target_width +
+                     static_cast<size_t>(col) * config_.tile_size) * expected_channels;
+                add_tile(tile_origin, nullptr, grid_target_width, config_.tile_size, config_.tile_size);
             }
         }
 
         if (config_.use_thumbnail && grid_rows * grid_cols != 1) {
-            std::vector<float> thumbnail_bytes = resize_image(
+            resized_image = resize_image(
                 source_data, width, height, resized_width, resized_height, expected_channels);
-            normalize_and_patchify(thumbnail_bytes.data(), resized_width, resized_height);
+            add_tile(resized_image.data(), nullptr, resized_width, resized_width, resized_height);
             thumbnail_added = true;
-            
         }
     } else {
-        int target_width = resized_width;
-        int target_height = resized_height;
-
-        const bool needs_resize = config_.do_resize && (width != target_width || height != target_height);
+        const bool needs_resize = config_.do_resize && (width != resized_width || height != resized_height);
 
-        std::vector<float> resized_image;
         if (needs_resize) {
-            resized_image = resize_image(source_data, width, height, target_width, target_height, expected_channels);
-            normalize_and_patchify(resized_image.data(), target_width, target_height);
-            
+            resized_image = resize_image(source_data, width, height, resized_width, resized_height, expected_channels);
+            add_tile(resized_image.data(), nullptr, resized_width, resized_width, resized_height);
         } else {
-            resized_image.resize(static_cast<size_t>(width) * height * expected_channels);
-            for (size_t idx = 0; idx < resized_image.size(); ++idx) {
-                resized_image[idx] = static_cast<float>(source_data[idx]);
-            }
-            normalize_and_patchify(resized_image.data(), width, height);
-            target_width = width;
-            target_height = height;
-            resized_width = target_width;
-            resized_height = target_height;
-            
+            add_tile(nullptr, source_data, width, width, height);
+            resized_width = width;
+            resized_height = height;
         }
-
-        grid_rows = 1;
-        grid_cols = 1;
     }
 
-    PreprocessedImage result = pad_patches(tile_patches, spatial_shapes, patch_dim, max_patches_per_tile);
-    
+    PreprocessedImage result = pad_patches(spatial_shapes, patch_dim, max_patches_per_tile);
+
+    const float scale = config_.do_rescale ? config_.rescale_factor : 1.0f;
+    const float identity_mean[3] = {0.0f, 0.0f, 0.0f};
+    const float identity_std[3] = {1.0f, 1.0f, 1.0f};
+    const float* mean = config_.do_normalize ? config_.image_mean : identity_mean;
+    const float* std_dev = config_.do_normalize ? config_.image_std : identity_std;
+    for (size_t tile_idx = 0; tile_idx < tiles.size(); ++tile_idx) {
+        const TileSource& tile = tiles[tile_idx];
+        float* destination = result.pixel_values.data() + tile_idx * max_patches_per_tile * patch_dim;
+        if (tile.pixels) {
+            normalize_rgb_into_patches(tile.pixels, tile.stride, tile.width, tile.height, patch,
+                                       destination, scale, mean, std_dev);
+        } else {
+            normalize_rgb_into_patches(tile.raw, tile.stride, tile.width, tile.height, patch,
+                                       destination, scale, mean, std_dev);
+        }
+    }
 
     result.image_rows = grid_rows;
     result.image_cols = grid_cols;
@@ -541,102 +696,29 @@ std::vector<float> Siglip2Preprocessor::resize_image(
     
     const size_t src_elements = static_cast<size_t>(src_width) * src_height * channels;
     std::vector<float> src_float(src_elements);
-    for (size_t idx = 0; idx < src_elements; ++idx) {
-        src_float[idx] = static_cast<float>(img_data[idx]);
-    }
-    
+    widen_u8_to_f32(img_data, src_float.data(), src_elements);
 
     std::vector<float> resized_data(static_cast<size_t>(dst_width) * dst_height * channels);
     
     stbir_pixel_layout layout = (channels == 1) ? STBIR_1CHANNEL : 
                                 (channels == 3) ? STBIR_RGB : STBIR_RGBA;
     
-    float* result = stbir_resize_float_linear(
-        src_float.data(), src_width, src_height, 0,
-        resized_data.data(), dst_width, dst_height, 0,
-        layout
-    );
-
-    if (!result) {
+    if (!resize_float_linear_parallel(src_float.data(), src_width, src_height,
+                                      resized_data.data(), dst_width, dst_height, layout)) {
         throw std::runtime_error("Failed to resize image");
     }
 
-    
     return resized_data;
 }
 
-std::vector<float> Siglip2Preprocessor::normalize_image(
-    const float* img_data, int width, int height, int channels) {
-    
-    size_t total_pixels = width * height * channels;
-    std::vector<float> normalized(total_pixels);
-
-    for (size_t i = 0; i < static_cast<size_t>(width * height); ++i) {
-        for (int c = 0; c < channels; ++c) {
-            size_t idx = i * channels + c;
-            float pixel = img_data[idx];
-            
-            if (config_.do_rescale) {
-                pixel *= config_.rescale_factor;
-            }
-            
-            if (config_.do_normalize) {
-                pixel = (pixel - config_.image_mean[c]) / config_.image_std[c];
-            }
-            
-            normalized[idx] = pixel;
-        }
-    }
-    
-
-    return normalized;
-}
-
-std::vector<std::vector<float>> Siglip2Preprocessor::convert_image_to_patches(
-    const std::vector<float>& image, int width, int height, int channels, int patch_size) {
-    
-    int num_patches_height = height / patch_size;
-    int num_patches_width = width / patch_size;
-    int num_patches = num_patches_height * num_patches_width;
-    int patch_elements = patch_size * patch_size * channels;
-
-    std::vector<std::vector<float>> patches(num_patches, std::vector<float>(patch_elements));
-
-    for (int ph = 0; ph < num_patches_height; ++ph) {
-        for (int pw = 0; pw < num_patches_width; ++pw) {
-            int patch_idx = ph * num_patches_width + pw;
-            
-            for (int y = 0; y < patch_size; ++y) {
-                for (int x = 0; x < patch_size; ++x) {
-                    int img_y = ph * patch_size + y;
-                    int img_x = pw * patch_size + x;
-                    int img_idx = (img_y * width + img_x) * channels;
-                    int patch_offset = (y * patch_size + x) * channels;
-                    
-                    for (int c = 0; c < channels; ++c) {
-                        patches[patch_idx][patch_offset + c] = image[img_idx + c];
-                    }
-                }
-            }
-        }
-    }
-
-    return patches;
-}
-
 Siglip2Preprocessor::PreprocessedImage Siglip2Preprocessor::pad_patches(
-    const std::vector<std::vector<float>>& tile_patches,
     const std::vector<std::pair<int,int>>& spatial_shapes,
     int patch_dim,
     int max_patches_per_tile) {
 
-    if (tile_patches.size() != spatial_shapes.size()) {
-        throw std::runtime_error("Mismatch between tile data and spatial shapes");
-    }
-
     PreprocessedImage result;
 
-    const int num_tiles = static_cast<int>(tile_patches.size());
+    const int num_tiles = static_cast<int>(spatial_shapes.size());
     result.num_tiles = num_tiles;
     result.patch_dim = patch_dim;
     result.max_patches_per_tile = max_patches_per_tile;
@@ -656,17 +738,6 @@ Siglip2Preprocessor::PreprocessedImage Siglip2Preprocessor::pad_patches(
             throw std::runtime_error("Actual patches exceed max_patches_per_tile");
         }
 
-        const auto& flattened = tile_patches[tile_idx];
-        const size_t expected_size = static_cast<size_t>(actual_patches) * patch_dim;
-        if (flattened.size() != expected_size) {
-            throw std::runtime_error("Tile patch data has unexpected size");
-        }
-
-        float* destination = result.pixel_values.data() +
-                             static_cast<size_t>(tile_idx) * max_patches_per_tile * patch_dim;
-        std::memcpy(destination, flattened.data(), expected_size * sizeof(float));
-    
-
         int mask_offset = tile_idx * max_patches_per_tile;
         for (int p = 0; p < actual_patches; ++p) {
             result.pixel_attention_mask[mask_offset + p] = 1;
@@ -738,64 +809,34 @@ Gemma4ImagePreprocessed preprocess_gemma4_image(const std::string& image_path, c
     if (target_h == 0) target_h = side_multiple;
     if (target_w == 0) target_w = side_multiple;
 
-    std::vector<float> resized(static_cast<size_t>(target_w) * target_h * 3);
-
-    if (target_w == width && target_h == height) {
-        for (size_t i = 0; i < resized.size(); ++i) {
-            resized[i] = static_cast<float>(raw[i]);
-        }
-    } else {
-        std::vector<unsigned char> resized_u8 = resize_rgb_uint8_pillow_bilinear(raw, width, height, target_w, target_h);
-        for (size_t i = 0; i < resized.size(); ++i) {
-            resized[i] = static_cast<float>(resized_u8[i]);
-        }
-    }
-    stbi_image_free(raw);
-
-    const bool do_rescale = true;
-    const float rescale_factor = config.rescale_factor > 0.0f ? config.rescale_factor : (1.0f / 255.0f);
-    const bool do_normalize = false;
-    const float mean_v = do_normalize ? config.image_mean : 0.0f;
-    const float std_v = (do_normalize && config.image_std != 0.0f) ? config.image_std : 1.0f;
-
-    if (do_rescale || do_normalize) {
-        const float inv_std = 1.0f / std_v;
-        for (size_t i = 0; i < resized.size(); ++i) {
-            float v = resized[i];
-            if (do_rescale) v *= rescale_factor;
-            if (do_normalize) v = (v - mean_v) * inv_std;
-            resized[i] = v;
-        }
-    }
-
     const int patch_h = target_h / patch_size;
     const int patch_w = target_w / patch_size;
     const size_t num_patches = static_cast<size_t>(patch_h) * static_cast<size_t>(patch_w);
     if (num_patches > max_patches) {
+        stbi_image_free(raw);
         throw std::runtime_error("Gemma4 native image preprocessing produced too many patches");
     }
 
+    const float rescale_factor = config.rescale_factor > 0.0f ? config.rescale_factor : (1.0f / 255.0f);
+    const float mean[3] = {0.0f, 0.0f, 0.0f};
+    const float std_dev[3] = {1.0f, 1.0f, 1.0f};
+
     result.pixel_values.assign(max_patches * patch_dim, 0.0f);
     result.pixel_position_ids.assign(max_patches * 2, -1);
 
-    for (int py = 0; py < patch_h; ++py) {
-        for (int px = 0; px < patch_w; ++px) {
-            const size_t patch_idx = static_cast<size_t>(py) * patch_w + px;
-            float* dst = result.pixel_values.data() + patch_idx * patch_dim;
-            for (int y = 0; y < patch_size; ++y) {
-                const int img_y = py * patch_size + y;
-                for (int x = 0; x < patch_size; ++x) {
-                    const int img_x = px * patch_size + x;
-                    const size_t src_off = (static_cast<size_t>(img_y) * target_w + img_x) * 3;
-                    const size_t dst_off = (static_cast<size_t>(y) * patch_size + x) * 3;
-                    dst[dst_off + 0] = resized[src_off + 0];
-                    dst[dst_off + 1] = resized[src_off + 1];
-                    dst[dst_off + 2] = resized[src_off + 2];
-                }
-            }
-            result.pixel_position_ids[patch_idx * 2 + 0] = static_cast<int64_t>(px);
-            result.pixel_position_ids[patch_idx * 2 + 1] = static_cast<int64_t>(py);
-        }
+    if (target_w == width && target_h == height) {
+        normalize_rgb_into_patches(raw, target_w, target_w, target_h, patch_size,
+                                   result.pixel_values.data(), rescale_factor, mean, std_dev);
+    } else {
+        std::vector<unsigned char> resized_u8 = resize_rgb_uint8_pillow_bilinear(raw, width, height, target_w, target_h);
+        normalize_rgb_into_patches(resized_u8.data(), target_w, target_w, target_h, patch_size,
+                                   result.pixel_values.data(), rescale_factor, mean, std_dev);
+    }
+    stbi_image_free(raw);
+
+    for (size_t patch_idx = 0; patch_idx < num_patches; ++patch_idx) {
+        result.pixel_position_ids[patch_idx * 2 + 0] = static_cast<int64_t>(patch_idx % patch_w);
+        result.pixel_position_ids[patch_idx * 2 + 1] = static_cast<int64_t>(patch_idx / patch_w);
     }
 
     result.num_patches = num_patches;
@@ -830,18 +871,12 @@ Qwen3VlImagePreprocessed preprocess_qwen3_vl_image(const std::string& image_path
     const int target_w = grid_side * patch_size;
     std::vector<float> resized(static_cast<size_t>(target_w) * target_h * 3);
     if (target_w == width && target_h == height) {
-        for (size_t i = 0; i < resized.size(); ++i) {
-            resized[i] = static_cast<float>(raw[i]);
-        }
+        widen_u8_to_f32(raw, resized.data(), resized.size());
     } else {
         std::vector<float> src_float(static_cast<size_t>(width) * height * 3);
-        for (size_t i = 0; i < src_float.size(); ++i) {
-            src_float[i] = static_cast<float>(raw[i]);
-        }
-        if (!stbir_resize_float_linear(
-                src_float.data(), width, height, 0,
-                resized.data(), target_w, target_h, 0,
-                STBIR_RGB)) {
+        widen_u8_to_f32(raw, src_float.data(), src_float.size());
+        if (!resize_float_linear_parallel(src_float.data(), width, height,
+                                          resized.data(), target_w, target_h, STBIR_RGB)) {
             stbi_image_free(raw);
             throw std::runtime_error("Failed to resize image: " + image_path);
         }
@@ -851,44 +886,39 @@ Qwen3VlImagePreprocessed preprocess_qwen3_vl_image(const std::string& image_path
     const float rescale_factor = config.rescale_factor > 0.0f ? config.rescale_factor : (1.0f / 255.0f);
     const float mean_v = config.image_mean;
     const float std_v = config.image_std != 0.0f ? config.image_std : 1.0f;
-    for (float& v : resized) {
-        v = (v * rescale_factor - mean_v) / std_v;
-    }
+    const float mean[3] = {mean_v, mean_v, mean_v};
+    const float std_dev[3] = {std_v, std_v, std_v};
 
     const size_t channel = 3;
     const size_t grid_t = 1;
     const size_t grid_h = static_cast<size_t>(grid_side);
     const size_t grid_w = static_cast<size_t>(grid_side);
     const size_t patch_dim = channel * static_cast<size_t>(temporal_patch_size) * patch_size * patch_size;
+    const size_t plane = static_cast<size_t>(patch_size) * patch_size;
     result.pixel_values.assign(grid_t * grid_h * grid_w * patch_dim, 0.0f);
 
-    for (size_t gh_major = 0; gh_major < grid_h / merge_size; ++gh_major) {
-        for (size_t gw_major = 0; gw_major < grid_w / merge_size; ++gw_major) {
-            for (size_t mh = 0; mh < static_cast<size_t>(merge_size); ++mh) {
-                for (size_t mw = 0; mw < static_cast<size_t>(merge_size); ++mw) {
-                    const size_t patch_y = gh_major * merge_size + mh;
-                    const size_t patch_x = gw_major * merge_size + mw;
-                    const size_t patch_index =
-                        (((gh_major * (grid_w / merge_size) + gw_major) * merge_size + mh) * merge_size + mw);
-                    float* dst = result.pixel_values.data() + patch_index * patch_dim;
-                    size_t dst_i = 0;
-                    for (size_t c = 0; c < channel; ++c) {
-                        for (size_t t = 0; t < static_cast<size_t>(temporal_patch_size); ++t) {
-                            (void)t;
-                            for (int y = 0; y < patch_size; ++y) {
-                                const size_t img_y = patch_y * patch_size + static_cast<size_t>(y);
-                                for (int x = 0; x < patch_size; ++x) {
-                                    const size_t img_x = patch_x * patch_size + static_cast<size_t>(x);
-                                    const size_t src_off = (img_y * static_cast<size_t>(target_w) + img_x) * channel + c;
-                                    dst[dst_i++] = resized[src_off];
-                                }
-                            }
-                        }
+    CactusThreading::parallel_for(grid_h * grid_w, CactusThreading::ParallelConfig{16, 8}, [&](size_t start, size_t end) {
+        std::vector<float> row(static_cast<size_t>(patch_size) * channel);
+        for (size_t patch_index = start; patch_index < end; ++patch_index) {
+            const size_t merged = patch_index / (merge_size * merge_size);
+            const size_t mh = (patch_index / merge_size) % merge_size;
+            const size_t mw = patch_index % merge_size;
+            const size_t patch_y = (merged / (grid_w / merge_size)) * merge_size + mh;
+            const size_t patch_x = (merged % (grid_w / merge_size)) * merge_size + mw;
+            float* dst = result.pixel_values.data() + patch_index * patch_dim;
+            for (int y = 0; y < patch_size; ++y) {
+                const size_t img_y = patch_y * patch_size + static_cast<size_t>(y);
+                const float* src = resized.data() + (img_y * static_cast<size_t>(target_w) + patch_x * patch_size) * channel;
+                normalize_rgb_run(src, row.data(), patch_size, rescale_factor, mean, std_dev);
+                for (size_t c = 0; c < channel; ++c) {
+                    for (size_t t = 0; t < static_cast<size_t>(temporal_patch_size); ++t) {
+                        float* out = dst + (c * temporal_patch_size + t) * plane + static_cast<size_t>(y) * patch_size;
+                        for (int x = 0; x < patch_size; ++x) out[x] = row[static_cast<size_t>(x) * channel + c];
                     }
                 }
             }
         }
-    }
+    });
 
     result.grid_t = grid_t;
     result.grid_h = grid_h;
@@ -0,0 +1,783 @@
+#include "engine.h"
+#include "picojson.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <stdexcept>
+
+namespace cactus {
+namespace engine {
+
+namespace {
+
+constexpr size_t kMaxCachedGrammarMasks = 128;
+constexpr size_t kMaxSchemaDepth = 64;
+
+struct ParsedElement {
+    enum class Kind { CHARSET, RULE };
+    Kind kind = Kind::CHARSET;
+    bool negated = false;
+    uint32_t rule = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+};
+using ParsedSequence = std::vector<ParsedElement>;
+using ParsedRule = std::vector<ParsedSequence>;
+
+bool is_name_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-';
+}
+
+class GrammarParser {
+public:
+    explicit GrammarParser(const std::string& src) : src_(src) {}
+
+    std::vector<ParsedRule> rules;
+    std::vector<std::string> names;
+    std::vector<bool> defined;
+
+    void parse() {
+        skip_space();
+        while (pos_ < src_.size()) {
+            const std::string name = parse_name();
+            skip_space();
+            if (src_.compare(pos_, 3, "::=") != 0) fail("expected '::=' after rule '" + name + "'");
+            pos_ += 3;
+            const uint32_t id = rule_id(name);
+            if (defined[id]) fail("rule '" + name + "' is defined twice");
+            rules[id] = parse_alternatives();
+            defined[id] = true;
+            skip_space();
+        }
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (!defined[i]) throw std::runtime_error("grammar: undefined rule '" + names[i] + "'");
+        }
+    }
+
+    uint32_t rule_id(const std::string& name) {
+        for (uint32_t i = 0; i < names.size(); ++i) {
+            if (names[i] == name) return i;
+        }
+        names.push_back(name);
+        rules.emplace_back();
+        defined.push_back(false);
+        return static_cast<uint32_t>(names.size() - 1);
+    }
+
+private:
+    const std::string& src_;
+    size_t pos_ = 0;
+    uint32_t generated_ = 0;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::runtime_error("grammar: " + message + " at offset " + std::to_string(pos_));
+    }
+
+    void skip_space() {
+        while (pos_ < src_.size()) {
+            const char c = src_[pos_];
+            if (c == '#') {
+                while (pos_ < src_.size() && src_[pos_] != '\n') ++pos_;
+            } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                ++pos_;
+            } else {
+                break;
+            }
+        }
+    }
+
+    std::string parse_name() {
+        const size_t start = pos_;
+        while (pos_ < src_.size() && is_name_char(src_[pos_])) ++pos_;
+        if (pos_ == start) fail("expected rule name");
+        return src_.substr(start, pos_ - start);
+    }
+
+    bool at_rule_start() {
+        const size_t saved = pos_;
+        bool result = false;
+        if (pos_ < src_.size() && is_name_char(src_[pos_])) {
+            while (pos_ < src_.size() && is_name_char(src_[pos_])) ++pos_;
+            skip_space();
+            result = src_.compare(pos_, 3, "::=") == 0;
+        }
+        pos_ = saved;
+        return result;
+    }
+
+    uint32_t new_rule(ParsedRule rule) {
+        const uint32_t id = rule_id("_gen" + std::to_string(generated_++));
+        rules[id] = std::move(rule);
+        defined[id] = true;
+        return id;
+    }
+
+    static ParsedElement rule_ref(uint32_t id) {
+        ParsedElement element;
+        element.kind = ParsedElement::Kind::RULE;
+        element.rule = id;
+        return element;
+    }
+
+    uint32_t parse_hex(size_t digits) {
+        if (pos_ + digits > src_.size()) fail("truncated escape");
+        uint32_t value = 0;
+        for (size_t i = 0; i < digits; ++i) {
+            const char c = src_[pos_++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else fail("invalid hex escape");
+        }
+        return value;
+    }
+
+    uint32_t parse_char() {
+        if (pos_ >= src_.size()) fail("unexpected end of grammar");
+        const unsigned char c = static_cast<unsigned char>(src_[pos_]);
+        if (c == '\\') {
+            if (++pos_ >= src_.size()) fail("unexpected end of grammar");
+            const char e = src_[pos_++];
+            switch (e) {
+                case 'n': return '\n';
+                case 'r': return '\r';
+                case 't': return '\t';
+                case 'x': return parse_hex(2);
+                case 'u': return parse_hex(4);
+                default: return static_cast<unsigned char>(e);
+            }
+        }
+        size_t len = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+        if (len == 0 || pos_ + len > src_.size()) fail("invalid UTF-8");
+        uint32_t cp = len == 1 ? c : c & (0x7F >> len);
+        for (size_t i = 1; i < len; ++i) cp = (cp << 6) | (static_cast<unsigned char>(src_[pos_ + i]) & 0x3F);
+        pos_ += len;
+        return cp;
+    }
+
+    ParsedRule parse_alternatives() {
+        ParsedRule alternatives;
+        alternatives.push_back(parse_sequence());
+        skip_space();
+        while (pos_ < src_.size() && src_[pos_] == '|') {
+            ++pos_;
+            alternatives.push_back(parse_sequence());
+            skip_space();
+        }
+        return alternatives;
+    }
+
+    ParsedSequence parse_sequence() {
+        ParsedSequence sequence;
+        while (true) {
+            skip_space();
+            if (pos_ >= src_.size() || src_[pos_] == '|' || src_[pos_] == ')' || at_rule_start()) break;
+            ParsedSequence item = parse_primary();
+            if (pos_ < src_.size() && (src_[pos_] == '*' || src_[pos_] == '+' || src_[pos_] == '?')) {
+                const char op = src_[pos_++];
+                if (item.size() != 1) item = {rule_ref(new_rule({item}))};
+                const ParsedElement element = item[0];
+                if (op == '?') {
+                    item = {rule_ref(new_rule({{element}, {}}))};
+                } else {
+                    const uint32_t id = rule_id("_gen" + std::to_string(generated_++));
+                    rules[id] = {{element, rule_ref(id)}, {}};
+                    defined[id] = true;
+                    if (op == '*') item = {rule_ref(id)};
+                    else item = {element, rule_ref(id)};
+                }
+            }
+            sequence.insert(sequence.end(), item.begin(), item.end());
+        }
+        return sequence;
+    }
+
+    ParsedSequence parse_primary() {
+        const char c = src_[pos_];
+        if (c == '"') {
+            ++pos_;
+            ParsedSequence literal;
+            while (pos_ < src_.size() && src_[pos_] != '"') {
+                const uint32_t cp = parse_char();
+                ParsedElement element;
+                element.ranges.emplace_back(cp, cp);
+                literal.push_back(std::move(element));
+            }
+            if (pos_ >= src_.size()) fail("unterminated string literal");
+            ++pos_;
+            return literal;
+        }
+        if (c == '[') {
+            ++pos_;
+            ParsedElement element;
+            if (pos_ < src_.size() && src_[pos_] == '^') {
+                element.negated = true;
+                ++pos_;
+            }
+            while (pos_ < src_.size() && src_[pos_] != ']') {
+                const uint32_t lo = parse_char();
+                uint32_t hi = lo;
+                if (pos_ + 1 < src_.size() && src_[pos_] == '-' && src_[pos_ + 1] != ']') {
+                    ++pos_;
+                    hi = parse_char();
+                }
+                element.ranges.emplace_back(lo, hi);
+            }
+            if (pos_ >= src_.size()) fail("unterminated character class");
+            ++pos_;
+            return {element};
+        }
+        if (c == '(') {
+            ++pos_;
+            ParsedRule group = parse_alternatives();
+            skip_space();
+            if (pos_ >= src_.size() || src_[pos_] != ')') fail("expected ')'");
+            ++pos_;
+            return {rule_ref(new_rule(std::move(group)))};
+        }
+        if (c == '.') {
+            ++pos_;
+            ParsedElement any;
+            any.negated = true;
+            return {any};
+        }
+        if (is_name_char(c)) return {rule_ref(rule_id(parse_name()))};
+        fail(std::string("unexpected character '") + c + "'");
+    }
+};
+
+using KeyOrder = std::map<const picojson::object*, std::vector<std::string>>;
+
+class KeyOrderParseContext {
+public:
+    KeyOrderParseContext(picojson::value* out, KeyOrder* order, size_t depth)
+        : out_(out), order_(order), depth_(depth) {}
+
+    bool set_null() { *out_ = picojson::value(); return true; }
+    bool set_bool(bool b) { *out_ = picojson::value(b); return true; }
+    bool set_number(double f) { *out_ = picojson::value(f); return true; }
+    template <typename Iter> bool parse_string(picojson::input<Iter>& in) {
+        *out_ = picojson::value(picojson::string_type, false);
+        return picojson::_parse_string(out_->get<std::string>(), in);
+    }
+    bool parse_array_start() {
+        if (depth_ == 0) return false;
+        *out_ = picojson::value(picojson::array_type, false);
+        return true;
+    }
+    template <typename Iter> bool parse_array_item(picojson::input<Iter>& in, size_t) {
+        auto& array = out_->get<picojson::array>();
+        array.push_back(picojson::value());
+        KeyOrderParseContext ctx(&array.back(), order_, depth_ - 1);
+        return picojson::_parse(ctx, in);
+    }
+    bool parse_array_stop(size_t) { return true; }
+    bool parse_object_start() {
+        if (depth_ == 0) return false;
+        *out_ = picojson::value(picojson::object_type, false);
+        return true;
+    }
+    template <typename Iter> bool parse_object_item(picojson::input<Iter>& in, const std::string& key) {
+        auto& object = out_->get<picojson::object>();
+        auto& keys = (*order_)[&object];
+        if (std::find(keys.begin(), keys.end(), key) == keys.end()) keys.push_back(key);
+        KeyOrderParseContext ctx(&object[key], order_, depth_ - 1);
+        return picojson::_parse(ctx, in);
+    }
+    bool parse_object_stop() { return true; }
+
+private:
+    picojson::value* out_;
+    KeyOrder* order_;
+    size_t depth_;
+};
+
+std::string gbnf_literal(const std::string& text) {
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\x%02X", c);
+            out += buf;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    return out + "\"";
+}
+
+const char* kJsonPrimitiveRules =
+    "ws ::= | \" \"\n"
+    "value ::= object | array | string | number | boolean | null\n"
+    "object ::= \"{\" ws ( string ws \":\" ws value ( ws \",\" ws string ws \":\" ws value )* )? ws \"}\"\n"
+    "array ::= \"[\" ws ( value ( ws \",\" ws value )* )? ws \"]\"\n"
+    "string ::= \"\\\"\" char* \"\\\"\"\n"
+    "char ::= [^\"\\\\\\x00-\\x1F] | \"\\\\\" ( [\"\\\\/bfnrt] | \"u\" hex hex hex hex )\n"
+    "hex ::= [0-9a-fA-F]\n"
+    "number ::= integer ( \".\" [0-9]+ )? ( [eE] [-+]? [0-9]+ )?\n"
+    "integer ::= \"-\"? ( \"0\" | [1-9] [0-9]* )\n"
+    "boolean ::= \"true\" | \"false\"\n"
+    "null ::= \"null\"\n";
+
+class SchemaConverter {
+public:
+    explicit SchemaConverter(const KeyOrder& order) : order_(order) {}
+
+    std::string convert(const picojson::value& schema) {
+        const std::string root = visit(schema, "root", 0);
+        std::string out = "root ::= " + root + "\n";
+        for (const auto& [name, body] : rules_) out += name + " ::= " + body + "\n";
+        return out + kJsonPrimitiveRules;
+    }
+
+private:
+    const KeyOrder& order_;
+    std::vector<std::pair<std::string, std::string>> rules_;
+
+    std::string add_rule(const std::string& hint, const std::string& body) {
+        std::string name = "s-";
+        for (char c : hint) name += is_name_char(c) ? c : '-';
+        const std::string base = name;
+        for (size_t suffix = 1;; ++suffix) {
+            bool taken = false;
+            for (const auto& rule : rules_) taken = taken || rule.first == name;
+            if (!taken) break;
+            name = base + "-" + std::to_string(suffix);
+        }
+        rules_.emplace_back(name, body);
+        return name;
+    }
+
+    std::vector<std::string> ordered_keys(const picojson::object& object) const {
+        auto it = order_.find(&object);
+        if (it != order_.end()) return it->second;
+        std::vector<std::string> keys;
+        for (const auto& [key, _] : object) keys.push_back(key);
+        return keys;
+    }
+
+    std::string visit_type(const std::string& type, const picojson::object& schema,
+                           const std::string& hint, size_t depth) {
+        if (type == "string" || type == "number" || type == "integer" || type == "boolean" || type == "null") {
+            return type;
+        }
+        if (type == "array") {
+            auto items = schema.find("items");
+            const std::string item = items != schema.end() ? visit(items->second, hint + "-item", depth + 1) : "value";
+            return add_rule(hint, "\"[\" ws ( " + item + " ( ws \",\" ws " + item + " )* )? ws \"]\"");
+        }
+        if (type == "object") {
+            auto props = schema.find("properties");
+            if (props == schema.end() || !props->second.is<picojson::object>() ||
+                props->second.get<picojson::object>().empty()) {
+                return "object";
+            }
+            const auto& properties = props->second.get<picojson::object>();
+            std::vector<std::string> required_names;
+            auto req = schema.find("required");
+            if (req != schema.end() && req->second.is<picojson::array>()) {
+                for (const auto& v : req->second.get<picojson::array>()) {
+                    if (v.is<std::string>()) required_names.push_back(v.get<std::string>());
+                }
+            }
+
+            std::vector<std::string> required;
+            std::vector<std::string> optional;
+            for (const auto& key : ordered_keys(properties)) {
+                const std::string value = visit(properties.at(key), hint + "-" + key, depth + 1);
+                const std::string kv = gbnf_literal(picojson::value(key).serialize()) + " ws \":\" ws " + value;
+                const bool is_required =
+                    std::find(required_names.begin(), required_names.end(), key) != required_names.end();
+                (is_required ? required : optional).push_back(kv);
+            }
+
+            std::string body = "\"{\" ws ";
+            for (size_t i = 0; i < required.size(); ++i) {
+                if (i > 0) body += "ws \",\" ws ";
+                body += required[i] + " ";
+            }
+            if (!required.empty()) {
+                for (const auto& kv : optional) body += "( ws \",\" ws " + kv + " )? ";
+            } else {
+                body += "( ";
+                for (size_t i = 0; i < optional.size(); ++i) {
+                    if (i > 0) body += "| ";
+                    body += optional[i] + " ";
+                    for (size_t j = i + 1; j < optional.size(); ++j) body += "( ws \",\" ws " + optional[j] + " )? ";
+                }
+                body += ")? ";
+            }
+            return add_rule(hint, body + "ws \"}\"");
+        }
+        throw std::runtime_error("json schema: unsupported type '" + type + "'");
+    }
+
+    std::string visit(const picojson::value& value, const std::string& hint, size_t depth) {
+        if (depth > kMaxSchemaDepth) throw std::runtime_error("json schema: nesting too deep");
+        if (!value.is<picojson::object>()) return "value";
+        const auto& schema = value.get<picojson::object>();
+
+        if (schema.count("$ref")) throw std::runtime_error("json schema: $ref is not supported");
+        if (auto it = schema.find("const"); it != schema.end()) return gbnf_literal(it->second.serialize());
+        if (auto it = schema.find("enum"); it != schema.end() && it->second.is<picojson::array>()) {
+            std::string body;
+            for (const auto& v : it->second.get<picojson::array>()) {
+                body += (body.empty() ? "" : " | ") + gbnf_literal(v.serialize());
+            }
+            if (body.empty()) throw std::runtime_error("json schema: empty enum");
+            return add_rule(hint, body);
+        }
+        for (const char* key : {"anyOf", "oneOf"}) {
+            auto it = schema.find(key);
+            if (it == schema.end() || !it->second.is<picojson::array>()) continue;
+            std::string body;
+            size_t index = 0;
+            for (const auto& v : it->second.get<picojson::array>()) {
+                body += (body.empty() ? "" : " | ") + visit(v, hint + "-" + std::to_string(index++), depth + 1);
+            }
+            if (body.empty()) throw std::runtime_error(std::string("json schema: empty ") + key);
+            return add_rule(hint, body);
+        }
+
+        auto type = schema.find("type");
+        if (type == schema.end()) return schema.count("properties") ? visit_type("object", schema, hint, depth) : "value";
+        if (type->second.is<std::string>()) return visit_type(type->second.get<std::string>(), schema, hint, depth);
+        if (type->second.is<picojson::array>()) {
+            std::string body;
+            for (const auto& t : type->second.get<picojson::array>()) {
+                if (!t.is<std::string>()) throw std::runtime_error("json schema: invalid type list");
+                body += (body.empty() ? "" : " | ") + visit_type(t.get<std::string>(), schema, hint, depth);
+            }
+            if (body.empty()) throw std::runtime_error("json schema: empty type list");
+            return add_rule(hint, body);
+        }
+        throw std::runtime_error("json schema: invalid type");
+    }
+};
+
+}  // namespace
+
+std::string TokenGrammar::json_schema_to_grammar(const std::string& schema_json) {
+    picojson::value schema;
+    KeyOrder order;
+    KeyOrderParseContext ctx(&schema, &order, kMaxSchemaDepth * 4);
+    std::string err;
+    picojson::_parse(ctx, schema_json.begin(), schema_json.end(), &err);
+    if (!err.empty()) throw std::runtime_error("json schema: " + err);
+    return SchemaConverter(order).convert(schema);
+}
+
+void TokenGrammar::parse(const std::string& grammar) {
+    GrammarParser parser(grammar);
+    const uint32_t root = parser.rule_id("root");
+    parser.parse();
+
+    elements_.clear();
+    ranges_.clear();
+    rule_alternatives_.assign(parser.rules.size(), {});
+    for (size_t r = 0; r < parser.rules.size(); ++r) {
+        for (const auto& sequence : parser.rules[r]) {
+            rule_alternatives_[r].push_back(static_cast<uint32_t>(elements_.size()));
+            for (const auto& parsed : sequence) {
+                Element element;
+                if (parsed.kind == ParsedElement::Kind::RULE) {
+                    element.kind = Element::Kind::RULE;
+                    element.rule = parsed.rule;
+                } else {
+                    element.kind = Element::Kind::CHARSET;
+                    element.negated = parsed.negated;
+                    element.range_begin = static_cast<uint32_t>(ranges_.size());
+                    element.range_count = static_cast<uint32_t>(parsed.ranges.size());
+                    ranges_.insert(ranges_.end(), parsed.ranges.begin(), parsed.ranges.end());
+                }
+                elements_.push_back(element);
+            }
+            elements_.push_back(Element{});
+        }
+    }
+    root_rule_ = root;
+}
+
+void TokenGrammar::check_left_recursion() const {
+    const size_t num_rules = rule_alternatives_.size();
+    std::vector<bool> nullable(num_rules, false);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t r = 0; r < num_rules; ++r) {
+            if (nullable[r]) continue;
+            for (uint32_t pos : rule_alternatives_[r]) {
+                while (elements_[pos].kind == Element::Kind::RULE && nullable[elements_[pos].rule]) ++pos;
+                if (elements_[pos].kind == Element::Kind::END) {
+                    nullable[r] = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<uint8_t> color(num_rules, 0);
+    std::function<void(uint32_t)> visit = [&](uint32_t r) {
+        color[r] = 1;
+        for (uint32_t pos : rule_alternatives_[r]) {
+            for (; elements_[pos].kind == Element::Kind::RULE; ++pos) {
+                const uint32_t next = elements_[pos].rule;
+                if (color[next] == 1) throw std::runtime_error("grammar: left recursion is not supported");
+                if (color[next] == 0) visit(next);
+                if (!nullable[next]) break;
+            }
+        }
+        color[r] = 2;
+    };
+    for (uint32_t r = 0; r < num_rules; ++r) {
+        if (color[r] == 0) visit(r);
+    }
+}
+
+void TokenGrammar::build_vocab_trie() {
+    const uint32_t vocab_size = tokenizer_->get_vocab_size();
+    if (vocab_size == vocab_size_ && !vocab_trie_.empty()) return;
+    vocab_size_ = vocab_size;
+    mask_cache_.clear();
+
+    auto specials = tokenizer_->special_token_ids();
+    specials.insert(tokenizer_->get_bos_token());
+    specials.insert(tokenizer_->get_eos_token());
+    specials.insert(tokenizer_->get_unk_token());
+
+    token_strings_.assign(vocab_size, "");
+    vocab_trie_.assign(1, VocabNode{});
+    for (uint32_t token_id = 0; token_id < vocab_size; ++token_id) {
+        if (specials.count(token_id)) continue;
+        token_strings_[token_id] = tokenizer_->decode({token_id});
+        const std::string& text = token_strings_[token_id];
+        if (text.empty()) continue;
+
+        uint32_t node = 0;
+        for (unsigned char byte : text) {
+            uint32_t child = 0;
+            for (const auto& [b, index] : vocab_trie_[node].children) {
+                if (b == byte) {
+                    child = index;
+                    break;
+                }
+            }
+            if (child == 0) {
+                child = static_cast<uint32_t>(vocab_trie_.size());
+                vocab_trie_[node].children.emplace_back(byte, child);
+                vocab_trie_.emplace_back();
+            }
+            node = child;
+        }
+        vocab_trie_[node].tokens.push_back(token_id);
+    }
+}
+
+void TokenGrammar::init(const std::string& grammar, const Tokenizer* tokenizer) {
+    clear();
+    if (!tokenizer) throw std::runtime_error("grammar: tokenizer is required");
+    if (tokenizer_ != tokenizer) {
+        vocab_trie_.clear();
+        source_.clear();
+    }
+    if (grammar != source_ || rule_alternatives_.empty()) {
+        source_.clear();
+        mask_cache_.clear();
+        parse(grammar);
+        check_left_recursion();
+        source_ = grammar;
+    }
+
+    tokenizer_ = tokenizer;
+    build_vocab_trie();
+    eos_token_ = tokenizer_->get_eos_token();
+    active_ = true;
+    reset();
+}
+
+void TokenGrammar::clear() {
+    active_ = false;
+    finished_ = false;
+    state_ = MatchState{};
+}
+
+void TokenGrammar::reset() {
+    state_ = MatchState{};
+    finished_ = false;
+    if (!active_) return;
+    for (uint32_t alt : rule_alternatives_[root_rule_]) {
+        Stack stack;
+        if (elements_[alt].kind != Element::Kind::END) stack.push_back(alt);
+        expand_stack(stack, state_.stacks);
+    }
+    std::sort(state_.stacks.begin(), state_.stacks.end());
+    state_.stacks.erase(std::unique(state_.stacks.begin(), state_.stacks.end()), state_.stacks.end());
+}
+
+bool TokenGrammar::is_complete() const {
+    if (!active_ || state_.partial_remaining != 0) return false;
+    for (const auto& stack : state_.stacks) {
+        if (stack.empty()) return true;
+    }
+    return false;
+}
+
+bool TokenGrammar::charset_matches(const Element& element, uint32_t codepoint) const {
+    bool found = false;
+    for (uint32_t i = 0; i < element.range_count && !found; ++i) {
+        const auto& [lo, hi] = ranges_[element.range_begin + i];
+        found = codepoint >= lo && codepoint <= hi;
+    }
+    return found != element.negated;
+}
+
+bool TokenGrammar::charset_accepts_multibyte(const Element& element) const {
+    if (element.negated) return true;
+    for (uint32_t i = 0; i < element.range_count; ++i) {
+        if (ranges_[element.range_begin + i].second >= 0x80) return true;
+    }
+    return false;
+}
+
+void TokenGrammar::expand_stack(Stack& stack, std::vector<Stack>& out) const {
+    if (stack.empty()) {
+        out.push_back(stack);
+        return;
+    }
+    const uint32_t pos = stack.back();
+    const Element& element = elements_[pos];
+    if (element.kind == Element::Kind::CHARSET) {
+        out.push_back(stack);
+        return;
+    }
+    stack.pop_back();
+    if (elements_[pos + 1].kind != Element::Kind::END) stack.push_back(pos + 1);
+    for (uint32_t alt : rule_alternatives_[element.rule]) {
+        Stack next = stack;
+        if (elements_[alt].kind != Element::Kind::END) next.push_back(alt);
+        expand_stack(next, out);
+    }
+}
+
+std::vector<TokenGrammar::Stack> TokenGrammar::advance_codepoint(const std::vector<Stack>& stacks,
+                                                                 uint32_t codepoint) const {
+    std::vector<Stack> out;
+    for (const auto& stack : stacks) {
+        if (stack.empty()) continue;
+        const uint32_t pos = stack.back();
+        if (!charset_matches(elements_[pos], codepoint)) continue;
+        Stack next(stack.begin(), stack.end() - 1);
+        if (elements_[pos + 1].kind != Element::Kind::END) next.push_back(pos + 1);
+        expand_stack(next, out);
+    }
+    if (out.size() > 1) {
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+    return out;
+}
+
+bool TokenGrammar::advance_byte(const MatchState& state, uint8_t byte, MatchState& out) const {
+    out.partial_codepoint = 0;
+    out.partial_remaining = 0;
+    if (state.partial_remaining == 0) {
+        if (byte < 0x80) {
+            out.stacks = advance_codepoint(state.stacks, byte);
+            return !out.stacks.empty();
+        }
+        const uint8_t len = (byte & 0xE0) == 0xC0 ? 2 : (byte & 0xF0) == 0xE0 ? 3 : (byte & 0xF8) == 0xF0 ? 4 : 0;
+        if (len == 0) return false;
+        out.partial_codepoint = byte & (0x7F >> len);
+        out.partial_remaining = len - 1;
+    } else {
+        if ((byte & 0xC0) != 0x80) return false;
+        const uint32_t codepoint = (state.partial_codepoint << 6) | (byte & 0x3F);
+        if (state.partial_remaining == 1) {
+            out.stacks = advance_codepoint(state.stacks, codepoint);
+            return !out.stacks.empty();
+        }
+        out.partial_codepoint = codepoint;
+        out.partial_remaining = state.partial_remaining - 1;
+    }
+    out.stacks = state.stacks;
+    for (const auto& stack : out.stacks) {
+        if (!stack.empty() && charset_accepts_multibyte(elements_[stack.back()])) return true;
+    }
+    return false;
+}
+
+void TokenGrammar::fill_mask(uint32_t node, const MatchState& state, std::vector<uint64_t>& mask) const {
+    MatchState next;
+    for (const auto& [byte, child] : vocab_trie_[node].children) {
+        if (!advance_byte(state, byte, next)) continue;
+        for (uint32_t token_id : vocab_trie_[child].tokens) mask[token_id >> 6] |= 1ULL << (token_id & 63);
+        fill_mask(child, next, mask);
+    }
+}
+
+std::string TokenGrammar::state_key() const {
+    std::string key;
+    auto append = [&](uint32_t v) { key.append(reinterpret_cast<const char*>(&v), sizeof(v)); };
+    append(finished_ ? 1 : 0);
+    append(state_.partial_codepoint);
+    append(state_.partial_remaining);
+    for (const auto& stack : state_.stacks) {
+        for (uint32_t pos : stack) append(pos);
+        append(UINT32_MAX);
+    }
+    return key;
+}
+
+const uint64_t* TokenGrammar::get_token_mask() {
+    if (!active_) return nullptr;
+    std::string key = state_key();
+    auto it = mask_cache_.find(key);
+    if (it == mask_cache_.end()) {
+        if (mask_cache_.size() >= kMaxCachedGrammarMasks) mask_cache_.clear();
+        std::vector<uint64_t> mask((vocab_size_ + 63) / 64, 0);
+        if (!finished_) fill_mask(0, state_, mask);
+        bool any = false;
+        for (uint64_t word : mask) any = any || word != 0;
+        if ((is_complete() || finished_ || !any) && eos_token_ < vocab_size_) {
+            mask[eos_token_ >> 6] |= 1ULL << (eos_token_ & 63);
+        }
+        it = mask_cache_.emplace(std::move(key), std::move(mask)).first;
+    }
+    return it->second.data();
+}
+
+void TokenGrammar::accept(uint32_t token_id) {
+    if (!active_ || finished_) return;
+    if (token_id == eos_token_) {
+        finished_ = true;
+        return;
+    }
+    if (token_id >= token_strings_.size()) return;
+    MatchState next;
+    for (unsigned char byte : token_strings_[token_id]) {
+        if (!advance_byte(state_, byte, next)) {
+            state_ = MatchState{};
+            return;
+        }
+        std::swap(state_, next);
+    }
+}
+
+void Model::set_grammar(const std::string& grammar) {
+    grammar_.init(grammar, tokenizer_.get());
+}
+
+void Model::clear_grammar() {
+    grammar_.clear();
+}
+
+void Model::update_grammar(uint32_t token_id) {
+    if (grammar_.is_active()) grammar_.accept(token_id);
+}
+
+} // namespace engine
+} // namespace cactus
@@ -24,7 +24,12 @@ struct CacheHeader {
     uint64_t num_kv_heads;
     uint64_t head_dim;
     uint64_t sink_size;
-    uint64_t reserved[3];
+    uint64_t num_slots;
+    uint64_t ring_head;
+    uint16_t kv_bits;       // 4 or 2: packed low-bit rows, which compaction leaves alone
+    uint8_t kv_role;
+    uint8_t kv_flags;       // non-zero: rows spilled to a file, also left alone
+    uint32_t packed_rows;
 };
 static_assert(sizeof(CacheHeader) == 64, "CacheHeader must be 64 bytes");
 
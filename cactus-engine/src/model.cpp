@@ -17,6 +17,8 @@
 #include <array>
 #include <cctype>
 #include <limits>
+#include <numeric>
+#include <random>
 #include <set>
 #include <sstream>
 #include <stdexcept>
@@ -578,6 +580,7 @@ bool Model::init(const std::string& bundle_dir, size_t context_size,
     lm_encoder_ = components_.count("lm_encoder") ? &components_.at("lm_encoder") : nullptr;
     lm_encoder_text_chunk_ = components_.count("lm_encoder_text_chunk") ? &components_.at("lm_encoder_text_chunk") : nullptr;
     lm_encoder_media_chunk_ = components_.count("lm_encoder_media_chunk") ? &components_.at("lm_encoder_media_chunk") : nullptr;
+    if (vision_encoder_) configure_vision_cache();
     std::vector<Component*> to_bind = {
         encoder_,
         source_encoder_,
@@ -786,11 +789,24 @@ bool Model::load_component_graph(Component& comp) {
             return false;
         }
     }
+    if (const char* env = std::getenv("CACTUS_MOE_RESIDENT_MB")) {
+        ExpertResidencyConfig residency;
+        residency.budget_bytes = static_cast<size_t>(std::max(0L, std::atol(env))) << 20;
+        if (const char* lock = std::getenv("CACTUS_MOE_LOCK_EXPERTS")) residency.lock_hot = std::atoi(lock) != 0;
+        comp.graph->configure_expert_residency(residency);
+    }
     return bind_runtime_buffers(comp);
 }
 
 void Model::unload_component_graph(Component& comp) {
     if (comp.graph) {
+        for (const auto& s : comp.graph->expert_residency_stats()) {
+            CACTUS_LOG_INFO("model", comp.graph_path << " moe node " << s.node_id
+                << ": hit_rate=" << s.hit_rate() << " lookups=" << s.lookups
+                << " prefetch_hits=" << s.prefetch_hits << "/" << s.prefetches
+                << " major_faults=" << s.major_faults << " resident=" << s.resident << "/" << s.num_experts
+                << " pinned=" << s.pinned);
+        }
         comp.graph->release_runtime_buffers();
         comp.graph->release_all_weight_pages();
     }
@@ -897,16 +913,29 @@ void Model::run_encoder_step(uint32_t token_id, size_t position) {
     encoder_->graph->execute();
 }
 
-void Model::set_component_batch(Component& comp, size_t batch) {
+// Resized inputs start zeroed, or with row 0 repeated in every row when `tile_first_row` is set
+// (inputs written once before the resize, such as the cross-KV every beam attends to).
+void Model::set_component_batch(Component& comp, size_t batch, bool tile_first_row) {
     for (size_t i = 0; i < comp.runtime_input_node_ids.size(); ++i) {
         size_t node_id = static_cast<size_t>(comp.runtime_input_node_ids[i]);
         const auto& desc = comp.graph->get_output_buffer(node_id);
         if (!desc.has_dynamic_dims() || desc.shape.empty() || desc.shape[0] == batch) continue;
+        std::vector<uint8_t> first_row;
+        if (tile_first_row && desc.shape[0] > 0) {
+            const size_t row_bytes = desc.byte_size / desc.shape[0];
+            first_row.assign(comp.input_buffers[i].begin(),
+                             comp.input_buffers[i].begin() + std::min(row_bytes, comp.input_buffers[i].size()));
+        }
         std::vector<size_t> shape = desc.shape;
         shape[0] = batch;
         comp.graph->set_runtime_input_shape(node_id, shape);
         const auto& resized = comp.graph->get_output_buffer(node_id);
         comp.input_buffers[i].assign(resized.byte_size, 0);
+        if (!first_row.empty() && first_row.size() * batch <= resized.byte_size) {
+            for (size_t b = 0; b < batch; ++b) {
+                std::memcpy(comp.input_buffers[i].data() + b * first_row.size(), first_row.data(), first_row.size());
+            }
+        }
         comp.graph->set_external_input(node_id, comp.input_buffers[i].data(), resized.precision);
     }
 }
@@ -943,6 +972,14 @@ void Model::run_step_batch(const std::vector<uint32_t>& token_ids, const std::ve
     maybe_capture_handoff_probe_hidden(*decoder_);
 }
 
+bool Model::has_dynamic_batch_input(const Component& comp) {
+    for (int node_id : comp.runtime_input_node_ids) {
+        if (node_id < 0) continue;
+        if (comp.graph->get_output_buffer(static_cast<size_t>(node_id)).has_dynamic_dims()) return true;
+    }
+    return false;
+}
+
 std::vector<uint32_t> Model::batch_stop_token_ids() const {
     std::vector<uint32_t> stops;
     stops.push_back(config_.eos_token_id);
@@ -959,6 +996,7 @@ std::vector<uint32_t> Model::batch_stop_token_ids() const {
 
 std::vector<std::vector<uint32_t>> Model::generate_batch(const std::vector<std::vector<uint32_t>>& prompts,
                                                          size_t max_new_tokens, bool stop_on_eos) {
+    settle_kv_compaction();
     size_t batch = prompts.size();
     const bool cached = decode_route_ == DecodeRoute::CACHED_STEP;
     const bool direct = decode_route_ == DecodeRoute::DIRECT_DECODER_STEP;
@@ -968,16 +1006,9 @@ std::vector<std::vector<uint32_t>> Model::generate_batch(const std::vector<std::
     if (cached && !load_component_graph(*encoder_)) return {};
     if (!load_component_graph(*decoder_)) return {};
     if (batch > decoder_cache_num_slots()) return {};
-    auto has_dynamic_input = [](Component& c) {
-        for (int node_id : c.runtime_input_node_ids) {
-            if (node_id < 0) continue;
-            if (c.graph->get_output_buffer(static_cast<size_t>(node_id)).has_dynamic_dims()) return true;
-        }
-        return false;
-    };
     if (batch > 1) {
-        if (!has_dynamic_input(*decoder_)) return {};
-        if (cached && !has_dynamic_input(*encoder_)) return {};
+        if (!has_dynamic_batch_input(*decoder_)) return {};
+        if (cached && !has_dynamic_batch_input(*encoder_)) return {};
         for (const auto& np : decoder_->graph->nodes_) {
             if (np->op_type == OpType::CONV_CACHE_STATE || np->op_type == OpType::RECURRENT_CACHE_STATE) return {};
         }
@@ -1046,6 +1077,7 @@ bool Model::supports_dynamic_batch() {
 void Model::set_decode_slots(size_t num_slots) {
     if (num_slots == 0) num_slots = 1;
     if (!decoder_) return;
+    settle_kv_compaction();
     if (!decoder_->graph && !load_component_graph(*decoder_)) return;
     for (const auto& state : decoder_->cache_states) {
         for (int node_id : {state.key_node_id, state.value_node_id}) {
@@ -1056,6 +1088,302 @@ void Model::set_decode_slots(size_t num_slots) {
     }
 }
 
+bool Model::decoder_supports_cache_slots() {
+    if (!decoder_ || !decoder_->graph) return false;
+    bool has_kv_cache = false;
+    for (const auto& np : decoder_->graph->nodes_) {
+        if (np->op_type == OpType::CONV_CACHE_STATE || np->op_type == OpType::RECURRENT_CACHE_STATE) return false;
+        if (np->op_type == OpType::KV_CACHE_STATE) has_kv_cache = true;
+    }
+    return has_kv_cache;
+}
+
+void Model::fork_decoder_cache_slot(size_t src_slot, size_t dst_slot) {
+    for (const auto& state : decoder_->cache_states) {
+        for (int node_id : {state.key_node_id, state.value_node_id}) {
+            if (node_id < 0) continue;
+            if (decoder_->graph->get_node_op_type(static_cast<size_t>(node_id)) != OpType::KV_CACHE_STATE) continue;
+            decoder_->graph->copy_cache_slot(static_cast<size_t>(node_id), src_slot, dst_slot);
+        }
+    }
+}
+
+void Model::share_decoder_cache_prefix(size_t num_slots, size_t tail_rows) {
+    for (const auto& state : decoder_->cache_states) {
+        for (int node_id : {state.key_node_id, state.value_node_id}) {
+            if (node_id < 0) continue;
+            if (decoder_->graph->get_node_op_type(static_cast<size_t>(node_id)) != OpType::KV_CACHE_STATE) continue;
+            decoder_->graph->share_cache_prefix(static_cast<size_t>(node_id), num_slots, 0, tail_rows);
+        }
+    }
+}
+
+void Model::reslot_decoder_cache(size_t num_slots, size_t src_slot, size_t dst_slot) {
+    for (const auto& state : decoder_->cache_states) {
+        for (int node_id : {state.key_node_id, state.value_node_id}) {
+            if (node_id < 0) continue;
+            if (decoder_->graph->get_node_op_type(static_cast<size_t>(node_id)) != OpType::KV_CACHE_STATE) continue;
+            decoder_->graph->reslot_cache(static_cast<size_t>(node_id), num_slots, src_slot, dst_slot);
+        }
+    }
+}
+
+// Log-softmax of the last logits of batch row `row` out of `rows`, after the vocab bias and the
+// suppressed token that greedy argmax also applies.
+void Model::beam_row_logprobs(size_t row, size_t rows, std::vector<float>& out) {
+    size_t out_node = static_cast<size_t>(decoder_->output_node_ids.empty() ? 0 : decoder_->output_node_ids[0]);
+    const auto& desc = decoder_->graph->get_output_buffer(out_node);
+    const void* ptr = decoder_->graph->get_output(out_node);
+    const size_t vocab = desc.shape.empty() ? 0 : desc.shape.back();
+    out.assign(vocab, -std::numeric_limits<float>::infinity());
+    if (!ptr || vocab == 0 || rows == 0) return;
+    const size_t seq = desc.total_size / vocab / rows;
+    const size_t row_off = (row * seq + (seq > 0 ? seq - 1 : 0)) * vocab;
+    auto load = [&](const auto* p) {
+        for (size_t i = 0; i < vocab; ++i) out[i] = static_cast<float>(p[row_off + i]);
+    };
+    if (desc.precision == Precision::FP32) load(static_cast<const float*>(ptr));
+    else if (desc.precision == Precision::FP16) load(static_cast<const __fp16*>(ptr));
+    else load(static_cast<const int8_t*>(ptr));
+    for (const auto& [token_id, bias] : vocab_bias_) {
+        if (token_id < vocab) out[token_id] += bias;
+    }
+    if (suppressed_token_id_ >= 0 && static_cast<size_t>(suppressed_token_id_) < vocab) {
+        out[static_cast<size_t>(suppressed_token_id_)] = -std::numeric_limits<float>::infinity();
+    }
+    const float max_v = *std::max_element(out.begin(), out.end());
+    double sum = 0.0;
+    for (size_t i = 0; i < vocab; ++i) sum += std::exp(static_cast<double>(out[i] - max_v));
+    const float log_z = max_v + static_cast<float>(std::log(sum));
+    for (size_t i = 0; i < vocab; ++i) out[i] -= log_z;
+}
+
+// Live beam b always decodes in cache slot b, so a batched step maps row b to slot b without a
+// gather. After each expansion the first child of a parent inherits the parent's slot and every
+// other child forks it into a slot whose beam died. The prompt is stored once in `prompt_slot`
+// (see share_decoder_cache_prefix) and beam slots hold only the rows generated after it, so a
+// fork copies those rows alone and each fallback attempt restarts without copying anything.
+std::vector<Model::BeamHypothesis> Model::run_beam_search(
+    size_t start_position, const std::vector<float>& prompt_logprobs, size_t prompt_slot,
+    const BeamSearchOptions& options, const std::vector<std::vector<uint32_t>>& stop_token_sequences,
+    const std::atomic<bool>* should_stop, const BeamStepFn& step) {
+    const size_t beam = std::max<size_t>(options.beam_size, 1);
+    const size_t vocab = prompt_logprobs.size();
+    if (vocab == 0 || options.max_tokens == 0) return {};
+
+    auto score_of = [&](float logprob, size_t len) {
+        if (options.length_penalty == 0.0f || len == 0) return logprob;
+        return logprob / std::pow((5.0f + static_cast<float>(len)) / 6.0f, options.length_penalty);
+    };
+    auto stopped = [&](const std::vector<uint32_t>& tokens) {
+        for (const auto& stop_seq : stop_token_sequences) {
+            if (stop_seq.empty() || tokens.size() < stop_seq.size()) continue;
+            if (std::equal(stop_seq.rbegin(), stop_seq.rend(), tokens.rbegin())) return true;
+        }
+        return false;
+    };
+
+    struct Beam {
+        std::vector<uint32_t> tokens;
+        float logprob = 0.0f;
+    };
+    struct Candidate {
+        size_t parent;
+        uint32_t token;
+        float logprob;
+    };
+    const std::vector<float> temperatures = options.temperatures.empty() ? std::vector<float>{0.0f}
+                                                                         : options.temperatures;
+    std::mt19937 rng(std::random_device{}());
+    std::vector<uint32_t> order(vocab);
+    std::vector<double> weights(vocab);
+    std::vector<BeamHypothesis> result;
+
+    for (size_t attempt = 0; attempt < temperatures.size(); ++attempt) {
+        const float temperature = std::max(0.0f, temperatures[attempt]);
+        fork_decoder_cache_slot(prompt_slot, 0);
+        std::vector<Beam> live(1);
+        std::vector<std::vector<float>> logprobs = {prompt_logprobs};
+        std::vector<BeamHypothesis> finished;
+
+        for (size_t t = 0; t < options.max_tokens && !live.empty(); ++t) {
+            if (should_stop && should_stop->load()) break;
+            std::vector<Candidate> candidates;
+            if (temperature > 0.0f) {
+                const size_t draws = t == 0 ? beam : 1;
+                for (size_t b = 0; b < live.size(); ++b) {
+                    const auto& lp = logprobs[b];
+                    const float max_lp = *std::max_element(lp.begin(), lp.end());
+                    for (size_t i = 0; i < vocab; ++i) weights[i] = std::exp((lp[i] - max_lp) / temperature);
+                    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+                    for (size_t d = 0; d < draws; ++d) {
+                        const size_t token = pick(rng);
+                        candidates.push_back({b, static_cast<uint32_t>(token), live[b].logprob + lp[token]});
+                    }
+                }
+            } else {
+                const size_t k = std::min(beam, vocab);
+                for (size_t b = 0; b < live.size(); ++b) {
+                    const auto& lp = logprobs[b];
+                    std::iota(order.begin(), order.end(), 0u);
+                    std::nth_element(order.begin(), order.begin() + (k - 1), order.end(),
+                                     [&](uint32_t x, uint32_t y) { return lp[x] > lp[y]; });
+                    for (size_t i = 0; i < k; ++i) {
+                        if (!std::isfinite(lp[order[i]])) continue;
+                        candidates.push_back({b, order[i], live[b].logprob + lp[order[i]]});
+                    }
+                }
+                std::stable_sort(candidates.begin(), candidates.end(),
+                                 [](const Candidate& x, const Candidate& y) { return x.logprob > y.logprob; });
+            }
+
+            const size_t width = temperature > 0.0f ? candidates.size() : beam;
+            std::vector<Beam> next;
+            std::vector<size_t> parents;
+            for (const auto& c : candidates) {
+                if (next.size() >= width) break;
+                Beam child{live[c.parent].tokens, c.logprob};
+                child.tokens.push_back(c.token);
+                if (stopped(child.tokens)) {
+                    finished.push_back({child.tokens, child.logprob, score_of(child.logprob, child.tokens.size()),
+                                        temperature, true});
+                    continue;
+                }
+                next.push_back(std::move(child));
+                parents.push_back(c.parent);
+            }
+            if ((temperature <= 0.0f && finished.size() >= beam) || next.empty()) {
+                live.clear();
+                break;
+            }
+
+            const size_t n = next.size();
+            std::vector<size_t> slot_of(n, n);
+            std::vector<bool> taken(n, false);
+            for (size_t j = 0; j < n; ++j) {
+                if (parents[j] < n && !taken[parents[j]]) {
+                    slot_of[j] = parents[j];
+                    taken[parents[j]] = true;
+                }
+            }
+            size_t free_slot = 0;
+            for (size_t j = 0; j < n; ++j) {
+                if (slot_of[j] != n) continue;
+                while (taken[free_slot]) ++free_slot;
+                taken[free_slot] = true;
+                slot_of[j] = free_slot;
+                fork_decoder_cache_slot(parents[j], free_slot);
+            }
+            live.assign(n, Beam{});
+            std::vector<uint32_t> tokens(n);
+            for (size_t j = 0; j < n; ++j) {
+                tokens[slot_of[j]] = next[j].tokens.back();
+                live[slot_of[j]] = std::move(next[j]);
+            }
+            if (t + 1 >= options.max_tokens) break;
+            if (!step(tokens, start_position + t, logprobs)) return {};
+        }
+
+        for (auto& b : live) {
+            const float score = score_of(b.logprob, b.tokens.size());
+            finished.push_back({std::move(b.tokens), b.logprob, score, temperature, false});
+        }
+        std::stable_sort(finished.begin(), finished.end(),
+                         [](const BeamHypothesis& x, const BeamHypothesis& y) { return x.score > y.score; });
+        result = std::move(finished);
+        if (result.empty() || (should_stop && should_stop->load())) break;
+        const auto& best = result.front();
+        const float avg_logprob = best.tokens.empty() ? 0.0f
+            : best.logprob / static_cast<float>(best.tokens.size());
+        if (avg_logprob >= options.logprob_threshold) break;
+    }
+
+    if (result.size() > std::max<size_t>(options.n_best, 1)) result.resize(std::max<size_t>(options.n_best, 1));
+    return result;
+}
+
+// `prompt_tokens` continue whatever the cache already holds. All but the last go through the
+// regular (chunked) prefill and the last runs once as a single-row step; the conversation then
+// becomes the shared prefix of beam tail slots sized for `max_tokens`. On return the cache is
+// back in its own layout holding the conversation plus the whole prompt; a search that cannot
+// run returns nothing and leaves it untouched.
+std::vector<Model::BeamHypothesis> Model::beam_search(
+    const std::vector<uint32_t>& prompt_tokens, const BeamSearchOptions& options,
+    const std::vector<std::vector<uint32_t>>& stop_token_sequences, const std::atomic<bool>* should_stop) {
+    settle_kv_compaction();
+    const bool cached = decode_route_ == DecodeRoute::CACHED_STEP;
+    const bool direct = decode_route_ == DecodeRoute::DIRECT_DECODER_STEP;
+    if (prompt_tokens.empty() || options.max_tokens == 0 || !decoder_ || (!cached && !direct)) return {};
+    if (cached && (!encoder_ || !load_component_graph(*encoder_))) return {};
+    if (!load_component_graph(*decoder_) || !decoder_supports_cache_slots()) return {};
+    for (const auto& state : decoder_->cache_states) {
+        for (int node_id : {state.key_node_id, state.value_node_id}) {
+            if (node_id < 0) continue;
+            if (decoder_->graph->get_node_op_type(static_cast<size_t>(node_id)) != OpType::KV_CACHE_STATE) continue;
+            if (!decoder_->graph->cache_slots_supported(static_cast<size_t>(node_id))) return {};
+        }
+    }
+
+    const size_t beam = std::max<size_t>(options.beam_size, 1);
+    const bool batched = beam > 1 && has_dynamic_batch_input(*decoder_) &&
+                         (!cached || has_dynamic_batch_input(*encoder_));
+    if (prompt_tokens.size() > 1) {
+        prefill(std::vector<uint32_t>(prompt_tokens.begin(), prompt_tokens.end() - 1));
+        settle_kv_compaction();
+    }
+
+    if (cached) set_component_batch(*encoder_, 1);
+    set_component_batch(*decoder_, 1);
+    decoder_->graph->set_cache_slot(0);
+    run_step_batch({prompt_tokens.back()}, {cache_total_seq_len_});
+    ++cache_total_seq_len_;
+    cache_token_ids_.push_back(prompt_tokens.back());
+    std::vector<float> prompt_logprobs;
+    beam_row_logprobs(0, 1, prompt_logprobs);
+
+    const size_t num_slots = decoder_cache_num_slots();
+    share_decoder_cache_prefix(beam, options.max_tokens);
+    const size_t prompt_slot = beam;
+    struct SlotRestore {
+        Model& model;
+        Component* encoder;
+        size_t num_slots;
+        size_t prompt_slot;
+        ~SlotRestore() {
+            model.decoder_->graph->set_cache_slot(0);
+            if (encoder) model.set_component_batch(*encoder, 1);
+            model.set_component_batch(*model.decoder_, 1);
+            model.reslot_decoder_cache(num_slots, prompt_slot, 0);
+        }
+    } restore{*this, cached ? encoder_ : nullptr, num_slots, prompt_slot};
+
+    size_t current_batch = 1;
+    BeamStepFn step = [&](const std::vector<uint32_t>& tokens, size_t position,
+                          std::vector<std::vector<float>>& logprobs) {
+        const size_t n = tokens.size();
+        logprobs.resize(n);
+        if (batched) {
+            if (n != current_batch) {
+                if (cached) set_component_batch(*encoder_, n);
+                set_component_batch(*decoder_, n);
+                current_batch = n;
+            }
+            run_step_batch(tokens, std::vector<size_t>(n, position));
+            for (size_t b = 0; b < n; ++b) beam_row_logprobs(b, n, logprobs[b]);
+            return true;
+        }
+        for (size_t b = 0; b < n; ++b) {
+            decoder_->graph->set_cache_slot(b);
+            run_step_batch({tokens[b]}, {position});
+            beam_row_logprobs(0, 1, logprobs[b]);
+        }
+        decoder_->graph->set_cache_slot(0);
+        return true;
+    };
+    return run_beam_search(cache_total_seq_len_, prompt_logprobs, prompt_slot, options,
+                           stop_token_sequences, should_stop, step);
+}
+
 #define FOR_EACH_MATCHED_OUTPUT(source, target, body) \
     for (size_t _i = 0; _i < (source).output_node_ids.size() && _i < (source).logical_outputs.size(); ++_i) { \
         const std::string& out_name = (source).logical_outputs[_i]; \
@@ -1204,7 +1532,12 @@ void Model::reset_component_cache_states(Component& comp) {
                         uint64_t num_slots = (desc.byte_size >= 6 * sizeof(uint64_t) && meta[5] > 0) ? meta[5] : 1;
                         size_t slot_stride = num_slots ? desc.byte_size / num_slots : desc.byte_size;
                         for (uint64_t s = 0; s < num_slots; ++s) {
-                            *reinterpret_cast<uint64_t*>(static_cast<char*>(ptr) + s * slot_stride) = 0;
+                            char* slot = static_cast<char*>(ptr) + s * slot_stride;
+                            *reinterpret_cast<uint64_t*>(slot) = 0;
+                            // An emptied sliding window restarts linear, not at the old ring rotation.
+                            if (slot_stride >= sizeof(cactus::kvcompress::CacheHeader)) {
+                                reinterpret_cast<cactus::kvcompress::CacheHeader*>(slot)->ring_head = 0;
+                            }
                         }
                     }
                     break;
@@ -1500,8 +1833,101 @@ void write_typed_buffer(std::vector<uint8_t>& buf, Precision dst_prec,
                         const void* src_data, size_t src_bytes, Precision src_prec);
 }  // namespace
 
+void Model::configure_vision_cache() {
+    size_t max_mb = 64;
+    if (const char* env = std::getenv("CACTUS_VISION_CACHE_MB")) {
+        max_mb = static_cast<size_t>(std::max(0L, std::atol(env)));
+    }
+    std::string disk_dir;
+    if (const char* env = std::getenv("CACTUS_VISION_CACHE_DIR")) disk_dir = env;
+
+    std::string salt = family_ + "|" + bundle_dir_ + "|" + vision_encoder_->graph_path;
+    std::error_code ec;
+    const auto graph_time = fs::last_write_time(fs::path(bundle_dir_) / vision_encoder_->graph_path, ec);
+    if (!ec) salt += "|" + std::to_string(graph_time.time_since_epoch().count());
+    vision_cache_.configure(max_mb << 20, disk_dir, salt);
+}
+
+std::vector<std::string> Model::vision_feature_names() const {
+    if (family_ == "lfm2_vl") return {"image_features"};
+    return vision_encoder_ ? vision_encoder_->logical_outputs : std::vector<std::string>{};
+}
+
+Model::VisionFeatureMarks Model::mark_vision_features() const {
+    VisionFeatureMarks marks;
+    for (const std::string& name : vision_feature_names()) {
+        auto it = media_features_.find(name);
+        if (it == media_features_.end()) continue;
+        VisionFeatureMark mark;
+        mark.bytes = it->second.size();
+        auto shape_it = media_feature_shapes_.find(name);
+        if (shape_it != media_feature_shapes_.end() && shape_it->second.size() >= 2) {
+            mark.rows = shape_it->second[shape_it->second.size() - 2];
+        }
+        marks[name] = mark;
+    }
+    return marks;
+}
+
+VisionCacheEntry Model::capture_vision_features(const VisionFeatureMarks& marks) const {
+    VisionCacheEntry entry;
+    for (const std::string& name : vision_feature_names()) {
+        auto it = media_features_.find(name);
+        if (it == media_features_.end()) continue;
+        auto mark_it = marks.find(name);
+        const VisionFeatureMark mark = mark_it != marks.end() ? mark_it->second : VisionFeatureMark{};
+        if (it->second.size() <= mark.bytes) continue;
+
+        VisionCacheEntry::Output out;
+        out.name = name;
+        out.bytes.assign(it->second.begin() + static_cast<std::ptrdiff_t>(mark.bytes), it->second.end());
+        auto shape_it = media_feature_shapes_.find(name);
+        if (shape_it != media_feature_shapes_.end()) out.shape = shape_it->second;
+        if (out.shape.size() >= 2) out.shape[out.shape.size() - 2] -= mark.rows;
+        auto prec_it = media_feature_precisions_.find(name);
+        if (prec_it != media_feature_precisions_.end()) out.precision = prec_it->second;
+        entry.outputs.push_back(std::move(out));
+    }
+    return entry;
+}
+
+void Model::append_vision_features(const VisionCacheEntry& entry) {
+    for (const auto& out : entry.outputs) {
+        auto& slot = media_features_[out.name];
+        slot.insert(slot.end(), out.bytes.begin(), out.bytes.end());
+        auto shape_it = media_feature_shapes_.find(out.name);
+        if (shape_it == media_feature_shapes_.end() || shape_it->second.empty()) {
+            media_feature_shapes_[out.name] = out.shape;
+        } else if (out.shape.size() >= 2 && shape_it->second.size() == out.shape.size()) {
+            shape_it->second[shape_it->second.size() - 2] += out.shape[out.shape.size() - 2];
+        }
+        media_feature_precisions_[out.name] = out.precision;
+    }
+}
+
+void Model::clear_vision_features() {
+    for (const std::string& name : vision_feature_names()) {
+        media_features_.erase(name);
+        media_feature_shapes_.erase(name);
+        media_feature_precisions_.erase(name);
+    }
+}
+
 void Model::run_vision_encoder(const std::string& image_path) {
     if (!vision_encoder_) return;
+    VisionCacheKey key;
+    const bool keyed = vision_cache_.enabled() && vision_cache_.key_for_file(image_path, key);
+    std::shared_ptr<const VisionCacheEntry> cached = keyed ? vision_cache_.find(key) : nullptr;
+    clear_vision_features();
+    if (cached) {
+        append_vision_features(*cached);
+        return;
+    }
+    run_vision_encoder_uncached(image_path);
+    if (keyed) vision_cache_.insert(key, capture_vision_features({}));
+}
+
+void Model::run_vision_encoder_uncached(const std::string& image_path) {
     if (family_ == "lfm2_vl") {
         run_vision_encoder_lfm2_vl(image_path);
         return;
@@ -1899,6 +2325,33 @@ void Model::run_audio_encoder(const std::vector<float>& audio_features) {
     }
 }
 
+const uint64_t* Model::prepare_logit_mask(size_t vocab) {
+    const uint64_t* tool_mask = tool_constrainer_.get_token_mask();
+    const uint64_t* grammar_mask = grammar_.is_active() ? grammar_.get_token_mask() : nullptr;
+    if ((!tool_mask && !grammar_mask) || !tokenizer_ || vocab == 0) return nullptr;
+
+    const size_t words = (vocab + 63) / 64;
+    const size_t mask_words = std::min<size_t>(words, (tokenizer_->get_vocab_size() + 63) / 64);
+    logit_mask_.assign(words, 0);
+    for (size_t w = 0; w < mask_words; ++w) {
+        logit_mask_[w] = (tool_mask ? tool_mask[w] : ~0ULL) & (grammar_mask ? grammar_mask[w] : ~0ULL);
+    }
+    if (vocab % 64) logit_mask_[words - 1] &= (1ULL << (vocab % 64)) - 1;
+    logit_mask_scratch_ = logit_mask_;
+
+    masked_bias_tokens_.clear();
+    auto split_out = [&](size_t token_id) {
+        if (token_id >= vocab || !((logit_mask_[token_id >> 6] >> (token_id & 63)) & 1)) return;
+        if (!((logit_mask_scratch_[token_id >> 6] >> (token_id & 63)) & 1)) return;
+        logit_mask_scratch_[token_id >> 6] &= ~(1ULL << (token_id & 63));
+        masked_bias_tokens_.push_back(token_id);
+    };
+    for (const auto& [token_id, _] : tool_constrainer_.get_bias()) split_out(token_id);
+    for (const auto& [token_id, _] : vocab_bias_) split_out(token_id);
+    if (suppressed_token_id_ >= 0) split_out(static_cast<size_t>(suppressed_token_id_));
+    return logit_mask_.data();
+}
+
 uint32_t Model::argmax_logits_at(const BufferDesc& desc, void* ptr, size_t row_off, float* out_uncertainty) {
     size_t vocab = desc.shape.empty() ? 0 : desc.shape.back();
     uint32_t best = 0;
@@ -1923,7 +2376,32 @@ uint32_t Model::argmax_logits_at(const BufferDesc& desc, void* ptr, size_t row_o
             second_v = v;
         }
     };
-    if (desc.precision == Precision::FP32) {
+    const uint64_t* mask = prepare_logit_mask(vocab);
+    auto observe_masked = [&](auto* p, auto masked_argmax) {
+        for (size_t i : masked_bias_tokens_) observe_logit(i, static_cast<float>(p[i]));
+        for (int pass = 0; pass < 2; ++pass) {
+            float v = 0.0f;
+            const size_t i = masked_argmax(p, logit_mask_scratch_.data(), vocab, &v);
+            if (i >= vocab) break;
+            // Every allowed logit is -inf: emit the first allowed token rather than token 0.
+            if (pass == 0 && v == -std::numeric_limits<float>::infinity() && best_v == v &&
+                static_cast<int64_t>(i) != suppressed_token_id_) {
+                best = static_cast<uint32_t>(i);
+            }
+            observe_logit(i, v);
+            logit_mask_scratch_[i >> 6] &= ~(1ULL << (i & 63));
+        }
+    };
+    if (mask && desc.precision == Precision::FP32) {
+        observe_masked(static_cast<const float*>(ptr) + row_off, cactus_masked_argmax_f32);
+    } else if (mask && desc.precision == Precision::FP16) {
+        observe_masked(static_cast<const __fp16*>(ptr) + row_off, cactus_masked_argmax_f16);
+    } else if (mask) {
+        int8_t* p = static_cast<int8_t*>(ptr) + row_off;
+        for (size_t i = 0; i < vocab; ++i) {
+            if ((mask[i >> 6] >> (i & 63)) & 1) observe_logit(i, static_cast<float>(p[i]));
+        }
+    } else if (desc.precision == Precision::FP32) {
         float* p = static_cast<float*>(ptr) + row_off;
         for (size_t i = 0; i < vocab; ++i) observe_logit(i, p[i]);
     } else if (desc.precision == Precision::FP16) {
@@ -1950,15 +2428,18 @@ uint32_t Model::argmax_component_logits(Component& comp, size_t logit_row, float
     void* ptr = comp.graph->get_output(out_node);
     size_t vocab = desc.shape.empty() ? 0 : desc.shape.back();
     size_t seq = desc.shape.size() >= 2 ? desc.shape[desc.shape.size() - 2] : 1;
-    size_t row = seq > 0 ? seq - 1 : 0;
-    if (logit_row != std::numeric_limits<size_t>::max()) {
-        row = std::min(logit_row, seq > 0 ? seq - 1 : 0);
-    } else if (decode_route_ == DecodeRoute::FULL_CONTEXT_TEXT) {
-        row = std::min(last_logit_position_, seq > 0 ? seq - 1 : 0);
-    }
+    size_t row = logit_row != std::numeric_limits<size_t>::max()
+        ? std::min(logit_row, seq > 0 ? seq - 1 : 0)
+        : default_logit_row(seq);
     return argmax_logits_at(desc, ptr, row * vocab, out_uncertainty);
 }
 
+size_t Model::default_logit_row(size_t seq) const {
+    size_t row = seq > 0 ? seq - 1 : 0;
+    if (decode_route_ == DecodeRoute::FULL_CONTEXT_TEXT) row = std::min(last_logit_position_, row);
+    return row;
+}
+
 std::vector<uint32_t> Model::argmax_component_logits_batch(Component& comp, size_t batch) {
     std::vector<uint32_t> out(batch, 0);
     if (batch == 0) return out;
@@ -1982,6 +2463,7 @@ uint32_t Model::argmax_last_logits(float* out_uncertainty) {
 
 bool Model::prefill_and_sample_first_token(const std::vector<uint32_t>& tokens, uint32_t& out_token,
                                            float* out_uncertainty) {
+    settle_kv_compaction();
     reset_prefill_stats();
     if (out_uncertainty) *out_uncertainty = 0.0f;
     if (tokens.empty() || !decoder_ || cache_total_seq_len_ != 0) {
@@ -2060,6 +2542,7 @@ bool Model::prefill_and_sample_first_token(const std::vector<uint32_t>& tokens,
 }
 
 void Model::prefill(const std::vector<uint32_t>& tokens, size_t /*chunk_size*/, const std::string& /*profile_file*/, bool prepare_decode) {
+    settle_kv_compaction();
     reset_prefill_stats();
     if (decode_route_ == DecodeRoute::ENCODER_CROSS_KV_STEP && encoder_cross_kv_source_kind_ == "text_tokens") {
         (void)prepare_decode;
@@ -2342,6 +2825,11 @@ bool Model::prepare_encoder_cross_kv_from_audio(const std::vector<float>& audio_
 }
 
 bool Model::run_encoder_cross_kv_decoder_step(uint32_t token_id, size_t position) {
+    return run_encoder_cross_kv_decoder_step(std::vector<uint32_t>{token_id}, position);
+}
+
+// Row b of a batched decoder step takes token_ids[b]; all rows share one position.
+bool Model::run_encoder_cross_kv_decoder_step(const std::vector<uint32_t>& token_ids, size_t position) {
     if (!encoder_cross_kv_ready_ || !decoder_) return false;
     int ids_idx = input_index(*decoder_, "decoder_input_ids");
     const char* ids_name = "decoder_input_ids";
@@ -2354,8 +2842,10 @@ bool Model::run_encoder_cross_kv_decoder_step(uint32_t token_id, size_t position
         CACTUS_LOG_ERROR("model", "decoder_step missing decoder_input_ids/input_ids or position_ids input");
         return false;
     }
-    write_int_input(*decoder_, ids_name, static_cast<int64_t>(token_id));
-    write_int_input(*decoder_, "position_ids", static_cast<int64_t>(position));
+    for (size_t b = 0; b < token_ids.size(); ++b) {
+        write_int_input_at(*decoder_, ids_name, b, static_cast<int64_t>(token_ids[b]));
+        write_int_input_at(*decoder_, "position_ids", b, static_cast<int64_t>(position));
+    }
     decoder_->graph->execute();
     return true;
 }
@@ -2544,7 +3034,23 @@ bool Model::run_chunk_prefill_path(const std::vector<uint32_t>& tokens,
     std::vector<Qwen3VlImagePreprocessed> qwen_images;
 
     if (have_images) {
-        if (!load_component_graph(*vision_encoder_)) {
+        const bool lfm2_vision = family_ == "lfm2_vl";
+        const bool qwen_vision = !lfm2_vision && (family_ == "qwen3_5" || family_ == "qwen3_vl"
+                                                  || config_.model_type == Config::ModelType::QWEN);
+        std::vector<VisionCacheKey> image_keys(image_paths.size());
+        std::vector<bool> image_keyed(image_paths.size(), false);
+        std::vector<std::shared_ptr<const VisionCacheEntry>> cached_images(image_paths.size());
+        bool any_image_miss = false;
+        for (size_t i = 0; i < image_paths.size(); ++i) {
+            if (vision_cache_.enabled() && vision_cache_.key_for_file(image_paths[i], image_keys[i])) {
+                image_keyed[i] = true;
+                cached_images[i] = vision_cache_.find(image_keys[i]);
+                if (cached_images[i] && qwen_vision && cached_images[i]->grid_h == 0) cached_images[i] = nullptr;
+            }
+            if (!cached_images[i]) any_image_miss = true;
+        }
+
+        if (any_image_miss && !load_component_graph(*vision_encoder_)) {
             throw std::runtime_error("failed to load vision_encoder");
         }
         for (const std::string& logical : vision_encoder_->logical_outputs) {
@@ -2552,22 +3058,23 @@ bool Model::run_chunk_prefill_path(const std::vector<uint32_t>& tokens,
             media_feature_shapes_.erase(logical);
             media_feature_precisions_.erase(logical);
         }
-        const bool lfm2_vision = family_ == "lfm2_vl";
         if (lfm2_vision) {
+            media_features_.erase("image_features");
+            media_feature_shapes_.erase("image_features");
+            media_feature_precisions_.erase("image_features");
+        }
+        if (lfm2_vision && any_image_miss) {
             if (!vision_projector_) throw std::runtime_error("lfm2_vl requires a vision_projector component");
             if (!load_lfm2_vl_position_grid()) {
                 throw std::runtime_error("lfm2_vl vision position-embedding grid is missing from the bundle");
             }
             if (!load_component_graph(*vision_projector_)) throw std::runtime_error("failed to load vision_projector");
-            media_features_.erase("image_features");
-            media_feature_shapes_.erase("image_features");
-            media_feature_precisions_.erase("image_features");
         }
-        for (const auto& path : image_paths) {
-            if (family_ == "lfm2_vl") {
+        auto encode_image = [&](const std::string& path) {
+            if (lfm2_vision) {
                 encode_lfm2_vl_image_into_features(path);
-                continue;
-            } else if (family_ == "qwen3_5" || family_ == "qwen3_vl" || config_.model_type == Config::ModelType::QWEN) {
+                return;
+            } else if (qwen_vision) {
                 Qwen3VlImagePreprocessed prep = preprocess_qwen3_vl_image(path, config_);
                 int pv_idx = input_index(*vision_encoder_, "pixel_values");
                 if (pv_idx < 0) {
@@ -2584,7 +3091,7 @@ bool Model::run_chunk_prefill_path(const std::vector<uint32_t>& tokens,
             } else {
                 Gemma4ImagePreprocessed prep = preprocess_gemma4_image(path, config_);
                 if (has_npu_vision_encoder() && vision_encode_via_npu(prep.pixel_values, &prep.pixel_position_ids)) {
-                    continue;
+                    return;
                 }
                 int pv_idx = input_index(*vision_encoder_, "pixel_values");
                 if (pv_idx >= 0) {
@@ -2640,11 +3147,38 @@ bool Model::run_chunk_prefill_path(const std::vector<uint32_t>& tokens,
             }
             vision_encoder_->graph->release_runtime_buffers();
             vision_encoder_->graph->release_all_weight_pages();
+        };
+
+        for (size_t i = 0; i < image_paths.size(); ++i) {
+            if (cached_images[i]) {
+                append_vision_features(*cached_images[i]);
+                if (qwen_vision) {
+                    Qwen3VlImagePreprocessed grid;
+                    grid.grid_t = cached_images[i]->grid_t;
+                    grid.grid_h = cached_images[i]->grid_h;
+                    grid.grid_w = cached_images[i]->grid_w;
+                    qwen_images.push_back(std::move(grid));
+                }
+                continue;
+            }
+            const VisionFeatureMarks marks = mark_vision_features();
+            encode_image(image_paths[i]);
+            if (image_keyed[i]) {
+                VisionCacheEntry entry = capture_vision_features(marks);
+                if (qwen_vision && !qwen_images.empty()) {
+                    entry.grid_t = qwen_images.back().grid_t;
+                    entry.grid_h = qwen_images.back().grid_h;
+                    entry.grid_w = qwen_images.back().grid_w;
+                }
+                vision_cache_.insert(image_keys[i], std::move(entry));
+            }
         }
-        if (lfm2_vision) {
-            unload_component_graph(*vision_projector_);
+        if (any_image_miss) {
+            if (lfm2_vision) {
+                unload_component_graph(*vision_projector_);
+            }
+            unload_component_graph(*vision_encoder_);
         }
-        unload_component_graph(*vision_encoder_);
     }
 
     if (have_audio) {
@@ -2864,6 +3398,7 @@ void Model::prefill_with_media(const std::vector<uint32_t>& tokens,
                                const std::vector<std::vector<float>>& audio_features_per_message,
                                const std::string& profile_file) {
     if (tokens.empty()) return;
+    settle_kv_compaction();
     if (!image_paths.empty() && vision_encoder_ == nullptr) {
         throw std::runtime_error("Model bundle does not include a vision_encoder for image input");
     }
@@ -3026,6 +3561,8 @@ uint32_t Model::decode(const std::vector<uint32_t>& tokens, float /*temperature*
         record_sampled_token(result);
         return result;
     }
+    // Background scoring only tolerates one appended row per step before the swap point.
+    if (tokens.size() > 1) settle_kv_compaction();
     for (size_t i = 0; i + 1 < tokens.size(); ++i) {
         run_step(tokens[i], cache_total_seq_len_ + i, /*read_logits=*/false);
     }
@@ -3068,6 +3605,79 @@ std::vector<uint32_t> Model::transcribe_whisper_seq2seq(
         should_stop);
 }
 
+// The decoder prompt runs once in the default layout and becomes the shared prefix of the beam
+// slots. A decoder with a dynamic batch steps every beam in one call, with the cross-KV tiled
+// across the rows; otherwise beams step one after another, each pointed at its own slot.
+std::vector<Model::BeamHypothesis> Model::transcribe_whisper_beam(
+    const std::vector<float>& audio_features,
+    const std::vector<uint32_t>& decoder_prompt_tokens,
+    const BeamSearchOptions& options,
+    const std::vector<std::vector<uint32_t>>& stop_token_sequences,
+    const std::atomic<bool>* should_stop,
+    int64_t suppress_token_id) {
+    if (decoder_prompt_tokens.empty() || options.max_tokens == 0) return {};
+    if (decode_route_ != DecodeRoute::ENCODER_CROSS_KV_STEP || encoder_cross_kv_source_kind_ != "audio_features") {
+        CACTUS_LOG_ERROR("model", "Whisper bundle missing encoder_cross_kv_decoder_step route metadata");
+        return {};
+    }
+    if (!decoder_ || !load_component_graph(*decoder_) || !decoder_supports_cache_slots()) return {};
+
+    const size_t beam = std::max<size_t>(options.beam_size, 1);
+    // Batched rows each read their own copy of the cross-KV, so every decoder input must resize.
+    bool batched = beam > 1 && has_dynamic_batch_input(*decoder_);
+    for (int node_id : decoder_->runtime_input_node_ids) {
+        if (node_id < 0) continue;
+        if (!decoder_->graph->get_output_buffer(static_cast<size_t>(node_id)).has_dynamic_dims()) batched = false;
+    }
+    struct SlotRestore {
+        Model& model;
+        size_t num_slots;
+        ~SlotRestore() {
+            model.decoder_->graph->set_cache_slot(0);
+            model.set_component_batch(*model.decoder_, 1, true);
+            model.set_decode_slots(num_slots);
+            model.suppressed_token_id_ = -1;
+        }
+    } restore{*this, decoder_cache_num_slots()};
+    set_component_batch(*decoder_, 1, true);
+    if (!prepare_encoder_cross_kv_from_audio(audio_features)) return {};
+    suppressed_token_id_ = suppress_token_id;
+
+    decoder_->graph->set_cache_slot(0);
+    for (size_t pos = 0; pos < decoder_prompt_tokens.size(); ++pos) {
+        if (!run_encoder_cross_kv_decoder_step(decoder_prompt_tokens[pos], pos)) return {};
+    }
+    std::vector<float> prompt_logprobs;
+    beam_row_logprobs(0, 1, prompt_logprobs);
+    share_decoder_cache_prefix(beam, options.max_tokens);
+    const size_t prompt_slot = beam;
+
+    size_t current_batch = 1;
+    BeamStepFn step = [&](const std::vector<uint32_t>& tokens, size_t position,
+                          std::vector<std::vector<float>>& logprobs) {
+        const size_t n = tokens.size();
+        logprobs.resize(n);
+        if (batched) {
+            if (n != current_batch) {
+                set_component_batch(*decoder_, n, true);
+                current_batch = n;
+            }
+            if (!run_encoder_cross_kv_decoder_step(tokens, position)) return false;
+            for (size_t b = 0; b < n; ++b) beam_row_logprobs(b, n, logprobs[b]);
+            return true;
+        }
+        for (size_t b = 0; b < n; ++b) {
+            decoder_->graph->set_cache_slot(b);
+            if (!run_encoder_cross_kv_decoder_step(tokens[b], position)) return false;
+            beam_row_logprobs(0, 1, logprobs[b]);
+        }
+        decoder_->graph->set_cache_slot(0);
+        return true;
+    };
+    return run_beam_search(decoder_prompt_tokens.size(), prompt_logprobs, prompt_slot, options,
+                           stop_token_sequences, should_stop, step);
+}
+
 std::vector<uint32_t> Model::transcribe_parakeet_tdt(const std::vector<float>& audio_features,
                                                      ParakeetTdtStreamState* stream, bool is_final,
                                                      size_t end_frame,
@@ -3531,6 +4141,7 @@ std::vector<float> Model::get_audio_embeddings(const std::vector<float>& mel_bin
 }
 
 void Model::reset_cache() {
+    kv_compaction_.reset();
     cache_total_seq_len_ = 0;
     last_logit_position_ = 0;
     encoder_cross_kv_ready_ = false;
@@ -3548,11 +4159,62 @@ void Model::reset_cache() {
     }
 }
 
+Model::CacheStash Model::stash_cache() {
+    CacheStash stash;
+    for (auto& kv : components_) {
+        Component& comp = kv.second;
+        if (!comp.graph) continue;
+        std::set<int> taken;
+        for (const auto& state : comp.cache_states) {
+            for (int node_id : {state.key_node_id, state.value_node_id}) {
+                if (node_id < 0 || !taken.insert(node_id).second) continue;
+                stash.buffers.emplace_back(&comp, static_cast<size_t>(node_id),
+                                           comp.graph->take_cache_buffer(static_cast<size_t>(node_id)));
+            }
+        }
+    }
+    stash.compaction = std::move(kv_compaction_);
+    stash.total_seq_len = cache_total_seq_len_;
+    stash.last_logit_position = last_logit_position_;
+    stash.encoder_cross_kv_ready = encoder_cross_kv_ready_;
+    stash.context_tokens = std::move(context_tokens_);
+    stash.cache_token_ids = std::move(cache_token_ids_);
+    stash.token_history = std::move(token_history_);
+    stash.special_rows = std::move(special_rows_);
+    stash.media_features = std::move(media_features_);
+    stash.media_feature_shapes = std::move(media_feature_shapes_);
+    stash.media_feature_precisions = std::move(media_feature_precisions_);
+    reset_cache();
+    return stash;
+}
+
+void Model::restore_cache(CacheStash& stash) {
+    // Settle the scratch pass's compaction before its buffers go away.
+    kv_compaction_.reset();
+    for (auto& [comp, node_id, buffer] : stash.buffers) {
+        if (comp->graph) comp->graph->restore_cache_buffer(node_id, std::move(buffer));
+    }
+    stash.buffers.clear();
+    kv_compaction_ = std::move(stash.compaction);
+    cache_total_seq_len_ = stash.total_seq_len;
+    last_logit_position_ = stash.last_logit_position;
+    encoder_cross_kv_ready_ = stash.encoder_cross_kv_ready;
+    context_tokens_ = std::move(stash.context_tokens);
+    cache_token_ids_ = std::move(stash.cache_token_ids);
+    token_history_ = std::move(stash.token_history);
+    special_rows_ = std::move(stash.special_rows);
+    media_features_ = std::move(stash.media_features);
+    media_feature_shapes_ = std::move(stash.media_feature_shapes);
+    media_feature_precisions_ = std::move(stash.media_feature_precisions);
+}
+
 void Model::set_cache_window(size_t /*window_size*/, size_t /*sink_size*/) {}
 
 void Model::apply_kv_compress_env_override() {
     config_.parse_kv_compress_override(std::getenv("CACTUS_KV_COMPRESS_AT"),
                                        std::getenv("CACTUS_KV_COMPRESS_TO"));
+    const char* lead = std::getenv("CACTUS_KV_COMPRESS_ASYNC_LEAD");
+    if (lead && *lead) config_.kv_compress_async_lead = static_cast<int32_t>(std::stol(lead));
 }
 
 std::vector<size_t> Model::compressible_layers() const {
@@ -3562,37 +4224,39 @@ std::vector<size_t> Model::compressible_layers() const {
         config_.layer_types, config_.num_layers, shared);
 }
 
-void Model::compress_kv_cache_keydiff(const cactus::kvcompress::Params& params) {
-    if (!decoder_) return;
+bool Model::prepare_kv_compaction(const cactus::kvcompress::Params& params, size_t rope_len,
+                                  KvCompactionPlan& plan) {
+    if (!decoder_ || !decoder_->graph) return false;
     using cactus::kvcompress::CacheHeader;
     constexpr size_t kHeaderBytes = sizeof(CacheHeader);
 
     std::vector<size_t> layers = compressible_layers();
-    if (layers.empty()) return;
+    if (layers.empty()) return false;
     std::set<size_t> compressible(layers.begin(), layers.end());
-    const double rope_theta = static_cast<double>(config_.rope_theta);
-    const double rope_local_theta = (config_.rope_local_base_freq == Config::UNSET_F32)
-        ? rope_theta : static_cast<double>(config_.rope_local_base_freq);
     const size_t old_total = cache_total_seq_len_;
 
-    cactus::kvcompress::Params params_local = params;
     bool preserve = config_.kv_compress_preserve_special;
     if (const char* e = std::getenv("CACTUS_KV_PRESERVE_SPECIAL")) preserve = (std::atoi(e) != 0);
     const bool map_valid = cache_token_ids_.size() == old_total && media_features_.empty();
-    const bool per_head_protect = preserve && map_valid && special_rows_.valid();
+    plan.params = params;
+    plan.snapshot_len = old_total;
+    plan.rope_theta = static_cast<double>(config_.rope_theta);
+    plan.per_head_protect = preserve && map_valid && special_rows_.valid();
+    plan.appended_special.clear();
+    plan.layers.clear();
+    plan.unrope.clear();
     // cache_token_ids_ past tracked_len is still head-aligned, so specials there apply to every head.
-    std::vector<int> appended_special;
-    if (per_head_protect) {
+    if (plan.per_head_protect) {
         if (special_ids_.empty() && tokenizer_) special_ids_ = tokenizer_->special_token_ids();
         for (size_t r = special_rows_.tracked_len(); r < old_total && r < cache_token_ids_.size(); ++r)
-            if (special_ids_.count(cache_token_ids_[r])) appended_special.push_back(static_cast<int>(r));
+            if (special_ids_.count(cache_token_ids_[r])) plan.appended_special.push_back(static_cast<int>(r));
     }
 
     Component& comp = *decoder_;
-    if (!comp.graph) return;
-    // Skip the whole pass (before mutating) if any layer's V dim differs from K (MLA), or a head
-    // can't fit sink + all its specials in the budget.
+    // Skip the whole pass if any layer's V dim differs from K (MLA), or a head can't fit sink + all
+    // its specials in the budget.
     const size_t protect_budget = params.abs_budget > 0 ? static_cast<size_t>(params.abs_budget) : 0;
+    size_t rows = 0;
     for (size_t li = 0; li < comp.cache_states.size(); ++li) {
         if (!compressible.count(li)) continue;
         const auto& cs = comp.cache_states[li];
@@ -3601,56 +4265,115 @@ void Model::compress_kv_cache_keydiff(const cactus::kvcompress::Params& params)
         void* kraw = comp.graph->get_output(static_cast<size_t>(cs.key_node_id));
         void* vraw = comp.graph->get_output(static_cast<size_t>(cs.value_node_id));
         if (!kraw || !vraw) continue;
-        if (static_cast<CacheHeader*>(vraw)->head_dim != static_cast<CacheHeader*>(kraw)->head_dim) return;
-        if (per_head_protect && protect_budget > 0 &&
-            special_rows_.max_reserved(li, params.sink, appended_special) > protect_budget) return;
+        if (static_cast<CacheHeader*>(vraw)->head_dim != static_cast<CacheHeader*>(kraw)->head_dim) return false;
+        if (static_cast<CacheHeader*>(kraw)->kv_bits != 0 || static_cast<CacheHeader*>(kraw)->kv_flags != 0) return false;
+        if (plan.per_head_protect && protect_budget > 0 &&
+            special_rows_.max_reserved(li, params.sink, plan.appended_special) > protect_budget) return false;
+
+        const auto& kdesc = comp.graph->get_output_buffer(static_cast<size_t>(cs.key_node_id));
+        const auto& vdesc = comp.graph->get_output_buffer(static_cast<size_t>(cs.value_node_id));
+        if (kdesc.byte_size <= kHeaderBytes || vdesc.byte_size <= kHeaderBytes) continue;
+        if (kdesc.precision != Precision::FP16 && kdesc.precision != Precision::INT8) continue;
+        const auto* khdr = static_cast<const CacheHeader*>(kraw);
+        KvCompactionLayer layer;
+        layer.cache_index = li;
+        layer.precision = kdesc.precision;
+        layer.rows = khdr->current_seq_len;
+        layer.kv_heads = khdr->num_kv_heads;
+        layer.head_dim = khdr->head_dim;
+        if (layer.kv_heads == 0 || layer.head_dim == 0) continue;
+        layer.key_rows = static_cast<const char*>(kraw) + kHeaderBytes;
+        if (layer.precision == Precision::INT8) {
+            layer.key_scales = reinterpret_cast<const float*>(static_cast<const char*>(kraw) + kHeaderBytes +
+                                                              khdr->max_seq_len * layer.kv_heads * layer.head_dim);
+        }
+        if (plan.per_head_protect) {
+            layer.protect = special_rows_.protect(li);
+            if (layer.protect.empty()) layer.protect.resize(layer.kv_heads);
+            for (auto& head_rows : layer.protect)
+                head_rows.insert(head_rows.end(), plan.appended_special.begin(), plan.appended_special.end());
+        }
+        if (plan.layers.empty()) rows = layer.rows;
+        plan.layers.push_back(std::move(layer));
+    }
+    plan.rope_len = std::max(rope_len, rows);
+    return !plan.layers.empty();
+}
+
+void Model::score_kv_compaction(KvCompactionPlan& plan) {
+    if (plan.layers.empty()) return;
+    plan.unrope = cactus::kvcompress::unrope_table(plan.rope_len, plan.layers.front().head_dim, plan.rope_theta);
+    static const std::vector<std::vector<int>> kNoProtect;
+    for (auto& layer : plan.layers) {
+        const auto& pph = plan.per_head_protect ? layer.protect : kNoProtect;
+        if (layer.precision == Precision::FP16) {
+            layer.kept = cactus::kvcompress::keepsets_from_fp16(
+                static_cast<const uint16_t*>(layer.key_rows), layer.rows, layer.kv_heads, layer.head_dim,
+                plan.unrope, plan.params, pph);
+        } else {
+            layer.kept = cactus::kvcompress::keepsets_from_int8(
+                static_cast<const int8_t*>(layer.key_rows), layer.key_scales, layer.rows, layer.kv_heads,
+                layer.head_dim, KV_QUANT_GROUP_SIZE, plan.unrope, plan.params, pph);
+        }
+    }
+}
+
+bool Model::apply_kv_compaction(KvCompactionPlan& plan) {
+    if (!decoder_ || !decoder_->graph || plan.layers.empty()) return false;
+    using cactus::kvcompress::CacheHeader;
+    constexpr size_t kHeaderBytes = sizeof(CacheHeader);
+    Component& comp = *decoder_;
+
+    const size_t old_total = cache_total_seq_len_;
+    if (old_total < plan.snapshot_len) return false;
+    for (const auto& layer : plan.layers) {
+        const auto& cs = comp.cache_states[layer.cache_index];
+        const auto* khdr = static_cast<const CacheHeader*>(comp.graph->get_output(static_cast<size_t>(cs.key_node_id)));
+        if (!khdr || khdr->current_seq_len < layer.rows) return false;
+    }
+
+    std::vector<size_t> layers = compressible_layers();
+    std::set<size_t> compressible(layers.begin(), layers.end());
+    const double rope_theta = plan.rope_theta;
+    const double rope_local_theta = (config_.rope_local_base_freq == Config::UNSET_F32)
+        ? rope_theta : static_cast<double>(config_.rope_local_base_freq);
+    const bool map_valid = cache_token_ids_.size() == old_total && media_features_.empty();
+    const bool per_head_protect = plan.per_head_protect && map_valid;
+    // Rows appended after the snapshot are all kept; any specials among them join the tracker.
+    std::vector<int> appended_special = plan.appended_special;
+    if (per_head_protect) {
+        for (size_t r = plan.snapshot_len; r < old_total; ++r)
+            if (special_ids_.count(cache_token_ids_[r])) appended_special.push_back(static_cast<int>(r));
     }
+
     size_t new_seq_len = 0;
     bool have_new_seq_len = false;
     std::vector<int> canonical_keep;
     bool canonical_captured = false;
-    std::vector<cactus::kvcompress::RopeRotation> unrope;
     size_t shrink_cap = 1;
     while (shrink_cap < static_cast<size_t>(config_.kv_compress_trigger_len)) shrink_cap <<= 1;
-    for (size_t li = 0; li < comp.cache_states.size(); ++li) {
-        if (!compressible.count(li)) continue;
+    for (auto& layer : plan.layers) {
+        const size_t li = layer.cache_index;
         const auto& cs = comp.cache_states[li];
-        if (cs.key_node_id < 0 || cs.value_node_id < 0) continue;
-        if (comp.graph->get_node_op_type(static_cast<size_t>(cs.key_node_id)) != OpType::KV_CACHE_STATE) continue;
-
-        const auto& kdesc = comp.graph->get_output_buffer(static_cast<size_t>(cs.key_node_id));
-        const auto& vdesc = comp.graph->get_output_buffer(static_cast<size_t>(cs.value_node_id));
-        if (kdesc.byte_size <= kHeaderBytes || vdesc.byte_size <= kHeaderBytes) continue;
         void* kraw = comp.graph->get_output(static_cast<size_t>(cs.key_node_id));
         void* vraw = comp.graph->get_output(static_cast<size_t>(cs.value_node_id));
-        if (!kraw || !vraw) continue;
-
         auto* khdr = static_cast<CacheHeader*>(kraw);
         auto* vhdr = static_cast<CacheHeader*>(vraw);
-        size_t n = khdr->current_seq_len;
-        size_t kv_heads = khdr->num_kv_heads;
-        size_t head_dim = khdr->head_dim;
-        if (kv_heads == 0 || head_dim == 0) continue;
-        if (unrope.empty()) unrope = cactus::kvcompress::unrope_table(n, head_dim, rope_theta);
-
-        static const std::vector<std::vector<int>> kNoProtect;
+        const size_t n = khdr->current_seq_len;
+        const size_t kv_heads = layer.kv_heads;
+        const size_t head_dim = layer.head_dim;
+        std::vector<std::vector<int>>& kept = layer.kept;
+        for (auto& head_rows : kept)
+            for (size_t r = layer.rows; r < n; ++r) head_rows.push_back(static_cast<int>(r));
+        if (plan.unrope.size() < n) plan.unrope = cactus::kvcompress::unrope_table(n, head_dim, rope_theta);
         if (per_head_protect) special_rows_.add_appended(li, kv_heads, appended_special);
-        const std::vector<std::vector<int>>& pph = per_head_protect ? special_rows_.protect(li) : kNoProtect;
+        if (!canonical_captured) { canonical_keep = kept.empty() ? std::vector<int>{} : kept[0]; canonical_captured = true; }
 
-        if (kdesc.precision == Precision::FP16) {
+        if (layer.precision == Precision::FP16) {
             auto* kbase = reinterpret_cast<uint16_t*>(static_cast<char*>(kraw) + kHeaderBytes);
             auto* vbase = reinterpret_cast<uint16_t*>(static_cast<char*>(vraw) + kHeaderBytes);
-            auto kept = cactus::kvcompress::keepsets_from_fp16(
-                kbase, n, kv_heads, head_dim, unrope, params_local, pph);
-            if (!canonical_captured) { canonical_keep = kept.empty() ? std::vector<int>{} : kept[0]; canonical_captured = true; }
-            cactus::kvcompress::compact_fp16(kbase, vbase, kv_heads, head_dim, kept, unrope);
-            if (per_head_protect) special_rows_.remap(li, kept);
-            size_t B = kept.empty() ? 0 : kept[0].size();
-            khdr->current_seq_len = B;
-            vhdr->current_seq_len = B;
-            new_seq_len = B;
-            have_new_seq_len = true;
-        } else if (kdesc.precision == Precision::INT8) {
+            cactus::kvcompress::compact_fp16(kbase, vbase, kv_heads, head_dim, kept, plan.unrope);
+        } else {
             size_t max_seq = khdr->max_seq_len;
             auto* k_i8 = reinterpret_cast<int8_t*>(static_cast<char*>(kraw) + kHeaderBytes);
             auto* k_sc = reinterpret_cast<float*>(static_cast<char*>(kraw) + kHeaderBytes +
@@ -3658,20 +4381,17 @@ void Model::compress_kv_cache_keydiff(const cactus::kvcompress::Params& params)
             auto* v_i8 = reinterpret_cast<int8_t*>(static_cast<char*>(vraw) + kHeaderBytes);
             auto* v_sc = reinterpret_cast<float*>(static_cast<char*>(vraw) + kHeaderBytes +
                                                   max_seq * kv_heads * head_dim);
-            auto kept = cactus::kvcompress::keepsets_from_int8(
-                k_i8, k_sc, n, kv_heads, head_dim, KV_QUANT_GROUP_SIZE, unrope, params_local, pph);
-            if (!canonical_captured) { canonical_keep = kept.empty() ? std::vector<int>{} : kept[0]; canonical_captured = true; }
             cactus::kvcompress::compact_int8(k_i8, k_sc, kv_heads, head_dim, KV_QUANT_GROUP_SIZE,
-                                             kept, unrope, /*renumber=*/true);
+                                             kept, plan.unrope, /*renumber=*/true);
             cactus::kvcompress::compact_int8(v_i8, v_sc, kv_heads, head_dim, KV_QUANT_GROUP_SIZE,
-                                             kept, unrope, /*renumber=*/false);
-            if (per_head_protect) special_rows_.remap(li, kept);
-            size_t B = kept.empty() ? 0 : kept[0].size();
-            khdr->current_seq_len = B;
-            vhdr->current_seq_len = B;
-            new_seq_len = B;
-            have_new_seq_len = true;
-        }
+                                             kept, plan.unrope, /*renumber=*/false);
+        }
+        if (per_head_protect) special_rows_.remap(li, kept);
+        size_t B = kept.empty() ? 0 : kept[0].size();
+        khdr->current_seq_len = B;
+        vhdr->current_seq_len = B;
+        new_seq_len = B;
+        have_new_seq_len = true;
         comp.graph->shrink_cache_buffer(static_cast<size_t>(cs.key_node_id), shrink_cap);
         comp.graph->shrink_cache_buffer(static_cast<size_t>(cs.value_node_id), shrink_cap);
     }
@@ -3724,11 +4444,79 @@ void Model::compress_kv_cache_keydiff(const cactus::kvcompress::Params& params)
             cache_token_ids_.clear();
         }
     }
+    return have_new_seq_len;
+}
+
+void Model::compress_kv_cache_keydiff(const cactus::kvcompress::Params& params) {
+    kv_compaction_.reset();
+    KvCompactionPlan plan;
+    if (!prepare_kv_compaction(params, 0, plan)) return;
+    score_kv_compaction(plan);
+    apply_kv_compaction(plan);
+}
+
+void Model::start_kv_compaction() {
+    if (!decoder_ || !decoder_->graph) return;
+    const size_t trigger = static_cast<size_t>(config_.kv_compress_trigger_len);
+    // Appends until the swap must not move the rows the worker reads, so grow the caches now.
+    std::vector<size_t> layers = compressible_layers();
+    for (size_t li : layers) {
+        if (li >= decoder_->cache_states.size()) continue;
+        const auto& cs = decoder_->cache_states[li];
+        for (int node_id : {cs.key_node_id, cs.value_node_id}) {
+            if (node_id < 0) continue;
+            decoder_->graph->reserve_cache_buffer(static_cast<size_t>(node_id), trigger);
+        }
+    }
+
+    // Rows appended between the snapshot and the trigger are kept whole, so the snapshot is
+    // scored for a smaller budget and the swap at the trigger lands on target_len.
+    const size_t pending = trigger - cache_total_seq_len_;
+    cactus::kvcompress::Params p;
+    p.recent_frac = config_.kv_compress_recent_frac;
+    p.sink = config_.kv_compress_sink;
+    p.abs_budget = std::max(config_.kv_compress_target_len - static_cast<int32_t>(pending),
+                            static_cast<int32_t>(config_.kv_compress_sink) + 1);
+    auto job = std::make_unique<KvCompactionJob>();
+    if (!prepare_kv_compaction(p, trigger, job->plan)) return;
+    for (const auto& layer : job->plan.layers) {
+        const auto& cs = decoder_->cache_states[layer.cache_index];
+        for (int node_id : {cs.key_node_id, cs.value_node_id}) {
+            const auto* hdr = static_cast<const cactus::kvcompress::CacheHeader*>(
+                decoder_->graph->get_output(static_cast<size_t>(node_id)));
+            if (!hdr || hdr->max_seq_len < trigger) return;
+        }
+    }
+    KvCompactionJob* raw = job.get();
+    job->worker = std::thread([raw] {
+        score_kv_compaction(raw->plan);
+        raw->done.store(true, std::memory_order_release);
+    });
+    kv_compaction_ = std::move(job);
+}
+
+void Model::settle_kv_compaction() {
+    if (!kv_compaction_) return;
+    std::unique_ptr<KvCompactionJob> job = std::move(kv_compaction_);
+    job->worker.join();
+    apply_kv_compaction(job->plan);
 }
 
 void Model::maybe_roll_compact() {
     if (!config_.kv_compress || config_.kv_compress_trigger_len <= 0) return;
-    if (cache_total_seq_len_ < static_cast<size_t>(config_.kv_compress_trigger_len)) return;
+    const size_t trigger = static_cast<size_t>(config_.kv_compress_trigger_len);
+    if (kv_compaction_) {
+        // Swap at the first step boundary after scoring finishes; only wait if the trigger comes first.
+        if (!kv_compaction_->done.load(std::memory_order_acquire) && cache_total_seq_len_ < trigger) return;
+        settle_kv_compaction();
+    }
+    const size_t lead = std::min<size_t>(static_cast<size_t>(std::max<int32_t>(config_.kv_compress_async_lead, 0)),
+                                         static_cast<size_t>(config_.kv_compress_target_len) / 4);
+    if (lead > 0 && cache_total_seq_len_ < trigger && cache_total_seq_len_ + lead >= trigger) {
+        start_kv_compaction();
+        return;
+    }
+    if (cache_total_seq_len_ < trigger) return;
 
     cactus::kvcompress::Params p;
     p.recent_frac = config_.kv_compress_recent_frac;
@@ -4060,6 +4848,7 @@ bool Config::from_json(const std::string& config_path) {
         else if (key == "kv_compress_trigger_len") kv_compress_trigger_len = static_cast<int32_t>(std::stol(value));
         else if (key == "kv_compress_target_len") kv_compress_target_len = static_cast<int32_t>(std::stol(value));
         else if (key == "kv_compress_preserve_special") kv_compress_preserve_special = (value == "true" || value == "1");
+        else if (key == "kv_compress_async_lead") kv_compress_async_lead = static_cast<int32_t>(std::stol(value));
         else if (key == "layer_types") {
             layer_types.clear();
             std::string sanitized;
@@ -4287,10 +5076,57 @@ const std::vector<Model::DebugNode>& Model::get_debug_nodes() const {
 }
 
 
-double Model::score_tokens_window_logprob(const std::vector<uint32_t>& /*tokens*/, size_t /*start*/,
-                                            size_t /*end*/, size_t /*context*/, size_t* tokens_scored) {
+// Raw logits, before the tool/vocab biases argmax applies: this is the model's own distribution.
+double Model::last_token_logprob(uint32_t token) {
+    if (!decoder_ || !decoder_->graph) return -std::numeric_limits<double>::infinity();
+    size_t out_node = static_cast<size_t>(decoder_->output_node_ids.empty() ? 0 : decoder_->output_node_ids[0]);
+    const auto& desc = decoder_->graph->get_output_buffer(out_node);
+    const void* ptr = decoder_->graph->get_output(out_node);
+    size_t vocab = desc.shape.empty() ? 0 : desc.shape.back();
+    if (!ptr || token >= vocab) return -std::numeric_limits<double>::infinity();
+    size_t seq = desc.shape.size() >= 2 ? desc.shape[desc.shape.size() - 2] : 1;
+    const size_t row_off = default_logit_row(seq) * vocab;
+    auto log_softmax = [&](const auto* p) {
+        double max_v = -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < vocab; ++i) max_v = std::max(max_v, static_cast<double>(p[i]));
+        double sum = 0.0;
+        for (size_t i = 0; i < vocab; ++i) sum += std::exp(static_cast<double>(p[i]) - max_v);
+        return static_cast<double>(p[token]) - max_v - std::log(sum);
+    };
+    if (desc.precision == Precision::FP32) return log_softmax(static_cast<const float*>(ptr) + row_off);
+    if (desc.precision == Precision::FP16) return log_softmax(static_cast<const __fp16*>(ptr) + row_off);
+    return log_softmax(static_cast<const int8_t*>(ptr) + row_off);
+}
+
+// Every token in [max(start, 1), end) is predicted from at most `context` tokens before the first
+// one scored (all earlier tokens when context is 0): that history is prefilled once and the window
+// is then teacher-forced one decode step at a time.
+double Model::score_tokens_window_logprob(const std::vector<uint32_t>& tokens, size_t start,
+                                            size_t end, size_t context, size_t* tokens_scored) {
     if (tokens_scored) *tokens_scored = 0;
-    return 0.0;
+    end = std::min(end, tokens.size());
+    const size_t first = std::max<size_t>(start, 1);
+    if (first >= end) return 0.0;
+    const size_t begin = context > 0 && first > context ? first - context : 0;
+
+    // Scoring runs on an empty cache of its own; the caller's conversation is put back afterwards.
+    CacheStash stash = stash_cache();
+    struct Restore {
+        Model* model;
+        CacheStash& stash;
+        ~Restore() { model->restore_cache(stash); }
+    } restore{this, stash};
+
+    if (first - 1 > begin) {
+        prefill(std::vector<uint32_t>(tokens.begin() + begin, tokens.begin() + first - 1), get_prefill_chunk_size());
+    }
+    double total = 0.0;
+    for (size_t i = first; i < end; ++i) {
+        decode({tokens[i - 1]});
+        total += last_token_logprob(tokens[i]);
+    }
+    if (tokens_scored) *tokens_scored = end - first;
+    return total;
 }
 
 }
@@ -1,8 +1,10 @@
 #include "engine.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <fstream>
 #include <limits>
+#include <queue>
 #include <sstream>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -13,9 +15,104 @@
 namespace cactus {
 namespace engine {
 
+namespace {
+constexpr char32_t kMetaspaceCodepoint = 0x2581;
+constexpr float kUnkPenalty = 10.0f;
+
+size_t utf8_lead_len(unsigned char byte) {
+    if (byte < 0x80) return 1;
+    if ((byte & 0xE0) == 0xC0) return 2;
+    if ((byte & 0xF0) == 0xE0) return 3;
+    if ((byte & 0xF8) == 0xF0) return 4;
+    return 0;
+}
+
+char32_t decode_codepoint(const char* c, size_t len) {
+    const unsigned char lead = static_cast<unsigned char>(c[0]);
+    switch (len) {
+        case 1: return lead;
+        case 2: return ((lead & 0x1F) << 6) | (c[1] & 0x3F);
+        case 3: return ((lead & 0x0F) << 12) | ((c[1] & 0x3F) << 6) | (c[2] & 0x3F);
+        default: return ((lead & 0x07) << 18) | ((c[1] & 0x3F) << 12) | ((c[2] & 0x3F) << 6) | (c[3] & 0x3F);
+    }
+}
+
+void append_codepoint(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Decodes leniently (stray continuation bytes are skipped, a truncated tail ends the text) and
+// re-encodes, so trie lookups see every piece and input in one canonical byte form.
+std::string canonical_utf8(const std::string& text, std::vector<char32_t>* codepoints = nullptr) {
+    std::string out;
+    out.reserve(text.size());
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const size_t len = utf8_lead_len(static_cast<unsigned char>(text[pos]));
+        if (len == 0) {
+            ++pos;
+            continue;
+        }
+        if (pos + len > text.size()) break;
+        const char32_t cp = decode_codepoint(text.data() + pos, len);
+        append_codepoint(out, cp);
+        if (codepoints) codepoints->push_back(cp);
+        pos += len;
+    }
+    return out;
+}
+
+template <typename Units>
+inline int32_t trie_next(const Units& units, int32_t state, unsigned char byte) {
+    const int64_t next = static_cast<int64_t>(units[state].base) + byte;
+    if (next <= 0 || next >= static_cast<int64_t>(units.size()) || units[next].check != state) return -1;
+    return static_cast<int32_t>(next);
+}
+
+struct ViterbiScratch {
+    std::vector<float> score;
+    std::vector<int32_t> from;
+    std::vector<int32_t> id;
+    std::vector<std::pair<int32_t, int32_t>> path;
+};
+
+struct BpeSymbol {
+    uint32_t start;
+    uint32_t len;
+    int32_t state;
+    int32_t prev;
+    int32_t next;
+};
+
+struct BpeCandidate {
+    float score;
+    int32_t left;
+    int32_t right;
+    uint32_t left_len;
+    uint32_t right_len;
+    int32_t state;
+    bool operator<(const BpeCandidate& other) const {
+        return score != other.score ? score < other.score : left > other.left;
+    }
+};
+}  // namespace
+
 SPTokenizer::SPTokenizer()
-    : trie_root_(std::make_unique<TrieNode>()),
-      vocab_size_(0),
+    : vocab_size_(0),
       unk_token_id_(3),
       bos_token_id_(2),
       eos_token_id_(1),
@@ -118,9 +215,7 @@ bool SPTokenizer::load_vocabulary_with_config(const std::string& vocab_file, con
     }
 
     vocab_stream.close();
-    
-    build_trie();
-    
+
     std::ifstream config_stream(config_file);
     if (config_stream.is_open()) {
         std::string config_line;
@@ -148,6 +243,7 @@ bool SPTokenizer::load_vocabulary_with_config(const std::string& vocab_file, con
                 bos_token_id_ = std::stoul(value);
             } else if (key == "sp_model_type") {
                 sp_bpe_mode_ = (value == "bpe" || value == "BPE");
+                sp_unigram_mode_ = (value == "unigram" || value == "UNIGRAM");
             } else if (key == "sp_add_dummy_prefix") {
                 sp_add_dummy_prefix_ = (value == "true" || value == "1");
             } else if (key == "sp_byte_fallback") {
@@ -156,6 +252,8 @@ bool SPTokenizer::load_vocabulary_with_config(const std::string& vocab_file, con
         }
     }
     
+    build_trie();
+
     std::string special_tokens_path = config_file.substr(0, config_file.find_last_of("/\\")) + "/special_tokens.json";
     load_special_tokens(special_tokens_path);
 
@@ -166,59 +264,103 @@ bool SPTokenizer::load_vocabulary_with_config(const std::string& vocab_file, con
 }
 
 void SPTokenizer::build_trie() {
+    space_joiners_.clear();
+    trie_.clear();
+
+    std::unordered_map<std::string, int32_t> pieces;
+    std::vector<char32_t> codepoints;
     for (uint32_t id = 0; id < id_to_token_.size(); ++id) {
         const std::string& token = id_to_token_[id];
         if (token.empty()) continue;
-        
-        std::u32string u32_token;
-        size_t pos = 0;
-        while (pos < token.length()) {
-            char32_t codepoint = 0;
-            unsigned char byte = token[pos];
-
-            if (byte < 0x80) {
-                codepoint = byte;
-                pos++;
-            } else if ((byte & 0xE0) == 0xC0) {
-                if (pos + 1 < token.length()) {
-                    codepoint = ((byte & 0x1F) << 6) | (token[pos + 1] & 0x3F);
-                    pos += 2;
-                } else break;
-            } else if ((byte & 0xF0) == 0xE0) {
-                if (pos + 2 < token.length()) {
-                    codepoint = ((byte & 0x0F) << 12) |
-                               ((token[pos + 1] & 0x3F) << 6) |
-                               (token[pos + 2] & 0x3F);
-                    pos += 3;
-                } else break;
-            } else if ((byte & 0xF8) == 0xF0) {
-                if (pos + 3 < token.length()) {
-                    codepoint = ((byte & 0x07) << 18) |
-                               ((token[pos + 1] & 0x3F) << 12) |
-                               ((token[pos + 2] & 0x3F) << 6) |
-                               (token[pos + 3] & 0x3F);
-                    pos += 4;
-                } else break;
-            } else {
-                pos++;
-                continue;
-            }
 
-            u32_token.push_back(codepoint);
+        codepoints.clear();
+        std::string key = canonical_utf8(token, &codepoints);
+        if (codepoints.empty()) continue;
+
+        for (size_t i = 1; i < codepoints.size(); ++i) {
+            if (codepoints[i] == kMetaspaceCodepoint) space_joiners_.insert(codepoints[i - 1]);
+        }
+        if (!sp_bpe_mode_) pieces[std::move(key)] = static_cast<int32_t>(id);
+    }
+    if (sp_bpe_mode_) {
+        for (const auto& [token, id] : token_to_id_) {
+            if (!token.empty()) pieces[token] = static_cast<int32_t>(id);
+        }
+    }
+
+    std::vector<std::pair<std::string, int32_t>> keys(pieces.begin(), pieces.end());
+    std::sort(keys.begin(), keys.end());
+
+    float min_score = 0.0f;
+    for (const auto& key : keys) {
+        if (static_cast<size_t>(key.second) < token_scores_.size()) {
+            min_score = std::min(min_score, token_scores_[key.second]);
+        }
+    }
+    unk_score_ = min_score - kUnkPenalty;
+
+    trie_.resize(256 + 1);
+    std::vector<uint8_t> used(trie_.size(), 0);
+    used[0] = 1;
+    size_t first_free = 1;
+
+    struct Pending { int32_t state; size_t lo; size_t hi; size_t depth; };
+    std::vector<Pending> stack;
+    if (!keys.empty()) stack.push_back(Pending{0, 0, keys.size(), 0});
+
+    std::vector<std::pair<unsigned char, std::pair<size_t, size_t>>> labels;
+    while (!stack.empty()) {
+        const Pending node = stack.back();
+        stack.pop_back();
+
+        size_t i = node.lo;
+        if (keys[i].first.size() == node.depth) {
+            trie_[node.state].value = keys[i].second;
+            ++i;
+        }
+        if (i == node.hi) continue;
+
+        labels.clear();
+        while (i < node.hi) {
+            const unsigned char label = static_cast<unsigned char>(keys[i].first[node.depth]);
+            size_t j = i + 1;
+            while (j < node.hi && static_cast<unsigned char>(keys[j].first[node.depth]) == label) ++j;
+            labels.push_back({label, {i, j}});
+            i = j;
         }
 
-        if (u32_token.empty()) continue;
-        
-        TrieNode* current = trie_root_.get();
-        for (char32_t ch : u32_token) {
-            if (current->children.find(ch) == current->children.end()) {
-                current->children[ch] = std::make_unique<TrieNode>();
+        size_t base = 0;
+        for (size_t pos = std::max<size_t>(first_free, labels.front().first + 1);; ++pos) {
+            if (pos + 256 >= used.size()) {
+                trie_.resize(std::max(trie_.size() * 2, pos + 257));
+                used.resize(trie_.size(), 0);
             }
-            current = current->children[ch].get();
+            if (used[pos]) continue;
+            base = pos - labels.front().first;
+            bool fits = true;
+            for (const auto& label : labels) {
+                if (used[base + label.first]) {
+                    fits = false;
+                    break;
+                }
+            }
+            if (fits) break;
+        }
+
+        trie_[node.state].base = static_cast<int32_t>(base);
+        for (const auto& label : labels) {
+            const size_t child = base + label.first;
+            used[child] = 1;
+            trie_[child].check = node.state;
+            stack.push_back(Pending{static_cast<int32_t>(child), label.second.first, label.second.second, node.depth + 1});
         }
-        current->token_id = static_cast<int32_t>(id);
-        current->score = token_scores_[id];
+        while (first_free < used.size() && used[first_free]) ++first_free;
     }
+
+    size_t size = used.size();
+    while (size > 1 && !used[size - 1]) --size;
+    trie_.resize(size);
+    trie_.shrink_to_fit();
 }
 
 std::string SPTokenizer::preprocess_text(const std::string& text) const {
@@ -272,167 +414,250 @@ std::string SPTokenizer::postprocess_text(const std::string& text) const {
     return result;
 }
 
-std::vector<std::pair<std::string, uint32_t>> SPTokenizer::tokenize_with_trie(const std::string& text) const {
-    std::vector<std::pair<std::string, uint32_t>> result;
-    
-    std::u32string u32_text;
+void SPTokenizer::append_unknown(const char* bytes, size_t len, std::vector<uint32_t>& out) const {
+    if (!sp_byte_fallback_) {
+        out.push_back(unk_token_id_);
+        return;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        char buf[7];
+        std::snprintf(buf, sizeof(buf), "<0x%02X>", static_cast<unsigned char>(bytes[i]));
+        auto byte_it = token_to_id_.find(buf);
+        out.push_back(byte_it != token_to_id_.end() ? byte_it->second : unk_token_id_);
+    }
+}
+
+void SPTokenizer::tokenize_with_trie(const std::string& text, std::vector<uint32_t>& out) const {
+    const std::string canonical = canonical_utf8(text);
+    if (canonical.empty()) {
+        out.push_back(unk_token_id_);
+        return;
+    }
+
     size_t pos = 0;
-    while (pos < text.length()) {
-        char32_t codepoint = 0;
-        unsigned char byte = text[pos];
-
-        if (byte < 0x80) {
-            codepoint = byte;
-            pos++;
-        } else if ((byte & 0xE0) == 0xC0) {
-            if (pos + 1 < text.length()) {
-                codepoint = ((byte & 0x1F) << 6) | (text[pos + 1] & 0x3F);
-                pos += 2;
-            } else break;
-        } else if ((byte & 0xF0) == 0xE0) {
-            if (pos + 2 < text.length()) {
-                codepoint = ((byte & 0x0F) << 12) |
-                           ((text[pos + 1] & 0x3F) << 6) |
-                           (text[pos + 2] & 0x3F);
-                pos += 3;
-            } else break;
-        } else if ((byte & 0xF8) == 0xF0) {
-            if (pos + 3 < text.length()) {
-                codepoint = ((byte & 0x07) << 18) |
-                           ((text[pos + 1] & 0x3F) << 12) |
-                           ((text[pos + 2] & 0x3F) << 6) |
-                           (text[pos + 3] & 0x3F);
-                pos += 4;
-            } else break;
-        } else {
-            pos++;
-            continue;
+    while (pos < canonical.size()) {
+        size_t best_len = 0;
+        int32_t best_id = -1;
+        int32_t state = 0;
+        for (size_t i = pos; i < canonical.size(); ++i) {
+            state = trie_next(trie_, state, static_cast<unsigned char>(canonical[i]));
+            if (state < 0) break;
+            if (trie_[state].value >= 0) {
+                best_len = i + 1 - pos;
+                best_id = trie_[state].value;
+            }
         }
 
-        u32_text.push_back(codepoint);
+        if (best_len > 0) {
+            out.push_back(static_cast<uint32_t>(best_id));
+            pos += best_len;
+        } else {
+            out.push_back(unk_token_id_);
+            pos += utf8_lead_len(static_cast<unsigned char>(canonical[pos]));
+        }
     }
+}
 
-    if (u32_text.empty()) {
-        result.push_back({text, unk_token_id_});
-        return result;
+void SPTokenizer::tokenize_with_viterbi(const std::string& text, std::vector<uint32_t>& out) const {
+    const std::string canonical = canonical_utf8(text);
+    if (canonical.empty()) {
+        out.push_back(unk_token_id_);
+        return;
     }
 
-    pos = 0;
-    while (pos < u32_text.length()) {
-        TrieNode* current = trie_root_.get();
-        size_t best_match_len = 0;
-        int32_t best_token_id = -1;
-        
-        for (size_t len = 0; pos + len < u32_text.length(); ++len) {
-            char32_t ch = u32_text[pos + len];
-            if (current->children.find(ch) == current->children.end()) {
-                break;
+    thread_local ViterbiScratch scratch;
+    bool last_unknown = false;
+
+    auto solve = [&](size_t begin, size_t end) {
+        const size_t n = end - begin;
+        scratch.score.assign(n + 1, 0.0f);
+        scratch.from.assign(n + 1, -1);
+        scratch.id.assign(n + 1, -1);
+        scratch.from[0] = 0;
+
+        for (size_t start = 0; start < n; ) {
+            const size_t char_len = utf8_lead_len(static_cast<unsigned char>(canonical[begin + start]));
+            const float base_score = scratch.score[start];
+            bool has_single_char = false;
+
+            int32_t state = 0;
+            for (size_t i = start; i < n; ++i) {
+                state = trie_next(trie_, state, static_cast<unsigned char>(canonical[begin + i]));
+                if (state < 0) break;
+                const int32_t id = trie_[state].value;
+                if (id < 0) continue;
+                const size_t stop = i + 1;
+                const float piece_score = static_cast<size_t>(id) < token_scores_.size()
+                    ? token_scores_[id] : -static_cast<float>(id);
+                const float score = base_score + piece_score;
+                if (scratch.from[stop] < 0 || score > scratch.score[stop]) {
+                    scratch.score[stop] = score;
+                    scratch.from[stop] = static_cast<int32_t>(start);
+                    scratch.id[stop] = id;
+                }
+                if (stop == start + char_len) has_single_char = true;
             }
-            current = current->children[ch].get();
-            if (current->token_id >= 0) {
-                best_match_len = len + 1;
-                best_token_id = current->token_id;
+
+            const size_t stop = start + char_len;
+            if (!has_single_char) {
+                const float score = base_score + unk_score_;
+                if (scratch.from[stop] < 0 || score > scratch.score[stop]) {
+                    scratch.score[stop] = score;
+                    scratch.from[stop] = static_cast<int32_t>(start);
+                    scratch.id[stop] = -1;
+                }
             }
+            start = stop;
         }
-        
-        if (best_match_len > 0) {
-            std::u32string u32_token = u32_text.substr(pos, best_match_len);
-            
-            std::string token;
-            for (char32_t cp : u32_token) {
-                if (cp < 0x80) {
-                    token.push_back(static_cast<char>(cp));
-                } else if (cp < 0x800) {
-                    token.push_back(static_cast<char>(0xC0 | (cp >> 6)));
-                    token.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-                } else if (cp < 0x10000) {
-                    token.push_back(static_cast<char>(0xE0 | (cp >> 12)));
-                    token.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
-                    token.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-                } else {
-                    token.push_back(static_cast<char>(0xF0 | (cp >> 18)));
-                    token.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
-                    token.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
-                    token.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-                }
+
+        scratch.path.clear();
+        for (size_t pos = n; pos > 0; pos = static_cast<size_t>(scratch.from[pos])) {
+            scratch.path.push_back({scratch.from[pos], scratch.id[pos]});
+        }
+        for (auto it = scratch.path.rbegin(); it != scratch.path.rend(); ++it) {
+            if (it->second >= 0) {
+                out.push_back(static_cast<uint32_t>(it->second));
+                last_unknown = false;
+                continue;
             }
-            result.push_back({token, static_cast<uint32_t>(best_token_id)});
-            pos += best_match_len;
-        } else {
-            char32_t cp = u32_text[pos];
-            std::string char_str;
-            if (cp < 0x80) {
-                char_str.push_back(static_cast<char>(cp));
-            } else if (cp < 0x800) {
-                char_str.push_back(static_cast<char>(0xC0 | (cp >> 6)));
-                char_str.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-            } else if (cp < 0x10000) {
-                char_str.push_back(static_cast<char>(0xE0 | (cp >> 12)));
-                char_str.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
-                char_str.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-            } else {
-                char_str.push_back(static_cast<char>(0xF0 | (cp >> 18)));
-                char_str.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
-                char_str.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
-                char_str.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            const size_t piece_start = static_cast<size_t>(it->first);
+            const size_t piece_end = (it + 1 == scratch.path.rend()) ? n : static_cast<size_t>((it + 1)->first);
+            if (sp_byte_fallback_) {
+                append_unknown(canonical.data() + begin + piece_start, piece_end - piece_start, out);
+            } else if (!last_unknown) {
+                out.push_back(unk_token_id_);
             }
-            result.push_back({char_str, unk_token_id_});
-            pos++;
+            last_unknown = true;
         }
+    };
+
+    size_t word_begin = 0;
+    size_t prev = 0;
+    for (size_t pos = 0; pos < canonical.size(); ) {
+        const size_t len = utf8_lead_len(static_cast<unsigned char>(canonical[pos]));
+        if (pos > word_begin && len == 3 && canonical.compare(pos, 3, "\xE2\x96\x81") == 0 &&
+            !space_joiners_.count(decode_codepoint(canonical.data() + prev, pos - prev))) {
+            solve(word_begin, pos);
+            word_begin = pos;
+        }
+        prev = pos;
+        pos += len;
     }
-    
-    return result;
+    solve(word_begin, canonical.size());
 }
 
-std::vector<uint32_t> SPTokenizer::tokenize_with_bpe(const std::string& text) const {
-    std::vector<std::string> symbols;
+void SPTokenizer::tokenize_with_bpe(const std::string& text, std::vector<uint32_t>& out) const {
+    std::vector<BpeSymbol> symbols;
+    symbols.reserve(text.size());
     for (size_t i = 0; i < text.size(); ) {
         size_t char_len = 1;
         unsigned char byte = static_cast<unsigned char>(text[i]);
         if ((byte & 0xE0) == 0xC0) char_len = 2;
         else if ((byte & 0xF0) == 0xE0) char_len = 3;
         else if ((byte & 0xF8) == 0xF0) char_len = 4;
-        if (i + char_len <= text.size()) symbols.push_back(text.substr(i, char_len));
+        if (i + char_len <= text.size()) {
+            int32_t state = 0;
+            for (size_t k = i; k < i + char_len && state >= 0; ++k) {
+                state = trie_next(trie_, state, static_cast<unsigned char>(text[k]));
+            }
+            const int32_t index = static_cast<int32_t>(symbols.size());
+            symbols.push_back(BpeSymbol{static_cast<uint32_t>(i), static_cast<uint32_t>(char_len), state, index - 1, index + 1});
+        }
         i += char_len;
     }
-
-    while (symbols.size() > 1) {
-        int best_index = -1;
-        float best_score = -std::numeric_limits<float>::infinity();
-        for (size_t i = 0; i + 1 < symbols.size(); ++i) {
-            auto it = token_to_id_.find(symbols[i] + symbols[i + 1]);
-            if (it == token_to_id_.end()) continue;
-            float score = it->second < token_scores_.size()
-                ? token_scores_[it->second]
-                : -static_cast<float>(it->second);
-            if (score > best_score) { best_score = score; best_index = static_cast<int>(i); }
+    if (symbols.empty()) return;
+    symbols.back().next = -1;
+
+    std::priority_queue<BpeCandidate> queue;
+    auto push_pair = [&](int32_t left, int32_t right) {
+        if (left < 0 || right < 0) return;
+        const BpeSymbol& a = symbols[left];
+        const BpeSymbol& b = symbols[right];
+        if (a.state < 0) return;
+        int32_t state = a.state;
+        for (uint32_t k = 0; k < b.len && state >= 0; ++k) {
+            state = trie_next(trie_, state, static_cast<unsigned char>(text[b.start + k]));
         }
-        if (best_index < 0) break;
-        symbols[best_index] += symbols[best_index + 1];
-        symbols.erase(symbols.begin() + best_index + 1);
-    }
-
-    std::vector<uint32_t> result;
-    for (const auto& symbol : symbols) {
-        auto it = token_to_id_.find(symbol);
-        if (it != token_to_id_.end()) { result.push_back(it->second); continue; }
-        if (sp_byte_fallback_) {
-            for (unsigned char b : symbol) {
-                char buf[7]; std::snprintf(buf, sizeof(buf), "<0x%02X>", b);
-                auto byte_it = token_to_id_.find(buf);
-                result.push_back(byte_it != token_to_id_.end() ? byte_it->second : unk_token_id_);
-            }
-            continue;
+        if (state < 0 || trie_[state].value < 0) return;
+        const int32_t id = trie_[state].value;
+        const float score = static_cast<size_t>(id) < token_scores_.size()
+            ? token_scores_[id] : -static_cast<float>(id);
+        queue.push(BpeCandidate{score, left, right, a.len, b.len, state});
+    };
+
+    for (int32_t i = 0; i + 1 < static_cast<int32_t>(symbols.size()); ++i) push_pair(i, i + 1);
+
+    while (!queue.empty()) {
+        const BpeCandidate top = queue.top();
+        queue.pop();
+        BpeSymbol& left = symbols[top.left];
+        BpeSymbol& right = symbols[top.right];
+        if (left.len != top.left_len || right.len != top.right_len || left.next != top.right) continue;
+
+        left.len += right.len;
+        left.state = top.state;
+        left.next = right.next;
+        if (right.next >= 0) symbols[right.next].prev = top.left;
+        right.len = 0;
+
+        push_pair(left.prev, top.left);
+        push_pair(top.left, left.next);
+    }
+
+    for (int32_t i = 0; i >= 0; i = symbols[i].next) {
+        const BpeSymbol& symbol = symbols[i];
+        if (symbol.state >= 0 && trie_[symbol.state].value >= 0) {
+            out.push_back(static_cast<uint32_t>(trie_[symbol.state].value));
+        } else {
+            append_unknown(text.data() + symbol.start, symbol.len, out);
         }
-        result.push_back(unk_token_id_);
     }
-    return result;
 }
 
 std::vector<std::string> SPTokenizer::split_with_special_tokens(const std::string& text) const {
     return cactus::engine::split_with_special_tokens(text, special_tokens_);
 }
 
+void SPTokenizer::encode_processed(const std::string& processed, std::vector<uint32_t>& out) const {
+    if (sp_bpe_mode_) {
+        tokenize_with_bpe(processed, out);
+    } else if (sp_unigram_mode_) {
+        tokenize_with_viterbi(processed, out);
+    } else {
+        tokenize_with_trie(processed, out);
+    }
+}
+
+void SPTokenizer::split_processed(const std::string& processed, size_t chunk_bytes,
+                                  std::vector<std::pair<size_t, size_t>>& ranges) const {
+    if (!token_to_id_.count("\xE2\x96\x81")) {
+        ranges.emplace_back(0, processed.size());
+        return;
+    }
+
+    size_t last = 0;
+    size_t prev = 0;
+    size_t prev_len = 0;
+    size_t pos = 0;
+    while (pos < processed.size()) {
+        const size_t lead_len = utf8_lead_len(static_cast<unsigned char>(processed[pos]));
+        const size_t len = lead_len == 0 ? 1 : lead_len;
+        if (pos + len > processed.size()) break;
+
+        if (pos - last >= chunk_bytes && prev_len > 0 && len == 3 &&
+            processed.compare(pos, 3, "\xE2\x96\x81") == 0 &&
+            !space_joiners_.count(decode_codepoint(processed.data() + prev, prev_len))) {
+            ranges.emplace_back(last, pos);
+            last = pos;
+        }
+
+        prev = pos;
+        prev_len = lead_len;
+        pos += len;
+    }
+    ranges.emplace_back(last, processed.size());
+}
+
 std::vector<uint32_t> SPTokenizer::encode(const std::string& text) const {
     if (text.empty()) return {};
 
@@ -446,22 +671,52 @@ std::vector<uint32_t> SPTokenizer::encode(const std::string& text) const {
         } else {
             std::string processed = preprocess_text(segment);
             if (processed.empty()) continue;
-
-            if (sp_bpe_mode_) {
-                auto ids = tokenize_with_bpe(processed);
-                token_ids.insert(token_ids.end(), ids.begin(), ids.end());
-            } else {
-                auto token_pairs = tokenize_with_trie(processed);
-                for (const auto& [token, id] : token_pairs) {
-                    token_ids.push_back(id);
-                }
-            }
+            encode_processed(processed, token_ids);
         }
     }
 
     return token_ids;
 }
 
+std::vector<uint32_t> SPTokenizer::encode_parallel(const std::string& text) const {
+    if (text.size() < 2 * kParallelEncodeChunkBytes) return encode(text);
+
+    const auto text_segments = split_with_special_tokens(text);
+    std::vector<std::string> processed(text_segments.size());
+    struct Chunk {
+        size_t segment;
+        size_t begin;
+        size_t end;
+        int64_t special;
+    };
+    std::vector<Chunk> chunks;
+    std::vector<std::pair<size_t, size_t>> ranges;
+
+    for (size_t i = 0; i < text_segments.size(); ++i) {
+        auto special_it = special_tokens_.find(text_segments[i]);
+        if (special_it != special_tokens_.end()) {
+            chunks.push_back(Chunk{i, 0, 0, special_it->second});
+            continue;
+        }
+        processed[i] = preprocess_text(text_segments[i]);
+        if (processed[i].empty()) continue;
+        ranges.clear();
+        split_processed(processed[i], kParallelEncodeChunkBytes, ranges);
+        for (const auto& [begin, end] : ranges) chunks.push_back(Chunk{i, begin, end, -1});
+    }
+
+    return encode_chunks_parallel(chunks.size(), [&](size_t c, std::vector<uint32_t>& out) {
+        const Chunk& chunk = chunks[c];
+        if (chunk.special >= 0) {
+            out.push_back(static_cast<uint32_t>(chunk.special));
+        } else if (chunk.begin == 0 && chunk.end == processed[chunk.segment].size()) {
+            encode_processed(processed[chunk.segment], out);
+        } else {
+            encode_processed(processed[chunk.segment].substr(chunk.begin, chunk.end - chunk.begin), out);
+        }
+    });
+}
+
 std::string SPTokenizer::decode(const std::vector<uint32_t>& tokens) const {
     if (tokens.size() == 1) {
         if (tokens[0] >= id_to_token_.size()) return {};
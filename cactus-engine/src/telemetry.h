@@ -1,10 +1,13 @@
 #pragma once
 #include <string>
+#include <cstddef>
 #include <cstdint>
 
 namespace cactus {
 namespace telemetry {
 
+enum class DropPolicy { DropNewest, DropOldest, Block };
+
 struct CompletionMetrics {
     bool success;
     bool cloud_handoff;
@@ -37,6 +40,9 @@ void recordStreamTranscription(const char* model, bool success, double ttft_ms,
 void setStreamMode(bool in_stream);
 bool isStreamMode();
 void markInference(bool active);
+void setQueueOptions(size_t capacity, DropPolicy policy);
+void setLocalSink(const char* path);
+uint64_t droppedEventCount();
 void flush();
 void shutdown();
 
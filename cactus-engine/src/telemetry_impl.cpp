@@ -14,6 +14,8 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <memory>
 #include <sys/stat.h>
 #include <sys/utsname.h>
 #include <unistd.h>
@@ -84,7 +86,8 @@ static std::string project_registered_file;
 static bool device_registered = false;
 static bool project_registered = false;
 static bool ids_ready = false;
-static bool in_stream_mode = false;
+static std::atomic<bool> in_stream_mode{false};
+static std::atomic<bool> recording_enabled{false};
 
 static std::mutex telemetry_mutex;
 static std::condition_variable telemetry_lifecycle_cv;
@@ -101,6 +104,10 @@ static bool can_record_event_locked() {
     return enabled && ids_ready && lifecycle_state == TelemetryLifecycleState::Running;
 }
 
+static void refresh_recording_locked() {
+    recording_enabled.store(can_record_event_locked(), std::memory_order_release);
+}
+
 struct CloudSendResult {
     bool payload_ok = false;
     bool project_registered_ok = false;
@@ -131,14 +138,13 @@ struct CloudConfigurationStateSnapshot {
 
 static std::string new_uuid();
 static std::string format_timestamp(const std::chrono::system_clock::time_point& tp);
-static std::string model_basename(const char* model_path) {
-    if (!model_path) return {};
-    std::string m(model_path);
-    size_t pos = m.find_last_of("/\\");
-    if (pos != std::string::npos && pos + 1 < m.size()) {
-        m = m.substr(pos + 1);
+static void copy_model_basename(char* dst, size_t dst_size, const char* model_path) {
+    if (!model_path) return;
+    const char* base = model_path;
+    for (const char* p = model_path; *p; ++p) {
+        if ((*p == '/' || *p == '\\') && p[1] != '\0') base = p + 1;
     }
-    return m;
+    std::strncpy(dst, base, dst_size - 1);
 }
 
 // Forward declarations for helpers used before definition
@@ -151,11 +157,91 @@ static bool extract_double_field(const std::string& line, const std::string& key
 static bool extract_int_field(const std::string& line, const std::string& key, int& out);
 static bool extract_double_field_raw(const std::string& line, const std::string& key, double& out);
 static void process_events(const std::vector<Event>& fresh_events);
+static std::string event_to_json_line(const Event& e, const std::string& app);
 static std::string get_telemetry_dir_locked();
 static CloudConfigurationStateSnapshot capture_cloud_configuration_state_snapshot_locked();
 
+class EventRing {
+public:
+    void reset(size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) rounded <<= 1;
+        if (rounded != capacity_) {
+            slots_.reset(new Slot[rounded]);
+            capacity_ = rounded;
+        }
+        for (size_t i = 0; i < capacity_; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_release);
+    }
+
+    bool try_push(const Event& event) {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & (capacity_ - 1)];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq - pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.event = event;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(Event& out) {
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & (capacity_ - 1)];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = slot.event;
+                    slot.seq.store(pos + capacity_, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t size() const {
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        return head > tail ? static_cast<size_t>(head - tail) : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        Event event;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_ = 0;
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+// Producers only touch the ring and a few atomics; formatting, batching and IO run on the worker.
 class TelemetryDispatcher {
 public:
+    static constexpr size_t kDefaultCapacity = 1024;
+    static constexpr size_t kBatchSize = 64;
+    static constexpr auto kBatchInterval = std::chrono::milliseconds(100);
+
     TelemetryDispatcher() = default;
 
     static TelemetryDispatcher& instance() {
@@ -167,109 +253,162 @@ public:
         return *singleton;
     }
 
+    void configure(size_t capacity, DropPolicy policy) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        requested_capacity_ = capacity > 0 ? capacity : kDefaultCapacity;
+        policy_.store(policy, std::memory_order_relaxed);
+    }
+
     void start() {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        if (running_) return;
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        if (running_.load(std::memory_order_relaxed)) return;
+        while (producers_.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+        ring_.reset(requested_capacity_);
         stop_ = false;
-        processing_ = false;
-        running_ = true;
+        accepted_.store(0, std::memory_order_relaxed);
+        retired_.store(0, std::memory_order_relaxed);
+        running_.store(true, std::memory_order_release);
         worker_thread_ = std::thread([this] { worker_loop(); });
     }
 
     bool enqueue(const Event& event) {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        if (!running_) return false;
-        pending_events_.push_back(event);
-        enqueue_seq_ += 1;
-        queue_cv_.notify_one();
-        return true;
+        producers_.fetch_add(1, std::memory_order_acq_rel);
+        bool accepted = false;
+        if (running_.load(std::memory_order_acquire)) {
+            accepted = push(event);
+        }
+        producers_.fetch_sub(1, std::memory_order_release);
+        return accepted;
     }
 
     void flush() {
-        uint64_t target = 0;
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (running_) {
-                target = enqueue_seq_;
-                queue_cv_.notify_one();
-                flush_cv_.wait(lock, [this, target] {
-                    return processed_seq_ >= target && !processing_;
-                });
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            const uint64_t target = accepted_.load(std::memory_order_acquire);
+            flush_waiters_ += 1;
+            while (running_.load(std::memory_order_acquire) &&
+                   retired_.load(std::memory_order_acquire) < target) {
+                wake_cv_.notify_one();
+                flush_cv_.wait_for(lock, kBatchInterval);
             }
+            flush_waiters_ -= 1;
         }
         process_with_io_lock({});
     }
 
     void stop() {
         {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
+            std::lock_guard<std::mutex> lock(wake_mutex_);
             stop_ = true;
-            queue_cv_.notify_all();
+            running_.store(false, std::memory_order_release);
+            wake_cv_.notify_all();
         }
 
         if (worker_thread_.joinable()) {
             worker_thread_.join();
         }
 
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        running_ = false;
+        std::lock_guard<std::mutex> lock(wake_mutex_);
         stop_ = false;
-        processing_ = false;
-        pending_events_.clear();
-        enqueue_seq_ = 0;
-        processed_seq_ = 0;
     }
 
+    void set_local_sink(const std::string& path) {
+        std::lock_guard<std::mutex> io_guard(io_mutex_);
+        sink_path_ = path;
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
 private:
+    bool push(const Event& event) {
+        while (!ring_.try_push(event)) {
+            switch (policy_.load(std::memory_order_relaxed)) {
+                case DropPolicy::DropNewest:
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                case DropPolicy::DropOldest: {
+                    Event evicted;
+                    if (ring_.try_pop(evicted)) {
+                        dropped_.fetch_add(1, std::memory_order_relaxed);
+                        retired_.fetch_add(1, std::memory_order_acq_rel);
+                    }
+                    break;
+                }
+                case DropPolicy::Block:
+                    // A full ring during stop() has no consumer left to drain it.
+                    if (stop_.load(std::memory_order_acquire) || !running_.load(std::memory_order_acquire)) {
+                        dropped_.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    wake_cv_.notify_one();
+                    std::this_thread::yield();
+                    break;
+            }
+        }
+        accepted_.fetch_add(1, std::memory_order_acq_rel);
+        if (ring_.size() == kBatchSize) wake_cv_.notify_one();
+        return true;
+    }
+
     void process_with_io_lock(const std::vector<Event>& batch) {
         std::lock_guard<std::mutex> io_guard(io_mutex_);
+        if (!sink_path_.empty() && !batch.empty()) {
+            std::string app;
+            {
+                std::lock_guard<std::mutex> guard(telemetry_mutex);
+                app = app_id;
+            }
+            std::ofstream out(sink_path_, std::ios::app);
+            if (out.is_open()) {
+                for (const auto& e : batch) out << event_to_json_line(e, app) << "\n";
+            }
+        }
         process_events(batch);
     }
 
     void worker_loop() {
+        std::vector<Event> batch;
+        batch.reserve(kBatchSize);
         while (true) {
-            std::vector<Event> batch;
-            uint64_t processed_count = 0;
+            bool stopping = false;
             {
-                std::unique_lock<std::mutex> lock(queue_mutex_);
-                queue_cv_.wait(lock, [this] {
-                    return stop_ || !pending_events_.empty();
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                wake_cv_.wait_for(lock, kBatchInterval, [this] {
+                    return stop_ || ring_.size() >= kBatchSize || (flush_waiters_ > 0 && ring_.size() > 0);
                 });
-                if (stop_ && pending_events_.empty()) {
-                    break;
-                }
-                batch.assign(pending_events_.begin(), pending_events_.end());
-                processed_count = static_cast<uint64_t>(batch.size());
-                pending_events_.clear();
-                processing_ = true;
+                stopping = stop_;
             }
 
-            process_with_io_lock(batch);
+            batch.clear();
+            Event event;
+            while (ring_.try_pop(event)) batch.push_back(event);
+            if (!batch.empty()) process_with_io_lock(batch);
 
             {
-                std::lock_guard<std::mutex> lock(queue_mutex_);
-                processed_seq_ += processed_count;
-                processing_ = false;
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                retired_.fetch_add(batch.size(), std::memory_order_acq_rel);
                 flush_cv_.notify_all();
             }
+            if (stopping && ring_.size() == 0) break;
         }
-
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        running_ = false;
-        processing_ = false;
-        flush_cv_.notify_all();
     }
-    std::mutex queue_mutex_;
+
+    EventRing ring_;
+    std::mutex wake_mutex_;
     std::mutex io_mutex_;
-    std::condition_variable queue_cv_;
+    std::condition_variable wake_cv_;
     std::condition_variable flush_cv_;
-    std::deque<Event> pending_events_;
     std::thread worker_thread_;
-    bool stop_ = false;
-    bool running_ = false;
-    bool processing_ = false;
-    uint64_t enqueue_seq_ = 0;
-    uint64_t processed_seq_ = 0;
+    std::string sink_path_;
+    size_t requested_capacity_ = kDefaultCapacity;
+    int flush_waiters_ = 0;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> running_{false};
+    std::atomic<DropPolicy> policy_{DropPolicy::DropNewest};
+    std::atomic<int> producers_{0};
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> retired_{0};
+    std::atomic<uint64_t> dropped_{0};
 };
 
 static void mkdir_p(const std::string& path) {
@@ -397,8 +536,7 @@ static Event make_event(EventType type, const char* model, bool success, double
     std::memset(e.message, 0, sizeof(e.message));
     std::memset(e.error, 0, sizeof(e.error));
     std::memset(e.function_calls, 0, sizeof(e.function_calls));
-    std::string safe_model = model_basename(model);
-    if (!safe_model.empty()) std::strncpy(e.model, safe_model.c_str(), sizeof(e.model)-1);
+    copy_model_basename(e.model, sizeof(e.model), model);
     if (message) std::strncpy(e.message, message, sizeof(e.message)-1);
     return e;
 }
@@ -427,8 +565,7 @@ static Event make_event_extended(EventType type, const char* model, const Comple
     std::memset(e.message, 0, sizeof(e.message));
     std::memset(e.error, 0, sizeof(e.error));
     std::memset(e.function_calls, 0, sizeof(e.function_calls));
-    std::string safe_model = model_basename(model);
-    if (!safe_model.empty()) std::strncpy(e.model, safe_model.c_str(), sizeof(e.model)-1);
+    copy_model_basename(e.model, sizeof(e.model), model);
     if (!metrics.success && metrics.error_message) std::strncpy(e.error, metrics.error_message, sizeof(e.error)-1);
     if (metrics.function_calls_json) std::strncpy(e.function_calls, metrics.function_calls_json, sizeof(e.function_calls)-1);
     return e;
@@ -1103,76 +1240,80 @@ static void trim_cache_file(const std::string& file, size_t max_lines) {
     for (const auto& line : lines) out << line << "\n";
 }
 
+static std::string event_to_json_line(const Event& e, const std::string& app) {
+    std::ostringstream oss;
+    oss << "{\"event_type\":\"" << event_type_to_string(e.type) << "\",";
+    oss << "\"model\":\"" << escape_json_string(e.model) << "\",";
+    oss << "\"success\":" << (e.success ? "true" : "false") << ",";
+    oss << "\"cloud_handoff\":" << (e.cloud_handoff ? "true" : "false") << ",";
+    if (e.type == INIT || !e.success) {
+        oss << "\"ttft\":null,";
+        oss << "\"prefill_tps\":null,";
+        oss << "\"decode_tps\":null,";
+        oss << "\"tps\":null,";
+    } else {
+        oss << "\"ttft\":" << e.ttft_ms << ",";
+        oss << "\"prefill_tps\":" << e.prefill_tps << ",";
+        oss << "\"decode_tps\":" << e.decode_tps << ",";
+        oss << "\"tps\":" << e.tps << ",";
+    }
+    if (!e.success) {
+        oss << "\"response_time\":null,";
+        oss << "\"ram_usage_mb\":null,";
+    } else {
+        oss << "\"response_time\":" << e.response_time_ms << ",";
+        oss << "\"ram_usage_mb\":" << e.ram_usage_mb << ",";
+    }
+    if (e.type == INIT || !e.success) {
+        oss << "\"confidence\":null,";
+        oss << "\"tokens\":null,";
+        oss << "\"prefill_tokens\":null,";
+        oss << "\"decode_tokens\":null,";
+    } else {
+        oss << "\"confidence\":" << e.confidence << ",";
+        oss << "\"tokens\":" << e.tokens << ",";
+        oss << "\"prefill_tokens\":" << e.prefill_tokens << ",";
+        oss << "\"decode_tokens\":" << e.decode_tokens << ",";
+    }
+    if (e.type == STREAM_TRANSCRIBE) {
+        oss << "\"session_ttft\":" << e.session_ttft_ms << ",";
+        oss << "\"session_tps\":" << e.session_tps << ",";
+        oss << "\"session_time_ms\":" << e.session_time_ms << ",";
+        oss << "\"session_tokens\":" << e.session_tokens;
+    } else {
+        oss << "\"session_ttft\":null,";
+        oss << "\"session_tps\":null,";
+        oss << "\"session_time_ms\":null,";
+        oss << "\"session_tokens\":null";
+    }
+    oss << ",\"ts_ms\":" << std::chrono::duration_cast<std::chrono::milliseconds>(e.timestamp.time_since_epoch()).count();
+    if (e.message[0] != '\0') {
+        oss << ",\"message\":\"" << escape_json_string(e.message) << "\"";
+    } else {
+        oss << ",\"message\":null";
+    }
+    if (e.error[0] != '\0') {
+        oss << ",\"error\":\"" << escape_json_string(e.error) << "\"";
+    } else {
+        oss << ",\"error\":null";
+    }
+    oss << ",\"function_calls\":null";
+    if (!app.empty()) {
+        oss << ",\"app_id\":\"" << escape_json_string(app.c_str()) << "\"";
+    } else {
+        oss << ",\"app_id\":null";
+    }
+    oss << "}";
+    return oss.str();
+}
+
 static void write_events_to_cache_in_dir(const std::vector<Event>& local, const std::string& dir) {
     std::vector<std::string> touched_files;
     for (const auto &e : local) {
-        std::ostringstream oss;
-        oss << "{\"event_type\":\"" << event_type_to_string(e.type) << "\",";
-        oss << "\"model\":\"" << escape_json_string(e.model) << "\",";
-        oss << "\"success\":" << (e.success ? "true" : "false") << ",";
-        oss << "\"cloud_handoff\":" << (e.cloud_handoff ? "true" : "false") << ",";
-        if (e.type == INIT || !e.success) {
-            oss << "\"ttft\":null,";
-            oss << "\"prefill_tps\":null,";
-            oss << "\"decode_tps\":null,";
-            oss << "\"tps\":null,";
-        } else {
-            oss << "\"ttft\":" << e.ttft_ms << ",";
-            oss << "\"prefill_tps\":" << e.prefill_tps << ",";
-            oss << "\"decode_tps\":" << e.decode_tps << ",";
-            oss << "\"tps\":" << e.tps << ",";
-        }
-        if (!e.success) {
-            oss << "\"response_time\":null,";
-            oss << "\"ram_usage_mb\":null,";
-        } else {
-            oss << "\"response_time\":" << e.response_time_ms << ",";
-            oss << "\"ram_usage_mb\":" << e.ram_usage_mb << ",";
-        }
-        if (e.type == INIT || !e.success) {
-            oss << "\"confidence\":null,";
-            oss << "\"tokens\":null,";
-            oss << "\"prefill_tokens\":null,";
-            oss << "\"decode_tokens\":null,";
-        } else {
-            oss << "\"confidence\":" << e.confidence << ",";
-            oss << "\"tokens\":" << e.tokens << ",";
-            oss << "\"prefill_tokens\":" << e.prefill_tokens << ",";
-            oss << "\"decode_tokens\":" << e.decode_tokens << ",";
-        }
-        if (e.type == STREAM_TRANSCRIBE) {
-            oss << "\"session_ttft\":" << e.session_ttft_ms << ",";
-            oss << "\"session_tps\":" << e.session_tps << ",";
-            oss << "\"session_time_ms\":" << e.session_time_ms << ",";
-            oss << "\"session_tokens\":" << e.session_tokens;
-        } else {
-            oss << "\"session_ttft\":null,";
-            oss << "\"session_tps\":null,";
-            oss << "\"session_time_ms\":null,";
-            oss << "\"session_tokens\":null";
-        }
-        oss << ",\"ts_ms\":" << std::chrono::duration_cast<std::chrono::milliseconds>(e.timestamp.time_since_epoch()).count();
-        if (e.message[0] != '\0') {
-            oss << ",\"message\":\"" << escape_json_string(e.message) << "\"";
-        } else {
-            oss << ",\"message\":null";
-        }
-        if (e.error[0] != '\0') {
-            oss << ",\"error\":\"" << escape_json_string(e.error) << "\"";
-        } else {
-            oss << ",\"error\":null";
-        }
-        oss << ",\"function_calls\":null";
-        if (!app_id.empty()) {
-            oss << ",\"app_id\":\"" << escape_json_string(app_id.c_str()) << "\"";
-        } else {
-            oss << ",\"app_id\":null";
-        }
-        oss << "}";
         std::string file = dir + "/" + event_type_to_string(e.type) + ".log";
         std::ofstream out(file, std::ios::app);
         if (out.is_open()) {
-            out << oss.str() << "\n";
+            out << event_to_json_line(e, app_id) << "\n";
             out.close();
         }
         bool seen = false;
@@ -1289,6 +1430,10 @@ static void process_events(const std::vector<Event>& fresh_events) {
 }
 
 void init(const char* project_id_param, const char* project_scope_param, const char* cloud_key_param) {
+    // The worker takes the dispatcher IO lock before telemetry_mutex; set the sink before taking it.
+    const char* env_sink = std::getenv("CACTUS_TELEMETRY_SINK");
+    if (env_sink && *env_sink) TelemetryDispatcher::instance().set_local_sink(env_sink);
+
     std::unique_lock<std::mutex> lifecycle_guard(telemetry_mutex);
     telemetry_lifecycle_cv.wait(lifecycle_guard, [] {
         return lifecycle_state != TelemetryLifecycleState::ShuttingDown;
@@ -1369,11 +1514,13 @@ void init(const char* project_id_param, const char* project_scope_param, const c
     enabled = true;
     lifecycle_state = TelemetryLifecycleState::Running;
     TelemetryDispatcher::instance().start();
+    refresh_recording_locked();
 }
 
 void setEnabled(bool en) {
     std::lock_guard<std::mutex> guard(telemetry_mutex);
     enabled = en;
+    refresh_recording_locked();
 }
 
 void setCloudDisabled(bool disabled) {
@@ -1432,62 +1579,54 @@ std::string loadCachedCloudApiKey() {
 }
 
 void recordInit(const char* model, bool success, double response_time_ms, const char* message) {
+    if (!recording_enabled.load(std::memory_order_acquire)) return;
     double nan = std::numeric_limits<double>::quiet_NaN();
     Event e = make_event(INIT, model, success, nan, nan, response_time_ms, 0, message);
-    std::lock_guard<std::mutex> guard(telemetry_mutex);
-    if (!can_record_event_locked()) return;
     TelemetryDispatcher::instance().enqueue(e);
 }
 
 void recordCompletion(const char* model, const CompletionMetrics& metrics) {
+    if (!recording_enabled.load(std::memory_order_acquire)) return;
     Event e = make_event_extended(COMPLETION, model, metrics);
-    std::lock_guard<std::mutex> guard(telemetry_mutex);
-    if (!can_record_event_locked()) return;
     TelemetryDispatcher::instance().enqueue(e);
 }
 
 void recordCompletion(const char* model, bool success, double ttft_ms, double tps, double response_time_ms, int tokens, const char* message) {
+    if (!recording_enabled.load(std::memory_order_acquire)) return;
     Event e = make_event(COMPLETION, model, success, ttft_ms, tps, response_time_ms, tokens, message);
-    std::lock_guard<std::mutex> guard(telemetry_mutex);
-    if (!can_record_event_locked()) return;
     TelemetryDispatcher::instance().enqueue(e);
 }
 
 void recordEmbedding(const char* model, bool success, const char* message) {
+    if (!recording_enabled.load(std::memory_order_acquire)) return;
     Event e = make_event(EMBEDDING, model, success, 0.0, 0.0, 0.0, 0, message);
-    std::lock_guard<std::mutex> guard(telemetry_mutex);
-    if (!can_record_event_locked()) return;
     TelemetryDispatcher::instance().enqueue(e);
 }
 
 void recordTranscription(const char* model, bool success, double ttft_ms, double tps, double response_time_ms, int tokens, double ram_usage_mb, const char* message) {
-    std::lock_guard<std::mutex> guard(telemetry_mutex);
-    if (in_stream_mode) return;
+    if (in_stream_mode.load(std::memory_order_relaxed)) return;
+    if (!recording_enabled.load(std::memory_order_acquire)) return;
     Event e = make_event(TRANSCRIPTION, model, success, ttft_ms, tps, response_time_ms, tokens, message);
     e.ram_usage_mb = ram_usage_mb;
-    if (!can_record_event_locked()) return;
     TelemetryDispatcher::instance().enqueue(e);
 }
 
 void recordStreamTranscription(const char* model, bool success, double ttft_ms, double tps, double response_time_ms, int tokens, double session_ttft_ms, double session_tps, double session_time_ms, int session_tokens, const char* message) {
+    if (!recording_enabled.load(std::memory_order_acquire)) return;
     Event e = make_event(STREAM_TRANSCRIBE, model, success, ttft_ms, tps, response_time_ms, tokens, message);
     e.session_ttft_ms = session_ttft_ms;
     e.session_tps = session_tps;
     e.session_time_ms = session_time_ms;
     e.session_tokens = session_tokens;
-    std::lock_guard<std::mutex> guard(telemetry_mutex);
-    if (!can_record_event_locked()) return;
     TelemetryDispatcher::instance().enqueue(e);
 }
 
 void setStreamMode(bool in_stream) {
-    std::lock_guard<std::mutex> guard(telemetry_mutex);
-    in_stream_mode = in_stream;
+    in_stream_mode.store(in_stream, std::memory_order_relaxed);
 }
 
 bool isStreamMode() {
-    std::lock_guard<std::mutex> guard(telemetry_mutex);
-    return in_stream_mode;
+    return in_stream_mode.load(std::memory_order_relaxed);
 }
 
 void markInference(bool active) {
@@ -1499,6 +1638,18 @@ void markInference(bool active) {
     }
 }
 
+void setQueueOptions(size_t capacity, DropPolicy policy) {
+    TelemetryDispatcher::instance().configure(capacity, policy);
+}
+
+void setLocalSink(const char* path) {
+    TelemetryDispatcher::instance().set_local_sink(path ? path : "");
+}
+
+uint64_t droppedEventCount() {
+    return TelemetryDispatcher::instance().dropped();
+}
+
 void flush() {
     TelemetryDispatcher::instance().flush();
 }
@@ -1512,6 +1663,7 @@ void shutdown() {
 
         shutdown_called = true;
         lifecycle_state = TelemetryLifecycleState::ShuttingDown;
+        refresh_recording_locked();
     }
 
     flush();
@@ -1520,6 +1672,7 @@ void shutdown() {
         std::lock_guard<std::mutex> lifecycle_guard(telemetry_mutex);
         enabled = false;
         ids_ready = false;
+        refresh_recording_locked();
     }
 
     TelemetryDispatcher::instance().stop();
@@ -350,6 +350,21 @@ std::vector<std::string> split_with_special_tokens(const std::string& text,
     return result;
 }
 
+std::vector<uint32_t> Tokenizer::encode_chunks_parallel(size_t num_chunks,
+    const std::function<void(size_t, std::vector<uint32_t>&)>& encode_chunk) {
+    std::vector<std::vector<uint32_t>> chunk_ids(num_chunks);
+    CactusThreading::parallel_for(num_chunks, CactusThreading::ParallelConfig{2, 1}, [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; ++i) encode_chunk(i, chunk_ids[i]);
+    });
+
+    size_t total = 0;
+    for (const auto& ids : chunk_ids) total += ids.size();
+    std::vector<uint32_t> token_ids;
+    token_ids.reserve(total);
+    for (const auto& ids : chunk_ids) token_ids.insert(token_ids.end(), ids.begin(), ids.end());
+    return token_ids;
+}
+
 void Tokenizer::load_chat_template(const std::string& template_file) {
     std::ifstream file(template_file);
     if (!file.is_open()) {
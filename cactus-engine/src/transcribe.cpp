@@ -334,6 +334,7 @@ int cactus_transcribe(
         std::vector<TranscriptSegment> segments;
         std::vector<uint32_t> generated_tokens;
         generated_tokens.reserve(options.max_tokens);
+        std::vector<std::string> n_best_texts;
         const size_t prompt_tokens = tokens.size();
         double time_to_first_token = 0.0;
         float total_entropy_sum = 0.0f;
@@ -352,23 +353,52 @@ int cactus_transcribe(
                 }
             }
         } else if (is_whisper) {
-            generated_tokens = handle->model->transcribe_whisper_seq2seq(
-                audio_features,
-                tokens,
-                options.max_tokens,
-                stop_token_sequences,
-                &handle->should_stop,
-                want_timestamps ? static_cast<int64_t>(ts_begin) - 1 : -1);
+            const int64_t suppress_token_id = want_timestamps ? static_cast<int64_t>(ts_begin) - 1 : -1;
+            auto strip_stop_suffix = [&](std::vector<uint32_t>& seq_tokens) {
+                for (const auto& stop_seq : stop_token_sequences) {
+                    if (stop_seq.empty() || seq_tokens.size() < stop_seq.size()) continue;
+                    if (std::equal(stop_seq.rbegin(), stop_seq.rend(), seq_tokens.rbegin())) {
+                        seq_tokens.resize(seq_tokens.size() - stop_seq.size());
+                        break;
+                    }
+                }
+            };
+            std::vector<cactus::engine::Model::BeamHypothesis> beams;
+            if (wants_beam_search(options)) {
+                beams = handle->model->transcribe_whisper_beam(
+                    audio_features, tokens, beam_search_options(options), stop_token_sequences,
+                    &handle->should_stop, suppress_token_id);
+                if (beams.empty()) {
+                    CACTUS_LOG_WARN("transcribe", "Beam search needs a KV-cache decoder step; decoding greedily");
+                }
+            }
+            if (!beams.empty()) {
+                generated_tokens = beams.front().tokens;
+                if (beams.size() > 1) {
+                    for (auto& hyp : beams) {
+                        strip_stop_suffix(hyp.tokens);
+                        std::vector<uint32_t> text_tokens;
+                        for (uint32_t tok : hyp.tokens) {
+                            if (!want_timestamps || tok < ts_begin) text_tokens.push_back(tok);
+                        }
+                        std::string text = tokenizer->decode(text_tokens);
+                        if (!text.empty() && text[0] == ' ') text.erase(0, 1);
+                        n_best_texts.push_back(std::move(text));
+                    }
+                }
+            } else {
+                generated_tokens = handle->model->transcribe_whisper_seq2seq(
+                    audio_features,
+                    tokens,
+                    options.max_tokens,
+                    stop_token_sequences,
+                    &handle->should_stop,
+                    suppress_token_id);
+            }
             auto t_first = std::chrono::high_resolution_clock::now();
             time_to_first_token =
                 std::chrono::duration_cast<std::chrono::microseconds>(t_first - start_time).count() / 1000.0;
-            for (const auto& stop_seq : stop_token_sequences) {
-                if (stop_seq.empty() || generated_tokens.size() < stop_seq.size()) continue;
-                if (std::equal(stop_seq.rbegin(), stop_seq.rend(), generated_tokens.rbegin())) {
-                    generated_tokens.resize(generated_tokens.size() - stop_seq.size());
-                    break;
-                }
-            }
+            strip_stop_suffix(generated_tokens);
             if (want_timestamps) {
                 segments = parse_whisper_timestamp_segments(tokenizer, generated_tokens, ts_begin, final_text);
             } else {
@@ -508,7 +538,7 @@ int cactus_transcribe(
             final_text, {}, time_to_first_token, total_time_ms,
             prefill_tps, decode_tps, prompt_tokens, completion_tokens,
             confidence, cloud_handoff_used, "", segments, "",
-            reported_threshold, handoff_reason);
+            reported_threshold, handoff_reason, n_best_texts);
         if (json.size() >= buffer_size) {
             handle_error_response("Response buffer too small", response_buffer, buffer_size);
             return -1;
@@ -513,6 +513,11 @@ struct InferenceOptions {
     size_t max_tokens = 100;
     size_t tool_rag_top_k = 2;
     size_t cloud_timeout_ms = 15000;
+    size_t beam_size = 1;
+    size_t n_best = 1;
+    float length_penalty = 1.0f;
+    float logprob_threshold = -1.0f;
+    std::vector<float> temperature_fallback;
     std::vector<std::string> stop_sequences;
     bool force_tools = false;
     bool include_stop_sequences = false;
@@ -522,6 +527,8 @@ struct InferenceOptions {
     bool auto_handoff = true;
     bool handoff_with_images = true;
     bool enable_thinking_if_supported = false;
+    std::string grammar;
+    std::string json_schema;
 };
 
 } // namespace ffi
@@ -638,13 +645,14 @@ inline std::string json_string_field(const std::string& json, const std::string&
     return {};
 }
 
-inline std::string json_array_field(const std::string& json, const std::string& key) {
+inline std::string json_bracketed_field(const std::string& json, const std::string& key,
+                                       char open, char close, const std::string& fallback) {
     std::string pattern = "\"" + key + "\":";
     size_t pos = json.find(pattern);
-    if (pos == std::string::npos) return "[]";
+    if (pos == std::string::npos) return fallback;
     size_t start = pos + pattern.size();
     while (start < json.size() && std::isspace(static_cast<unsigned char>(json[start]))) ++start;
-    if (start >= json.size() || json[start] != '[') return "[]";
+    if (start >= json.size() || json[start] != open) return fallback;
 
     int depth = 1;
     size_t end = start + 1;
@@ -657,9 +665,9 @@ inline std::string json_array_field(const std::string& json, const std::string&
             else if (c == '"') in_string = false;
         } else if (c == '"') {
             in_string = true;
-        } else if (c == '[') {
+        } else if (c == open) {
             depth++;
-        } else if (c == ']') {
+        } else if (c == close) {
             depth--;
         }
         end++;
@@ -667,6 +675,14 @@ inline std::string json_array_field(const std::string& json, const std::string&
     return json.substr(start, end - start);
 }
 
+inline std::string json_array_field(const std::string& json, const std::string& key) {
+    return json_bracketed_field(json, key, '[', ']', "[]");
+}
+
+inline std::string json_object_field(const std::string& json, const std::string& key) {
+    return json_bracketed_field(json, key, '{', '}', "");
+}
+
 inline std::vector<std::string> split_json_array(const std::string& array_json) {
     std::vector<std::string> out;
     if (array_json.size() < 2 || array_json.front() != '[' || array_json.back() != ']') return out;
@@ -1701,6 +1717,43 @@ inline InferenceOptions parse_inference_options_json(const std::string& json) {
         options.enable_thinking_if_supported = (json.substr(pos, 4) == "true");
     }
 
+    options.grammar = json_string_field(json, "grammar");
+    options.json_schema = json_object_field(json, "json_schema");
+
+    size_t parsed_beam_size = options.beam_size;
+    if (try_parse_json_uint(json, "beam_size", parsed_beam_size)) {
+        options.beam_size = std::max<size_t>(parsed_beam_size, 1);
+    }
+
+    size_t parsed_n_best = options.n_best;
+    if (try_parse_json_uint(json, "n_best", parsed_n_best)) {
+        options.n_best = std::max<size_t>(parsed_n_best, 1);
+    }
+
+    float parsed_length_penalty = options.length_penalty;
+    if (try_parse_json_float(json, "length_penalty", parsed_length_penalty) && std::isfinite(parsed_length_penalty)) {
+        options.length_penalty = parsed_length_penalty;
+    }
+
+    float parsed_logprob_threshold = options.logprob_threshold;
+    if (try_parse_json_float(json, "logprob_threshold", parsed_logprob_threshold)) {
+        options.logprob_threshold = parsed_logprob_threshold;
+    }
+
+    pos = json.find("\"temperature_fallback\"");
+    if (pos != std::string::npos) {
+        pos = json.find('[', pos);
+        size_t end_pos = pos == std::string::npos ? pos : json.find(']', pos);
+        while (pos != std::string::npos && pos < end_pos) {
+            size_t num_pos = json.find_first_of("0123456789.-", pos + 1);
+            if (num_pos == std::string::npos || num_pos >= end_pos) break;
+            size_t consumed = 0;
+            float value = std::stof(json.substr(num_pos, end_pos - num_pos), &consumed);
+            if (std::isfinite(value) && value >= 0.0f) options.temperature_fallback.push_back(value);
+            pos = num_pos + consumed;
+        }
+    }
+
     pos = json.find("\"stop_sequences\"");
     if (pos != std::string::npos) {
         pos = json.find('[', pos);
@@ -1722,6 +1775,26 @@ inline InferenceOptions parse_inference_options_json(const std::string& json) {
     return options;
 }
 
+// Requests that ask for neither beams, alternatives nor a fallback schedule stay on the streaming
+// greedy path. The fallback schedule always starts at the request temperature.
+inline bool wants_beam_search(const InferenceOptions& options) {
+    return options.beam_size > 1 || options.n_best > 1 || !options.temperature_fallback.empty();
+}
+
+inline cactus::engine::Model::BeamSearchOptions beam_search_options(const InferenceOptions& options) {
+    cactus::engine::Model::BeamSearchOptions beam;
+    beam.beam_size = std::max(options.beam_size, options.n_best);
+    beam.n_best = options.n_best;
+    beam.max_tokens = options.max_tokens;
+    beam.length_penalty = options.length_penalty;
+    beam.temperatures = {std::max(0.0f, options.temperature)};
+    for (float t : options.temperature_fallback) {
+        if (t > beam.temperatures.back()) beam.temperatures.push_back(t);
+    }
+    beam.logprob_threshold = options.logprob_threshold;
+    return beam;
+}
+
 inline void parse_function_calls_from_response(const std::string& response_text,
                                                std::string& regular_response,
                                                std::vector<std::string>& function_calls,
@@ -1911,7 +1984,8 @@ inline std::string construct_response_json(const std::string& regular_response,
                                            const std::vector<TranscriptSegment>& segments = {},
                                            const std::string& context_response = "",
                                            float confidence_threshold = -1.0f,
-                                           const std::string& cloud_handoff_reason = "") {
+                                           const std::string& cloud_handoff_reason = "",
+                                           const std::vector<std::string>& n_best = {}) {
     std::ostringstream json;
     json << "{";
     json << "\"success\":true,";
@@ -1939,6 +2013,14 @@ inline std::string construct_response_json(const std::string& regular_response,
              << ",\"text\":\"" << escape_json_string(segments[i].text) << "\"}";
     }
     json << "],";
+    if (!n_best.empty()) {
+        json << "\"n_best\":[";
+        for (size_t i = 0; i < n_best.size(); ++i) {
+            if (i > 0) json << ",";
+            json << "\"" << escape_json_string(n_best[i]) << "\"";
+        }
+        json << "],";
+    }
     json << "\"confidence\":" << std::fixed << std::setprecision(4) << confidence << ",";
     json << "\"confidence_threshold\":" << std::fixed << std::setprecision(4) << confidence_threshold << ",";
     json << "\"time_to_first_token_ms\":" << std::fixed << std::setprecision(2) << time_to_first_token << ",";
@@ -0,0 +1,288 @@
+#include "vision_cache.h"
+#include "cactus_graph.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace cactus {
+namespace engine {
+
+namespace {
+
+constexpr uint32_t VISION_CACHE_MAGIC = 0x43465643;  // "CVFC"
+constexpr uint32_t VISION_CACHE_VERSION = 1;
+// Vision encoders expose a handful of outputs; a larger count means a corrupt header.
+constexpr uint32_t VISION_CACHE_MAX_OUTPUTS = 64;
+
+inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+struct ContentHasher {
+    uint64_t h1;
+    uint64_t h2;
+    uint64_t length = 0;
+    uint8_t tail[16] = {};
+    size_t tail_len = 0;
+
+    explicit ContentHasher(uint64_t seed) : h1(seed), h2(seed ^ 0x6a09e667f3bcc908ULL) {}
+
+    void block(const uint8_t* p) {
+        uint64_t k1, k2;
+        std::memcpy(&k1, p, 8);
+        std::memcpy(&k2, p + 8, 8);
+        k1 *= 0x87c37b91114253d5ULL; k1 = rotl64(k1, 31); k1 *= 0x4cf5ad432745937fULL; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= 0x4cf5ad432745937fULL; k2 = rotl64(k2, 33); k2 *= 0x87c37b91114253d5ULL; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    void update(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        length += size;
+        if (tail_len > 0) {
+            const size_t take = std::min(size, sizeof(tail) - tail_len);
+            std::memcpy(tail + tail_len, p, take);
+            tail_len += take;
+            p += take;
+            size -= take;
+            if (tail_len < sizeof(tail)) return;
+            block(tail);
+            tail_len = 0;
+        }
+        for (; size >= 16; p += 16, size -= 16) block(p);
+        std::memcpy(tail, p, size);
+        tail_len = size;
+    }
+
+    VisionCacheKey finish() {
+        std::memset(tail + tail_len, 0, sizeof(tail) - tail_len);
+        tail[15] = static_cast<uint8_t>(tail_len);
+        block(tail);
+        h1 ^= length;
+        h2 ^= length;
+        h1 += h2;
+        h2 += h1;
+        h1 = fmix64(h1);
+        h2 = fmix64(h2);
+        h1 += h2;
+        h2 += h1;
+        return VisionCacheKey{h1, h2};
+    }
+};
+
+template <typename T>
+void write_pod(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_pod(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+} // namespace
+
+std::string VisionCacheKey::hex() const {
+    char buf[33];
+    std::snprintf(buf, sizeof(buf), "%016llx%016llx",
+                  static_cast<unsigned long long>(hi), static_cast<unsigned long long>(lo));
+    return std::string(buf);
+}
+
+size_t VisionCacheEntry::byte_size() const {
+    size_t total = sizeof(VisionCacheEntry);
+    for (const auto& out : outputs) total += out.bytes.size() + out.name.size() + out.shape.size() * sizeof(size_t);
+    return total;
+}
+
+void VisionFeatureCache::configure(size_t max_bytes, const std::string& disk_dir, const std::string& salt) {
+    max_bytes_ = max_bytes;
+    disk_dir_ = disk_dir;
+    ContentHasher hasher(0);
+    hasher.update(salt.data(), salt.size());
+    salt_ = hasher.finish().hi;
+    if (!disk_dir_.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(disk_dir_, ec);
+        if (ec) disk_dir_.clear();
+    }
+    evict_to_budget();
+}
+
+bool VisionFeatureCache::key_for_file(const std::string& path, VisionCacheKey& out) const {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+    ContentHasher hasher(salt_);
+    std::vector<char> buf(1 << 16);
+    while (in) {
+        in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        const std::streamsize got = in.gcount();
+        if (got <= 0) break;
+        hasher.update(buf.data(), static_cast<size_t>(got));
+    }
+    if (in.bad()) return false;
+    out = hasher.finish();
+    return true;
+}
+
+bool VisionFeatureCache::key_for_bytes(const void* data, size_t size, VisionCacheKey& out) const {
+    if (!data && size > 0) return false;
+    ContentHasher hasher(salt_);
+    hasher.update(data, size);
+    out = hasher.finish();
+    return true;
+}
+
+std::shared_ptr<const VisionCacheEntry> VisionFeatureCache::find(const VisionCacheKey& key) {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+        hits_++;
+        return it->second.entry;
+    }
+    if (!disk_dir_.empty()) {
+        if (auto entry = load_from_disk(key)) {
+            hits_++;
+            disk_hits_++;
+            insert_resident(key, entry);
+            return entry;
+        }
+    }
+    misses_++;
+    return nullptr;
+}
+
+void VisionFeatureCache::insert(const VisionCacheKey& key, VisionCacheEntry entry) {
+    if (!enabled() || entry.outputs.empty()) return;
+    auto shared = std::make_shared<const VisionCacheEntry>(std::move(entry));
+    if (!disk_dir_.empty()) store_to_disk(key, *shared);
+    insert_resident(key, std::move(shared));
+}
+
+void VisionFeatureCache::clear() {
+    entries_.clear();
+    lru_.clear();
+    resident_bytes_ = 0;
+}
+
+void VisionFeatureCache::insert_resident(const VisionCacheKey& key, std::shared_ptr<const VisionCacheEntry> entry) {
+    const size_t bytes = entry->byte_size();
+    if (bytes > max_bytes_) return;
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        resident_bytes_ -= it->second.entry->byte_size();
+        lru_.erase(it->second.lru_it);
+        entries_.erase(it);
+    }
+    lru_.push_front(key);
+    entries_[key] = Slot{std::move(entry), lru_.begin()};
+    resident_bytes_ += bytes;
+    evict_to_budget();
+}
+
+void VisionFeatureCache::evict_to_budget() {
+    while (resident_bytes_ > max_bytes_ && !lru_.empty()) {
+        auto it = entries_.find(lru_.back());
+        resident_bytes_ -= it->second.entry->byte_size();
+        entries_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+std::string VisionFeatureCache::disk_path(const VisionCacheKey& key) const {
+    return (std::filesystem::path(disk_dir_) / (key.hex() + ".cvf")).string();
+}
+
+std::shared_ptr<const VisionCacheEntry> VisionFeatureCache::load_from_disk(const VisionCacheKey& key) const {
+    const std::string path = disk_path(key);
+    std::error_code ec;
+    const uint64_t file_size = std::filesystem::file_size(path, ec);
+    if (ec) return nullptr;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return nullptr;
+
+    uint32_t magic = 0, version = 0, num_outputs = 0;
+    uint64_t key_hi = 0, key_lo = 0;
+    uint64_t grid[3] = {};
+    if (!read_pod(in, magic) || !read_pod(in, version) || magic != VISION_CACHE_MAGIC
+        || version != VISION_CACHE_VERSION) return nullptr;
+    if (!read_pod(in, key_hi) || !read_pod(in, key_lo) || key_hi != key.hi || key_lo != key.lo) return nullptr;
+    if (!read_pod(in, grid) || !read_pod(in, num_outputs) || num_outputs > VISION_CACHE_MAX_OUTPUTS) return nullptr;
+
+    auto entry = std::make_shared<VisionCacheEntry>();
+    entry->grid_t = static_cast<size_t>(grid[0]);
+    entry->grid_h = static_cast<size_t>(grid[1]);
+    entry->grid_w = static_cast<size_t>(grid[2]);
+    entry->outputs.resize(num_outputs);
+    for (auto& out : entry->outputs) {
+        uint32_t name_len = 0, precision = 0, ndim = 0;
+        uint64_t byte_len = 0;
+        if (!read_pod(in, name_len) || name_len > 4096) return nullptr;
+        out.name.resize(name_len);
+        if (!in.read(out.name.data(), name_len)) return nullptr;
+        if (!read_pod(in, precision) || !read_pod(in, ndim) || ndim > 8) return nullptr;
+        if (precision > static_cast<uint32_t>(Precision::FP32)) return nullptr;
+        out.precision = static_cast<Precision>(precision);
+        out.shape.resize(ndim);
+        uint64_t expected = PrecisionTraits::size_of(out.precision);
+        for (auto& d : out.shape) {
+            uint64_t dim = 0;
+            if (!read_pod(in, dim)) return nullptr;
+            if (dim != 0 && expected > file_size / dim) return nullptr;
+            expected *= dim;
+            d = static_cast<size_t>(dim);
+        }
+        // A truncated or corrupt file must not drive the allocation below.
+        if (!read_pod(in, byte_len) || byte_len != expected || byte_len > file_size) return nullptr;
+        out.bytes.resize(static_cast<size_t>(byte_len));
+        if (!in.read(reinterpret_cast<char*>(out.bytes.data()), static_cast<std::streamsize>(byte_len))) return nullptr;
+    }
+    return entry;
+}
+
+void VisionFeatureCache::store_to_disk(const VisionCacheKey& key, const VisionCacheEntry& entry) const {
+    const std::string path = disk_path(key);
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return;
+        write_pod(out, VISION_CACHE_MAGIC);
+        write_pod(out, VISION_CACHE_VERSION);
+        write_pod(out, key.hi);
+        write_pod(out, key.lo);
+        const uint64_t grid[3] = {entry.grid_t, entry.grid_h, entry.grid_w};
+        write_pod(out, grid);
+        write_pod(out, static_cast<uint32_t>(entry.outputs.size()));
+        for (const auto& o : entry.outputs) {
+            write_pod(out, static_cast<uint32_t>(o.name.size()));
+            out.write(o.name.data(), static_cast<std::streamsize>(o.name.size()));
+            write_pod(out, static_cast<uint32_t>(o.precision));
+            write_pod(out, static_cast<uint32_t>(o.shape.size()));
+            for (size_t d : o.shape) write_pod(out, static_cast<uint64_t>(d));
+            write_pod(out, static_cast<uint64_t>(o.bytes.size()));
+            out.write(reinterpret_cast<const char*>(o.bytes.data()), static_cast<std::streamsize>(o.bytes.size()));
+        }
+        if (!out) {
+            out.close();
+            std::remove(tmp_path.c_str());
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) std::filesystem::remove(tmp_path, ec);
+}
+
+} // namespace engine
+} // namespace cactus
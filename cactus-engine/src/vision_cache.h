@@ -0,0 +1,90 @@
+#ifndef CACTUS_VISION_CACHE_H
+#define CACTUS_VISION_CACHE_H
+
+#include "cactus_kernels.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cactus {
+namespace engine {
+
+struct VisionCacheKey {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+
+    bool operator==(const VisionCacheKey& other) const { return hi == other.hi && lo == other.lo; }
+    std::string hex() const;
+};
+
+// One image's contribution to the vision media features, plus the grid Qwen3-VL needs for mRoPE.
+struct VisionCacheEntry {
+    struct Output {
+        std::string name;
+        std::vector<uint8_t> bytes;
+        std::vector<size_t> shape;
+        Precision precision = Precision::FP16;
+    };
+
+    std::vector<Output> outputs;
+    size_t grid_t = 1;
+    size_t grid_h = 0;
+    size_t grid_w = 0;
+
+    size_t byte_size() const;
+};
+
+// Content-addressed LRU of vision encoder outputs with an optional on-disk tier.
+class VisionFeatureCache {
+public:
+    void configure(size_t max_bytes, const std::string& disk_dir, const std::string& salt);
+    bool enabled() const { return max_bytes_ > 0 || !disk_dir_.empty(); }
+
+    bool key_for_file(const std::string& path, VisionCacheKey& out) const;
+    bool key_for_bytes(const void* data, size_t size, VisionCacheKey& out) const;
+
+    std::shared_ptr<const VisionCacheEntry> find(const VisionCacheKey& key);
+    void insert(const VisionCacheKey& key, VisionCacheEntry entry);
+    void clear();
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    size_t disk_hits() const { return disk_hits_; }
+    size_t resident_bytes() const { return resident_bytes_; }
+    size_t size() const { return entries_.size(); }
+
+private:
+    struct KeyHash {
+        size_t operator()(const VisionCacheKey& key) const { return static_cast<size_t>(key.hi ^ (key.lo * 0x9e3779b97f4a7c15ULL)); }
+    };
+    struct Slot {
+        std::shared_ptr<const VisionCacheEntry> entry;
+        std::list<VisionCacheKey>::iterator lru_it;
+    };
+
+    void insert_resident(const VisionCacheKey& key, std::shared_ptr<const VisionCacheEntry> entry);
+    void evict_to_budget();
+    std::string disk_path(const VisionCacheKey& key) const;
+    std::shared_ptr<const VisionCacheEntry> load_from_disk(const VisionCacheKey& key) const;
+    void store_to_disk(const VisionCacheKey& key, const VisionCacheEntry& entry) const;
+
+    size_t max_bytes_ = 0;
+    std::string disk_dir_;
+    uint64_t salt_ = 0;
+    std::unordered_map<VisionCacheKey, Slot, KeyHash> entries_;
+    std::list<VisionCacheKey> lru_;
+    size_t resident_bytes_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    size_t disk_hits_ = 0;
+};
+
+} // namespace engine
+} // namespace cactus
+
+#endif // CACTUS_VISION_CACHE_H
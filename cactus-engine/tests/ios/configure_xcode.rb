@@ -133,9 +133,11 @@ discovered_test_files.each { |f| puts "  - #{f}" }
 test_files = {}
 discovered_test_files.each { |f| test_files[f] = "#{File.basename(f, '.cpp')}_main" }
 test_files['test_utils.cpp'] = nil
+# test_synthetic_model and test_kv_compress build their bundles with the bench generator.
+test_files['../bench/synthetic_model.cpp'] = nil
 
 test_files.each do |filename, renamed_main|
-  file_path = File.join(tests_root, filename)
+  file_path = File.expand_path(filename, tests_root)
   next unless File.exist?(file_path)
   existing = tests_group.files.find { |f| f.path == filename || f.real_path&.to_s == file_path }
   file_ref = existing || begin
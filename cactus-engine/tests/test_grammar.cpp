@@ -0,0 +1,317 @@
+#include "test_utils.h"
+#include "../src/engine.h"
+#include "picojson.h"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+using namespace TestUtils;
+using namespace cactus::engine;
+
+namespace {
+
+constexpr uint32_t kEos = 2;
+
+std::vector<std::string> byte_level_alphabet() {
+    std::vector<std::string> table(256);
+    int next = 256;
+    for (int b = 0; b < 256; ++b) {
+        int cp = (b >= 33 && b <= 126) || (b >= 161 && b <= 255) ? b : next++;
+        if (cp < 0x80) {
+            table[b] = std::string(1, static_cast<char>(cp));
+        } else {
+            table[b] += static_cast<char>(0xC0 | (cp >> 6));
+            table[b] += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+    return table;
+}
+
+struct TestVocab {
+    std::string dir;
+    std::vector<std::string> tokens;
+    std::map<std::string, uint32_t> ids;
+    BPETokenizer tokenizer;
+
+    uint32_t id(const std::string& token) const { return ids.at(token); }
+};
+
+std::unique_ptr<TestVocab> make_vocab(size_t filler) {
+    auto vocab = std::make_unique<TestVocab>();
+    vocab->tokens = {"<unk>", "<s>", "</s>"};
+    for (int b = 0; b < 256; ++b) vocab->tokens.push_back(std::string(1, static_cast<char>(b)));
+    for (const char* t : {"{\"", "\":", "\": ", "\",", ", \"", "\"}", " {", "true", "false", "null", "name", "age",
+                          "ok", "tags", "yes", "no", "Alice", " Bob", "42", "1234", "-7", ".5", "\xC3\xA9",
+                          "\xE6\x97\xA5\xE6\x9C\xAC", "\xF0\x9F\x99\x82"}) {
+        vocab->tokens.push_back(t);
+    }
+    std::mt19937 rng(17);
+    const std::string alphabet = "abcdefghijklmnopqrstuvwxyz  ,.:\"{}[]0123456789";
+    while (vocab->tokens.size() < 3 + 256 + 25 + filler) {
+        std::string token;
+        for (size_t i = 0, len = 2 + rng() % 7; i < len; ++i) token += alphabet[rng() % alphabet.size()];
+        vocab->tokens.push_back(token);
+    }
+    for (uint32_t i = 0; i < vocab->tokens.size(); ++i) vocab->ids.emplace(vocab->tokens[i], i);
+
+    vocab->dir = (std::filesystem::temp_directory_path() / ("cactus_grammar_" + std::to_string(getpid()))).string();
+    std::filesystem::remove_all(vocab->dir);
+    std::filesystem::create_directories(vocab->dir);
+
+    const auto alphabet_map = byte_level_alphabet();
+    {
+        std::ofstream out(vocab->dir + "/vocab.txt", std::ios::binary);
+        for (uint32_t i = 0; i < vocab->tokens.size(); ++i) {
+            std::string encoded;
+            if (i < 3) {
+                encoded = vocab->tokens[i];
+            } else {
+                for (unsigned char c : vocab->tokens[i]) encoded += alphabet_map[c];
+            }
+            out << i << '\t' << encoded << '\n';
+        }
+    }
+    std::ofstream(vocab->dir + "/merges.txt") << "#version: 0.2\n";
+    std::ofstream(vocab->dir + "/config.txt")
+        << "vocab_format=id_tab_token\nnormalizer=byte_level\ndecoder=byte_level\n"
+        << "unk_token_id=0\nbos_token_id=1\neos_token_id=2\n";
+    if (!vocab->tokenizer.load_vocabulary_with_config(vocab->dir + "/vocab.txt", vocab->dir + "/merges.txt",
+                                                      vocab->dir + "/config.txt")) {
+        std::filesystem::remove_all(vocab->dir);
+        return nullptr;
+    }
+    return vocab;
+}
+
+bool allowed(const uint64_t* mask, uint32_t token_id) {
+    return (mask[token_id >> 6] >> (token_id & 63)) & 1;
+}
+
+bool accept_text(TokenGrammar& grammar, const TestVocab& vocab, const std::string& text) {
+    for (unsigned char c : text) {
+        const uint32_t token_id = vocab.id(std::string(1, static_cast<char>(c)));
+        if (!allowed(grammar.get_token_mask(), token_id)) return false;
+        grammar.accept(token_id);
+    }
+    return true;
+}
+
+bool test_gbnf_masks(const TestVocab& vocab) {
+    TokenGrammar grammar;
+    grammar.init("root ::= answer \" \" [0-9]+ \"!\"?\n"
+                 "answer ::= \"yes\" | \"no\"  # comment\n",
+                 &vocab.tokenizer);
+
+    const uint64_t* mask = grammar.get_token_mask();
+    bool ok = allowed(mask, vocab.id("y")) && allowed(mask, vocab.id("yes")) && allowed(mask, vocab.id("no")) &&
+              !allowed(mask, vocab.id("x")) && !allowed(mask, kEos) && !allowed(mask, vocab.id("true"));
+
+    ok = ok && accept_text(grammar, vocab, "no ");
+    mask = grammar.get_token_mask();
+    ok = ok && allowed(mask, vocab.id("1234")) && !allowed(mask, vocab.id("-7")) && !allowed(mask, kEos);
+
+    grammar.accept(vocab.id("42"));
+    mask = grammar.get_token_mask();
+    ok = ok && grammar.is_complete() && allowed(mask, kEos) && allowed(mask, vocab.id("!")) &&
+         allowed(mask, vocab.id("1234")) && !allowed(mask, vocab.id(" "));
+
+    grammar.reset();
+    ok = ok && !grammar.is_complete() && allowed(grammar.get_token_mask(), vocab.id("yes"));
+    return ok;
+}
+
+bool test_utf8_partial_tokens(const TestVocab& vocab) {
+    TokenGrammar grammar;
+    grammar.init("root ::= \"\xC3\xA9\" [a-z] | [\\u65E5] \"\xE6\x9C\xAC\"", &vocab.tokenizer);
+
+    const uint64_t* mask = grammar.get_token_mask();
+    bool ok = allowed(mask, vocab.id("\xC3\xA9")) && allowed(mask, vocab.id("\xE6\x97\xA5\xE6\x9C\xAC")) &&
+              allowed(mask, vocab.id("\xC3")) && allowed(mask, vocab.id("\xE6")) && !allowed(mask, vocab.id("a"));
+
+    grammar.accept(vocab.id("\xC3"));
+    mask = grammar.get_token_mask();
+    ok = ok && allowed(mask, vocab.id("\xA9")) && !allowed(mask, vocab.id("\xA8")) && !allowed(mask, vocab.id("a"));
+
+    grammar.accept(vocab.id("\xA9"));
+    mask = grammar.get_token_mask();
+    ok = ok && allowed(mask, vocab.id("q")) && !allowed(mask, vocab.id("Q"));
+    return ok;
+}
+
+std::string generate(TokenGrammar& grammar, const TestVocab& vocab, uint32_t seed, size_t max_steps) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+    std::vector<float> logits(vocab.tokens.size());
+    std::string text;
+    for (size_t step = 0; step < max_steps; ++step) {
+        for (size_t i = 0; i < logits.size(); ++i) {
+            const std::string& token = vocab.tokens[i];
+            logits[i] = noise(rng) + (token.find_first_of("\"}],") != std::string::npos ? 0.6f : 0.0f);
+        }
+        logits[kEos] += 2.0f;
+        const size_t next = cactus_masked_argmax_f32(logits.data(), grammar.get_token_mask(), logits.size(), nullptr);
+        if (next >= logits.size()) return "<dead end>";
+        if (next == kEos) return text;
+        grammar.accept(static_cast<uint32_t>(next));
+        text += vocab.tokens[next];
+    }
+    return "<max steps>";
+}
+
+bool test_json_schema_generation(const TestVocab& vocab) {
+    const std::string schema = R"({
+        "type": "object",
+        "properties": {
+            "name": {"type": "string"},
+            "age": {"type": "integer"},
+            "ok": {"type": "boolean"},
+            "tags": {"type": "array", "items": {"enum": ["red", "blue"]}}
+        },
+        "required": ["name", "age"]
+    })";
+    const std::string gbnf = TokenGrammar::json_schema_to_grammar(schema);
+
+    for (uint32_t seed = 1; seed <= 5; ++seed) {
+        TokenGrammar grammar;
+        grammar.init(gbnf, &vocab.tokenizer);
+        const std::string text = generate(grammar, vocab, seed, 4000);
+
+        picojson::value value;
+        const std::string err = picojson::parse(value, text);
+        if (!err.empty() || !value.is<picojson::object>()) {
+            std::cerr << "  invalid output: " << text << "\n";
+            return false;
+        }
+        const auto& object = value.get<picojson::object>();
+        if (!object.count("name") || !object.at("name").is<std::string>() ||
+            !object.count("age") || !object.at("age").is<double>() ||
+            std::floor(object.at("age").get<double>()) != object.at("age").get<double>() ||
+            text.find("\"name\"") > text.find("\"age\"")) {
+            std::cerr << "  schema violated: " << text << "\n";
+            return false;
+        }
+        if (object.count("tags")) {
+            for (const auto& tag : object.at("tags").get<picojson::array>()) {
+                if (tag.get<std::string>() != "red" && tag.get<std::string>() != "blue") return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool test_invalid_grammars(const TestVocab& vocab) {
+    auto rejects = [&](const std::string& grammar) {
+        try {
+            TokenGrammar g;
+            g.init(grammar, &vocab.tokenizer);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    auto schema_rejects = [](const std::string& schema) {
+        try {
+            TokenGrammar::json_schema_to_grammar(schema);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    return rejects("root ::= root \"a\" | \"a\"") && rejects("root ::= item") &&
+           rejects("root ::= (\"a\"?)*") && rejects("root ::= \"a") &&
+           schema_rejects(R"({"$ref": "#/defs/x"})") && schema_rejects("{") &&
+           !schema_rejects(R"({"type": ["string", "null"]})");
+}
+
+void run_benchmarks(TestRunner& runner, const TestVocab& vocab) {
+    constexpr size_t kVocab = 262144;
+    constexpr int kSteps = 50;
+    std::mt19937 rng(5);
+    std::vector<float> logits(kVocab);
+    for (auto& v : logits) v = static_cast<float>(rng() % 10000) / 1000.0f;
+    std::vector<uint64_t> mask(kVocab / 64, 0);
+    for (int i = 0; i < 2000; ++i) {
+        const uint32_t t = rng() % kVocab;
+        mask[t >> 6] |= 1ULL << (t & 63);
+    }
+
+    volatile size_t sink = 0;
+    EngineTestUtils::Timer timer;
+    for (int step = 0; step < kSteps; ++step) {
+        std::vector<bool> valid(kVocab, false);
+        for (uint32_t t = 0; t < kVocab; ++t) valid[t] = allowed(mask.data(), t);
+        std::unordered_map<uint32_t, float> bias;
+        for (uint32_t t = 0; t < kVocab; ++t) {
+            if (!valid[t]) bias[t] = -1e9f;
+        }
+        size_t best = 0;
+        float best_v = -INFINITY;
+        for (size_t t = 0; t < kVocab; ++t) {
+            float v = logits[t];
+            auto it = bias.find(static_cast<uint32_t>(t));
+            if (it != bias.end()) v += it->second;
+            if (v > best_v) {
+                best_v = v;
+                best = t;
+            }
+        }
+        sink = best;
+    }
+    const double map_us = timer.elapsed_ms() * 1000.0 / kSteps;
+
+    timer = EngineTestUtils::Timer();
+    for (int step = 0; step < kSteps * 20; ++step) {
+        sink = cactus_masked_argmax_f32(logits.data(), mask.data(), kVocab, nullptr);
+    }
+    const double bitmask_us = timer.elapsed_ms() * 1000.0 / (kSteps * 20);
+    (void)sink;
+
+    char details[160];
+    std::snprintf(details, sizeof(details), "%.1f us/step (bias map), %.1f us/step (bitmask), V=%zu",
+                  map_us, bitmask_us, kVocab);
+    runner.log_performance("constrained_step_256k", details);
+
+    TokenGrammar grammar;
+    grammar.init(TokenGrammar::json_schema_to_grammar(R"({"type":"object","properties":{"name":{"type":"string"}}})"),
+                 &vocab.tokenizer);
+    for (char c : std::string("{\"name\": \"A")) grammar.accept(vocab.id(std::string(1, c)));
+    timer = EngineTestUtils::Timer();
+    grammar.get_token_mask();
+    const double cold_ms = timer.elapsed_ms();
+    grammar.accept(vocab.id("b"));
+    timer = EngineTestUtils::Timer();
+    grammar.get_token_mask();
+    const double warm_us = timer.elapsed_ms() * 1000.0;
+    std::snprintf(details, sizeof(details), "%.2f ms first visit, %.1f us cached, V=%zu",
+                  cold_ms, warm_us, vocab.tokens.size());
+    runner.log_performance("grammar_mask_json_string", details);
+}
+
+}  // namespace
+
+int main() {
+    TestUtils::TestRunner runner("Grammar Tests");
+    auto vocab = make_vocab(32000);
+    if (!vocab) {
+        runner.log_skip("grammar", "tokenizer failed to load");
+        runner.print_summary();
+        return 1;
+    }
+    runner.run_test("gbnf_masks", test_gbnf_masks(*vocab));
+    runner.run_test("utf8_partial_tokens", test_utf8_partial_tokens(*vocab));
+    runner.run_test("json_schema_generation", test_json_schema_generation(*vocab));
+    runner.run_test("invalid_grammars", test_invalid_grammars(*vocab));
+    run_benchmarks(runner, *vocab);
+    std::filesystem::remove_all(vocab->dir);
+    runner.print_summary();
+    return runner.all_passed() ? 0 : 1;
+}
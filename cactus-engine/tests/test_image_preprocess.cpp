@@ -0,0 +1,335 @@
+#include "test_utils.h"
+#include "../src/engine.h"
+#include "stb_image_resize2.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace TestUtils;
+using namespace EngineTestUtils;
+using namespace cactus::engine;
+
+namespace {
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+void put_be32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int s = 24; s >= 0; s -= 8) out.push_back(static_cast<uint8_t>(v >> s));
+}
+
+void put_chunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    put_be32(out, static_cast<uint32_t>(data.size()));
+    std::vector<uint8_t> body(type, type + 4);
+    body.insert(body.end(), data.begin(), data.end());
+    out.insert(out.end(), body.begin(), body.end());
+    put_be32(out, crc32(body.data(), body.size()));
+}
+
+// Uncompressed (stored-block) RGB PNG so tests can feed arbitrary sizes through the file-based preprocessors.
+std::string write_png_rgb(const std::vector<uint8_t>& rgb, int width, int height, const std::string& tag) {
+    std::vector<uint8_t> raw;
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb.begin() + static_cast<size_t>(y) * width * 3,
+                   rgb.begin() + static_cast<size_t>(y + 1) * width * 3);
+    }
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    for (size_t pos = 0; pos < raw.size() || pos == 0;) {
+        const size_t len = std::min<size_t>(65535, raw.size() - pos);
+        const bool last = pos + len == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(len));
+        zlib.push_back(static_cast<uint8_t>(len >> 8));
+        zlib.push_back(static_cast<uint8_t>(~len));
+        zlib.push_back(static_cast<uint8_t>(~len >> 8));
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+        if (last) break;
+    }
+    uint32_t a = 1, b = 0;
+    for (uint8_t v : raw) { a = (a + v) % 65521; b = (b + a) % 65521; }
+    put_be32(zlib, (b << 16) | a);
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<uint8_t> ihdr;
+    put_be32(ihdr, static_cast<uint32_t>(width));
+    put_be32(ihdr, static_cast<uint32_t>(height));
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});
+    put_chunk(png, "IHDR", ihdr);
+    put_chunk(png, "IDAT", zlib);
+    put_chunk(png, "IEND", {});
+
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("cactus_image_preprocess_" + tag + "_" + std::to_string(getpid()) + ".png");
+    std::ofstream f(path, std::ios::binary);
+    f.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    return path.string();
+}
+
+std::vector<uint8_t> make_image(int width, int height, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = rgb.data() + (static_cast<size_t>(y) * width + x) * 3;
+            p[0] = static_cast<uint8_t>(x * 7 + y * 3 + (rng() & 31));
+            p[1] = static_cast<uint8_t>(127 + 120 * std::sin(x * 0.01 + y * 0.02));
+            p[2] = ((x / 8 + y / 8) & 1) ? static_cast<uint8_t>(rng()) : static_cast<uint8_t>(x ^ y);
+        }
+    }
+    return rgb;
+}
+
+// Scalar Pillow BILINEAR reference (int64 accumulators, 22-bit fixed point).
+std::vector<uint8_t> pillow_bilinear_reference(const std::vector<uint8_t>& src, int sw, int sh, int dw, int dh) {
+    auto coeffs = [](int in, int out, std::vector<int>& bounds, std::vector<int64_t>& k, int& ksize) {
+        const double scale = static_cast<double>(in) / out;
+        const double support = std::max(scale, 1.0);
+        ksize = static_cast<int>(std::ceil(support)) * 2 + 1;
+        bounds.assign(static_cast<size_t>(out) * 2, 0);
+        k.assign(static_cast<size_t>(out) * ksize, 0);
+        for (int o = 0; o < out; ++o) {
+            const double center = (o + 0.5) * scale;
+            const int xmin = std::max(0, static_cast<int>(center - support + 0.5));
+            const int xmax = std::min(in, static_cast<int>(center + support + 0.5)) - xmin;
+            std::vector<double> w(static_cast<size_t>(ksize), 0.0);
+            double total = 0.0;
+            for (int i = 0; i < xmax; ++i) {
+                const double x = std::fabs((i + xmin - center + 0.5) * (1.0 / support));
+                w[i] = x < 1.0 ? 1.0 - x : 0.0;
+                total += w[i];
+            }
+            for (int i = 0; i < ksize; ++i) k[static_cast<size_t>(o) * ksize + i] = static_cast<int64_t>(0.5 + w[i] / total * (1 << 22));
+            bounds[o * 2] = xmin;
+            bounds[o * 2 + 1] = xmax;
+        }
+    };
+    auto clip = [](int64_t v) { return static_cast<uint8_t>(std::clamp<int64_t>(v >> 22, 0, 255)); };
+
+    std::vector<int> xb, yb;
+    std::vector<int64_t> xk, yk;
+    int xks = 0, yks = 0;
+    coeffs(sw, dw, xb, xk, xks);
+    coeffs(sh, dh, yb, yk, yks);
+
+    std::vector<uint8_t> tmp(static_cast<size_t>(dw) * sh * 3);
+    for (int y = 0; y < sh; ++y)
+        for (int x = 0; x < dw; ++x)
+            for (int c = 0; c < 3; ++c) {
+                int64_t s = 1 << 21;
+                for (int i = 0; i < xb[x * 2 + 1]; ++i)
+                    s += src[(static_cast<size_t>(y) * sw + xb[x * 2] + i) * 3 + c] * xk[static_cast<size_t>(x) * xks + i];
+                tmp[(static_cast<size_t>(y) * dw + x) * 3 + c] = clip(s);
+            }
+    std::vector<uint8_t> dst(static_cast<size_t>(dw) * dh * 3);
+    for (int y = 0; y < dh; ++y)
+        for (int x = 0; x < dw; ++x)
+            for (int c = 0; c < 3; ++c) {
+                int64_t s = 1 << 21;
+                for (int i = 0; i < yb[y * 2 + 1]; ++i)
+                    s += tmp[(static_cast<size_t>(yb[y * 2] + i) * dw + x) * 3 + c] * yk[static_cast<size_t>(y) * yks + i];
+                dst[(static_cast<size_t>(y) * dw + x) * 3 + c] = clip(s);
+            }
+    return dst;
+}
+
+std::vector<float> to_float(const std::vector<uint8_t>& v) {
+    return std::vector<float>(v.begin(), v.end());
+}
+
+std::vector<float> stbir_reference(const std::vector<uint8_t>& src, int sw, int sh, int dw, int dh) {
+    std::vector<float> in = to_float(src), out(static_cast<size_t>(dw) * dh * 3);
+    stbir_resize_float_linear(in.data(), sw, sh, 0, out.data(), dw, dh, 0, STBIR_RGB);
+    return out;
+}
+
+// [patch][y][x][c] patches of the stride-`stride` region at (x0, y0), normalized as ((v * scale) - mean) / std.
+std::vector<float> patchify_reference(const std::vector<float>& img, int stride, int x0, int y0, int w, int h,
+                                      int patch, float scale, float mean, float std_dev) {
+    std::vector<float> out;
+    for (int py = 0; py < h / patch; ++py)
+        for (int px = 0; px < w / patch; ++px)
+            for (int y = 0; y < patch; ++y)
+                for (int x = 0; x < patch; ++x)
+                    for (int c = 0; c < 3; ++c) {
+                        float v = img[(static_cast<size_t>(y0 + py * patch + y) * stride + x0 + px * patch + x) * 3 + c] * scale;
+                        out.push_back((v - mean) / std_dev);
+                    }
+    return out;
+}
+
+bool close(const float* a, const float* b, size_t n, float tol = 1e-6f) {
+    for (size_t i = 0; i < n; ++i) {
+        if (std::fabs(a[i] - b[i]) > tol) return false;
+    }
+    return true;
+}
+
+bool all_zero(const float* a, size_t n) {
+    return std::all_of(a, a + n, [](float v) { return v == 0.0f; });
+}
+
+bool check_gemma4(const std::vector<uint8_t>& rgb, int width, int height, uint32_t soft_tokens, const std::string& tag) {
+    const std::string path = write_png_rgb(rgb, width, height, tag);
+    Config config;
+    config.vision_patch_size = 16;
+    config.vision_default_output_length = soft_tokens;
+    auto out = preprocess_gemma4_image(path, config);
+    std::remove(path.c_str());
+
+    const int side = 3 * 16;
+    const double factor = std::sqrt(static_cast<double>(soft_tokens) * 9 * 256 / (static_cast<double>(width) * height));
+    const int th = std::max(side, static_cast<int>(std::floor(factor * height / side)) * side);
+    const int tw = std::max(side, static_cast<int>(std::floor(factor * width / side)) * side);
+    std::vector<float> resized = to_float(tw == width && th == height ? rgb : pillow_bilinear_reference(rgb, width, height, tw, th));
+    std::vector<float> ref = patchify_reference(resized, tw, 0, 0, tw, th, 16, config.rescale_factor, 0.0f, 1.0f);
+
+    const size_t n = static_cast<size_t>(tw / 16) * (th / 16);
+    return out.num_patches == n && out.patch_dim == 768 && close(out.pixel_values.data(), ref.data(), ref.size())
+        && all_zero(out.pixel_values.data() + ref.size(), out.pixel_values.size() - ref.size())
+        && out.pixel_position_ids[2 * (n - 1)] == tw / 16 - 1 && out.pixel_position_ids[2 * (n - 1) + 1] == th / 16 - 1
+        && (n == out.max_patches || out.pixel_position_ids[2 * n] == -1);
+}
+
+bool test_gemma4_matches_pillow_reference() {
+    const auto odd = make_image(333, 517, 1);
+    const auto wide = make_image(1203, 401, 2);
+    return check_gemma4(odd, 333, 517, 280, "odd_up") && check_gemma4(odd, 333, 517, 4, "odd_down")
+        && check_gemma4(wide, 1203, 401, 70, "wide");
+}
+
+bool check_siglip2_tiles(const Siglip2Preprocessor::PreprocessedImage& out, const std::vector<uint8_t>& rgb,
+                         int width, int height, const Siglip2Preprocessor::Config& cfg) {
+    const int patch = cfg.patch_size;
+    const size_t tile_stride = static_cast<size_t>(out.max_patches_per_tile) * out.patch_dim;
+    std::vector<std::vector<float>> expected;
+    const int tiles = out.image_rows * out.image_cols;
+    if (tiles > 1) {
+        const int gw = out.image_cols * cfg.tile_size, gh = out.image_rows * cfg.tile_size;
+        const auto grid = stbir_reference(rgb, width, height, gw, gh);
+        for (int r = 0; r < out.image_rows; ++r)
+            for (int c = 0; c < out.image_cols; ++c)
+                expected.push_back(patchify_reference(grid, gw, c * cfg.tile_size, r * cfg.tile_size, cfg.tile_size,
+                                                      cfg.tile_size, patch, cfg.rescale_factor, 0.5f, 0.5f));
+    }
+    if (tiles == 1 || cfg.use_thumbnail) {
+        const int tw = out.image_width, th = out.image_height;
+        const auto img = tw == width && th == height ? to_float(rgb) : stbir_reference(rgb, width, height, tw, th);
+        expected.push_back(patchify_reference(img, tw, 0, 0, tw, th, patch, cfg.rescale_factor, 0.5f, 0.5f));
+    }
+    if (static_cast<int>(expected.size()) != out.num_tiles) return false;
+    for (int t = 0; t < out.num_tiles; ++t) {
+        const float* got = out.pixel_values.data() + t * tile_stride;
+        const size_t valid = expected[t].size();
+        const size_t patches = valid / out.patch_dim;
+        if (!close(got, expected[t].data(), valid) || !all_zero(got + valid, tile_stride - valid)) return false;
+        const int* mask = out.pixel_attention_mask.data() + static_cast<size_t>(t) * out.max_patches_per_tile;
+        if (mask[patches - 1] != 1 || (patches < static_cast<size_t>(out.max_patches_per_tile) && mask[patches] != 0)) return false;
+    }
+    return true;
+}
+
+bool test_siglip2_matches_reference() {
+    Siglip2Preprocessor::Config cfg;
+    cfg.rescale_factor = 1.0f / 255.0f;
+    Siglip2Preprocessor pre(cfg);
+
+    const auto large = make_image(1603, 1201, 3);
+    auto split = pre.preprocess_from_memory(large.data(), 1603, 1201, 3);
+
+    const auto small = make_image(300, 200, 4);
+    auto single = pre.preprocess_from_memory(small.data(), 300, 200, 3);
+
+    Siglip2Preprocessor::Config exact_cfg = cfg;
+    exact_cfg.do_resize = false;
+    exact_cfg.do_image_splitting = false;
+    Siglip2Preprocessor exact_pre(exact_cfg);
+    const auto aligned = make_image(256, 128, 5);
+    auto exact = exact_pre.preprocess_from_memory(aligned.data(), 256, 128, 3);
+
+    return split.num_tiles > 1 && check_siglip2_tiles(split, large, 1603, 1201, cfg)
+        && single.num_tiles == 1 && check_siglip2_tiles(single, small, 300, 200, cfg)
+        && exact.image_width == 256 && check_siglip2_tiles(exact, aligned, 256, 128, exact_cfg);
+}
+
+bool test_qwen3_vl_merge_order() {
+    const auto rgb = make_image(640, 480, 6);
+    const std::string path = write_png_rgb(rgb, 640, 480, "qwen");
+    Config config;
+    config.vision_patch_size = 16;
+    config.image_seq_len = 64;
+    auto out = preprocess_qwen3_vl_image(path, config);
+    std::remove(path.c_str());
+
+    const int side = 16, patch = 16, target = side * patch;
+    const auto img = stbir_reference(rgb, 640, 480, target, target);
+    std::vector<float> ref;
+    for (int gy = 0; gy < side / 2; ++gy)
+        for (int gx = 0; gx < side / 2; ++gx)
+            for (int mh = 0; mh < 2; ++mh)
+                for (int mw = 0; mw < 2; ++mw)
+                    for (int c = 0; c < 3; ++c)
+                        for (int t = 0; t < 2; ++t)
+                            for (int y = 0; y < patch; ++y)
+                                for (int x = 0; x < patch; ++x) {
+                                    const size_t iy = (gy * 2 + mh) * patch + y, ix = (gx * 2 + mw) * patch + x;
+                                    ref.push_back((img[(iy * target + ix) * 3 + c] * config.rescale_factor - config.image_mean) / config.image_std);
+                                }
+    return out.grid_h == 16 && out.grid_w == 16 && out.pixel_values.size() == ref.size()
+        && close(out.pixel_values.data(), ref.data(), ref.size(), 1e-5f);
+}
+
+void benchmark_preprocessing(TestRunner& runner) {
+    const auto rgb = make_image(4032, 3024, 7);
+    const std::string path = write_png_rgb(rgb, 4032, 3024, "bench");
+    Config config;
+    config.vision_patch_size = 16;
+
+    auto time_ms = [](auto&& fn) {
+        fn();
+        double best = 1e30;
+        for (int i = 0; i < 3; ++i) {
+            Timer t;
+            fn();
+            best = std::min(best, t.elapsed_ms());
+        }
+        return best;
+    };
+    const double gemma_ms = time_ms([&] { preprocess_gemma4_image(path, config); });
+    const double lfm_ms = time_ms([&] { preprocess_lfm2_vl_image(path, config); });
+    Siglip2Preprocessor pre;
+    const double siglip_ms = time_ms([&] { pre.preprocess_from_memory(rgb.data(), 4032, 3024, 3); });
+    std::remove(path.c_str());
+
+    std::ostringstream details;
+    details << std::fixed << std::setprecision(2) << "4032x3024: gemma4 " << gemma_ms << "ms (incl. decode), lfm2-vl "
+            << lfm_ms << "ms (incl. decode), siglip2 in-memory " << siglip_ms << "ms";
+    runner.log_performance("preprocess_12mp", details.str());
+}
+
+} // namespace
+
+int main() {
+    TestUtils::TestRunner runner("Image Preprocessing Tests");
+    runner.run_test("gemma4_matches_pillow_reference", test_gemma4_matches_pillow_reference());
+    runner.run_test("siglip2_matches_reference", test_siglip2_matches_reference());
+    runner.run_test("qwen3_vl_merge_order", test_qwen3_vl_merge_order());
+    benchmark_preprocessing(runner);
+    runner.print_summary();
+    return runner.all_passed() ? 0 : 1;
+}
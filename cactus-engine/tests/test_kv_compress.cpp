@@ -2,11 +2,13 @@
 #include "../src/kv_compress.h"
 #include "../src/engine.h"
 #include "cactus_graph.h"
+#include "../bench/synthetic_model.h"
 
 #include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -272,7 +274,7 @@ bool test_rolling_bounded_compaction() {
     std::vector<char> vbuf(kbuf.size(), 0);
     auto* khdr = reinterpret_cast<Header*>(kbuf.data());
     auto* vhdr = reinterpret_cast<Header*>(vbuf.data());
-    *khdr = Header{0, max_seq, kv_heads, head_dim, 4, {0, 0, 0}};
+    *khdr = Header{0, max_seq, kv_heads, head_dim, 4};
     *vhdr = *khdr;
     auto* krows = reinterpret_cast<uint16_t*>(kbuf.data() + kHeaderBytes);
     auto* vrows = reinterpret_cast<uint16_t*>(vbuf.data() + kHeaderBytes);
@@ -370,7 +372,7 @@ bool test_trigger_zero_gates_rolling() {
 
     auto fresh_cache = [&]() {
         std::vector<char> buf(kHeaderBytes + max_seq * kv_heads * head_dim * sizeof(uint16_t), 0);
-        *reinterpret_cast<Header*>(buf.data()) = Header{n, max_seq, kv_heads, head_dim, 4, {0, 0, 0}};
+        *reinterpret_cast<Header*>(buf.data()) = Header{n, max_seq, kv_heads, head_dim, 4};
         auto* rows = reinterpret_cast<uint16_t*>(buf.data() + kHeaderBytes);
         for (size_t i = 0; i < n * kv_heads * head_dim; ++i) rows[i] = f32_to_f16(0.01f * (i % 97));
         return buf;
@@ -695,7 +697,7 @@ bool test_rolling_protect_survives() {
     std::vector<char> vbuf(kbuf.size(), 0);
     auto* khdr = reinterpret_cast<Header*>(kbuf.data());
     auto* vhdr = reinterpret_cast<Header*>(vbuf.data());
-    *khdr = Header{0, max_seq, kv_heads, head_dim, 4, {0, 0, 0}};
+    *khdr = Header{0, max_seq, kv_heads, head_dim, 4};
     *vhdr = *khdr;
     auto* krows = reinterpret_cast<uint16_t*>(kbuf.data() + kHeaderBytes);
     auto* vrows = reinterpret_cast<uint16_t*>(vbuf.data() + kHeaderBytes);
@@ -860,7 +862,7 @@ bool test_all_heads_keep_special_across_cycles() {
     std::vector<char> vbuf(kbuf.size(), 0);
     auto* khdr = reinterpret_cast<Header*>(kbuf.data());
     auto* vhdr = reinterpret_cast<Header*>(vbuf.data());
-    *khdr = Header{0, max_seq, kv_heads, head_dim, 4, {0, 0, 0}};
+    *khdr = Header{0, max_seq, kv_heads, head_dim, 4};
     *vhdr = *khdr;
     auto* krows = reinterpret_cast<uint16_t*>(kbuf.data() + kHeaderBytes);
     auto* vrows = reinterpret_cast<uint16_t*>(vbuf.data() + kHeaderBytes);
@@ -972,6 +974,76 @@ bool test_shrink_cache_buffer_preserves_rows() {
     return ok;
 }
 
+bool test_reserve_cache_buffer_keeps_rows_in_place() {
+    CactusGraph gb;
+    const size_t kv_heads = 2, head_dim = 64, ceiling = 100000, chunk = 100;
+    const size_t int8_stride = kv_heads * head_dim;
+    size_t new_kv = gb.input({chunk, kv_heads, head_dim}, Precision::FP16);
+    size_t state = gb.kv_cache_state(ceiling, kv_heads, head_dim, /*window*/0, /*sink*/4);
+    size_t append = gb.kv_cache_append(new_kv, state, /*window*/0, /*sink*/4);
+    gb.retain_outputs({static_cast<int>(state), static_cast<int>(append)});
+
+    std::vector<uint16_t> in(chunk * int8_stride);
+    for (size_t i = 0; i < in.size(); ++i) in[i] = f32_to_f16(static_cast<float>(std::sin(0.01 * i)));
+    gb.set_input(new_kv, in.data(), Precision::FP16);
+    gb.execute();
+    std::vector<int8_t> first(static_cast<const int8_t*>(gb.get_output(state)) + kHeaderBytes,
+                              static_cast<const int8_t*>(gb.get_output(state)) + kHeaderBytes + chunk * int8_stride);
+
+    gb.reserve_cache_buffer(state, 700);  // same doubling as appends: 256 -> 1024
+    const void* reserved = gb.get_output(state);
+    if (reinterpret_cast<const Header*>(reserved)->max_seq_len != 1024) return false;
+    for (int step = 0; step < 6; ++step) gb.execute();  // 700 rows, no reallocation
+    const auto* hdr = reinterpret_cast<const Header*>(gb.get_output(state));
+    if (gb.get_output(state) != reserved || hdr->current_seq_len != 700 || hdr->max_seq_len != 1024) return false;
+    return std::memcmp(first.data(), static_cast<const char*>(reserved) + kHeaderBytes, first.size()) == 0;
+}
+
+// End-to-end rolling compaction on a generated dense bundle: background scoring must keep the cache
+// bounded like the synchronous path and swap before the trigger when it finishes in time.
+bool run_rolling_decode(const std::string& bundle, const char* lead, size_t trigger, size_t target,
+                        size_t& max_len, size_t& compactions, size_t& first_compaction_at) {
+    setenv("CACTUS_KV_COMPRESS_AT", std::to_string(trigger).c_str(), 1);
+    setenv("CACTUS_KV_COMPRESS_TO", std::to_string(target).c_str(), 1);
+    setenv("CACTUS_KV_COMPRESS_ASYNC_LEAD", lead, 1);
+    auto model = cactus::engine::create_model(bundle);
+    bool ok = model && model->init(bundle, 4 * trigger, "", false);
+    unsetenv("CACTUS_KV_COMPRESS_AT");
+    unsetenv("CACTUS_KV_COMPRESS_TO");
+    unsetenv("CACTUS_KV_COMPRESS_ASYNC_LEAD");
+    if (!ok) return false;
+
+    std::vector<uint32_t> prompt;
+    for (uint32_t i = 0; i < 40; ++i) prompt.push_back(40 + (i * 13) % 80);
+    uint32_t token = 0;
+    if (!model->prefill_and_sample_first_token(prompt, token)) return false;
+    max_len = model->get_cache_size();
+    compactions = 0;
+    first_compaction_at = 0;
+    size_t previous = max_len;
+    for (size_t step = 0; step < 3 * trigger; ++step) {
+        token = model->decode({token});
+        size_t len = model->get_cache_size();
+        if (len < previous) {
+            if (compactions++ == 0) first_compaction_at = previous + 1;  // length the step reached before the swap
+            if (len > target) ok = false;
+        }
+        max_len = std::max(max_len, len);
+        previous = len;
+    }
+    return ok;
+}
+
+bool test_async_rolling_compaction_end_to_end(const std::string& bundle) {
+    const size_t trigger = 192, target = 96;
+    size_t sync_max = 0, sync_count = 0, sync_at = 0;
+    size_t async_max = 0, async_count = 0, async_at = 0;
+    if (!run_rolling_decode(bundle, "0", trigger, target, sync_max, sync_count, sync_at)) return false;
+    if (!run_rolling_decode(bundle, "24", trigger, target, async_max, async_count, async_at)) return false;
+    return sync_max <= trigger && sync_count >= 2 && sync_at == trigger &&
+           async_max <= trigger && async_count >= 2 && async_at <= trigger && async_at > trigger - 24;
+}
+
 int main() {
     TestUtils::TestRunner runner("KV Compress Free-Function Tests");
     runner.run_test("cache_starts_small_and_grows", test_cache_starts_small_and_grows());
@@ -1002,6 +1074,23 @@ int main() {
     runner.run_test("empty_protect_per_head_uses_params_fallback", test_empty_protect_per_head_uses_params_fallback());
     runner.run_test("all_heads_keep_special_across_cycles", test_all_heads_keep_special_across_cycles());
     runner.run_test("shrink_cache_buffer_preserves_rows", test_shrink_cache_buffer_preserves_rows());
+    runner.run_test("reserve_cache_buffer_keeps_rows_in_place", test_reserve_cache_buffer_keeps_rows_in_place());
+    {
+        auto spec = cactus::synthetic::preset("dense");
+        spec.vocab_size = 512;
+        spec.hidden_dim = 64;
+        spec.num_layers = 2;
+        spec.num_heads = 2;
+        spec.num_kv_heads = 1;
+        spec.head_dim = 32;
+        spec.ffn_dim = 128;
+        spec.context_length = 1024;
+        spec.prefill_chunk = 16;
+        const std::string dir = "/tmp/cactus_kv_compress_bundle_" + std::to_string(getpid());
+        cactus::synthetic::write_bundle(spec, dir);
+        runner.run_test("async_rolling_compaction_end_to_end", test_async_rolling_compaction_end_to_end(dir));
+        std::filesystem::remove_all(dir);
+    }
     runner.print_summary();
     return runner.all_passed() ? 0 : 1;
 }
@@ -0,0 +1,234 @@
+#include "test_utils.h"
+#include "../bench/synthetic_model.h"
+#include "../src/engine.h"
+#include "picojson.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace TestUtils;
+namespace synthetic = cactus::synthetic;
+
+namespace {
+
+std::string bundle_root() {
+    return (std::filesystem::temp_directory_path() /
+            ("cactus_synthetic_test_" + std::to_string(getpid()))).string();
+}
+
+synthetic::ModelSpec tiny_spec(const std::string& arch) {
+    auto spec = synthetic::preset(arch);
+    spec.vocab_size = 512;
+    spec.hidden_dim = 64;
+    spec.num_heads = 2;
+    spec.num_kv_heads = arch == "whisper" ? 2 : 1;
+    spec.head_dim = 32;
+    spec.ffn_dim = 128;
+    spec.moe_ffn_dim = 64;
+    spec.num_experts = 4;
+    spec.num_layers = arch == "hybrid" ? 3 : 2;
+    spec.source_len = 64;
+    spec.context_length = 256;
+    spec.prefill_chunk = 16;
+    return spec;
+}
+
+bool run_tokens(cactus_model_t model, const std::vector<uint32_t>& prompt, size_t decode,
+                std::vector<uint32_t>& completion) {
+    std::vector<char> buffer(1 << 16);
+    int rc = cactus_benchmark_tokens(model, prompt.data(), prompt.size(), decode, buffer.data(), buffer.size());
+    if (rc < 0) {
+        std::printf("  benchmark failed: %s\n", buffer.data());
+        return false;
+    }
+    picojson::value json;
+    if (!picojson::parse(json, std::string(buffer.data())).empty()) return false;
+    completion.clear();
+    for (const auto& id : json.get("completion_token_ids").get<picojson::array>()) {
+        completion.push_back(static_cast<uint32_t>(id.get<double>()));
+    }
+    return json.get("success").is<bool>() && json.get("success").get<bool>();
+}
+
+bool test_architecture(const std::string& arch, const std::string& root) {
+    const auto spec = tiny_spec(arch);
+    const auto info = synthetic::write_bundle(spec, root + "/" + arch);
+    if (info.parameter_count == 0 || info.components.size() < 3) return false;
+
+    cactus_model_t model = cactus_init(info.dir.c_str(), nullptr, false);
+    if (!model) {
+        std::printf("  init failed: %s\n", cactus_get_last_error());
+        return false;
+    }
+    // 37 tokens spans two full prefill chunks plus a tail on the chunked route.
+    std::vector<uint32_t> prompt;
+    for (uint32_t i = 0; i < 37; ++i) prompt.push_back(65 + (i * 7) % 26);
+
+    std::vector<uint32_t> first, second;
+    bool ok = run_tokens(model, prompt, 8, first) && run_tokens(model, prompt, 8, second);
+    ok = ok && first.size() == 8 && first == second;
+    for (uint32_t id : first) ok = ok && id < spec.vocab_size;
+    cactus_destroy(model);
+    return ok;
+}
+
+bool score_window(const std::string& dir, const char* kv_bits, double& logprob, size_t& scored) {
+    if (kv_bits) setenv("CACTUS_KV_CACHE_BITS", kv_bits, 1);
+    else unsetenv("CACTUS_KV_CACHE_BITS");
+    cactus_model_t model = cactus_init(dir.c_str(), nullptr, false);
+    unsetenv("CACTUS_KV_CACHE_BITS");
+    if (!model) return false;
+    std::vector<uint32_t> tokens;
+    for (uint32_t i = 0; i < 96; ++i) tokens.push_back(65 + (i * 11) % 26);
+    std::vector<char> buffer(1 << 12);
+    int rc = cactus_score_window(model, tokens.data(), tokens.size(), 64, tokens.size(), 0,
+                                 buffer.data(), buffer.size());
+    cactus_destroy(model);
+    picojson::value json;
+    if (rc < 0 || !picojson::parse(json, std::string(buffer.data())).empty()) return false;
+    logprob = json.get("logprob").get<double>();
+    scored = static_cast<size_t>(json.get("tokens").get<double>());
+    return true;
+}
+
+// A 4-bit KV cache must score the same window as the INT8 cache to within quantization noise.
+bool test_lowbit_kv_cache_scoring(const std::string& root) {
+    auto spec = tiny_spec("dense");
+    spec.head_dim = 64;
+    const auto info = synthetic::write_bundle(spec, root + "/kv_bits");
+    double int8_lp = 0.0, q4_lp = 0.0;
+    size_t int8_n = 0, q4_n = 0;
+    if (!score_window(info.dir, nullptr, int8_lp, int8_n) || !score_window(info.dir, "4", q4_lp, q4_n)) return false;
+    const double nll_int8 = -int8_lp / static_cast<double>(int8_n);
+    const double nll_q4 = -q4_lp / static_cast<double>(q4_n);
+    return int8_n == 32 && q4_n == 32 && std::isfinite(q4_lp) && int8_lp < 0.0 && q4_lp < 0.0 &&
+           std::abs(nll_q4 - nll_int8) < 0.1 * nll_int8;
+}
+
+// Beam search over forked cache slots: one beam must reproduce greedy decoding, n-best hypotheses
+// come back ranked and rescore to their accumulated log-probability, a threshold no hypothesis
+// can meet walks the whole temperature schedule, and a search continuing a conversation matches
+// one over the whole prompt and leaves the prompt in the cache.
+bool test_beam_search(const std::string& root) {
+    const auto info = synthetic::write_bundle(tiny_spec("dense"), root + "/beam");
+    auto model = cactus::engine::create_model(info.dir);
+    if (!model || !model->init(info.dir, 256, "", false)) return false;
+    std::vector<uint32_t> prompt;
+    for (uint32_t i = 0; i < 12; ++i) prompt.push_back(65 + (i * 7) % 26);
+
+    cactus::engine::Model::BeamSearchOptions options;
+    options.beam_size = 1;
+    options.max_tokens = 8;
+    auto single = model->beam_search(prompt, options, {});
+    if (model->get_cache_size() != prompt.size()) return false;
+    model->reset_cache();
+    std::vector<uint32_t> greedy(1);
+    if (!model->prefill_and_sample_first_token(prompt, greedy[0])) return false;
+    while (greedy.size() < 8) greedy.push_back(model->decode({greedy.back()}));
+    if (single.size() != 1 || single[0].tokens != greedy) return false;
+
+    options.beam_size = 4;
+    options.n_best = 4;
+    model->reset_cache();
+    auto beams = model->beam_search(prompt, options, {});
+    if (beams.size() != 4 || beams[0].logprob + 1e-4f < single[0].logprob) return false;
+    for (size_t i = 0; i < beams.size(); ++i) {
+        if (i > 0 && beams[i].score > beams[i - 1].score) return false;
+        std::vector<uint32_t> all = prompt;
+        all.insert(all.end(), beams[i].tokens.begin(), beams[i].tokens.end());
+        size_t scored = 0;
+        double rescored = model->score_tokens_window_logprob(all, prompt.size(), all.size(), 0, &scored);
+        if (scored != beams[i].tokens.size() || std::abs(rescored - beams[i].logprob) > 0.05 * scored) return false;
+    }
+
+    model->reset_cache();
+    model->prefill(std::vector<uint32_t>(prompt.begin(), prompt.begin() + 5));
+    auto continued = model->beam_search(std::vector<uint32_t>(prompt.begin() + 5, prompt.end()), options, {});
+    if (continued.size() != beams.size() || continued[0].tokens != beams[0].tokens ||
+        model->get_cache_size() != prompt.size()) {
+        return false;
+    }
+
+    options.temperatures = {0.0f, 1.0f};
+    options.logprob_threshold = 0.0f;
+    model->reset_cache();
+    beams = model->beam_search(prompt, options, {});
+    return !beams.empty() && beams[0].temperature == 1.0f && beams[0].tokens.size() == 8;
+}
+
+// Scoring a window mid-conversation must leave the conversation's cache exactly where it was.
+bool test_score_window_keeps_cache(const std::string& root) {
+    const auto info = synthetic::write_bundle(tiny_spec("dense"), root + "/score_keep");
+    auto model = cactus::engine::create_model(info.dir);
+    if (!model || !model->init(info.dir, 256, "", false)) return false;
+    std::vector<uint32_t> prompt, window;
+    for (uint32_t i = 0; i < 20; ++i) prompt.push_back(65 + (i * 5) % 26);
+    for (uint32_t i = 0; i < 40; ++i) window.push_back(65 + (i * 11) % 26);
+
+    auto continue_from = [&](bool score, size_t& cache_len, double& logprob) {
+        model->reset_cache();
+        uint32_t token = 0;
+        std::vector<uint32_t> out;
+        if (!model->prefill_and_sample_first_token(prompt, token)) return out;
+        cache_len = model->get_cache_size();
+        if (score) logprob = model->score_tokens_window_logprob(window, 24, window.size(), 0, nullptr);
+        if (model->get_cache_size() != cache_len) return out;
+        for (int step = 0; step < 6; ++step) out.push_back(token = model->decode({token}));
+        return out;
+    };
+    size_t plain_len = 0, scored_len = 0;
+    double logprob = 0.0;
+    const auto plain = continue_from(false, plain_len, logprob);
+    const auto scored = continue_from(true, scored_len, logprob);
+    return plain.size() == 6 && plain == scored && plain_len == scored_len && logprob < 0.0;
+}
+
+bool test_deterministic_weights(const std::string& root) {
+    auto spec = tiny_spec("dense");
+    auto a = synthetic::write_bundle(spec, root + "/seed_a");
+    auto b = synthetic::write_bundle(spec, root + "/seed_b");
+    auto read = [](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+    const std::string weight = "/weights/layers.1.mlp.down_proj.weights";
+    spec.seed += 1;
+    auto c = synthetic::write_bundle(spec, root + "/seed_c");
+    return a.parameter_count == b.parameter_count &&
+           read(a.dir + weight) == read(b.dir + weight) &&
+           read(a.dir + weight) != read(c.dir + weight);
+}
+
+bool test_unknown_architecture() {
+    try {
+        synthetic::preset("transformer-xl");
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int main() {
+    TestRunner runner("Synthetic Model Tests");
+    const std::string root = bundle_root();
+    for (const auto& arch : synthetic::architectures()) {
+        runner.run_test("synthetic_" + arch, test_architecture(arch, root));
+    }
+    runner.run_test("lowbit_kv_cache_scoring", test_lowbit_kv_cache_scoring(root));
+    runner.run_test("beam_search", test_beam_search(root));
+    runner.run_test("score_window_keeps_cache", test_score_window_keeps_cache(root));
+    runner.run_test("deterministic_weights", test_deterministic_weights(root));
+    runner.run_test("unknown_architecture", test_unknown_architecture());
+    std::filesystem::remove_all(root);
+    runner.print_summary();
+    return runner.all_passed() ? 0 : 1;
+}
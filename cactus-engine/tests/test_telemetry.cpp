@@ -150,6 +150,168 @@ bool test_record_and_flush_race_no_deadlock() {
     return all_completed && event_count == expected_event_count;
 }
 
+bool test_local_sink_receives_events() {
+    const std::string cache_dir = make_temp_dir("cactus_telemetry_sink");
+    const std::string sink_file = cache_dir + "/sink.jsonl";
+
+    cactus::telemetry::setTelemetryEnvironment("cpp-test", cache_dir.c_str());
+    cactus::telemetry::setCloudDisabled(true);
+    cactus::telemetry::setLocalSink(sink_file.c_str());
+    cactus::telemetry::init("telemetry-test-project", "local-sink", nullptr);
+
+    constexpr int expected_event_count = 300;
+    for (int i = 0; i < expected_event_count; ++i) {
+        cactus::telemetry::recordCompletion("sink-model", true, 3.0, 40.0, 12.0, 8, "sink");
+    }
+    cactus::telemetry::flush();
+
+    const int event_count = count_events(sink_file);
+    std::ifstream in(sink_file);
+    std::string first_line;
+    std::getline(in, first_line);
+
+    cactus::telemetry::shutdown();
+    cactus::telemetry::setLocalSink(nullptr);
+    std::remove(sink_file.c_str());
+    std::remove((cache_dir + "/completion.log").c_str());
+    rmdir(cache_dir.c_str());
+
+    return event_count == expected_event_count &&
+           first_line.find("\"event_type\":\"completion\"") != std::string::npos &&
+           first_line.find("\"model\":\"sink-model\"") != std::string::npos;
+}
+
+// init() applies CACTUS_TELEMETRY_SINK while the worker may be writing a batch to the sink; the two
+// must not take the IO lock and the telemetry lock in opposite orders.
+bool test_env_sink_init_while_writing_no_deadlock() {
+    const std::string cache_dir = make_temp_dir("cactus_telemetry_env_sink");
+    const std::string sink_file = cache_dir + "/sink.jsonl";
+
+    cactus::telemetry::setTelemetryEnvironment("cpp-test", cache_dir.c_str());
+    cactus::telemetry::setCloudDisabled(true);
+    setenv("CACTUS_TELEMETRY_SINK", sink_file.c_str(), 1);
+    cactus::telemetry::init("telemetry-test-project", "env-sink", nullptr);
+
+    auto& pool = CactusThreading::get_thread_pool();
+    std::vector<std::future<void>> futures;
+    futures.push_back(pool.enqueue([]() {
+        for (int j = 0; j < 2000; ++j) {
+            cactus::telemetry::recordCompletion("env-sink-model", true, 1.0, 1.0, 2.0, 1, "env-sink");
+        }
+    }));
+    futures.push_back(pool.enqueue([]() {
+        for (int j = 0; j < 200; ++j) {
+            cactus::telemetry::init("telemetry-test-project", "env-sink", nullptr);
+        }
+    }));
+
+    bool all_completed = true;
+    for (auto& future : futures) {
+        if (future.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+            all_completed = false;
+            break;
+        }
+        future.get();
+    }
+    unsetenv("CACTUS_TELEMETRY_SINK");
+    if (!all_completed) return false;
+    cactus::telemetry::flush();
+    const int delivered = count_events(sink_file);
+
+    cactus::telemetry::shutdown();
+    cactus::telemetry::setLocalSink(nullptr);
+    std::remove(sink_file.c_str());
+    std::remove((cache_dir + "/completion.log").c_str());
+    rmdir(cache_dir.c_str());
+    return delivered > 0;
+}
+
+bool run_drop_policy_case(cactus::telemetry::DropPolicy policy, const char* scope) {
+    const std::string cache_dir = make_temp_dir("cactus_telemetry_drop");
+    const std::string sink_file = cache_dir + "/sink.jsonl";
+
+    cactus::telemetry::setTelemetryEnvironment("cpp-test", cache_dir.c_str());
+    cactus::telemetry::setCloudDisabled(true);
+    cactus::telemetry::setLocalSink(sink_file.c_str());
+    cactus::telemetry::setQueueOptions(16, policy);
+    cactus::telemetry::init("telemetry-test-project", scope, nullptr);
+
+    constexpr int producer_tasks = 4;
+    constexpr int records_per_task = 2000;
+    const uint64_t dropped_before = cactus::telemetry::droppedEventCount();
+
+    auto& pool = CactusThreading::get_thread_pool();
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < producer_tasks; ++i) {
+        futures.push_back(pool.enqueue([]() {
+            for (int j = 0; j < records_per_task; ++j) {
+                cactus::telemetry::recordCompletion("drop-model", true, 1.0, 1.0, 2.0, 1, "drop");
+            }
+        }));
+    }
+    bool all_completed = true;
+    for (auto& future : futures) {
+        if (future.wait_for(std::chrono::seconds(30)) != std::future_status::ready) {
+            all_completed = false;
+            break;
+        }
+        future.get();
+    }
+    cactus::telemetry::flush();
+
+    const uint64_t dropped = cactus::telemetry::droppedEventCount() - dropped_before;
+    const int delivered = count_events(sink_file);
+
+    cactus::telemetry::shutdown();
+    cactus::telemetry::setLocalSink(nullptr);
+    cactus::telemetry::setQueueOptions(0, cactus::telemetry::DropPolicy::DropNewest);
+    std::remove(sink_file.c_str());
+    std::remove((cache_dir + "/completion.log").c_str());
+    rmdir(cache_dir.c_str());
+
+    const uint64_t total = static_cast<uint64_t>(producer_tasks) * records_per_task;
+    if (policy == cactus::telemetry::DropPolicy::Block) {
+        return all_completed && dropped == 0 && static_cast<uint64_t>(delivered) == total;
+    }
+    return all_completed && static_cast<uint64_t>(delivered) + dropped == total;
+}
+
+bool test_drop_policies_account_for_every_event() {
+    return run_drop_policy_case(cactus::telemetry::DropPolicy::DropNewest, "drop-newest") &&
+           run_drop_policy_case(cactus::telemetry::DropPolicy::DropOldest, "drop-oldest") &&
+           run_drop_policy_case(cactus::telemetry::DropPolicy::Block, "block");
+}
+
+void benchmark_record_latency(TestUtils::TestRunner& runner) {
+    const std::string cache_dir = make_temp_dir("cactus_telemetry_bench");
+
+    cactus::telemetry::setTelemetryEnvironment("cpp-test", cache_dir.c_str());
+    cactus::telemetry::setCloudDisabled(true);
+    cactus::telemetry::init("telemetry-test-project", "bench", nullptr);
+
+    cactus::telemetry::CompletionMetrics metrics{};
+    metrics.success = true;
+    metrics.ttft_ms = 12.0;
+    metrics.decode_tps = 30.0;
+    metrics.decode_tokens = 1;
+
+    constexpr int iterations = 512;
+    EngineTestUtils::Timer timer;
+    for (int i = 0; i < iterations; ++i) {
+        cactus::telemetry::recordCompletion("/models/bench-model", metrics);
+    }
+    const double record_ns = timer.elapsed_ms() * 1e6 / iterations;
+
+    cactus::telemetry::flush();
+    cactus::telemetry::shutdown();
+    std::remove((cache_dir + "/completion.log").c_str());
+    rmdir(cache_dir.c_str());
+
+    char details[128];
+    std::snprintf(details, sizeof(details), "%.0f ns/event on the recording thread", record_ns);
+    runner.log_performance("record_completion", details);
+}
+
 enum class CloudTelemetryTestResult {
     Passed,
     Failed,
@@ -192,12 +354,16 @@ int main() {
     runner.run_test("Record many then Flush", test_record_many_then_flush());
     runner.run_test("Shutdown then Reinit", test_shutdown_then_reinit_then_record());
     runner.run_test("Record and Flush Race", test_record_and_flush_race_no_deadlock());
+    runner.run_test("Local Sink", test_local_sink_receives_events());
+    runner.run_test("Env Sink Init Race", test_env_sink_init_while_writing_no_deadlock());
+    runner.run_test("Drop Policies", test_drop_policies_account_for_every_event());
     CloudTelemetryTestResult cloud_result = test_cloud_upload_record_then_flush();
     if (cloud_result == CloudTelemetryTestResult::Skipped) {
         runner.log_skip("Cloud record + Flush", "--enable-telemetry and resolved cloud key (env/cache) required");
     } else {
         runner.run_test("Cloud record + Flush", cloud_result == CloudTelemetryTestResult::Passed);
     }
+    benchmark_record_latency(runner);
     runner.print_summary();
     return runner.all_passed() ? 0 : 1;
 }
@@ -0,0 +1,445 @@
+#include "test_utils.h"
+#include "../src/engine.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace TestUtils;
+using namespace cactus::engine;
+
+namespace {
+
+const std::string kMetaspace = "\xE2\x96\x81";
+
+std::string temp_dir(const std::string& tag) {
+    auto dir = std::filesystem::temp_directory_path() / ("cactus_tokenizer_" + tag + "_" + std::to_string(getpid()));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+std::string make_corpus(size_t bytes, uint32_t seed) {
+    static const char* words[] = {
+        "the", "model", "token", "cactus", "graph", "kernel", "quantized", "attention", "cache", "prefill",
+        "decode", "weights", "int8", "layer", "tensor", "batch", "thread", "memory", "mobile", "latency",
+        "café", "naïve", "日本語", "テキスト", "привет", "🙂", "x86", "arm64", "\t", "\n", "  ", "{\"a\": 1}",
+    };
+    std::mt19937 rng(seed);
+    std::string text;
+    while (text.size() < bytes) {
+        if (!text.empty()) text += (rng() % 9 == 0) ? ", " : " ";
+        text += words[rng() % (sizeof(words) / sizeof(words[0]))];
+        if (rng() % 97 == 0) text += static_cast<char>(rng() % 256);
+    }
+    return text;
+}
+
+bool has_space(const std::string& s) {
+    return s.find_first_of(" \t\n\r\v\f") != std::string::npos;
+}
+
+bool has_line_break(const std::string& s) {
+    return s.find_first_of("\n\r") != std::string::npos;
+}
+
+std::vector<std::string> split_chars(const std::string& text) {
+    std::vector<std::string> chars;
+    size_t i = 0;
+    while (i < text.size()) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        size_t len = (c & 0x80) == 0 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+        if (i + len <= text.size()) chars.push_back(text.substr(i, len));
+        i += len;
+    }
+    return chars;
+}
+
+std::vector<std::string> byte_level_alphabet() {
+    std::vector<std::string> table(256);
+    int next = 256;
+    for (int b = 0; b < 256; ++b) {
+        int cp = (b >= 33 && b <= 126) || (b >= 161 && b <= 255) ? b : next++;
+        if (cp < 0x80) {
+            table[b] = std::string(1, static_cast<char>(cp));
+        } else {
+            table[b] += static_cast<char>(0xC0 | (cp >> 6));
+            table[b] += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+    return table;
+}
+
+struct ReferenceBPE {
+    std::map<std::string, uint32_t> vocab;
+    std::map<std::pair<std::string, std::string>, uint32_t> ranks;
+    std::vector<std::string> byte_table;
+    bool metaspace = false;
+    bool byte_fallback = false;
+
+    std::vector<std::string> symbols(const std::string& text) const {
+        if (!metaspace) {
+            std::vector<std::string> out;
+            for (unsigned char c : text) out.push_back(byte_table[c]);
+            return out;
+        }
+        std::string normalized;
+        for (char c : text) normalized += c == ' ' ? kMetaspace : std::string(1, c);
+        return split_chars(normalized);
+    }
+
+    std::vector<std::string> merge(std::vector<std::string> parts) const {
+        while (parts.size() > 1) {
+            size_t best = parts.size();
+            uint32_t best_rank = UINT32_MAX;
+            for (size_t i = 0; i + 1 < parts.size(); ++i) {
+                auto it = ranks.find({parts[i], parts[i + 1]});
+                if (it != ranks.end() && it->second < best_rank) {
+                    best_rank = it->second;
+                    best = i;
+                }
+            }
+            if (best == parts.size()) break;
+            parts[best] += parts[best + 1];
+            parts.erase(parts.begin() + best + 1);
+        }
+        return parts;
+    }
+
+    std::vector<uint32_t> encode(const std::string& text) const {
+        std::vector<uint32_t> ids;
+        for (const auto& token : merge(symbols(text))) {
+            auto it = vocab.find(token);
+            if (it != vocab.end()) {
+                ids.push_back(it->second);
+                continue;
+            }
+            std::vector<uint32_t> fallback;
+            for (unsigned char c : token) {
+                char name[7];
+                std::snprintf(name, sizeof(name), "<0x%02X>", c);
+                auto byte_it = vocab.find(name);
+                if (!byte_fallback || byte_it == vocab.end()) {
+                    fallback.clear();
+                    break;
+                }
+                fallback.push_back(byte_it->second);
+            }
+            if (fallback.empty()) fallback.push_back(0);
+            ids.insert(ids.end(), fallback.begin(), fallback.end());
+        }
+        return ids;
+    }
+};
+
+ReferenceBPE train_reference(const std::string& corpus, bool metaspace, size_t num_merges) {
+    ReferenceBPE ref;
+    ref.metaspace = metaspace;
+    ref.byte_fallback = metaspace;
+    ref.byte_table = byte_level_alphabet();
+
+    std::vector<std::string> tokens = {"<unk>"};
+    if (metaspace) {
+        for (int b = 0; b < 256; ++b) {
+            char name[7];
+            std::snprintf(name, sizeof(name), "<0x%02X>", b);
+            tokens.push_back(name);
+        }
+        auto chars = ref.symbols(corpus);
+        std::sort(chars.begin(), chars.end());
+        chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+        for (size_t i = 0; i < chars.size(); ++i) {
+            if (i % 7 != 3 && !has_line_break(chars[i])) tokens.push_back(chars[i]);
+        }
+    } else {
+        tokens.insert(tokens.end(), ref.byte_table.begin(), ref.byte_table.end());
+    }
+
+    std::vector<std::vector<std::string>> lines;
+    size_t start = 0;
+    while (start < corpus.size()) {
+        size_t end = std::min(corpus.size(), start + 48);
+        lines.push_back(ref.symbols(corpus.substr(start, end - start)));
+        start = end;
+    }
+
+    for (size_t m = 0; m < num_merges; ++m) {
+        std::map<std::pair<std::string, std::string>, size_t> counts;
+        for (const auto& line : lines) {
+            for (size_t i = 0; i + 1 < line.size(); ++i) {
+                if (!has_space(line[i]) && !has_space(line[i + 1])) counts[{line[i], line[i + 1]}]++;
+            }
+        }
+        if (counts.empty()) break;
+        auto best = std::max_element(counts.begin(), counts.end(),
+                                     [](const auto& a, const auto& b) { return a.second < b.second; });
+        const auto pair = best->first;
+        ref.ranks.emplace(pair, static_cast<uint32_t>(m));
+        if (!metaspace || m % 11 != 5) tokens.push_back(pair.first + pair.second);
+        for (auto& line : lines) {
+            for (size_t i = 0; i + 1 < line.size(); ++i) {
+                if (line[i] == pair.first && line[i + 1] == pair.second) {
+                    line[i] += line[i + 1];
+                    line.erase(line.begin() + i + 1);
+                }
+            }
+        }
+    }
+
+    for (const auto& token : tokens) ref.vocab.emplace(token, static_cast<uint32_t>(ref.vocab.size()));
+    return ref;
+}
+
+void write_special_tokens(const std::string& dir, size_t first_id) {
+    std::ofstream out(dir + "/special_tokens.json");
+    out << "{\n  \"special_tokens\": {\n";
+    out << "    \"" << first_id << "\": \"<|im_start|>\",\n";
+    out << "    \"" << first_id + 1 << "\": \"<|im_end|>\"\n  }\n}\n";
+}
+
+std::string write_sp_tokenizer(const std::string& tag, const ReferenceBPE& ref, const std::string& model_type = "") {
+    const std::string dir = temp_dir(tag);
+    std::vector<std::string> tokens(ref.vocab.size());
+    for (const auto& [token, id] : ref.vocab) tokens[id] = token;
+    size_t next_id = 0;
+    {
+        std::ofstream vocab(dir + "/vocab.txt", std::ios::binary);
+        for (const auto& token : tokens) {
+            if (token.find_first_of("\t\n\r") != std::string::npos) continue;
+            vocab << next_id << '\t' << token << '\t' << -static_cast<float>(next_id % 97) << '\n';
+            ++next_id;
+        }
+        vocab << next_id << "\t<|im_start|>\n" << next_id + 1 << "\t<|im_end|>\n";
+    }
+    write_special_tokens(dir, next_id);
+    std::ofstream config(dir + "/config.txt");
+    config << "unk_token_id=0\nsp_add_dummy_prefix=true\nsp_byte_fallback=true\n";
+    if (!model_type.empty()) config << "sp_model_type=" << model_type << '\n';
+    return dir;
+}
+
+std::string make_prompt(size_t bytes, uint32_t seed) {
+    std::string text;
+    uint32_t part = 0;
+    while (text.size() < bytes) {
+        text += (part % 2 == 0) ? "<|im_start|>user\n" : "<|im_end|>\n";
+        text += make_corpus(6000 + (part * 7919) % 20000, seed + part);
+        ++part;
+    }
+    return text;
+}
+
+std::string write_tokenizer(const std::string& tag, const ReferenceBPE& ref) {
+    const std::string dir = temp_dir(tag);
+    std::vector<std::string> tokens(ref.vocab.size());
+    for (const auto& [token, id] : ref.vocab) tokens[id] = token;
+    {
+        std::ofstream vocab(dir + "/vocab.txt", std::ios::binary);
+        for (uint32_t id = 0; id < tokens.size(); ++id) vocab << id << '\t' << tokens[id] << '\n';
+        vocab << tokens.size() << "\t<|im_start|>\n" << tokens.size() + 1 << "\t<|im_end|>\n";
+    }
+    write_special_tokens(dir, tokens.size());
+    std::vector<std::pair<std::string, std::string>> merges(ref.ranks.size());
+    for (const auto& [pair, rank] : ref.ranks) merges[rank] = pair;
+    {
+        std::ofstream out(dir + "/merges.txt", std::ios::binary);
+        out << "#version: 0.2\n";
+        for (const auto& [a, b] : merges) out << a << ' ' << b << '\n';
+    }
+    {
+        std::ofstream config(dir + "/config.txt");
+        config << "vocab_format=id_tab_token\n";
+        config << (ref.metaspace ? "normalizer=metaspace\ndecoder=replace_metaspace\nbyte_fallback=true\n"
+                                 : "normalizer=byte_level\ndecoder=byte_level\n");
+        config << "unk_token_id=0\n";
+    }
+    return dir;
+}
+
+bool check_matches_reference(bool metaspace) {
+    const std::string corpus = make_corpus(24 * 1024, metaspace ? 11 : 5);
+    ReferenceBPE ref = train_reference(corpus, metaspace, 160);
+    const std::string dir = write_tokenizer(metaspace ? "metaspace" : "byte_level", ref);
+
+    BPETokenizer tokenizer;
+    bool ok = tokenizer.load_vocabulary_with_config(dir + "/vocab.txt", dir + "/merges.txt", dir + "/config.txt");
+
+    const std::string sample = make_corpus(64 * 1024, 23);
+    for (size_t pos = 0; ok && pos < sample.size(); pos += 777) {
+        const std::string piece = sample.substr(pos, 777);
+        ok = tokenizer.encode(piece) == ref.encode(piece);
+        if (ok && !metaspace) ok = tokenizer.decode(tokenizer.encode(piece)) == piece;
+    }
+    ok = ok && tokenizer.encode(sample.substr(0, 4096)) == ref.encode(sample.substr(0, 4096));
+
+    std::filesystem::remove_all(dir);
+    return ok;
+}
+
+bool test_byte_level_matches_reference() {
+    return check_matches_reference(false);
+}
+
+bool test_metaspace_fallback_matches_reference() {
+    return check_matches_reference(true);
+}
+
+bool test_bpe_parallel_matches_serial() {
+    bool ok = true;
+    for (bool metaspace : {false, true}) {
+        ReferenceBPE ref = train_reference(make_corpus(24 * 1024, 3), metaspace, 160);
+        const std::string dir = write_tokenizer(metaspace ? "parallel_metaspace" : "parallel_byte_level", ref);
+
+        BPETokenizer tokenizer;
+        ok = ok && tokenizer.load_vocabulary_with_config(dir + "/vocab.txt", dir + "/merges.txt", dir + "/config.txt");
+        const std::string prompt = make_prompt(300 * 1024, 41);
+        const auto serial = tokenizer.encode(prompt);
+        ok = ok && tokenizer.encode_parallel(prompt) == serial;
+        ok = ok && tokenizer.encode_parallel(make_corpus(200 * 1024, 43)) == tokenizer.encode(make_corpus(200 * 1024, 43));
+        ok = ok && std::count(serial.begin(), serial.end(), static_cast<uint32_t>(ref.vocab.size())) > 0;
+
+        std::filesystem::remove_all(dir);
+    }
+    return ok;
+}
+
+bool test_sp_parallel_matches_serial() {
+    ReferenceBPE ref = train_reference(make_corpus(24 * 1024, 13), true, 160);
+    const std::string dir = write_sp_tokenizer("parallel_sp", ref);
+
+    SPTokenizer tokenizer;
+    bool ok = tokenizer.load_vocabulary_with_config(dir + "/vocab.txt", "", dir + "/config.txt");
+    const std::string prompt = make_prompt(300 * 1024, 47);
+    ok = ok && tokenizer.encode_parallel(prompt) == tokenizer.encode(prompt);
+    ok = ok && tokenizer.encode_parallel(make_corpus(200 * 1024, 53)) == tokenizer.encode(make_corpus(200 * 1024, 53));
+
+    std::filesystem::remove_all(dir);
+    return ok;
+}
+
+bool test_sp_unigram_viterbi() {
+    const std::string dir = temp_dir("sp_unigram");
+    {
+        std::ofstream vocab(dir + "/vocab.txt", std::ios::binary);
+        vocab << "0\t<unk>\t0\n";
+        vocab << "1\t" << kMetaspace << "ab\t-5\n";
+        vocab << "2\tc\t-1\n";
+        vocab << "3\t" << kMetaspace << "\t-1\n";
+        vocab << "4\tabc\t-1\n";
+        vocab << "5\ta\t-3\n";
+        vocab << "6\tb\t-3\n";
+    }
+    const std::string base_config = "unk_token_id=0\nsp_add_dummy_prefix=true\n";
+
+    std::ofstream(dir + "/config.txt") << base_config;
+    SPTokenizer greedy;
+    bool ok = greedy.load_vocabulary_with_config(dir + "/vocab.txt", "", dir + "/config.txt");
+    ok = ok && greedy.encode("abc") == std::vector<uint32_t>{1, 2};
+
+    std::ofstream(dir + "/config.txt") << base_config << "sp_model_type=unigram\n";
+    SPTokenizer unigram;
+    ok = ok && unigram.load_vocabulary_with_config(dir + "/vocab.txt", "", dir + "/config.txt");
+    ok = ok && unigram.encode("abc") == std::vector<uint32_t>{3, 4};
+    ok = ok && unigram.encode("abcxyz") == std::vector<uint32_t>{3, 4, 0};
+    ok = ok && unigram.encode("abc ba") == std::vector<uint32_t>{3, 4, 3, 6, 5};
+
+    std::filesystem::remove_all(dir);
+    return ok;
+}
+
+bool test_sp_unigram_parallel_matches_serial() {
+    ReferenceBPE ref = train_reference(make_corpus(24 * 1024, 17), true, 160);
+    const std::string dir = write_sp_tokenizer("parallel_sp_unigram", ref, "unigram");
+
+    SPTokenizer tokenizer;
+    bool ok = tokenizer.load_vocabulary_with_config(dir + "/vocab.txt", "", dir + "/config.txt");
+    const std::string prompt = make_prompt(300 * 1024, 59);
+    ok = ok && tokenizer.encode_parallel(prompt) == tokenizer.encode(prompt);
+
+    std::filesystem::remove_all(dir);
+    return ok;
+}
+
+void run_sp_benchmarks(TestRunner& runner) {
+    ReferenceBPE ref = train_reference(make_corpus(24 * 1024, 7), true, 160);
+    const std::string text = make_corpus(4 * 1024 * 1024, 37);
+    for (const char* model_type : {"", "unigram", "bpe"}) {
+        const std::string name = std::string("sp_encode") + (*model_type ? "_" : "") + model_type;
+        const std::string dir = write_sp_tokenizer("bench_" + name, ref, model_type);
+
+        SPTokenizer tokenizer;
+        if (!tokenizer.load_vocabulary_with_config(dir + "/vocab.txt", "", dir + "/config.txt")) {
+            runner.log_skip(name, "tokenizer failed to load");
+            std::filesystem::remove_all(dir);
+            continue;
+        }
+
+        size_t tokens = 0;
+        EngineTestUtils::Timer timer;
+        for (size_t pos = 0; pos < text.size(); pos += 16 * 1024) {
+            tokens += tokenizer.encode(text.substr(pos, 16 * 1024)).size();
+        }
+        const double ms = timer.elapsed_ms();
+
+        char details[128];
+        std::snprintf(details, sizeof(details), "%.1f MB/s, %zu tokens in %.1f ms",
+                      text.size() / (ms / 1000.0) / 1e6, tokens, ms);
+        runner.log_performance(name, details);
+        std::filesystem::remove_all(dir);
+    }
+}
+
+void run_benchmarks(TestRunner& runner) {
+    const std::string corpus = make_corpus(24 * 1024, 5);
+    ReferenceBPE ref = train_reference(corpus, false, 160);
+    const std::string dir = write_tokenizer("bench", ref);
+
+    BPETokenizer tokenizer;
+    if (!tokenizer.load_vocabulary_with_config(dir + "/vocab.txt", dir + "/merges.txt", dir + "/config.txt")) {
+        runner.log_skip("bpe_encode", "tokenizer failed to load");
+        return;
+    }
+
+    const std::string text = make_corpus(4 * 1024 * 1024, 31);
+    size_t tokens = 0;
+    EngineTestUtils::Timer timer;
+    for (size_t pos = 0; pos < text.size(); pos += 16 * 1024) {
+        tokens += tokenizer.encode(text.substr(pos, 16 * 1024)).size();
+    }
+    const double ms = timer.elapsed_ms();
+
+    char details[128];
+    std::snprintf(details, sizeof(details), "%.1f MB/s, %zu tokens in %.1f ms",
+                  text.size() / (ms / 1000.0) / 1e6, tokens, ms);
+    runner.log_performance("bpe_encode", details);
+
+    timer = EngineTestUtils::Timer();
+    tokens = tokenizer.encode_parallel(text).size();
+    const double parallel_ms = timer.elapsed_ms();
+    std::snprintf(details, sizeof(details), "%.1f MB/s, %zu tokens in %.1f ms",
+                  text.size() / (parallel_ms / 1000.0) / 1e6, tokens, parallel_ms);
+    runner.log_performance("bpe_encode_parallel", details);
+    std::filesystem::remove_all(dir);
+}
+
+}  // namespace
+
+int main() {
+    TestUtils::TestRunner runner("Tokenizer Tests");
+    runner.run_test("byte_level_matches_reference", test_byte_level_matches_reference());
+    runner.run_test("metaspace_fallback_matches_reference", test_metaspace_fallback_matches_reference());
+    runner.run_test("bpe_parallel_matches_serial", test_bpe_parallel_matches_serial());
+    runner.run_test("sp_parallel_matches_serial", test_sp_parallel_matches_serial());
+    runner.run_test("sp_unigram_viterbi", test_sp_unigram_viterbi());
+    runner.run_test("sp_unigram_parallel_matches_serial", test_sp_unigram_parallel_matches_serial());
+    run_benchmarks(runner);
+    run_sp_benchmarks(runner);
+    runner.print_summary();
+    return runner.all_passed() ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include "test_utils.h"
+#include "../src/vision_cache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace TestUtils;
+using namespace cactus::engine;
+
+namespace {
+
+std::string temp_dir(const std::string& tag) {
+    auto dir = std::filesystem::temp_directory_path() / ("cactus_vision_cache_" + tag + "_" + std::to_string(getpid()));
+    std::filesystem::remove_all(dir);
+    return dir.string();
+}
+
+VisionCacheEntry make_entry(size_t rows, size_t hidden, uint8_t fill) {
+    VisionCacheEntry entry;
+    VisionCacheEntry::Output out;
+    out.name = "image_features";
+    out.shape = {rows, hidden};
+    out.precision = Precision::FP16;
+    out.bytes.assign(rows * hidden * 2, fill);
+    entry.outputs.push_back(std::move(out));
+    entry.grid_h = rows;
+    entry.grid_w = 4;
+    return entry;
+}
+
+bool test_key_depends_on_content_and_salt() {
+    VisionFeatureCache a, b;
+    a.configure(1 << 20, "", "model-a");
+    b.configure(1 << 20, "", "model-b");
+
+    std::vector<uint8_t> img(100003);
+    for (size_t i = 0; i < img.size(); ++i) img[i] = static_cast<uint8_t>(i * 31 + 7);
+
+    const std::string path = temp_dir("key") + ".bin";
+    {
+        std::ofstream f(path, std::ios::binary);
+        f.write(reinterpret_cast<const char*>(img.data()), static_cast<std::streamsize>(img.size()));
+    }
+
+    VisionCacheKey from_file, from_bytes, other_salt, flipped;
+    bool ok = a.key_for_file(path, from_file) && a.key_for_bytes(img.data(), img.size(), from_bytes)
+           && b.key_for_bytes(img.data(), img.size(), other_salt);
+    img[img.size() / 2] ^= 1;
+    ok = ok && a.key_for_bytes(img.data(), img.size(), flipped);
+    std::remove(path.c_str());
+
+    VisionCacheKey missing;
+    return ok && from_file == from_bytes && !(from_file == other_salt) && !(from_file == flipped)
+        && !a.key_for_file(path, missing);
+}
+
+bool test_lru_evicts_to_budget() {
+    const size_t entry_bytes = make_entry(16, 64, 0).byte_size();
+    VisionFeatureCache cache;
+    cache.configure(entry_bytes * 2 + entry_bytes / 2, "", "lru");
+
+    VisionCacheKey k1{1, 1}, k2{2, 2}, k3{3, 3};
+    cache.insert(k1, make_entry(16, 64, 1));
+    cache.insert(k2, make_entry(16, 64, 2));
+    if (!cache.find(k1)) return false;
+    cache.insert(k3, make_entry(16, 64, 3));
+
+    auto hit1 = cache.find(k1);
+    return cache.size() == 2 && hit1 && hit1->outputs[0].bytes[0] == 1
+        && !cache.find(k2) && cache.find(k3) && cache.resident_bytes() <= entry_bytes * 2 + entry_bytes / 2;
+}
+
+bool test_disk_tier_round_trip() {
+    const std::string dir = temp_dir("disk");
+    VisionCacheKey key{0x1234, 0x5678};
+    {
+        VisionFeatureCache writer;
+        writer.configure(1 << 20, dir, "disk");
+        VisionCacheEntry entry = make_entry(8, 32, 9);
+        entry.outputs[0].bytes[5] = 42;
+        writer.insert(key, std::move(entry));
+    }
+
+    VisionFeatureCache reader;
+    reader.configure(1 << 20, dir, "disk");
+    auto hit = reader.find(key);
+    const bool ok = hit && reader.disk_hits() == 1 && hit->outputs.size() == 1
+        && hit->outputs[0].name == "image_features" && hit->outputs[0].shape == std::vector<size_t>{8, 32}
+        && hit->outputs[0].precision == Precision::FP16 && hit->outputs[0].bytes.size() == 8 * 32 * 2
+        && hit->outputs[0].bytes[5] == 42 && hit->grid_h == 8 && hit->grid_w == 4
+        && reader.find(key) && reader.disk_hits() == 1;
+    std::filesystem::remove_all(dir);
+    return ok;
+}
+
+bool test_disk_tier_rejects_corrupt_entries() {
+    const std::string dir = temp_dir("corrupt");
+    VisionCacheKey mismatched{0xa, 0xb}, truncated{0xc, 0xd}, inflated{0xe, 0xf};
+    {
+        VisionFeatureCache writer;
+        writer.configure(1 << 20, dir, "corrupt");
+        VisionCacheEntry entry = make_entry(8, 32, 3);
+        entry.outputs[0].bytes.resize(100);
+        writer.insert(mismatched, std::move(entry));
+        writer.insert(truncated, make_entry(8, 32, 4));
+        writer.insert(inflated, make_entry(8, 32, 5));
+    }
+    for (const auto& file : std::filesystem::directory_iterator(dir)) {
+        const std::string name = file.path().filename().string();
+        if (name.rfind(truncated.hex(), 0) == 0) {
+            std::filesystem::resize_file(file.path(), std::filesystem::file_size(file.path()) / 2);
+        } else if (name.rfind(inflated.hex(), 0) == 0) {
+            // num_outputs follows magic, version, the key and the grid.
+            std::fstream f(file.path(), std::ios::binary | std::ios::in | std::ios::out);
+            const uint32_t huge = 0xffffffffu;
+            f.seekp(4 + 4 + 8 + 8 + 3 * 8);
+            f.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+        }
+    }
+
+    VisionFeatureCache reader;
+    reader.configure(1 << 20, dir, "corrupt");
+    const bool ok = !reader.find(mismatched) && !reader.find(truncated) && !reader.find(inflated)
+        && reader.disk_hits() == 0;
+    std::filesystem::remove_all(dir);
+    return ok;
+}
+
+bool test_disabled_cache_stores_nothing() {
+    VisionFeatureCache cache;
+    cache.configure(0, "", "off");
+    cache.insert(VisionCacheKey{7, 7}, make_entry(4, 4, 1));
+    return !cache.enabled() && cache.size() == 0 && !cache.find(VisionCacheKey{7, 7});
+}
+
+} // namespace
+
+int main() {
+    TestUtils::TestRunner runner("Vision Feature Cache Tests");
+    runner.run_test("key_depends_on_content_and_salt", test_key_depends_on_content_and_salt());
+    runner.run_test("lru_evicts_to_budget", test_lru_evicts_to_budget());
+    runner.run_test("disk_tier_round_trip", test_disk_tier_round_trip());
+    runner.run_test("disk_tier_rejects_corrupt_entries", test_disk_tier_rejects_corrupt_entries());
+    runner.run_test("disabled_cache_stores_nothing", test_disabled_cache_stores_nothing());
+    runner.print_summary();
+    return runner.all_passed() ? 0 : 1;
+}
@@ -11,8 +11,10 @@
 #include <cstring>
 #include <cstdlib>
 #include <stdexcept>
+#include <limits>
 #include <string>
 #include <mutex>
+#include <atomic>
 #include <sstream>
 #include <iostream>
 #include <arm_neon.h>
@@ -118,7 +120,10 @@ enum class OpType {
     SCALAR_NOT_EQUAL,
     RECURRENT_CACHE_STATE,
     RECURRENT_CACHE_WRITE,
-    CONV_CACHE_INITIALIZE
+    CONV_CACHE_INITIALIZE,
+    CONV2D,
+    RMS_NORM_MATMUL,
+    QKV_ROPE_CACHE_APPEND
 };
 
 struct PrecisionTraits {
@@ -229,6 +234,7 @@ struct BufferDesc {
     size_t byte_size;
     std::unique_ptr<char[]> data;
     void* external_data;
+    std::shared_ptr<void> external_owner;   // keeps external_data alive when the buffer owns it (e.g. an mmap)
     char* pooled_data;
     Precision precision;
 
@@ -373,6 +379,9 @@ struct OpParams {
     size_t cache_sink_size = 0;
     size_t cache_slot = 0;
     size_t cache_num_slots = 1;
+    size_t padding = 0;
+    bool nhwc_input = false;
+    bool nhwc_output = false;
 
     size_t hop_length = 0;
     float power = 2.0f;
@@ -452,6 +461,157 @@ namespace GraphFile {
     struct SerializedGraph;
 }
 
+struct ExpertResidencyConfig {
+    size_t budget_bytes = 0;
+    float pin_fraction = 0.5f;
+    bool lock_hot = true;
+    size_t prefetch_experts = 0;
+    float decay = 0.97f;
+    size_t rebalance_interval = 8;
+};
+
+struct ExpertLayerStats {
+    size_t node_id = 0;
+    size_t num_experts = 0;
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t prefetches = 0;
+    uint64_t prefetch_hits = 0;
+    uint64_t major_faults = 0;
+    size_t resident = 0;
+    size_t pinned = 0;
+
+    double hit_rate() const { return lookups ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0; }
+};
+
+// Page residency for mmapped MoE expert weights: routing frequency picks hot experts to pin,
+// co-activation counts between consecutive MoE layers pick experts to prefetch, and cold
+// experts are released once resident expert bytes exceed the budget.
+class ExpertResidency {
+public:
+    using ExpertFiles = std::vector<GraphFile::MappedFile*>;
+
+    void configure(const ExpertResidencyConfig& config) { config_ = config; }
+    const ExpertResidencyConfig& config() const { return config_; }
+    bool enabled() const { return config_.budget_bytes > 0; }
+    bool attached() const { return attached_; }
+
+    void add_layer(size_t node_id, size_t top_k, std::vector<ExpertFiles> experts);
+    void mark_attached() { attached_ = true; retained_.clear(); }
+    void detach();
+
+    void before_layer(const GraphNode& node, const nodes_vector& nodes, const node_index_map_t& node_index_map);
+    void after_layer(const GraphNode& node);
+    void end_pass();
+
+    std::vector<ExpertLayerStats> stats() const;
+    void reset_stats();
+    size_t resident_bytes() const { return resident_bytes_; }
+    size_t pinned_bytes() const { return pinned_bytes_; }
+    bool lock_failed() const { return lock_failed_; }
+
+private:
+    enum class State : uint8_t { COLD, RESIDENT, PINNED };
+
+    struct Expert {
+        ExpertFiles files;
+        size_t bytes = 0;
+        float score = 0.0f;
+        uint64_t last_used = 0;
+        State state = State::COLD;
+        bool prefetched = false;
+        bool locked = false;
+    };
+
+    struct Layer {
+        size_t node_id = 0;
+        size_t top_k = 0;
+        std::vector<Expert> experts;
+        std::vector<uint16_t> transitions;
+        std::vector<uint32_t> last_topk;
+        std::vector<uint32_t> selected;
+        uint64_t observed_pass = 0;
+        long faults_before = 0;
+        ExpertLayerStats stats;
+    };
+
+    void make_resident(Expert& expert, bool prefetch);
+    void release(Expert& expert);
+    void pin(Expert& expert);
+    void unpin(Expert& expert);
+    void record_transitions(Layer& prev, const Layer& cur, size_t tokens);
+    void prefetch_next(size_t layer_idx);
+    void enforce_budget(size_t active_layer);
+    void rebalance_pins();
+
+    ExpertResidencyConfig config_;
+    std::vector<Layer> layers_;
+    std::unordered_map<size_t, size_t> layer_of_node_;
+    std::vector<ExpertLayerStats> retained_;
+    std::vector<uint32_t> topk_scratch_;
+    std::vector<float> score_scratch_;
+    size_t resident_bytes_ = 0;
+    size_t pinned_bytes_ = 0;
+    uint64_t tick_ = 0;
+    uint64_t pass_ = 1;
+    bool attached_ = false;
+    bool lock_failed_ = false;
+};
+
+// Chrome trace (viewable in Perfetto) for execute(): one span per node with bytes moved and estimated
+// FLOPs, parallel_for chunk spans from whichever thread ran them, and BufferPool occupancy counters.
+// Events are appended to a JSON array that is left open so successive executions share one file.
+class GraphProfiler {
+public:
+    GraphProfiler() = default;
+    ~GraphProfiler();
+    GraphProfiler(const GraphProfiler&) = delete;
+    GraphProfiler& operator=(const GraphProfiler&) = delete;
+
+    static bool wants_chrome_trace(const std::string& target);
+
+    void begin(const std::string& path);
+    void end();
+    bool active() const { return active_; }
+
+    void enter_node(const GraphNode& node, const char* op_name);
+    void record_node(const GraphNode& node, const char* op_name, const nodes_vector& nodes,
+                     const node_index_map_t& node_index_map, uint64_t begin_ns, uint64_t end_ns);
+    void record_pool(const BufferPool& pool, size_t fresh_bytes, uint64_t ts_ns);
+    void record_chunk(size_t start_idx, size_t end_idx, uint64_t begin_ns, uint64_t end_ns);
+
+private:
+    struct Span {
+        const char* name;
+        uint64_t begin_ns;
+        uint64_t end_ns;
+        uint32_t tid;
+        size_t node_id;
+        size_t start_idx;
+        size_t end_idx;
+        size_t bytes_read;
+        size_t bytes_written;
+        double flops;
+        std::string shape;
+    };
+
+    struct PoolSample {
+        uint64_t ts_ns;
+        size_t active_bytes;
+        size_t pool_bytes;
+        size_t fresh_bytes;
+    };
+
+    std::string path_;
+    std::vector<Span> node_spans_;
+    std::vector<Span> chunk_spans_;
+    std::vector<PoolSample> pool_samples_;
+    std::mutex chunk_mutex_;
+    std::atomic<const char*> current_op_{nullptr};
+    std::atomic<size_t> current_node_{0};
+    bool active_ = false;
+};
+
 class CactusGraph {
 public:
     CactusGraph();
@@ -535,6 +695,7 @@ public:
         ComputeBackend backend = ComputeBackend::CPU);
 
     size_t rms_norm(size_t input, size_t weight, float epsilon = 1e-5f);
+    size_t rms_norm_matmul(size_t input, size_t norm_weight, size_t weight, float epsilon = 1e-5f);
     size_t layernorm(size_t input, size_t weight, size_t bias, float epsilon = 1e-5f);
     size_t layernorm(size_t input, size_t weight, float epsilon = 1e-5f);
     size_t groupnorm(size_t input, size_t weight, size_t bias, size_t num_groups = 32, float epsilon = 1e-5f);
@@ -591,6 +752,24 @@ public:
         size_t v_head_dim = 0,
         size_t cache_slot = 0);
 
+    // Projects Q/K/V from one normalized activation, applies RoPE to Q and K, and appends K/V to
+    // their caches in the caches' own storage format. Returns the rotated Q [1, T, Hq, head_dim];
+    // attend with attention_cached(q, q, q, k_cache, v_cache, scale, SIZE_MAX - 1). The RoPE
+    // position of the first token is explicit: a windowed cache's length stops tracking it.
+    size_t qkv_rope_cache_append(
+        size_t input,
+        size_t q_weight,
+        size_t k_weight,
+        size_t v_weight,
+        size_t k_cache_state,
+        size_t v_cache_state,
+        size_t head_dim,
+        float theta,
+        size_t position_offset,
+        size_t window_size = 0,
+        size_t sink_size = 4,
+        size_t cache_slot = 0);
+
     size_t conv_cache_state(size_t window_size, size_t hidden_dim);
     size_t conv_cache_append(size_t new_data, size_t cache_state_node);
     size_t conv_cache_initialize(size_t rows, size_t cache_state_node);
@@ -615,6 +794,10 @@ public:
     size_t conv2d_pointwise_1x1(size_t input, size_t weight, size_t bias);
     size_t conv2d_k3s1p1(size_t input, size_t weight);
     size_t conv2d_k3s1p1(size_t input, size_t weight, size_t bias);
+    size_t conv2d(size_t input, size_t weight, size_t stride = 1, size_t padding = 0, size_t dilation = 1,
+                  size_t groups = 1, bool nhwc_input = false, bool nhwc_output = false);
+    size_t conv2d(size_t input, size_t weight, size_t bias, size_t stride, size_t padding, size_t dilation,
+                  size_t groups, bool nhwc_input = false, bool nhwc_output = false);
     size_t stft(size_t input, size_t weight, size_t stride, size_t num_fft_bins);
 
     size_t rfft(size_t input);
@@ -696,6 +879,8 @@ public:
     void release_weight_pages(size_t node_id);
     void prefetch_weight_pages(size_t node_id);
     void release_all_weight_pages();
+    void configure_expert_residency(const ExpertResidencyConfig& config);
+    std::vector<ExpertLayerStats> expert_residency_stats() const { return expert_residency_.stats(); }
     void release_runtime_buffers();
     void clear_buffer_pool();
     void retain_outputs(const std::vector<int>& node_ids);
@@ -723,8 +908,17 @@ public:
     size_t get_node_sink_size(size_t node_id) const;
     size_t get_node_cache_num_slots(size_t node_id) const;
     void resize_cache_slots(size_t node_id, size_t num_slots);
+    void copy_cache_slot(size_t node_id, size_t src_slot, size_t dst_slot);
+    void reslot_cache(size_t node_id, size_t num_slots, size_t src_slot, size_t dst_slot);
+    void share_cache_prefix(size_t node_id, size_t num_slots, size_t src_slot, size_t tail_rows);
+    bool cache_slots_supported(size_t node_id) const;
+    void set_cache_slot(size_t slot);
     void steal_cache_buffer(size_t dst_node, CactusGraph& src, size_t src_node);
+    // Moves a cache state's storage out (the node re-initializes empty on the next execute) and back.
+    BufferDesc take_cache_buffer(size_t node_id);
+    void restore_cache_buffer(size_t node_id, BufferDesc buffer);
     void shrink_cache_buffer(size_t node_id, size_t new_capacity);
+    void reserve_cache_buffer(size_t node_id, size_t min_capacity);
     std::vector<uint8_t> snapshot_cache_padded_append(size_t node_id, size_t real_tokens, size_t pad_tokens) const;
     void rollback_cache_padded_append(size_t node_id, size_t real_tokens, size_t pad_tokens,
                                       const std::vector<uint8_t>& backup);
@@ -743,10 +937,12 @@ private:
     size_t reduction_op(OpType op, size_t input, int axis);
     size_t attach_conv_bias(size_t node, size_t bias, size_t expected_size, const char* op_name);
     static CactusGraph from_serialized(const GraphFile::SerializedGraph& serialized);
+    void attach_expert_residency();
     size_t next_node_id_;
     std::vector<std::unique_ptr<GraphFile::MappedFile>> mapped_files_;
     std::unordered_map<std::string, size_t> weight_cache_;
     std::unordered_map<size_t, size_t> node_to_mapped_file_;
+    ExpertResidency expert_residency_;
     std::vector<DebugNodeEntry> debug_nodes_;
     BufferPool buffer_pool_;
     bool prefill_mode_ = false;
@@ -812,6 +1008,9 @@ namespace GraphFile {
         template<typename T> const T* typed_data() const;
         void release_pages();
         void prefetch_pages();
+        bool lock_pages();
+        void unlock_pages();
+        size_t mapped_bytes() const { return byte_size_ + scales_bytes_; }
 
     private:
         int fd_;
@@ -981,6 +1180,8 @@ CACTUS_FFI_EXPORT int cactus_graph_batchnorm(
 CACTUS_FFI_EXPORT int cactus_graph_topk(cactus_graph_t graph, cactus_node_t input, size_t k, cactus_node_t* out);
 CACTUS_FFI_EXPORT int cactus_graph_rms_norm(
     cactus_graph_t graph, cactus_node_t input, cactus_node_t weight, float epsilon, cactus_node_t* out);
+CACTUS_FFI_EXPORT int cactus_graph_rms_norm_matmul(
+    cactus_graph_t graph, cactus_node_t input, cactus_node_t norm_weight, cactus_node_t weight, float epsilon, cactus_node_t* out);
 CACTUS_FFI_EXPORT int cactus_graph_rope(
     cactus_graph_t graph, cactus_node_t input, float theta, size_t position_offset, int32_t backend, cactus_node_t* out);
 CACTUS_FFI_EXPORT int cactus_graph_rope_gptj(
@@ -999,6 +1200,10 @@ CACTUS_FFI_EXPORT int cactus_graph_kv_cache_state(
     cactus_graph_t graph, size_t max_seq_len, size_t num_kv_heads, size_t head_dim, size_t window_size, size_t sink_size, size_t num_slots, cactus_node_t* out);
 CACTUS_FFI_EXPORT int cactus_graph_kv_cache_append(
     cactus_graph_t graph, cactus_node_t new_kv, cactus_node_t cache_state, size_t window_size, size_t sink_size, cactus_node_t* out);
+CACTUS_FFI_EXPORT int cactus_graph_qkv_rope_cache_append(
+    cactus_graph_t graph, cactus_node_t input, cactus_node_t q_weight, cactus_node_t k_weight, cactus_node_t v_weight,
+    cactus_node_t k_cache_state, cactus_node_t v_cache_state, size_t head_dim, float theta, size_t position_offset,
+    size_t window_size, size_t sink_size, cactus_node_t* out);
 CACTUS_FFI_EXPORT int cactus_graph_attention_cached(
     cactus_graph_t graph, cactus_node_t query, cactus_node_t key_new, cactus_node_t value_new,
     cactus_node_t k_cache_state, cactus_node_t v_cache_state,
@@ -1055,6 +1260,9 @@ CACTUS_FFI_EXPORT int cactus_graph_conv2d_depthwise_k3s2p1(
     cactus_graph_t graph, cactus_node_t input, cactus_node_t weight, bool has_bias, cactus_node_t bias, cactus_node_t* out);
 CACTUS_FFI_EXPORT int cactus_graph_conv2d_pointwise_1x1(
     cactus_graph_t graph, cactus_node_t input, cactus_node_t weight, bool has_bias, cactus_node_t bias, cactus_node_t* out);
+CACTUS_FFI_EXPORT int cactus_graph_conv2d(
+    cactus_graph_t graph, cactus_node_t input, cactus_node_t weight, bool has_bias, cactus_node_t bias,
+    size_t stride, size_t padding, size_t dilation, size_t groups, bool nhwc_input, bool nhwc_output, cactus_node_t* out);
 
 CACTUS_FFI_EXPORT int cactus_graph_lstm_cell(
     cactus_graph_t graph, cactus_node_t input, cactus_node_t h_prev, cactus_node_t c_prev, cactus_node_t weight_ih, cactus_node_t weight_hh, cactus_node_t bias_ih, cactus_node_t bias_hh, cactus_node_t* out);
@@ -255,6 +255,28 @@ size_t CactusGraph::rms_norm(size_t input, size_t weight, float epsilon) {
     return add_node(OpType::RMS_NORM, {input, weight}, {}, params);
 }
 
+size_t CactusGraph::rms_norm_matmul(size_t input, size_t norm_weight, size_t weight, float epsilon) {
+    const auto& input_buffer = get_output_buffer(input);
+    const auto& weight_buffer = get_output_buffer(weight);
+    if (input_buffer.shape.empty()) {
+        throw std::runtime_error("rms_norm_matmul expects non-scalar input");
+    }
+    if (!weight_buffer.is_cq() || weight_buffer.shape.size() != 2) {
+        throw std::runtime_error("rms_norm_matmul expects a 2D CQ weight");
+    }
+    if (weight_buffer.shape[1] != input_buffer.shape.back()) {
+        throw std::runtime_error("rms_norm_matmul weight [N, K] does not match input K");
+    }
+
+    std::vector<size_t> output_shape = input_buffer.shape;
+    output_shape.back() = weight_buffer.shape[0];
+
+    OpParams params;
+    params.epsilon = epsilon;
+    params.output_precision = Precision::FP16;
+    return add_node(OpType::RMS_NORM_MATMUL, {input, norm_weight, weight}, output_shape, params);
+}
+
 size_t CactusGraph::rope(size_t input, float theta, size_t position_offset, ComputeBackend backend) {
     OpParams params{.theta = theta, .position_offset = position_offset, .backend = backend};
     return add_node(OpType::ROPE, {input}, {}, params);
@@ -1266,6 +1288,17 @@ void CactusGraph::resize_cache_slots(size_t node_id, size_t num_slots) {
     node.output_buffer.data.reset();
 }
 
+// Batch-1 appends and cached attention read params.cache_slot; batched rows always map row i to
+// slot i, so this only redirects single-row steps.
+void CactusGraph::set_cache_slot(size_t slot) {
+    for (auto& node : nodes_) {
+        if (node->op_type == OpType::KV_CACHE_APPEND || node->op_type == OpType::ATTENTION_CACHED ||
+            node->op_type == OpType::QKV_ROPE_CACHE_APPEND) {
+            node->params.cache_slot = slot;
+        }
+    }
+}
+
 size_t CactusGraph::persistent(size_t source_node) {
     const auto& source_buffer = get_output_buffer(source_node);
     OpParams params;
@@ -1399,6 +1432,60 @@ size_t CactusGraph::conv2d_k3s1p1(size_t input, size_t weight, size_t bias) {
     return attach_conv_bias(node, bias, get_output_buffer(node).shape[1], "conv2d_k3s1p1");
 }
 
+size_t CactusGraph::conv2d(size_t input, size_t weight, size_t stride, size_t padding, size_t dilation,
+                           size_t groups, bool nhwc_input, bool nhwc_output) {
+    const auto& xin = get_output_buffer(input);
+    const auto& w = get_output_buffer(weight);
+
+    if (xin.shape.size() != 4) {
+        throw std::runtime_error(nhwc_input ? "conv2d expects input [N, H, W, C_in]"
+                                            : "conv2d expects input [N, C_in, H, W]");
+    }
+    if (w.shape.size() != 4) {
+        throw std::runtime_error("conv2d weight must be [C_out, C_in / groups, KH, KW]");
+    }
+    if (stride == 0 || dilation == 0 || groups == 0) {
+        throw std::runtime_error("conv2d stride, dilation and groups must be > 0");
+    }
+
+    const size_t N = xin.shape[0];
+    const size_t C_in = nhwc_input ? xin.shape[3] : xin.shape[1];
+    const size_t H = nhwc_input ? xin.shape[1] : xin.shape[2];
+    const size_t W = nhwc_input ? xin.shape[2] : xin.shape[3];
+    const size_t C_out = w.shape[0];
+    const size_t KH = w.shape[2];
+    const size_t KW = w.shape[3];
+
+    if (C_in % groups != 0 || C_out % groups != 0 || w.shape[1] != C_in / groups) {
+        throw std::runtime_error("conv2d weight must match [C_out, C_in / groups, KH, KW]");
+    }
+    const size_t eff_kh = dilation * (KH - 1) + 1;
+    const size_t eff_kw = dilation * (KW - 1) + 1;
+    if (KH == 0 || KW == 0 || H + 2 * padding < eff_kh || W + 2 * padding < eff_kw) {
+        throw std::runtime_error("conv2d kernel does not fit the padded input");
+    }
+    const size_t H_out = (H + 2 * padding - eff_kh) / stride + 1;
+    const size_t W_out = (W + 2 * padding - eff_kw) / stride + 1;
+
+    OpParams params{};
+    params.output_precision = xin.precision;
+    params.stride = stride;
+    params.padding = padding;
+    params.dilation = dilation;
+    params.num_groups = groups;
+    params.nhwc_input = nhwc_input;
+    params.nhwc_output = nhwc_output;
+    std::vector<size_t> out_shape = nhwc_output ? std::vector<size_t>{N, H_out, W_out, C_out}
+                                                : std::vector<size_t>{N, C_out, H_out, W_out};
+    return add_node(OpType::CONV2D, {input, weight}, out_shape, params);
+}
+
+size_t CactusGraph::conv2d(size_t input, size_t weight, size_t bias, size_t stride, size_t padding, size_t dilation,
+                           size_t groups, bool nhwc_input, bool nhwc_output) {
+    size_t node = conv2d(input, weight, stride, padding, dilation, groups, nhwc_input, nhwc_output);
+    return attach_conv_bias(node, bias, get_output_buffer(weight).shape[0], "conv2d");
+}
+
 size_t CactusGraph::stats_pool(size_t input) {
     const auto& xin = get_output_buffer(input);
     size_t batch = xin.shape[0];
@@ -1453,6 +1540,57 @@ size_t CactusGraph::kv_cache_append(size_t new_kv, size_t cache_state_node,
     return add_node(OpType::KV_CACHE_APPEND, {new_kv, cache_state_node}, {1}, params);
 }
 
+size_t CactusGraph::qkv_rope_cache_append(size_t input, size_t q_weight, size_t k_weight, size_t v_weight,
+                                          size_t k_cache_state, size_t v_cache_state, size_t head_dim, float theta,
+                                          size_t position_offset, size_t window_size, size_t sink_size,
+                                          size_t cache_slot) {
+    if (get_node_op_type(k_cache_state) != OpType::KV_CACHE_STATE ||
+        get_node_op_type(v_cache_state) != OpType::KV_CACHE_STATE) {
+        throw std::runtime_error("qkv_rope_cache_append expects kv_cache_state nodes for its caches");
+    }
+    const auto& cache_params = nodes_[node_index_map_.at(k_cache_state)]->params;
+    const size_t kv_heads = cache_params.num_kv_heads;
+    if (head_dim == 0 || head_dim % 2 != 0 || cache_params.head_dim != head_dim ||
+        nodes_[node_index_map_.at(v_cache_state)]->params.head_dim != head_dim) {
+        throw std::runtime_error("qkv_rope_cache_append head_dim must be even and match both caches");
+    }
+    if (position_offset == std::numeric_limits<size_t>::max()) {
+        throw std::runtime_error("qkv_rope_cache_append needs an explicit RoPE position");
+    }
+
+    const auto& input_buffer = get_output_buffer(input);
+    if (input_buffer.shape.empty()) {
+        throw std::runtime_error("qkv_rope_cache_append expects non-scalar input");
+    }
+    const size_t hidden = input_buffer.shape.back();
+    const size_t tokens = input_buffer.total_size / hidden;
+    auto projection_rows = [&](size_t weight) {
+        const auto& shape = get_output_buffer(weight).shape;
+        if (shape.size() != 2 || shape[1] != hidden) {
+            throw std::runtime_error("qkv_rope_cache_append weights must be [N, " + std::to_string(hidden) + "]");
+        }
+        return shape[0];
+    };
+    const size_t q_rows = projection_rows(q_weight);
+    if (q_rows % head_dim != 0 || projection_rows(k_weight) != kv_heads * head_dim ||
+        projection_rows(v_weight) != kv_heads * head_dim) {
+        throw std::runtime_error("qkv_rope_cache_append projection widths do not match the head layout");
+    }
+
+    OpParams params{};
+    params.theta = theta;
+    params.position_offset = position_offset;
+    params.window_size = window_size;
+    params.cache_sink_size = sink_size;
+    params.cache_slot = cache_slot;
+    params.num_kv_heads = kv_heads;
+    params.head_dim = head_dim;
+    params.output_precision = Precision::FP16;
+    return add_node(OpType::QKV_ROPE_CACHE_APPEND,
+                    {input, q_weight, k_weight, v_weight, k_cache_state, v_cache_state},
+                    {1, tokens, q_rows / head_dim, head_dim}, params);
+}
+
 size_t CactusGraph::conv_cache_state(size_t ws, size_t hidden_dim) {
     size_t total_bytes = sizeof(uint64_t) * 8 + ws * hidden_dim * sizeof(__fp16);
     OpParams params{};
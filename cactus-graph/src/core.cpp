@@ -80,6 +80,7 @@ BufferDesc::BufferDesc(BufferDesc&& other) noexcept
       byte_size(other.byte_size),
       data(std::move(other.data)),
       external_data(other.external_data),
+      external_owner(std::move(other.external_owner)),
       pooled_data(other.pooled_data),
       precision(other.precision),
       dynamic_dims(std::move(other.dynamic_dims)),
@@ -127,6 +128,7 @@ BufferDesc& BufferDesc::operator=(BufferDesc&& other) noexcept {
         byte_size = other.byte_size;
         data = std::move(other.data);
         external_data = other.external_data;
+        external_owner = std::move(other.external_owner);
         pooled_data = other.pooled_data;
         precision = other.precision;
         dynamic_dims = std::move(other.dynamic_dims);
@@ -26,6 +26,8 @@ DECLARE_COMPUTE(compute_reshape_node);
 DECLARE_COMPUTE(compute_precision_cast_node);
 DECLARE_COMPUTE(compute_matmul_node);
 DECLARE_COMPUTE(compute_rms_norm_node);
+DECLARE_COMPUTE(compute_rms_norm_matmul_node);
+DECLARE_COMPUTE(compute_qkv_rope_cache_append_node);
 DECLARE_COMPUTE(compute_rope_node);
 DECLARE_COMPUTE(compute_softmax_node);
 DECLARE_COMPUTE(compute_attention_node);
@@ -55,6 +57,7 @@ DECLARE_COMPUTE(compute_gaussian_topk_node);
 DECLARE_COMPUTE(compute_maxpool1d_node);
 DECLARE_COMPUTE(compute_bilstm_sequence_node);
 DECLARE_COMPUTE(compute_conv2d_k3s1p1_node);
+DECLARE_COMPUTE(compute_conv2d_node);
 DECLARE_COMPUTE(compute_stats_pool_node);
 DECLARE_COMPUTE(compute_weighted_stats_pool_node);
 DECLARE_COMPUTE(compute_transpose_node);
@@ -87,7 +90,7 @@ DECLARE_COMPUTE(compute_spectrogram_node);
 extern void shrink_thread_local_buffers();
 #undef DECLARE_COMPUTE
 
-static constexpr int OP_TYPE_COUNT = static_cast<int>(OpType::CONV_CACHE_INITIALIZE) + 1;
+static constexpr int OP_TYPE_COUNT = static_cast<int>(OpType::QKV_ROPE_CACHE_APPEND) + 1;
 static_assert(OP_TYPE_COUNT <= 256, "OpType dispatch table overflow");
 static ComputeFn dispatch_flat[OP_TYPE_COUNT] = {};
 
@@ -183,6 +186,9 @@ static bool init_dispatch() {
     dispatch_flat[static_cast<int>(OpType::RECURRENT_CACHE_STATE)] = compute_recurrent_cache_state_node;
     dispatch_flat[static_cast<int>(OpType::RECURRENT_CACHE_WRITE)] = compute_recurrent_cache_write_node;
     dispatch_flat[static_cast<int>(OpType::CONV_CACHE_INITIALIZE)] = compute_conv_cache_initialize_node;
+    dispatch_flat[static_cast<int>(OpType::CONV2D)] = compute_conv2d_node;
+    dispatch_flat[static_cast<int>(OpType::RMS_NORM_MATMUL)] = compute_rms_norm_matmul_node;
+    dispatch_flat[static_cast<int>(OpType::QKV_ROPE_CACHE_APPEND)] = compute_qkv_rope_cache_append_node;
     dispatch_flat[static_cast<int>(OpType::IMAGE_PREPROCESS)] = compute_image_preprocess_node;
     dispatch_flat[static_cast<int>(OpType::RFFT)] = compute_rfft_node;
     dispatch_flat[static_cast<int>(OpType::IRFFT)] = compute_irfft_node;
@@ -233,7 +239,10 @@ static const char* op_type_names[] = {
     "NOT_EQUAL", "SCALAR_NOT_EQUAL",
     "RECURRENT_CACHE_STATE",
     "RECURRENT_CACHE_WRITE",
-    "CONV_CACHE_INITIALIZE"
+    "CONV_CACHE_INITIALIZE",
+    "CONV2D",
+    "RMS_NORM_MATMUL",
+    "QKV_ROPE_CACHE_APPEND"
 };
 
 static const char* get_op_name(OpType op) {
@@ -318,6 +327,18 @@ std::vector<size_t> infer_output_shape(const GraphNode& node, const nodes_vector
             out.back() = node.params.pretransposed_rhs ? rhs[rhs.size() - 2] : rhs[rhs.size() - 1];
             return out;
         }
+        case OpType::RMS_NORM_MATMUL: {
+            std::vector<size_t> out = in(0);
+            out.back() = in(2)[0];
+            return out;
+        }
+        case OpType::QKV_ROPE_CACHE_APPEND: {
+            std::vector<size_t> out = node.output_buffer.shape;
+            size_t tokens = 1;
+            for (size_t i = 0; i + 1 < in(0).size(); ++i) tokens *= in(0)[i];
+            out[1] = tokens;
+            return out;
+        }
         case OpType::ADD: case OpType::ADD_CLIPPED: case OpType::SUBTRACT:
         case OpType::MULTIPLY: case OpType::DIVIDE: case OpType::NOT_EQUAL:
             return BroadcastInfo::compute(in(0), in(1)).output_shape;
@@ -434,6 +455,18 @@ void CactusGraph::execute(const std::string& profile_file) {
     const size_t n = nodes_.size();
     infer_shapes();
 
+    const bool track_experts = expert_residency_.enabled();
+    if (track_experts && !expert_residency_.attached()) attach_expert_residency();
+    auto dispatch_tracked = [&](GraphNode& node) {
+        if (!track_experts || node.op_type != OpType::MOE_LAYER) {
+            dispatch_node(node, nodes_, node_index_map_);
+            return;
+        }
+        expert_residency_.before_layer(node, nodes_, node_index_map_);
+        dispatch_node(node, nodes_, node_index_map_);
+        expert_residency_.after_layer(node);
+    };
+
     auto get_env_int = [](const char* name, int fallback) -> int {
         const char* val = std::getenv(name);
         return val ? std::atoi(val) : fallback;
@@ -561,7 +594,7 @@ void CactusGraph::execute(const std::string& profile_file) {
             if (preallocates_output(*node)) {
                 node->output_buffer.resize_from_pool(pool);
             }
-            dispatch_node(*node, nodes_, node_index_map_);
+            dispatch_tracked(*node);
             trace_nonfinite(i, *node);
             if (node->op_type == OpType::PERSISTENT) {
                 populated_node_ids_.insert(node->id);
@@ -570,6 +603,7 @@ void CactusGraph::execute(const std::string& profile_file) {
                 nodes_[release_idx]->output_buffer.release_memory(pool);
             }
         }
+        if (track_experts) expert_residency_.end_pass();
         return;
     }
 
@@ -602,11 +636,15 @@ void CactusGraph::execute(const std::string& profile_file) {
 
     bool enable_profiling = !target_profile.empty();
     bool to_stdout = (target_profile == "stdout" || target_profile == "-");
+    bool chrome_trace = enable_profiling && !to_stdout && GraphProfiler::wants_chrome_trace(target_profile);
 
     std::ofstream profile_out;
     std::ostream* out = &std::cout;
+    GraphProfiler profiler;
 
-    if (enable_profiling && !to_stdout) {
+    if (chrome_trace) {
+        profiler.begin(target_profile);
+    } else if (enable_profiling && !to_stdout) {
         profile_out.open(target_profile, std::ios::app);
         if (profile_out.is_open()) {
             out = &profile_out;
@@ -615,7 +653,7 @@ void CactusGraph::execute(const std::string& profile_file) {
 
     auto total_start = std::chrono::high_resolution_clock::now();
 
-    if (enable_profiling) {
+    if (enable_profiling && !chrome_trace) {
         *out << "=== Graph Execution Profile ===" << std::endl;
         *out << std::left << std::setw(24) << "Operation"
              << std::setw(12) << "Time (ms)"
@@ -646,6 +684,8 @@ void CactusGraph::execute(const std::string& profile_file) {
             continue;
         }
 
+        const size_t active_before = pool.active_bytes();
+        const size_t pooled_before = pool.pool_bytes();
         node->output_buffer.allocate_from_pool(pool);
 
         if (trace_execution) {
@@ -660,9 +700,22 @@ void CactusGraph::execute(const std::string& profile_file) {
             std::cerr << "]" << std::endl;
         }
 
-        if (enable_profiling) {
+        if (chrome_trace) {
+            const char* op_name = get_op_name(node->op_type);
+            const size_t fresh_bytes = (pool.active_bytes() - active_before) - (pooled_before - pool.pool_bytes());
+            const uint64_t begin_ns = CactusThreading::trace_clock_ns();
+            profiler.record_pool(pool, fresh_bytes, begin_ns);
+            profiler.enter_node(*node, op_name);
+            dispatch_tracked(*node);
+            const uint64_t end_ns = CactusThreading::trace_clock_ns();
+            profiler.record_node(*node, op_name, nodes_, node_index_map_, begin_ns, end_ns);
+            trace_nonfinite(node_idx, *node);
+            if (node->op_type == OpType::PERSISTENT) {
+                populated_node_ids_.insert(node->id);
+            }
+        } else if (enable_profiling) {
             auto start = std::chrono::high_resolution_clock::now();
-            dispatch_node(*node, nodes_, node_index_map_);
+            dispatch_tracked(*node);
             trace_nonfinite(node_idx, *node);
             if (node->op_type == OpType::PERSISTENT) {
                 populated_node_ids_.insert(node->id);
@@ -681,7 +734,7 @@ void CactusGraph::execute(const std::string& profile_file) {
                  << std::setw(12) << std::fixed << std::setprecision(3) << ms
                  << std::setw(20) << shape_str << std::endl;
         } else {
-            dispatch_node(*node, nodes_, node_index_map_);
+            dispatch_tracked(*node);
             trace_nonfinite(node_idx, *node);
             if (node->op_type == OpType::PERSISTENT) {
                 populated_node_ids_.insert(node->id);
@@ -695,6 +748,7 @@ void CactusGraph::execute(const std::string& profile_file) {
                       << std::endl;
         }
     }
+    if (track_experts) expert_residency_.end_pass();
 
     std::unique_ptr<std::ofstream> capture_file_stream;
     std::vector<std::ostream*> capture_outputs;
@@ -933,7 +987,9 @@ void CactusGraph::execute(const std::string& profile_file) {
         }
     }
 
-    if (enable_profiling) {
+    if (chrome_trace) {
+        profiler.end();
+    } else if (enable_profiling) {
         auto total_end = std::chrono::high_resolution_clock::now();
         auto total_duration = std::chrono::duration_cast<std::chrono::microseconds>(total_end - total_start);
         double total_ms = total_duration.count() / 1000.0;
@@ -949,6 +1005,8 @@ void CactusGraph::execute(const std::string& profile_file) {
 }
 
 void CactusGraph::hard_reset() {
+    expert_residency_.detach();
+    expert_residency_.reset_stats();
     nodes_.clear();
     node_index_map_.clear();
     mapped_files_.clear();
@@ -0,0 +1,342 @@
+#include "../cactus_graph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sys/resource.h>
+
+namespace {
+
+long major_faults_now() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_majflt;
+}
+
+constexpr float RESIDENCY_HYSTERESIS = 0.9f;
+constexpr uint16_t TRANSITION_SATURATION = 0xFFFF;
+
+} // namespace
+
+void ExpertResidency::add_layer(size_t node_id, size_t top_k, std::vector<ExpertFiles> experts) {
+    Layer layer;
+    layer.node_id = node_id;
+    layer.top_k = top_k;
+    layer.experts.resize(experts.size());
+    for (size_t e = 0; e < experts.size(); ++e) {
+        Expert& expert = layer.experts[e];
+        expert.files = std::move(experts[e]);
+        for (const auto* file : expert.files) expert.bytes += file->mapped_bytes();
+    }
+    layer.stats.node_id = node_id;
+    layer.stats.num_experts = layer.experts.size();
+    for (const auto& kept : retained_) {
+        if (kept.node_id == node_id && kept.num_experts == layer.experts.size()) layer.stats = kept;
+    }
+
+    if (!layers_.empty()) {
+        Layer& prev = layers_.back();
+        prev.transitions.assign(prev.experts.size() * layer.experts.size(), 0);
+    }
+    layer_of_node_[node_id] = layers_.size();
+    layers_.push_back(std::move(layer));
+}
+
+void ExpertResidency::detach() {
+    // Counters outlive the page bookkeeping so stats can still be read after weights are released
+    // or rebound; a later attach resumes them.
+    if (!layers_.empty()) {
+        retained_ = stats();
+        for (auto& s : retained_) s.resident = s.pinned = 0;
+    }
+    for (auto& layer : layers_) {
+        for (auto& expert : layer.experts) {
+            if (expert.state == State::PINNED) unpin(expert);
+        }
+    }
+    layers_.clear();
+    layer_of_node_.clear();
+    resident_bytes_ = 0;
+    pinned_bytes_ = 0;
+    attached_ = false;
+}
+
+void ExpertResidency::make_resident(Expert& expert, bool prefetch) {
+    for (auto* file : expert.files) file->prefetch_pages();
+    expert.state = State::RESIDENT;
+    expert.prefetched = prefetch;
+    resident_bytes_ += expert.bytes;
+}
+
+void ExpertResidency::release(Expert& expert) {
+    if (expert.state == State::PINNED) unpin(expert);
+    for (auto* file : expert.files) file->release_pages();
+    expert.state = State::COLD;
+    expert.prefetched = false;
+    resident_bytes_ -= expert.bytes;
+}
+
+void ExpertResidency::pin(Expert& expert) {
+    if (expert.state == State::COLD) make_resident(expert, false);
+    if (config_.lock_hot && !lock_failed_) {
+        bool locked = true;
+        for (auto* file : expert.files) locked = file->lock_pages() && locked;
+        if (locked) {
+            expert.locked = true;
+        } else {
+            for (auto* file : expert.files) file->unlock_pages();
+            lock_failed_ = true;
+            CACTUS_LOG_WARN("graph", "mlock of hot MoE experts failed (RLIMIT_MEMLOCK?); keeping them unlocked");
+        }
+    }
+    expert.state = State::PINNED;
+    expert.prefetched = false;
+    pinned_bytes_ += expert.bytes;
+}
+
+void ExpertResidency::unpin(Expert& expert) {
+    if (expert.locked) {
+        for (auto* file : expert.files) file->unlock_pages();
+        expert.locked = false;
+    }
+    expert.state = State::RESIDENT;
+    pinned_bytes_ -= expert.bytes;
+}
+
+void ExpertResidency::before_layer(const GraphNode& node, const nodes_vector& nodes, const node_index_map_t& node_index_map) {
+    auto it = layer_of_node_.find(node.id);
+    if (it == layer_of_node_.end()) return;
+    const size_t layer_idx = it->second;
+    Layer& layer = layers_[layer_idx];
+
+    const auto& topk_buffer = get_input(node, 2, nodes, node_index_map);
+    if (topk_buffer.precision != Precision::FP32 || topk_buffer.shape.size() != 2) return;
+    const size_t tokens = topk_buffer.shape[0];
+    const size_t k = topk_buffer.shape[1];
+    const size_t num_experts = layer.experts.size();
+    const float* topk = topk_buffer.data_as<float>();
+
+    ++tick_;
+    topk_scratch_.assign(num_experts, 0);
+    layer.last_topk.resize(tokens * k);
+    for (size_t i = 0; i < tokens * k; ++i) {
+        const float raw = topk[i];
+        size_t e = (std::isfinite(raw) && raw >= 0.0f) ? static_cast<size_t>(raw + 0.5f) : num_experts;
+        if (e >= num_experts) e = num_experts;
+        layer.last_topk[i] = static_cast<uint32_t>(e);
+        if (e < num_experts) topk_scratch_[e]++;
+    }
+
+    const float inv_tokens = tokens > 0 ? 1.0f / static_cast<float>(tokens) : 0.0f;
+    layer.selected.clear();
+    for (size_t e = 0; e < num_experts; ++e) {
+        Expert& expert = layer.experts[e];
+        expert.score *= config_.decay;
+        if (topk_scratch_[e] == 0) continue;
+
+        expert.score += static_cast<float>(topk_scratch_[e]) * inv_tokens;
+        expert.last_used = tick_;
+        layer.selected.push_back(static_cast<uint32_t>(e));
+        layer.stats.lookups++;
+        if (expert.state == State::COLD) {
+            make_resident(expert, false);
+        } else {
+            layer.stats.hits++;
+            if (expert.prefetched) layer.stats.prefetch_hits++;
+            expert.prefetched = false;
+        }
+    }
+
+    if (layer_idx > 0) {
+        Layer& prev = layers_[layer_idx - 1];
+        if (prev.observed_pass == pass_ && prev.last_topk.size() == layer.last_topk.size()) {
+            record_transitions(prev, layer, tokens);
+        }
+    }
+    layer.observed_pass = pass_;
+
+    prefetch_next(layer_idx);
+    layer.faults_before = major_faults_now();
+}
+
+void ExpertResidency::after_layer(const GraphNode& node) {
+    auto it = layer_of_node_.find(node.id);
+    if (it == layer_of_node_.end()) return;
+    Layer& layer = layers_[it->second];
+    const long faults = major_faults_now() - layer.faults_before;
+    if (faults > 0) layer.stats.major_faults += static_cast<uint64_t>(faults);
+    if (resident_bytes_ > config_.budget_bytes) enforce_budget(it->second);
+}
+
+void ExpertResidency::end_pass() {
+    if (layers_.empty()) return;
+    if (config_.rebalance_interval == 0 || pass_ % config_.rebalance_interval == 0) rebalance_pins();
+    ++pass_;
+}
+
+void ExpertResidency::record_transitions(Layer& prev, const Layer& cur, size_t tokens) {
+    const size_t prev_experts = prev.experts.size();
+    const size_t cur_experts = cur.experts.size();
+    if (prev.transitions.size() != prev_experts * cur_experts) return;
+    const size_t prev_k = tokens > 0 ? prev.last_topk.size() / tokens : 0;
+    const size_t cur_k = tokens > 0 ? cur.last_topk.size() / tokens : 0;
+
+    for (size_t t = 0; t < tokens; ++t) {
+        for (size_t a = 0; a < prev_k; ++a) {
+            const uint32_t i = prev.last_topk[t * prev_k + a];
+            if (i >= prev_experts) continue;
+            uint16_t* row = prev.transitions.data() + static_cast<size_t>(i) * cur_experts;
+            for (size_t b = 0; b < cur_k; ++b) {
+                const uint32_t j = cur.last_topk[t * cur_k + b];
+                if (j >= cur_experts) continue;
+                if (row[j] == TRANSITION_SATURATION) {
+                    for (size_t c = 0; c < cur_experts; ++c) row[c] >>= 1;
+                }
+                row[j]++;
+            }
+        }
+    }
+}
+
+void ExpertResidency::prefetch_next(size_t layer_idx) {
+    if (layer_idx + 1 >= layers_.size()) return;
+    const Layer& layer = layers_[layer_idx];
+    Layer& next = layers_[layer_idx + 1];
+    const size_t next_experts = next.experts.size();
+    const size_t budget = config_.prefetch_experts > 0 ? config_.prefetch_experts : next.top_k;
+    if (budget == 0 || next_experts == 0) return;
+
+    score_scratch_.assign(next_experts, 0.0f);
+    bool any_transition = false;
+    if (layer.transitions.size() == layer.experts.size() * next_experts) {
+        for (uint32_t i : layer.selected) {
+            const uint16_t* row = layer.transitions.data() + static_cast<size_t>(i) * next_experts;
+            for (size_t j = 0; j < next_experts; ++j) {
+                score_scratch_[j] += static_cast<float>(row[j]);
+                any_transition |= row[j] != 0;
+            }
+        }
+    }
+    if (!any_transition) {
+        for (size_t j = 0; j < next_experts; ++j) score_scratch_[j] = next.experts[j].score;
+    }
+
+    std::vector<uint32_t>& order = topk_scratch_;
+    order.resize(next_experts);
+    std::iota(order.begin(), order.end(), 0u);
+    const size_t take = std::min(budget, next_experts);
+    std::partial_sort(order.begin(), order.begin() + take, order.end(), [&](uint32_t a, uint32_t b) {
+        return score_scratch_[a] > score_scratch_[b] || (score_scratch_[a] == score_scratch_[b] && a < b);
+    });
+    for (size_t r = 0; r < take; ++r) {
+        const uint32_t j = order[r];
+        if (score_scratch_[j] <= 0.0f) break;
+        Expert& expert = next.experts[j];
+        if (expert.state != State::COLD) continue;
+        make_resident(expert, true);
+        next.stats.prefetches++;
+    }
+}
+
+void ExpertResidency::enforce_budget(size_t active_layer) {
+    struct Candidate { float score; uint64_t last_used; Expert* expert; };
+    std::vector<Candidate> candidates;
+    for (size_t l = 0; l < layers_.size(); ++l) {
+        for (auto& expert : layers_[l].experts) {
+            if (expert.state != State::RESIDENT) continue;
+            if (l == active_layer && expert.last_used == tick_) continue;
+            if (l == active_layer + 1 && expert.prefetched) continue;
+            candidates.push_back({expert.score, expert.last_used, &expert});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.score < b.score || (a.score == b.score && a.last_used < b.last_used);
+    });
+
+    const size_t target = static_cast<size_t>(static_cast<double>(config_.budget_bytes) * RESIDENCY_HYSTERESIS);
+    for (const auto& c : candidates) {
+        if (resident_bytes_ <= target) break;
+        release(*c.expert);
+    }
+}
+
+void ExpertResidency::rebalance_pins() {
+    struct Candidate { float score; Expert* expert; };
+    std::vector<Candidate> candidates;
+    for (auto& layer : layers_) {
+        for (auto& expert : layer.experts) {
+            if (expert.score > 0.0f || expert.state == State::PINNED) candidates.push_back({expert.score, &expert});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+    const size_t pin_budget = static_cast<size_t>(static_cast<double>(config_.budget_bytes) * std::clamp(config_.pin_fraction, 0.0f, 1.0f));
+    size_t planned = 0;
+    std::vector<Expert*> to_pin;
+    for (auto& c : candidates) {
+        const bool keep = c.score > 0.0f && planned + c.expert->bytes <= pin_budget;
+        if (keep) {
+            planned += c.expert->bytes;
+            if (c.expert->state != State::PINNED) to_pin.push_back(c.expert);
+        } else if (c.expert->state == State::PINNED) {
+            unpin(*c.expert);
+        }
+    }
+    for (Expert* expert : to_pin) pin(*expert);
+}
+
+std::vector<ExpertLayerStats> ExpertResidency::stats() const {
+    if (layers_.empty()) return retained_;
+    std::vector<ExpertLayerStats> out;
+    out.reserve(layers_.size());
+    for (const auto& layer : layers_) {
+        ExpertLayerStats s = layer.stats;
+        s.resident = 0;
+        s.pinned = 0;
+        for (const auto& expert : layer.experts) {
+            s.resident += expert.state != State::COLD;
+            s.pinned += expert.state == State::PINNED;
+        }
+        out.push_back(s);
+    }
+    return out;
+}
+
+void ExpertResidency::reset_stats() {
+    retained_.clear();
+    for (auto& layer : layers_) {
+        const size_t node_id = layer.stats.node_id;
+        const size_t num_experts = layer.stats.num_experts;
+        layer.stats = ExpertLayerStats{};
+        layer.stats.node_id = node_id;
+        layer.stats.num_experts = num_experts;
+    }
+}
+
+void CactusGraph::configure_expert_residency(const ExpertResidencyConfig& config) {
+    expert_residency_.detach();
+    expert_residency_.configure(config);
+}
+
+void CactusGraph::attach_expert_residency() {
+    for (const auto& node_ptr : nodes_) {
+        const GraphNode& node = *node_ptr;
+        if (node.op_type != OpType::MOE_LAYER) continue;
+        const size_t num_experts = node.params.num_experts;
+        const size_t matrices = node.params.moe_gated ? 3 : 2;
+        if (node.input_ids.size() < 3 + matrices * num_experts) continue;
+
+        std::vector<ExpertResidency::ExpertFiles> experts(num_experts);
+        bool any_mapped = false;
+        for (size_t e = 0; e < num_experts; ++e) {
+            for (size_t m = 0; m < matrices; ++m) {
+                auto it = node_to_mapped_file_.find(node.input_ids[3 + m * num_experts + e]);
+                if (it == node_to_mapped_file_.end() || it->second >= mapped_files_.size()) continue;
+                experts[e].push_back(mapped_files_[it->second].get());
+                any_mapped = true;
+            }
+        }
+        if (any_mapped) expert_residency_.add_layer(node.id, node.params.num_experts_per_tok, std::move(experts));
+    }
+    expert_residency_.mark_attached();
+}
@@ -881,6 +881,18 @@ int cactus_graph_rms_norm(cactus_graph_t graph, cactus_node_t input, cactus_node
     }
 }
 
+int cactus_graph_rms_norm_matmul(cactus_graph_t graph, cactus_node_t input, cactus_node_t norm_weight, cactus_node_t weight, float epsilon, cactus_node_t* out) {
+    if (!graph || !out) return fail_invalid("Invalid args to cactus_graph_rms_norm_matmul");
+    try {
+        *out = static_cast<cactus_node_t>(as_graph(graph)->graph.rms_norm_matmul(
+            static_cast<size_t>(input), static_cast<size_t>(norm_weight), static_cast<size_t>(weight), epsilon));
+        return 0;
+    } catch (const std::exception& e) {
+        last_error_message = e.what();
+        return -1;
+    }
+}
+
 int cactus_graph_rope(cactus_graph_t graph, cactus_node_t input, float theta, size_t position_offset, int32_t backend, cactus_node_t* out) {
     if (!graph || !out) return fail_invalid("Invalid args to cactus_graph_rope");
     try {
@@ -977,6 +989,23 @@ int cactus_graph_kv_cache_append(cactus_graph_t graph, cactus_node_t new_kv, cac
     }
 }
 
+int cactus_graph_qkv_rope_cache_append(cactus_graph_t graph, cactus_node_t input, cactus_node_t q_weight, cactus_node_t k_weight,
+                                        cactus_node_t v_weight, cactus_node_t k_cache_state, cactus_node_t v_cache_state,
+                                        size_t head_dim, float theta, size_t position_offset, size_t window_size,
+                                        size_t sink_size, cactus_node_t* out) {
+    if (!graph || !out) return fail_invalid("Invalid args to cactus_graph_qkv_rope_cache_append");
+    try {
+        *out = static_cast<cactus_node_t>(as_graph(graph)->graph.qkv_rope_cache_append(
+            static_cast<size_t>(input), static_cast<size_t>(q_weight), static_cast<size_t>(k_weight),
+            static_cast<size_t>(v_weight), static_cast<size_t>(k_cache_state), static_cast<size_t>(v_cache_state),
+            head_dim, theta, position_offset, window_size, sink_size));
+        return 0;
+    } catch (const std::exception& e) {
+        last_error_message = e.what();
+        return -1;
+    }
+}
+
 int cactus_graph_attention_cached(cactus_graph_t graph, cactus_node_t query, cactus_node_t key_new, cactus_node_t value_new,
                                    cactus_node_t k_cache_state, cactus_node_t v_cache_state,
                                    float scale, size_t position_offset, size_t window_size, size_t v_head_dim, cactus_node_t* out) {
@@ -1258,6 +1287,23 @@ int cactus_graph_conv2d_pointwise_1x1(cactus_graph_t graph, cactus_node_t input,
     }
 }
 
+int cactus_graph_conv2d(cactus_graph_t graph, cactus_node_t input, cactus_node_t weight, bool has_bias, cactus_node_t bias,
+                        size_t stride, size_t padding, size_t dilation, size_t groups, bool nhwc_input, bool nhwc_output,
+                        cactus_node_t* out) {
+    if (!graph || !out) return fail_invalid("Invalid args to cactus_graph_conv2d");
+    try {
+        if (has_bias) {
+            *out = static_cast<cactus_node_t>(as_graph(graph)->graph.conv2d(static_cast<size_t>(input), static_cast<size_t>(weight), static_cast<size_t>(bias), stride, padding, dilation, groups, nhwc_input, nhwc_output));
+        } else {
+            *out = static_cast<cactus_node_t>(as_graph(graph)->graph.conv2d(static_cast<size_t>(input), static_cast<size_t>(weight), stride, padding, dilation, groups, nhwc_input, nhwc_output));
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        last_error_message = e.what();
+        return -1;
+    }
+}
+
 int cactus_graph_lstm_cell(cactus_graph_t graph, cactus_node_t input, cactus_node_t h_prev, cactus_node_t c_prev, cactus_node_t weight_ih, cactus_node_t weight_hh, cactus_node_t bias_ih, cactus_node_t bias_hh, cactus_node_t* out) {
     if (!graph || !out) return fail_invalid("Invalid args to cactus_graph_lstm_cell");
     try {
@@ -241,7 +241,7 @@ namespace {
         GraphFile::NodeEntry node;
         node.index = read_u32(in);
         uint32_t op_type_val = read_u32(in);
-        if (op_type_val > static_cast<uint32_t>(OpType::CONV_CACHE_INITIALIZE)) {
+        if (op_type_val > static_cast<uint32_t>(OpType::QKV_ROPE_CACHE_APPEND)) {
             throw std::runtime_error("Graph file corrupted: invalid op type");
         }
         node.op_type = static_cast<OpType>(op_type_val);
@@ -536,6 +536,7 @@ void CactusGraph::bind_mmap_weights(size_t node_id, const std::string& filename)
     const auto& shape = mapped_file->shape();
     Precision precision = mapped_file->precision();
     auto& buffer = node.output_buffer;
+    expert_residency_.detach();
     if (buffer.shape != shape) {
         throw std::runtime_error("mmap weight shape mismatch for node " + std::to_string(node_id));
     }
@@ -621,6 +622,7 @@ void CactusGraph::prefetch_weight_pages(size_t node_id) {
 }
 
 void CactusGraph::release_all_weight_pages() {
+    expert_residency_.detach();
     for (auto& mf : mapped_files_) {
         if (mf) mf->release_pages();
     }
@@ -1096,6 +1098,25 @@ void MappedFile::prefetch_pages() {
     madvise(static_cast<char*>(mapped_data_) + data_offset_, byte_size_, MADV_WILLNEED);
 }
 
+bool MappedFile::lock_pages() {
+    if (mapped_data_ == nullptr || mapped_data_ == MAP_FAILED) return false;
+
+    if (scales_bytes_ > 0 && scales_offset_ > 0 &&
+        mlock(static_cast<char*>(mapped_data_) + scales_offset_, scales_bytes_) != 0) {
+        return false;
+    }
+    return mlock(static_cast<char*>(mapped_data_) + data_offset_, byte_size_) == 0;
+}
+
+void MappedFile::unlock_pages() {
+    if (mapped_data_ == nullptr || mapped_data_ == MAP_FAILED) return;
+
+    if (scales_bytes_ > 0 && scales_offset_ > 0) {
+        munlock(static_cast<char*>(mapped_data_) + scales_offset_, scales_bytes_);
+    }
+    munlock(static_cast<char*>(mapped_data_) + data_offset_, byte_size_);
+}
+
 template const int8_t* MappedFile::typed_data<int8_t>() const;
 template const float* MappedFile::typed_data<float>() const;
 template const uint16_t* MappedFile::typed_data<uint16_t>() const;
@@ -5,7 +5,12 @@
 #include <limits>
 #include <cstdlib>
 #include <cassert>
+#include <numeric>
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace {
 
@@ -34,11 +39,37 @@ struct CacheMetadata {
     uint64_t head_dim;
     uint64_t sink_size;
     uint64_t num_slots;
-    uint64_t reserved[2];
+    uint64_t ring_head;
+    uint16_t kv_bits;       // 4 or 2: low-bit layout below; 0 otherwise
+    uint8_t kv_role;        // low-bit and spilled caches: kCacheKeys or kCacheValues
+    uint8_t kv_flags;       // kKvSpill, kKvSharedPrefix
+    uint32_t packed_rows;   // low-bit keys: rows [0, packed_rows) sit in quantized blocks;
+                            // spilled caches: rows before packed_rows have been paged out;
+                            // shared-prefix slots: logical rows [0, packed_rows) are the prefix's
 };
 
 static_assert(sizeof(CacheMetadata) == 64, "CacheMetadata must be 64 bytes");
 
+// share_cache_prefix layout: slots [0, num_slots - 1) each hold only the rows their sequence adds
+// after a prefix stored once, in the last slot. Their own rows start at logical row packed_rows;
+// the prefix slot itself is an ordinary slot sized to the prefix.
+constexpr uint8_t kKvSharedPrefix = 2;
+
+inline bool shared_prefix_slot(const CacheMetadata* meta) {
+    return (meta->kv_flags & kKvSharedPrefix) != 0;
+}
+
+// A full sliding window overwrites its oldest tail row in place and advances ring_head instead
+// of shifting the tail down; attention reads rows back in logical order through this map.
+inline CactusKVRing kv_ring(const CacheMetadata* meta) {
+    CactusKVRing ring;
+    if (meta->ring_head == 0) return ring;
+    ring.sink = std::min<size_t>(meta->sink_size, meta->current_seq_len);
+    ring.head = meta->ring_head;
+    ring.span = meta->current_seq_len - ring.sink;
+    return ring;
+}
+
 inline size_t cache_buffer_size(size_t max_seq, size_t kv_heads, size_t head_dim) {
     size_t num_groups = (head_dim + KV_QUANT_GROUP_SIZE - 1) / KV_QUANT_GROUP_SIZE;
     return sizeof(CacheMetadata) + max_seq * kv_heads * head_dim + max_seq * kv_heads * num_groups * sizeof(float);
@@ -91,6 +122,28 @@ inline const __fp16* get_fp16_data(const BufferDesc& buf, size_t slot = 0) {
     return reinterpret_cast<const __fp16*>(static_cast<const char*>(buf.get_data()) + kv_slot_off(buf, slot) + sizeof(CacheMetadata));
 }
 
+// The ring map of a slot, plus where its shared prefix lives when it continues one. K and V are
+// appended in lockstep, so one map describes both.
+inline CactusKVRing kv_rows(const BufferDesc& k_buf, const BufferDesc& v_buf, size_t slot, size_t v_hdim) {
+    const auto* meta = get_meta(k_buf, slot);
+    CactusKVRing ring = kv_ring(meta);
+    if (!shared_prefix_slot(meta)) return ring;
+    const size_t prefix = meta->num_slots - 1;
+    ring.shared = meta->packed_rows;
+    if (k_buf.precision == Precision::FP16) {
+        ring.shared_keys = get_fp16_data(k_buf, prefix);
+        ring.shared_values = get_fp16_data(v_buf, prefix);
+        return ring;
+    }
+    const auto* k_prefix = get_meta(k_buf, prefix);
+    const auto* v_prefix = get_meta(v_buf, prefix);
+    ring.shared_keys = get_int8_data(k_buf, prefix);
+    ring.shared_values = get_int8_data(v_buf, prefix);
+    ring.shared_k_scales = get_scales(k_buf, k_prefix->max_seq_len, k_prefix->num_kv_heads, k_prefix->head_dim, prefix);
+    ring.shared_v_scales = get_scales(v_buf, v_prefix->max_seq_len, v_prefix->num_kv_heads, v_hdim, prefix);
+    return ring;
+}
+
 inline bool use_fp16_kv_cache() {
     static const bool cached = [] {
         const char* value = std::getenv("CACTUS_KV_CACHE_FP16");
@@ -101,12 +154,229 @@ inline bool use_fp16_kv_cache() {
 
 constexpr size_t kInitialCacheEntries = 256;
 
+constexpr uint8_t kCacheKeys = 0;
+constexpr uint8_t kCacheValues = 1;
+
+// Sub-8-bit caches (CACTUS_KV_CACHE_BITS=4|2) keep the INT8 byte buffer but a different body.
+// Keys: an fp16 residual of up to KV_LOWBIT_BLOCK rows that have not filled a block yet, then
+// per-channel quantized blocks. Values: one per-token quantized row per position. The residual
+// sits in front of the blocks so growth only ever extends the tail.
+
+inline size_t requested_kv_cache_bits() {
+    const char* value = std::getenv("CACTUS_KV_CACHE_BITS");
+    if (value == nullptr) return 8;
+    if (std::strcmp(value, "4") == 0) return 4;
+    if (std::strcmp(value, "2") == 0) return 2;
+    return 8;
+}
+
+inline bool lowbit_cache(const CacheMetadata* meta) {
+    return meta->kv_bits == 4 || meta->kv_bits == 2;
+}
+
+inline size_t lowbit_residual_bytes(size_t kv_heads, size_t head_dim) {
+    return KV_LOWBIT_BLOCK * kv_heads * head_dim * sizeof(__fp16);
+}
+
+inline size_t lowbit_cache_buffer_size(size_t max_seq, size_t kv_heads, size_t head_dim, size_t bits, uint8_t role) {
+    if (role == kCacheValues) {
+        return sizeof(CacheMetadata) + max_seq * kv_lowbit_value_row_bytes(kv_heads, head_dim, bits);
+    }
+    return sizeof(CacheMetadata) + lowbit_residual_bytes(kv_heads, head_dim) +
+           (max_seq / KV_LOWBIT_BLOCK) * kv_lowbit_key_block_bytes(kv_heads, head_dim, bits);
+}
+
+inline __fp16* lowbit_key_residual(BufferDesc& buf) {
+    return reinterpret_cast<__fp16*>(static_cast<char*>(buf.get_data()) + sizeof(CacheMetadata));
+}
+
+inline const __fp16* lowbit_key_residual(const BufferDesc& buf) {
+    return reinterpret_cast<const __fp16*>(static_cast<const char*>(buf.get_data()) + sizeof(CacheMetadata));
+}
+
+inline uint8_t* lowbit_key_blocks(BufferDesc& buf) {
+    const auto* meta = get_meta(buf);
+    return static_cast<uint8_t*>(buf.get_data()) + sizeof(CacheMetadata) +
+           lowbit_residual_bytes(meta->num_kv_heads, meta->head_dim);
+}
+
+inline const uint8_t* lowbit_key_blocks(const BufferDesc& buf) {
+    const auto* meta = get_meta(buf);
+    return static_cast<const uint8_t*>(buf.get_data()) + sizeof(CacheMetadata) +
+           lowbit_residual_bytes(meta->num_kv_heads, meta->head_dim);
+}
+
+inline uint8_t* lowbit_value_rows(BufferDesc& buf) {
+    return static_cast<uint8_t*>(buf.get_data()) + sizeof(CacheMetadata);
+}
+
+inline const uint8_t* lowbit_value_rows(const BufferDesc& buf) {
+    return static_cast<const uint8_t*>(buf.get_data()) + sizeof(CacheMetadata);
+}
+
+// current_seq_len may be cut back below packed_rows (padded prefill tail, reset, handoff); the
+// rows of the last partial block go back to the residual before anything else touches it.
+inline void lowbit_unpack_tail(BufferDesc& buf) {
+    auto* meta = get_meta(buf);
+    if (meta->kv_role != kCacheKeys || meta->packed_rows <= meta->current_seq_len) return;
+    const size_t block_start = (meta->current_seq_len / KV_LOWBIT_BLOCK) * KV_LOWBIT_BLOCK;
+    const size_t rows = meta->current_seq_len - block_start;
+    if (rows > 0) {
+        cactus_dequantize_kv_keys_lowbit(
+            lowbit_key_blocks(buf) + (block_start / KV_LOWBIT_BLOCK) *
+                kv_lowbit_key_block_bytes(meta->num_kv_heads, meta->head_dim, meta->kv_bits),
+            lowbit_key_residual(buf), rows, meta->num_kv_heads, meta->head_dim, meta->kv_bits);
+    }
+    meta->packed_rows = static_cast<uint32_t>(block_start);
+}
+
+inline bool resize_lowbit_cache_buffer(BufferDesc& buf, size_t new_max) {
+    lowbit_unpack_tail(buf);
+    const auto* meta = get_meta(buf);
+    const size_t bits = meta->kv_bits;
+    const size_t used = meta->kv_role == kCacheValues
+        ? sizeof(CacheMetadata) + meta->current_seq_len * kv_lowbit_value_row_bytes(meta->num_kv_heads, meta->head_dim, bits)
+        : lowbit_cache_buffer_size(meta->packed_rows, meta->num_kv_heads, meta->head_dim, bits, kCacheKeys);
+    BufferDesc resized({lowbit_cache_buffer_size(new_max, meta->num_kv_heads, meta->head_dim, bits, meta->kv_role)},
+                       Precision::INT8);
+    resized.allocate();
+    std::memset(resized.get_data(), 0, resized.byte_size);
+    std::memcpy(resized.get_data(), buf.get_data(), used);
+    get_meta(resized)->max_seq_len = new_max;
+    buf = std::move(resized);
+    return true;
+}
+
+// Disk tier (CACTUS_KV_SPILL_DIR=<dir>): a plain INT8 cache is laid out once at its ceiling in a
+// sparse, already-unlinked file under <dir> and mapped shared, so it never grows or moves. The
+// pinned sink block and the last CACTUS_KV_HOT_TOKENS rows stay resident; older blocks are dropped
+// from the mapping as they go cold and are read back only when decode attention picks them by
+// their key summary. Key summaries (cactus_kv_block_minmax_int8) follow the scales.
+constexpr uint8_t kKvSpill = 1;
+
+inline const char* kv_spill_dir() {
+    const char* value = std::getenv("CACTUS_KV_SPILL_DIR");
+    return value != nullptr && *value ? value : nullptr;
+}
+
+inline size_t kv_spill_setting(const char* name, size_t fallback) {
+    const char* value = std::getenv(name);
+    if (value == nullptr || *value == '\0') return fallback;
+    return static_cast<size_t>(std::strtoull(value, nullptr, 10));
+}
+
+inline bool spill_cache(const CacheMetadata* meta) {
+    return (meta->kv_flags & kKvSpill) != 0;
+}
+
+inline size_t spill_summary_bytes(size_t max_seq, size_t kv_heads, size_t head_dim) {
+    return (max_seq + KV_SPILL_BLOCK - 1) / KV_SPILL_BLOCK * kv_heads * 2 * head_dim * sizeof(__fp16);
+}
+
+inline __fp16* spill_summaries(BufferDesc& buf) {
+    const auto* meta = get_meta(buf);
+    return reinterpret_cast<__fp16*>(static_cast<char*>(buf.get_data()) +
+                                     cache_buffer_size(meta->max_seq_len, meta->num_kv_heads, meta->head_dim));
+}
+
+inline const __fp16* spill_summaries(const BufferDesc& buf) {
+    const auto* meta = get_meta(buf);
+    return reinterpret_cast<const __fp16*>(static_cast<const char*>(buf.get_data()) +
+                                           cache_buffer_size(meta->max_seq_len, meta->num_kv_heads, meta->head_dim));
+}
+
+// Rows [0, pinned) are the attention sink and never leave memory: the configured sink rounded up
+// to whole blocks, at least one block.
+inline size_t spill_pinned_rows(const CacheMetadata* meta) {
+    const size_t sink = std::max<size_t>(meta->sink_size, 1);
+    return (sink + KV_SPILL_BLOCK - 1) / KV_SPILL_BLOCK * KV_SPILL_BLOCK;
+}
+
+// Rows before the returned block boundary are cold once `len` rows are cached.
+inline size_t spill_cold_end(const CacheMetadata* meta, size_t len) {
+    const size_t hot = kv_spill_setting("CACTUS_KV_HOT_TOKENS", 1024);
+    const size_t pinned = spill_pinned_rows(meta);
+    if (len <= pinned + hot) return 0;
+    return std::max(pinned, (len - hot) / KV_SPILL_BLOCK * KV_SPILL_BLOCK);
+}
+
+inline BufferDesc map_spill_buffer(size_t bytes) {
+    std::string path = std::string(kv_spill_dir()) + "/cactus_kv_XXXXXX";
+    const int fd = mkstemp(path.data());
+    if (fd < 0) throw std::runtime_error("cannot create KV spill file under " + std::string(kv_spill_dir()));
+    unlink(path.c_str());
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) throw std::runtime_error("cannot map KV spill file of " + std::to_string(bytes) + " bytes");
+    BufferDesc buf({bytes}, Precision::INT8);
+    buf.external_data = data;
+    buf.external_owner = std::shared_ptr<void>(data, [bytes](void* p) { munmap(p, bytes); });
+    return buf;
+}
+
+// Drops the whole pages of rows [first, last) from this process's mapping; the bytes stay in the
+// shared file and fault back in on the next read.
+inline void spill_release_rows(const BufferDesc& buf, size_t first, size_t last) {
+    if (last <= first) return;
+    static const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto* meta = get_meta(buf);
+    const size_t stride = meta->num_kv_heads * meta->head_dim;
+    const size_t scale_stride = meta->num_kv_heads * ((meta->head_dim + KV_QUANT_GROUP_SIZE - 1) / KV_QUANT_GROUP_SIZE) * sizeof(float);
+    auto release = [](const void* base, size_t begin, size_t end) {
+        const uintptr_t lo = (reinterpret_cast<uintptr_t>(base) + begin + page - 1) & ~(page - 1);
+        const uintptr_t hi = (reinterpret_cast<uintptr_t>(base) + end) & ~(page - 1);
+        if (hi > lo) madvise(reinterpret_cast<void*>(lo), hi - lo, MADV_DONTNEED);
+    };
+    release(get_int8_data(buf), first * stride, last * stride);
+    release(get_scales(buf, meta->max_seq_len, meta->num_kv_heads, meta->head_dim), first * scale_stride, last * scale_stride);
+}
+
+inline void spill_release_cold(const BufferDesc& buf) {
+    const auto* meta = get_meta(buf);
+    spill_release_rows(buf, spill_pinned_rows(meta), meta->packed_rows);
+}
+
+// After rows [first_row, current_seq_len) were written: widen the key summaries of their blocks
+// and page out blocks that have fallen behind the hot window.
+inline void spill_after_write(BufferDesc& buf, size_t first_row) {
+    auto* meta = get_meta(buf);
+    const size_t len = meta->current_seq_len;
+    const size_t kv_heads = meta->num_kv_heads;
+    const size_t hdim = meta->head_dim;
+    if (meta->kv_role == kCacheKeys) {
+        const size_t groups = (hdim + KV_QUANT_GROUP_SIZE - 1) / KV_QUANT_GROUP_SIZE;
+        const int8_t* keys = get_int8_data(buf);
+        const float* scales = get_scales(buf, meta->max_seq_len, kv_heads, hdim);
+        __fp16* summaries = spill_summaries(buf);
+        for (size_t row = first_row; row < len;) {
+            const size_t block = row / KV_SPILL_BLOCK;
+            const size_t rows = std::min(len, (block + 1) * KV_SPILL_BLOCK) - row;
+            cactus_kv_block_minmax_int8(keys + row * kv_heads * hdim, scales + row * kv_heads * groups,
+                                        summaries + block * kv_heads * 2 * hdim, rows, kv_heads, hdim,
+                                        row % KV_SPILL_BLOCK != 0);
+            row += rows;
+        }
+    }
+    const size_t released = std::min<size_t>(meta->packed_rows, first_row / KV_SPILL_BLOCK * KV_SPILL_BLOCK);
+    const size_t cold_end = spill_cold_end(meta, len);
+    if (cold_end > released) {
+        spill_release_rows(buf, std::max(released, spill_pinned_rows(meta)), cold_end);
+    }
+    meta->packed_rows = static_cast<uint32_t>(std::max(released, cold_end));
+}
+
 inline bool resize_cache_buffer(BufferDesc& buf, size_t new_max) {
     auto* meta = get_meta(buf);
     size_t cur = meta->max_seq_len;
     const size_t current_seq = meta->current_seq_len;
     if (new_max == cur || new_max < current_seq) return false;
 
+    if (lowbit_cache(meta)) return resize_lowbit_cache_buffer(buf, new_max);
+    if (spill_cache(meta)) return false;
+
     const size_t kv_heads = meta->num_kv_heads;
     const size_t hdim = meta->head_dim;
     const bool fp16_cache = buf.precision == Precision::FP16;
@@ -143,12 +413,41 @@ inline bool grow_cache_buffer(BufferDesc& buf, size_t needed, size_t ceiling) {
     return resize_cache_buffer(buf, new_max);
 }
 
+// Low-bit and spilled storage cover only the plain layout: one slot, no sliding ring, and an
+// ATTENTION_CACHED consumer. Low-bit K and V caches must also share a head_dim the fused kernel
+// handles. Anything else stays a resident INT8 cache.
+inline int tiered_cache_role(const GraphNode& node, const nodes_vector& nodes, const node_index_map_t& node_index_map,
+                             bool lowbit) {
+    auto plain = [lowbit](const GraphNode& cache) {
+        const size_t ceiling = cache.params.max_cache_seq_len;
+        const size_t window = cache.params.window_size;
+        return cache.params.cache_num_slots <= 1 && !(window > 0 && window < ceiling) &&
+               (!lowbit || (cache.params.head_dim % KV_QUANT_GROUP_SIZE == 0 && cache.params.head_dim <= 512));
+    };
+    for (const auto& consumer : nodes) {
+        if (consumer->op_type != OpType::ATTENTION_CACHED || consumer->input_ids.size() < 5) continue;
+        const size_t k_id = consumer->input_ids[3];
+        const size_t v_id = consumer->input_ids[4];
+        if (k_id != node.id && v_id != node.id) continue;
+        const auto& k_node = *nodes[node_index_map.at(k_id)];
+        const auto& v_node = *nodes[node_index_map.at(v_id)];
+        const size_t v_hdim = consumer->params.v_head_dim;
+        if (k_id == v_id || !plain(k_node) || !plain(v_node) ||
+            (lowbit && (k_node.params.head_dim != v_node.params.head_dim ||
+                        (v_hdim != 0 && v_hdim != k_node.params.head_dim)))) {
+            return -1;
+        }
+        return k_id == node.id ? kCacheKeys : kCacheValues;
+    }
+    return -1;
+}
+
 } // namespace
 
 void compute_kv_cache_state_node(
     GraphNode& node,
-    const nodes_vector&,
-    const node_index_map_t&) {
+    const nodes_vector& nodes,
+    const node_index_map_t& node_index_map) {
 
     if (node.output_buffer.get_data()) return;
 
@@ -163,6 +462,38 @@ void compute_kv_cache_state_node(
     size_t kv_heads = node.params.num_kv_heads;
     size_t hdim = node.params.head_dim;
     const bool fp16_cache = use_fp16_kv_cache();
+    const size_t bits = fp16_cache ? 16 : requested_kv_cache_bits();
+    const int role = bits < 8 ? tiered_cache_role(node, nodes, node_index_map, true) : -1;
+    if (role >= 0) {
+        node.output_buffer = BufferDesc({lowbit_cache_buffer_size(max_seq, kv_heads, hdim, bits, static_cast<uint8_t>(role))},
+                                        Precision::INT8);
+        node.output_buffer.allocate();
+        std::memset(node.output_buffer.get_data(), 0, node.output_buffer.byte_size);
+        auto* meta = get_meta(node.output_buffer);
+        meta->max_seq_len = max_seq;
+        meta->num_kv_heads = kv_heads;
+        meta->head_dim = hdim;
+        meta->sink_size = node.params.cache_sink_size;
+        meta->num_slots = 1;
+        meta->kv_bits = static_cast<uint16_t>(bits);
+        meta->kv_role = static_cast<uint8_t>(role);
+        return;
+    }
+    const int spill_role = !fp16_cache && kv_spill_dir() && num_slots == 1
+        ? tiered_cache_role(node, nodes, node_index_map, false) : -1;
+    if (spill_role >= 0) {
+        node.output_buffer = map_spill_buffer(cache_buffer_size(ceiling, kv_heads, hdim) +
+                                              spill_summary_bytes(ceiling, kv_heads, hdim));
+        auto* meta = get_meta(node.output_buffer);
+        meta->max_seq_len = ceiling;
+        meta->num_kv_heads = kv_heads;
+        meta->head_dim = hdim;
+        meta->sink_size = node.params.cache_sink_size;
+        meta->num_slots = 1;
+        meta->kv_role = static_cast<uint8_t>(spill_role);
+        meta->kv_flags = kKvSpill;
+        return;
+    }
     size_t per_slot = fp16_cache
         ? fp16_cache_elements(max_seq, kv_heads, hdim)
         : cache_buffer_size(max_seq, kv_heads, hdim);
@@ -183,11 +514,137 @@ void compute_kv_cache_state_node(
     }
 }
 
+// At the ceiling a low-bit cache drops its oldest rows after the sink, like the INT8 cache, but in
+// whole KV_LOWBIT_BLOCK blocks so packed key blocks move intact. The sink is pinned rounded up to a
+// block. K and V decide from their lengths alone, so both caches drop the same rows. Returns how
+// many leading source rows no longer fit; those are skipped.
+static size_t lowbit_evict(BufferDesc& cache_buf, size_t new_seq_len) {
+    auto* meta = get_meta(cache_buf);
+    const size_t current = meta->current_seq_len;
+    const size_t packed = current / KV_LOWBIT_BLOCK * KV_LOWBIT_BLOCK;
+    const size_t pinned = std::min(packed,
+        (meta->sink_size + KV_LOWBIT_BLOCK - 1) / KV_LOWBIT_BLOCK * KV_LOWBIT_BLOCK);
+    const size_t need = current + new_seq_len - meta->max_seq_len;
+    size_t drop = (need + KV_LOWBIT_BLOCK - 1) / KV_LOWBIT_BLOCK * KV_LOWBIT_BLOCK;
+    size_t skipped = 0;
+    if (drop > packed - pinned) {
+        // The new rows outrun everything movable: keep the sink and the newest rows that fit.
+        drop = current - pinned;
+        skipped = new_seq_len - std::min(new_seq_len, meta->max_seq_len - pinned);
+    }
+    const size_t kv_heads = meta->num_kv_heads;
+    const size_t hdim = meta->head_dim;
+    const size_t bits = meta->kv_bits;
+    if (meta->kv_role == kCacheValues) {
+        const size_t row_bytes = kv_lowbit_value_row_bytes(kv_heads, hdim, bits);
+        uint8_t* rows = lowbit_value_rows(cache_buf);
+        std::memmove(rows + pinned * row_bytes, rows + (pinned + drop) * row_bytes, (current - pinned - drop) * row_bytes);
+    } else if (pinned + drop >= packed) {
+        meta->packed_rows = static_cast<uint32_t>(pinned);
+    } else {
+        const size_t block_bytes = kv_lowbit_key_block_bytes(kv_heads, hdim, bits);
+        uint8_t* blocks = lowbit_key_blocks(cache_buf);
+        std::memmove(blocks + pinned / KV_LOWBIT_BLOCK * block_bytes,
+                     blocks + (pinned + drop) / KV_LOWBIT_BLOCK * block_bytes,
+                     (packed - pinned - drop) / KV_LOWBIT_BLOCK * block_bytes);
+        meta->packed_rows = static_cast<uint32_t>(packed - drop);
+    }
+    meta->current_seq_len = current - drop;
+    return skipped;
+}
+
+// Keys collect in the fp16 residual until a block of KV_LOWBIT_BLOCK rows is complete; whole blocks
+// that arrive with an empty residual are quantized straight from the source. Values are quantized
+// per row on arrival.
+static void kv_append_lowbit(BufferDesc& cache_buf, const __fp16* source, size_t new_seq_len, size_t ceiling) {
+    lowbit_unpack_tail(cache_buf);
+    auto* meta = get_meta(cache_buf);
+    if (meta->current_seq_len + new_seq_len > meta->max_seq_len) {
+        grow_cache_buffer(cache_buf, meta->current_seq_len + new_seq_len, ceiling);
+        meta = get_meta(cache_buf);
+    }
+    const size_t kv_heads = meta->num_kv_heads;
+    const size_t hdim = meta->head_dim;
+    const size_t bits = meta->kv_bits;
+    const size_t stride = kv_heads * hdim;
+    if (meta->current_seq_len + new_seq_len > meta->max_seq_len) {
+        const size_t skipped = lowbit_evict(cache_buf, new_seq_len);
+        source += skipped * stride;
+        new_seq_len -= skipped;
+    }
+
+    if (meta->kv_role == kCacheValues) {
+        const size_t row_bytes = kv_lowbit_value_row_bytes(kv_heads, hdim, bits);
+        cactus_quantize_kv_values_lowbit(source, lowbit_value_rows(cache_buf) + meta->current_seq_len * row_bytes,
+                                         new_seq_len, kv_heads, hdim, bits);
+        meta->current_seq_len += new_seq_len;
+        return;
+    }
+
+    __fp16* residual = lowbit_key_residual(cache_buf);
+    uint8_t* blocks = lowbit_key_blocks(cache_buf);
+    const size_t block_bytes = kv_lowbit_key_block_bytes(kv_heads, hdim, bits);
+    size_t packed = meta->packed_rows;
+    size_t pending = meta->current_seq_len - packed;
+    for (size_t done = 0; done < new_seq_len;) {
+        if (pending == 0 && new_seq_len - done >= KV_LOWBIT_BLOCK) {
+            cactus_quantize_kv_keys_lowbit(source + done * stride, blocks + (packed / KV_LOWBIT_BLOCK) * block_bytes,
+                                           kv_heads, hdim, bits);
+            packed += KV_LOWBIT_BLOCK;
+            done += KV_LOWBIT_BLOCK;
+            continue;
+        }
+        const size_t take = std::min(KV_LOWBIT_BLOCK - pending, new_seq_len - done);
+        std::memcpy(residual + pending * stride, source + done * stride, take * stride * sizeof(__fp16));
+        pending += take;
+        done += take;
+        if (pending == KV_LOWBIT_BLOCK) {
+            cactus_quantize_kv_keys_lowbit(residual, blocks + (packed / KV_LOWBIT_BLOCK) * block_bytes,
+                                           kv_heads, hdim, bits);
+            packed += KV_LOWBIT_BLOCK;
+            pending = 0;
+        }
+    }
+    meta->packed_rows = static_cast<uint32_t>(packed);
+    meta->current_seq_len += new_seq_len;
+}
+
+// A slot continuing a shared prefix writes only its own rows. It is sized for what a search can
+// generate and never shifts: the prefix it reads stays where it is.
+static void kv_append_shared_tail(BufferDesc& cache_buf, size_t slot, const __fp16* source, size_t new_seq_len) {
+    auto* meta = get_meta(cache_buf, slot);
+    const size_t row = meta->current_seq_len - meta->packed_rows;
+    if (row + new_seq_len > meta->max_seq_len) {
+        throw std::runtime_error("shared-prefix KV cache slot is full");
+    }
+    const size_t kv_heads = meta->num_kv_heads;
+    const size_t hdim = meta->head_dim;
+    const size_t stride = kv_heads * hdim;
+    if (cache_buf.precision == Precision::FP16) {
+        std::memcpy(get_fp16_data(cache_buf, slot) + row * stride, source, new_seq_len * stride * sizeof(__fp16));
+    } else {
+        const size_t num_groups = (hdim + KV_QUANT_GROUP_SIZE - 1) / KV_QUANT_GROUP_SIZE;
+        cactus_quantize_kv_fp16_to_int8(source, get_int8_data(cache_buf, slot) + row * stride,
+            get_scales(cache_buf, meta->max_seq_len, kv_heads, hdim, slot) + row * kv_heads * num_groups,
+            new_seq_len, kv_heads, hdim);
+    }
+    meta->current_seq_len += new_seq_len;
+}
+
 void kv_append_one_slot(BufferDesc& cache_buf, size_t slot, size_t num_slots,
                         const __fp16* source, size_t new_seq_len,
                         size_t window_size, size_t ceiling) {
     auto* meta = get_meta(cache_buf, slot);
+    if (lowbit_cache(meta)) {
+        kv_append_lowbit(cache_buf, source, new_seq_len, ceiling);
+        return;
+    }
+    if (shared_prefix_slot(meta)) {
+        kv_append_shared_tail(cache_buf, slot, source, new_seq_len);
+        return;
+    }
     size_t current_len = meta->current_seq_len;
+    if (current_len == 0) meta->ring_head = 0;
     size_t max_len = meta->max_seq_len;
     size_t kv_heads = meta->num_kv_heads;
     size_t hdim = meta->head_dim;
@@ -204,73 +661,71 @@ void kv_append_one_slot(BufferDesc& cache_buf, size_t slot, size_t num_slots,
         }
     }
 
-    if (cache_buf.precision == Precision::FP16) {
-        size_t stride = kv_heads * hdim;
-        __fp16* fp16_base = get_fp16_data(cache_buf, slot);
-        size_t window = sliding ? window_size : max_len;
-        size_t new_total = current_len + new_seq_len;
-        if (new_total > window) {
-            size_t keep_sink = std::min({sink, current_len, window});
-            size_t tail_capacity = window - keep_sink;
-            if (new_seq_len >= tail_capacity) {
-                if (tail_capacity > 0) {
-                    size_t source_offset = new_seq_len - tail_capacity;
-                    std::memcpy(fp16_base + keep_sink * stride, source + source_offset * stride,
-                                tail_capacity * stride * sizeof(__fp16));
-                }
-                meta->current_seq_len = keep_sink + tail_capacity;
-                return;
-            }
-            size_t remaining = std::min(tail_capacity - new_seq_len, current_len - keep_sink);
-            size_t shift_src = current_len - remaining;
-            if (remaining > 0 && shift_src > keep_sink) {
-                std::memmove(fp16_base + keep_sink * stride, fp16_base + shift_src * stride,
-                             remaining * stride * sizeof(__fp16));
-            }
-            size_t append_offset = keep_sink + remaining;
-            std::memcpy(fp16_base + append_offset * stride, source, new_seq_len * stride * sizeof(__fp16));
-            meta->current_seq_len = append_offset + new_seq_len;
+    const bool fp16_cache = cache_buf.precision == Precision::FP16;
+    __fp16* fp16_base = fp16_cache ? get_fp16_data(cache_buf, slot) : nullptr;
+    int8_t* int8_base = fp16_cache ? nullptr : get_int8_data(cache_buf, slot);
+    float* scale_base = fp16_cache ? nullptr : get_scales(cache_buf, max_len, kv_heads, hdim, slot);
+    auto write_rows = [&](size_t row, const __fp16* src, size_t rows) {
+        if (rows == 0) return;
+        if (fp16_cache) {
+            std::memcpy(fp16_base + row * int8_stride, src, rows * int8_stride * sizeof(__fp16));
         } else {
-            std::memcpy(fp16_base + current_len * stride, source, new_seq_len * stride * sizeof(__fp16));
-            meta->current_seq_len = new_total;
+            cactus_quantize_kv_fp16_to_int8(src, int8_base + row * int8_stride,
+                scale_base + row * scale_stride, rows, kv_heads, hdim);
         }
-        return;
-    }
+    };
 
-    int8_t* int8_base = get_int8_data(cache_buf, slot);
-    float* scale_base = get_scales(cache_buf, max_len, kv_heads, hdim, slot);
     size_t window = sliding ? window_size : max_len;
     size_t new_total = current_len + new_seq_len;
-    if (new_total > window) {
-        size_t keep_sink = std::min({sink, current_len, window});
-        size_t tail_capacity = window - keep_sink;
-        if (new_seq_len >= tail_capacity) {
-            if (tail_capacity > 0) {
-                size_t source_offset = new_seq_len - tail_capacity;
-                cactus_quantize_kv_fp16_to_int8(source + source_offset * int8_stride,
-                    int8_base + keep_sink * int8_stride, scale_base + keep_sink * scale_stride,
-                    tail_capacity, kv_heads, hdim);
-            }
-            meta->current_seq_len = keep_sink + tail_capacity;
-            return;
+    if (new_total <= window) {
+        write_rows(current_len, source, new_seq_len);
+        meta->current_seq_len = new_total;
+        if (spill_cache(meta)) spill_after_write(cache_buf, current_len);
+        return;
+    }
+
+    size_t keep_sink = std::min({sink, current_len, window});
+    size_t tail_capacity = window - keep_sink;
+    if (new_seq_len >= tail_capacity) {
+        write_rows(keep_sink, source + (new_seq_len - tail_capacity) * int8_stride, tail_capacity);
+        meta->current_seq_len = keep_sink + tail_capacity;
+        meta->ring_head = 0;
+        if (spill_cache(meta)) spill_after_write(cache_buf, keep_sink);
+        return;
+    }
+
+    if (sliding) {
+        size_t fill = window - current_len;
+        write_rows(current_len, source, fill);
+        size_t head = meta->ring_head;
+        for (size_t done = fill; done < new_seq_len;) {
+            size_t run = std::min(new_seq_len - done, tail_capacity - head);
+            write_rows(keep_sink + head, source + done * int8_stride, run);
+            done += run;
+            head = (head + run) % tail_capacity;
         }
-        size_t remaining = std::min(tail_capacity - new_seq_len, current_len - keep_sink);
-        size_t shift_src = current_len - remaining;
-        if (remaining > 0 && shift_src > keep_sink) {
+        meta->ring_head = head;
+        meta->current_seq_len = window;
+        return;
+    }
+
+    size_t remaining = std::min(tail_capacity - new_seq_len, current_len - keep_sink);
+    size_t shift_src = current_len - remaining;
+    if (remaining > 0 && shift_src > keep_sink) {
+        if (fp16_cache) {
+            std::memmove(fp16_base + keep_sink * int8_stride, fp16_base + shift_src * int8_stride,
+                         remaining * int8_stride * sizeof(__fp16));
+        } else {
             std::memmove(int8_base + keep_sink * int8_stride, int8_base + shift_src * int8_stride,
                          remaining * int8_stride);
             std::memmove(scale_base + keep_sink * scale_stride, scale_base + shift_src * scale_stride,
                          remaining * scale_stride * sizeof(float));
         }
-        size_t append_offset = keep_sink + remaining;
-        cactus_quantize_kv_fp16_to_int8(source, int8_base + append_offset * int8_stride,
-            scale_base + append_offset * scale_stride, new_seq_len, kv_heads, hdim);
-        meta->current_seq_len = append_offset + new_seq_len;
-    } else {
-        cactus_quantize_kv_fp16_to_int8(source, int8_base + current_len * int8_stride,
-            scale_base + current_len * scale_stride, new_seq_len, kv_heads, hdim);
-        meta->current_seq_len = new_total;
     }
+    size_t append_offset = keep_sink + remaining;
+    write_rows(append_offset, source, new_seq_len);
+    meta->current_seq_len = append_offset + new_seq_len;
+    if (spill_cache(meta)) spill_after_write(cache_buf, keep_sink);
 }
 
 void compute_kv_cache_append_node(
@@ -305,6 +760,136 @@ void compute_kv_cache_append_node(
     *node.output_buffer.data_as<float>() = static_cast<float>(get_meta(cache_buf, slot)->current_seq_len);
 }
 
+// Projection for the fused attention entry: CQ weights go through the quantized matmul, FP16
+// weights are the pretransposed [N, K] layout matmul(x, w, true) expects.
+static void project_qkv(const BufferDesc& weight, const __fp16* x, size_t rows, size_t hidden, __fp16* out) {
+    if (weight.is_cq()) {
+        CactusQuantMatrix mat = weight.to_cq_matrix();
+        if (weight.cq_flags & CACTUS_QUANT_FLAG_ORTHOGONAL)
+            cactus_quant_orthogonal_matmul(&mat, x, static_cast<uint32_t>(rows), out);
+        else
+            cactus_quant_matmul(&mat, x, static_cast<uint32_t>(rows), out);
+    } else if (weight.precision == Precision::FP16) {
+        cactus_matmul_f16(x, weight.data_as<__fp16>(), out, rows, hidden, weight.shape[0]);
+    } else {
+        throw std::runtime_error("qkv_rope_cache_append supports FP16 and CQ projection weights");
+    }
+}
+
+// Q is projected straight into the output and K/V into scratch; RoPE runs in place on both, then
+// K and V go through the same slot append as KV_CACHE_APPEND, which quantizes them into the cache.
+void compute_qkv_rope_cache_append_node(
+    GraphNode& node,
+    const nodes_vector& nodes,
+    const node_index_map_t& node_index_map) {
+
+    const auto& input = get_input(node, 0, nodes, node_index_map);
+    if (input.precision != Precision::FP16) {
+        throw std::runtime_error("qkv_rope_cache_append requires FP16 input");
+    }
+    auto& k_cache_node = *nodes[node_index_map.at(node.input_ids[4])];
+    auto& v_cache_node = *nodes[node_index_map.at(node.input_ids[5])];
+    BufferDesc& k_cache_buf = k_cache_node.output_buffer;
+    BufferDesc& v_cache_buf = v_cache_node.output_buffer;
+
+    const size_t slot = node.params.cache_slot;
+    const auto* k_meta = get_meta(k_cache_buf, slot);
+    const size_t num_slots = k_meta->num_slots ? k_meta->num_slots : 1;
+    const size_t kv_heads = node.params.num_kv_heads;
+    const size_t hdim = node.params.head_dim;
+    const size_t hidden = input.shape.back();
+    const size_t tokens = input.total_size / hidden;
+    const size_t q_heads = node.output_buffer.shape[2];
+    const size_t kv_width = kv_heads * hdim;
+
+    thread_local std::vector<__fp16> kv_scratch;
+    if (kv_scratch.size() < 2 * tokens * kv_width) kv_scratch.resize(2 * tokens * kv_width);
+    __fp16* q = node.output_buffer.data_as<__fp16>();
+    __fp16* k = kv_scratch.data();
+    __fp16* v = k + tokens * kv_width;
+
+    const __fp16* x = input.data_as<__fp16>();
+    project_qkv(get_input(node, 1, nodes, node_index_map), x, tokens, hidden, q);
+    project_qkv(get_input(node, 2, nodes, node_index_map), x, tokens, hidden, k);
+    project_qkv(get_input(node, 3, nodes, node_index_map), x, tokens, hidden, v);
+    cactus_rope_qk_f16(q, k, tokens, q_heads, kv_heads, hdim, node.params.position_offset, node.params.theta);
+
+    kv_append_one_slot(k_cache_buf, slot, num_slots, k, tokens, node.params.window_size,
+                       k_cache_node.params.max_cache_seq_len);
+    kv_append_one_slot(v_cache_buf, slot, num_slots, v, tokens, node.params.window_size,
+                       v_cache_node.params.max_cache_seq_len);
+}
+
+// One decode token against a spilled cache reads the pinned sink, the CACTUS_KV_SPILL_TOPK cold
+// blocks whose key summaries bound q.k highest, and the hot tail, gathered into scratch for the
+// INT8 kernel. In cache-only mode the token's own K/V is the last cache row, which the hot tail
+// always holds. Returns false while every cold block would be read anyway.
+static bool attention_spill_decode(
+    GraphNode& node, const BufferDesc& query_buf, const BufferDesc& key_new_buf, const BufferDesc& val_new_buf,
+    const BufferDesc& k_cache_buf, const BufferDesc& v_cache_buf, size_t history_len, bool cache_only,
+    size_t num_q_heads, size_t v_hdim) {
+    const auto* k_meta = get_meta(k_cache_buf);
+    const auto* v_meta = get_meta(v_cache_buf);
+    const size_t pinned = spill_pinned_rows(k_meta);
+    const size_t cold_end = spill_cold_end(k_meta, history_len);
+    const size_t top_k = kv_spill_setting("CACTUS_KV_SPILL_TOPK", 16);
+    if (cold_end <= pinned || (cold_end - pinned) / KV_SPILL_BLOCK <= top_k) return false;
+
+    const size_t kv_heads = k_meta->num_kv_heads;
+    const size_t hdim = k_meta->head_dim;
+    const size_t first_block = pinned / KV_SPILL_BLOCK;
+    const size_t cold_blocks = cold_end / KV_SPILL_BLOCK - first_block;
+    thread_local std::vector<float> scores;
+    thread_local std::vector<size_t> picked;
+    scores.resize(cold_blocks);
+    picked.resize(cold_blocks);
+    cactus_kv_block_scores_f16(query_buf.data_as<__fp16>(),
+                               spill_summaries(k_cache_buf) + first_block * kv_heads * 2 * hdim,
+                               scores.data(), cold_blocks, num_q_heads, kv_heads, hdim);
+    std::iota(picked.begin(), picked.end(), size_t{0});
+    std::nth_element(picked.begin(), picked.begin() + top_k, picked.end(),
+                     [](size_t a, size_t b) { return scores[a] > scores[b]; });
+    std::sort(picked.begin(), picked.begin() + top_k);
+
+    const size_t rows = pinned + top_k * KV_SPILL_BLOCK + (history_len - cold_end);
+    const size_t k_groups = (hdim + KV_QUANT_GROUP_SIZE - 1) / KV_QUANT_GROUP_SIZE;
+    const size_t v_groups = (v_meta->head_dim + KV_QUANT_GROUP_SIZE - 1) / KV_QUANT_GROUP_SIZE;
+    thread_local std::vector<int8_t> keys, values;
+    thread_local std::vector<float> k_scales, v_scales;
+    keys.resize(rows * kv_heads * hdim);
+    values.resize(rows * kv_heads * v_meta->head_dim);
+    k_scales.resize(rows * kv_heads * k_groups);
+    v_scales.resize(rows * kv_heads * v_groups);
+    const int8_t* k_src = get_int8_data(k_cache_buf);
+    const int8_t* v_src = get_int8_data(v_cache_buf);
+    const float* ks_src = get_scales(k_cache_buf, k_meta->max_seq_len, kv_heads, hdim);
+    const float* vs_src = get_scales(v_cache_buf, v_meta->max_seq_len, kv_heads, v_meta->head_dim);
+    size_t filled = 0;
+    auto gather = [&](size_t row, size_t count) {
+        auto copy = [&](auto* dst, const auto* src, size_t width) {
+            std::memcpy(dst + filled * width, src + row * width, count * width * sizeof(*src));
+        };
+        copy(keys.data(), k_src, kv_heads * hdim);
+        copy(values.data(), v_src, kv_heads * v_meta->head_dim);
+        copy(k_scales.data(), ks_src, kv_heads * k_groups);
+        copy(v_scales.data(), vs_src, kv_heads * v_groups);
+        filled += count;
+    };
+    gather(0, pinned);
+    for (size_t i = 0; i < top_k; ++i) gather((first_block + picked[i]) * KV_SPILL_BLOCK, KV_SPILL_BLOCK);
+    gather(cold_end, history_len - cold_end);
+    spill_release_cold(k_cache_buf);
+    spill_release_cold(v_cache_buf);
+
+    cactus_attention_hybrid_int8_fp16(
+        query_buf.data_as<__fp16>(), keys.data(), values.data(), k_scales.data(), v_scales.data(),
+        key_new_buf.data_as<__fp16>(), val_new_buf.data_as<__fp16>(),
+        node.output_buffer.data_as<__fp16>(),
+        1, 1, rows, cache_only ? 0 : 1, num_q_heads, kv_heads, hdim, node.params.scale,
+        cache_only ? rows - 1 : rows, true, 0, KV_QUANT_GROUP_SIZE, v_hdim);
+    return true;
+}
+
 void compute_attention_cached_node(
     GraphNode& node,
     const nodes_vector& nodes,
@@ -327,6 +912,7 @@ void compute_attention_cached_node(
     const auto* v_meta = get_meta(v_cache_buf, slot);
     size_t v_hdim = node.params.v_head_dim > 0 ? node.params.v_head_dim : hdim;
     size_t v_max = v_meta->max_seq_len;
+    const CactusKVRing ring = kv_rows(k_cache_buf, v_cache_buf, slot, v_hdim);
 
     const int8_t* cached_keys = get_int8_data(k_cache_buf, slot);
     const float* k_scales = get_scales(k_cache_buf, k_max, kv_heads, hdim, slot);
@@ -351,6 +937,34 @@ void compute_attention_cached_node(
         cache_only_attention = true;
     }
 
+    if (lowbit_cache(k_meta)) {
+        if (!lowbit_cache(v_meta) || batch_size != 1) {
+            throw std::runtime_error("low-bit KV cache needs low-bit keys and values and a single sequence");
+        }
+        cactus_attention_hybrid_lowbit_fp16(
+            query_buf.data_as<__fp16>(),
+            lowbit_key_blocks(k_cache_buf),
+            lowbit_key_residual(k_cache_buf),
+            lowbit_value_rows(v_cache_buf),
+            key_new_buf.data_as<__fp16>(),
+            val_new_buf.data_as<__fp16>(),
+            node.output_buffer.data_as<__fp16>(),
+            seq_len, history_len, k_meta->packed_rows, cache_only_attention ? 0 : seq_len,
+            num_q_heads, kv_heads, hdim, k_meta->kv_bits,
+            node.params.scale,
+            position_offset,
+            true,
+            node.params.window_size);
+        return;
+    }
+
+    const bool spilled = spill_cache(k_meta) && spill_cache(v_meta);
+    if (spilled && batch_size == 1 && seq_len == 1 &&
+        attention_spill_decode(node, query_buf, key_new_buf, val_new_buf, k_cache_buf, v_cache_buf,
+                               history_len, cache_only_attention, num_q_heads, v_hdim)) {
+        return;
+    }
+
     if (batch_size > 1 && num_slots > 1) {
         bool fp16_cache = (k_cache_buf.precision == Precision::FP16 || v_cache_buf.precision == Precision::FP16);
         size_t q_stride = query_buf.total_size / batch_size;
@@ -362,8 +976,10 @@ void compute_attention_cached_node(
         const __fp16* vnew_all = val_new_buf.data_as<__fp16>();
         __fp16* out_all = node.output_buffer.data_as<__fp16>();
         for (size_t i = 0; i < batch_size; ++i) {
-            size_t ci = get_meta(k_cache_buf, i)->current_seq_len;
+            const auto* meta_i = get_meta(k_cache_buf, i);
+            size_t ci = meta_i->current_seq_len;
             size_t hist_i = (ci >= seq_len) ? ci - seq_len : 0;
+            const CactusKVRing ring_i = kv_rows(k_cache_buf, v_cache_buf, i, v_hdim);
             if (fp16_cache) {
                 cactus_attention_f16(
                     q_all + i * q_stride,
@@ -373,21 +989,21 @@ void compute_attention_cached_node(
                     1, seq_len, ci,
                     num_q_heads, kv_heads, hdim,
                     node.params.scale, nullptr, hist_i, node.params.window_size,
-                    true, false, false, v_hdim);
+                    true, false, false, v_hdim, 0.0f, ring_i);
             } else {
                 cactus_attention_hybrid_int8_fp16(
                     q_all + i * q_stride,
                     get_int8_data(k_cache_buf, i),
                     get_int8_data(v_cache_buf, i),
-                    get_scales(k_cache_buf, k_max, kv_heads, hdim, i),
-                    get_scales(v_cache_buf, v_max, kv_heads, v_hdim, i),
+                    get_scales(k_cache_buf, meta_i->max_seq_len, kv_heads, hdim, i),
+                    get_scales(v_cache_buf, get_meta(v_cache_buf, i)->max_seq_len, kv_heads, v_hdim, i),
                     knew_all + i * knew_stride,
                     vnew_all + i * vnew_stride,
                     out_all + i * out_stride,
                     1, seq_len, hist_i, seq_len,
                     num_q_heads, kv_heads, hdim,
                     node.params.scale, hist_i, true, node.params.window_size,
-                    KV_QUANT_GROUP_SIZE, v_hdim);
+                    KV_QUANT_GROUP_SIZE, v_hdim, ring_i);
             }
         }
         return;
@@ -408,7 +1024,9 @@ void compute_attention_cached_node(
             true,
             false,
             false,
-            v_hdim);
+            v_hdim,
+            0.0f,
+            ring);
         return;
     }
 
@@ -428,7 +1046,14 @@ void compute_attention_cached_node(
         true,
         node.params.window_size,
         KV_QUANT_GROUP_SIZE,
-        v_hdim);
+        v_hdim,
+        ring);
+    // A full read (prefill, or a history the block filter would not thin out) faulted the cold
+    // rows back in; let them go again.
+    if (spilled) {
+        spill_release_cold(k_cache_buf);
+        spill_release_cold(v_cache_buf);
+    }
 }
 
 void compute_conv_cache_state_node(
@@ -586,12 +1211,30 @@ void CactusGraph::steal_cache_buffer(size_t dst_node, CactusGraph& src, size_t s
     s->output_buffer = BufferDesc(shape, prec);
 }
 
+BufferDesc CactusGraph::take_cache_buffer(size_t node_id) {
+    auto& node = nodes_[node_index_map_.at(node_id)];
+    auto shape = node->output_buffer.shape;
+    auto prec = node->output_buffer.precision;
+    BufferDesc taken = std::move(node->output_buffer);
+    node->output_buffer = BufferDesc(shape, prec);
+    return taken;
+}
+
+void CactusGraph::restore_cache_buffer(size_t node_id, BufferDesc buffer) {
+    nodes_[node_index_map_.at(node_id)]->output_buffer = std::move(buffer);
+}
+
 namespace {
 
+// Pads that spill past a full sliding window overwrite the oldest ring rows; those rows are saved
+// so the rollback can put them back and leave the ring where the real tokens alone would.
 struct PaddedAppendBackup {
-    uint64_t overshoot;
+    uint64_t len0;
+    uint64_t ring_head0;
     uint64_t keep_sink;
-    uint64_t kept_padded;
+    uint64_t tail_capacity;
+    uint64_t first_ring_row;
+    uint64_t ring_pads;
 };
 
 struct CacheRowRegion {
@@ -631,22 +1274,26 @@ std::vector<uint8_t> CactusGraph::snapshot_cache_padded_append(size_t node_id, s
     if (appended >= tail_capacity) {
         throw std::runtime_error("padded cache append larger than the attention window is not supported");
     }
-    auto kept_after = [&](size_t n) { return std::min(tail_capacity - n, len0 - keep_sink); };
-    const size_t kept_real = kept_after(real_tokens);
-    const size_t kept_padded = kept_after(appended);
-    const size_t overshoot = kept_real - kept_padded;
-    if (overshoot == 0) return {};
-
-    const size_t first_saved_row = len0 - kept_real;
+    // Tokens [0, fill) land linearly; the rest walk the ring from ring_head.
+    const size_t fill = window - len0;
+    const size_t first_ring_pad = std::max(real_tokens, fill);
+
+    PaddedAppendBackup header;
+    header.len0 = len0;
+    header.ring_head0 = meta->ring_head;
+    header.keep_sink = keep_sink;
+    header.tail_capacity = tail_capacity;
+    header.first_ring_row = (meta->ring_head + first_ring_pad - fill) % tail_capacity;
+    header.ring_pads = appended - first_ring_pad;
     std::vector<uint8_t> backup(sizeof(PaddedAppendBackup));
-    auto* header = reinterpret_cast<PaddedAppendBackup*>(backup.data());
-    header->overshoot = overshoot;
-    header->keep_sink = keep_sink;
-    header->kept_padded = kept_padded;
+    std::memcpy(backup.data(), &header, sizeof(header));
     const auto* base = static_cast<const uint8_t*>(buf.get_data());
     for (const auto& region : cache_row_regions(buf, meta)) {
-        const uint8_t* rows = base + region.offset + first_saved_row * region.row_bytes;
-        backup.insert(backup.end(), rows, rows + overshoot * region.row_bytes);
+        for (size_t i = 0; i < header.ring_pads; ++i) {
+            const size_t row = keep_sink + (header.first_ring_row + i) % tail_capacity;
+            const uint8_t* src = base + region.offset + row * region.row_bytes;
+            backup.insert(backup.end(), src, src + region.row_bytes);
+        }
     }
     return backup;
 }
@@ -661,21 +1308,23 @@ void CactusGraph::rollback_cache_padded_append(size_t node_id, size_t real_token
         meta->current_seq_len = meta->current_seq_len >= pad_tokens ? meta->current_seq_len - pad_tokens : 0;
         return;
     }
-    const auto* header = reinterpret_cast<const PaddedAppendBackup*>(backup.data());
-    const size_t overshoot = header->overshoot;
-    const size_t keep_sink = header->keep_sink;
-    const size_t kept_padded = header->kept_padded;
-    const size_t move_rows = kept_padded + real_tokens;
+    PaddedAppendBackup header;
+    std::memcpy(&header, backup.data(), sizeof(header));
     auto* base = static_cast<uint8_t*>(buf.get_data());
     const uint8_t* saved = backup.data() + sizeof(PaddedAppendBackup);
     for (const auto& region : cache_row_regions(buf, meta)) {
-        uint8_t* rows = base + region.offset;
-        std::memmove(rows + (keep_sink + overshoot) * region.row_bytes,
-                     rows + keep_sink * region.row_bytes, move_rows * region.row_bytes);
-        std::memcpy(rows + keep_sink * region.row_bytes, saved, overshoot * region.row_bytes);
-        saved += overshoot * region.row_bytes;
+        for (size_t i = 0; i < header.ring_pads; ++i) {
+            const size_t row = header.keep_sink + (header.first_ring_row + i) % header.tail_capacity;
+            std::memcpy(base + region.offset + row * region.row_bytes, saved, region.row_bytes);
+            saved += region.row_bytes;
+        }
     }
-    meta->current_seq_len = keep_sink + overshoot + kept_padded + real_tokens;
+    const size_t window = header.keep_sink + header.tail_capacity;
+    const size_t fill = window - header.len0;
+    meta->current_seq_len = std::min(header.len0 + real_tokens, window);
+    meta->ring_head = real_tokens > fill
+        ? (header.ring_head0 + real_tokens - fill) % header.tail_capacity
+        : header.ring_head0;
 }
 
 void CactusGraph::shrink_cache_buffer(size_t node_id, size_t new_capacity) {
@@ -687,3 +1336,190 @@ void CactusGraph::shrink_cache_buffer(size_t node_id, size_t new_capacity) {
     resize_cache_buffer(buf, target);
 }
 
+// Grows ahead of appends (same doubling, same ceiling) so row pointers stay stable until
+// current_seq_len reaches min_capacity.
+void CactusGraph::reserve_cache_buffer(size_t node_id, size_t min_capacity) {
+    auto& node = *nodes_[node_index_map_.at(node_id)];
+    auto& buf = node.output_buffer;
+    if (!buf.get_data() || node.op_type != OpType::KV_CACHE_STATE) return;
+    const size_t ceiling = node.params.max_cache_seq_len;
+    if (get_meta(buf)->num_slots > 1 || (node.params.window_size > 0 && node.params.window_size < ceiling)) return;
+    grow_cache_buffer(buf, min_capacity, ceiling);
+}
+
+// Forks one slot into another: dst takes src's metadata and every row src has written, so both
+// share the prefix and diverge on their next append. A wrapped ring is copied whole. In a
+// share_cache_prefix layout the prefix never moves: forking the prefix slot only points dst at
+// it, and forking a slot that continues it copies just the rows past it.
+void CactusGraph::copy_cache_slot(size_t node_id, size_t src_slot, size_t dst_slot) {
+    auto& node = *nodes_[node_index_map_.at(node_id)];
+    if (node.op_type != OpType::KV_CACHE_STATE) {
+        throw std::runtime_error("copy_cache_slot expects a kv_cache_state node");
+    }
+    auto& buf = node.output_buffer;
+    if (!buf.get_data() || src_slot == dst_slot) return;
+    const auto* m0 = get_meta(buf);
+    const size_t num_slots = m0->num_slots ? m0->num_slots : 1;
+    if (src_slot >= num_slots || dst_slot >= num_slots) {
+        throw std::runtime_error("copy_cache_slot slot index out of range");
+    }
+    const auto* src = get_meta(buf, src_slot);
+    auto* dst = get_meta(buf, dst_slot);
+    if (shared_prefix_slot(src) != shared_prefix_slot(dst)) {
+        if (!shared_prefix_slot(dst) || src_slot != num_slots - 1) {
+            throw std::runtime_error("copy_cache_slot cannot copy between a shared prefix and its own slots");
+        }
+        dst->current_seq_len = src->current_seq_len;
+        dst->packed_rows = static_cast<uint32_t>(src->current_seq_len);
+        return;
+    }
+    const size_t first = shared_prefix_slot(src) ? src->packed_rows : 0;
+    const size_t rows = src->ring_head != 0 ? src->max_seq_len : src->current_seq_len - first;
+    auto* base = static_cast<uint8_t*>(buf.get_data());
+    const size_t src_off = kv_slot_off(buf, src_slot);
+    const size_t dst_off = kv_slot_off(buf, dst_slot);
+    for (const auto& region : cache_row_regions(buf, m0)) {
+        std::memcpy(base + dst_off + region.offset, base + src_off + region.offset, rows * region.row_bytes);
+    }
+    *dst = *src;
+}
+
+// Lays a cache out again over `num_slots` slots; src_slot's metadata and rows move into dst_slot
+// and every other slot starts empty. Unlike resize_cache_slots the sequence survives, so a
+// prefilled conversation can enter a multi-slot layout and come back out of it.
+void CactusGraph::reslot_cache(size_t node_id, size_t num_slots, size_t src_slot, size_t dst_slot) {
+    auto& node = *nodes_[node_index_map_.at(node_id)];
+    if (node.op_type != OpType::KV_CACHE_STATE) {
+        throw std::runtime_error("reslot_cache expects a kv_cache_state node");
+    }
+    if (num_slots == 0) num_slots = 1;
+    if (dst_slot >= num_slots) {
+        throw std::runtime_error("reslot_cache slot index out of range");
+    }
+    node.params.cache_num_slots = num_slots;
+    auto& buf = node.output_buffer;
+    if (!buf.get_data()) return;
+    const auto* m0 = get_meta(buf);
+    if (lowbit_cache(m0) || spill_cache(m0)) {
+        throw std::runtime_error("low-bit and spilled KV caches hold a single slot");
+    }
+    if (src_slot >= (m0->num_slots ? m0->num_slots : 1)) {
+        throw std::runtime_error("reslot_cache slot index out of range");
+    }
+    const auto* src = get_meta(buf, src_slot);
+    const size_t ceiling = node.params.max_cache_seq_len;
+    const size_t window = node.params.window_size;
+    size_t max_seq;
+    if (window > 0 && window < ceiling) max_seq = std::min(ceiling, window + node.params.cache_sink_size + 1);
+    else if (num_slots > 1) max_seq = ceiling;
+    else max_seq = std::min(ceiling, std::max<size_t>(kInitialCacheEntries, src->current_seq_len));
+
+    const bool fp16_cache = buf.precision == Precision::FP16;
+    const size_t per_slot = fp16_cache ? fp16_cache_elements(max_seq, m0->num_kv_heads, m0->head_dim)
+                                       : cache_buffer_size(max_seq, m0->num_kv_heads, m0->head_dim);
+    BufferDesc laid_out({num_slots * per_slot}, buf.precision);
+    laid_out.allocate();
+    std::memset(laid_out.get_data(), 0, laid_out.byte_size);
+    CacheMetadata meta = *src;
+    meta.max_seq_len = max_seq;
+    meta.num_slots = num_slots;
+    meta.current_seq_len = 0;
+    meta.ring_head = 0;
+    meta.kv_flags &= static_cast<uint8_t>(~kKvSharedPrefix);
+    meta.packed_rows = 0;
+    for (size_t s = 0; s < num_slots; ++s) *get_meta(laid_out, s) = meta;
+
+    // A slot that continues a shared prefix comes out whole: the prefix rows, then its own.
+    const auto to = cache_row_regions(laid_out, get_meta(laid_out));
+    auto* dst_base = static_cast<uint8_t*>(laid_out.get_data()) + kv_slot_off(laid_out, dst_slot);
+    auto copy_rows = [&](size_t slot, size_t first, size_t rows) {
+        const auto from = cache_row_regions(buf, get_meta(buf, slot));
+        const auto* src_base = static_cast<const uint8_t*>(buf.get_data()) + kv_slot_off(buf, slot);
+        for (size_t r = 0; r < from.size(); ++r) {
+            std::memcpy(dst_base + to[r].offset + first * to[r].row_bytes, src_base + from[r].offset,
+                        rows * from[r].row_bytes);
+        }
+    };
+    const size_t shared = shared_prefix_slot(src) ? src->packed_rows : 0;
+    if (shared > 0) copy_rows(m0->num_slots - 1, 0, shared);
+    copy_rows(src_slot, shared, src->ring_head != 0 ? src->max_seq_len : src->current_seq_len - shared);
+    meta.current_seq_len = src->current_seq_len;
+    meta.ring_head = src->ring_head;
+    *get_meta(laid_out, dst_slot) = meta;
+    buf = std::move(laid_out);
+}
+
+// Lays a cache out for `num_slots` sequences that all continue src_slot's. Its rows move once into
+// a prefix slot at index num_slots, sized to them; slots [0, num_slots) start empty with room for
+// `tail_rows` rows of their own. copy_cache_slot from the prefix slot starts a sequence on the
+// whole prefix without copying it, and attention on such a slot reads the prefix, then its rows.
+// A sliding window shifts and wraps its rows, so it falls back to num_slots + 1 full slots.
+void CactusGraph::share_cache_prefix(size_t node_id, size_t num_slots, size_t src_slot, size_t tail_rows) {
+    auto& node = *nodes_[node_index_map_.at(node_id)];
+    if (node.op_type != OpType::KV_CACHE_STATE) {
+        throw std::runtime_error("share_cache_prefix expects a kv_cache_state node");
+    }
+    if (num_slots == 0) num_slots = 1;
+    const size_t ceiling = node.params.max_cache_seq_len;
+    const size_t window = node.params.window_size;
+    auto& buf = node.output_buffer;
+    if ((window > 0 && window < ceiling) || !buf.get_data()) {
+        reslot_cache(node_id, num_slots + 1, src_slot, num_slots);
+        return;
+    }
+    const auto* m0 = get_meta(buf);
+    if (lowbit_cache(m0) || spill_cache(m0)) {
+        throw std::runtime_error("low-bit and spilled KV caches hold a single slot");
+    }
+    if (src_slot >= (m0->num_slots ? m0->num_slots : 1) || shared_prefix_slot(get_meta(buf, src_slot))) {
+        throw std::runtime_error("share_cache_prefix needs a whole sequence as its prefix");
+    }
+    const auto* src = get_meta(buf, src_slot);
+    const size_t prefix_rows = std::max<size_t>(src->current_seq_len, 1);
+    const size_t tail = std::max<size_t>(tail_rows, 1);
+    const bool fp16_cache = buf.precision == Precision::FP16;
+    auto slot_size = [&](size_t rows) {
+        return fp16_cache ? fp16_cache_elements(rows, m0->num_kv_heads, m0->head_dim)
+                          : cache_buffer_size(rows, m0->num_kv_heads, m0->head_dim);
+    };
+    BufferDesc laid_out({num_slots * slot_size(tail) + slot_size(prefix_rows)}, buf.precision);
+    laid_out.allocate();
+    std::memset(laid_out.get_data(), 0, laid_out.byte_size);
+    CacheMetadata meta = *src;
+    meta.num_slots = num_slots + 1;
+    meta.ring_head = 0;
+    meta.max_seq_len = tail;
+    meta.current_seq_len = 0;
+    meta.kv_flags |= kKvSharedPrefix;
+    meta.packed_rows = 0;
+    for (size_t s = 0; s < num_slots; ++s) *get_meta(laid_out, s) = meta;
+    meta.max_seq_len = prefix_rows;
+    meta.current_seq_len = src->current_seq_len;
+    meta.kv_flags = src->kv_flags;
+    meta.packed_rows = src->packed_rows;
+    auto* prefix = get_meta(laid_out, num_slots);
+    *prefix = meta;
+
+    const auto from = cache_row_regions(buf, src);
+    const auto to = cache_row_regions(laid_out, prefix);
+    const auto* src_base = static_cast<const uint8_t*>(buf.get_data()) + kv_slot_off(buf, src_slot);
+    auto* dst_base = static_cast<uint8_t*>(laid_out.get_data()) + kv_slot_off(laid_out, num_slots);
+    for (size_t r = 0; r < from.size(); ++r) {
+        std::memcpy(dst_base + to[r].offset, src_base + from[r].offset, src->current_seq_len * from[r].row_bytes);
+    }
+    node.params.cache_num_slots = num_slots + 1;
+    buf = std::move(laid_out);
+}
+
+// Low-bit and spilled storage hold exactly one sequence; an empty cache answers for the layout
+// the environment would give it.
+bool CactusGraph::cache_slots_supported(size_t node_id) const {
+    const auto& node = *nodes_[node_index_map_.at(node_id)];
+    if (node.op_type != OpType::KV_CACHE_STATE) return false;
+    if (node.output_buffer.get_data()) {
+        const auto* meta = get_meta(node.output_buffer);
+        return !lowbit_cache(meta) && !spill_cache(meta);
+    }
+    return use_fp16_kv_cache() || (requested_kv_cache_bits() >= 8 && !kv_spill_dir());
+}
+
@@ -911,3 +911,50 @@ void compute_conv2d_k3s1p1_node(GraphNode& node, const std::vector<std::unique_p
 
     throw std::runtime_error("conv2d_k3s1p1 only supports FP16 weights");
 }
+
+void compute_conv2d_node(GraphNode& node, const std::vector<std::unique_ptr<GraphNode>>& nodes,
+                         const std::unordered_map<size_t, size_t>& node_index_map) {
+    const auto& X = get_input(node, 0, nodes, node_index_map);
+    const auto& W = get_input(node, 1, nodes, node_index_map);
+    const BufferDesc* B = nullptr;
+    if (node.input_ids.size() >= 3) {
+        B = &get_input(node, 2, nodes, node_index_map);
+    }
+    auto& Y = node.output_buffer;
+    const auto& p = node.params;
+
+    if (X.shape.size() != 4 || W.shape.size() != 4) {
+        throw std::runtime_error("conv2d expects 4D input and [C_out, C_in / groups, KH, KW] weight");
+    }
+    if (X.precision != Precision::FP16) {
+        throw std::runtime_error("conv2d only supports FP16 activations");
+    }
+    if (W.precision != Precision::FP16) {
+        throw std::runtime_error("conv2d only supports FP16 weights");
+    }
+
+    const size_t N = X.shape[0];
+    const size_t C_in = p.nhwc_input ? X.shape[3] : X.shape[1];
+    const size_t H = p.nhwc_input ? X.shape[1] : X.shape[2];
+    const size_t W_in = p.nhwc_input ? X.shape[2] : X.shape[3];
+    const size_t C_out = W.shape[0];
+    const size_t groups = p.num_groups == 0 ? 1 : p.num_groups;
+
+    const __fp16* bias_ptr = nullptr;
+    std::vector<__fp16> bias_fp16;
+    if (B) {
+        if (B->precision == Precision::FP16) {
+            bias_ptr = B->data_as<__fp16>();
+        } else if (B->precision == Precision::FP32) {
+            bias_fp16.resize(C_out);
+            cactus_fp32_to_fp16(B->data_as<float>(), bias_fp16.data(), C_out);
+            bias_ptr = bias_fp16.data();
+        } else {
+            throw std::runtime_error("conv2d bias only supports FP16/FP32");
+        }
+    }
+
+    cactus_conv2d_f16(X.data_as<__fp16>(), W.data_as<__fp16>(), bias_ptr, Y.data_as<__fp16>(),
+                      N, C_in, H, W_in, C_out, W.shape[2], W.shape[3],
+                      p.stride, p.padding, p.dilation, groups, p.nhwc_input, p.nhwc_output);
+}
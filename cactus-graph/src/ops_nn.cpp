@@ -81,29 +81,43 @@ void compute_matmul_node(GraphNode& node, const std::vector<std::unique_ptr<Grap
 }
 
 namespace {
-    thread_local std::vector<__fp16> moe_compact_hidden_buf;
-    thread_local std::vector<__fp16> moe_gate_buf;
-    thread_local std::vector<__fp16> moe_gate_pad_buf;
-    thread_local std::vector<__fp16> moe_up_buf;
-    thread_local std::vector<__fp16> moe_expert_out_buf;
+    struct MoeExpertScratch {
+        std::vector<__fp16> compact_hidden;
+        std::vector<__fp16> gate;
+        std::vector<__fp16> up;
+        std::vector<__fp16> gate_pad;
+
+        void ensure(size_t tokens, size_t hidden_dim, size_t intermediate_dim, size_t padded_dim) {
+            if (compact_hidden.size() < tokens * hidden_dim) compact_hidden.resize(tokens * hidden_dim);
+            if (gate.size() < tokens * intermediate_dim) gate.resize(tokens * intermediate_dim);
+            if (up.size() < tokens * intermediate_dim) up.resize(tokens * intermediate_dim);
+            if (padded_dim != intermediate_dim && gate_pad.size() < tokens * padded_dim) gate_pad.resize(tokens * padded_dim);
+        }
+    };
+
+    thread_local MoeExpertScratch moe_scratch;
+    thread_local std::vector<__fp16> moe_slot_out_buf;
     thread_local std::vector<size_t> moe_expert_offsets_buf;
     thread_local std::vector<size_t> moe_expert_tokens_buf;
+    thread_local std::vector<size_t> moe_token_slots_buf;
+    thread_local std::vector<size_t> moe_write_cursors_buf;
     thread_local std::vector<float> moe_routing_denom_buf;
 
-    void ensure_moe_buffers(size_t max_tokens, size_t hidden_dim, size_t intermediate_dim,
-                            size_t num_experts, size_t top_k) {
-        size_t hidden_size = max_tokens * hidden_dim;
-        size_t inter_size = max_tokens * intermediate_dim;
-        if (moe_compact_hidden_buf.size() < hidden_size) moe_compact_hidden_buf.resize(hidden_size);
-        if (moe_gate_buf.size() < inter_size) moe_gate_buf.resize(inter_size);
-        if (moe_up_buf.size() < inter_size) moe_up_buf.resize(inter_size);
-        if (moe_expert_out_buf.size() < hidden_size) moe_expert_out_buf.resize(hidden_size);
+    void ensure_moe_buffers(size_t max_tokens, size_t hidden_dim, size_t num_experts, size_t top_k) {
         size_t total_assignments = max_tokens * top_k;
+        if (moe_slot_out_buf.size() < total_assignments * hidden_dim) moe_slot_out_buf.resize(total_assignments * hidden_dim);
         if (moe_expert_offsets_buf.size() < num_experts + 1) moe_expert_offsets_buf.resize(num_experts + 1);
         if (moe_expert_tokens_buf.size() < total_assignments) moe_expert_tokens_buf.resize(total_assignments);
+        if (moe_token_slots_buf.size() < total_assignments) moe_token_slots_buf.resize(total_assignments);
+        if (moe_write_cursors_buf.size() < num_experts) moe_write_cursors_buf.resize(num_experts);
         if (moe_routing_denom_buf.size() < max_tokens) moe_routing_denom_buf.resize(max_tokens);
     }
 
+    bool moe_weight_supported(const BufferDesc& buffer) {
+        return buffer.precision == Precision::FP16 ||
+               (PrecisionTraits::is_cq(buffer.precision) && buffer.group_size > 0);
+    }
+
     void moe_matmul(const __fp16* lhs,
                     size_t M,
                     size_t K,
@@ -126,6 +140,41 @@ namespace {
 
         throw std::runtime_error("moe_layer only supports FP16 or TQ expert weights");
     }
+
+    void moe_activation(Activation activation, __fp16* data, size_t count) {
+        switch (activation) {
+            case Activation::GELU:
+                cactus_gelu_f16(data, data, count);
+                break;
+            case Activation::GELU_ERF:
+                cactus_gelu_f16_erf(data, data, count);
+                break;
+            case Activation::RELU:
+                cactus_relu_f16(data, data, count);
+                break;
+            case Activation::SIGMOID:
+                cactus_sigmoid_f16(data, data, count);
+                break;
+            case Activation::TANH:
+                cactus_tanh_f16(data, data, count);
+                break;
+            case Activation::SILU:
+            default:
+                cactus_silu_f16(data, data, count);
+                break;
+        }
+    }
+
+    // Fixed per-expert cost (in token units) of streaming its weights, used when balancing experts over threads.
+    constexpr size_t MOE_EXPERT_WEIGHT_COST = 2;
+
+    bool moe_expert_parallel_enabled() {
+        static const bool enabled = [] {
+            const char* env = std::getenv("CACTUS_MOE_EXPERT_PARALLEL");
+            return !(env && env[0] == '0');
+        }();
+        return enabled;
+    }
 }
 
 void compute_moe_layer_node(GraphNode& node, const std::vector<std::unique_ptr<GraphNode>>& nodes, const std::unordered_map<size_t, size_t>& node_index_map) {
@@ -181,10 +230,12 @@ void compute_moe_layer_node(GraphNode& node, const std::vector<std::unique_ptr<G
         return routing_fp32[offset];
     };
 
-    ensure_moe_buffers(token_count, hidden_dim, expert_intermediate_dim, num_experts, top_k);
+    ensure_moe_buffers(token_count, hidden_dim, num_experts, top_k);
 
-    size_t* expert_offsets = moe_expert_offsets_buf.data(); 
-    size_t* expert_tokens_flat = moe_expert_tokens_buf.data();  
+    size_t* expert_offsets = moe_expert_offsets_buf.data();
+    size_t* expert_tokens_flat = moe_expert_tokens_buf.data();
+    size_t* token_slots = moe_token_slots_buf.data();
+    __fp16* slot_out = moe_slot_out_buf.data();
 
     auto expert_index = [&](float raw_idx) -> size_t {
         if (!std::isfinite(raw_idx) || raw_idx < 0.0f) {
@@ -208,14 +259,14 @@ void compute_moe_layer_node(GraphNode& node, const std::vector<std::unique_ptr<G
         expert_offsets[e + 1] += expert_offsets[e];
     }
     
-    thread_local std::vector<size_t> moe_write_cursors;
-    if (moe_write_cursors.size() < num_experts) moe_write_cursors.resize(num_experts);
-    std::memcpy(moe_write_cursors.data(), expert_offsets, num_experts * sizeof(size_t));
+    size_t* write_cursors = moe_write_cursors_buf.data();
+    std::memcpy(write_cursors, expert_offsets, num_experts * sizeof(size_t));
 
     for (size_t tok = 0; tok < token_count; ++tok) {
         for (size_t k = 0; k < top_k; ++k) {
             size_t idx = expert_index(topk_idx[tok * top_k + k]);
-            expert_tokens_flat[moe_write_cursors[idx]++] = tok;
+            token_slots[tok * top_k + k] = write_cursors[idx];
+            expert_tokens_flat[write_cursors[idx]++] = tok;
         }
     }
 
@@ -231,99 +282,136 @@ void compute_moe_layer_node(GraphNode& node, const std::vector<std::unique_ptr<G
         }
     }
 
-    std::memset(output, 0, token_count * hidden_dim * sizeof(__fp16));
+    auto w1_for = [&](size_t e) -> const BufferDesc& { return get_input(node, 3 + e, nodes, node_index_map); };
+    auto w2_for = [&](size_t e) -> const BufferDesc& {
+        return get_input(node, (gated ? 3 + 2 * num_experts : 3 + num_experts) + e, nodes, node_index_map);
+    };
+    auto w3_for = [&](size_t e) -> const BufferDesc& { return get_input(node, 3 + num_experts + e, nodes, node_index_map); };
 
-    for (size_t expert_idx = 0; expert_idx < num_experts; ++expert_idx) {
-        const size_t start = expert_offsets[expert_idx];
-        const size_t end = expert_offsets[expert_idx + 1];
-        if (start == end) continue;
+    std::vector<size_t> active_experts;
+    for (size_t e = 0; e < num_experts; ++e) {
+        if (expert_offsets[e] == expert_offsets[e + 1]) continue;
+        const auto& w2_buffer = w2_for(e);
+        if (!moe_weight_supported(w1_for(e)) || !moe_weight_supported(w2_buffer) || (gated && !moe_weight_supported(w3_for(e)))) {
+            throw std::runtime_error("moe_layer only supports FP16 or TQ expert weights");
+        }
+        const size_t w2_k = w2_buffer.shape.size() == 2 ? w2_buffer.shape[1] : 0;
+        if (w2_k < expert_intermediate_dim) {
+            throw std::runtime_error("moe_layer down-proj weight K smaller than expert intermediate dim");
+        }
+        active_experts.push_back(e);
+    }
 
-        const size_t selected_count = end - start;
+    // Gate, activation, up and down projection for one expert over all of its tokens. Results land in the
+    // expert's contiguous slot rows, so experts can run concurrently without touching shared output rows.
+    auto run_expert = [&](size_t expert_idx) {
+        const size_t start = expert_offsets[expert_idx];
+        const size_t selected_count = expert_offsets[expert_idx + 1] - start;
         const size_t* selected_tokens = expert_tokens_flat + start;
-
-        const auto& w1_buffer = get_input(node, 3 + expert_idx, nodes, node_index_map);
-        const auto& w2_buffer = gated
-            ? get_input(node, 3 + 2 * num_experts + expert_idx, nodes, node_index_map)
-            : get_input(node, 3 + num_experts + expert_idx, nodes, node_index_map);
-
-        __fp16* compact_hidden = moe_compact_hidden_buf.data();
+        const auto& w1_buffer = w1_for(expert_idx);
+        const auto& w2_buffer = w2_for(expert_idx);
+        const size_t w2_k = w2_buffer.shape[1];
+
+        MoeExpertScratch& scratch = moe_scratch;
+        scratch.ensure(selected_count, hidden_dim, expert_intermediate_dim, w2_k);
+        __fp16* compact_hidden = scratch.compact_hidden.data();
+        __fp16* gate = scratch.gate.data();
         for (size_t i = 0; i < selected_count; ++i) {
             std::memcpy(compact_hidden + i * hidden_dim,
                         hidden + selected_tokens[i] * hidden_dim,
                         hidden_dim * sizeof(__fp16));
         }
 
-        __fp16* gate = moe_gate_buf.data();
-        __fp16* up = moe_up_buf.data();
-        __fp16* expert_out = moe_expert_out_buf.data();
-
         moe_matmul(compact_hidden, selected_count, hidden_dim, w1_buffer, gate, expert_intermediate_dim);
-
-        switch (activation) {
-            case Activation::GELU:
-                cactus_gelu_f16(gate, gate, selected_count * expert_intermediate_dim);
-                break;
-            case Activation::GELU_ERF:
-                cactus_gelu_f16_erf(gate, gate, selected_count * expert_intermediate_dim);
-                break;
-            case Activation::RELU:
-                cactus_relu_f16(gate, gate, selected_count * expert_intermediate_dim);
-                break;
-            case Activation::SIGMOID:
-                cactus_sigmoid_f16(gate, gate, selected_count * expert_intermediate_dim);
-                break;
-            case Activation::TANH:
-                cactus_tanh_f16(gate, gate, selected_count * expert_intermediate_dim);
-                break;
-            case Activation::SILU:
-            default:
-                cactus_silu_f16(gate, gate, selected_count * expert_intermediate_dim);
-                break;
-        }
+        moe_activation(activation, gate, selected_count * expert_intermediate_dim);
 
         if (gated) {
-            const auto& w3_buffer = get_input(node, 3 + num_experts + expert_idx, nodes, node_index_map);
-            moe_matmul(compact_hidden, selected_count, hidden_dim, w3_buffer, up, expert_intermediate_dim);
+            __fp16* up = scratch.up.data();
+            moe_matmul(compact_hidden, selected_count, hidden_dim, w3_for(expert_idx), up, expert_intermediate_dim);
             cactus_multiply_f16(gate, up, gate, selected_count * expert_intermediate_dim);
         }
 
-        const size_t w2_k = w2_buffer.shape.size() == 2 ? w2_buffer.shape[1] : 0;
-        if (w2_k < expert_intermediate_dim) {
-            throw std::runtime_error("moe_layer down-proj weight K smaller than expert intermediate dim");
-        }
         const __fp16* w2_input = gate;
         if (w2_k != expert_intermediate_dim) {
-            if (moe_gate_pad_buf.size() < selected_count * w2_k) moe_gate_pad_buf.resize(selected_count * w2_k);
-            std::memset(moe_gate_pad_buf.data(), 0, selected_count * w2_k * sizeof(__fp16));
+            __fp16* padded = scratch.gate_pad.data();
+            std::memset(padded, 0, selected_count * w2_k * sizeof(__fp16));
             for (size_t i = 0; i < selected_count; ++i) {
-                std::memcpy(moe_gate_pad_buf.data() + i * w2_k,
+                std::memcpy(padded + i * w2_k,
                             gate + i * expert_intermediate_dim,
                             expert_intermediate_dim * sizeof(__fp16));
             }
-            w2_input = moe_gate_pad_buf.data();
+            w2_input = padded;
         }
 
-        moe_matmul(w2_input, selected_count, w2_k, w2_buffer, expert_out, hidden_dim);
+        moe_matmul(w2_input, selected_count, w2_k, w2_buffer, slot_out + start * hidden_dim, hidden_dim);
+    };
 
-        for (size_t i = 0; i < selected_count; ++i) {
-            const size_t tok = selected_tokens[i];
-            float expert_prob = routing_prob(tok, expert_idx);
-            if (expert_prob <= 0.0f) continue;
+    // Experts holding more than a thread's fair share of the assignments keep intra-GEMM parallelism. The rest
+    // (every expert during decode) are packed longest-first onto the least loaded thread and run serially there.
+    const size_t num_threads = CactusThreading::get_thread_pool().num_workers();
+    const size_t total_assignments = token_count * top_k;
+    const size_t fair_share = std::max<size_t>(1, total_assignments / std::max<size_t>(1, num_threads));
+    std::vector<size_t> light_experts;
+    for (size_t e : active_experts) {
+        const size_t count = expert_offsets[e + 1] - expert_offsets[e];
+        if (num_threads > 1 && moe_expert_parallel_enabled() && count <= fair_share) {
+            light_experts.push_back(e);
+        } else {
+            run_expert(e);
+        }
+    }
 
-            float route_weight = expert_prob;
-            if (normalize_routing) {
-                route_weight = expert_prob / routing_denom[tok];
+    if (light_experts.size() == 1) {
+        run_expert(light_experts[0]);
+    } else if (!light_experts.empty()) {
+        auto expert_cost = [&](size_t e) { return expert_offsets[e + 1] - expert_offsets[e] + MOE_EXPERT_WEIGHT_COST; };
+        std::stable_sort(light_experts.begin(), light_experts.end(),
+                         [&](size_t a, size_t b) { return expert_cost(a) > expert_cost(b); });
+
+        const size_t num_bins = std::min(num_threads, light_experts.size());
+        std::vector<std::vector<size_t>> bins(num_bins);
+        std::vector<size_t> bin_load(num_bins, 0);
+        for (size_t e : light_experts) {
+            const size_t target = static_cast<size_t>(std::min_element(bin_load.begin(), bin_load.end()) - bin_load.begin());
+            bins[target].push_back(e);
+            bin_load[target] += expert_cost(e);
+        }
+
+        CactusThreading::parallel_for(num_bins, CactusThreading::ParallelConfig{2, 1}, [&](size_t start, size_t end) {
+            CactusThreading::SerialScope serial;
+            for (size_t b = start; b < end; ++b) {
+                for (size_t e : bins[b]) run_expert(e);
             }
-            route_weight *= routed_scaling_factor;
-            if (expert_scales_fp16) {
-                route_weight *= static_cast<float>(expert_scales_fp16[expert_idx]);
+        });
+    }
+
+    CactusThreading::parallel_for(token_count, CactusThreading::Thresholds::AXIS_REDUCE, [&](size_t tok_start, size_t tok_end) {
+        std::vector<std::pair<size_t, size_t>> routes(top_k);
+        for (size_t tok = tok_start; tok < tok_end; ++tok) {
+            for (size_t k = 0; k < top_k; ++k) {
+                routes[k] = {expert_index(topk_idx[tok * top_k + k]), token_slots[tok * top_k + k]};
             }
+            std::sort(routes.begin(), routes.end());
 
             auto* out_row = output + tok * hidden_dim;
-            const auto* expert_row = expert_out + i * hidden_dim;
-            cactus_add_scaled_f16(out_row, expert_row, out_row, hidden_dim, route_weight);
+            std::memset(out_row, 0, hidden_dim * sizeof(__fp16));
+            for (const auto& [expert_idx, slot] : routes) {
+                float expert_prob = routing_prob(tok, expert_idx);
+                if (expert_prob <= 0.0f) continue;
+
+                float route_weight = expert_prob;
+                if (normalize_routing) {
+                    route_weight = expert_prob / routing_denom[tok];
+                }
+                route_weight *= routed_scaling_factor;
+                if (expert_scales_fp16) {
+                    route_weight *= static_cast<float>(expert_scales_fp16[expert_idx]);
+                }
+
+                cactus_add_scaled_f16(out_row, slot_out + slot * hidden_dim, out_row, hidden_dim, route_weight);
+            }
         }
-    }
+    });
 }
 
 void compute_dense_mlp_tq_fused_node(GraphNode& node, const std::vector<std::unique_ptr<GraphNode>>& nodes, const std::unordered_map<size_t, size_t>& node_index_map) {
@@ -481,6 +569,26 @@ void compute_rms_norm_node(GraphNode& node, const std::vector<std::unique_ptr<Gr
        node.output_buffer.data_as<__fp16>(), batch_size, dims, node.params.epsilon);
 }
 
+void compute_rms_norm_matmul_node(GraphNode& node, const std::vector<std::unique_ptr<GraphNode>>& nodes, const std::unordered_map<size_t, size_t>& node_index_map) {
+    const auto& input_buffer = get_input(node, 0, nodes, node_index_map);
+    const auto& norm_buffer = get_input(node, 1, nodes, node_index_map);
+    const auto& weight_buffer = get_input(node, 2, nodes, node_index_map);
+
+    if (input_buffer.precision != Precision::FP16 || norm_buffer.precision != Precision::FP16) {
+        throw std::runtime_error("rms_norm_matmul requires FP16 input and norm weight");
+    }
+    if (!weight_buffer.is_cq()) {
+        throw std::runtime_error("rms_norm_matmul requires a CQ weight");
+    }
+
+    const size_t K = input_buffer.shape.back();
+    const size_t M = input_buffer.total_size / K;
+    CactusQuantMatrix mat = weight_buffer.to_cq_matrix();
+    cactus_quant_rms_norm_matmul(&mat, input_buffer.data_as<__fp16>(), norm_buffer.data_as<__fp16>(),
+                                 node.params.epsilon, static_cast<uint32_t>(M),
+                                 node.output_buffer.data_as<__fp16>());
+}
+
 void compute_rope_node(GraphNode& node, const std::vector<std::unique_ptr<GraphNode>>& nodes, const std::unordered_map<size_t, size_t>& node_index_map) {
     if (node.params.backend == ComputeBackend::NPU) {
         throw std::runtime_error("NPU RoPE operation not yet implemented");
@@ -143,6 +143,9 @@ enum class ParamField : uint32_t {
     MaxCacheSeqLen,
     CacheSinkSize,
     CacheNumSlots,
+    Padding,
+    NhwcInput,
+    NhwcOutput,
 };
 
 enum class FieldPersistence {
@@ -185,6 +188,7 @@ const Schema& op_schema(OpType op_type) {
         {OpType::TRANSPOSE, {{ParamField::Permutation, FieldPersistence::Persistent}, {ParamField::Backend, FieldPersistence::Persistent}}},
         {OpType::SLICE, {{ParamField::Axis, FieldPersistence::Persistent}, {ParamField::SliceStart, FieldPersistence::Persistent}, {ParamField::SliceLength, FieldPersistence::Persistent}}},
         {OpType::RMS_NORM, {{ParamField::Epsilon, FieldPersistence::Persistent}}},
+        {OpType::RMS_NORM_MATMUL, {{ParamField::Epsilon, FieldPersistence::Persistent}}},
         {OpType::LAYERNORM, {{ParamField::Epsilon, FieldPersistence::Persistent}}},
         {OpType::GROUPNORM, {{ParamField::Epsilon, FieldPersistence::Persistent}, {ParamField::NumGroups, FieldPersistence::Persistent}}},
         {OpType::BATCHNORM, {{ParamField::Epsilon, FieldPersistence::Persistent}, {ParamField::Axis, FieldPersistence::Persistent}}},
@@ -224,6 +228,14 @@ const Schema& op_schema(OpType op_type) {
             {ParamField::WindowSize, FieldPersistence::Persistent},
             {ParamField::VHeadDim, FieldPersistence::Persistent},
         }},
+        {OpType::QKV_ROPE_CACHE_APPEND, {
+            {ParamField::Theta, FieldPersistence::Persistent},
+            {ParamField::PositionOffset, FieldPersistence::Persistent},
+            {ParamField::WindowSize, FieldPersistence::Persistent},
+            {ParamField::CacheSinkSize, FieldPersistence::Persistent},
+            {ParamField::NumKvHeads, FieldPersistence::Persistent},
+            {ParamField::HeadDim, FieldPersistence::Persistent},
+        }},
         {OpType::CONV_CACHE_STATE, {
             {ParamField::WindowSize, FieldPersistence::Persistent},
             {ParamField::HeadDim, FieldPersistence::Persistent},
@@ -241,6 +253,7 @@ const Schema& op_schema(OpType op_type) {
         {OpType::CONV1D_K3, {{ParamField::Stride, FieldPersistence::Persistent}}},
         {OpType::CONV1D_K7S3, {{ParamField::Stride, FieldPersistence::Persistent}}},
         {OpType::CONV1D, {{ParamField::Stride, FieldPersistence::Persistent}}},
+        {OpType::CONV2D, {{ParamField::Stride, FieldPersistence::Persistent}, {ParamField::Padding, FieldPersistence::Persistent}, {ParamField::Dilation, FieldPersistence::Persistent}, {ParamField::NumGroups, FieldPersistence::Persistent}, {ParamField::NhwcInput, FieldPersistence::Persistent}, {ParamField::NhwcOutput, FieldPersistence::Persistent}}},
         {OpType::SAMPLE, {{ParamField::Temperature, FieldPersistence::Persistent}, {ParamField::TopP, FieldPersistence::Persistent}, {ParamField::MinP, FieldPersistence::Persistent}, {ParamField::RepetitionPenalty, FieldPersistence::Persistent}, {ParamField::TopK, FieldPersistence::Persistent}, {ParamField::RandomSeed, FieldPersistence::Persistent}, {ParamField::BiasIndices, FieldPersistence::Persistent}, {ParamField::BiasValues, FieldPersistence::Persistent}}},
     };
 
@@ -303,6 +316,9 @@ void write_field(std::ostream& out, ParamField field, const OpParams& params) {
         case ParamField::MaxCacheSeqLen: write_u64(out, static_cast<uint64_t>(params.max_cache_seq_len)); break;
         case ParamField::CacheSinkSize: write_u64(out, static_cast<uint64_t>(params.cache_sink_size)); break;
         case ParamField::CacheNumSlots: write_u64(out, static_cast<uint64_t>(params.cache_num_slots)); break;
+        case ParamField::Padding: write_u64(out, static_cast<uint64_t>(params.padding)); break;
+        case ParamField::NhwcInput: write_u32(out, params.nhwc_input ? 1u : 0u); break;
+        case ParamField::NhwcOutput: write_u32(out, params.nhwc_output ? 1u : 0u); break;
     }
 }
 
@@ -368,6 +384,9 @@ void read_field(std::istream& in, ParamField field, OpParams& params) {
         case ParamField::MaxCacheSeqLen: params.max_cache_seq_len = static_cast<size_t>(read_u64(in)); break;
         case ParamField::CacheSinkSize: params.cache_sink_size = static_cast<size_t>(read_u64(in)); break;
         case ParamField::CacheNumSlots: params.cache_num_slots = static_cast<size_t>(read_u64(in)); break;
+        case ParamField::Padding: params.padding = static_cast<size_t>(read_u64(in)); break;
+        case ParamField::NhwcInput: params.nhwc_input = (read_u32(in) != 0); break;
+        case ParamField::NhwcOutput: params.nhwc_output = (read_u32(in) != 0); break;
     }
 }
 
@@ -0,0 +1,211 @@
+#include "../cactus_graph.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+std::atomic<GraphProfiler*> active_profiler{nullptr};
+
+void chunk_trace_trampoline(size_t start_idx, size_t end_idx, uint64_t begin_ns, uint64_t end_ns) {
+    GraphProfiler* profiler = active_profiler.load(std::memory_order_acquire);
+    if (profiler) profiler->record_chunk(start_idx, end_idx, begin_ns, end_ns);
+}
+
+uint32_t trace_thread_id() {
+    static std::atomic<uint32_t> next_id{1};
+    static thread_local uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+uint64_t trace_epoch_ns() {
+    static const uint64_t epoch = CactusThreading::trace_clock_ns();
+    return epoch;
+}
+
+double trace_us(uint64_t ns) {
+    return ns >= trace_epoch_ns() ? static_cast<double>(ns - trace_epoch_ns()) / 1000.0 : 0.0;
+}
+
+double estimate_flops(const GraphNode& node, const nodes_vector& nodes, const node_index_map_t& node_index_map) {
+    const double out_elems = static_cast<double>(node.output_buffer.total_size);
+    auto input_shape = [&](size_t i) -> const std::vector<size_t>& {
+        return get_input(node, i, nodes, node_index_map).shape;
+    };
+    switch (node.op_type) {
+        case OpType::MATMUL: {
+            const auto& lhs = input_shape(0);
+            return lhs.empty() ? out_elems : 2.0 * out_elems * static_cast<double>(lhs.back());
+        }
+        case OpType::ATTENTION:
+        case OpType::ATTENTION_CACHED:
+        case OpType::ATTENTION_INT8_HYBRID: {
+            if (node.input_ids.size() < 2) return out_elems;
+            const auto& keys = input_shape(1);
+            const double kv_len = keys.size() >= 3 ? static_cast<double>(keys[1]) : 1.0;
+            return 4.0 * out_elems * kv_len;
+        }
+        default:
+            return out_elems;
+    }
+}
+
+void write_json_string(std::ostream& out, const char* value) {
+    out << '"';
+    for (const char* p = value ? value : ""; *p; ++p) {
+        if (*p == '"' || *p == '\\') out << '\\';
+        out << *p;
+    }
+    out << '"';
+}
+
+}
+
+GraphProfiler::~GraphProfiler() {
+    if (active_) end();
+}
+
+bool GraphProfiler::wants_chrome_trace(const std::string& target) {
+    const char* format = std::getenv("CACTUS_PROFILE_FORMAT");
+    if (format && (std::string(format) == "chrome" || std::string(format) == "perfetto")) return true;
+    return target.size() > 5 && target.compare(target.size() - 5, 5, ".json") == 0;
+}
+
+void GraphProfiler::begin(const std::string& path) {
+    path_ = path;
+    node_spans_.clear();
+    chunk_spans_.clear();
+    pool_samples_.clear();
+    current_op_.store(nullptr, std::memory_order_relaxed);
+    trace_epoch_ns();
+    active_ = true;
+    active_profiler.store(this, std::memory_order_release);
+    CactusThreading::chunk_trace_hook().store(&chunk_trace_trampoline, std::memory_order_release);
+}
+
+void GraphProfiler::enter_node(const GraphNode& node, const char* op_name) {
+    current_node_.store(node.id, std::memory_order_relaxed);
+    current_op_.store(op_name, std::memory_order_release);
+}
+
+void GraphProfiler::record_node(const GraphNode& node, const char* op_name, const nodes_vector& nodes,
+                                const node_index_map_t& node_index_map, uint64_t begin_ns, uint64_t end_ns) {
+    current_op_.store(nullptr, std::memory_order_release);
+
+    Span span{};
+    span.name = op_name;
+    span.begin_ns = begin_ns;
+    span.end_ns = end_ns;
+    span.tid = trace_thread_id();
+    span.node_id = node.id;
+    for (size_t i = 0; i < node.input_ids.size(); ++i) {
+        span.bytes_read += get_input(node, i, nodes, node_index_map).byte_size;
+    }
+    span.bytes_written = node.output_buffer.byte_size;
+    span.flops = estimate_flops(node, nodes, node_index_map);
+    span.shape = "[";
+    for (size_t i = 0; i < node.output_buffer.shape.size(); ++i) {
+        if (i > 0) span.shape += ",";
+        span.shape += std::to_string(node.output_buffer.shape[i]);
+    }
+    span.shape += "]";
+    node_spans_.push_back(std::move(span));
+}
+
+void GraphProfiler::record_pool(const BufferPool& pool, size_t fresh_bytes, uint64_t ts_ns) {
+    pool_samples_.push_back({ts_ns, pool.active_bytes(), pool.pool_bytes(), fresh_bytes});
+}
+
+void GraphProfiler::record_chunk(size_t start_idx, size_t end_idx, uint64_t begin_ns, uint64_t end_ns) {
+    Span span{};
+    span.name = current_op_.load(std::memory_order_acquire);
+    span.begin_ns = begin_ns;
+    span.end_ns = end_ns;
+    span.tid = trace_thread_id();
+    span.node_id = current_node_.load(std::memory_order_relaxed);
+    span.start_idx = start_idx;
+    span.end_idx = end_idx;
+    std::lock_guard<std::mutex> lock(chunk_mutex_);
+    chunk_spans_.push_back(std::move(span));
+}
+
+void GraphProfiler::end() {
+    CactusThreading::chunk_trace_hook().store(nullptr, std::memory_order_release);
+    GraphProfiler* expected = this;
+    active_profiler.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+    active_ = false;
+
+    static std::mutex files_mutex;
+    static std::unordered_set<std::string> started_files;
+    std::lock_guard<std::mutex> files_lock(files_mutex);
+
+    const bool fresh = started_files.insert(path_).second;
+    std::ofstream out(path_, fresh ? std::ios::trunc : std::ios::app);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open profile file: " << path_ << std::endl;
+        return;
+    }
+
+    char ts[64];
+    auto write_times = [&](uint64_t begin_ns, uint64_t end_ns) {
+        std::snprintf(ts, sizeof(ts), "\"ts\":%.3f,\"dur\":%.3f", trace_us(begin_ns),
+                      end_ns > begin_ns ? static_cast<double>(end_ns - begin_ns) / 1000.0 : 0.0);
+        out << ts;
+    };
+
+    if (fresh) {
+        out << "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"cactus graph\"}},\n";
+    }
+
+    std::unordered_set<uint32_t> threads;
+    for (const auto& span : node_spans_) {
+        threads.insert(span.tid);
+        const double seconds = static_cast<double>(span.end_ns - span.begin_ns) * 1e-9;
+        out << "{\"name\":";
+        write_json_string(out, span.name);
+        out << ",\"cat\":\"node\",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.tid << ",";
+        write_times(span.begin_ns, span.end_ns);
+        out << ",\"args\":{\"node_id\":" << span.node_id
+            << ",\"shape\":\"" << span.shape << "\""
+            << ",\"bytes_read\":" << span.bytes_read
+            << ",\"bytes_written\":" << span.bytes_written
+            << ",\"flops\":" << static_cast<uint64_t>(span.flops);
+        if (seconds > 0.0) {
+            std::snprintf(ts, sizeof(ts), ",\"gflops\":%.3f,\"gbps\":%.3f", span.flops / seconds * 1e-9,
+                          static_cast<double>(span.bytes_read + span.bytes_written) / seconds * 1e-9);
+            out << ts;
+        }
+        out << "}},\n";
+    }
+
+    for (const auto& span : chunk_spans_) {
+        threads.insert(span.tid);
+        out << "{\"name\":";
+        write_json_string(out, span.name ? span.name : "parallel_for");
+        out << ",\"cat\":\"chunk\",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.tid << ",";
+        write_times(span.begin_ns, span.end_ns);
+        out << ",\"args\":{\"node_id\":" << span.node_id
+            << ",\"start\":" << span.start_idx
+            << ",\"end\":" << span.end_idx << "}},\n";
+    }
+
+    for (const auto& sample : pool_samples_) {
+        std::snprintf(ts, sizeof(ts), "\"ts\":%.3f", trace_us(sample.ts_ns));
+        out << "{\"name\":\"buffer_pool\",\"ph\":\"C\",\"pid\":1," << ts
+            << ",\"args\":{\"active_bytes\":" << sample.active_bytes
+            << ",\"pool_bytes\":" << sample.pool_bytes << "}},\n";
+        if (sample.fresh_bytes > 0) {
+            out << "{\"name\":\"pool_alloc\",\"cat\":\"memory\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1," << ts
+                << ",\"args\":{\"bytes\":" << sample.fresh_bytes << "}},\n";
+        }
+    }
+
+    for (uint32_t tid : threads) {
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"cactus thread " << tid << "\"}},\n";
+    }
+
+    node_spans_.clear();
+    chunk_spans_.clear();
+    pool_samples_.clear();
+}
@@ -4,6 +4,9 @@
 #include <iostream>
 #include <iomanip>
 #include <cstring>
+#include <filesystem>
+#include <limits>
+#include <unistd.h>
 
 using namespace TestUtils;
 
@@ -260,6 +263,445 @@ bool test_padded_rollback_empty_cache() {
     return padded_rollback_matches_exact_append(0, 5, 11);
 }
 
+namespace {
+
+struct RingStream {
+    size_t h = 2, kv = 1, d = 32, window = 12, sink = 2, max_seq = 64;
+    std::vector<__fp16> q, k, v;
+
+    explicit RingStream(size_t tokens) : q(tokens * 2 * 32), k(tokens * 32), v(tokens * 32) {
+        fill_random_fp16(q);
+        fill_random_fp16(k);
+        fill_random_fp16(v);
+    }
+
+    // Appends the given tokens to both caches and returns the attention output of their queries.
+    std::vector<float> step(CactusGraph& g, size_t k_cache, size_t v_cache,
+                            const std::vector<size_t>& kv_tokens, const std::vector<size_t>& q_tokens) const {
+        const size_t s = kv_tokens.size();
+        std::vector<__fp16> qs, ks, vs;
+        for (size_t t : q_tokens) qs.insert(qs.end(), q.begin() + t * h * d, q.begin() + (t + 1) * h * d);
+        for (size_t t : kv_tokens) {
+            ks.insert(ks.end(), k.begin() + t * kv * d, k.begin() + (t + 1) * kv * d);
+            vs.insert(vs.end(), v.begin() + t * kv * d, v.begin() + (t + 1) * kv * d);
+        }
+        if (q_tokens.empty()) qs.assign(s * h * d, static_cast<__fp16>(0.0f));
+        size_t iq = g.input({1, s, h, d}, Precision::FP16);
+        size_t ik = g.input({1, s, kv, d}, Precision::FP16);
+        size_t iv = g.input({1, s, kv, d}, Precision::FP16);
+        g.set_input(iq, qs.data(), Precision::FP16);
+        g.set_input(ik, ks.data(), Precision::FP16);
+        g.set_input(iv, vs.data(), Precision::FP16);
+        g.kv_cache_append(ik, k_cache, window, sink);
+        g.kv_cache_append(iv, v_cache, window, sink);
+        size_t attn = g.attention_cached(iq, ik, iv, k_cache, v_cache, 1.0f / std::sqrt(static_cast<float>(d)),
+                                         std::numeric_limits<size_t>::max(), window);
+        g.execute();
+        const __fp16* out = static_cast<const __fp16*>(g.get_output(attn));
+        std::vector<float> result(out, out + s * h * d);
+        g.soft_reset();
+        return result;
+    }
+
+    // Fresh linear cache holding the same logical rows (sinks, then the newest tail before
+    // `first`), followed by the tokens [first, first + count) as one append.
+    std::vector<float> rebuilt(size_t first, size_t count) const {
+        CactusGraph g;
+        size_t k_cache = g.kv_cache_state(max_seq, kv, d, window, sink);
+        size_t v_cache = g.kv_cache_state(max_seq, kv, d, window, sink);
+        std::vector<size_t> history;
+        for (size_t t = 0; t < sink; ++t) history.push_back(t);
+        for (size_t t = first - (window - sink - count); t < first; ++t) history.push_back(t);
+        step(g, k_cache, v_cache, history, {});
+        std::vector<size_t> tokens;
+        for (size_t t = first; t < first + count; ++t) tokens.push_back(t);
+        return step(g, k_cache, v_cache, tokens, tokens);
+    }
+};
+
+bool outputs_close(const std::vector<float>& a, const std::vector<float>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::abs(a[i] - b[i]) > 2e-2f) {
+            std::cerr << "  output " << i << ": " << a[i] << " != " << b[i] << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool test_sliding_window_ring_decode() {
+    const size_t tokens = 48, prefill = 5;
+    RingStream stream(tokens);
+    CactusGraph g;
+    size_t k_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d, stream.window, stream.sink);
+    size_t v_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d, stream.window, stream.sink);
+    std::vector<size_t> first;
+    for (size_t t = 0; t < prefill; ++t) first.push_back(t);
+    stream.step(g, k_cache, v_cache, first, first);
+
+    bool wrapped = false;
+    for (size_t t = prefill; t < tokens; ++t) {
+        auto out = stream.step(g, k_cache, v_cache, {t}, {t});
+        auto* raw = static_cast<uint8_t*>(g.get_output(k_cache));
+        uint64_t seq = *reinterpret_cast<uint64_t*>(raw);
+        uint64_t ring_head = *reinterpret_cast<uint64_t*>(raw + 48);
+        if (seq != std::min(t + 1, stream.window)) return false;
+        wrapped = wrapped || ring_head != 0;
+        if (t >= stream.window && !outputs_close(out, stream.rebuilt(t, 1))) return false;
+    }
+    return wrapped;
+}
+
+bool test_sliding_window_ring_chunk_after_decode() {
+    const size_t tokens = 40, chunk = 3;
+    RingStream stream(tokens);
+    CactusGraph g;
+    size_t k_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d, stream.window, stream.sink);
+    size_t v_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d, stream.window, stream.sink);
+    size_t t = 0;
+    for (; t + chunk < tokens; ++t) stream.step(g, k_cache, v_cache, {t}, {t});
+    std::vector<size_t> last;
+    for (size_t i = t; i < t + chunk; ++i) last.push_back(i);
+    auto out = stream.step(g, k_cache, v_cache, last, last);
+    return outputs_close(out, stream.rebuilt(t, chunk));
+}
+
+namespace {
+
+// Streams tokens through a low-bit cache graph and scores every step against fp16 attention over
+// the exact history. On uniform random K/V the error is the value quantization noise: about
+// 0.07 relative at 4 bits and 0.38 at 2 bits.
+struct LowbitStream {
+    size_t h = 4, kv = 2, d = 64, max_seq = 512;
+    std::vector<__fp16> q, k, v;
+
+    explicit LowbitStream(size_t tokens) : q(tokens * 4 * 64), k(tokens * 2 * 64), v(tokens * 2 * 64) {
+        fill_random_fp16(q);
+        fill_random_fp16(k);
+        fill_random_fp16(v);
+    }
+
+    // Appends tokens [first, first + count) onto a cache holding [0, first); returns the relative
+    // L2 error of their attention output.
+    float step(CactusGraph& g, size_t k_cache, size_t v_cache, size_t first, size_t count) const {
+        const size_t row = kv * d;
+        size_t iq = g.input({1, count, h, d}, Precision::FP16);
+        size_t ik = g.input({1, count, kv, d}, Precision::FP16);
+        size_t iv = g.input({1, count, kv, d}, Precision::FP16);
+        g.set_input(iq, q.data() + first * h * d, Precision::FP16);
+        g.set_input(ik, k.data() + first * row, Precision::FP16);
+        g.set_input(iv, v.data() + first * row, Precision::FP16);
+        g.kv_cache_append(ik, k_cache);
+        g.kv_cache_append(iv, v_cache);
+        const float scale = 1.0f / std::sqrt(static_cast<float>(d));
+        size_t attn = g.attention_cached(iq, ik, iv, k_cache, v_cache, scale, std::numeric_limits<size_t>::max());
+        g.execute();
+
+        std::vector<__fp16> expected(count * h * d);
+        cactus_attention_f16(q.data() + first * h * d, k.data(), v.data(), expected.data(),
+                             1, count, first + count, h, kv, d, scale, nullptr, first);
+        const __fp16* out = static_cast<const __fp16*>(g.get_output(attn));
+        double err = 0.0, ref = 0.0;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            const double e = static_cast<float>(expected[i]);
+            err += (static_cast<float>(out[i]) - e) * (static_cast<float>(out[i]) - e);
+            ref += e * e;
+        }
+        g.soft_reset();
+        return static_cast<float>(std::sqrt(err / std::max(ref, 1e-12)));
+    }
+};
+
+struct ScopedKvBits {
+    explicit ScopedKvBits(const char* bits) { setenv("CACTUS_KV_CACHE_BITS", bits, 1); }
+    ~ScopedKvBits() { unsetenv("CACTUS_KV_CACHE_BITS"); }
+};
+
+struct LowbitHeader {
+    uint64_t current_seq_len;
+    uint64_t max_seq_len;
+    uint64_t fields[5];
+    uint16_t kv_bits;
+    uint8_t kv_role;
+    uint8_t kv_flags;
+    uint32_t packed_rows;
+};
+
+bool lowbit_matches_fp16(const char* bits, float tolerance) {
+    ScopedKvBits scoped(bits);
+    LowbitStream stream(160);
+    CactusGraph g;
+    size_t k_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d);
+    size_t v_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d);
+
+    // 45 tokens: one block quantized straight from the prefill, 13 rows left in the residual.
+    float worst = stream.step(g, k_cache, v_cache, 0, 45);
+    auto* khdr = static_cast<const LowbitHeader*>(g.get_output(k_cache));
+    auto* vhdr = static_cast<const LowbitHeader*>(g.get_output(v_cache));
+    if (khdr->kv_bits != std::atoi(bits) || khdr->kv_role != 0 || vhdr->kv_role != 1 || khdr->packed_rows != 32) {
+        return false;
+    }
+    for (size_t t = 45; t < 150; ++t) worst = std::max(worst, stream.step(g, k_cache, v_cache, t, 1));
+    worst = std::max(worst, stream.step(g, k_cache, v_cache, 150, 10));
+    khdr = static_cast<const LowbitHeader*>(g.get_output(k_cache));
+    if (khdr->current_seq_len != 160 || khdr->packed_rows != 160 / KV_LOWBIT_BLOCK * KV_LOWBIT_BLOCK) return false;
+    if (worst > tolerance) {
+        std::cerr << "  " << bits << "-bit relative error " << worst << " > " << tolerance << "\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool test_lowbit_kv_cache_4bit() {
+    return lowbit_matches_fp16("4", 0.1f);
+}
+
+bool test_lowbit_kv_cache_2bit() {
+    return lowbit_matches_fp16("2", 0.45f);
+}
+
+bool test_lowbit_kv_cache_truncate_and_grow() {
+    ScopedKvBits scoped("4");
+    LowbitStream stream(400);
+    CactusGraph g;
+    size_t k_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d);
+    size_t v_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d);
+    stream.step(g, k_cache, v_cache, 0, 70);
+
+    // A padded prefill tail cuts current_seq_len back inside an already quantized block.
+    for (size_t cache : {k_cache, v_cache}) *static_cast<uint64_t*>(g.get_output(cache)) = 50;
+    float worst = stream.step(g, k_cache, v_cache, 50, 1);
+    auto* khdr = static_cast<const LowbitHeader*>(g.get_output(k_cache));
+    if (khdr->current_seq_len != 51 || khdr->packed_rows != 32) return false;
+
+    // Growing past the initial 256 rows keeps the residual and every packed block.
+    const size_t initial_bytes = g.get_output_buffer(k_cache).byte_size;
+    for (size_t t = 51; t < 391; t += 17) worst = std::max(worst, stream.step(g, k_cache, v_cache, t, 17));
+    khdr = static_cast<const LowbitHeader*>(g.get_output(k_cache));
+    return khdr->current_seq_len == 391 && khdr->max_seq_len == 512 &&
+           g.get_output_buffer(k_cache).byte_size > initial_bytes && worst < 0.1f;
+}
+
+// Decoding past the ceiling drops whole blocks after the pinned sink block instead of throwing;
+// attention then matches fp16 attention over the sink block plus the newest rows.
+bool test_lowbit_kv_cache_evicts_at_ceiling() {
+    ScopedKvBits scoped("4");
+    LowbitStream stream(300);
+    const size_t max_seq = 128, row = stream.kv * stream.d;
+    CactusGraph g;
+    size_t k_cache = g.kv_cache_state(max_seq, stream.kv, stream.d);
+    size_t v_cache = g.kv_cache_state(max_seq, stream.kv, stream.d);
+    stream.step(g, k_cache, v_cache, 0, max_seq);
+
+    float worst = 0.0f;
+    auto decode = [&](size_t first, size_t count) {
+        size_t iq = g.input({1, count, stream.h, stream.d}, Precision::FP16);
+        size_t ik = g.input({1, count, stream.kv, stream.d}, Precision::FP16);
+        size_t iv = g.input({1, count, stream.kv, stream.d}, Precision::FP16);
+        g.set_input(iq, stream.q.data() + first * stream.h * stream.d, Precision::FP16);
+        g.set_input(ik, stream.k.data() + first * row, Precision::FP16);
+        g.set_input(iv, stream.v.data() + first * row, Precision::FP16);
+        g.kv_cache_append(ik, k_cache);
+        g.kv_cache_append(iv, v_cache);
+        const float scale = 1.0f / std::sqrt(static_cast<float>(stream.d));
+        size_t attn = g.attention_cached(iq, ik, iv, k_cache, v_cache, scale, std::numeric_limits<size_t>::max());
+        g.execute();
+
+        const auto* khdr = static_cast<const LowbitHeader*>(g.get_output(k_cache));
+        const auto* vhdr = static_cast<const LowbitHeader*>(g.get_output(v_cache));
+        const size_t len = khdr->current_seq_len, end = first + count;
+        if (len > max_seq || vhdr->current_seq_len != len || khdr->packed_rows != len / KV_LOWBIT_BLOCK * KV_LOWBIT_BLOCK) {
+            worst = 1.0f;
+            g.soft_reset();
+            return;
+        }
+        std::vector<__fp16> k_kept(len * row), v_kept(len * row), expected(count * stream.h * stream.d);
+        std::copy(stream.k.begin(), stream.k.begin() + KV_LOWBIT_BLOCK * row, k_kept.begin());
+        std::copy(stream.v.begin(), stream.v.begin() + KV_LOWBIT_BLOCK * row, v_kept.begin());
+        std::copy(stream.k.begin() + (end - len + KV_LOWBIT_BLOCK) * row, stream.k.begin() + end * row,
+                  k_kept.begin() + KV_LOWBIT_BLOCK * row);
+        std::copy(stream.v.begin() + (end - len + KV_LOWBIT_BLOCK) * row, stream.v.begin() + end * row,
+                  v_kept.begin() + KV_LOWBIT_BLOCK * row);
+        cactus_attention_f16(stream.q.data() + first * stream.h * stream.d, k_kept.data(), v_kept.data(),
+                             expected.data(), 1, count, len, stream.h, stream.kv, stream.d, scale, nullptr, len - count);
+        const __fp16* out = static_cast<const __fp16*>(g.get_output(attn));
+        double err = 0.0, ref = 0.0;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            const double e = static_cast<float>(expected[i]);
+            err += (static_cast<float>(out[i]) - e) * (static_cast<float>(out[i]) - e);
+            ref += e * e;
+        }
+        worst = std::max(worst, static_cast<float>(std::sqrt(err / std::max(ref, 1e-12))));
+        g.soft_reset();
+    };
+    for (size_t t = max_seq; t < 260; ++t) decode(t, 1);
+    decode(260, 40);
+    if (worst >= 0.1f) std::cerr << "  evicting low-bit cache relative error " << worst << "\n";
+    return worst < 0.1f;
+}
+
+namespace {
+
+struct ScopedEnv {
+    ScopedEnv(const char* name, const char* value) : name(name) { setenv(name, value, 1); }
+    ~ScopedEnv() { unsetenv(name); }
+    const char* name;
+};
+
+// Per-test spill directory, removed with everything the cache paged out into it.
+struct ScopedSpillDir {
+    explicit ScopedSpillDir(const std::string& tag)
+        : path(std::filesystem::temp_directory_path() / ("cactus_kv_spill_" + tag + "_" + std::to_string(getpid()))) {
+        std::filesystem::create_directories(path);
+        setenv("CACTUS_KV_SPILL_DIR", path.c_str(), 1);
+    }
+    ~ScopedSpillDir() {
+        unsetenv("CACTUS_KV_SPILL_DIR");
+        std::filesystem::remove_all(path);
+    }
+    std::filesystem::path path;
+};
+
+// Prefill, single-token decode and a chunk through one cache pair; returns the per-step errors.
+std::vector<float> spill_run(const LowbitStream& stream, size_t tokens, LowbitHeader* k_header = nullptr) {
+    CactusGraph g;
+    size_t k_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d);
+    size_t v_cache = g.kv_cache_state(stream.max_seq, stream.kv, stream.d);
+    std::vector<float> errors{stream.step(g, k_cache, v_cache, 0, 100)};
+    for (size_t t = 100; t + 20 < tokens; ++t) errors.push_back(stream.step(g, k_cache, v_cache, t, 1));
+    errors.push_back(stream.step(g, k_cache, v_cache, tokens - 20, 20));
+    if (k_header) *k_header = *static_cast<const LowbitHeader*>(g.get_output(k_cache));
+    return errors;
+}
+
+} // namespace
+
+// With every cold block still read, a spilled cache must give the resident INT8 result exactly,
+// including rows that were paged out and faulted back in.
+bool test_spill_kv_cache_matches_resident() {
+    LowbitStream stream(400);
+    const auto resident = spill_run(stream, 400);
+    ScopedSpillDir dir("resident");
+    ScopedEnv hot("CACTUS_KV_HOT_TOKENS", "64");
+    ScopedEnv top_k("CACTUS_KV_SPILL_TOPK", "64");
+    LowbitHeader header{};
+    const auto spilled = spill_run(stream, 400, &header);
+    // 400 rows, 64 hot: rows [64, 320) are cold, block 0 is the pinned sink.
+    return spilled == resident && header.kv_flags == 1 && header.max_seq_len == stream.max_seq &&
+           header.packed_rows == 320 && header.current_seq_len == 400;
+}
+
+// Decode reads only the top-k cold blocks: one block holds keys aligned with every query, the rest
+// is noise, so the filter has to find it for the output to match full attention.
+bool test_spill_kv_cache_block_filter() {
+    LowbitStream stream(512);
+    const size_t q_row = stream.h * stream.d, k_row = stream.kv * stream.d;
+    for (size_t t = 0; t < 512; ++t) {
+        for (size_t i = 0; i < q_row; ++i) stream.q[t * q_row + i] = stream.q[i % stream.d];
+        for (size_t i = 0; i < k_row; ++i) {
+            const float needle = 3.0f * static_cast<float>(stream.q[i % stream.d]);
+            stream.k[t * k_row + i] = (t >= 192 && t < 256) ? static_cast<__fp16>(needle)
+                                                            : static_cast<__fp16>(0.05f * static_cast<float>(stream.k[t * k_row + i]));
+        }
+    }
+    ScopedSpillDir dir("block_filter");
+    ScopedEnv hot("CACTUS_KV_HOT_TOKENS", "64");
+    ScopedEnv top_k("CACTUS_KV_SPILL_TOPK", "2");
+    const auto errors = spill_run(stream, 512);
+    const float worst = *std::max_element(errors.begin(), errors.end());
+    if (worst > 0.05f) std::cerr << "  block filter relative error " << worst << "\n";
+    return worst <= 0.05f;
+}
+
+// The fused QKV entry attends in cache-only mode, which must still go through the block filter on a
+// spilled cache. Identity projections at RoPE position 0 make q = k = v = x; one needle block holds
+// keys aligned with the decode token, and a cold noise block is rewritten behind its summary to
+// keys that would swamp full attention, so only a filtered read matches the needle answer.
+bool test_spill_kv_cache_fused_qkv_decode() {
+    const size_t h = 2, kv = 1, d = 64, max_seq = 1024, prefill = 512;
+    const float scale = 1.0f / std::sqrt(static_cast<float>(d));
+    std::vector<__fp16> needle(d), k((prefill + 1) * d), v((prefill + 1) * d);
+    fill_random_fp16(needle);
+    fill_random_fp16(k);
+    fill_random_fp16(v);
+    for (size_t t = 0; t < prefill; ++t) {
+        for (size_t i = 0; i < d; ++i) {
+            k[t * d + i] = (t >= 192 && t < 256) ? static_cast<__fp16>(3.0f * static_cast<float>(needle[i]))
+                                                 : static_cast<__fp16>(0.05f * static_cast<float>(k[t * d + i]));
+        }
+    }
+    std::copy(needle.begin(), needle.end(), k.begin() + prefill * d);
+    std::copy(needle.begin(), needle.end(), v.begin() + prefill * d);
+
+    ScopedSpillDir dir("fused_qkv");
+    ScopedEnv hot("CACTUS_KV_HOT_TOKENS", "64");
+    ScopedEnv top_k("CACTUS_KV_SPILL_TOPK", "2");
+    CactusGraph g;
+    size_t k_cache = g.kv_cache_state(max_seq, kv, d);
+    size_t v_cache = g.kv_cache_state(max_seq, kv, d);
+    {
+        std::vector<__fp16> q(prefill * h * d);
+        fill_random_fp16(q);
+        size_t iq = g.input({1, prefill, h, d}, Precision::FP16);
+        size_t ik = g.input({1, prefill, kv, d}, Precision::FP16);
+        size_t iv = g.input({1, prefill, kv, d}, Precision::FP16);
+        g.set_input(iq, q.data(), Precision::FP16);
+        g.set_input(ik, k.data(), Precision::FP16);
+        g.set_input(iv, v.data(), Precision::FP16);
+        g.kv_cache_append(ik, k_cache);
+        g.kv_cache_append(iv, v_cache);
+        g.attention_cached(iq, ik, iv, k_cache, v_cache, scale, std::numeric_limits<size_t>::max());
+        g.execute();
+        g.soft_reset();
+    }
+
+    // Rows [320, 384) are cold; their summaries still describe the noise written there.
+    auto* k_bytes = static_cast<char*>(g.get_output(k_cache)) + sizeof(LowbitHeader);
+    auto* k_scales = reinterpret_cast<float*>(k_bytes + max_seq * kv * d);
+    const size_t groups = d / KV_QUANT_GROUP_SIZE;
+    for (size_t t = 320; t < 384; ++t) {
+        for (size_t i = 0; i < d; ++i) k_bytes[t * d + i] = static_cast<float>(needle[i]) > 0.0f ? 127 : -127;
+        for (size_t gi = 0; gi < groups; ++gi) k_scales[t * groups + gi] = 1.0f;
+    }
+
+    std::vector<__fp16> wq(h * d * d, static_cast<__fp16>(0.0f)), wkv(d * d, static_cast<__fp16>(0.0f));
+    for (size_t i = 0; i < d; ++i) {
+        wkv[i * d + i] = static_cast<__fp16>(1.0f);
+        for (size_t head = 0; head < h; ++head) wq[(head * d + i) * d + i] = static_cast<__fp16>(1.0f);
+    }
+    size_t ix = g.input({1, d}, Precision::FP16);
+    size_t iwq = g.input({h * d, d}, Precision::FP16);
+    size_t iwk = g.input({d, d}, Precision::FP16);
+    size_t iwv = g.input({d, d}, Precision::FP16);
+    g.set_input(ix, needle.data(), Precision::FP16);
+    g.set_input(iwq, wq.data(), Precision::FP16);
+    g.set_input(iwk, wkv.data(), Precision::FP16);
+    g.set_input(iwv, wkv.data(), Precision::FP16);
+    size_t q = g.qkv_rope_cache_append(ix, iwq, iwk, iwv, k_cache, v_cache, d, 10000.0f, 0);
+    size_t attn = g.attention_cached(q, q, q, k_cache, v_cache, scale, std::numeric_limits<size_t>::max() - 1);
+    g.execute();
+
+    std::vector<__fp16> query(h * d), expected(h * d);
+    for (size_t head = 0; head < h; ++head) std::copy(needle.begin(), needle.end(), query.begin() + head * d);
+    cactus_attention_f16(query.data(), k.data(), v.data(), expected.data(),
+                         1, 1, prefill + 1, h, kv, d, scale, nullptr, prefill);
+    const __fp16* out = static_cast<const __fp16*>(g.get_output(attn));
+    double err = 0.0, ref = 0.0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const double e = static_cast<float>(expected[i]);
+        err += (static_cast<float>(out[i]) - e) * (static_cast<float>(out[i]) - e);
+        ref += e * e;
+    }
+    const float rel = static_cast<float>(std::sqrt(err / std::max(ref, 1e-12)));
+    if (rel > 0.05f) std::cerr << "  fused spill decode relative error " << rel << "\n";
+    return rel <= 0.05f;
+}
+
 bool test_attention_cached_basic() {
     const size_t b = 1, s = 1, h = 2, kv = 2, d = 16;
     const size_t max_seq = 64;
@@ -369,6 +811,73 @@ bool test_attention_cached_multistep() {
     return true;
 }
 
+bool test_qkv_rope_cache_append_matches_unfused() {
+    // Prefill then two decode steps through the fused entry and through matmul -> rope ->
+    // kv_cache_append. Rotated Q and the cache bytes must match exactly; attention differs only
+    // by the new tokens being read back from INT8 instead of FP16.
+    const size_t hidden = 64, h = 4, kv = 2, d = 16, max_seq = 64;
+    const float theta = 10000.0f, scale = 1.0f / std::sqrt(static_cast<float>(d));
+    std::vector<__fp16> wq(h * d * hidden), wk(kv * d * hidden), wv(kv * d * hidden);
+    for (auto* w : {&wq, &wk, &wv}) {
+        fill_random_fp16(*w);
+        for (auto& e : *w) e = static_cast<__fp16>(0.2f * static_cast<float>(e));
+    }
+
+    CactusGraph ref, fused;
+    size_t ref_k = ref.kv_cache_state(max_seq, kv, d), ref_v = ref.kv_cache_state(max_seq, kv, d);
+    size_t fused_k = fused.kv_cache_state(max_seq, kv, d), fused_v = fused.kv_cache_state(max_seq, kv, d);
+
+    size_t position = 0;
+    for (size_t tokens : {5, 1, 1}) {
+        std::vector<__fp16> x(tokens * hidden);
+        fill_random_fp16(x);
+        auto weights = [&](CactusGraph& g, std::vector<size_t>& ids) {
+            size_t ix = g.input({tokens, hidden}, Precision::FP16);
+            g.set_input(ix, x.data(), Precision::FP16);
+            ids = {ix};
+            for (auto* w : {&wq, &wk, &wv}) {
+                size_t iw = g.input({w->size() / hidden, hidden}, Precision::FP16);
+                g.set_input(iw, w->data(), Precision::FP16);
+                ids.push_back(iw);
+            }
+        };
+
+        std::vector<size_t> r, f;
+        weights(ref, r);
+        size_t q = ref.rope(ref.reshape(ref.matmul(r[0], r[1], true), {1, tokens, h, d}), theta, position);
+        size_t k = ref.rope(ref.reshape(ref.matmul(r[0], r[2], true), {1, tokens, kv, d}), theta, position);
+        size_t v = ref.reshape(ref.matmul(r[0], r[3], true), {1, tokens, kv, d});
+        ref.kv_cache_append(k, ref_k);
+        ref.kv_cache_append(v, ref_v);
+        size_t ref_attn = ref.attention_cached(q, k, v, ref_k, ref_v, scale, std::numeric_limits<size_t>::max());
+        ref.execute();
+
+        weights(fused, f);
+        size_t fq = fused.qkv_rope_cache_append(f[0], f[1], f[2], f[3], fused_k, fused_v, d, theta, position);
+        size_t fused_attn = fused.attention_cached(fq, fq, fq, fused_k, fused_v, scale,
+                                                   std::numeric_limits<size_t>::max() - 1);
+        fused.execute();
+
+        const __fp16* rq = static_cast<const __fp16*>(ref.get_output(q));
+        const __fp16* fqo = static_cast<const __fp16*>(fused.get_output(fq));
+        const __fp16* ra = static_cast<const __fp16*>(ref.get_output(ref_attn));
+        const __fp16* fa = static_cast<const __fp16*>(fused.get_output(fused_attn));
+        for (size_t i = 0; i < tokens * h * d; ++i) {
+            if (rq[i] != fqo[i]) return false;
+            if (std::abs(static_cast<float>(ra[i]) - static_cast<float>(fa[i])) > 2e-2f) return false;
+        }
+        for (auto [a, b] : {std::pair{ref_k, fused_k}, std::pair{ref_v, fused_v}}) {
+            const size_t bytes = ref.get_output_buffer(a).byte_size;
+            if (bytes != fused.get_output_buffer(b).byte_size ||
+                std::memcmp(ref.get_output(a), fused.get_output(b), bytes) != 0) return false;
+        }
+        position += tokens;
+        ref.soft_reset();
+        fused.soft_reset();
+    }
+    return true;
+}
+
 bool test_kv_cache_invalidate() {
     CactusGraph g;
 
@@ -896,6 +1405,129 @@ bool run_benchmarks() {
         });
     }
 
+    {
+        // One decode attention layer up to the output projection: separate Q/K/V matmuls, RoPE and
+        // appends against the fused qkv_rope_cache_append entry, both over 512 cached rows.
+        const size_t hidden = 1024, h = 8, kv = 4, d = 128, max_seq = 1024, prefill = 512;
+        const float theta = 10000.0f, scale = 1.0f / std::sqrt(static_cast<float>(d));
+        std::vector<__fp16> x(hidden), wq(h * d * hidden), wk(kv * d * hidden), wv(kv * d * hidden);
+        std::vector<__fp16> prefill_kv(prefill * kv * d);
+        for (auto* buf : {&x, &wq, &wk, &wv, &prefill_kv}) fill_random_fp16(*buf);
+
+        for (bool use_fused : {false, true}) {
+            CactusGraph g;
+            size_t k_cache = g.kv_cache_state(max_seq, kv, d);
+            size_t v_cache = g.kv_cache_state(max_seq, kv, d);
+            size_t pk = g.input({prefill * kv * d}, Precision::FP16);
+            g.set_input(pk, prefill_kv.data(), Precision::FP16);
+            g.kv_cache_append(pk, k_cache);
+            g.kv_cache_append(pk, v_cache);
+            g.execute();
+
+            bench(use_fused ? "qkv_rope fused 1tok@512" : "qkv_rope split 1tok@512", []{}, [&]{
+                for (size_t cache : {k_cache, v_cache}) *static_cast<uint64_t*>(g.get_output(cache)) = prefill;
+                g.soft_reset_keep_pool();
+                size_t ix = g.input({1, hidden}, Precision::FP16);
+                size_t iq = g.input({h * d, hidden}, Precision::FP16);
+                size_t ik = g.input({kv * d, hidden}, Precision::FP16);
+                size_t iv = g.input({kv * d, hidden}, Precision::FP16);
+                g.set_input(ix, x.data(), Precision::FP16);
+                g.set_input(iq, wq.data(), Precision::FP16);
+                g.set_input(ik, wk.data(), Precision::FP16);
+                g.set_input(iv, wv.data(), Precision::FP16);
+                if (use_fused) {
+                    size_t q = g.qkv_rope_cache_append(ix, iq, ik, iv, k_cache, v_cache, d, theta, prefill);
+                    g.attention_cached(q, q, q, k_cache, v_cache, scale, std::numeric_limits<size_t>::max() - 1);
+                } else {
+                    size_t q = g.rope(g.reshape(g.matmul(ix, iq, true), {1, 1, h, d}), theta, prefill);
+                    size_t k = g.rope(g.reshape(g.matmul(ix, ik, true), {1, 1, kv, d}), theta, prefill);
+                    size_t v = g.reshape(g.matmul(ix, iv, true), {1, 1, kv, d});
+                    g.kv_cache_append(k, k_cache);
+                    g.kv_cache_append(v, v_cache);
+                    g.attention_cached(q, k, v, k_cache, v_cache, scale, prefill);
+                }
+                g.execute();
+            });
+        }
+    }
+
+    {
+        // Same decode step on 4-bit keys and values; the cache has to be allocated next to its
+        // attention consumer, so the prefill runs attention too.
+        ScopedKvBits scoped("4");
+        const size_t b = 1, s = 1, h = 16, kv = 8, d = 128, max_seq = 1024, prefill = 512;
+        float scale = 1.0f / std::sqrt(static_cast<float>(d));
+
+        CactusGraph g;
+        size_t k_cache = g.kv_cache_state(max_seq, kv, d);
+        size_t v_cache = g.kv_cache_state(max_seq, kv, d);
+
+        std::vector<__fp16> prefill_q(prefill * h * d), prefill_kv(prefill * kv * d);
+        fill_random_fp16(prefill_q);
+        fill_random_fp16(prefill_kv);
+        size_t pq = g.input({b, prefill, h, d}, Precision::FP16);
+        size_t pk = g.input({b, prefill, kv, d}, Precision::FP16);
+        size_t pv = g.input({b, prefill, kv, d}, Precision::FP16);
+        g.set_input(pq, prefill_q.data(), Precision::FP16);
+        g.set_input(pk, prefill_kv.data(), Precision::FP16);
+        g.set_input(pv, prefill_kv.data(), Precision::FP16);
+        g.kv_cache_append(pk, k_cache);
+        g.kv_cache_append(pv, v_cache);
+        g.attention_cached(pq, pk, pv, k_cache, v_cache, scale, 0);
+        g.execute();
+
+        std::vector<__fp16> q(b*s*h*d), k_new(b*s*kv*d), v_new(b*s*kv*d);
+        fill_random_fp16(q);
+        fill_random_fp16(k_new);
+        fill_random_fp16(v_new);
+
+        // Reset the length each run so the timed step always sees 512 cached rows.
+        bench("attention_cached q4 1tok@512", []{}, [&]{
+            for (size_t cache : {k_cache, v_cache}) *static_cast<uint64_t*>(g.get_output(cache)) = prefill;
+            g.soft_reset_keep_pool();
+            size_t iq = g.input({b, s, h, d}, Precision::FP16);
+            size_t ik = g.input({b, s, kv, d}, Precision::FP16);
+            size_t iv = g.input({b, s, kv, d}, Precision::FP16);
+            g.set_input(iq, q.data(), Precision::FP16);
+            g.set_input(ik, k_new.data(), Precision::FP16);
+            g.set_input(iv, v_new.data(), Precision::FP16);
+            g.kv_cache_append(ik, k_cache);
+            g.kv_cache_append(iv, v_cache);
+            g.attention_cached(iq, ik, iv, k_cache, v_cache, scale, prefill);
+            g.execute();
+        });
+    }
+
+    {
+        // Past a full sliding window each append overwrites one ring row, so per-token
+        // cost should read the same one window and four windows beyond the fill.
+        const size_t kv = 8, d = 128, window = 512, sink = 4, max_seq = 4096;
+
+        CactusGraph g;
+        size_t k_cache = g.kv_cache_state(max_seq, kv, d, window, sink);
+
+        std::vector<__fp16> fill_data(window * kv * d);
+        fill_random_fp16(fill_data);
+        size_t fill_input = g.input({fill_data.size()}, Precision::FP16);
+        g.set_input(fill_input, fill_data.data(), Precision::FP16);
+        g.kv_cache_append(fill_input, k_cache, window, sink);
+        g.execute();
+
+        std::vector<__fp16> append_data(kv * d);
+        fill_random_fp16(append_data);
+        auto append_one = [&]{
+            g.soft_reset_keep_pool();
+            size_t inp = g.input({append_data.size()}, Precision::FP16);
+            g.set_input(inp, append_data.data(), Precision::FP16);
+            g.kv_cache_append(inp, k_cache, window, sink);
+            g.execute();
+        };
+
+        bench("kv_append window512 @1x", []{}, append_one);
+        for (size_t i = 0; i < 3 * window; ++i) append_one();
+        bench("kv_append window512 @4x", []{}, append_one);
+    }
+
     return true;
 }
 
@@ -1093,6 +1725,190 @@ bool test_batched_kv_append() {
     return true;
 }
 
+bool test_kv_cache_slot_fork() {
+    // A prefix decoded into slot 0 and forked into slot 2 must attend exactly like slot 0 on the
+    // next token; slot 1 stays empty.
+    const size_t h = 2, kv = 2, d = 16, max_seq = 32, prefix = 5;
+    const float scale = 1.0f / std::sqrt(static_cast<float>(d));
+
+    CactusGraph g;
+    size_t kc = g.kv_cache_state(max_seq, kv, d, 0, 4, 3);
+    size_t vc = g.kv_cache_state(max_seq, kv, d, 0, 4, 3);
+    size_t iq = g.input({1, 1, h, d}, Precision::FP16);
+    size_t ik = g.input({1, 1, kv, d}, Precision::FP16);
+    size_t iv = g.input({1, 1, kv, d}, Precision::FP16);
+    g.kv_cache_append(ik, kc);
+    g.kv_cache_append(iv, vc);
+    size_t attn = g.attention_cached(iq, ik, iv, kc, vc, scale, std::numeric_limits<size_t>::max());
+
+    std::vector<__fp16> q(h * d), k(kv * d), v(kv * d);
+    auto step = [&](size_t slot, bool refill) {
+        if (refill) { fill_random_fp16(q); fill_random_fp16(k); fill_random_fp16(v); }
+        g.set_cache_slot(slot);
+        g.set_input(iq, q.data(), Precision::FP16);
+        g.set_input(ik, k.data(), Precision::FP16);
+        g.set_input(iv, v.data(), Precision::FP16);
+        g.execute();
+        const __fp16* r = static_cast<const __fp16*>(g.get_output(attn));
+        return std::vector<float>(r, r + h * d);
+    };
+    for (size_t t = 0; t < prefix; t++) step(0, true);
+
+    g.copy_cache_slot(kc, 0, 2);
+    g.copy_cache_slot(vc, 0, 2);
+    std::vector<float> out0 = step(0, true);
+    std::vector<float> out2 = step(2, false);
+    for (size_t i = 0; i < h * d; i++) {
+        if (out0[i] != out2[i]) return false;
+    }
+
+    auto seq_len = [&](size_t node, size_t slot) {
+        const auto& buf = g.get_output_buffer(node);
+        const size_t stride = buf.byte_size / 3;
+        return *reinterpret_cast<const uint64_t*>(static_cast<const uint8_t*>(g.get_output(node)) + slot * stride);
+    };
+    if (seq_len(kc, 0) != prefix + 1 || seq_len(kc, 2) != prefix + 1 || seq_len(vc, 1) != 0) return false;
+
+    try {
+        g.copy_cache_slot(iq, 0, 1);
+        return false;
+    } catch (const std::runtime_error&) {
+    }
+    try {
+        g.copy_cache_slot(kc, 0, 3);
+        return false;
+    } catch (const std::runtime_error&) {
+    }
+    return true;
+}
+
+bool test_kv_cache_shared_prefix() {
+    // A prompt shared into two tail slots is stored once; each tail must attend exactly like a
+    // contiguous cache holding the same rows, across a tail-to-tail fork and a reslot back.
+    const size_t h = 2, kv = 2, d = 16, max_seq = 32, prefix = 5, tail = 8;
+    const float scale = 1.0f / std::sqrt(static_cast<float>(d));
+
+    CactusGraph shared, plain;
+    auto build = [&](CactusGraph& g) {
+        size_t kc = g.kv_cache_state(max_seq, kv, d);
+        size_t vc = g.kv_cache_state(max_seq, kv, d);
+        size_t iq = g.input({1, 1, h, d}, Precision::FP16);
+        size_t ik = g.input({1, 1, kv, d}, Precision::FP16);
+        size_t iv = g.input({1, 1, kv, d}, Precision::FP16);
+        g.kv_cache_append(ik, kc);
+        g.kv_cache_append(iv, vc);
+        size_t attn = g.attention_cached(iq, ik, iv, kc, vc, scale, std::numeric_limits<size_t>::max());
+        return std::vector<size_t>{kc, vc, iq, ik, iv, attn};
+    };
+    const auto a = build(shared);
+    const auto b = build(plain);
+
+    std::vector<__fp16> q(h * d), k(kv * d), v(kv * d);
+    auto step = [&](CactusGraph& g, const std::vector<size_t>& ids, size_t slot) {
+        g.set_cache_slot(slot);
+        g.set_input(ids[2], q.data(), Precision::FP16);
+        g.set_input(ids[3], k.data(), Precision::FP16);
+        g.set_input(ids[4], v.data(), Precision::FP16);
+        g.execute();
+        const __fp16* r = static_cast<const __fp16*>(g.get_output(ids[5]));
+        return std::vector<float>(r, r + h * d);
+    };
+    auto both = [&](size_t slot) {
+        fill_random_fp16(q); fill_random_fp16(k); fill_random_fp16(v);
+        return step(shared, a, slot) == step(plain, b, 0);
+    };
+    auto fork = [&](size_t src, size_t dst) {
+        shared.copy_cache_slot(a[0], src, dst);
+        shared.copy_cache_slot(a[1], src, dst);
+    };
+    for (size_t t = 0; t < prefix; t++) {
+        if (!both(0)) return false;
+    }
+
+    const size_t single_bytes = shared.get_output_buffer(a[0]).byte_size;
+    shared.share_cache_prefix(a[0], 2, 0, tail);
+    shared.share_cache_prefix(a[1], 2, 0, tail);
+    if (shared.get_node_cache_num_slots(a[0]) != 3) return false;
+    if (shared.get_output_buffer(a[0]).byte_size >= single_bytes) return false;
+
+    fork(2, 0);
+    fork(2, 1);
+    for (size_t t = 0; t < 3; t++) {
+        if (!both(0)) return false;
+    }
+    fill_random_fp16(q); fill_random_fp16(k); fill_random_fp16(v);
+    step(shared, a, 1);
+
+    fork(0, 1);
+    if (!both(1)) return false;
+
+    shared.reslot_cache(a[0], 1, 1, 0);
+    shared.reslot_cache(a[1], 1, 1, 0);
+    if (*static_cast<const uint64_t*>(shared.get_output(a[0])) != prefix + 4) return false;
+    return both(0) && both(0);
+}
+
+bool test_kv_cache_reslot() {
+    // A one-slot prefix laid out over three slots (landing in slot 2) and back must attend exactly
+    // like the same cache left alone; the slots it did not land in start empty.
+    const size_t h = 2, kv = 2, d = 16, max_seq = 32, prefix = 5;
+    const float scale = 1.0f / std::sqrt(static_cast<float>(d));
+
+    CactusGraph moved, still;
+    auto build = [&](CactusGraph& g) {
+        size_t kc = g.kv_cache_state(max_seq, kv, d);
+        size_t vc = g.kv_cache_state(max_seq, kv, d);
+        size_t iq = g.input({1, 1, h, d}, Precision::FP16);
+        size_t ik = g.input({1, 1, kv, d}, Precision::FP16);
+        size_t iv = g.input({1, 1, kv, d}, Precision::FP16);
+        g.kv_cache_append(ik, kc);
+        g.kv_cache_append(iv, vc);
+        size_t attn = g.attention_cached(iq, ik, iv, kc, vc, scale, std::numeric_limits<size_t>::max());
+        return std::vector<size_t>{kc, vc, iq, ik, iv, attn};
+    };
+    const auto a = build(moved);
+    const auto b = build(still);
+
+    std::vector<__fp16> q(h * d), k(kv * d), v(kv * d);
+    auto step = [&](CactusGraph& g, const std::vector<size_t>& ids, size_t slot) {
+        g.set_cache_slot(slot);
+        g.set_input(ids[2], q.data(), Precision::FP16);
+        g.set_input(ids[3], k.data(), Precision::FP16);
+        g.set_input(ids[4], v.data(), Precision::FP16);
+        g.execute();
+        const __fp16* r = static_cast<const __fp16*>(g.get_output(ids[5]));
+        return std::vector<float>(r, r + h * d);
+    };
+    auto both = [&](size_t slot) {
+        fill_random_fp16(q); fill_random_fp16(k); fill_random_fp16(v);
+        return step(moved, a, slot) == step(still, b, 0);
+    };
+    for (size_t t = 0; t < prefix; t++) {
+        if (!both(0)) return false;
+    }
+
+    moved.reslot_cache(a[0], 3, 0, 2);
+    moved.reslot_cache(a[1], 3, 0, 2);
+    if (moved.get_node_cache_num_slots(a[0]) != 3 || !both(2)) return false;
+    const auto& buf = moved.get_output_buffer(a[0]);
+    const auto* base = static_cast<const uint8_t*>(moved.get_output(a[0]));
+    for (size_t slot = 0; slot < 3; slot++) {
+        const uint64_t len = *reinterpret_cast<const uint64_t*>(base + slot * (buf.byte_size / 3));
+        if (len != (slot == 2 ? prefix + 1 : 0)) return false;
+    }
+
+    moved.reslot_cache(a[0], 1, 2, 0);
+    moved.reslot_cache(a[1], 1, 2, 0);
+    if (*static_cast<const uint64_t*>(moved.get_output(a[0])) != prefix + 1 || !both(0)) return false;
+
+    try {
+        moved.reslot_cache(a[0], 2, 1, 0);
+        return false;
+    } catch (const std::runtime_error&) {
+    }
+    return moved.cache_slots_supported(a[0]) && !moved.cache_slots_supported(a[2]);
+}
+
 int main() {
     TestUtils::TestRunner runner("Cache Tests");
 
@@ -1106,11 +1922,24 @@ int main() {
     runner.run_test("Padded Rollback Eviction Overshoot", test_padded_rollback_eviction_overshoot());
     runner.run_test("Padded Rollback Only Pads Evict", test_padded_rollback_only_pads_evict());
     runner.run_test("Padded Rollback Empty Cache", test_padded_rollback_empty_cache());
+    runner.run_test("Sliding Window Ring Decode", test_sliding_window_ring_decode());
+    runner.run_test("Sliding Window Ring Chunk After Decode", test_sliding_window_ring_chunk_after_decode());
+    runner.run_test("Low-Bit KV Cache 4-bit", test_lowbit_kv_cache_4bit());
+    runner.run_test("Low-Bit KV Cache 2-bit", test_lowbit_kv_cache_2bit());
+    runner.run_test("Low-Bit KV Cache Truncate And Grow", test_lowbit_kv_cache_truncate_and_grow());
+    runner.run_test("Low-Bit KV Cache Evicts At Ceiling", test_lowbit_kv_cache_evicts_at_ceiling());
+    runner.run_test("Spilled KV Cache Matches Resident", test_spill_kv_cache_matches_resident());
+    runner.run_test("Spilled KV Cache Block Filter", test_spill_kv_cache_block_filter());
+    runner.run_test("Spilled KV Cache Fused QKV Decode", test_spill_kv_cache_fused_qkv_decode());
     runner.run_test("Attention Cached Basic", test_attention_cached_basic());
     runner.run_test("KV Cache Slots Independent", test_kv_cache_slots_independent());
     runner.run_test("Batched Per-Slot Attention", test_batched_per_slot_attention());
     runner.run_test("Batched KV Append", test_batched_kv_append());
+    runner.run_test("KV Cache Slot Fork", test_kv_cache_slot_fork());
+    runner.run_test("KV Cache Shared Prefix", test_kv_cache_shared_prefix());
+    runner.run_test("KV Cache Reslot", test_kv_cache_reslot());
     runner.run_test("Attention Cached Multistep", test_attention_cached_multistep());
+    runner.run_test("QKV RoPE Cache Append Matches Unfused", test_qkv_rope_cache_append_matches_unfused());
     runner.run_test("KV Cache Invalidate", test_kv_cache_invalidate());
     runner.run_test("Conv Cache State Init", test_conv_cache_state_init());
     runner.run_test("Conv Cache Append Basic", test_conv_cache_append_basic());
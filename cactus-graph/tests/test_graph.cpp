@@ -3,6 +3,9 @@
 #include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
 
 using namespace TestUtils;
 
@@ -82,6 +85,46 @@ bool test_graph_reset() {
             std::abs(static_cast<float>(output2[1]) - 25.0f) < 1e-2f);
 }
 
+bool test_chrome_trace_profile() {
+    const std::string path = "/tmp/cactus_graph_profile_test.json";
+    std::remove(path.c_str());
+
+    CactusGraph graph;
+    size_t a = graph.input({64, 256}, Precision::FP16);
+    size_t b = graph.input({256, 256}, Precision::FP16);
+    size_t product = graph.matmul(a, b, false);
+    size_t result = graph.scalar_add(product, 1.0f);
+    (void)result;
+
+    std::vector<__fp16> data_a(64 * 256, static_cast<__fp16>(0.01f));
+    std::vector<__fp16> data_b(256 * 256, static_cast<__fp16>(0.01f));
+    graph.set_input(a, data_a.data(), Precision::FP16);
+    graph.set_input(b, data_b.data(), Precision::FP16);
+    graph.execute(path);
+    graph.execute(path);
+
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string trace = buffer.str();
+    std::remove(path.c_str());
+
+    auto count = [&](const std::string& needle) {
+        size_t n = 0;
+        for (size_t pos = trace.find(needle); pos != std::string::npos; pos = trace.find(needle, pos + 1)) ++n;
+        return n;
+    };
+
+    const size_t matmul_flops = 2ull * 64 * 256 * 256;
+    return trace.rfind("[\n", 0) == 0 &&
+           count("[\n") == 1 &&
+           count("\"cat\":\"node\"") == 4 &&
+           count("\"name\":\"MATMUL\"") >= 2 &&
+           count("\"flops\":" + std::to_string(matmul_flops)) == 2 &&
+           count("\"cat\":\"chunk\"") >= 2 &&
+           count("\"name\":\"buffer_pool\",\"ph\":\"C\"") == 4;
+}
+
 bool run_benchmarks() {
     std::vector<__fp16> data(4, static_cast<__fp16>(1.0f));
 
@@ -131,6 +174,7 @@ int main() {
     runner.run_test("Complex Graph Structure", test_complex_graph_structure());
     runner.run_test("Multiple Outputs", test_multiple_outputs());
     runner.run_test("Graph Reset", test_graph_reset());
+    runner.run_test("Chrome Trace Profile", test_chrome_trace_profile());
     runner.print_benchmarks_header();
     runner.run_bench("benchmarks", run_benchmarks());
     runner.print_summary();
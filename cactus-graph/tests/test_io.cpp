@@ -453,6 +453,85 @@ bool test_save_load_preserves_kv_cache_num_slots() {
     }
 }
 
+bool test_conv2d_save_load_roundtrip() {
+    try {
+        const std::string filename = "test_conv2d_save_load.cg";
+
+        CactusGraph original;
+        size_t x = original.input({1, 4, 7, 6}, Precision::FP16);
+        size_t w = original.input({6, 2, 3, 3}, Precision::FP16);
+        size_t b = original.input({6}, Precision::FP16);
+        size_t y = original.conv2d(x, w, b, 2, 1, 1, 2, false, true);
+
+        const auto& shape = original.get_output_buffer(y).shape;
+        if (shape != std::vector<size_t>{1, 4, 3, 6}) {
+            std::cout << "[conv2d_save_load] unexpected output shape" << std::endl;
+            return false;
+        }
+
+        std::vector<__fp16> data_x(4 * 7 * 6), data_w(6 * 2 * 9), data_b(6);
+        for (size_t i = 0; i < data_x.size(); ++i) data_x[i] = static_cast<__fp16>(static_cast<float>(i % 11) * 0.1f - 0.5f);
+        for (size_t i = 0; i < data_w.size(); ++i) data_w[i] = static_cast<__fp16>(static_cast<float>(i % 7) * 0.05f - 0.15f);
+        for (size_t i = 0; i < data_b.size(); ++i) data_b[i] = static_cast<__fp16>(0.25f * static_cast<float>(i));
+
+        original.set_input(x, data_x.data(), Precision::FP16);
+        original.set_input(w, data_w.data(), Precision::FP16);
+        original.set_input(b, data_b.data(), Precision::FP16);
+        original.execute();
+        const __fp16* out = static_cast<__fp16*>(original.get_output(y));
+        std::vector<float> expected(out, out + 4 * 3 * 6);
+
+        // Direct reference for the NHWC output: out[oh][ow][oc] with 2 groups of 2 input channels.
+        for (size_t oh = 0; oh < 4; ++oh) {
+            for (size_t ow = 0; ow < 3; ++ow) {
+                for (size_t oc = 0; oc < 6; ++oc) {
+                    const size_t g = oc / 3;
+                    float acc = static_cast<float>(data_b[oc]);
+                    for (size_t ic = 0; ic < 2; ++ic) {
+                        for (size_t kh = 0; kh < 3; ++kh) {
+                            for (size_t kw = 0; kw < 3; ++kw) {
+                                const long ih = static_cast<long>(oh * 2 + kh) - 1;
+                                const long iw = static_cast<long>(ow * 2 + kw) - 1;
+                                if (ih < 0 || iw < 0 || ih >= 7 || iw >= 6) continue;
+                                acc += static_cast<float>(data_x[((g * 2 + ic) * 7 + ih) * 6 + iw]) *
+                                       static_cast<float>(data_w[((oc * 2 + ic) * 3 + kh) * 3 + kw]);
+                            }
+                        }
+                    }
+                    const float got = expected[(oh * 3 + ow) * 6 + oc];
+                    if (std::abs(got - acc) > 0.02f + 0.01f * std::abs(acc)) {
+                        std::cout << "[conv2d_save_load] reference mismatch: got=" << got
+                                  << " expected=" << acc << std::endl;
+                        return false;
+                    }
+                }
+            }
+        }
+
+        original.save(filename);
+        CactusGraph loaded = CactusGraph::load(filename);
+        GraphFile::SerializedGraph sg = GraphFile::load_graph(filename);
+        std::remove(filename.c_str());
+
+        loaded.set_input(runtime_id_from_serialized_index(sg.graph_inputs[0]), data_x.data(), Precision::FP16);
+        loaded.set_input(runtime_id_from_serialized_index(sg.graph_inputs[1]), data_w.data(), Precision::FP16);
+        loaded.set_input(runtime_id_from_serialized_index(sg.graph_inputs[2]), data_b.data(), Precision::FP16);
+        loaded.execute();
+        const __fp16* loaded_out = static_cast<__fp16*>(
+            loaded.get_output(runtime_id_from_serialized_index(sg.graph_outputs[0])));
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (std::abs(static_cast<float>(loaded_out[i]) - expected[i]) > 1e-3f) {
+                std::cout << "[conv2d_save_load] roundtrip mismatch at index " << i << std::endl;
+                return false;
+            }
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "[conv2d_save_load] exception: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 bool run_benchmarks() {
     const int ITERS = 100;
     const std::string temp_file = "bench_io_50nodes.cg";
@@ -517,6 +596,7 @@ int main() {
                     test_save_load_preserves_recurrent_cache_persistence());
     runner.run_test("Save/Load Preserves KV Cache Num Slots",
                     test_save_load_preserves_kv_cache_num_slots());
+    runner.run_test("Conv2d Save/Load Roundtrip", test_conv2d_save_load_roundtrip());
     runner.print_benchmarks_header();
     runner.run_bench("benchmarks", run_benchmarks());
     runner.print_summary();
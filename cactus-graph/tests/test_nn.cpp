@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <random>
 
 using namespace TestUtils;
@@ -193,6 +194,77 @@ bool test_matmul_cq() {
     return true;
 }
 
+bool test_rms_norm_matmul_cq() {
+    // The fused node must agree with the rms_norm -> matmul pair it replaces.
+    const size_t M = 2, K = 256, N = 8, gs = 128, ng = K / gs;
+    const uint32_t bits = 4;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+    std::vector<__fp16> A(M * K), norm_w(K);
+    for (auto& v : A) v = static_cast<__fp16>(3.f * dist(gen));
+    for (auto& v : norm_w) v = static_cast<__fp16>(1.f + 0.5f * dist(gen));
+
+    std::vector<uint8_t> packed(N * ng * cactus_quant_packed_group_bytes(bits, gs));
+    for (auto& v : packed) v = static_cast<uint8_t>(gen() & 0xFF);
+    std::vector<__fp16> codebook(1u << bits), input_scale(K), input_scale_recip(K), norms(N * ng);
+    std::vector<int8_t> left_signs(gs), right_signs(gs);
+    std::vector<uint32_t> permutation(gs);
+    for (auto& v : codebook) v = static_cast<__fp16>(dist(gen));
+    for (size_t i = 0; i < K; i++) {
+        float s = 0.5f + std::abs(dist(gen));
+        input_scale[i] = static_cast<__fp16>(s);
+        input_scale_recip[i] = static_cast<__fp16>(1.f / s);
+    }
+    for (auto& v : norms) v = static_cast<__fp16>(dist(gen) * 0.1f);
+    for (auto& v : left_signs) v = (gen() & 1) ? 1 : -1;
+    for (auto& v : right_signs) v = (gen() & 1) ? 1 : -1;
+    for (uint32_t i = 0; i < gs; i++) permutation[i] = i;
+
+    auto path = std::filesystem::temp_directory_path() / "cactus_graph_rms_norm_matmul.weights";
+    write_test_cq_weights(path, bits, K, N, gs, packed, codebook, input_scale,
+                          input_scale_recip, norms, left_signs, right_signs, permutation);
+
+    CactusGraph g;
+    size_t ia = g.input({M, K}, Precision::FP16);
+    size_t in = g.input({K}, Precision::FP16);
+    size_t iw = g.mmap_weights(path.string());
+    size_t unfused = g.matmul(g.rms_norm(ia, in, 1e-6f), iw, true);
+    size_t fused = g.rms_norm_matmul(ia, in, iw, 1e-6f);
+    g.set_input(ia, A.data(), Precision::FP16);
+    g.set_input(in, norm_w.data(), Precision::FP16);
+    g.execute();
+
+    const __fp16* expected = static_cast<__fp16*>(g.get_output(unfused));
+    const __fp16* actual = static_cast<__fp16*>(g.get_output(fused));
+    bool ok = g.get_output_buffer(fused).shape == std::vector<size_t>{M, N};
+    for (size_t i = 0; ok && i < M * N; i++) {
+        ok = std::isfinite(static_cast<float>(actual[i])) &&
+             std::abs(static_cast<float>(actual[i]) - static_cast<float>(expected[i])) <= 1e-3f;
+    }
+    const std::vector<__fp16> reference(actual, actual + M * N);
+    g.hard_reset();
+
+    // A 3D input resized at runtime must keep its leading dims and take N from the weight rows.
+    CactusGraph dyn;
+    size_t da = dyn.input({1, 1, K}, Precision::FP16);
+    size_t dn = dyn.input({K}, Precision::FP16);
+    size_t dw = dyn.mmap_weights(path.string());
+    size_t dfused = dyn.rms_norm_matmul(da, dn, dw, 1e-6f);
+    dyn.set_runtime_input_shape(da, {M / 2, 2, K});
+    dyn.set_input(da, A.data(), Precision::FP16);
+    dyn.set_input(dn, norm_w.data(), Precision::FP16);
+    dyn.execute();
+    ok = ok && dyn.get_output_buffer(dfused).shape == std::vector<size_t>{M / 2, 2, N};
+    const __fp16* dyn_out = static_cast<__fp16*>(dyn.get_output(dfused));
+    for (size_t i = 0; ok && i < M * N; i++) {
+        ok = std::abs(static_cast<float>(dyn_out[i]) - static_cast<float>(reference[i])) <= 1e-3f;
+    }
+    dyn.hard_reset();
+    std::filesystem::remove(path);
+    return ok;
+}
+
 bool test_attention_int8_hybrid() {
     const size_t b = 1, s = 1, h = 2, kv = 2, d = 16;
     const size_t cache_len = 4;
@@ -586,6 +658,214 @@ bool test_moe_activations() {
     return true;
 }
 
+struct MoeFixture {
+    size_t tokens, hidden, inter, experts, top_k;
+    std::vector<__fp16> x, routing;
+    std::vector<float> topk;
+    std::vector<std::vector<__fp16>> w1, w3, w2;
+
+    MoeFixture(size_t T, size_t H, size_t I, size_t E, size_t K, bool skewed, uint32_t seed)
+        : tokens(T), hidden(H), inter(I), experts(E), top_k(K), x(T * H), routing(T * E), topk(T * K) {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> dis(-0.5f, 0.5f);
+        for (auto& v : x) v = static_cast<__fp16>(dis(gen));
+        w1.resize(E); w3.resize(E); w2.resize(E);
+        for (size_t e = 0; e < E; ++e) {
+            w1[e].resize(I * H); w3[e].resize(I * H); w2[e].resize(H * I);
+            for (auto& v : w1[e]) v = static_cast<__fp16>(dis(gen) * 0.2f);
+            for (auto& v : w3[e]) v = static_cast<__fp16>(dis(gen) * 0.2f);
+            for (auto& v : w2[e]) v = static_cast<__fp16>(dis(gen) * 0.2f);
+        }
+        for (size_t t = 0; t < T; ++t) {
+            std::vector<size_t> order(E);
+            std::iota(order.begin(), order.end(), 0);
+            std::shuffle(order.begin(), order.end(), gen);
+            if (skewed) std::swap(*std::find(order.begin(), order.end(), 0), order[0]);
+            for (size_t k = 0; k < K; ++k) {
+                topk[t * K + k] = static_cast<float>(order[k]);
+                routing[t * E + order[k]] = static_cast<__fp16>(0.1f + 0.8f * (dis(gen) + 0.5f));
+            }
+        }
+    }
+
+    std::vector<float> reference() const {
+        std::vector<float> out(tokens * hidden, 0.0f);
+        std::vector<float> h(inter);
+        for (size_t t = 0; t < tokens; ++t) {
+            float denom = 1e-6f;
+            for (size_t k = 0; k < top_k; ++k) denom += static_cast<float>(routing[t * experts + static_cast<size_t>(topk[t * top_k + k])]);
+            for (size_t k = 0; k < top_k; ++k) {
+                const size_t e = static_cast<size_t>(topk[t * top_k + k]);
+                for (size_t i = 0; i < inter; ++i) {
+                    float g = 0.0f, u = 0.0f;
+                    for (size_t d = 0; d < hidden; ++d) {
+                        g += static_cast<float>(w1[e][i * hidden + d]) * static_cast<float>(x[t * hidden + d]);
+                        u += static_cast<float>(w3[e][i * hidden + d]) * static_cast<float>(x[t * hidden + d]);
+                    }
+                    h[i] = g / (1.0f + std::exp(-g)) * u;
+                }
+                const float p = static_cast<float>(routing[t * experts + e]) / denom;
+                for (size_t d = 0; d < hidden; ++d) {
+                    float acc = 0.0f;
+                    for (size_t i = 0; i < inter; ++i) acc += static_cast<float>(w2[e][d * inter + i]) * h[i];
+                    out[t * hidden + d] += p * acc;
+                }
+            }
+        }
+        return out;
+    }
+
+    size_t build(CactusGraph& g) const {
+        size_t hidden_id = g.input({tokens, hidden}, Precision::FP16);
+        size_t routing_id = g.input({tokens, experts}, Precision::FP16);
+        size_t topk_id = g.input({tokens, top_k}, Precision::FP32);
+        std::vector<size_t> w1_ids, w3_ids, w2_ids;
+        for (size_t e = 0; e < experts; ++e) {
+            w1_ids.push_back(g.input({inter, hidden}, Precision::FP16));
+            w3_ids.push_back(g.input({inter, hidden}, Precision::FP16));
+            w2_ids.push_back(g.input({hidden, inter}, Precision::FP16));
+        }
+        size_t out = g.moe_layer(hidden_id, routing_id, topk_id, w1_ids, w3_ids, w2_ids,
+                                 experts, top_k, true, 1e-6f, 1.0f, Activation::SILU);
+        g.set_input(hidden_id, x.data(), Precision::FP16);
+        g.set_input(routing_id, routing.data(), Precision::FP16);
+        g.set_input(topk_id, topk.data(), Precision::FP32);
+        for (size_t e = 0; e < experts; ++e) {
+            g.set_input(w1_ids[e], w1[e].data(), Precision::FP16);
+            g.set_input(w3_ids[e], w3[e].data(), Precision::FP16);
+            g.set_input(w2_ids[e], w2[e].data(), Precision::FP16);
+        }
+        return out;
+    }
+};
+
+// Decode (one token over many experts) takes the expert-parallel path; the skewed prefill routes every
+// token through expert 0, which then exceeds its fair share and runs with intra-GEMM threading instead.
+bool test_moe_expert_parallel() {
+    const MoeFixture cases[] = {
+        MoeFixture(1, 64, 96, 16, 6, false, 1),
+        MoeFixture(37, 64, 96, 16, 4, true, 2),
+        MoeFixture(5, 40, 24, 8, 8, false, 3),
+    };
+    for (const auto& fx : cases) {
+        CactusGraph g;
+        size_t out = fx.build(g);
+        g.execute();
+        const auto* result = static_cast<const __fp16*>(g.get_output(out));
+        const auto expected = fx.reference();
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (std::abs(static_cast<float>(result[i]) - expected[i]) > 2e-3f + 2e-2f * std::abs(expected[i])) return false;
+        }
+
+        std::vector<__fp16> first(result, result + expected.size());
+        g.execute();
+        result = static_cast<const __fp16*>(g.get_output(out));
+        if (std::memcmp(first.data(), result, first.size() * sizeof(__fp16)) != 0) return false;
+    }
+    return true;
+}
+
+// Two chained MoE layers over mmapped expert files. Routing cycles through four contexts, each with
+// its own layer-1 pair and layer-2 pair, so after one cycle the co-activation table should turn
+// layer-2 misses into prefetch hits while the budget keeps releasing the other experts.
+bool test_moe_expert_residency() {
+    const size_t H = 64, I = 32, E = 8, K = 2, STEPS = 24;
+    const MoeFixture fx(1, H, I, E, K, false, 5);
+    const auto dir = std::filesystem::temp_directory_path() / "cactus_moe_residency";
+    std::filesystem::create_directories(dir);
+
+    std::vector<std::string> files;
+    {
+        CactusGraph src;
+        for (size_t layer = 0; layer < 2; ++layer) {
+            for (size_t e = 0; e < E; ++e) {
+                const std::vector<__fp16>* mats[] = {&fx.w1[e], &fx.w3[e], &fx.w2[e]};
+                for (size_t m = 0; m < 3; ++m) {
+                    size_t id = src.input(m == 2 ? std::vector<size_t>{H, I} : std::vector<size_t>{I, H}, Precision::FP16);
+                    src.set_input(id, mats[m]->data(), Precision::FP16);
+                    files.push_back((dir / ("l" + std::to_string(layer) + "_w" + std::to_string(m) + "_" + std::to_string(e) + ".bin")).string());
+                    GraphFile::save_node(src, id, files.back());
+                }
+            }
+        }
+    }
+
+    auto build = [&](CactusGraph& g, size_t ids[6]) {
+        ids[0] = g.input({1, H}, Precision::FP16);
+        ids[1] = g.input({1, E}, Precision::FP16);
+        ids[2] = g.input({1, K}, Precision::FP32);
+        ids[3] = g.input({1, K}, Precision::FP32);
+        for (size_t layer = 0; layer < 2; ++layer) {
+            std::vector<size_t> w1, w3, w2;
+            for (size_t e = 0; e < E; ++e) {
+                const size_t base = (layer * E + e) * 3;
+                w1.push_back(g.mmap_weights(files[base]));
+                w3.push_back(g.mmap_weights(files[base + 1]));
+                w2.push_back(g.mmap_weights(files[base + 2]));
+            }
+            ids[4 + layer] = g.moe_layer(layer == 0 ? ids[0] : ids[4], ids[1], ids[2 + layer], w1, w3, w2,
+                                         E, K, true, 1e-6f, 1.0f, Activation::SILU);
+        }
+        g.set_input(ids[0], fx.x.data(), Precision::FP16);
+        std::vector<__fp16> routing(E, static_cast<__fp16>(0.5f));
+        g.set_input(ids[1], routing.data(), Precision::FP16);
+    };
+    auto route = [&](CactusGraph& g, const size_t ids[6], size_t step) {
+        const size_t c = step % 4;
+        const float first[K] = {static_cast<float>(2 * c), static_cast<float>(2 * c + 1)};
+        const float second[K] = {static_cast<float>((2 * c + 3) % E), static_cast<float>((2 * c + 6) % E)};
+        g.set_input(ids[2], first, Precision::FP32);
+        g.set_input(ids[3], second, Precision::FP32);
+    };
+
+    const size_t expert_bytes = 3 * I * H * sizeof(__fp16);
+    const size_t budget = 6 * expert_bytes;
+    CactusGraph plain, tracked;
+    size_t plain_ids[6], tracked_ids[6];
+    build(plain, plain_ids);
+    build(tracked, tracked_ids);
+    ExpertResidencyConfig config;
+    config.budget_bytes = budget;
+    config.rebalance_interval = 4;
+    config.lock_hot = true;
+    tracked.configure_expert_residency(config);
+
+    bool ok = true;
+    for (size_t step = 0; step < STEPS && ok; ++step) {
+        route(plain, plain_ids, step);
+        route(tracked, tracked_ids, step);
+        plain.execute();
+        tracked.execute();
+        ok = std::memcmp(plain.get_output(plain_ids[5]), tracked.get_output(tracked_ids[5]), H * sizeof(__fp16)) == 0;
+
+        size_t resident = 0;
+        for (const auto& s : tracked.expert_residency_stats()) resident += s.resident;
+        ok = ok && resident * expert_bytes <= budget + 2 * K * expert_bytes;
+    }
+
+    const auto stats = tracked.expert_residency_stats();
+    ok = ok && stats.size() == 2;
+    if (ok) {
+        size_t pinned = 0;
+        for (const auto& s : stats) {
+            ok = ok && s.num_experts == E && s.lookups == STEPS * K && s.hits <= s.lookups;
+            pinned += s.pinned;
+        }
+        ok = ok && stats[1].prefetch_hits >= (STEPS - 4) * K / 2 && stats[1].hit_rate() > 0.5 && pinned > 0;
+    }
+
+    tracked.release_all_weight_pages();
+    const auto released = tracked.expert_residency_stats();
+    ok = ok && released.size() == 2 && released[0].lookups == STEPS * K &&
+         released[0].resident == 0 && released[0].pinned == 0;
+    tracked.hard_reset();
+    ok = ok && tracked.expert_residency_stats().empty();
+    plain.hard_reset();
+    tracked.hard_reset();
+    std::filesystem::remove_all(dir);
+    return ok;
+}
+
 bool run_benchmarks() {
     auto bench = [](const char* label, auto setup, auto run) {
         setup();
@@ -702,6 +982,12 @@ bool run_benchmarks() {
         g.set_input(ii, in.data(), Precision::FP16);
         bench("softmax 1024x1024", []{}, [&]{ g.execute(); });
     }
+    {
+        MoeFixture decode(1, 512, 256, 32, 8, false, 4);
+        CactusGraph g;
+        decode.build(g);
+        bench("moe decode 32x top-8", []{}, [&]{ g.execute(); });
+    }
     return true;
 }
 
@@ -710,6 +996,7 @@ int main() {
 
     runner.run_test("Matrix Multiplication", test_matrix_multiplication());
     runner.run_test("MatMul CQ", test_matmul_cq());
+    runner.run_test("RMSNorm MatMul CQ", test_rms_norm_matmul_cq());
     runner.run_test("Transpose", test_transpose());
     runner.run_test("RMS Norm", test_rms_norm());
     runner.run_test("Softmax", test_softmax());
@@ -722,6 +1009,8 @@ int main() {
     runner.run_test("STFT Complex", test_stft());
     runner.run_test("LayerNorm", test_layernorm());
     runner.run_test("MoE Activations", test_moe_activations());
+    runner.run_test("MoE Expert Parallel", test_moe_expert_parallel());
+    runner.run_test("MoE Expert Residency", test_moe_expert_residency());
     runner.print_benchmarks_header();
     runner.run_bench("benchmarks", run_benchmarks());
     runner.print_summary();
@@ -0,0 +1,637 @@
+#include "../cactus_kernels.h"
+#include "../src/threading.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+    std::string filter;
+    std::string json_path;
+    std::string label;
+    double min_time_ms = 200.0;
+    size_t max_iters = 1000;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string shape;
+    double ms = 0.0;
+    double gbps = 0.0;
+    double gflops = 0.0;
+    double pct_peak = 0.0;
+    double rtf = 0.0;
+};
+
+struct BenchCase {
+    std::string name;
+    std::string shape;
+    double bytes;
+    double flops;
+    std::function<void()> run;
+    double audio_seconds = 0.0;  // > 0 reports a real-time factor (compute time / audio duration)
+};
+
+template<typename T>
+std::vector<T> random_vector(size_t n, float lo = -1.0f, float hi = 1.0f, uint32_t seed = 7) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(lo, hi);
+    std::vector<T> v(n);
+    for (auto& x : v) x = static_cast<T>(dist(gen));
+    return v;
+}
+
+std::vector<uint8_t> random_bytes(size_t n, uint32_t seed = 11) {
+    std::mt19937 gen(seed);
+    std::vector<uint8_t> v(n);
+    for (auto& x : v) x = static_cast<uint8_t>(gen());
+    return v;
+}
+
+double median_ms(const std::function<void()>& fn, const BenchOptions& opts) {
+    fn();
+    fn();
+    std::vector<double> samples;
+    double total = 0.0;
+    while (samples.size() < opts.max_iters && (samples.size() < 5 || total < opts.min_time_ms)) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        samples.push_back(ms);
+        total += ms;
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// STREAM-style copy and triad over buffers far larger than the last-level cache, spread over the
+// kernel thread pool. The best of the two is used as the attainable bandwidth roof.
+double measure_peak_bandwidth_gbps(const BenchOptions& opts) {
+    const size_t n = size_t(32) << 20;
+    std::vector<float> a(n, 1.0f), b(n, 2.0f), c(n, 0.5f);
+    const CactusThreading::ParallelConfig config{1, n / 64};
+
+    auto copy = [&] {
+        CactusThreading::parallel_for(n, config, [&](size_t start, size_t end) {
+            std::memcpy(a.data() + start, b.data() + start, (end - start) * sizeof(float));
+        });
+    };
+    auto triad = [&] {
+        CactusThreading::parallel_for(n, config, [&](size_t start, size_t end) {
+            const float32x4_t s = vdupq_n_f32(3.0f);
+            size_t i = start;
+            for (; i + 4 <= end; i += 4) {
+                vst1q_f32(a.data() + i, vfmaq_f32(vld1q_f32(b.data() + i), vld1q_f32(c.data() + i), s));
+            }
+            for (; i < end; ++i) a[i] = b[i] + 3.0f * c[i];
+        });
+    };
+
+    BenchOptions peak_opts = opts;
+    peak_opts.max_iters = 20;
+    const double copy_gbps = 2.0 * n * sizeof(float) / (median_ms(copy, peak_opts) * 1e6);
+    const double triad_gbps = 3.0 * n * sizeof(float) / (median_ms(triad, peak_opts) * 1e6);
+    std::cout << "STREAM copy " << std::fixed << std::setprecision(2) << copy_gbps
+              << " GB/s, triad " << triad_gbps << " GB/s\n";
+    return std::max(copy_gbps, triad_gbps);
+}
+
+struct QuantWeights {
+    uint32_t bits, K, N, group_size, num_groups;
+    std::vector<__fp16> codebook, input_scale, input_scale_recip, norms;
+    std::vector<int8_t> left_signs, right_signs;
+    std::vector<uint32_t> permutation;
+    std::vector<uint8_t> packed;
+
+    QuantWeights(uint32_t b, uint32_t k, uint32_t n, uint32_t gs = 128)
+        : bits(b), K(k), N(n), group_size(gs), num_groups(k / gs) {
+        codebook = random_vector<__fp16>(1u << bits);
+        input_scale = random_vector<__fp16>(K, 0.5f, 1.5f);
+        input_scale_recip.resize(K);
+        for (uint32_t i = 0; i < K; ++i) input_scale_recip[i] = static_cast<__fp16>(1.0f / static_cast<float>(input_scale[i]));
+        norms = random_vector<__fp16>(size_t(N) * num_groups, -0.1f, 0.1f);
+        left_signs.resize(group_size);
+        right_signs.resize(group_size);
+        for (uint32_t i = 0; i < group_size; ++i) {
+            left_signs[i] = (i * 7 + 3) % 5 < 2 ? -1 : 1;
+            right_signs[i] = (i * 11 + 1) % 3 == 0 ? -1 : 1;
+        }
+        permutation.resize(group_size);
+        for (uint32_t i = 0; i < group_size; ++i) permutation[i] = i;
+        packed = random_bytes(size_t(N) * num_groups * cactus_quant_packed_group_bytes(bits, group_size));
+    }
+
+    CactusQuantMatrix matrix(uint32_t flags = 0) const {
+        CactusQuantMatrix m{};
+        m.bits = bits;
+        m.K = K;
+        m.N = N;
+        m.group_size = group_size;
+        m.num_groups = num_groups;
+        m.flags = flags;
+        m.codebook = codebook.data();
+        m.input_scale = input_scale.data();
+        m.input_scale_recip = input_scale_recip.data();
+        m.norms = norms.data();
+        m.packed_indices = packed.data();
+        m.left_signs = left_signs.data();
+        m.right_signs = right_signs.data();
+        m.permutation = permutation.data();
+        return m;
+    }
+
+    double weight_bytes() const {
+        return static_cast<double>(packed.size() + norms.size() * sizeof(__fp16));
+    }
+};
+
+std::string shape_str(std::initializer_list<size_t> dims) {
+    std::string s;
+    for (size_t d : dims) {
+        if (!s.empty()) s += "x";
+        s += std::to_string(d);
+    }
+    return s;
+}
+
+using GemvFn = void (*)(const CactusQuantMatrix*, const __fp16*, __fp16*);
+using GemmFn = void (*)(const CactusQuantMatrix*, const __fp16*, uint32_t, __fp16*);
+using GemvInterleavedFn = void (*)(const CactusQuantMatrix*, const uint8_t*, const __fp16*, const __fp16*, __fp16*);
+
+void add_quant_cases(std::vector<BenchCase>& cases) {
+    const GemvFn gemv[] = {cactus_quant_1bit_gemv, cactus_quant_2bit_gemv, cactus_quant_3bit_gemv, cactus_quant_4bit_gemv};
+    const GemmFn gemm[] = {cactus_quant_1bit_gemm, cactus_quant_2bit_gemm, cactus_quant_3bit_gemm, cactus_quant_4bit_gemm};
+    const GemvInterleavedFn gemv_il[] = {cactus_quant_1bit_gemv_interleaved, cactus_quant_2bit_gemv_interleaved,
+                                         cactus_quant_3bit_gemv_interleaved, cactus_quant_4bit_gemv_interleaved};
+
+    struct Projection { const char* label; uint32_t K, N; };
+    const Projection projections[] = {
+        {"qkv_1b", 1024, 3072},
+        {"ffn_up_1b", 2048, 8192},
+        {"ffn_down_1b", 8192, 2048},
+    };
+
+    for (uint32_t bits = 1; bits <= 4; ++bits) {
+        for (const auto& p : projections) {
+            auto w = std::make_shared<QuantWeights>(bits, p.K, p.N);
+            auto x = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(size_t(256) * p.K));
+            auto y = std::make_shared<std::vector<__fp16>>(size_t(256) * p.N);
+            const double io_bytes = (p.K + p.N) * sizeof(__fp16);
+            const std::string tag = "cq" + std::to_string(bits) + "_";
+
+            cases.push_back({tag + "gemv/" + p.label, shape_str({1, p.K, p.N}),
+                             w->weight_bytes() + io_bytes, 2.0 * p.K * p.N,
+                             [w, x, y, fn = gemv[bits - 1]] {
+                                 CactusQuantMatrix m = w->matrix();
+                                 fn(&m, x->data(), y->data());
+                             }});
+
+            cases.push_back({tag + "gemv_il/" + p.label, shape_str({1, p.K, p.N}),
+                             w->weight_bytes() + io_bytes, 2.0 * p.K * p.N,
+                             [w, x, y, fn = gemv_il[bits - 1]] {
+                                 CactusQuantMatrix m = w->matrix(CACTUS_QUANT_FLAG_INTERLEAVED_4ROW);
+                                 fn(&m, w->packed.data(), w->norms.data(), x->data(), y->data());
+                             }});
+
+            if (bits == 4) {
+                // Decode pre-norm + projection: the unfused pair writes and re-reads the normed row.
+                auto gamma = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(p.K, 0.5f, 1.5f));
+                auto normed = std::make_shared<std::vector<__fp16>>(p.K);
+                cases.push_back({tag + "rmsnorm_gemv_il/" + p.label, shape_str({1, p.K, p.N}),
+                                 w->weight_bytes() + io_bytes + p.K * sizeof(__fp16), 2.0 * p.K * p.N,
+                                 [w, x, y, gamma] {
+                                     CactusQuantMatrix m = w->matrix(CACTUS_QUANT_FLAG_INTERLEAVED_4ROW);
+                                     cactus_quant_rms_norm_matmul(&m, x->data(), gamma->data(), 1e-6f, 1, y->data());
+                                 }});
+                cases.push_back({tag + "rmsnorm_gemv_il_unfused/" + p.label, shape_str({1, p.K, p.N}),
+                                 w->weight_bytes() + io_bytes + 3 * p.K * sizeof(__fp16), 2.0 * p.K * p.N,
+                                 [w, x, y, gamma, normed, K = p.K] {
+                                     CactusQuantMatrix m = w->matrix(CACTUS_QUANT_FLAG_INTERLEAVED_4ROW);
+                                     cactus_rms_norm_f16(x->data(), gamma->data(), normed->data(), 1, K, 1e-6f);
+                                     cactus_quant_matmul(&m, normed->data(), 1, y->data());
+                                 }});
+            }
+
+            if (&p == &projections[0]) {
+                // Small-batch sweep: M = 2..8 takes the decode-once small-M kernel, M > 8 the
+                // expanded-INT8 GEMM; the per-row GEMV loop is the baseline both must beat.
+                for (uint32_t M = 1; M <= 16; ++M) {
+                    cases.push_back({tag + "small_m/" + p.label, shape_str({M, p.K, p.N}),
+                                     w->weight_bytes() + M * io_bytes, 2.0 * M * p.K * p.N,
+                                     [w, x, y, M] {
+                                         CactusQuantMatrix m = w->matrix();
+                                         cactus_quant_matmul(&m, x->data(), M, y->data());
+                                     }});
+                    cases.push_back({tag + "gemv_rows/" + p.label, shape_str({M, p.K, p.N}),
+                                     M * w->weight_bytes() + M * io_bytes, 2.0 * M * p.K * p.N,
+                                     [w, x, y, M, K = p.K, N = p.N, fn = gemv[bits - 1]] {
+                                         CactusQuantMatrix m = w->matrix();
+                                         for (uint32_t r = 0; r < M; ++r)
+                                             fn(&m, x->data() + size_t(r) * K, y->data() + size_t(r) * N);
+                                     }});
+                }
+            }
+
+            for (uint32_t M : {16u, 256u}) {
+                cases.push_back({tag + "gemm/" + p.label, shape_str({M, p.K, p.N}),
+                                 w->weight_bytes() + M * io_bytes, 2.0 * M * p.K * p.N,
+                                 [w, x, y, M, fn = gemm[bits - 1]] {
+                                     CactusQuantMatrix m = w->matrix();
+                                     fn(&m, x->data(), M, y->data());
+                                 }});
+            }
+        }
+    }
+}
+
+void add_dense_cases(std::vector<BenchCase>& cases) {
+    struct MatmulShape { const char* label; size_t M, K, N; };
+    const MatmulShape shapes[] = {
+        {"decode_qkv", 1, 2048, 2048},
+        {"prefill_ffn", 128, 2048, 8192},
+        {"vit_mlp", 256, 768, 3072},
+        {"whisper_enc", 1500, 384, 1536},
+    };
+    for (const auto& s : shapes) {
+        auto a = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(s.M * s.K));
+        auto b = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(s.N * s.K));
+        auto c = std::make_shared<std::vector<__fp16>>(s.M * s.N);
+        cases.push_back({std::string("matmul_f16/") + s.label, shape_str({s.M, s.K, s.N}),
+                         (s.M * s.K + s.N * s.K + s.M * s.N) * 2.0, 2.0 * s.M * s.K * s.N,
+                         [a, b, c, s] { cactus_matmul_f16(a->data(), b->data(), c->data(), s.M, s.K, s.N); }});
+    }
+
+    struct AttentionShape { const char* label; size_t seq, kv, hq, hkv, dim; };
+    const AttentionShape attention[] = {
+        {"decode_2k", 1, 2048, 16, 8, 128},
+        {"decode_8k", 1, 8192, 16, 8, 128},
+        {"prefill_512", 512, 512, 16, 8, 64},
+    };
+    for (const auto& s : attention) {
+        auto q = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(s.seq * s.hq * s.dim));
+        auto k = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(s.kv * s.hkv * s.dim));
+        auto v = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(s.kv * s.hkv * s.dim));
+        auto o = std::make_shared<std::vector<__fp16>>(s.seq * s.hq * s.dim);
+        const float scale = 1.0f / std::sqrt(static_cast<float>(s.dim));
+        cases.push_back({std::string("attention/") + s.label, shape_str({s.seq, s.kv, s.hq, s.hkv, s.dim}),
+                         (q->size() + k->size() + v->size() + o->size()) * 2.0,
+                         4.0 * s.seq * s.kv * s.hq * s.dim,
+                         [q, k, v, o, s, scale] {
+                             cactus_attention_f16(q->data(), k->data(), v->data(), o->data(), 1, s.seq, s.kv,
+                                                  s.hq, s.hkv, s.dim, scale, nullptr, s.kv - s.seq);
+                         }});
+    }
+
+    // One decode query over a quantized KV cache: the INT8 hybrid kernel against 4- and 2-bit
+    // low-bit caches. Cache contents are built on first run so filtered-out contexts cost nothing.
+    struct KvCacheState {
+        bool ready = false;
+        std::vector<__fp16> q, k_new, v_new, o, residual;
+        std::vector<int8_t> k8, v8;
+        std::vector<float> k_scales, v_scales;
+        std::vector<uint8_t> key_blocks, value_rows;
+    };
+    const size_t kv_hq = 16, kv_hkv = 2, kv_dim = 128;
+    const std::pair<const char*, size_t> kv_contexts[] = {{"8k", 8192}, {"32k", 32768}, {"128k", 131072}};
+    for (const auto& [ctx_label, ctx] : kv_contexts) {
+        for (size_t bits : {8, 4, 2}) {
+            const size_t cache_len = ctx - 1;
+            const size_t packed_len = (cache_len / KV_LOWBIT_BLOCK) * KV_LOWBIT_BLOCK;
+            const size_t row = kv_hkv * kv_dim;
+            const double cache_bytes = bits == 8
+                ? 2.0 * cache_len * (row + kv_scales_count(1, kv_hkv, kv_dim) * sizeof(float))
+                : (packed_len / KV_LOWBIT_BLOCK) * double(kv_lowbit_key_block_bytes(kv_hkv, kv_dim, bits)) +
+                  (cache_len - packed_len) * row * 2.0 + cache_len * double(kv_lowbit_value_row_bytes(kv_hkv, kv_dim, bits));
+            const std::string name = std::string("attention_kv/") + (bits == 8 ? "int8" : bits == 4 ? "q4" : "q2") + "_" + ctx_label;
+            auto st = std::make_shared<KvCacheState>();
+            cases.push_back({name, shape_str({ctx, kv_hq, kv_hkv, kv_dim}),
+                             cache_bytes + (2.0 * kv_hq * kv_dim + 2.0 * row) * 2.0,
+                             4.0 * ctx * kv_hq * kv_dim,
+                             [st, cache_len, packed_len, row, bits, kv_hq, kv_hkv, kv_dim] {
+                                 const float scale = 1.0f / std::sqrt(static_cast<float>(kv_dim));
+                                 if (!st->ready) {
+                                     st->q = random_vector<__fp16>(kv_hq * kv_dim, -1.0f, 1.0f, 3);
+                                     st->k_new = random_vector<__fp16>(row, -1.0f, 1.0f, 5);
+                                     st->v_new = random_vector<__fp16>(row, -1.0f, 1.0f, 9);
+                                     st->o.resize(kv_hq * kv_dim);
+                                     const auto keys = random_vector<__fp16>(cache_len * row, -1.0f, 1.0f, 13);
+                                     const auto values = random_vector<__fp16>(cache_len * row, -1.0f, 1.0f, 17);
+                                     if (bits == 8) {
+                                         st->k8.resize(keys.size());
+                                         st->v8.resize(values.size());
+                                         st->k_scales.resize(kv_scales_count(cache_len, kv_hkv, kv_dim));
+                                         st->v_scales.resize(st->k_scales.size());
+                                         cactus_quantize_kv_fp16_to_int8(keys.data(), st->k8.data(), st->k_scales.data(), cache_len, kv_hkv, kv_dim);
+                                         cactus_quantize_kv_fp16_to_int8(values.data(), st->v8.data(), st->v_scales.data(), cache_len, kv_hkv, kv_dim);
+                                     } else {
+                                         const size_t block_bytes = kv_lowbit_key_block_bytes(kv_hkv, kv_dim, bits);
+                                         st->key_blocks.resize((packed_len / KV_LOWBIT_BLOCK) * block_bytes);
+                                         for (size_t b = 0; b < packed_len / KV_LOWBIT_BLOCK; ++b) {
+                                             cactus_quantize_kv_keys_lowbit(keys.data() + b * KV_LOWBIT_BLOCK * row,
+                                                                            st->key_blocks.data() + b * block_bytes, kv_hkv, kv_dim, bits);
+                                         }
+                                         st->residual.assign(keys.begin() + packed_len * row, keys.end());
+                                         st->value_rows.resize(cache_len * kv_lowbit_value_row_bytes(kv_hkv, kv_dim, bits));
+                                         cactus_quantize_kv_values_lowbit(values.data(), st->value_rows.data(), cache_len, kv_hkv, kv_dim, bits);
+                                     }
+                                     st->ready = true;
+                                 }
+                                 if (bits == 8) {
+                                     cactus_attention_hybrid_int8_fp16(st->q.data(), st->k8.data(), st->v8.data(),
+                                                                       st->k_scales.data(), st->v_scales.data(),
+                                                                       st->k_new.data(), st->v_new.data(), st->o.data(),
+                                                                       1, 1, cache_len, 1, kv_hq, kv_hkv, kv_dim, scale, cache_len);
+                                 } else {
+                                     cactus_attention_hybrid_lowbit_fp16(st->q.data(), st->key_blocks.data(), st->residual.data(),
+                                                                         st->value_rows.data(), st->k_new.data(), st->v_new.data(),
+                                                                         st->o.data(), 1, cache_len, packed_len, 1,
+                                                                         kv_hq, kv_hkv, kv_dim, bits, scale, cache_len);
+                                 }
+                             }});
+        }
+    }
+
+    // Gated DeltaNet prefill over long prompts (Qwen3-Next-style heads). Inputs are built on first
+    // run; set CACTUS_GATED_DELTANET_PREFILL_SERIAL=1 to time the per-head serial chunked path.
+    struct DeltaNetState {
+        std::vector<__fp16> q, k, v, g, beta, state, out;
+    };
+    const size_t dn_hq = 8, dn_hv = 16, dn_dim = 128;
+    const std::pair<const char*, size_t> dn_lengths[] = {{"1k", 1024}, {"4k", 4096}, {"16k", 16384}, {"32k", 32768}};
+    for (const auto& [len_label, T] : dn_lengths) {
+        auto st = std::make_shared<DeltaNetState>();
+        cases.push_back({std::string("deltanet_prefill/") + len_label, shape_str({T, dn_hq, dn_hv, dn_dim}),
+                         (2.0 * T * dn_hq * dn_dim + 2.0 * T * dn_hv * dn_dim + 2.0 * T * dn_hv) * 2.0,
+                         6.0 * T * dn_hv * dn_dim * dn_dim,
+                         [st, T, dn_hq, dn_hv, dn_dim] {
+                             if (st->q.empty()) {
+                                 st->q = random_vector<__fp16>(T * dn_hq * dn_dim, -0.1f, 0.1f, 3);
+                                 st->k = random_vector<__fp16>(T * dn_hq * dn_dim, -0.1f, 0.1f, 5);
+                                 st->v = random_vector<__fp16>(T * dn_hv * dn_dim, -1.0f, 1.0f, 9);
+                                 st->g = random_vector<__fp16>(T * dn_hv, -0.5f, 0.0f, 13);
+                                 st->beta = random_vector<__fp16>(T * dn_hv, 0.0f, 1.0f, 17);
+                                 st->state.assign(dn_dim * dn_hv * dn_dim, static_cast<__fp16>(0.0f));
+                                 st->out.resize((T + dn_dim) * dn_hv * dn_dim);
+                             }
+                             cactus_gated_deltanet_prefill_f16(st->q.data(), st->k.data(), st->v.data(), st->g.data(),
+                                                               st->beta.data(), st->state.data(), st->out.data(),
+                                                               1, T, dn_hq, dn_hv, dn_dim, dn_dim, 64,
+                                                               1.0f / std::sqrt(static_cast<float>(dn_dim)));
+                         }});
+    }
+    {
+        auto q = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(dn_hq * dn_dim, -0.1f, 0.1f));
+        auto v = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(dn_hv * dn_dim));
+        auto g = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(dn_hv, -0.5f, 0.0f));
+        auto beta = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(dn_hv, 0.0f, 1.0f));
+        auto state = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(dn_dim * dn_hv * dn_dim, -0.2f, 0.2f));
+        auto out = std::make_shared<std::vector<__fp16>>((1 + dn_dim) * dn_hv * dn_dim);
+        cases.push_back({"deltanet_decode/step", shape_str({1, dn_hq, dn_hv, dn_dim}),
+                         (2.0 * state->size() + v->size()) * 2.0, 6.0 * dn_hv * dn_dim * dn_dim,
+                         [q, v, g, beta, state, out, dn_hq, dn_hv, dn_dim] {
+                             cactus_gated_deltanet_decode_f16(q->data(), q->data(), v->data(), g->data(), beta->data(),
+                                                              state->data(), out->data(), 1, dn_hq, dn_hv, dn_dim, dn_dim,
+                                                              1.0f / std::sqrt(static_cast<float>(dn_dim)));
+                         }});
+    }
+
+    {
+        const size_t rows = 512, dims = 2048;
+        auto x = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(rows * dims));
+        auto w = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(dims));
+        auto y = std::make_shared<std::vector<__fp16>>(rows * dims);
+        cases.push_back({"rms_norm/prefill", shape_str({rows, dims}), (2.0 * rows * dims + dims) * 2.0, 4.0 * rows * dims,
+                         [x, w, y] { cactus_rms_norm_f16(x->data(), w->data(), y->data(), rows, dims, 1e-6f); }});
+    }
+    {
+        const size_t seq = 512, heads = 16, dim = 128;
+        auto x = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(seq * heads * dim));
+        auto y = std::make_shared<std::vector<__fp16>>(seq * heads * dim);
+        cases.push_back({"rope/prefill", shape_str({seq, heads, dim}), 4.0 * seq * heads * dim, 3.0 * seq * heads * dim,
+                         [x, y] { cactus_rope_f16(x->data(), y->data(), 1, seq, heads, dim, 0, 1e6f); }});
+    }
+    {
+        const size_t vocab = 151936;
+        auto x = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(vocab, -8.0f, 8.0f));
+        auto y = std::make_shared<std::vector<__fp16>>(vocab);
+        cases.push_back({"softmax/vocab", shape_str({1, vocab}), 4.0 * vocab, 3.0 * vocab,
+                         [x, y] { cactus_softmax_f16(x->data(), y->data(), 1, 1, vocab); }});
+
+        auto logits = std::make_shared<std::vector<float>>(random_vector<float>(vocab, -8.0f, 8.0f));
+        auto token = std::make_shared<uint32_t>(0);
+        cases.push_back({"sample/top_p", shape_str({vocab}), 4.0 * vocab, 4.0 * vocab,
+                         [logits, token] { cactus_sample_f32(logits->data(), token.get(), vocab, 0.7f, 0.9f, 40, 1234); }});
+    }
+}
+
+void add_signal_cases(std::vector<BenchCase>& cases) {
+    {
+        const size_t L = 3000, c_in = 80, c_out = 384;
+        auto x = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(L * c_in));
+        auto w = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(c_out * c_in * 3));
+        auto y = std::make_shared<std::vector<__fp16>>(L * c_out);
+        cases.push_back({"conv1d_k3/whisper_stem", shape_str({L, c_in, c_out}),
+                         (x->size() + w->size() + y->size()) * 2.0, 2.0 * L * c_in * c_out * 3,
+                         [x, w, y] { cactus_conv1d_f16_k3(x->data(), w->data(), y->data(), 1, L, c_in, c_out, 1); }});
+    }
+    {
+        const size_t L = 512, C = 1024, K = 4;
+        auto x = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(L * C));
+        auto w = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(C * K));
+        auto y = std::make_shared<std::vector<__fp16>>(L * C);
+        cases.push_back({"conv1d_causal_dw/lfm_short_conv", shape_str({L, C, K}),
+                         (x->size() + w->size() + y->size()) * 2.0, 2.0 * L * C * K,
+                         [x, w, y] { cactus_conv1d_causal_depthwise_f16(x->data(), w->data(), y->data(), 1, L, C, K, 1); }});
+    }
+    {
+        const size_t c_in = 64, c_out = 64, H = 112, W = 112;
+        auto x = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(c_in * H * W));
+        auto w = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(c_out * c_in * 9));
+        auto b = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(c_out));
+        auto y = std::make_shared<std::vector<__fp16>>(c_out * H * W);
+        cases.push_back({"conv2d_k3s1/vision_stem", shape_str({c_in, H, W, c_out}),
+                         (x->size() + w->size() + y->size()) * 2.0, 2.0 * c_out * H * W * c_in * 9,
+                         [x, w, b, y] {
+                             cactus_conv2d_f16_k3s1p1_nchw(x->data(), w->data(), b->data(), y->data(), 1, c_in, H, W, c_out);
+                         }});
+    }
+    struct Conv2dShape {
+        const char* name;
+        size_t c_in, c_out, H, W, k, stride, padding, groups;
+    };
+    const Conv2dShape conv2d_shapes[] = {
+        {"k3s1_c64_56", 64, 64, 56, 56, 3, 1, 1, 1},
+        {"k3s1_c128_28", 128, 128, 28, 28, 3, 1, 1, 1},
+        {"k3s2_stem", 3, 32, 224, 224, 3, 2, 1, 1},
+        {"k3s2_c64_56", 64, 128, 56, 56, 3, 2, 1, 1},
+        {"k1_c256_28", 256, 256, 28, 28, 1, 1, 0, 1},
+        {"k5s1_g4_c64_32", 64, 64, 32, 32, 5, 1, 2, 4},
+    };
+    for (const auto& s : conv2d_shapes) {
+        const size_t H_out = (s.H + 2 * s.padding - s.k) / s.stride + 1;
+        const size_t W_out = (s.W + 2 * s.padding - s.k) / s.stride + 1;
+        auto x = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(s.c_in * s.H * s.W));
+        auto w = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(s.c_out * (s.c_in / s.groups) * s.k * s.k));
+        auto b = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(s.c_out));
+        auto y = std::make_shared<std::vector<__fp16>>(s.c_out * H_out * W_out);
+        const double bytes = (x->size() + w->size() + y->size()) * 2.0;
+        const double flops = 2.0 * s.c_out * H_out * W_out * (s.c_in / s.groups) * s.k * s.k;
+        const std::string shape = shape_str({s.c_in, s.H, s.W, s.c_out});
+        for (bool nhwc : {false, true}) {
+            cases.push_back({std::string("conv2d/") + s.name + (nhwc ? "_nhwc" : "_nchw"), shape, bytes, flops,
+                             [x, w, b, y, s, nhwc] {
+                                 cactus_conv2d_f16(x->data(), w->data(), b->data(), y->data(), 1, s.c_in, s.H, s.W,
+                                                   s.c_out, s.k, s.k, s.stride, s.padding, 1, s.groups, nhwc, nhwc);
+                             }});
+        }
+        // Reference: the fixed-shape kernel this engine replaces for the same problem, where one exists.
+        if (s.k == 3 && s.stride == 2 && s.groups == 1) {
+            cases.push_back({std::string("conv2d/") + s.name + "_direct", shape, bytes, flops, [x, w, b, y, s] {
+                                 cactus_conv2d_f16_k3s2p1_nchw(x->data(), w->data(), b->data(), y->data(), 1, s.c_in, s.H, s.W, s.c_out);
+                             }});
+        } else if (s.k == 1 && s.groups == 1) {
+            cases.push_back({std::string("conv2d/") + s.name + "_direct", shape, bytes, flops, [x, w, b, y, s] {
+                                 cactus_conv2d_pointwise_f16_1x1_nchw_gemm(x->data(), w->data(), b->data(), y->data(), 1, s.c_in, s.H, s.W, s.c_out);
+                             }});
+        }
+    }
+    // Diarization-style BiLSTM stack layer (hidden 128, 2 x 128 input) at ~59 frames per second of audio.
+    for (size_t seconds : {10, 60, 600}) {
+        const size_t T = 59 * seconds, I = 256, H = 128, G = 4 * H;
+        auto x = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(T * I));
+        auto w_ih = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(2 * G * I, -0.1f, 0.1f));
+        auto w_hh = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(2 * G * H, -0.1f, 0.1f));
+        auto bias = std::make_shared<std::vector<__fp16>>(random_vector<__fp16>(2 * G, -0.1f, 0.1f));
+        auto y = std::make_shared<std::vector<__fp16>>(T * 2 * H);
+        BenchCase bc{"bilstm/diarization_" + std::to_string(seconds) + "s", shape_str({T, I, H}),
+                     (x->size() + w_ih->size() + w_hh->size() + y->size()) * 2.0, 2.0 * 2.0 * T * G * (I + H),
+                     [x, w_ih, w_hh, bias, y, T, I, H, G] {
+                         cactus_bilstm_sequence_f16(x->data(), w_ih->data(), w_hh->data(), bias->data(), bias->data(),
+                                                    w_ih->data() + G * I, w_hh->data() + G * H, bias->data() + G, bias->data() + G,
+                                                    y->data(), 1, T, I, H);
+                     }};
+        bc.audio_seconds = static_cast<double>(seconds);
+        cases.push_back(std::move(bc));
+    }
+    {
+        const size_t n = 400, frames = 3000, bins = n / 2 + 1;
+        auto x = std::make_shared<std::vector<float>>(random_vector<float>(n * frames));
+        auto y = std::make_shared<std::vector<float>>(2 * bins * frames);
+        cases.push_back({"rfft/whisper_30s", shape_str({frames, n}), (x->size() + y->size()) * 4.0,
+                         5.0 * n * std::log2(static_cast<double>(n)) * frames / 2.0,
+                         [x, y] { cactus_rfft_f32_batch(x->data(), n, y->data(), 2 * bins, n, frames, "backward"); }});
+    }
+}
+
+std::string json_escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+void write_json(const std::string& path, const BenchOptions& opts, double peak_gbps, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open " << path << "\n";
+        return;
+    }
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"label\": \"" << json_escape(opts.label) << "\",\n"
+        << "  \"threads\": " << CactusThreading::get_thread_pool().num_workers() << ",\n"
+        << "  \"peak_gbps\": " << peak_gbps << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"shape\": \"" << r.shape << "\", \"ms\": " << r.ms
+            << ", \"gbps\": " << r.gbps << ", \"gflops\": " << r.gflops << ", \"pct_peak\": " << r.pct_peak;
+        if (r.rtf > 0.0) out << ", \"rtf\": " << r.rtf;
+        out << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+void print_usage() {
+    std::cout << "usage: cactus_kernel_bench [--filter SUBSTR] [--json FILE] [--label TEXT]\n"
+              << "                           [--min-time-ms MS] [--max-iters N] [--list]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    bool list_only = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                print_usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--filter") opts.filter = next();
+        else if (arg == "--json") opts.json_path = next();
+        else if (arg == "--label") opts.label = next();
+        else if (arg == "--min-time-ms") opts.min_time_ms = std::atof(next().c_str());
+        else if (arg == "--max-iters") opts.max_iters = static_cast<size_t>(std::max(1, std::atoi(next().c_str())));
+        else if (arg == "--list") list_only = true;
+        else {
+            print_usage();
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    std::vector<BenchCase> cases;
+    add_quant_cases(cases);
+    add_dense_cases(cases);
+    add_signal_cases(cases);
+    cases.erase(std::remove_if(cases.begin(), cases.end(), [&](const BenchCase& c) {
+        return !opts.filter.empty() && c.name.find(opts.filter) == std::string::npos;
+    }), cases.end());
+
+    if (list_only) {
+        for (const auto& c : cases) std::cout << c.name << " " << c.shape << "\n";
+        return 0;
+    }
+
+    const double peak_gbps = measure_peak_bandwidth_gbps(opts);
+    std::cout << std::left << std::setw(36) << "kernel" << std::setw(22) << "shape"
+              << std::right << std::setw(10) << "ms" << std::setw(10) << "GB/s"
+              << std::setw(10) << "GFLOP/s" << std::setw(8) << "%peak" << "\n";
+
+    std::vector<BenchResult> results;
+    for (const auto& c : cases) {
+        BenchResult r;
+        r.name = c.name;
+        r.shape = c.shape;
+        r.ms = median_ms(c.run, opts);
+        r.gbps = c.bytes / (r.ms * 1e6);
+        r.gflops = c.flops / (r.ms * 1e6);
+        r.pct_peak = peak_gbps > 0.0 ? 100.0 * r.gbps / peak_gbps : 0.0;
+        r.rtf = c.audio_seconds > 0.0 ? r.ms / (1000.0 * c.audio_seconds) : 0.0;
+        std::cout << std::left << std::setw(36) << r.name << std::setw(22) << r.shape << std::right
+                  << std::fixed << std::setprecision(3) << std::setw(10) << r.ms
+                  << std::setprecision(2) << std::setw(10) << r.gbps << std::setw(10) << r.gflops
+                  << std::setprecision(1) << std::setw(8) << r.pct_peak;
+        if (r.rtf > 0.0) std::cout << "  RTF " << std::setprecision(5) << r.rtf;
+        std::cout << "\n";
+        results.push_back(std::move(r));
+    }
+
+    if (!opts.json_path.empty()) write_json(opts.json_path, opts, peak_gbps, results);
+    return 0;
+}
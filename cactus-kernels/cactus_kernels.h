@@ -32,6 +32,8 @@ enum class ScalarOpType {
 };
 
 constexpr size_t KV_QUANT_GROUP_SIZE = 32;
+constexpr size_t KV_LOWBIT_BLOCK = 32;
+constexpr size_t KV_SPILL_BLOCK = 64;
 
 void cactus_add_f16(
     const __fp16* a,
@@ -154,6 +156,11 @@ void cactus_max_axis_f16(
     size_t axis_size,
     size_t inner_size);
 
+// Index of the largest logit among those whose mask bit is set. When every allowed logit is -inf
+// the first allowed index is returned; n only when the mask allows nothing.
+size_t cactus_masked_argmax_f32(const float* logits, const uint64_t* mask, size_t n, float* out_value);
+size_t cactus_masked_argmax_f16(const __fp16* logits, const uint64_t* mask, size_t n, float* out_value);
+
 void cactus_transpose_2d_f16(
     const __fp16* source,
     __fp16* destination,
@@ -225,6 +232,9 @@ struct CactusQuantMatrix {
 
 uint32_t cactus_quant_packed_group_bytes(uint32_t bits, uint32_t group_size);
 
+// Largest row count served by cactus_quant_small_m_gemm (speculative verify, beam search, small batches).
+constexpr uint32_t CACTUS_QUANT_SMALL_M_MAX = 8;
+
 void cactus_quant_4bit_gemv(
     const CactusQuantMatrix* W,
     const __fp16* x,
@@ -281,6 +291,16 @@ void cactus_quant_orthogonal_matmul(
     uint32_t M,
     __fp16* C);
 
+// CQ1-CQ4 GEMM for 2 <= M <= CACTUS_QUANT_SMALL_M_MAX: each 4-row weight block is decoded from the
+// codebook once per group and applied to every activation row, with SMMLA when the CPU has i8mm
+// and lane SDOT otherwise. Reads the packed indices directly (row-major or INTERLEAVED_4ROW), so
+// no expanded INT8 copy of the matrix is built. cactus_quant_matmul routes this M range here.
+void cactus_quant_small_m_gemm(
+    const CactusQuantMatrix* W,
+    const __fp16* A,
+    uint32_t M,
+    __fp16* C);
+
 void cactus_quant_4bit_gemv_interleaved(
     const CactusQuantMatrix* W,
     const uint8_t* packed_interleaved,
@@ -309,6 +329,17 @@ void cactus_quant_1bit_gemv_interleaved(
     const __fp16* x,
     __fp16* y);
 
+// C = (rms_norm(A) * norm_weight) @ W^T. For M == 1 with an interleaved CQ4 matrix the
+// normalization is folded into the Hadamard/INT8 activation transform; otherwise it falls
+// back to cactus_rms_norm_f16 followed by cactus_quant_matmul.
+void cactus_quant_rms_norm_matmul(
+    const CactusQuantMatrix* W,
+    const __fp16* A,
+    const __fp16* norm_weight,
+    float eps,
+    uint32_t M,
+    __fp16* C);
+
 void cactus_quant_dequantize_hadamard_embedding_row(
     uint32_t bits,
     uint32_t hidden_dim,
@@ -394,6 +425,18 @@ void cactus_rope_f16(
     size_t start_pos,
     float theta);
 
+// In-place RoPE over a token-major Q [seq, num_q_heads, head_dim] and K [seq, num_kv_heads,
+// head_dim] pair in one pass over the shared cos/sin rows. Same numerics as cactus_rope_f16.
+void cactus_rope_qk_f16(
+    __fp16* query,
+    __fp16* key,
+    size_t seq_len,
+    size_t num_q_heads,
+    size_t num_kv_heads,
+    size_t head_dim,
+    size_t start_pos,
+    float theta);
+
 void cactus_gpt_j_rope_f16(
     const __fp16* input,
     __fp16* output,
@@ -430,6 +473,38 @@ void cactus_glu_f32(
     size_t inner_size);
 
 
+// Row map of a full sliding-window KV cache kept as a ring: logical rows [0, sink) are pinned,
+// the next `span` logical rows start at physical row sink + head and wrap back to row sink.
+// head == 0 is the plain linear layout.
+//
+// A cache slot may also continue a prefix stored once elsewhere: logical rows [0, shared) are
+// read from the shared_* buffers and the slot's own storage holds rows from `shared` on. The
+// two are not combined; a slot with a shared prefix is linear.
+struct CactusKVRing {
+    size_t sink = 0;
+    size_t head = 0;
+    size_t span = 0;
+    size_t shared = 0;
+    const void* shared_keys = nullptr;
+    const void* shared_values = nullptr;
+    const float* shared_k_scales = nullptr;
+    const float* shared_v_scales = nullptr;
+
+    size_t row(size_t logical) const {
+        if (head == 0 || logical < sink) return logical;
+        const size_t t = logical - sink + head;
+        return sink + (t >= span ? t - span : t);
+    }
+
+    // Start of logical row `logical` in a per-row buffer whose own storage begins at `own`, with
+    // `prefix` the matching shared buffer and `stride` elements per row.
+    template <typename T>
+    const T* at(const T* own, const void* prefix, size_t logical, size_t stride) const {
+        if (logical < shared) return static_cast<const T*>(prefix) + logical * stride;
+        return own + row(logical - shared) * stride;
+    }
+};
+
 void cactus_attention_f16(
     const __fp16* queries,
     const __fp16* keys,
@@ -449,7 +524,8 @@ void cactus_attention_f16(
     bool mask_is_additive = false,
     bool mask_per_head = false,
     size_t v_head_dim = 0,
-    float logit_cap = 0.0f);
+    float logit_cap = 0.0f,
+    const CactusKVRing& kv_ring = {});
 
 void cactus_attention_hybrid_int8_fp16(
     const __fp16* queries,
@@ -472,7 +548,83 @@ void cactus_attention_hybrid_int8_fp16(
     bool is_causal = true,
     size_t window_size = 0,
     size_t group_size = KV_QUANT_GROUP_SIZE,
-    size_t v_head_dim = 0);
+    size_t v_head_dim = 0,
+    const CactusKVRing& kv_ring = {});
+
+// Sub-8-bit (bits = 4 or 2) asymmetric KV cache, KIVI-style. Keys are quantized per channel over
+// blocks of KV_LOWBIT_BLOCK tokens; per kv head a block holds fp16 scale[head_dim], fp16
+// min[head_dim], then KV_LOWBIT_BLOCK rows of packed codes. Values are quantized per token over
+// KV_QUANT_GROUP_SIZE channels; per kv head a row holds packed codes, then fp16 scale[groups] and
+// fp16 min[groups]. Codes are packed lowest channel in the lowest bits.
+void cactus_quantize_kv_keys_lowbit(
+    const __fp16* src,
+    uint8_t* dst,
+    size_t kv_heads,
+    size_t head_dim,
+    size_t bits);
+
+void cactus_dequantize_kv_keys_lowbit(
+    const uint8_t* src,
+    __fp16* dst,
+    size_t rows,
+    size_t kv_heads,
+    size_t head_dim,
+    size_t bits);
+
+void cactus_quantize_kv_values_lowbit(
+    const __fp16* src,
+    uint8_t* dst,
+    size_t seq_len,
+    size_t kv_heads,
+    size_t head_dim,
+    size_t bits);
+
+// Cached keys [0, packed_len) come from key_blocks and [packed_len, cache_len) from the fp16
+// key_residual rows; cached values all come from value_rows. head_dim must be a multiple of 32
+// and at most 512. Codes are expanded inside the score and accumulate loops.
+void cactus_attention_hybrid_lowbit_fp16(
+    const __fp16* queries,
+    const uint8_t* key_blocks,
+    const __fp16* key_residual,
+    const uint8_t* value_rows,
+    const __fp16* keys_new,
+    const __fp16* values_new,
+    __fp16* output,
+    size_t seq_len,
+    size_t cache_len,
+    size_t packed_len,
+    size_t new_len,
+    size_t num_q_heads,
+    size_t num_kv_heads,
+    size_t head_dim,
+    size_t bits,
+    float scale,
+    size_t position_offset = 0,
+    bool is_causal = true,
+    size_t window_size = 0);
+
+// Relevance summaries for a disk-tiered KV cache. Per block of KV_SPILL_BLOCK rows and kv head a
+// summary holds fp16 min[head_dim] then max[head_dim] of the dequantized INT8 keys. With merge the
+// rows widen an existing summary instead of replacing it.
+void cactus_kv_block_minmax_int8(
+    const int8_t* keys,
+    const float* scales,
+    __fp16* summary,
+    size_t rows,
+    size_t kv_heads,
+    size_t head_dim,
+    bool merge);
+
+// Upper bound of q.k over each block from its summary: sum_d max(q_d * min_d, q_d * max_d), taken
+// as the max over query heads. queries is one token, [num_q_heads, head_dim].
+void cactus_kv_block_scores_f16(
+    const __fp16* queries,
+    const __fp16* summaries,
+    float* scores,
+    size_t num_blocks,
+    size_t num_q_heads,
+    size_t num_kv_heads,
+    size_t head_dim);
 
 
 void cactus_conv1d_causal_depthwise_f16(
@@ -579,6 +731,28 @@ void cactus_conv2d_pointwise_f16_1x1_nchw_gemm(
     size_t W,
     size_t C_out);
 
+// General 2D convolution with OIHW weights [C_out, C_in / groups, kernel_h, kernel_w]. Stride-1
+// 3x3 convolutions run Winograd F(4x4, 3x3); everything else packs im2col tiles for the FP16 GEMM.
+// nhwc_input / nhwc_output select [N, H, W, C] activations instead of [N, C, H, W].
+void cactus_conv2d_f16(
+    const __fp16* input,
+    const __fp16* weight,
+    const __fp16* bias,
+    __fp16* output,
+    size_t N,
+    size_t C_in,
+    size_t H,
+    size_t W,
+    size_t C_out,
+    size_t kernel_h,
+    size_t kernel_w,
+    size_t stride,
+    size_t padding,
+    size_t dilation,
+    size_t groups,
+    bool nhwc_input = false,
+    bool nhwc_output = false);
+
 void cactus_stft_f16(
     const __fp16* input,
     const __fp16* weight,
@@ -770,6 +944,8 @@ void cactus_quantize_kv_fp16_to_int8(
 
 void cactus_rfft_f32_1d(const float* input, float* output, size_t n, const char* norm);
 void cactus_irfft_f32_1d(const float* input, float* output, size_t n, const char* norm);
+void cactus_rfft_f32_batch(const float* input, size_t input_stride, float* output, size_t output_stride,
+                           size_t n, size_t num_frames, const char* norm);
 float cactus_hertz_to_mel(float freq, const char* mel_scale);
 float cactus_mel_to_hertz(float mels, const char* mel_scale);
 
@@ -794,6 +970,25 @@ void cactus_compute_spectrogram_f32(
     float reference, float min_value, const float* db_range,
     bool remove_dc_offset);
 
+struct CactusSpectrogramStream;
+
+CactusSpectrogramStream* cactus_spectrogram_stream_create(
+    const float* window, size_t window_length,
+    size_t frame_length, size_t hop_length, const size_t* fft_length,
+    float power, bool center, const char* pad_mode,
+    const float* preemphasis,
+    const float* mel_filters, size_t mel_filters_size,
+    float mel_floor, const char* log_mel,
+    float reference, float min_value,
+    bool remove_dc_offset);
+
+void cactus_spectrogram_stream_destroy(CactusSpectrogramStream* stream);
+void cactus_spectrogram_stream_reset(CactusSpectrogramStream* stream);
+size_t cactus_spectrogram_stream_bins(const CactusSpectrogramStream* stream);
+size_t cactus_spectrogram_stream_push(CactusSpectrogramStream* stream, const float* samples, size_t num_samples);
+size_t cactus_spectrogram_stream_finish(CactusSpectrogramStream* stream);
+size_t cactus_spectrogram_stream_read(CactusSpectrogramStream* stream, float* output, size_t max_frames);
+
 unsigned char* cactus_image_load(const char* path, int* width, int* height, int* channels, int desired_channels);
 int cactus_image_info(const char* path, int* width, int* height, int* channels);
 void cactus_image_free(unsigned char* data);
@@ -829,4 +1024,12 @@ inline size_t kv_scales_count(
     return seq_len * kv_heads * num_groups;
 }
 
+inline size_t kv_lowbit_key_block_bytes(size_t kv_heads, size_t head_dim, size_t bits) {
+    return kv_heads * (2 * head_dim * sizeof(__fp16) + KV_LOWBIT_BLOCK * head_dim * bits / 8);
+}
+
+inline size_t kv_lowbit_value_row_bytes(size_t kv_heads, size_t head_dim, size_t bits) {
+    return kv_heads * (head_dim * bits / 8 + 2 * (head_dim / KV_QUANT_GROUP_SIZE) * sizeof(__fp16));
+}
+
 #endif
@@ -227,14 +227,15 @@ static inline void cactus_attention_f16_fast(
     size_t position_offset,
     bool is_causal,
     size_t window_size,
-    size_t v_head_dim
+    size_t v_head_dim,
+    const CactusKVRing& kv_ring
 ) {
     constexpr size_t BLOCK_SIZE = 32;
     const size_t qk_nblocks = head_dim / 8;
     const size_t v_nblocks = v_head_dim / 8;
 
 #ifdef __APPLE__
-    if (seq_len >= 64 && window_size == 0) {
+    if (seq_len >= 64 && window_size == 0 && kv_ring.head == 0 && kv_ring.shared == 0) {
         cactus_attention_f16_accelerate(
             queries, keys, values, output,
             batch_size, seq_len, kv_seq_len,
@@ -291,7 +292,7 @@ static inline void cactus_attention_f16_fast(
                     float32x4_t s0 = vdupq_n_f32(0.f);
                     float32x4_t s1 = vdupq_n_f32(0.f);
 
-                    const __fp16* k = keys + batch*kv_batch_stride + i*kv_seq_stride + kv_head*head_dim;
+                    const __fp16* k = kv_ring.at(keys + batch*kv_batch_stride, kv_ring.shared_keys, i, kv_seq_stride) + kv_head*head_dim;
 
                     for (size_t d = 0; d < qk_nblocks; d++) {
                         float16x8_t qv = vld1q_f16(q + d*8);
@@ -335,7 +336,7 @@ static inline void cactus_attention_f16_fast(
                     const float attn_weight = block_scores[i] * current_block_scale;
                     if (attn_weight == 0.f) continue;
 
-                    const __fp16* v = values + batch*v_batch_stride + (kv0+i)*v_seq_stride + kv_head*v_head_dim;
+                    const __fp16* v = kv_ring.at(values + batch*v_batch_stride, kv_ring.shared_values, kv0+i, v_seq_stride) + kv_head*v_head_dim;
                     float32x4_t wv = vdupq_n_f32(attn_weight);
 
                     for (size_t d = 0; d < v_nblocks; d++) {
@@ -386,7 +387,8 @@ void cactus_attention_f16(
     bool mask_is_additive,
     bool mask_per_head,
     size_t v_head_dim,
-    float logit_cap
+    float logit_cap,
+    const CactusKVRing& kv_ring
 ) {
     if (v_head_dim == 0) v_head_dim = head_dim;
     if (scale == 0.0f) {
@@ -398,10 +400,32 @@ void cactus_attention_f16(
             queries, keys, values, output,
             batch_size, seq_len, kv_seq_len,
             num_q_heads, num_kv_heads, head_dim,
-            scale, position_offset, is_causal, window_size, v_head_dim
+            scale, position_offset, is_causal, window_size, v_head_dim, kv_ring
         );
         return;
     }
+    if (kv_ring.head != 0 || kv_ring.shared != 0) {
+        // The masked path walks rows linearly, so put ring-ordered or prefix-shared rows back in
+        // logical order first.
+        thread_local std::vector<__fp16> ring_keys, ring_values;
+        const size_t k_row = num_kv_heads * head_dim, v_row = num_kv_heads * v_head_dim;
+        ring_keys.resize(batch_size * kv_seq_len * k_row);
+        ring_values.resize(batch_size * kv_seq_len * v_row);
+        for (size_t b = 0; b < batch_size; ++b) {
+            for (size_t i = 0; i < kv_seq_len; ++i) {
+                std::memcpy(ring_keys.data() + (b * kv_seq_len + i) * k_row,
+                            kv_ring.at(keys + b * kv_seq_len * k_row, kv_ring.shared_keys, i, k_row),
+                            k_row * sizeof(__fp16));
+                std::memcpy(ring_values.data() + (b * kv_seq_len + i) * v_row,
+                            kv_ring.at(values + b * kv_seq_len * v_row, kv_ring.shared_values, i, v_row),
+                            v_row * sizeof(__fp16));
+            }
+        }
+        cactus_attention_f16(queries, ring_keys.data(), ring_values.data(), output, batch_size, seq_len, kv_seq_len,
+                             num_q_heads, num_kv_heads, head_dim, scale, mask, position_offset, window_size, is_causal,
+                             mask_is_additive, mask_per_head, v_head_dim, logit_cap);
+        return;
+    }
 
     constexpr size_t VECTOR_WIDTH = 8;
     constexpr size_t BLOCK_SIZE = 32;
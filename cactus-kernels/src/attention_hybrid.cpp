@@ -25,7 +25,8 @@ static void cactus_attention_hybrid_int8_fp16_decode_dot(
     float scale,
     size_t position_offset,
     bool is_causal,
-    size_t window_size
+    size_t window_size,
+    const CactusKVRing& kv_ring
 ) {
     const size_t kv_seq_len = cache_len + new_len;
 
@@ -68,6 +69,19 @@ static void cactus_attention_hybrid_int8_fp16_decode_dot(
                 const __fp16* K_new_base = keys_new + batch_idx * k_new_batch_stride;
                 const __fp16* V_new_base = values_new + batch_idx * v_new_batch_stride;
                 __fp16* o_vec = output + batch_idx * o_batch_stride + q_head_idx * head_dim;
+                const size_t scale_stride = num_kv_heads * num_quant_groups;
+                auto k_row = [&](size_t pos) {
+                    return kv_ring.at(K_cached_base, kv_ring.shared_keys, pos, kv_seq_stride) + kv_head_idx * head_dim;
+                };
+                auto v_row = [&](size_t pos) {
+                    return kv_ring.at(V_cached_base, kv_ring.shared_values, pos, kv_seq_stride) + kv_head_idx * head_dim;
+                };
+                auto k_scale_row = [&](size_t pos) {
+                    return kv_ring.at(k_scales, kv_ring.shared_k_scales, pos, scale_stride) + kv_head_idx * num_quant_groups;
+                };
+                auto v_scale_row = [&](size_t pos) {
+                    return kv_ring.at(v_scales, kv_ring.shared_v_scales, pos, scale_stride) + kv_head_idx * num_quant_groups;
+                };
 
                 for (size_t qg = 0; qg < num_quant_groups; ++qg) {
                     const __fp16* q_grp = q_vec + qg * QGROUP;
@@ -116,19 +130,17 @@ static void cactus_attention_hybrid_int8_fp16_decode_dot(
 
                     size_t kv_pos = kv_block_start;
                     for (; kv_pos + 3 < cached_kv_end; kv_pos += 4) {
-                        const int8_t* k1 = K_cached_base + kv_pos * kv_seq_stride + kv_head_idx * head_dim;
-                        const int8_t* k2 = k1 + kv_seq_stride;
-                        const int8_t* k3 = k2 + kv_seq_stride;
-                        const int8_t* k4 = k3 + kv_seq_stride;
-                        const float* ks1 = k_scales + (kv_pos * num_kv_heads + kv_head_idx) * num_quant_groups;
-                        const float* ks2 = ks1 + num_kv_heads * num_quant_groups;
-                        const float* ks3 = ks2 + num_kv_heads * num_quant_groups;
-                        const float* ks4 = ks3 + num_kv_heads * num_quant_groups;
+                        const int8_t* k1 = k_row(kv_pos);
+                        const int8_t* k2 = k_row(kv_pos + 1);
+                        const int8_t* k3 = k_row(kv_pos + 2);
+                        const int8_t* k4 = k_row(kv_pos + 3);
+                        const float* ks1 = k_scale_row(kv_pos);
+                        const float* ks2 = k_scale_row(kv_pos + 1);
+                        const float* ks3 = k_scale_row(kv_pos + 2);
+                        const float* ks4 = k_scale_row(kv_pos + 3);
                         if (kv_pos + 8 < cached_kv_end) {
-                            __builtin_prefetch(k1 + 4 * kv_seq_stride, 0, 0);
-                            __builtin_prefetch(k1 + 5 * kv_seq_stride, 0, 0);
-                            __builtin_prefetch(k1 + 6 * kv_seq_stride, 0, 0);
-                            __builtin_prefetch(k1 + 7 * kv_seq_stride, 0, 0);
+                            for (size_t ahead = 4; ahead < 8; ++ahead)
+                                __builtin_prefetch(k_row(kv_pos + ahead), 0, 0);
                         }
 
                         float32x4_t sumv1 = vdupq_n_f32(0.0f);
@@ -172,8 +184,8 @@ static void cactus_attention_hybrid_int8_fp16_decode_dot(
                         if (local_max > block_max) block_max = local_max;
                     }
                     for (; kv_pos < cached_kv_end; ++kv_pos) {
-                        const int8_t* k_vec = K_cached_base + kv_pos * kv_seq_stride + kv_head_idx * head_dim;
-                        const float* k_scale_base = k_scales + (kv_pos * num_kv_heads + kv_head_idx) * num_quant_groups;
+                        const int8_t* k_vec = k_row(kv_pos);
+                        const float* k_scale_base = k_scale_row(kv_pos);
 
                         float32x4_t sumv = vdupq_n_f32(0.0f);
                         for (size_t qg = 0; qg < num_quant_groups; ++qg) {
@@ -240,19 +252,17 @@ static void cactus_attention_hybrid_int8_fp16_decode_dot(
                         const float w4 = block_scores[v_kv + 3 - kv_block_start];
                         if (w1 == 0.0f && w2 == 0.0f && w3 == 0.0f && w4 == 0.0f) continue;
 
-                        const int8_t* v1 = V_cached_base + v_kv * kv_seq_stride + kv_head_idx * head_dim;
-                        const int8_t* v2 = v1 + kv_seq_stride;
-                        const int8_t* v3 = v2 + kv_seq_stride;
-                        const int8_t* v4 = v3 + kv_seq_stride;
-                        const float* vs1 = v_scales + (v_kv * num_kv_heads + kv_head_idx) * num_quant_groups;
-                        const float* vs2 = vs1 + num_kv_heads * num_quant_groups;
-                        const float* vs3 = vs2 + num_kv_heads * num_quant_groups;
-                        const float* vs4 = vs3 + num_kv_heads * num_quant_groups;
+                        const int8_t* v1 = v_row(v_kv);
+                        const int8_t* v2 = v_row(v_kv + 1);
+                        const int8_t* v3 = v_row(v_kv + 2);
+                        const int8_t* v4 = v_row(v_kv + 3);
+                        const float* vs1 = v_scale_row(v_kv);
+                        const float* vs2 = v_scale_row(v_kv + 1);
+                        const float* vs3 = v_scale_row(v_kv + 2);
+                        const float* vs4 = v_scale_row(v_kv + 3);
                         if (v_kv + 8 < cached_block_end) {
-                            __builtin_prefetch(v1 + 4 * kv_seq_stride, 0, 0);
-                            __builtin_prefetch(v1 + 5 * kv_seq_stride, 0, 0);
-                            __builtin_prefetch(v1 + 6 * kv_seq_stride, 0, 0);
-                            __builtin_prefetch(v1 + 7 * kv_seq_stride, 0, 0);
+                            for (size_t ahead = 4; ahead < 8; ++ahead)
+                                __builtin_prefetch(v_row(v_kv + ahead), 0, 0);
                         }
 
                         for (size_t qg = 0; qg < num_quant_groups; ++qg) {
@@ -279,8 +289,8 @@ static void cactus_attention_hybrid_int8_fp16_decode_dot(
                     for (; v_kv < cached_block_end; ++v_kv) {
                         const float w = block_scores[v_kv - kv_block_start];
                         if (w == 0.0f) continue;
-                        const int8_t* v_vec = V_cached_base + v_kv * kv_seq_stride + kv_head_idx * head_dim;
-                        const float* v_scale_base = v_scales + (v_kv * num_kv_heads + kv_head_idx) * num_quant_groups;
+                        const int8_t* v_vec = v_row(v_kv);
+                        const float* v_scale_base = v_scale_row(v_kv);
                         for (size_t qg = 0; qg < num_quant_groups; ++qg) {
                             const float16x8_t ws_vec = vdupq_n_f16(static_cast<__fp16>(w * v_scale_base[qg]));
                             #pragma unroll
@@ -347,7 +357,8 @@ void cactus_attention_hybrid_int8_fp16(
     bool is_causal,
     size_t window_size,
     size_t quant_group_size,
-    size_t v_head_dim
+    size_t v_head_dim,
+    const CactusKVRing& kv_ring
 ) {
     if (v_head_dim == 0) v_head_dim = head_dim;
     if (scale == 0.0f) {
@@ -364,7 +375,7 @@ void cactus_attention_hybrid_int8_fp16(
             keys_new, values_new, output,
             batch_size, cache_len, new_len,
             num_q_heads, num_kv_heads, head_dim,
-            scale, position_offset, is_causal, window_size);
+            scale, position_offset, is_causal, window_size, kv_ring);
         return;
     }
 
@@ -467,8 +478,10 @@ void cactus_attention_hybrid_int8_fp16(
 
                         if (kv_pos < cache_len) {
                             if (k_scales != nullptr) {
-                                const int8_t* k_vec = K_cached_base + kv_pos * k_seq_stride + kv_head_idx * head_dim;
-                                const float* k_scale_base = k_scales + (kv_pos * num_kv_heads + kv_head_idx) * num_quant_groups_k;
+                                const int8_t* k_vec = kv_ring.at(K_cached_base, kv_ring.shared_keys, kv_pos, k_seq_stride) +
+                                    kv_head_idx * head_dim;
+                                const float* k_scale_base = kv_ring.at(k_scales, kv_ring.shared_k_scales, kv_pos,
+                                    num_kv_heads * num_quant_groups_k) + kv_head_idx * num_quant_groups_k;
 
                                 for (size_t quant_group = 0; quant_group < num_quant_groups_k; quant_group++) {
                                     const size_t dim_base = quant_group * quant_group_size;
@@ -489,8 +502,8 @@ void cactus_attention_hybrid_int8_fp16(
                                     score += k_scale_base[quant_group] * partial;
                                 }
                             } else {
-                                const __fp16* k_vec = reinterpret_cast<const __fp16*>(K_cached_base) +
-                                    kv_pos * k_seq_stride + kv_head_idx * head_dim;
+                                const __fp16* k_vec = kv_ring.at(reinterpret_cast<const __fp16*>(K_cached_base),
+                                    kv_ring.shared_keys, kv_pos, k_seq_stride) + kv_head_idx * head_dim;
                                 float16x8_t s_acc = vdupq_n_f16((__fp16)0.0f);
 
                                 for (size_t dim_block = 0; dim_block < head_dim_aligned; dim_block += VECTOR_WIDTH) {
@@ -555,8 +568,10 @@ void cactus_attention_hybrid_int8_fp16(
 
                         if (kv_pos < cache_len) {
                             if (v_scales != nullptr) {
-                                const int8_t* v_vec = V_cached_base + kv_pos * v_seq_stride + kv_head_idx * v_head_dim;
-                                const float* v_scale_base = v_scales + (kv_pos * num_kv_heads + kv_head_idx) * num_quant_groups_v;
+                                const int8_t* v_vec = kv_ring.at(V_cached_base, kv_ring.shared_values, kv_pos, v_seq_stride) +
+                                    kv_head_idx * v_head_dim;
+                                const float* v_scale_base = kv_ring.at(v_scales, kv_ring.shared_v_scales, kv_pos,
+                                    num_kv_heads * num_quant_groups_v) + kv_head_idx * num_quant_groups_v;
 
                                 for (size_t quant_group = 0; quant_group < num_quant_groups_v; quant_group++) {
                                     const size_t dim_base = quant_group * quant_group_size;
@@ -572,8 +587,8 @@ void cactus_attention_hybrid_int8_fp16(
                                     }
                                 }
                             } else {
-                                const __fp16* v_vec = reinterpret_cast<const __fp16*>(V_cached_base) +
-                                    kv_pos * v_seq_stride + kv_head_idx * v_head_dim;
+                                const __fp16* v_vec = kv_ring.at(reinterpret_cast<const __fp16*>(V_cached_base),
+                                    kv_ring.shared_values, kv_pos, v_seq_stride) + kv_head_idx * v_head_dim;
                                 const float16x8_t w_vec = vdupq_n_f16(static_cast<__fp16>(attn_weight));
 
                                 for (size_t dim_block = 0; dim_block < v_head_dim_aligned; dim_block += VECTOR_WIDTH) {
@@ -616,3 +631,331 @@ void cactus_attention_hybrid_int8_fp16(
             }
         });
 }
+
+// vqtbl1q_u8 replicates each packed byte into the lanes of the channels it carries; a per-lane
+// shift then drops every code to bit 0 ahead of the mask.
+alignas(16) static const uint8_t kLowbitIndex4[2][16] = {
+    {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7},
+    {8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15, 15}};
+alignas(16) static const int8_t kLowbitShift4[16] = {0, -4, 0, -4, 0, -4, 0, -4, 0, -4, 0, -4, 0, -4, 0, -4};
+alignas(16) static const uint8_t kLowbitIndex2[2][16] = {
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3},
+    {4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7}};
+alignas(16) static const int8_t kLowbitShift2[16] = {0, -2, -4, -6, 0, -2, -4, -6, 0, -2, -4, -6, 0, -2, -4, -6};
+
+template <size_t BITS>
+struct LowbitUnpacker {
+    static constexpr size_t GROUP_BYTES = KV_QUANT_GROUP_SIZE * BITS / 8;
+
+    uint8x16_t index_lo = vld1q_u8(BITS == 4 ? kLowbitIndex4[0] : kLowbitIndex2[0]);
+    uint8x16_t index_hi = vld1q_u8(BITS == 4 ? kLowbitIndex4[1] : kLowbitIndex2[1]);
+    int8x16_t shift = vld1q_s8(BITS == 4 ? kLowbitShift4 : kLowbitShift2);
+    uint8x16_t mask = vdupq_n_u8(static_cast<uint8_t>((1u << BITS) - 1));
+
+    // 32 codes of one quantization group, as int8 lanes for channels [0, 16) and [16, 32).
+    inline void unpack(const uint8_t* packed, int8x16_t& lo, int8x16_t& hi) const {
+        const uint8x16_t bytes = BITS == 4 ? vld1q_u8(packed) : vcombine_u8(vld1_u8(packed), vld1_u8(packed));
+        lo = vreinterpretq_s8_u8(vandq_u8(vshlq_u8(vqtbl1q_u8(bytes, index_lo), shift), mask));
+        hi = vreinterpretq_s8_u8(vandq_u8(vshlq_u8(vqtbl1q_u8(bytes, index_hi), shift), mask));
+    }
+};
+
+static inline float lowbit_dot_f16(const __fp16* a, const __fp16* b, size_t head_dim) {
+    float16x8_t s_acc = vdupq_n_f16((__fp16)0.0f);
+    for (size_t d = 0; d < head_dim; d += 8) {
+        s_acc = vfmaq_f16(s_acc, vld1q_f16(a + d), vld1q_f16(b + d));
+    }
+    return vaddvq_f32(vcvt_f32_f16(vget_low_f16(s_acc))) +
+           vaddvq_f32(vcvt_f32_f16(vget_high_f16(s_acc)));
+}
+
+template <size_t BITS>
+static void cactus_attention_hybrid_lowbit_impl(
+    const __fp16* queries,
+    const uint8_t* key_blocks,
+    const __fp16* key_residual,
+    const uint8_t* value_rows,
+    const __fp16* keys_new,
+    const __fp16* values_new,
+    __fp16* output,
+    size_t seq_len,
+    size_t cache_len,
+    size_t packed_len,
+    size_t new_len,
+    size_t num_q_heads,
+    size_t num_kv_heads,
+    size_t head_dim,
+    float scale,
+    size_t position_offset,
+    bool is_causal,
+    size_t window_size
+) {
+    constexpr size_t VECTOR_WIDTH = 8;
+    constexpr size_t BLOCK_SIZE = KV_LOWBIT_BLOCK;
+    constexpr size_t QGROUP = KV_QUANT_GROUP_SIZE;
+    constexpr size_t MAX_HEAD_DIM = 512;
+    constexpr size_t MAX_QUANT_GROUPS = MAX_HEAD_DIM / QGROUP;
+    constexpr size_t MAX_ACCUM_SLOTS = MAX_HEAD_DIM / VECTOR_WIDTH;
+    constexpr size_t GROUP_BYTES = LowbitUnpacker<BITS>::GROUP_BYTES;
+
+    const size_t kv_seq_len = cache_len + new_len;
+    const size_t num_quant_groups = head_dim / QGROUP;
+    const size_t num_accum_slots = head_dim / VECTOR_WIDTH;
+    const size_t gqa_group_size = num_q_heads / num_kv_heads;
+    const size_t code_bytes = head_dim * BITS / 8;
+    const size_t key_block_bytes = kv_lowbit_key_block_bytes(num_kv_heads, head_dim, BITS);
+    const size_t key_head_bytes = kv_lowbit_key_block_bytes(1, head_dim, BITS);
+    const size_t value_row_bytes = kv_lowbit_value_row_bytes(num_kv_heads, head_dim, BITS);
+    const size_t value_head_bytes = kv_lowbit_value_row_bytes(1, head_dim, BITS);
+    const size_t q_seq_stride = num_q_heads * head_dim;
+    const size_t kv_seq_stride = num_kv_heads * head_dim;
+    const size_t cache_abs_offset = position_offset >= cache_len ? position_offset - cache_len : 0;
+
+    CactusThreading::parallel_for(num_q_heads * seq_len, CactusThreading::Thresholds::ATTENTION,
+        [=](size_t start_idx, size_t end_idx) {
+            const LowbitUnpacker<BITS> unpacker;
+            alignas(16) int8_t q_int8[MAX_HEAD_DIM];
+            float q_scales[MAX_QUANT_GROUPS];
+            float group_bias[MAX_QUANT_GROUPS];
+            float block_scores[BLOCK_SIZE];
+            float32x4_t output_accum_low[MAX_ACCUM_SLOTS];
+            float32x4_t output_accum_high[MAX_ACCUM_SLOTS];
+            float16x8_t block_accum[MAX_ACCUM_SLOTS];
+
+            for (size_t work_idx = start_idx; work_idx < end_idx; ++work_idx) {
+                const size_t q_head_idx = work_idx / seq_len;
+                const size_t q_pos = work_idx % seq_len;
+                const size_t kv_head_idx = q_head_idx / gqa_group_size;
+
+                const __fp16* q_vec = queries + q_pos * q_seq_stride + q_head_idx * head_dim;
+                __fp16* o_vec = output + q_pos * q_seq_stride + q_head_idx * head_dim;
+
+                float running_max = -std::numeric_limits<float>::infinity();
+                float running_sum = 0.0f;
+                for (size_t i = 0; i < num_accum_slots; ++i) {
+                    output_accum_low[i] = vdupq_n_f32(0.0f);
+                    output_accum_high[i] = vdupq_n_f32(0.0f);
+                }
+                std::fill(group_bias, group_bias + num_quant_groups, 0.0f);
+
+                const size_t absolute_q_pos = position_offset + q_pos;
+                const size_t kv_end = is_causal ? std::min(kv_seq_len, cache_len + q_pos + 1) : kv_seq_len;
+                size_t kv_first = 0;
+                if (window_size > 0 && absolute_q_pos > window_size) {
+                    const size_t window_start = absolute_q_pos - window_size;
+                    kv_first = window_start > cache_abs_offset ? window_start - cache_abs_offset : 0;
+                }
+
+                for (size_t kv_block_start = (kv_first / BLOCK_SIZE) * BLOCK_SIZE; kv_block_start < kv_end;
+                     kv_block_start += BLOCK_SIZE) {
+                    const size_t kv_block_end = std::min(kv_block_start + BLOCK_SIZE, kv_end);
+                    const size_t block_size = kv_block_end - kv_block_start;
+                    float block_max = -std::numeric_limits<float>::infinity();
+
+                    size_t kv_pos = kv_block_start;
+                    for (; kv_pos < std::min(kv_first, kv_block_end); ++kv_pos) {
+                        block_scores[kv_pos - kv_block_start] = -std::numeric_limits<float>::infinity();
+                    }
+
+                    const size_t packed_end = kv_block_start < packed_len ? std::min(kv_block_end, cache_len) : kv_block_start;
+                    if (kv_pos < packed_end) {
+                        // Per-channel scale folds into the query, per-channel min into one bias term.
+                        const uint8_t* block = key_blocks + (kv_block_start / BLOCK_SIZE) * key_block_bytes +
+                                               kv_head_idx * key_head_bytes;
+                        const __fp16* k_scale = reinterpret_cast<const __fp16*>(block);
+                        const __fp16* k_min = k_scale + head_dim;
+                        const uint8_t* codes = block + 2 * head_dim * sizeof(__fp16);
+
+                        float32x4_t bias_v = vdupq_n_f32(0.0f);
+                        for (size_t qg = 0; qg < num_quant_groups; ++qg) {
+                            float32x4_t qs[QGROUP / 4];
+                            float32x4_t amax_v = vdupq_n_f32(0.0f);
+                            for (size_t i = 0; i < QGROUP / VECTOR_WIDTH; ++i) {
+                                const size_t d = qg * QGROUP + i * VECTOR_WIDTH;
+                                const float16x8_t qf = vld1q_f16(q_vec + d);
+                                const float16x8_t sf = vld1q_f16(k_scale + d);
+                                const float16x8_t mf = vld1q_f16(k_min + d);
+                                const float32x4_t q_lo = vcvt_f32_f16(vget_low_f16(qf));
+                                const float32x4_t q_hi = vcvt_f32_f16(vget_high_f16(qf));
+                                qs[2 * i] = vmulq_f32(q_lo, vcvt_f32_f16(vget_low_f16(sf)));
+                                qs[2 * i + 1] = vmulq_f32(q_hi, vcvt_f32_f16(vget_high_f16(sf)));
+                                bias_v = vfmaq_f32(bias_v, q_lo, vcvt_f32_f16(vget_low_f16(mf)));
+                                bias_v = vfmaq_f32(bias_v, q_hi, vcvt_f32_f16(vget_high_f16(mf)));
+                                amax_v = vmaxq_f32(amax_v, vmaxq_f32(vabsq_f32(qs[2 * i]), vabsq_f32(qs[2 * i + 1])));
+                            }
+                            const float amax = vmaxvq_f32(amax_v);
+                            q_scales[qg] = amax / 127.0f;
+                            const float inv = amax > 0.0f ? 127.0f / amax : 0.0f;
+                            for (size_t i = 0; i < QGROUP / VECTOR_WIDTH; ++i) {
+                                const int32x4_t lo_i = vcvtaq_s32_f32(vmulq_n_f32(qs[2 * i], inv));
+                                const int32x4_t hi_i = vcvtaq_s32_f32(vmulq_n_f32(qs[2 * i + 1], inv));
+                                vst1_s8(q_int8 + qg * QGROUP + i * VECTOR_WIDTH,
+                                        vqmovn_s16(vcombine_s16(vqmovn_s32(lo_i), vqmovn_s32(hi_i))));
+                            }
+                        }
+                        const float bias = vaddvq_f32(bias_v);
+
+                        for (; kv_pos < packed_end; ++kv_pos) {
+                            const uint8_t* row = codes + (kv_pos - kv_block_start) * code_bytes;
+                            float32x4_t sumv = vdupq_n_f32(0.0f);
+                            for (size_t qg = 0; qg < num_quant_groups; ++qg) {
+                                int8x16_t k_lo, k_hi;
+                                unpacker.unpack(row + qg * GROUP_BYTES, k_lo, k_hi);
+                                int32x4_t dot_acc = vdupq_n_s32(0);
+                                dot_acc = vdotq_s32(dot_acc, vld1q_s8(q_int8 + qg * QGROUP), k_lo);
+                                dot_acc = vdotq_s32(dot_acc, vld1q_s8(q_int8 + qg * QGROUP + 16), k_hi);
+                                sumv = vmlaq_n_f32(sumv, vcvtq_f32_s32(dot_acc), q_scales[qg]);
+                            }
+                            const float score = (vaddvq_f32(sumv) + bias) * scale;
+                            block_scores[kv_pos - kv_block_start] = score;
+                            block_max = std::max(block_max, score);
+                        }
+                    }
+
+                    for (; kv_pos < kv_block_end; ++kv_pos) {
+                        const __fp16* k_vec = kv_pos < cache_len
+                            ? key_residual + (kv_pos - packed_len) * kv_seq_stride + kv_head_idx * head_dim
+                            : keys_new + (kv_pos - cache_len) * kv_seq_stride + kv_head_idx * head_dim;
+                        const float score = lowbit_dot_f16(q_vec, k_vec, head_dim) * scale;
+                        block_scores[kv_pos - kv_block_start] = score;
+                        block_max = std::max(block_max, score);
+                    }
+
+                    if (block_max > -std::numeric_limits<float>::infinity()) {
+                        const float scale_correction = expf(running_max - block_max);
+                        running_sum *= scale_correction;
+                        for (size_t i = 0; i < num_accum_slots; ++i) {
+                            output_accum_low[i] = vmulq_n_f32(output_accum_low[i], scale_correction);
+                            output_accum_high[i] = vmulq_n_f32(output_accum_high[i], scale_correction);
+                        }
+                        for (size_t qg = 0; qg < num_quant_groups; ++qg) group_bias[qg] *= scale_correction;
+                        running_max = block_max;
+                    }
+
+                    float block_sum = 0.0f;
+                    for (size_t kv_idx = 0; kv_idx < block_size; ++kv_idx) {
+                        if (block_scores[kv_idx] != -std::numeric_limits<float>::infinity()) {
+                            block_scores[kv_idx] = expf(block_scores[kv_idx] - block_max);
+                            block_sum += block_scores[kv_idx];
+                        } else {
+                            block_scores[kv_idx] = 0.0f;
+                        }
+                    }
+
+                    for (size_t i = 0; i < num_accum_slots; ++i)
+                        block_accum[i] = vdupq_n_f16((__fp16)0.0f);
+
+                    for (size_t kv_idx = 0; kv_idx < block_size; ++kv_idx) {
+                        const float attn_weight = block_scores[kv_idx];
+                        if (attn_weight == 0.0f) continue;
+                        const size_t kv = kv_block_start + kv_idx;
+
+                        if (kv < cache_len) {
+                            const uint8_t* row = value_rows + kv * value_row_bytes + kv_head_idx * value_head_bytes;
+                            const __fp16* v_scale = reinterpret_cast<const __fp16*>(row + code_bytes);
+                            const __fp16* v_min = v_scale + num_quant_groups;
+                            for (size_t qg = 0; qg < num_quant_groups; ++qg) {
+                                int8x16_t v_lo, v_hi;
+                                unpacker.unpack(row + qg * GROUP_BYTES, v_lo, v_hi);
+                                const float16x8_t ws = vdupq_n_f16(static_cast<__fp16>(attn_weight * static_cast<float>(v_scale[qg])));
+                                float16x8_t* acc = block_accum + qg * (QGROUP / VECTOR_WIDTH);
+                                acc[0] = vfmaq_f16(acc[0], vcvtq_f16_s16(vmovl_s8(vget_low_s8(v_lo))), ws);
+                                acc[1] = vfmaq_f16(acc[1], vcvtq_f16_s16(vmovl_s8(vget_high_s8(v_lo))), ws);
+                                acc[2] = vfmaq_f16(acc[2], vcvtq_f16_s16(vmovl_s8(vget_low_s8(v_hi))), ws);
+                                acc[3] = vfmaq_f16(acc[3], vcvtq_f16_s16(vmovl_s8(vget_high_s8(v_hi))), ws);
+                                group_bias[qg] += attn_weight * static_cast<float>(v_min[qg]);
+                            }
+                        } else {
+                            const __fp16* v_vec = values_new + (kv - cache_len) * kv_seq_stride + kv_head_idx * head_dim;
+                            const float16x8_t w_vec = vdupq_n_f16(static_cast<__fp16>(attn_weight));
+                            for (size_t i = 0; i < num_accum_slots; ++i) {
+                                block_accum[i] = vfmaq_f16(block_accum[i], vld1q_f16(v_vec + i * VECTOR_WIDTH), w_vec);
+                            }
+                        }
+                    }
+
+                    for (size_t i = 0; i < num_accum_slots; ++i) {
+                        output_accum_low[i] = vaddq_f32(output_accum_low[i], vcvt_f32_f16(vget_low_f16(block_accum[i])));
+                        output_accum_high[i] = vaddq_f32(output_accum_high[i], vcvt_f32_f16(vget_high_f16(block_accum[i])));
+                    }
+                    running_sum += block_sum;
+                }
+
+                if (running_sum > 0.0f) {
+                    const float inv_sum = 1.0f / running_sum;
+                    for (size_t i = 0; i < num_accum_slots; ++i) {
+                        const float32x4_t bias = vdupq_n_f32(group_bias[i * VECTOR_WIDTH / QGROUP]);
+                        vst1q_f16(o_vec + i * VECTOR_WIDTH, vcombine_f16(
+                            vcvt_f16_f32(vmulq_n_f32(vaddq_f32(output_accum_low[i], bias), inv_sum)),
+                            vcvt_f16_f32(vmulq_n_f32(vaddq_f32(output_accum_high[i], bias), inv_sum))));
+                    }
+                } else {
+                    memset(o_vec, 0, head_dim * sizeof(__fp16));
+                }
+            }
+        });
+}
+
+void cactus_attention_hybrid_lowbit_fp16(
+    const __fp16* queries,
+    const uint8_t* key_blocks,
+    const __fp16* key_residual,
+    const uint8_t* value_rows,
+    const __fp16* keys_new,
+    const __fp16* values_new,
+    __fp16* output,
+    size_t seq_len,
+    size_t cache_len,
+    size_t packed_len,
+    size_t new_len,
+    size_t num_q_heads,
+    size_t num_kv_heads,
+    size_t head_dim,
+    size_t bits,
+    float scale,
+    size_t position_offset,
+    bool is_causal,
+    size_t window_size
+) {
+    auto* run = bits == 2 ? &cactus_attention_hybrid_lowbit_impl<2> : &cactus_attention_hybrid_lowbit_impl<4>;
+    run(queries, key_blocks, key_residual, value_rows, keys_new, values_new, output,
+        seq_len, cache_len, packed_len, new_len, num_q_heads, num_kv_heads, head_dim,
+        scale, position_offset, is_causal, window_size);
+}
+
+void cactus_kv_block_scores_f16(
+    const __fp16* queries,
+    const __fp16* summaries,
+    float* scores,
+    size_t num_blocks,
+    size_t num_q_heads,
+    size_t num_kv_heads,
+    size_t head_dim
+) {
+    const size_t group = num_q_heads / num_kv_heads;
+    const size_t block_stride = num_kv_heads * 2 * head_dim;
+    CactusThreading::parallel_for(num_blocks, CactusThreading::Thresholds::ELEMENT_WISE,
+        [=](size_t start, size_t end) {
+            for (size_t b = start; b < end; ++b) {
+                float best = -std::numeric_limits<float>::infinity();
+                for (size_t h = 0; h < num_q_heads; ++h) {
+                    const __fp16* q = queries + h * head_dim;
+                    const __fp16* lo = summaries + b * block_stride + (h / group) * 2 * head_dim;
+                    const __fp16* hi = lo + head_dim;
+                    float32x4_t acc = vdupq_n_f32(0.0f);
+                    size_t d = 0;
+                    for (; d + 4 <= head_dim; d += 4) {
+                        const float32x4_t qv = vcvt_f32_f16(vld1_f16(q + d));
+                        acc = vaddq_f32(acc, vmaxq_f32(vmulq_f32(qv, vcvt_f32_f16(vld1_f16(lo + d))),
+                                                       vmulq_f32(qv, vcvt_f32_f16(vld1_f16(hi + d)))));
+                    }
+                    float bound = vaddvq_f32(acc);
+                    for (; d < head_dim; ++d) {
+                        bound += std::max(static_cast<float>(q[d]) * lo[d], static_cast<float>(q[d]) * hi[d]);
+                    }
+                    best = std::max(best, bound);
+                }
+                scores[b] = best;
+            }
+        });
+}
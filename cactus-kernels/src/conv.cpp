@@ -6,6 +6,9 @@
 #include <cstdint>
 #include <cstring>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <tuple>
 #include <vector>
 #include <cstddef>
 #include <iostream>
@@ -14,6 +17,10 @@
 #include <Accelerate/Accelerate.h>
 #endif
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 constexpr size_t T_TILE_F16 = 2;
 #ifdef __APPLE__
 constexpr size_t ACCELERATE_K_THRESHOLD = 32;
@@ -784,6 +791,119 @@ void cactus_bilinear_interpolation_f16(const __fp16* input, __fp16* output, size
     }
 }
 
+static bool stft_weight_is_dft_basis(
+    const __fp16* weight, size_t K, size_t num_fft_bins, size_t n_fft, float& imag_sign) {
+
+    if (n_fft < K || n_fft < 2 || n_fft / 2 + 1 != num_fft_bins) return false;
+
+    std::vector<float> cos_table(n_fft), sin_table(n_fft);
+    for (size_t i = 0; i < n_fft; ++i) {
+        const double angle = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(n_fft);
+        cos_table[i] = static_cast<float>(std::cos(angle));
+        sin_table[i] = static_cast<float>(std::sin(angle));
+    }
+
+    float max_window = 0.0f;
+    for (size_t k = 0; k < K; ++k) max_window = std::max(max_window, std::abs((float)weight[k]));
+    const float tol = 2e-3f * std::max(max_window, 1e-6f);
+
+    imag_sign = 0.0f;
+    for (size_t bin = 0; bin < num_fft_bins; ++bin) {
+        const __fp16* Wr = weight + bin * K;
+        const __fp16* Wi = weight + (bin + num_fft_bins) * K;
+        for (size_t k = 0; k < K; ++k) {
+            const float w = (float)weight[k];
+            const size_t idx = (bin * k) % n_fft;
+            if (std::abs((float)Wr[k] - w * cos_table[idx]) > tol) return false;
+            const float s = w * sin_table[idx];
+            const float wi = (float)Wi[k];
+            if (imag_sign == 0.0f && std::abs(s) > tol) imag_sign = wi * s < 0.0f ? 1.0f : -1.0f;
+            if (std::abs(wi + (imag_sign == 0.0f ? 1.0f : imag_sign) * s) > tol) return false;
+        }
+    }
+    if (imag_sign == 0.0f) imag_sign = 1.0f;
+    return true;
+}
+
+// The basis check scans the whole weight, so its verdict is kept per weight pointer and shape. The
+// window row is folded into the key as well, so a buffer reused at the same address for different
+// weights is checked again.
+static bool stft_weight_is_dft_basis_cached(
+    const __fp16* weight, size_t K, size_t num_fft_bins, size_t n_fft, float& imag_sign) {
+
+    uint64_t window_hash = 1469598103934665603ULL;
+    for (size_t k = 0; k < K; ++k) {
+        uint16_t bits;
+        std::memcpy(&bits, weight + k, sizeof(bits));
+        window_hash = (window_hash ^ bits) * 1099511628211ULL;
+    }
+    using Key = std::tuple<const __fp16*, size_t, size_t, size_t, uint64_t>;
+    static std::mutex verdicts_mutex;
+    static std::map<Key, std::pair<bool, float>> verdicts;
+    const Key key{weight, K, num_fft_bins, n_fft, window_hash};
+    {
+        std::lock_guard<std::mutex> lock(verdicts_mutex);
+        auto it = verdicts.find(key);
+        if (it != verdicts.end()) {
+            imag_sign = it->second.second;
+            return it->second.first;
+        }
+    }
+
+    const bool is_basis = stft_weight_is_dft_basis(weight, K, num_fft_bins, n_fft, imag_sign);
+    std::lock_guard<std::mutex> lock(verdicts_mutex);
+    if (verdicts.size() >= 64) verdicts.clear();
+    verdicts[key] = {is_basis, imag_sign};
+    return is_basis;
+}
+
+static void stft_f16_fft(
+    const __fp16* input, const __fp16* weight, __fp16* output,
+    size_t N, size_t L, size_t K, size_t stride,
+    size_t num_fft_bins, size_t n_fft, float imag_sign) {
+
+    const size_t out_len = ((L - K) / stride) + 1;
+    const size_t out_bs = 2 * num_fft_bins * out_len;
+    const size_t spec_stride = 2 * num_fft_bins;
+
+    std::vector<float> window(K);
+    for (size_t k = 0; k < K; ++k) window[k] = (float)weight[k];
+    std::vector<float> frames(out_len * n_fft, 0.0f);
+    std::vector<float> spectrum(out_len * spec_stride);
+
+    for (size_t n = 0; n < N; ++n) {
+        const __fp16* Xb = input + n * L;
+
+        CactusThreading::parallel_for(out_len, CactusThreading::Thresholds::SCALAR_EXPENSIVE, [&](size_t start, size_t end) {
+            for (size_t t = start; t < end; ++t) {
+                const __fp16* x = Xb + t * stride;
+                float* frame = frames.data() + t * n_fft;
+                size_t k = 0;
+                for (; k + 8 <= K; k += 8) {
+                    const float16x8_t xv = vld1q_f16(x + k);
+                    vst1q_f32(frame + k, vmulq_f32(vcvt_f32_f16(vget_low_f16(xv)), vld1q_f32(window.data() + k)));
+                    vst1q_f32(frame + k + 4, vmulq_f32(vcvt_f32_f16(vget_high_f16(xv)), vld1q_f32(window.data() + k + 4)));
+                }
+                for (; k < K; ++k) frame[k] = (float)x[k] * window[k];
+            }
+        });
+
+        cactus_rfft_f32_batch(frames.data(), n_fft, spectrum.data(), spec_stride, n_fft, out_len, "backward");
+
+        __fp16* out_re = output + n * out_bs;
+        __fp16* out_im = out_re + num_fft_bins * out_len;
+        CactusThreading::parallel_for(num_fft_bins, CactusThreading::Thresholds::ELEMENT_WISE, [&](size_t start, size_t end) {
+            for (size_t bin = start; bin < end; ++bin) {
+                for (size_t t = 0; t < out_len; ++t) {
+                    const float* spec = spectrum.data() + t * spec_stride + bin * 2;
+                    out_re[bin * out_len + t] = (__fp16)spec[0];
+                    out_im[bin * out_len + t] = (__fp16)(imag_sign * spec[1]);
+                }
+            }
+        });
+    }
+}
+
 void cactus_stft_f16(
     const __fp16* input,
     const __fp16* weight,
@@ -797,6 +917,16 @@ void cactus_stft_f16(
     const size_t in_bs  = C_in * L;
     const size_t out_bs = 2 * num_fft_bins * out_len;
 
+    if (C_in == 1 && out_len > 1 && num_fft_bins > 1) {
+        float imag_sign = 1.0f;
+        for (size_t n_fft : {2 * (num_fft_bins - 1), 2 * num_fft_bins - 1}) {
+            if (stft_weight_is_dft_basis_cached(weight, K, num_fft_bins, n_fft, imag_sign)) {
+                stft_f16_fft(input, weight, output, N, L, K, stride, num_fft_bins, n_fft, imag_sign);
+                return;
+            }
+        }
+    }
+
     for (size_t n = 0; n < N; ++n) {
         const __fp16* Xb = input + n * in_bs;
 
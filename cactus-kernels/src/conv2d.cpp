@@ -4,7 +4,12 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
 #ifdef __APPLE__
@@ -502,10 +507,9 @@ void cactus_conv2d_f16_k3s1p1_nchw(
     size_t C_in, size_t H, size_t W,
     size_t C_out
 ) {
+#ifdef __APPLE__
     const size_t H_out = H;
     const size_t W_out = W;
-
-#ifdef __APPLE__
     const size_t col_K = C_in * 9;
     std::vector<float> W_f32(C_out * col_K);
     conv2d_k3_weights_to_f32(weight, W_f32.data(), C_out, C_in);
@@ -555,34 +559,411 @@ void cactus_conv2d_f16_k3s1p1_nchw(
     }
 
 #else
-    const size_t total_compute = N * C_out * H_out * W_out * C_in * 9;
-    CactusThreading::ParallelConfig cfg =
-        (total_compute < 100000) ? CactusThreading::ParallelConfig{SIZE_MAX, SIZE_MAX}
-                                 : CactusThreading::Thresholds::ATTENTION;
+    cactus_conv2d_f16(input, weight, bias, output, N, C_in, H, W, C_out, 3, 3, 1, 1, 1, 1, false, false);
+#endif
+}
 
-    CactusThreading::parallel_for_2d(N, C_out, cfg, [&](size_t n, size_t oc) {
-        const float b0 = bias ? static_cast<float>(bias[oc]) : 0.0f;
-        for (size_t oh = 0; oh < H_out; ++oh) {
-            for (size_t ow = 0; ow < W_out; ++ow) {
-                float acc = b0;
-                for (size_t ic = 0; ic < C_in; ++ic) {
-                    for (size_t kh = 0; kh < 3; ++kh) {
-                        for (size_t kw = 0; kw < 3; ++kw) {
-                            const ptrdiff_t ih = static_cast<ptrdiff_t>(oh) + kh - 1;
-                            const ptrdiff_t iw = static_cast<ptrdiff_t>(ow) + kw - 1;
-                            if (ih >= 0 && ih < static_cast<ptrdiff_t>(H) &&
-                                iw >= 0 && iw < static_cast<ptrdiff_t>(W)) {
-                                acc += static_cast<float>(input[((n * C_in + ic) * H + ih) * W + iw]) *
-                                       static_cast<float>(weight[((oc * C_in + ic) * 3 + kh) * 3 + kw]);
+namespace {
+
+// Winograd F(4x4, 3x3): a 6x6 input tile yields a 4x4 output tile with 36 multiplies per channel
+// pair instead of 144. Transforms are applied to four channels at a time, so activations are kept
+// channels-last with C padded to a multiple of four.
+constexpr size_t kWinogradTile = 4;
+constexpr size_t kWinogradInput = 6;
+constexpr size_t kWinogradPoints = kWinogradInput * kWinogradInput;
+constexpr size_t kWinogradTileBlock = 16;
+constexpr size_t kIm2colTileRows = 64;
+
+inline size_t round_up4(size_t x) { return (x + 3) & ~size_t(3); }
+
+// B^T d for one column of six values.
+inline void winograd_input_1d(const float32x4_t* d, float32x4_t* r) {
+    r[0] = vaddq_f32(vfmsq_f32(vmulq_n_f32(d[0], 4.0f), d[2], vdupq_n_f32(5.0f)), d[4]);
+    const float32x4_t t1 = vfmsq_f32(vaddq_f32(d[3], d[4]), vaddq_f32(d[1], d[2]), vdupq_n_f32(4.0f));
+    const float32x4_t t2 = vfmaq_f32(vsubq_f32(d[4], d[3]), vsubq_f32(d[1], d[2]), vdupq_n_f32(4.0f));
+    r[1] = t1;
+    r[2] = t2;
+    const float32x4_t d13 = vsubq_f32(d[3], d[1]);
+    const float32x4_t d42 = vsubq_f32(d[4], d[2]);
+    r[3] = vfmaq_f32(d42, d13, vdupq_n_f32(2.0f));
+    r[4] = vfmsq_f32(d42, d13, vdupq_n_f32(2.0f));
+    r[5] = vaddq_f32(vfmsq_f32(vmulq_n_f32(d[1], 4.0f), d[3], vdupq_n_f32(5.0f)), d[5]);
+}
+
+// A^T m for one column of six values.
+inline void winograd_output_1d(const float32x4_t* m, float32x4_t* y) {
+    const float32x4_t s12 = vaddq_f32(m[1], m[2]);
+    const float32x4_t d12 = vsubq_f32(m[1], m[2]);
+    const float32x4_t s34 = vaddq_f32(m[3], m[4]);
+    const float32x4_t d34 = vsubq_f32(m[3], m[4]);
+    y[0] = vaddq_f32(vaddq_f32(m[0], s12), s34);
+    y[1] = vfmaq_f32(d12, d34, vdupq_n_f32(2.0f));
+    y[2] = vfmaq_f32(s12, s34, vdupq_n_f32(4.0f));
+    y[3] = vaddq_f32(vfmaq_f32(d12, d34, vdupq_n_f32(8.0f)), m[5]);
+}
+
+// G g G^T for every (ic, oc) pair, stored as [36][C_in4][C_out4] so each point is a plain GEMM operand.
+void winograd_transform_weights(const __fp16* weight, float* U, size_t C_in, size_t C_out, size_t C_in4, size_t C_out4) {
+    std::fill(U, U + kWinogradPoints * C_in4 * C_out4, 0.0f);
+    CactusThreading::parallel_for(C_out, CactusThreading::Thresholds::AXIS_REDUCE, [&](size_t oc_start, size_t oc_end) {
+        for (size_t oc = oc_start; oc < oc_end; ++oc) {
+            for (size_t ic = 0; ic < C_in; ++ic) {
+                const __fp16* g = weight + (oc * C_in + ic) * 9;
+                float tmp[kWinogradInput][3];
+                for (size_t c = 0; c < 3; ++c) {
+                    const float g0 = static_cast<float>(g[0 * 3 + c]);
+                    const float g1 = static_cast<float>(g[1 * 3 + c]);
+                    const float g2 = static_cast<float>(g[2 * 3 + c]);
+                    tmp[0][c] = g0 / 4.0f;
+                    tmp[1][c] = -(g0 + g1 + g2) / 6.0f;
+                    tmp[2][c] = -(g0 - g1 + g2) / 6.0f;
+                    tmp[3][c] = g0 / 24.0f + g1 / 12.0f + g2 / 6.0f;
+                    tmp[4][c] = g0 / 24.0f - g1 / 12.0f + g2 / 6.0f;
+                    tmp[5][c] = g2;
+                }
+                for (size_t r = 0; r < kWinogradInput; ++r) {
+                    const float g0 = tmp[r][0], g1 = tmp[r][1], g2 = tmp[r][2];
+                    const float row[kWinogradInput] = {
+                        g0 / 4.0f,
+                        -(g0 + g1 + g2) / 6.0f,
+                        -(g0 - g1 + g2) / 6.0f,
+                        g0 / 24.0f + g1 / 12.0f + g2 / 6.0f,
+                        g0 / 24.0f - g1 / 12.0f + g2 / 6.0f,
+                        g2,
+                    };
+                    for (size_t c = 0; c < kWinogradInput; ++c) {
+                        U[((r * kWinogradInput + c) * C_in4 + ic) * C_out4 + oc] = row[c];
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Transformed weights depend only on the weight tensor, so repeated inference over a layer reuses
+// them. Entries are keyed by pointer and shape plus a sampled fingerprint, so a buffer refilled in
+// place is transformed again.
+constexpr size_t kWinogradWeightCacheBytes = 128u << 20;
+
+std::shared_ptr<const std::vector<float>> winograd_cached_weights(
+    const __fp16* weight, size_t C_in, size_t C_out, size_t C_in4, size_t C_out4) {
+    const size_t count = C_out * C_in * 9;
+    const size_t step = std::max<size_t>(1, count / 64);
+    uint64_t fingerprint = 1469598103934665603ULL;
+    for (size_t i = 0; i < count; i += step) {
+        uint16_t bits;
+        std::memcpy(&bits, weight + i, sizeof(bits));
+        fingerprint = (fingerprint ^ bits) * 1099511628211ULL;
+    }
+
+    using Key = std::tuple<const __fp16*, size_t, size_t, uint64_t>;
+    static std::mutex cache_mutex;
+    static std::map<Key, std::shared_ptr<const std::vector<float>>> cache;
+    static size_t cached_bytes = 0;
+    const Key key{weight, C_in, C_out, fingerprint};
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end()) return it->second;
+    }
+
+    auto U = std::make_shared<std::vector<float>>(kWinogradPoints * C_in4 * C_out4);
+    winograd_transform_weights(weight, U->data(), C_in, C_out, C_in4, C_out4);
+    const size_t bytes = U->size() * sizeof(float);
+    if (bytes > kWinogradWeightCacheBytes) return U;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (cached_bytes + bytes > kWinogradWeightCacheBytes) {
+        cache.clear();
+        cached_bytes = 0;
+    }
+    auto inserted = cache.emplace(key, U);
+    if (inserted.second) cached_bytes += bytes;
+    return inserted.first->second;
+}
+
+inline float32x4_t load_channels4(const __fp16* src, size_t valid) {
+    if (valid >= 4) return vcvt_f32_f16(vld1_f16(src));
+    float tmp[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < valid; ++i) tmp[i] = static_cast<float>(src[i]);
+    return vld1q_f32(tmp);
+}
+
+struct Conv2dScratch {
+    std::vector<float> V, M;
+    std::vector<__fp16> col, tile_out;
+};
+
+thread_local Conv2dScratch g_conv2d_scratch;
+
+// Stride-1, dilation-1 3x3 convolution over a channels-last input into a channels-last output.
+void conv2d_winograd_f43_nhwc(
+    const __fp16* input, const __fp16* weight, const __fp16* bias, __fp16* output,
+    size_t N, size_t H, size_t W, size_t C_in, size_t C_out, size_t pad, size_t H_out, size_t W_out) {
+    const size_t C_in4 = round_up4(C_in);
+    const size_t C_out4 = round_up4(C_out);
+    const auto U = winograd_cached_weights(weight, C_in, C_out, C_in4, C_out4);
+
+    const size_t tiles_h = (H_out + kWinogradTile - 1) / kWinogradTile;
+    const size_t tiles_w = (W_out + kWinogradTile - 1) / kWinogradTile;
+    const size_t tiles = N * tiles_h * tiles_w;
+    const size_t blocks = (tiles + kWinogradTileBlock - 1) / kWinogradTileBlock;
+    static constexpr CactusThreading::ParallelConfig WINOGRAD_BLOCKS{2, 1};
+
+    CactusThreading::parallel_for(blocks, WINOGRAD_BLOCKS, [&](size_t block_start, size_t block_end) {
+        auto& ws = g_conv2d_scratch;
+        if (ws.V.size() < kWinogradPoints * kWinogradTileBlock * C_in4) ws.V.resize(kWinogradPoints * kWinogradTileBlock * C_in4);
+        if (ws.M.size() < kWinogradPoints * kWinogradTileBlock * C_out4) ws.M.resize(kWinogradPoints * kWinogradTileBlock * C_out4);
+        float* V = ws.V.data();
+        float* M = ws.M.data();
+
+        for (size_t block = block_start; block < block_end; ++block) {
+            const size_t tile0 = block * kWinogradTileBlock;
+            const size_t count = std::min(kWinogradTileBlock, tiles - tile0);
+
+            for (size_t t = 0; t < count; ++t) {
+                const size_t tile = tile0 + t;
+                const size_t n = tile / (tiles_h * tiles_w);
+                const size_t ty = (tile / tiles_w) % tiles_h;
+                const size_t tx = tile % tiles_w;
+                const ptrdiff_t iy0 = static_cast<ptrdiff_t>(ty * kWinogradTile) - static_cast<ptrdiff_t>(pad);
+                const ptrdiff_t ix0 = static_cast<ptrdiff_t>(tx * kWinogradTile) - static_cast<ptrdiff_t>(pad);
+
+                for (size_t c = 0; c < C_in4; c += 4) {
+                    const size_t valid = std::min<size_t>(4, C_in - c);
+                    float32x4_t d[kWinogradInput][kWinogradInput];
+                    for (size_t i = 0; i < kWinogradInput; ++i) {
+                        const ptrdiff_t iy = iy0 + static_cast<ptrdiff_t>(i);
+                        for (size_t j = 0; j < kWinogradInput; ++j) {
+                            const ptrdiff_t ix = ix0 + static_cast<ptrdiff_t>(j);
+                            d[i][j] = (iy < 0 || iy >= static_cast<ptrdiff_t>(H) || ix < 0 || ix >= static_cast<ptrdiff_t>(W))
+                                ? vdupq_n_f32(0.0f)
+                                : load_channels4(input + ((n * H + iy) * W + ix) * C_in + c, valid);
+                        }
+                    }
+                    float32x4_t rows[kWinogradInput][kWinogradInput];
+                    for (size_t j = 0; j < kWinogradInput; ++j) {
+                        float32x4_t col[kWinogradInput], out[kWinogradInput];
+                        for (size_t i = 0; i < kWinogradInput; ++i) col[i] = d[i][j];
+                        winograd_input_1d(col, out);
+                        for (size_t i = 0; i < kWinogradInput; ++i) rows[i][j] = out[i];
+                    }
+                    for (size_t i = 0; i < kWinogradInput; ++i) {
+                        float32x4_t out[kWinogradInput];
+                        winograd_input_1d(rows[i], out);
+                        for (size_t j = 0; j < kWinogradInput; ++j) {
+                            vst1q_f32(V + ((i * kWinogradInput + j) * kWinogradTileBlock + t) * C_in4 + c, out[j]);
+                        }
+                    }
+                }
+            }
+
+            // 36 independent [count x C_in4] x [C_in4 x C_out4] products.
+            for (size_t p = 0; p < kWinogradPoints; ++p) {
+                const float* Vp = V + p * kWinogradTileBlock * C_in4;
+                const float* Up = U->data() + p * C_in4 * C_out4;
+                float* Mp = M + p * kWinogradTileBlock * C_out4;
+                for (size_t t = 0; t < count; t += 4) {
+                    const size_t rows = std::min<size_t>(4, count - t);
+                    for (size_t oc = 0; oc < C_out4; oc += 4) {
+                        float32x4_t acc[4] = {vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f)};
+                        for (size_t ic = 0; ic < C_in4; ++ic) {
+                            const float32x4_t u = vld1q_f32(Up + ic * C_out4 + oc);
+                            for (size_t r = 0; r < rows; ++r) acc[r] = vfmaq_n_f32(acc[r], u, Vp[(t + r) * C_in4 + ic]);
+                        }
+                        for (size_t r = 0; r < rows; ++r) vst1q_f32(Mp + (t + r) * C_out4 + oc, acc[r]);
+                    }
+                }
+            }
+
+            for (size_t t = 0; t < count; ++t) {
+                const size_t tile = tile0 + t;
+                const size_t n = tile / (tiles_h * tiles_w);
+                const size_t ty = (tile / tiles_w) % tiles_h;
+                const size_t tx = tile % tiles_w;
+                for (size_t oc = 0; oc < C_out4; oc += 4) {
+                    float32x4_t m[kWinogradInput][kWinogradInput];
+                    for (size_t i = 0; i < kWinogradInput; ++i)
+                        for (size_t j = 0; j < kWinogradInput; ++j)
+                            m[i][j] = vld1q_f32(M + ((i * kWinogradInput + j) * kWinogradTileBlock + t) * C_out4 + oc);
+                    float32x4_t rows[kWinogradTile][kWinogradInput];
+                    for (size_t j = 0; j < kWinogradInput; ++j) {
+                        float32x4_t col[kWinogradInput], out[kWinogradTile];
+                        for (size_t i = 0; i < kWinogradInput; ++i) col[i] = m[i][j];
+                        winograd_output_1d(col, out);
+                        for (size_t i = 0; i < kWinogradTile; ++i) rows[i][j] = out[i];
+                    }
+                    const size_t valid = std::min<size_t>(4, C_out - oc);
+                    float b[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                    for (size_t i = 0; bias && i < valid; ++i) b[i] = static_cast<float>(bias[oc + i]);
+                    const float32x4_t b4 = vld1q_f32(b);
+                    for (size_t i = 0; i < kWinogradTile; ++i) {
+                        const size_t oy = ty * kWinogradTile + i;
+                        if (oy >= H_out) break;
+                        float32x4_t y[kWinogradTile];
+                        winograd_output_1d(rows[i], y);
+                        for (size_t j = 0; j < kWinogradTile; ++j) {
+                            const size_t ox = tx * kWinogradTile + j;
+                            if (ox >= W_out) break;
+                            __fp16* dst = output + ((n * H_out + oy) * W_out + ox) * C_out + oc;
+                            const float16x4_t h = vcvt_f16_f32(vaddq_f32(y[j], b4));
+                            if (valid == 4) {
+                                vst1_f16(dst, h);
+                            } else {
+                                __fp16 lanes[4];
+                                vst1_f16(lanes, h);
+                                for (size_t v = 0; v < valid; ++v) dst[v] = lanes[v];
                             }
                         }
                     }
                 }
-                output[((n * C_out + oc) * H_out + oh) * W_out + ow] = static_cast<__fp16>(acc);
             }
         }
     });
-#endif
+}
+
+// General (stride, padding, dilation, groups) convolution: each worker packs a tile of output pixels
+// into im2col rows ordered (kh, kw, ic), which is contiguous in a channels-last input, and runs the
+// FP16 GEMM against the weights repacked to the same order.
+void conv2d_im2col_nhwc(
+    const __fp16* input, const __fp16* weight, const __fp16* bias, __fp16* output,
+    size_t N, size_t H, size_t W, size_t C_in, size_t C_out, size_t KH, size_t KW,
+    size_t stride, size_t pad, size_t dilation, size_t groups, size_t H_out, size_t W_out) {
+    const size_t cig = C_in / groups;
+    const size_t cog = C_out / groups;
+    const size_t col_k = KH * KW * cig;
+
+    std::vector<__fp16> packed_w(C_out * col_k);
+    for (size_t oc = 0; oc < C_out; ++oc)
+        for (size_t ic = 0; ic < cig; ++ic)
+            for (size_t kh = 0; kh < KH; ++kh)
+                for (size_t kw = 0; kw < KW; ++kw)
+                    packed_w[oc * col_k + (kh * KW + kw) * cig + ic] = weight[((oc * cig + ic) * KH + kh) * KW + kw];
+
+    // 1x1 stride-1 convolutions read their GEMM rows straight from the input.
+    const bool pointwise = KH == 1 && KW == 1 && stride == 1 && pad == 0 && groups == 1;
+    const size_t pixels = N * H_out * W_out;
+    const size_t row_tiles = (pixels + kIm2colTileRows - 1) / kIm2colTileRows;
+    static constexpr CactusThreading::ParallelConfig IM2COL_TILES{2, 1};
+
+    CactusThreading::parallel_for(row_tiles * groups, IM2COL_TILES, [&](size_t start, size_t end) {
+        auto& ws = g_conv2d_scratch;
+        if (ws.col.size() < kIm2colTileRows * col_k) ws.col.resize(kIm2colTileRows * col_k);
+        if (ws.tile_out.size() < kIm2colTileRows * cog) ws.tile_out.resize(kIm2colTileRows * cog);
+
+        for (size_t item = start; item < end; ++item) {
+            const size_t g = item % groups;
+            const size_t p0 = (item / groups) * kIm2colTileRows;
+            const size_t rows = std::min(kIm2colTileRows, pixels - p0);
+
+            for (size_t r = 0; r < rows && !pointwise; ++r) {
+                const size_t p = p0 + r;
+                const size_t n = p / (H_out * W_out);
+                const size_t oy = (p / W_out) % H_out;
+                const size_t ox = p % W_out;
+                __fp16* dst = ws.col.data() + r * col_k;
+                for (size_t kh = 0; kh < KH; ++kh) {
+                    const ptrdiff_t iy = static_cast<ptrdiff_t>(oy * stride + kh * dilation) - static_cast<ptrdiff_t>(pad);
+                    for (size_t kw = 0; kw < KW; ++kw, dst += cig) {
+                        const ptrdiff_t ix = static_cast<ptrdiff_t>(ox * stride + kw * dilation) - static_cast<ptrdiff_t>(pad);
+                        if (iy < 0 || iy >= static_cast<ptrdiff_t>(H) || ix < 0 || ix >= static_cast<ptrdiff_t>(W)) {
+                            std::memset(dst, 0, cig * sizeof(__fp16));
+                        } else {
+                            std::memcpy(dst, input + ((n * H + iy) * W + ix) * C_in + g * cig, cig * sizeof(__fp16));
+                        }
+                    }
+                }
+            }
+
+            __fp16* out_rows = output + p0 * C_out + g * cog;
+            __fp16* gemm_out = groups == 1 ? out_rows : ws.tile_out.data();
+            const __fp16* gemm_in = pointwise ? input + p0 * C_in : ws.col.data();
+            cactus_matmul_f16(gemm_in, packed_w.data() + g * cog * col_k, gemm_out, rows, col_k, cog);
+            if (groups == 1 && !bias) continue;
+            for (size_t r = 0; r < rows; ++r) {
+                const __fp16* src = gemm_out + r * cog;
+                __fp16* dst = out_rows + r * C_out;
+                for (size_t oc = 0; oc < cog; ++oc) {
+                    const float b = bias ? static_cast<float>(bias[g * cog + oc]) : 0.0f;
+                    dst[oc] = static_cast<__fp16>(static_cast<float>(src[oc]) + b);
+                }
+            }
+        }
+    });
+}
+
+// [N, C, H, W] <-> [N, H, W, C]
+void transpose_nchw_to_nhwc(const __fp16* src, __fp16* dst, size_t N, size_t C, size_t H, size_t W) {
+    CactusThreading::parallel_for(N * H, CactusThreading::Thresholds::AXIS_REDUCE, [&](size_t start, size_t end) {
+        for (size_t nh = start; nh < end; ++nh) {
+            const size_t n = nh / H, h = nh % H;
+            for (size_t w = 0; w < W; ++w) {
+                __fp16* d = dst + (nh * W + w) * C;
+                for (size_t c = 0; c < C; ++c) d[c] = src[((n * C + c) * H + h) * W + w];
+            }
+        }
+    });
+}
+
+void transpose_nhwc_to_nchw(const __fp16* src, __fp16* dst, size_t N, size_t C, size_t H, size_t W) {
+    CactusThreading::parallel_for(N * C, CactusThreading::Thresholds::AXIS_REDUCE, [&](size_t start, size_t end) {
+        for (size_t nc = start; nc < end; ++nc) {
+            const size_t n = nc / C, c = nc % C;
+            __fp16* d = dst + nc * H * W;
+            for (size_t hw = 0; hw < H * W; ++hw) d[hw] = src[(n * H * W + hw) * C + c];
+        }
+    });
+}
+
+bool conv2d_winograd_enabled() {
+    const char* env = std::getenv("CACTUS_CONV2D_WINOGRAD");
+    return env == nullptr || std::atoi(env) != 0;
+}
+
+} // namespace
+
+void cactus_conv2d_f16(
+    const __fp16* input,
+    const __fp16* weight,
+    const __fp16* bias,
+    __fp16* output,
+    size_t N,
+    size_t C_in, size_t H, size_t W,
+    size_t C_out,
+    size_t kernel_h, size_t kernel_w,
+    size_t stride, size_t padding, size_t dilation, size_t groups,
+    bool nhwc_input, bool nhwc_output
+) {
+    if (N == 0 || stride == 0 || dilation == 0 || groups == 0 || C_in % groups != 0 || C_out % groups != 0) return;
+    const size_t span_h = dilation * (kernel_h - 1) + 1;
+    const size_t span_w = dilation * (kernel_w - 1) + 1;
+    if (H + 2 * padding < span_h || W + 2 * padding < span_w) return;
+    const size_t H_out = (H + 2 * padding - span_h) / stride + 1;
+    const size_t W_out = (W + 2 * padding - span_w) / stride + 1;
+
+    std::vector<__fp16> nhwc_in, nhwc_out;
+    const __fp16* x = input;
+    if (!nhwc_input) {
+        nhwc_in.resize(N * H * W * C_in);
+        transpose_nchw_to_nhwc(input, nhwc_in.data(), N, C_in, H, W);
+        x = nhwc_in.data();
+    }
+    __fp16* y = output;
+    if (!nhwc_output) {
+        nhwc_out.resize(N * H_out * W_out * C_out);
+        y = nhwc_out.data();
+    }
+
+    const bool winograd = groups == 1 && kernel_h == 3 && kernel_w == 3 && stride == 1 && dilation == 1 &&
+                          C_in >= 8 && C_out >= 8 && conv2d_winograd_enabled();
+    if (winograd) {
+        conv2d_winograd_f43_nhwc(x, weight, bias, y, N, H, W, C_in, C_out, padding, H_out, W_out);
+    } else {
+        conv2d_im2col_nhwc(x, weight, bias, y, N, H, W, C_in, C_out, kernel_h, kernel_w,
+                           stride, padding, dilation, groups, H_out, W_out);
+    }
+
+    if (!nhwc_output) transpose_nhwc_to_nchw(y, output, N, C_out, H_out, W_out);
 }
 
 void cactus_maxpool1d_f16(
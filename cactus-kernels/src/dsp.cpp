@@ -8,6 +8,9 @@
 #include <limits>
 #include <random>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
@@ -17,35 +20,10 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-static size_t bit_reverse(size_t x, size_t log2n) {
-    size_t result = 0;
-    for (size_t i = 0; i < log2n; i++) {
-        result = (result << 1) | (x & 1);
-        x >>= 1;
-    }
-    return result;
-}
-
 static bool is_power_of_two(size_t n) {
     return n != 0 && (n & (n - 1)) == 0;
 }
 
-static size_t log2_power_of_two(size_t n) {
-    size_t log2n = 0;
-    for (size_t temp = n; temp > 1; temp >>= 1) {
-        log2n++;
-    }
-    return log2n;
-}
-
-static size_t next_power_of_two(size_t n) {
-    size_t padded_n = 1;
-    while (padded_n < n) {
-        padded_n <<= 1;
-    }
-    return padded_n;
-}
-
 enum class FFTNorm { BACKWARD, FORWARD, ORTHO };
 
 static FFTNorm parse_fft_norm(const char* norm) {
@@ -61,77 +39,376 @@ static float fft_norm_factor(size_t n, FFTNorm norm_mode, bool inverse) {
     return inverse ? (1.0f / static_cast<float>(n)) : 1.0f;
 }
 
-static void ensure_irfft_scratch(std::vector<float>& re, std::vector<float>& im, size_t n) {
-    if (re.size() < n) re.resize(n);
-    if (im.size() < n) im.resize(n);
+struct FFTStage {
+    size_t radix;
+    size_t l;
+    size_t m;
+    std::vector<float> tw_re;
+    std::vector<float> tw_im;
+    std::vector<float> root_re;
+    std::vector<float> root_im;
+};
+
+struct FFTPlan {
+    size_t n;
+    size_t complex_n;
+    bool packed_real;
+    std::vector<FFTStage> stages;
+    std::vector<float> split_re;
+    std::vector<float> split_im;
+};
+
+static std::vector<size_t> factor_fft_size(size_t n) {
+    std::vector<size_t> radices;
+    while (n % 4 == 0) { radices.push_back(4); n /= 4; }
+    while (n % 2 == 0) { radices.push_back(2); n /= 2; }
+    for (size_t p : {size_t{3}, size_t{5}}) {
+        while (n % p == 0) { radices.push_back(p); n /= p; }
+    }
+    for (size_t p = 7; n > 1; p += 2) {
+        while (n % p == 0) { radices.push_back(p); n /= p; }
+    }
+    return radices;
 }
 
-static void fft_radix2(float* re, float* im, size_t n, bool inverse) {
-    if (!is_power_of_two(n)) return;
-    const size_t log2n = log2_power_of_two(n);
+static std::unique_ptr<FFTPlan> build_fft_plan(size_t n) {
+    auto plan = std::make_unique<FFTPlan>();
+    plan->n = n;
+    plan->packed_real = n >= 2 && n % 2 == 0;
+    plan->complex_n = plan->packed_real ? n / 2 : n;
+
+    const double two_pi = 2.0 * M_PI;
+    size_t m = 1;
+    for (size_t radix : factor_fft_size(plan->complex_n)) {
+        FFTStage stage;
+        stage.radix = radix;
+        stage.m = m;
+        stage.l = plan->complex_n / (m * radix);
+        stage.tw_re.resize(stage.l * radix);
+        stage.tw_im.resize(stage.l * radix);
+        for (size_t j = 0; j < stage.l; j++) {
+            for (size_t r = 0; r < radix; r++) {
+                const double angle = -two_pi * static_cast<double>(j * r) / static_cast<double>(radix * stage.l);
+                stage.tw_re[j * radix + r] = static_cast<float>(std::cos(angle));
+                stage.tw_im[j * radix + r] = static_cast<float>(std::sin(angle));
+            }
+        }
+        if (radix > 5) {
+            stage.root_re.resize(radix);
+            stage.root_im.resize(radix);
+            for (size_t t = 0; t < radix; t++) {
+                const double angle = -two_pi * static_cast<double>(t) / static_cast<double>(radix);
+                stage.root_re[t] = static_cast<float>(std::cos(angle));
+                stage.root_im[t] = static_cast<float>(std::sin(angle));
+            }
+        }
+        plan->stages.push_back(std::move(stage));
+        m *= radix;
+    }
 
-    for (size_t i = 0; i < n; i++) {
-        size_t j = bit_reverse(i, log2n);
-        if (i < j) {
-            std::swap(re[i], re[j]);
-            std::swap(im[i], im[j]);
+    if (plan->packed_real) {
+        const size_t half = plan->complex_n;
+        plan->split_re.resize(half + 1);
+        plan->split_im.resize(half + 1);
+        for (size_t k = 0; k <= half; k++) {
+            const double angle = -two_pi * static_cast<double>(k) / static_cast<double>(n);
+            plan->split_re[k] = static_cast<float>(std::cos(angle));
+            plan->split_im[k] = static_cast<float>(std::sin(angle));
         }
     }
+    return plan;
+}
+
+static const FFTPlan& get_fft_plan(size_t n) {
+    thread_local const FFTPlan* last_plan = nullptr;
+    if (last_plan && last_plan->n == n) return *last_plan;
+
+    static std::mutex plans_mutex;
+    static std::unordered_map<size_t, std::unique_ptr<FFTPlan>> plans;
+    std::lock_guard<std::mutex> lock(plans_mutex);
+    auto& slot = plans[n];
+    if (!slot) slot = build_fft_plan(n);
+    last_plan = slot.get();
+    return *last_plan;
+}
+
+template <typename T> static inline T lane_load(const float* p);
+template <> inline float lane_load<float>(const float* p) { return *p; }
+template <> inline float32x4_t lane_load<float32x4_t>(const float* p) { return vld1q_f32(p); }
+
+template <typename T> static inline T lane_splat(float x);
+template <> inline float lane_splat<float>(float x) { return x; }
+template <> inline float32x4_t lane_splat<float32x4_t>(float x) { return vdupq_n_f32(x); }
+
+static inline void lane_store(float* p, float v) { *p = v; }
+static inline void lane_store(float* p, float32x4_t v) { vst1q_f32(p, v); }
+
+template <typename T>
+static inline void butterfly_radix2(T* re, T* im) {
+    const T r0 = re[0] + re[1], i0 = im[0] + im[1];
+    re[1] = re[0] - re[1];
+    im[1] = im[0] - im[1];
+    re[0] = r0;
+    im[0] = i0;
+}
 
-    for (size_t s = 1; s <= log2n; s++) {
-        size_t m = size_t{1} << s;
-        size_t m2 = m >> 1;
-        float w_re = 1.0f;
-        float w_im = 0.0f;
-        const float angle = static_cast<float>(M_PI) / static_cast<float>(m2);
-        const float wm_re = std::cos(angle);
-        const float wm_im = inverse ? std::sin(angle) : -std::sin(angle);
-
-        for (size_t j = 0; j < m2; j++) {
-            for (size_t k = j; k < n; k += m) {
-                size_t k_m2 = k + m2;
-                float t_re = w_re * re[k_m2] - w_im * im[k_m2];
-                float t_im = w_re * im[k_m2] + w_im * re[k_m2];
-                float u_re = re[k];
-                float u_im = im[k];
-                re[k] = u_re + t_re;
-                im[k] = u_im + t_im;
-                re[k_m2] = u_re - t_re;
-                im[k_m2] = u_im - t_im;
+template <typename T>
+static inline void butterfly_radix3(T* re, T* im) {
+    const T half = lane_splat<T>(0.5f);
+    const T sin60 = lane_splat<T>(0.866025403784438647f);
+    const T tr = re[1] + re[2], ti = im[1] + im[2];
+    const T dr = re[1] - re[2], di = im[1] - im[2];
+    const T mr = re[0] - half * tr, mi = im[0] - half * ti;
+    re[0] = re[0] + tr;
+    im[0] = im[0] + ti;
+    re[1] = mr + sin60 * di;
+    im[1] = mi - sin60 * dr;
+    re[2] = mr - sin60 * di;
+    im[2] = mi + sin60 * dr;
+}
+
+template <typename T>
+static inline void butterfly_radix4(T* re, T* im) {
+    const T t0r = re[0] + re[2], t0i = im[0] + im[2];
+    const T t1r = re[0] - re[2], t1i = im[0] - im[2];
+    const T t2r = re[1] + re[3], t2i = im[1] + im[3];
+    const T t3r = re[1] - re[3], t3i = im[1] - im[3];
+    re[0] = t0r + t2r;
+    im[0] = t0i + t2i;
+    re[2] = t0r - t2r;
+    im[2] = t0i - t2i;
+    re[1] = t1r + t3i;
+    im[1] = t1i - t3r;
+    re[3] = t1r - t3i;
+    im[3] = t1i + t3r;
+}
+
+template <typename T>
+static inline void butterfly_radix5(T* re, T* im) {
+    const T c1 = lane_splat<T>(0.309016994374947424f);
+    const T c2 = lane_splat<T>(-0.809016994374947424f);
+    const T s1 = lane_splat<T>(0.951056516295153572f);
+    const T s2 = lane_splat<T>(0.587785252292473129f);
+    const T t1r = re[1] + re[4], t1i = im[1] + im[4];
+    const T t2r = re[2] + re[3], t2i = im[2] + im[3];
+    const T d1r = re[1] - re[4], d1i = im[1] - im[4];
+    const T d2r = re[2] - re[3], d2i = im[2] - im[3];
+    const T m1r = re[0] + c1 * t1r + c2 * t2r, m1i = im[0] + c1 * t1i + c2 * t2i;
+    const T m2r = re[0] + c2 * t1r + c1 * t2r, m2i = im[0] + c2 * t1i + c1 * t2i;
+    const T n1r = s1 * d1r + s2 * d2r, n1i = s1 * d1i + s2 * d2i;
+    const T n2r = s2 * d1r - s1 * d2r, n2i = s2 * d1i - s1 * d2i;
+    re[0] = re[0] + t1r + t2r;
+    im[0] = im[0] + t1i + t2i;
+    re[1] = m1r + n1i;
+    im[1] = m1i - n1r;
+    re[4] = m1r - n1i;
+    im[4] = m1i + n1r;
+    re[2] = m2r + n2i;
+    im[2] = m2i - n2r;
+    re[3] = m2r - n2i;
+    im[3] = m2i + n2r;
+}
+
+template <typename T, size_t Radix>
+static inline void fft_stage_block(
+    const FFTStage& stage, const float* xr, const float* xi, float* yr, float* yi, size_t j, size_t k) {
+
+    const size_t m = stage.m;
+    const size_t lm = stage.l * m;
+    const size_t in = k + j * m;
+    T re[Radix], im[Radix];
+    for (size_t q = 0; q < Radix; q++) {
+        re[q] = lane_load<T>(xr + in + q * lm);
+        im[q] = lane_load<T>(xi + in + q * lm);
+    }
+
+    if constexpr (Radix == 2) butterfly_radix2(re, im);
+    else if constexpr (Radix == 3) butterfly_radix3(re, im);
+    else if constexpr (Radix == 4) butterfly_radix4(re, im);
+    else butterfly_radix5(re, im);
+
+    const size_t out = k + Radix * j * m;
+    lane_store(yr + out, re[0]);
+    lane_store(yi + out, im[0]);
+    const float* tw_re = stage.tw_re.data() + j * Radix;
+    const float* tw_im = stage.tw_im.data() + j * Radix;
+    for (size_t r = 1; r < Radix; r++) {
+        const T wr = lane_splat<T>(tw_re[r]);
+        const T wi = lane_splat<T>(tw_im[r]);
+        lane_store(yr + out + r * m, re[r] * wr - im[r] * wi);
+        lane_store(yi + out + r * m, re[r] * wi + im[r] * wr);
+    }
+}
+
+template <size_t Radix>
+static void fft_stage_fixed(const FFTStage& stage, const float* xr, const float* xi, float* yr, float* yi) {
+    const size_t m = stage.m;
+    const size_t vec_m = m - m % 4;
+    for (size_t j = 0; j < stage.l; j++) {
+        size_t k = 0;
+        for (; k < vec_m; k += 4) fft_stage_block<float32x4_t, Radix>(stage, xr, xi, yr, yi, j, k);
+        for (; k < m; k++) fft_stage_block<float, Radix>(stage, xr, xi, yr, yi, j, k);
+    }
+}
+
+static void fft_stage_generic(const FFTStage& stage, const float* xr, const float* xi, float* yr, float* yi) {
+    const size_t p = stage.radix;
+    const size_t m = stage.m;
+    const size_t lm = stage.l * m;
+    std::vector<float> are(p), aim(p);
+
+    for (size_t j = 0; j < stage.l; j++) {
+        for (size_t k = 0; k < m; k++) {
+            const size_t in = k + j * m;
+            for (size_t q = 0; q < p; q++) {
+                are[q] = xr[in + q * lm];
+                aim[q] = xi[in + q * lm];
+            }
+            const size_t out = k + p * j * m;
+            for (size_t r = 0; r < p; r++) {
+                float br = 0.0f, bi = 0.0f;
+                for (size_t q = 0; q < p; q++) {
+                    const size_t t = (q * r) % p;
+                    br += are[q] * stage.root_re[t] - aim[q] * stage.root_im[t];
+                    bi += are[q] * stage.root_im[t] + aim[q] * stage.root_re[t];
+                }
+                const float wr = stage.tw_re[j * p + r];
+                const float wi = stage.tw_im[j * p + r];
+                yr[out + r * m] = br * wr - bi * wi;
+                yi[out + r * m] = br * wi + bi * wr;
             }
-            float new_w_re = w_re * wm_re - w_im * wm_im;
-            float new_w_im = w_re * wm_im + w_im * wm_re;
-            w_re = new_w_re;
-            w_im = new_w_im;
         }
     }
 }
 
-static void idft_r_f32_1d_dft(
-    const float* input, float* output, const size_t n, const float norm_factor) {
-    const size_t in_len = n / 2 + 1;
-    const float two_pi_over_n = (2.0f * static_cast<float>(M_PI)) / static_cast<float>(n);
-    for (size_t t = 0; t < n; ++t) {
-        float sum = input[0];
-        for (size_t k = 1; k < in_len; ++k) {
-            const float re = input[k * 2];
-            const float im = input[k * 2 + 1];
-            const float a = two_pi_over_n * static_cast<float>(k * t);
-            const float c = std::cos(a);
-            const float s = std::sin(a);
-            const bool self_conjugate = (k * 2 == n);
-            if (self_conjugate) {
-                sum += re * c;
-            } else {
-                sum += 2.0f * (re * c - im * s);
-            }
+static void fft_complex_forward(const FFTPlan& plan, float* re, float* im, float* scratch_re, float* scratch_im) {
+    float* xr = re;
+    float* xi = im;
+    float* yr = scratch_re;
+    float* yi = scratch_im;
+    for (const FFTStage& stage : plan.stages) {
+        switch (stage.radix) {
+            case 2: fft_stage_fixed<2>(stage, xr, xi, yr, yi); break;
+            case 3: fft_stage_fixed<3>(stage, xr, xi, yr, yi); break;
+            case 4: fft_stage_fixed<4>(stage, xr, xi, yr, yi); break;
+            case 5: fft_stage_fixed<5>(stage, xr, xi, yr, yi); break;
+            default: fft_stage_generic(stage, xr, xi, yr, yi); break;
         }
-        output[t] = sum * norm_factor;
+        std::swap(xr, yr);
+        std::swap(xi, yi);
+    }
+    if (xr != re) {
+        std::copy(xr, xr + plan.complex_n, re);
+        std::copy(xi, xi + plan.complex_n, im);
+    }
+}
+
+struct FFTScratch {
+    std::vector<float> re, im, scratch_re, scratch_im;
+
+    void ensure(size_t n) {
+        if (re.size() < n) {
+            re.resize(n);
+            im.resize(n);
+            scratch_re.resize(n);
+            scratch_im.resize(n);
+        }
+    }
+};
+
+static FFTScratch& fft_scratch() {
+    thread_local FFTScratch scratch;
+    return scratch;
+}
+
+static void rfft_planned(const FFTPlan& plan, const float* input, float* output, float norm_factor) {
+    FFTScratch& s = fft_scratch();
+    s.ensure(plan.complex_n);
+    float* re = s.re.data();
+    float* im = s.im.data();
+    const size_t n = plan.n;
+
+    if (!plan.packed_real) {
+        std::copy(input, input + n, re);
+        std::fill(im, im + n, 0.0f);
+        fft_complex_forward(plan, re, im, s.scratch_re.data(), s.scratch_im.data());
+        for (size_t k = 0; k <= n / 2; k++) {
+            output[k * 2] = re[k] * norm_factor;
+            output[k * 2 + 1] = im[k] * norm_factor;
+        }
+        return;
+    }
+
+    const size_t half = plan.complex_n;
+    for (size_t k = 0; k < half; k++) {
+        re[k] = input[2 * k];
+        im[k] = input[2 * k + 1];
+    }
+    fft_complex_forward(plan, re, im, s.scratch_re.data(), s.scratch_im.data());
+
+    const float scale = 0.5f * norm_factor;
+    for (size_t k = 0; k <= half; k++) {
+        const size_t a = k == half ? 0 : k;
+        const size_t b = k == 0 ? 0 : half - k;
+        const float zr = re[a], zi = im[a];
+        const float cr = re[b], ci = -im[b];
+        const float er = zr + cr, ei = zi + ci;
+        const float dr = zr - cr, di = zi - ci;
+        const float odd_r = di, odd_i = -dr;
+        const float wr = plan.split_re[k], wi = plan.split_im[k];
+        output[k * 2] = (er + odd_r * wr - odd_i * wi) * scale;
+        output[k * 2 + 1] = (ei + odd_r * wi + odd_i * wr) * scale;
+    }
+}
+
+static void irfft_planned(const FFTPlan& plan, const float* input, float* output, float norm_factor) {
+    FFTScratch& s = fft_scratch();
+    s.ensure(plan.complex_n);
+    float* re = s.re.data();
+    float* im = s.im.data();
+    const size_t n = plan.n;
+
+    if (!plan.packed_real) {
+        const size_t in_len = n / 2 + 1;
+        for (size_t k = 0; k < in_len; k++) {
+            re[k] = input[k * 2];
+            im[k] = -input[k * 2 + 1];
+        }
+        im[0] = 0.0f;
+        for (size_t k = 1; k < in_len; k++) {
+            re[n - k] = re[k];
+            im[n - k] = -im[k];
+        }
+        fft_complex_forward(plan, re, im, s.scratch_re.data(), s.scratch_im.data());
+        for (size_t t = 0; t < n; t++) output[t] = re[t] * norm_factor;
+        return;
+    }
+
+    const size_t half = plan.complex_n;
+    for (size_t k = 0; k < half; k++) {
+        const float xr = input[k * 2];
+        const float xi = k == 0 ? 0.0f : input[k * 2 + 1];
+        const size_t b = half - k;
+        const float yr = input[b * 2];
+        const float yi = b == half ? 0.0f : -input[b * 2 + 1];
+        const float er = xr + yr, ei = xi + yi;
+        const float dr = xr - yr, di = xi - yi;
+        const float wr = plan.split_re[k], wi = -plan.split_im[k];
+        const float or_ = dr * wr - di * wi;
+        const float oi = dr * wi + di * wr;
+        re[k] = er - oi;
+        im[k] = -(ei + or_);
+    }
+    fft_complex_forward(plan, re, im, s.scratch_re.data(), s.scratch_im.data());
+
+    const float scale = norm_factor;
+    for (size_t k = 0; k < half; k++) {
+        output[2 * k] = re[k] * scale;
+        output[2 * k + 1] = -im[k] * scale;
     }
 }
 
 void cactus_rfft_f32_1d(const float* input, float* output, size_t n, const char* norm) {
-    const size_t out_len = n / 2 + 1;
     const FFTNorm norm_mode = parse_fft_norm(norm);
     const float norm_factor = fft_norm_factor(n, norm_mode, false);
 
@@ -142,42 +419,30 @@ void cactus_rfft_f32_1d(const float* input, float* output, size_t n, const char*
     }
 
 #ifdef __APPLE__
-    {
+    if (is_power_of_two(n)) {
         size_t log2n = 0;
-        size_t padded_n = 1;
-        while (padded_n < n) {
-            padded_n <<= 1;
-            log2n++;
-        }
+        for (size_t temp = n; temp > 1; temp >>= 1) log2n++;
 
         FFTSetup fft_setup = vDSP_create_fftsetup(log2n, FFT_RADIX2);
         if (fft_setup) {
-            std::vector<float> buffer(padded_n, 0.0f);
-            std::copy(input, input + n, buffer.begin());
-
+            const size_t out_len = n / 2 + 1;
             DSPSplitComplex split;
-            std::vector<float> real_part(padded_n / 2);
-            std::vector<float> imag_part(padded_n / 2);
+            std::vector<float> real_part(n / 2);
+            std::vector<float> imag_part(n / 2);
             split.realp = real_part.data();
             split.imagp = imag_part.data();
 
-            vDSP_ctoz(reinterpret_cast<const DSPComplex*>(buffer.data()), 2, &split, 1, padded_n / 2);
+            vDSP_ctoz(reinterpret_cast<const DSPComplex*>(input), 2, &split, 1, n / 2);
             vDSP_fft_zrip(fft_setup, &split, 1, log2n, FFT_FORWARD);
 
             float scale = 0.5f * norm_factor;
 
             output[0] = split.realp[0] * scale;
             output[1] = 0.0f;
+            output[(n / 2) * 2] = split.imagp[0] * scale;
+            output[(n / 2) * 2 + 1] = 0.0f;
 
-            if (out_len > 1) {
-                size_t nyquist_idx = padded_n / 2;
-                if (nyquist_idx < out_len) {
-                    output[nyquist_idx * 2] = split.imagp[0] * scale;
-                    output[nyquist_idx * 2 + 1] = 0.0f;
-                }
-            }
-
-            for (size_t i = 1; i < out_len && i < padded_n / 2; i++) {
+            for (size_t i = 1; i < out_len - 1; i++) {
                 output[i * 2] = split.realp[i] * scale;
                 output[i * 2 + 1] = split.imagp[i] * scale;
             }
@@ -188,19 +453,10 @@ void cactus_rfft_f32_1d(const float* input, float* output, size_t n, const char*
     }
 #endif
 
-    const size_t padded_n = next_power_of_two(n);
-    std::vector<float> re(padded_n, 0.0f), im(padded_n, 0.0f);
-    std::copy(input, input + n, re.begin());
-    fft_radix2(re.data(), im.data(), padded_n, false);
-
-    for (size_t i = 0; i < out_len; i++) {
-        output[i * 2] = re[i] * norm_factor;
-        output[i * 2 + 1] = im[i] * norm_factor;
-    }
+    rfft_planned(get_fft_plan(n), input, output, norm_factor);
 }
 
 void cactus_irfft_f32_1d(const float* input, float* output, size_t n, const char* norm) {
-    const size_t in_len = n / 2 + 1;
     const FFTNorm norm_mode = parse_fft_norm(norm);
     const float norm_factor = fft_norm_factor(n, norm_mode, true);
 
@@ -209,43 +465,31 @@ void cactus_irfft_f32_1d(const float* input, float* output, size_t n, const char
         return;
     }
 
-    if (!is_power_of_two(n)) {
-        idft_r_f32_1d_dft(input, output, n, norm_factor);
-        return;
-    }
-
-    const size_t padded_n = next_power_of_two(n);
-    const size_t padded_half_plus_one = padded_n / 2 + 1;
-    thread_local std::vector<float> re_scratch;
-    thread_local std::vector<float> im_scratch;
-    ensure_irfft_scratch(re_scratch, im_scratch, padded_n);
-    std::fill(re_scratch.begin(), re_scratch.begin() + padded_n, 0.0f);
-    std::fill(im_scratch.begin(), im_scratch.begin() + padded_n, 0.0f);
-    float* re = re_scratch.data();
-    float* im = im_scratch.data();
-    for (size_t i = 0; i < in_len; ++i) {
-        re[i] = input[i * 2];
-        im[i] = input[i * 2 + 1];
-    }
-
-    im[0] = 0.0f;
-    const bool has_padded_nyquist_bin = in_len == padded_half_plus_one;
-    if (has_padded_nyquist_bin) {
-        im[padded_n / 2] = 0.0f;
-    }
+    irfft_planned(get_fft_plan(n), input, output, norm_factor);
+}
 
-    const size_t mirror_limit = has_padded_nyquist_bin ? (in_len - 1) : in_len;
-    for (size_t i = 1; i < mirror_limit; ++i) {
-        const size_t mirrored = padded_n - i;
-        re[mirrored] = re[i];
-        im[mirrored] = -im[i];
-    }
+void cactus_rfft_f32_batch(
+    const float* input, size_t input_stride,
+    float* output, size_t output_stride,
+    size_t n, size_t num_frames, const char* norm) {
 
-    fft_radix2(re, im, padded_n, true);
+    if (num_frames == 0) return;
+    const FFTNorm norm_mode = parse_fft_norm(norm);
+    const float norm_factor = fft_norm_factor(n, norm_mode, false);
+    const FFTPlan& plan = get_fft_plan(n);
 
-    for (size_t i = 0; i < n; ++i) {
-        output[i] = re[i] * norm_factor;
-    }
+    CactusThreading::parallel_for(num_frames, CactusThreading::Thresholds::SCALAR_EXPENSIVE, [&](size_t start_frame, size_t end_frame) {
+        for (size_t f = start_frame; f < end_frame; f++) {
+            const float* frame = input + f * input_stride;
+            float* out = output + f * output_stride;
+            if (n == 1) {
+                out[0] = frame[0] * norm_factor;
+                out[1] = 0.0f;
+                continue;
+            }
+            rfft_planned(plan, frame, out, norm_factor);
+        }
+    });
 }
 
 float cactus_hertz_to_mel(float freq, const char* mel_scale) {
@@ -401,6 +645,143 @@ void cactus_spectrogram_to_db(
     }
 }
 
+static void fill_periodic_hann_window(std::vector<float>& window, size_t frame_length) {
+    const size_t length = frame_length + 1;
+    window.resize(frame_length);
+    for (size_t i = 0; i < frame_length; i++) {
+        window[i] = 0.5f * (1.0f - std::cos(2.0f * static_cast<float>(M_PI) * i / (length - 1)));
+    }
+}
+
+static void apply_window_f32(float* buffer, const float* window, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(buffer + i, vmulq_f32(vld1q_f32(buffer + i), vld1q_f32(window + i)));
+    }
+    for (; i < n; i++) buffer[i] *= window[i];
+}
+
+struct SpectrogramFrameParams {
+    const float* window;
+    size_t frame_length;
+    size_t fft_length;
+    size_t num_frequency_bins;
+    float power;
+    float dither;
+    const float* preemphasis;
+    bool remove_dc_offset;
+};
+
+static void compute_power_spectrum_frame(
+    const SpectrogramFrameParams& p,
+    const float* frame, size_t available_length,
+    float* fft_buffer, float* fft_complex, float* power_out) {
+
+    std::fill(fft_buffer, fft_buffer + p.fft_length, 0.0f);
+    std::copy(frame, frame + available_length, fft_buffer);
+
+    if (p.dither != 0.0f) {
+        thread_local std::mt19937 rng(std::random_device{}());
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        for (size_t i = 0; i < p.frame_length; i++) fft_buffer[i] += p.dither * dist(rng);
+    }
+
+    if (p.remove_dc_offset) {
+        float mean = 0.0f;
+        for (size_t i = 0; i < p.frame_length; i++) mean += fft_buffer[i];
+        mean /= static_cast<float>(p.frame_length);
+        for (size_t i = 0; i < p.frame_length; i++) fft_buffer[i] -= mean;
+    }
+
+    if (p.preemphasis != nullptr) {
+        float preemph_coef = *p.preemphasis;
+        for (size_t i = p.frame_length - 1; i > 0; i--) fft_buffer[i] -= preemph_coef * fft_buffer[i - 1];
+        fft_buffer[0] *= (1.0f - preemph_coef);
+    }
+
+    apply_window_f32(fft_buffer, p.window, p.frame_length);
+
+    cactus_rfft_f32_1d(fft_buffer, fft_complex, p.fft_length, "backward");
+
+    for (size_t i = 0; i < p.num_frequency_bins; i++) {
+        float real = fft_complex[i * 2];
+        float imag = fft_complex[i * 2 + 1];
+        float magnitude = std::hypot(real, imag);
+        power_out[i] = std::pow(magnitude, p.power);
+    }
+}
+
+struct MelBand {
+    size_t begin;
+    size_t end;
+};
+
+static std::vector<MelBand> compute_mel_bands(const float* mel_filters, size_t num_mel_bins, size_t num_frequency_bins) {
+    std::vector<MelBand> bands(num_mel_bins, MelBand{0, 0});
+    for (size_t m = 0; m < num_mel_bins; m++) {
+        const float* filter = mel_filters + m * num_frequency_bins;
+        size_t begin = 0;
+        while (begin < num_frequency_bins && filter[begin] == 0.0f) begin++;
+        size_t end = num_frequency_bins;
+        while (end > begin && filter[end - 1] == 0.0f) end--;
+        bands[m] = MelBand{begin, end};
+    }
+    return bands;
+}
+
+static void project_mel_frame(
+    const float* mel_filters, const MelBand* bands, size_t num_mel_bins, size_t num_frequency_bins,
+    const float* power_spectrum, float mel_floor, float* output, size_t output_stride) {
+
+    for (size_t m = 0; m < num_mel_bins; m++) {
+        const float* filter = mel_filters + m * num_frequency_bins;
+        size_t f = bands[m].begin;
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (; f + 4 <= bands[m].end; f += 4) {
+            acc = vfmaq_f32(acc, vld1q_f32(filter + f), vld1q_f32(power_spectrum + f));
+        }
+        float sum = vaddvq_f32(acc);
+        for (; f < bands[m].end; f++) sum += filter[f] * power_spectrum[f];
+        output[m * output_stride] = std::max(mel_floor, sum);
+    }
+}
+
+enum class LogMelMode { NONE, LOG, LOG10, DB };
+
+static LogMelMode parse_log_mel(const char* log_mel, float power) {
+    if (power == 0.0f || log_mel == nullptr) return LogMelMode::NONE;
+    if (std::strcmp(log_mel, "log") == 0) return LogMelMode::LOG;
+    if (std::strcmp(log_mel, "log10") == 0) return LogMelMode::LOG10;
+    if (std::strcmp(log_mel, "dB") == 0) {
+        if (power != 1.0f && power != 2.0f) throw std::invalid_argument("Cannot use log_mel option 'dB' with this power value");
+        return LogMelMode::DB;
+    }
+    throw std::invalid_argument("Unknown log_mel option");
+}
+
+static void apply_log_mel(
+    float* data, size_t size, LogMelMode mode, float power,
+    float reference, float min_value, const float* db_range) {
+
+    switch (mode) {
+        case LogMelMode::NONE:
+            return;
+        case LogMelMode::LOG:
+            CactusThreading::parallel_for(size, CactusThreading::Thresholds::ALL_REDUCE, [&](size_t start, size_t end) {
+                for (size_t i = start; i < end; i++) data[i] = std::log(data[i]);
+            });
+            return;
+        case LogMelMode::LOG10:
+            CactusThreading::parallel_for(size, CactusThreading::Thresholds::ALL_REDUCE, [&](size_t start, size_t end) {
+                for (size_t i = start; i < end; i++) data[i] = std::log10(data[i]);
+            });
+            return;
+        case LogMelMode::DB:
+            cactus_spectrogram_to_db(data, size, reference, min_value, db_range, power == 1.0f ? 20.0f : 10.0f);
+            return;
+    }
+}
+
 void cactus_compute_spectrogram_f32(
     const float* waveform, size_t waveform_length,
     const float* window, size_t window_length,
@@ -426,11 +807,7 @@ void cactus_compute_spectrogram_f32(
     const float* actual_window = window;
 
     if (window == nullptr) {
-        size_t length = frame_length + 1;
-        hann_window.resize(frame_length);
-        for (size_t i = 0; i < frame_length; i++) {
-            hann_window[i] = 0.5f * (1.0f - std::cos(2.0f * static_cast<float>(M_PI) * i / (length - 1)));
-        }
+        fill_periodic_hann_window(hann_window, frame_length);
         actual_window = hann_window.data();
     } else if (window_length != frame_length) {
         throw std::invalid_argument("window length must equal frame_length");
@@ -442,6 +819,8 @@ void cactus_compute_spectrogram_f32(
         throw std::invalid_argument("Cannot compute mel spectrogram with power=0");
     }
 
+    const LogMelMode log_mode = parse_log_mel(log_mel, power);
+
     std::vector<float> padded_waveform;
     const float* input_waveform = waveform;
     size_t input_length = waveform_length;
@@ -470,83 +849,214 @@ void cactus_compute_spectrogram_f32(
 
     const size_t num_mel_bins = mel_filters != nullptr ? mel_filters_size / num_frequency_bins : 0;
     const size_t spectrogram_bins = mel_filters != nullptr ? num_mel_bins : num_frequency_bins;
+    const std::vector<MelBand> mel_bands = mel_filters != nullptr
+        ? compute_mel_bands(mel_filters, num_mel_bins, num_frequency_bins) : std::vector<MelBand>();
 
-    std::vector<float> temp_spectrogram(num_frames * num_frequency_bins);
+    const SpectrogramFrameParams frame_params{
+        actual_window, frame_length, actual_fft_length, num_frequency_bins,
+        power, dither, preemphasis, remove_dc_offset};
 
     CactusThreading::parallel_for(num_frames, CactusThreading::Thresholds::SCALAR_EXPENSIVE, [&](size_t start_frame, size_t end_frame) {
         std::vector<float> local_buffer(actual_fft_length);
         std::vector<float> local_complex(num_frequency_bins * 2);
+        std::vector<float> local_power(num_frequency_bins);
 
         for (size_t frame_idx = start_frame; frame_idx < end_frame; frame_idx++) {
             size_t timestep = frame_idx * hop_length;
-            std::fill(local_buffer.begin(), local_buffer.end(), 0.0f);
-
             size_t available_length = std::min(frame_length, input_length - timestep);
-            std::copy(input_waveform + timestep, input_waveform + timestep + available_length, local_buffer.data());
+            compute_power_spectrum_frame(frame_params, input_waveform + timestep, available_length,
+                                         local_buffer.data(), local_complex.data(), local_power.data());
 
-            if (dither != 0.0f) {
-                thread_local std::mt19937 rng(std::random_device{}());
-                std::normal_distribution<float> dist(0.0f, 1.0f);
-                for (size_t i = 0; i < frame_length; i++) local_buffer[i] += dither * dist(rng);
+            if (mel_filters != nullptr) {
+                project_mel_frame(mel_filters, mel_bands.data(), num_mel_bins, num_frequency_bins,
+                                  local_power.data(), mel_floor, spectrogram + frame_idx, num_frames);
+            } else {
+                for (size_t f = 0; f < num_frequency_bins; f++) {
+                    spectrogram[f * num_frames + frame_idx] = local_power[f];
+                }
             }
+        }
+    });
 
-            if (remove_dc_offset) {
-                float mean = 0.0f;
-                for (size_t i = 0; i < frame_length; i++) mean += local_buffer[i];
-                mean /= static_cast<float>(frame_length);
-                for (size_t i = 0; i < frame_length; i++) local_buffer[i] -= mean;
-            }
+    apply_log_mel(spectrogram, spectrogram_bins * num_frames, log_mode, power, reference, min_value, db_range);
+}
 
-            if (preemphasis != nullptr) {
-                float preemph_coef = *preemphasis;
-                for (size_t i = frame_length - 1; i > 0; i--) local_buffer[i] -= preemph_coef * local_buffer[i - 1];
-                local_buffer[0] *= (1.0f - preemph_coef);
-            }
+struct CactusSpectrogramStream {
+    std::vector<float> window;
+    SpectrogramFrameParams frame_params;
+    size_t hop_length;
+    size_t pad_length;
+    bool reflect_pad;
+    float preemphasis_coef;
+    bool has_preemphasis;
+
+    std::vector<float> mel_filters;
+    std::vector<MelBand> mel_bands;
+    size_t num_mel_bins;
+    float mel_floor;
+    LogMelMode log_mode;
+    float reference;
+    float min_value;
+
+    std::vector<float> head;
+    std::vector<float> tail;
+    std::vector<float> pending;
+    bool left_padded;
+    bool finished;
+};
+
+static size_t spectrogram_stream_ready_frames(const CactusSpectrogramStream* s) {
+    const size_t frame_length = s->frame_params.frame_length;
+    if (s->pending.size() < frame_length) return 0;
+    return 1 + (s->pending.size() - frame_length) / s->hop_length;
+}
 
-            for (size_t i = 0; i < frame_length; i++) local_buffer[i] *= actual_window[i];
+CactusSpectrogramStream* cactus_spectrogram_stream_create(
+    const float* window, size_t window_length,
+    size_t frame_length, size_t hop_length, const size_t* fft_length,
+    float power, bool center, const char* pad_mode,
+    const float* preemphasis,
+    const float* mel_filters, size_t mel_filters_size,
+    float mel_floor, const char* log_mel,
+    float reference, float min_value,
+    bool remove_dc_offset) {
 
-            cactus_rfft_f32_1d(local_buffer.data(), local_complex.data(), actual_fft_length, "backward");
+    const size_t actual_fft_length = fft_length ? *fft_length : frame_length;
+    if (frame_length == 0) throw std::invalid_argument("frame_length must be greater than zero");
+    if (frame_length > actual_fft_length) throw std::invalid_argument("frame_length may not be larger than fft_length");
+    if (hop_length == 0) throw std::invalid_argument("hop_length must be greater than zero");
+    if (hop_length > frame_length) throw std::invalid_argument("hop_length may not be larger than frame_length");
+    if (window != nullptr && window_length != frame_length) throw std::invalid_argument("window length must equal frame_length");
+    if (power == 0.0f && mel_filters != nullptr) throw std::invalid_argument("Cannot compute mel spectrogram with power=0");
 
-            for (size_t i = 0; i < num_frequency_bins; i++) {
-                float real = local_complex[i * 2];
-                float imag = local_complex[i * 2 + 1];
-                float magnitude = std::hypot(real, imag);
-                temp_spectrogram[frame_idx * num_frequency_bins + i] = std::pow(magnitude, power);
-            }
-        }
-    });
+    bool reflect_pad = false;
+    if (center) {
+        if (pad_mode != nullptr && std::strcmp(pad_mode, "reflect") == 0) reflect_pad = true;
+        else if (pad_mode == nullptr || std::strcmp(pad_mode, "constant") != 0) throw std::invalid_argument("Unsupported pad_mode");
+    }
+
+    auto* s = new CactusSpectrogramStream();
+    if (window != nullptr) s->window.assign(window, window + frame_length);
+    else fill_periodic_hann_window(s->window, frame_length);
+
+    s->has_preemphasis = preemphasis != nullptr;
+    s->preemphasis_coef = preemphasis != nullptr ? *preemphasis : 0.0f;
+    s->hop_length = hop_length;
+    s->pad_length = center ? frame_length / 2 : 0;
+    s->reflect_pad = reflect_pad;
+
+    const size_t num_frequency_bins = actual_fft_length / 2 + 1;
+    s->frame_params = SpectrogramFrameParams{
+        s->window.data(), frame_length, actual_fft_length, num_frequency_bins,
+        power, 0.0f, s->has_preemphasis ? &s->preemphasis_coef : nullptr, remove_dc_offset};
 
     if (mel_filters != nullptr) {
-        CactusThreading::parallel_for_2d(num_mel_bins, num_frames, CactusThreading::Thresholds::AXIS_REDUCE, [&](size_t m, size_t t) {
-            float sum = 0.0f;
-            for (size_t f = 0; f < num_frequency_bins; f++) {
-                sum += mel_filters[m * num_frequency_bins + f] * temp_spectrogram[t * num_frequency_bins + f];
-            }
-            spectrogram[m * num_frames + t] = std::max(mel_floor, sum);
-        });
+        s->num_mel_bins = mel_filters_size / num_frequency_bins;
+        s->mel_filters.assign(mel_filters, mel_filters + s->num_mel_bins * num_frequency_bins);
+        s->mel_bands = compute_mel_bands(s->mel_filters.data(), s->num_mel_bins, num_frequency_bins);
     } else {
-        CactusThreading::parallel_for_2d(num_frames, num_frequency_bins, CactusThreading::Thresholds::AXIS_REDUCE, [&](size_t t, size_t f) {
-            spectrogram[f * num_frames + t] = temp_spectrogram[t * num_frequency_bins + f];
-        });
+        s->num_mel_bins = 0;
     }
+    s->mel_floor = mel_floor;
+    s->log_mode = parse_log_mel(log_mel, power);
+    s->reference = reference;
+    s->min_value = min_value;
 
-    if (power != 0.0f && log_mel != nullptr) {
-        const size_t total_elements = spectrogram_bins * num_frames;
+    cactus_spectrogram_stream_reset(s);
+    return s;
+}
 
-        if (std::strcmp(log_mel, "log") == 0) {
-            CactusThreading::parallel_for(total_elements, CactusThreading::Thresholds::ALL_REDUCE, [&](size_t start, size_t end) {
-                for (size_t i = start; i < end; i++) spectrogram[i] = std::log(spectrogram[i]);
-            });
-        } else if (std::strcmp(log_mel, "log10") == 0) {
-            CactusThreading::parallel_for(total_elements, CactusThreading::Thresholds::ALL_REDUCE, [&](size_t start, size_t end) {
-                for (size_t i = start; i < end; i++) spectrogram[i] = std::log10(spectrogram[i]);
-            });
-        } else if (std::strcmp(log_mel, "dB") == 0) {
-            if (power == 1.0f) cactus_spectrogram_to_db(spectrogram, total_elements, reference, min_value, db_range, 20.0f);
-            else if (power == 2.0f) cactus_spectrogram_to_db(spectrogram, total_elements, reference, min_value, db_range, 10.0f);
-            else throw std::invalid_argument("Cannot use log_mel option 'dB' with this power value");
-        } else {
-            throw std::invalid_argument("Unknown log_mel option");
+void cactus_spectrogram_stream_destroy(CactusSpectrogramStream* stream) {
+    delete stream;
+}
+
+void cactus_spectrogram_stream_reset(CactusSpectrogramStream* stream) {
+    stream->head.clear();
+    stream->tail.clear();
+    stream->pending.clear();
+    stream->finished = false;
+    stream->left_padded = !stream->reflect_pad;
+    if (!stream->reflect_pad) stream->pending.assign(stream->pad_length, 0.0f);
+}
+
+size_t cactus_spectrogram_stream_bins(const CactusSpectrogramStream* stream) {
+    return stream->mel_filters.empty() ? stream->frame_params.num_frequency_bins : stream->num_mel_bins;
+}
+
+size_t cactus_spectrogram_stream_push(CactusSpectrogramStream* stream, const float* samples, size_t num_samples) {
+    if (stream->finished) throw std::invalid_argument("spectrogram stream already finished");
+
+    if (stream->reflect_pad) {
+        const size_t keep = stream->pad_length + 1;
+        stream->tail.insert(stream->tail.end(), samples, samples + num_samples);
+        if (stream->tail.size() > keep) {
+            stream->tail.erase(stream->tail.begin(), stream->tail.end() - keep);
+        }
+    }
+
+    if (stream->left_padded) {
+        stream->pending.insert(stream->pending.end(), samples, samples + num_samples);
+    } else {
+        stream->head.insert(stream->head.end(), samples, samples + num_samples);
+        const size_t pad = stream->pad_length;
+        if (stream->head.size() > pad) {
+            stream->pending.resize(pad);
+            for (size_t i = 0; i < pad; i++) stream->pending[i] = stream->head[pad - i];
+            stream->pending.insert(stream->pending.end(), stream->head.begin(), stream->head.end());
+            stream->head.clear();
+            stream->head.shrink_to_fit();
+            stream->left_padded = true;
         }
     }
+
+    return spectrogram_stream_ready_frames(stream);
+}
+
+size_t cactus_spectrogram_stream_finish(CactusSpectrogramStream* stream) {
+    if (stream->finished) return spectrogram_stream_ready_frames(stream);
+    if (!stream->left_padded) {
+        throw std::invalid_argument("reflect padding requires more than frame_length / 2 samples");
+    }
+
+    const size_t pad = stream->pad_length;
+    if (stream->reflect_pad) {
+        for (size_t i = 0; i < pad; i++) stream->pending.push_back(stream->tail[pad - 1 - i]);
+    } else {
+        stream->pending.insert(stream->pending.end(), pad, 0.0f);
+    }
+    stream->finished = true;
+    return spectrogram_stream_ready_frames(stream);
+}
+
+size_t cactus_spectrogram_stream_read(CactusSpectrogramStream* stream, float* output, size_t max_frames) {
+    const size_t num_frames = std::min(max_frames, spectrogram_stream_ready_frames(stream));
+    if (num_frames == 0) return 0;
+
+    const SpectrogramFrameParams& p = stream->frame_params;
+    const size_t bins = cactus_spectrogram_stream_bins(stream);
+    const float* frames = stream->pending.data();
+
+    CactusThreading::parallel_for(num_frames, CactusThreading::Thresholds::SCALAR_EXPENSIVE, [&](size_t start_frame, size_t end_frame) {
+        std::vector<float> local_buffer(p.fft_length);
+        std::vector<float> local_complex(p.num_frequency_bins * 2);
+        std::vector<float> local_power(p.num_frequency_bins);
+
+        for (size_t t = start_frame; t < end_frame; t++) {
+            float* out = output + t * bins;
+            if (stream->mel_filters.empty()) {
+                compute_power_spectrum_frame(p, frames + t * stream->hop_length, p.frame_length,
+                                             local_buffer.data(), local_complex.data(), out);
+                continue;
+            }
+            compute_power_spectrum_frame(p, frames + t * stream->hop_length, p.frame_length,
+                                         local_buffer.data(), local_complex.data(), local_power.data());
+            project_mel_frame(stream->mel_filters.data(), stream->mel_bands.data(), stream->num_mel_bins,
+                              p.num_frequency_bins, local_power.data(), stream->mel_floor, out, 1);
+        }
+    });
+
+    apply_log_mel(output, num_frames * bins, stream->log_mode, p.power, stream->reference, stream->min_value, nullptr);
+
+    stream->pending.erase(stream->pending.begin(), stream->pending.begin() + num_frames * stream->hop_length);
+    return num_frames;
 }
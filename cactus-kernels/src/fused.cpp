@@ -746,6 +746,293 @@ void gated_deltanet_prefill_chunked_f16(
         });
 }
 
+// Two-level chunkwise form of the gated delta rule. Inside a chunk with inclusive cumulative
+// log-gate G_t, the corrections solve (I + A) delta = U - W S0 with A_tj = beta_t e^(G_t - G_j) k_t.k_j,
+// U = (I + A)^-1 diag(beta) V and W = (I + A)^-1 diag(beta e^G) K. Everything except S0 is local to
+// the chunk, so phase 1 builds U, W and the causal q.k mask for many chunks at once; phase 2 only
+// carries the K x V state from chunk to chunk, and does so independently per block of V columns.
+constexpr size_t kDeltaNetVBlock = 16;
+constexpr size_t kDeltaNetSegmentChunks = 64;
+
+struct GatedDeltaParallelScratch {
+    std::vector<float> state;
+    std::vector<float> chunks;
+
+    static size_t chunk_stride(size_t k_dim, size_t v_dim, size_t c_max) {
+        return (c_max * (3 * k_dim + v_dim + c_max) + 4) & ~size_t(3);
+    }
+};
+
+thread_local GatedDeltaParallelScratch g_gated_deltanet_parallel_scratch;
+thread_local std::vector<float> g_gated_deltanet_chunk_gates;
+thread_local std::vector<float> g_gated_deltanet_block_scratch;
+
+inline float dot_f32(const float* a, const float* b, size_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float dot = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < n; ++i) dot += a[i] * b[i];
+    return dot;
+}
+
+inline void axpy_f32(float* dst, const float* src, float c, size_t n) {
+    const float32x4_t c4 = vdupq_n_f32(c);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_f32(dst + i, vfmaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), c4));
+    for (; i < n; ++i) dst[i] += c * src[i];
+}
+
+inline void scale_f32(float* x, float c, size_t n) {
+    const float32x4_t c4 = vdupq_n_f32(c);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_f32(x + i, vmulq_f32(vld1q_f32(x + i), c4));
+    for (; i < n; ++i) x[i] *= c;
+}
+
+// Phase 1 for one (head, chunk): converts the chunk's q/k/v and leaves, row-major with C rows,
+// Qp = diag(e^G) Q, Kt = diag(e^(G_end - G)) K, W, U, the causal mask M_tj = e^(G_t - G_j) q_t.k_j
+// (j <= t) and the chunk's total decay e^G_end in the last slot.
+void gated_deltanet_chunk_prepare(
+    const __fp16* q_data, const __fp16* k_data, const __fp16* v_data,
+    const __fp16* g_data, const __fp16* b_data,
+    size_t batch, size_t v_head, size_t qk_head, size_t t0, size_t C,
+    size_t T, size_t Hq, size_t Hv, size_t K, size_t V, size_t c_max, float* slot) {
+    float* qp = slot;
+    float* kt = qp + c_max * K;
+    float* w = kt + c_max * K;
+    float* u = w + c_max * K;
+    float* m = u + c_max * V;
+    float* p_end = m + c_max * c_max;
+
+    auto& gates = g_gated_deltanet_chunk_gates;
+    if (gates.size() < c_max * (c_max + 2)) gates.resize(c_max * (c_max + 2));
+    float* G = gates.data();
+    float* beta = G + c_max;
+    float* A = beta + c_max;
+
+    float running = 0.0f;
+    for (size_t t = 0; t < C; ++t) {
+        const size_t tok = t0 + t;
+        const size_t qk_base = ((batch * T + tok) * Hq + qk_head) * K;
+        const size_t gb_idx = (batch * T + tok) * Hv + v_head;
+        cactus_fp16_to_fp32(q_data + qk_base, qp + t * K, K);
+        cactus_fp16_to_fp32(k_data + qk_base, kt + t * K, K);
+        cactus_fp16_to_fp32(v_data + ((batch * T + tok) * Hv + v_head) * V, u + t * V, V);
+        const float gate_log = static_cast<float>(g_data[gb_idx]);
+        const float b = static_cast<float>(b_data[gb_idx]);
+        running += std::max(-20.0f, std::min(6.0f, std::isfinite(gate_log) ? gate_log : -20.0f));
+        G[t] = running;
+        beta[t] = std::isfinite(b) ? std::min(1.0f, std::max(0.0f, b)) : 0.0f;
+    }
+
+    for (size_t t = 0; t < C; ++t) {
+        const float* q_row = qp + t * K;
+        const float* k_row = kt + t * K;
+        for (size_t j = 0; j <= t; ++j) {
+            const float decay = std::exp(G[t] - G[j]);
+            m[t * C + j] = decay * dot_f32(q_row, kt + j * K, K);
+            if (j < t) A[t * C + j] = beta[t] * decay * dot_f32(k_row, kt + j * K, K);
+        }
+    }
+
+    // Forward substitution through the unit lower-triangular (I + A).
+    for (size_t t = 0; t < C; ++t) {
+        float* u_row = u + t * V;
+        float* w_row = w + t * K;
+        scale_f32(u_row, beta[t], V);
+        const float wk = beta[t] * std::exp(G[t]);
+        const float* k_row = kt + t * K;
+        for (size_t kd = 0; kd < K; ++kd) w_row[kd] = wk * k_row[kd];
+        for (size_t j = 0; j < t; ++j) {
+            const float a = A[t * C + j];
+            axpy_f32(u_row, u + j * V, -a, V);
+            axpy_f32(w_row, w + j * K, -a, K);
+        }
+    }
+
+    const float g_end = G[C - 1];
+    for (size_t t = 0; t < C; ++t) {
+        scale_f32(qp + t * K, std::exp(G[t]), K);
+        scale_f32(kt + t * K, std::exp(g_end - G[t]), K);
+    }
+    *p_end = std::exp(g_end);
+}
+
+// Phase 2 for one (head, V-column block) over a run of prepared chunks: the only sequential part.
+void gated_deltanet_chunk_recur(
+    const float* slot, size_t C, size_t K, size_t V, size_t c_max,
+    float* state, size_t v0, size_t vb, float scale, __fp16* out, size_t out_row_stride) {
+    const float* qp = slot;
+    const float* kt = qp + c_max * K;
+    const float* w = kt + c_max * K;
+    const float* u = w + c_max * K;
+    const float* m = u + c_max * V;
+    const float p_end = *(m + c_max * c_max);
+
+    auto& scratch = g_gated_deltanet_block_scratch;
+    if (scratch.size() < 2 * c_max * kDeltaNetVBlock) scratch.resize(2 * c_max * kDeltaNetVBlock);
+    float* delta = scratch.data();
+    float* o = delta + c_max * kDeltaNetVBlock;
+
+    if (vb == kDeltaNetVBlock) {
+        // Full block: the 16 columns of delta_t and o_t stay in registers across the K reduction.
+        for (size_t t = 0; t < C; ++t) {
+            const float* w_row = w + t * K;
+            const float* q_row = qp + t * K;
+            const float* u_row = u + t * V + v0;
+            float32x4_t d[4], acc[4];
+            for (int i = 0; i < 4; ++i) {
+                d[i] = vld1q_f32(u_row + 4 * i);
+                acc[i] = vdupq_n_f32(0.0f);
+            }
+            for (size_t kd = 0; kd < K; ++kd) {
+                const float* s_row = state + kd * V + v0;
+                const float32x4_t w4 = vdupq_n_f32(w_row[kd]);
+                const float32x4_t q4 = vdupq_n_f32(q_row[kd]);
+                for (int i = 0; i < 4; ++i) {
+                    const float32x4_t s4 = vld1q_f32(s_row + 4 * i);
+                    d[i] = vfmsq_f32(d[i], s4, w4);
+                    acc[i] = vfmaq_f32(acc[i], s4, q4);
+                }
+            }
+            for (int i = 0; i < 4; ++i) vst1q_f32(delta + t * vb + 4 * i, d[i]);
+            const float* m_row = m + t * C;
+            for (size_t j = 0; j <= t; ++j) {
+                const float32x4_t m4 = vdupq_n_f32(m_row[j]);
+                for (int i = 0; i < 4; ++i) acc[i] = vfmaq_f32(acc[i], vld1q_f32(delta + j * vb + 4 * i), m4);
+            }
+            for (int i = 0; i < 4; ++i) vst1q_f32(o + t * vb + 4 * i, acc[i]);
+        }
+        const float32x4_t p4 = vdupq_n_f32(p_end);
+        for (size_t kd = 0; kd < K; ++kd) {
+            float* s_row = state + kd * V + v0;
+            float32x4_t s4[4];
+            for (int i = 0; i < 4; ++i) s4[i] = vmulq_f32(vld1q_f32(s_row + 4 * i), p4);
+            for (size_t t = 0; t < C; ++t) {
+                const float32x4_t k4 = vdupq_n_f32(kt[t * K + kd]);
+                for (int i = 0; i < 4; ++i) s4[i] = vfmaq_f32(s4[i], vld1q_f32(delta + t * vb + 4 * i), k4);
+            }
+            for (int i = 0; i < 4; ++i) vst1q_f32(s_row + 4 * i, s4[i]);
+        }
+    } else {
+        for (size_t t = 0; t < C; ++t) {
+            float* d_row = delta + t * vb;
+            float* o_row = o + t * vb;
+            std::memcpy(d_row, u + t * V + v0, vb * sizeof(float));
+            std::fill(o_row, o_row + vb, 0.0f);
+            const float* w_row = w + t * K;
+            const float* q_row = qp + t * K;
+            for (size_t kd = 0; kd < K; ++kd) {
+                const float* s_row = state + kd * V + v0;
+                axpy_f32(d_row, s_row, -w_row[kd], vb);
+                axpy_f32(o_row, s_row, q_row[kd], vb);
+            }
+            const float* m_row = m + t * C;
+            for (size_t j = 0; j <= t; ++j) axpy_f32(o_row, delta + j * vb, m_row[j], vb);
+        }
+        for (size_t kd = 0; kd < K; ++kd) {
+            float* s_row = state + kd * V + v0;
+            scale_f32(s_row, p_end, vb);
+            for (size_t t = 0; t < C; ++t) axpy_f32(s_row, delta + t * vb, kt[t * K + kd], vb);
+        }
+    }
+
+    for (size_t t = 0; t < C; ++t) {
+        __fp16* dst = out + t * out_row_stride;
+        for (size_t vd = 0; vd < vb; ++vd) dst[vd] = static_cast<__fp16>(o[t * vb + vd] * scale);
+    }
+}
+
+void gated_deltanet_prefill_parallel_f16(
+    const __fp16* q_data,
+    const __fp16* k_data,
+    const __fp16* v_data,
+    const __fp16* g_data,
+    const __fp16* b_data,
+    const __fp16* s_data,
+    __fp16* out,
+    size_t B,
+    size_t T,
+    size_t Hq,
+    size_t Hv,
+    size_t K,
+    size_t V,
+    size_t chunk_size,
+    float scale) {
+    static constexpr CactusThreading::ParallelConfig DELTANET_TILES{2, 1};
+    const size_t out_seq = T + K;
+    const size_t qk_repeat = Hv / Hq;
+    const size_t heads = B * Hv;
+    const size_t n_chunks = (T + chunk_size - 1) / chunk_size;
+    const size_t n_vblocks = (V + kDeltaNetVBlock - 1) / kDeltaNetVBlock;
+
+    // Enough chunks per segment to give every worker several phase-1 tiles, bounded so the
+    // prepared-chunk buffer stays a few MB regardless of sequence length.
+    const size_t workers = CactusThreading::get_thread_pool().num_workers();
+    const size_t segment = std::max<size_t>(1, std::min({n_chunks, kDeltaNetSegmentChunks,
+                                                         (4 * workers + heads - 1) / heads}));
+    const size_t stride = GatedDeltaParallelScratch::chunk_stride(K, V, chunk_size);
+
+    auto& ws = g_gated_deltanet_parallel_scratch;
+    if (ws.state.size() < heads * K * V) ws.state.resize(heads * K * V);
+    if (ws.chunks.size() < heads * segment * stride) ws.chunks.resize(heads * segment * stride);
+    float* states = ws.state.data();
+    float* chunks = ws.chunks.data();
+
+    size_t seg0 = 0;
+    do {
+        const size_t seg_len = std::min(segment, n_chunks - seg0);
+
+        CactusThreading::parallel_for(heads * seg_len, DELTANET_TILES, [&](size_t start, size_t end) {
+            for (size_t item = start; item < end; ++item) {
+                const size_t bh = item / seg_len;
+                const size_t c = item % seg_len;
+                const size_t t0 = (seg0 + c) * chunk_size;
+                gated_deltanet_chunk_prepare(q_data, k_data, v_data, g_data, b_data,
+                                             bh / Hv, bh % Hv, (bh % Hv) / qk_repeat, t0,
+                                             std::min(chunk_size, T - t0), T, Hq, Hv, K, V, chunk_size,
+                                             chunks + (bh * segment + c) * stride);
+            }
+        });
+
+        const bool first = seg0 == 0;
+        const bool last = seg0 + segment >= n_chunks;
+        CactusThreading::parallel_for(heads * n_vblocks, DELTANET_TILES, [&](size_t start, size_t end) {
+            for (size_t item = start; item < end; ++item) {
+                const size_t bh = item / n_vblocks;
+                const size_t batch = bh / Hv;
+                const size_t v_head = bh % Hv;
+                const size_t v0 = (item % n_vblocks) * kDeltaNetVBlock;
+                const size_t vb = std::min(kDeltaNetVBlock, V - v0);
+                float* state = states + bh * K * V;
+
+                if (first) {
+                    for (size_t kd = 0; kd < K; ++kd) {
+                        cactus_fp16_to_fp32(s_data + ((batch * K + kd) * Hv + v_head) * V + v0, state + kd * V + v0, vb);
+                    }
+                }
+                for (size_t c = 0; c < seg_len; ++c) {
+                    const size_t t0 = (seg0 + c) * chunk_size;
+                    gated_deltanet_chunk_recur(chunks + (bh * segment + c) * stride,
+                                               std::min(chunk_size, T - t0), K, V, chunk_size, state, v0, vb, scale,
+                                               out + ((batch * out_seq + t0) * Hv + v_head) * V + v0, Hv * V);
+                }
+                if (last) {
+                    for (size_t kd = 0; kd < K; ++kd) {
+                        cactus_fp32_to_fp16(state + kd * V + v0, out + ((batch * out_seq + T + kd) * Hv + v_head) * V + v0, vb);
+                    }
+                }
+            }
+        });
+        seg0 += segment;
+    } while (seg0 < n_chunks);
+}
+
 } // namespace
 
 void cactus_gated_deltanet_decode_f16(
@@ -762,54 +1049,59 @@ void cactus_gated_deltanet_decode_f16(
     size_t K,
     size_t V,
     float scale) {
+    // Every column of the state updates independently, so one token splits over V-column blocks too.
+    static constexpr CactusThreading::ParallelConfig DELTANET_DECODE_TILES{4, 2};
     const size_t qk_repeat = Hv / Hq;
     const size_t out_seq = 1 + K;
+    const size_t n_vblocks = (V + kDeltaNetVBlock - 1) / kDeltaNetVBlock;
 
-    CactusThreading::parallel_for(B * Hv, CactusThreading::Thresholds::SCALAR_EXPENSIVE,
-        [&](size_t bh_start, size_t bh_end) {
-            std::vector<float> state(K * V);
-            std::vector<float> proj(V);
-            std::vector<float> delta(V);
+    CactusThreading::parallel_for(B * Hv * n_vblocks, DELTANET_DECODE_TILES,
+        [&](size_t start, size_t end) {
+            auto& scratch = g_gated_deltanet_block_scratch;
+            if (scratch.size() < (K + 1) * kDeltaNetVBlock) scratch.resize((K + 1) * kDeltaNetVBlock);
+            float* state = scratch.data();
+            float* delta = state + K * kDeltaNetVBlock;
 
-            for (size_t bh = bh_start; bh < bh_end; ++bh) {
+            for (size_t item = start; item < end; ++item) {
+                const size_t bh = item / n_vblocks;
                 const size_t batch = bh / Hv;
                 const size_t v_head = bh % Hv;
-                const size_t qk_head = v_head / qk_repeat;
+                const size_t v0 = (item % n_vblocks) * kDeltaNetVBlock;
+                const size_t vb = std::min(kDeltaNetVBlock, V - v0);
+                const __fp16* q_ptr = q_data + (batch * Hq + v_head / qk_repeat) * K;
+                const __fp16* k_ptr = k_data + (batch * Hq + v_head / qk_repeat) * K;
+                const __fp16* v_ptr = v_data + (batch * Hv + v_head) * V + v0;
+                const float gate_log = static_cast<float>(g_data[batch * Hv + v_head]);
+                const float beta = static_cast<float>(b_data[batch * Hv + v_head]);
+                const float gate = safe_exp_gate(std::isfinite(gate_log) ? gate_log : -20.0f);
+                const float beta_safe = std::isfinite(beta) ? std::min(1.0f, std::max(0.0f, beta)) : 0.0f;
 
                 for (size_t kd = 0; kd < K; ++kd) {
-                    for (size_t vd = 0; vd < V; ++vd) {
-                        const size_t s_idx = (((batch * K + kd) * Hv + v_head) * V + vd);
-                        state[kd * V + vd] = static_cast<float>(s_data[s_idx]);
-                    }
+                    cactus_fp16_to_fp32(s_data + ((batch * K + kd) * Hv + v_head) * V + v0, state + kd * vb, vb);
                 }
 
-                float state_scale = 1.0f;
-                const size_t qk_base = ((batch * Hq + qk_head) * K);
-                const size_t v_base = ((batch * Hv + v_head) * V);
-                const float gate_log = static_cast<float>(g_data[batch * Hv + v_head]);
-                const float beta = static_cast<float>(b_data[batch * Hv + v_head]);
-
-                gated_deltanet_step(
-                    q_data + qk_base,
-                    k_data + qk_base,
-                    v_data + v_base,
-                    gate_log,
-                    beta,
-                    scale,
-                    K,
-                    V,
-                    state,
-                    state_scale,
-                    proj,
-                    delta,
-                    out + (((batch * out_seq) * Hv + v_head) * V));
+                std::fill(delta, delta + vb, 0.0f);
+                for (size_t kd = 0; kd < K; ++kd) {
+                    axpy_f32(delta, state + kd * vb, static_cast<float>(k_ptr[kd]), vb);
+                }
+                for (size_t vd = 0; vd < vb; ++vd) {
+                    delta[vd] = beta_safe * (static_cast<float>(v_ptr[vd]) - gate * delta[vd]);
+                }
 
-                fold_state_scale(state, state_scale);
+                __fp16* o_ptr = out + ((batch * out_seq) * Hv + v_head) * V + v0;
+                float o_acc[kDeltaNetVBlock] = {};
                 for (size_t kd = 0; kd < K; ++kd) {
-                    for (size_t vd = 0; vd < V; ++vd) {
-                        const size_t out_idx = (((batch * out_seq + (1 + kd)) * Hv + v_head) * V + vd);
-                        out[out_idx] = static_cast<__fp16>(state[kd * V + vd]);
+                    float* s_row = state + kd * vb;
+                    scale_f32(s_row, gate, vb);
+                    axpy_f32(s_row, delta, static_cast<float>(k_ptr[kd]), vb);
+                    for (size_t vd = 0; vd < vb; ++vd) {
+                        if (!std::isfinite(s_row[vd])) s_row[vd] = 0.0f;
                     }
+                    axpy_f32(o_acc, s_row, static_cast<float>(q_ptr[kd]), vb);
+                    cactus_fp32_to_fp16(s_row, out + ((batch * out_seq + 1 + kd) * Hv + v_head) * V + v0, vb);
+                }
+                for (size_t vd = 0; vd < vb; ++vd) {
+                    o_ptr[vd] = static_cast<__fp16>(std::isfinite(o_acc[vd]) ? o_acc[vd] * scale : 0.0f);
                 }
             }
         });
@@ -845,6 +1137,12 @@ void cactus_gated_deltanet_prefill_f16(
     }
 
     const size_t chunk_size = tuned_gated_deltanet_chunk_size(requested_chunk_size, K, V);
-    gated_deltanet_prefill_chunked_f16(q_data, k_data, v_data, g_data, b_data, s_data, out,
-                                       B, T, Hq, Hv, K, V, chunk_size, scale);
+    const char* force_serial = std::getenv("CACTUS_GATED_DELTANET_PREFILL_SERIAL");
+    if (force_serial != nullptr && std::atoi(force_serial) != 0) {
+        gated_deltanet_prefill_chunked_f16(q_data, k_data, v_data, g_data, b_data, s_data, out,
+                                           B, T, Hq, Hv, K, V, chunk_size, scale);
+        return;
+    }
+    gated_deltanet_prefill_parallel_f16(q_data, k_data, v_data, g_data, b_data, s_data, out,
+                                        B, T, Hq, Hv, K, V, chunk_size, scale);
 }
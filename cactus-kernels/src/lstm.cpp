@@ -1,6 +1,7 @@
 #include "../cactus_kernels.h"
 #include "threading.h"
 #include <arm_neon.h>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <vector>
@@ -118,7 +119,6 @@ void cactus_lstm_cell_f16(
 }
 #ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
-#endif
 
 static void apply_lstm_gates_f32(
     const float* __restrict gates,
@@ -158,27 +158,7 @@ static void apply_lstm_gates_f32(
     }
 }
 
-#ifndef __APPLE__
-static void apply_lstm_gates_f16(
-    const __fp16* __restrict gates,
-    __fp16* __restrict c,
-    __fp16* __restrict h,
-    size_t hidden_size
-) {
-    const size_t gate_size = 4 * hidden_size;
-    std::vector<float> gates_f32(gate_size);
-    std::vector<float> c_f32(hidden_size);
-    std::vector<float> h_f32(hidden_size);
-
-    cactus_fp16_to_fp32(gates, gates_f32.data(), gate_size);
-    cactus_fp16_to_fp32(c, c_f32.data(), hidden_size);
-
-    apply_lstm_gates_f32(gates_f32.data(), c_f32.data(), h_f32.data(), hidden_size);
-
-    cactus_fp32_to_fp16(c_f32.data(), c, hidden_size);
-    cactus_fp32_to_fp16(h_f32.data(), h, hidden_size);
-}
-
+#else
 static inline float hsum_f16x8_f32(float16x8_t v) {
     float16x4_t lo = vget_low_f16(v);
     float16x4_t hi = vget_high_f16(v);
@@ -188,73 +168,121 @@ static inline float hsum_f16x8_f32(float16x8_t v) {
     return static_cast<float>(vget_lane_f16(s1, 0));
 }
 
-static void lstm_gemv_f16_neon(
-    const __fp16* __restrict x,
-    const __fp16* __restrict W,
-    const __fp16* __restrict bias,
-    __fp16* __restrict out,
-    size_t K, size_t N
-) {
-    const size_t K16 = (K / 16) * 16;
-    const size_t K8 = (K / 8) * 8;
-    size_t n = 0;
-    for (; n + 4 <= N; n += 4) {
-        const __fp16* w0 = W + n * K;
-        const __fp16* w1 = W + (n + 1) * K;
-        const __fp16* w2 = W + (n + 2) * K;
-        const __fp16* w3 = W + (n + 3) * K;
-        float16x8_t a0 = vdupq_n_f16(0);
-        float16x8_t a1 = vdupq_n_f16(0);
-        float16x8_t a2 = vdupq_n_f16(0);
-        float16x8_t a3 = vdupq_n_f16(0);
-        for (size_t k = 0; k < K16; k += 16) {
-            float16x8_t xlo = vld1q_f16(x + k);
-            float16x8_t xhi = vld1q_f16(x + k + 8);
-            a0 = vfmaq_f16(a0, xlo, vld1q_f16(w0 + k));
-            a0 = vfmaq_f16(a0, xhi, vld1q_f16(w0 + k + 8));
-            a1 = vfmaq_f16(a1, xlo, vld1q_f16(w1 + k));
-            a1 = vfmaq_f16(a1, xhi, vld1q_f16(w1 + k + 8));
-            a2 = vfmaq_f16(a2, xlo, vld1q_f16(w2 + k));
-            a2 = vfmaq_f16(a2, xhi, vld1q_f16(w2 + k + 8));
-            a3 = vfmaq_f16(a3, xlo, vld1q_f16(w3 + k));
-            a3 = vfmaq_f16(a3, xhi, vld1q_f16(w3 + k + 8));
+// Recurrent weights are repacked so the i/f/g/o rows of every 4 hidden units sit next to each
+// other: one pass over h yields all 16 pre-activations of a unit block, the gates are applied
+// while they are still in registers, and the weights stream through the cache exactly once per step.
+constexpr size_t kLstmUnitBlock = 4;
+
+static size_t lstm_packed_row(size_t unit, size_t gate, size_t hidden_size) {
+    const size_t blocked = (hidden_size / kLstmUnitBlock) * kLstmUnitBlock;
+    if (unit < blocked) return (unit / kLstmUnitBlock) * 4 * kLstmUnitBlock + gate * kLstmUnitBlock + unit % kLstmUnitBlock;
+    return blocked * 4 + (unit - blocked) * 4 + gate;
+}
+
+static void pack_lstm_recurrent_f16(const __fp16* weight_hh, __fp16* packed, size_t hidden_size) {
+    for (size_t gate = 0; gate < 4; ++gate) {
+        for (size_t unit = 0; unit < hidden_size; ++unit) {
+            memcpy(packed + lstm_packed_row(unit, gate, hidden_size) * hidden_size,
+                   weight_hh + (gate * hidden_size + unit) * hidden_size, hidden_size * sizeof(__fp16));
         }
-        for (size_t k = K16; k < K8; k += 8) {
-            float16x8_t xv = vld1q_f16(x + k);
-            a0 = vfmaq_f16(a0, xv, vld1q_f16(w0 + k));
-            a1 = vfmaq_f16(a1, xv, vld1q_f16(w1 + k));
-            a2 = vfmaq_f16(a2, xv, vld1q_f16(w2 + k));
-            a3 = vfmaq_f16(a3, xv, vld1q_f16(w3 + k));
+    }
+}
+
+static float lstm_dot_f16(const __fp16* __restrict x, const __fp16* __restrict w, size_t K) {
+    const size_t K8 = (K / 8) * 8;
+    float16x8_t acc = vdupq_n_f16(0);
+    for (size_t k = 0; k < K8; k += 8)
+        acc = vfmaq_f16(acc, vld1q_f16(x + k), vld1q_f16(w + k));
+    float s = hsum_f16x8_f32(acc);
+    for (size_t k = K8; k < K; ++k)
+        s += static_cast<float>(x[k]) * static_cast<float>(w[k]);
+    return s;
+}
+
+// Runs one direction of one sequence. x_proj holds W_ih·x_t for every step (4 * hidden_size
+// values per row, row stride proj_stride); only the recurrent GEMV is left inside the time loop.
+static void lstm_recurrence_f16(
+    const __fp16* x_proj,
+    size_t proj_stride,
+    const __fp16* W_packed,
+    const float* bias,
+    __fp16* output,
+    size_t out_stride,
+    size_t seq_len,
+    size_t hidden_size,
+    bool reverse
+) {
+    const size_t H = hidden_size;
+    const size_t K8 = (H / 8) * 8;
+    const size_t blocked = (H / kLstmUnitBlock) * kLstmUnitBlock;
+    constexpr size_t ROWS = 4 * kLstmUnitBlock;
+
+    std::vector<__fp16> h_buf(2 * H, static_cast<__fp16>(0));
+    std::vector<float> c(H, 0.0f);
+
+    for (size_t step = 0; step < seq_len; ++step) {
+        const size_t t = reverse ? seq_len - 1 - step : step;
+        const __fp16* h_prev = h_buf.data() + (step & 1) * H;
+        __fp16* h_next = h_buf.data() + ((step + 1) & 1) * H;
+        const __fp16* xp = x_proj + t * proj_stride;
+        __fp16* out = output + t * out_stride;
+
+        for (size_t j0 = 0; j0 < blocked; j0 += kLstmUnitBlock) {
+            const __fp16* w = W_packed + j0 * 4 * H;
+            float16x8_t acc[ROWS];
+            for (size_t r = 0; r < ROWS; ++r) acc[r] = vdupq_n_f16(0);
+            for (size_t k = 0; k < K8; k += 8) {
+                const float16x8_t hv = vld1q_f16(h_prev + k);
+                for (size_t r = 0; r < ROWS; ++r)
+                    acc[r] = vfmaq_f16(acc[r], hv, vld1q_f16(w + r * H + k));
+            }
+            float pre[ROWS];
+            for (size_t r = 0; r < ROWS; ++r) {
+                float s = hsum_f16x8_f32(acc[r]);
+                for (size_t k = K8; k < H; ++k)
+                    s += static_cast<float>(h_prev[k]) * static_cast<float>(w[r * H + k]);
+                pre[r] = s;
+            }
+
+            float32x4_t gate[4];
+            for (size_t g = 0; g < 4; ++g) {
+                const float32x4_t proj = vcvt_f32_f16(vld1_f16(xp + g * H + j0));
+                gate[g] = vaddq_f32(vaddq_f32(vld1q_f32(pre + g * kLstmUnitBlock), proj),
+                                    vld1q_f32(bias + g * H + j0));
+            }
+            const float32x4_t i_act = fast_sigmoid_f32x4(gate[0]);
+            const float32x4_t f_act = fast_sigmoid_f32x4(gate[1]);
+            const float32x4_t g_act = fast_tanh_f32x4(gate[2]);
+            const float32x4_t o_act = fast_sigmoid_f32x4(gate[3]);
+            const float32x4_t c_new = vfmaq_f32(vmulq_f32(f_act, vld1q_f32(c.data() + j0)), i_act, g_act);
+            vst1q_f32(c.data() + j0, c_new);
+            const float16x4_t h_new = vcvt_f16_f32(vmulq_f32(o_act, fast_tanh_f32x4(c_new)));
+            vst1_f16(h_next + j0, h_new);
+            vst1_f16(out + j0, h_new);
         }
-        float s0 = hsum_f16x8_f32(a0);
-        float s1 = hsum_f16x8_f32(a1);
-        float s2 = hsum_f16x8_f32(a2);
-        float s3 = hsum_f16x8_f32(a3);
-        for (size_t k = K8; k < K; ++k) {
-            float xv = static_cast<float>(x[k]);
-            s0 += xv * static_cast<float>(w0[k]);
-            s1 += xv * static_cast<float>(w1[k]);
-            s2 += xv * static_cast<float>(w2[k]);
-            s3 += xv * static_cast<float>(w3[k]);
+
+        for (size_t j = blocked; j < H; ++j) {
+            float pre[4];
+            for (size_t g = 0; g < 4; ++g) {
+                pre[g] = lstm_dot_f16(h_prev, W_packed + lstm_packed_row(j, g, H) * H, H) +
+                         static_cast<float>(xp[g * H + j]) + bias[g * H + j];
+            }
+            const float ig = 1.0f / (1.0f + expf(-pre[0]));
+            const float fg = 1.0f / (1.0f + expf(-pre[1]));
+            const float gg = tanhf(pre[2]);
+            const float og = 1.0f / (1.0f + expf(-pre[3]));
+            c[j] = fg * c[j] + ig * gg;
+            const __fp16 hv = static_cast<__fp16>(og * tanhf(c[j]));
+            h_next[j] = hv;
+            out[j] = hv;
         }
-        out[n] = static_cast<__fp16>(s0 + static_cast<float>(bias[n]));
-        out[n + 1] = static_cast<__fp16>(s1 + static_cast<float>(bias[n + 1]));
-        out[n + 2] = static_cast<__fp16>(s2 + static_cast<float>(bias[n + 2]));
-        out[n + 3] = static_cast<__fp16>(s3 + static_cast<float>(bias[n + 3]));
-    }
-    for (; n < N; ++n) {
-        const __fp16* w = W + n * K;
-        float16x8_t acc = vdupq_n_f16(0);
-        for (size_t k = 0; k < K8; k += 8)
-            acc = vfmaq_f16(acc, vld1q_f16(x + k), vld1q_f16(w + k));
-        float s = hsum_f16x8_f32(acc);
-        for (size_t k = K8; k < K; ++k)
-            s += static_cast<float>(x[k]) * static_cast<float>(w[k]);
-        out[n] = static_cast<__fp16>(s + static_cast<float>(bias[n]));
     }
 }
 #endif
 
+// Each (batch, direction) recurrence is an independent task; two sequences keep two cores busy.
+static constexpr CactusThreading::ParallelConfig BILSTM_SEQUENCES{2, 1};
+
 void cactus_bilstm_sequence_f16(
     const __fp16* input,
     const __fp16* weight_ih_fwd,
@@ -272,145 +300,86 @@ void cactus_bilstm_sequence_f16(
     size_t hidden_size
 ) {
     const size_t gate_size = 4 * hidden_size;
-    const size_t combined_K = input_size + hidden_size;
+    const size_t proj_size = 2 * gate_size;
     const size_t output_size = 2 * hidden_size;
+    const size_t rows = batch_size * seq_len;
 
-    std::vector<float> bias_fwd_f32(gate_size);
-    std::vector<float> bias_bwd_f32(gate_size);
+    std::vector<float> bias_f32(proj_size);
     for (size_t g = 0; g < gate_size; ++g) {
-        bias_fwd_f32[g] = static_cast<float>(bias_ih_fwd[g]) + static_cast<float>(bias_hh_fwd[g]);
-        bias_bwd_f32[g] = static_cast<float>(bias_ih_bwd[g]) + static_cast<float>(bias_hh_bwd[g]);
+        bias_f32[g] = static_cast<float>(bias_ih_fwd[g]) + static_cast<float>(bias_hh_fwd[g]);
+        bias_f32[gate_size + g] = static_cast<float>(bias_ih_bwd[g]) + static_cast<float>(bias_hh_bwd[g]);
     }
 
+    // Input projections do not depend on the recurrence, so both directions and every timestep
+    // go through one GEMM up front: proj[b * seq_len + t] = [W_ih_fwd; W_ih_bwd] · x[b, t].
 #ifdef __APPLE__
-    std::vector<float> W_fwd_f32(gate_size * combined_K);
-    std::vector<float> W_bwd_f32(gate_size * combined_K);
-    for (size_t g = 0; g < gate_size; ++g) {
-        cactus_fp16_to_fp32(weight_ih_fwd + g * input_size,
-                          W_fwd_f32.data() + g * combined_K, input_size);
-        cactus_fp16_to_fp32(weight_hh_fwd + g * hidden_size,
-                          W_fwd_f32.data() + g * combined_K + input_size, hidden_size);
-        cactus_fp16_to_fp32(weight_ih_bwd + g * input_size,
-                          W_bwd_f32.data() + g * combined_K, input_size);
-        cactus_fp16_to_fp32(weight_hh_bwd + g * hidden_size,
-                          W_bwd_f32.data() + g * combined_K + input_size, hidden_size);
-    }
-
-    for (size_t b = 0; b < batch_size; ++b) {
-        const __fp16* batch_in = input + b * seq_len * input_size;
-        __fp16* batch_out = output + b * seq_len * output_size;
-
-        auto& pool = CactusThreading::get_thread_pool();
-        auto bwd_future = pool.enqueue([&, batch_in, batch_out]() {
-            std::vector<float> xh(combined_K);
+    std::vector<float> x_f32(rows * input_size);
+    std::vector<float> W_ih_f32(proj_size * input_size);
+    std::vector<float> W_hh_f32(2 * gate_size * hidden_size);
+    std::vector<float> proj(rows * proj_size);
+    cactus_fp16_to_fp32(input, x_f32.data(), rows * input_size);
+    cactus_fp16_to_fp32(weight_ih_fwd, W_ih_f32.data(), gate_size * input_size);
+    cactus_fp16_to_fp32(weight_ih_bwd, W_ih_f32.data() + gate_size * input_size, gate_size * input_size);
+    cactus_fp16_to_fp32(weight_hh_fwd, W_hh_f32.data(), gate_size * hidden_size);
+    cactus_fp16_to_fp32(weight_hh_bwd, W_hh_f32.data() + gate_size * hidden_size, gate_size * hidden_size);
+
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans,
+                static_cast<int>(rows), static_cast<int>(proj_size), static_cast<int>(input_size),
+                1.0f, x_f32.data(), static_cast<int>(input_size),
+                W_ih_f32.data(), static_cast<int>(input_size),
+                0.0f, proj.data(), static_cast<int>(proj_size));
+
+    CactusThreading::parallel_for(2 * batch_size, BILSTM_SEQUENCES,
+        [&](size_t task_start, size_t task_end) {
             std::vector<float> gates(gate_size);
-            std::vector<float> h(hidden_size, 0.0f);
-            std::vector<float> c(hidden_size, 0.0f);
-
-            for (size_t idx = 0; idx < seq_len; ++idx) {
-                const size_t t = seq_len - 1 - idx;
-                cactus_fp16_to_fp32(batch_in + t * input_size, xh.data(), input_size);
-                memcpy(xh.data() + input_size, h.data(), hidden_size * sizeof(float));
-
-                memcpy(gates.data(), bias_bwd_f32.data(), gate_size * sizeof(float));
-                cblas_sgemv(CblasRowMajor, CblasNoTrans,
-                            static_cast<int>(gate_size), static_cast<int>(combined_K),
-                            1.0f, W_bwd_f32.data(), static_cast<int>(combined_K),
-                            xh.data(), 1, 1.0f, gates.data(), 1);
-
-                apply_lstm_gates_f32(gates.data(), c.data(), h.data(), hidden_size);
-
-                cactus_fp32_to_fp16(h.data(), batch_out + t * output_size + hidden_size, hidden_size);
+            std::vector<float> h(hidden_size);
+            std::vector<float> c(hidden_size);
+            for (size_t task = task_start; task < task_end; ++task) {
+                const size_t b = task / 2;
+                const size_t dir = task % 2;
+                const float* W_hh = W_hh_f32.data() + dir * gate_size * hidden_size;
+                const float* bias = bias_f32.data() + dir * gate_size;
+                std::fill(h.begin(), h.end(), 0.0f);
+                std::fill(c.begin(), c.end(), 0.0f);
+
+                for (size_t step = 0; step < seq_len; ++step) {
+                    const size_t t = dir ? seq_len - 1 - step : step;
+                    const float* xp = proj.data() + (b * seq_len + t) * proj_size + dir * gate_size;
+                    for (size_t g = 0; g < gate_size; ++g) gates[g] = xp[g] + bias[g];
+                    cblas_sgemv(CblasRowMajor, CblasNoTrans,
+                                static_cast<int>(gate_size), static_cast<int>(hidden_size),
+                                1.0f, W_hh, static_cast<int>(hidden_size),
+                                h.data(), 1, 1.0f, gates.data(), 1);
+
+                    apply_lstm_gates_f32(gates.data(), c.data(), h.data(), hidden_size);
+
+                    cactus_fp32_to_fp16(h.data(), output + (b * seq_len + t) * output_size + dir * hidden_size, hidden_size);
+                }
             }
         });
 
-        {
-            std::vector<float> xh(combined_K);
-            std::vector<float> gates(gate_size);
-            std::vector<float> h(hidden_size, 0.0f);
-            std::vector<float> c(hidden_size, 0.0f);
-
-            for (size_t t = 0; t < seq_len; ++t) {
-                cactus_fp16_to_fp32(batch_in + t * input_size, xh.data(), input_size);
-                memcpy(xh.data() + input_size, h.data(), hidden_size * sizeof(float));
-
-                memcpy(gates.data(), bias_fwd_f32.data(), gate_size * sizeof(float));
-                cblas_sgemv(CblasRowMajor, CblasNoTrans,
-                            static_cast<int>(gate_size), static_cast<int>(combined_K),
-                            1.0f, W_fwd_f32.data(), static_cast<int>(combined_K),
-                            xh.data(), 1, 1.0f, gates.data(), 1);
-
-                apply_lstm_gates_f32(gates.data(), c.data(), h.data(), hidden_size);
-
-                cactus_fp32_to_fp16(h.data(), batch_out + t * output_size, hidden_size);
-            }
-        }
-
-        bwd_future.get();
-    }
-
 #else
-    std::vector<__fp16> W_fwd_f16(gate_size * combined_K);
-    std::vector<__fp16> W_bwd_f16(gate_size * combined_K);
-    for (size_t g = 0; g < gate_size; ++g) {
-        memcpy(W_fwd_f16.data() + g * combined_K,
-               weight_ih_fwd + g * input_size, input_size * sizeof(__fp16));
-        memcpy(W_fwd_f16.data() + g * combined_K + input_size,
-               weight_hh_fwd + g * hidden_size, hidden_size * sizeof(__fp16));
-        memcpy(W_bwd_f16.data() + g * combined_K,
-               weight_ih_bwd + g * input_size, input_size * sizeof(__fp16));
-        memcpy(W_bwd_f16.data() + g * combined_K + input_size,
-               weight_hh_bwd + g * hidden_size, hidden_size * sizeof(__fp16));
-    }
-
-    std::vector<__fp16> bias_fwd_f16(gate_size);
-    std::vector<__fp16> bias_bwd_f16(gate_size);
-    for (size_t g = 0; g < gate_size; ++g) {
-        bias_fwd_f16[g] = static_cast<__fp16>(bias_fwd_f32[g]);
-        bias_bwd_f16[g] = static_cast<__fp16>(bias_bwd_f32[g]);
-    }
-
-    for (size_t b = 0; b < batch_size; ++b) {
-        const __fp16* batch_in = input + b * seq_len * input_size;
-        __fp16* batch_out = output + b * seq_len * output_size;
-
-        auto& pool = CactusThreading::get_thread_pool();
-        auto bwd_future = pool.enqueue([&, batch_in, batch_out]() {
-            std::vector<__fp16> xh(combined_K);
-            std::vector<__fp16> gates(gate_size);
-            std::vector<__fp16> h(hidden_size, static_cast<__fp16>(0));
-            std::vector<__fp16> c(hidden_size, static_cast<__fp16>(0));
-
-            for (size_t idx = 0; idx < seq_len; ++idx) {
-                const size_t t = seq_len - 1 - idx;
-                memcpy(xh.data(), batch_in + t * input_size, input_size * sizeof(__fp16));
-                memcpy(xh.data() + input_size, h.data(), hidden_size * sizeof(__fp16));
-                lstm_gemv_f16_neon(xh.data(), W_bwd_f16.data(), bias_bwd_f16.data(),
-                                   gates.data(), combined_K, gate_size);
-                apply_lstm_gates_f16(gates.data(), c.data(), h.data(), hidden_size);
-                memcpy(batch_out + t * output_size + hidden_size,
-                       h.data(), hidden_size * sizeof(__fp16));
+    std::vector<__fp16> W_ih_f16(proj_size * input_size);
+    memcpy(W_ih_f16.data(), weight_ih_fwd, gate_size * input_size * sizeof(__fp16));
+    memcpy(W_ih_f16.data() + gate_size * input_size, weight_ih_bwd, gate_size * input_size * sizeof(__fp16));
+    std::vector<__fp16> proj(rows * proj_size);
+    cactus_matmul_f16(input, W_ih_f16.data(), proj.data(), rows, input_size, proj_size);
+
+    std::vector<__fp16> W_hh_packed(2 * gate_size * hidden_size);
+    pack_lstm_recurrent_f16(weight_hh_fwd, W_hh_packed.data(), hidden_size);
+    pack_lstm_recurrent_f16(weight_hh_bwd, W_hh_packed.data() + gate_size * hidden_size, hidden_size);
+
+    CactusThreading::parallel_for(2 * batch_size, BILSTM_SEQUENCES,
+        [&](size_t task_start, size_t task_end) {
+            for (size_t task = task_start; task < task_end; ++task) {
+                const size_t b = task / 2;
+                const size_t dir = task % 2;
+                lstm_recurrence_f16(proj.data() + b * seq_len * proj_size + dir * gate_size, proj_size,
+                                    W_hh_packed.data() + dir * gate_size * hidden_size,
+                                    bias_f32.data() + dir * gate_size,
+                                    output + b * seq_len * output_size + dir * hidden_size, output_size,
+                                    seq_len, hidden_size, dir == 1);
             }
         });
-
-        {
-            std::vector<__fp16> xh(combined_K);
-            std::vector<__fp16> gates(gate_size);
-            std::vector<__fp16> h(hidden_size, static_cast<__fp16>(0));
-            std::vector<__fp16> c(hidden_size, static_cast<__fp16>(0));
-
-            for (size_t t = 0; t < seq_len; ++t) {
-                memcpy(xh.data(), batch_in + t * input_size, input_size * sizeof(__fp16));
-                memcpy(xh.data() + input_size, h.data(), hidden_size * sizeof(__fp16));
-                lstm_gemv_f16_neon(xh.data(), W_fwd_f16.data(), bias_fwd_f16.data(),
-                                   gates.data(), combined_K, gate_size);
-                apply_lstm_gates_f16(gates.data(), c.data(), h.data(), hidden_size);
-                memcpy(batch_out + t * output_size,
-                       h.data(), hidden_size * sizeof(__fp16));
-            }
-        }
-
-        bwd_future.get();
-    }
 #endif
 }
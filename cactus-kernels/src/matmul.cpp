@@ -235,11 +235,15 @@ static void cactus_quant_fwht_f16(__fp16* x, uint32_t n) {
     }
 }
 
+// When norm_weight is set the group is RMS-normalized on the fly (x * inv_rms * norm_weight, rounded
+// to FP16 exactly as cactus_rms_norm_f16 would) so the normalized activations never hit memory.
 static void cactus_quant_transform_hadamard_group(
     const CactusQuantMatrix& W,
     const __fp16* x_group,
     uint32_t group,
-    __fp16* code_basis) {
+    __fp16* code_basis,
+    const __fp16* norm_weight = nullptr,
+    float inv_rms = 1.0f) {
     const uint32_t gs = W.group_size;
     __fp16 tmp[256];
     __fp16* work = (W.permutation == nullptr) ? code_basis : tmp;
@@ -248,6 +252,10 @@ static void cactus_quant_transform_hadamard_group(
     for (; k + 8 <= gs; k += 8) {
         const uint32_t offset = group * gs + k;
         float16x8_t x_v = vld1q_f16(x_group + k);
+        if (norm_weight) {
+            const float16x8_t w_v = vld1q_f16(norm_weight + offset);
+            x_v = vmulq_f16(vmulq_f16(x_v, vdupq_n_f16(static_cast<__fp16>(inv_rms))), w_v);
+        }
         x_v = vmulq_f16(x_v, cactus_quant_input_scale_recip8(W, offset));
         float16x8_t s_v = cactus_quant_signs_to_f16(W.left_signs, k);
         vst1q_f16(work + k, vmulq_f16(x_v, s_v));
@@ -256,7 +264,11 @@ static void cactus_quant_transform_hadamard_group(
         const uint32_t offset = group * gs + k;
         const float sign = W.left_signs ? static_cast<float>(W.left_signs[k]) : 1.0f;
         const float scale = static_cast<float>(cactus_quant_input_scale_recip1(W, offset));
-        work[k] = static_cast<__fp16>(static_cast<float>(x_group[k]) * scale * sign);
+        float xv = static_cast<float>(x_group[k]);
+        if (norm_weight) {
+            xv = static_cast<float>(static_cast<__fp16>(xv * inv_rms * static_cast<float>(norm_weight[offset])));
+        }
+        work[k] = static_cast<__fp16>(xv * scale * sign);
     }
 
     if (gs == 128) {
@@ -1369,117 +1381,131 @@ static inline int8x16_t tq_expand_i8_16(const uint8_t* packed, uint32_t bits, in
     }
 }
 
-static void tq_preexpand_weights_interleaved(
+// Decodes one 4-row block of group g into per-row INT8 codebook values (16 K per vector) and the
+// matching norms pre-multiplied by the codebook scale. Handles both the row-major and the
+// INTERLEAVED_4ROW packing; rows past N decode to zero.
+static void tq_decode_panel_i8(
     const CactusQuantMatrix* W,
-    uint32_t bits, uint32_t num_groups, uint32_t gs, uint32_t pgb,
+    uint32_t bits, uint32_t pgb,
     const int8x16_t& cb_lut, float cb_scale,
-    size_t N_blocks,
-    int8_t* w_il, float* n_f32) {
+    size_t nb, uint32_t g,
+    int8x16_t exp4[4][16], float nd[4]) {
+    const uint32_t num_groups = W->num_groups;
+    const uint32_t gs = W->group_size;
     const uint32_t n_vecs = gs / 16;
-    const size_t panel_bytes = static_cast<size_t>(4) * pgb;
+    const size_t n_start = nb * 4;
+    const size_t valid_n = std::min(size_t(4), static_cast<size_t>(W->N) - n_start);
+    const bool interleaved = (W->flags & CACTUS_QUANT_FLAG_INTERLEAVED_4ROW) != 0
+        && bits >= 1 && bits <= 4
+        && (W->N % 4) == 0
+        && (gs % 32) == 0
+        && gs <= 256;
+
+    if (!interleaved) {
+        for (size_t ni = 0; ni < valid_n; ++ni) {
+            const uint8_t* p = W->packed_indices + (static_cast<size_t>(n_start + ni) * num_groups + g) * pgb;
+            for (uint32_t v = 0; v < n_vecs; ++v)
+                exp4[ni][v] = tq_expand_i8_16(p + (v * 16 * bits) / 8, bits, cb_lut);
+        }
+        for (size_t ni = valid_n; ni < 4; ++ni)
+            for (uint32_t v = 0; v < n_vecs; ++v) exp4[ni][v] = vdupq_n_s8(0);
+        for (size_t ni = 0; ni < 4; ++ni)
+            nd[ni] = (n_start + ni < W->N)
+                ? static_cast<float>(W->norms[(n_start + ni) * num_groups + g]) * cb_scale
+                : 0.f;
+        return;
+    }
 
     alignas(16) static const uint8_t reorder4_tbl[16] = {0,1,2,3, 8,9,10,11, 4,5,6,7, 12,13,14,15};
-    const uint8x16_t reorder4 = vld1q_u8(reorder4_tbl);
     alignas(16) static const uint8_t spread2_tbl[16] = {0,0,0,0, 4,4,4,4, 8,8,8,8, 12,12,12,12};
     alignas(16) static const int8_t  shifts2_tbl[16] = {0,-2,-4,-6, 0,-2,-4,-6, 0,-2,-4,-6, 0,-2,-4,-6};
-    const uint8x16_t spread2 = vld1q_u8(spread2_tbl);
-    const int8x16_t  shifts2 = vld1q_s8(shifts2_tbl);
-    const uint8x16_t mask2   = vdupq_n_u8(0x03);
-
-    for (size_t nb = 0; nb < N_blocks; ++nb) {
-        size_t n_start = nb * 4;
-        size_t valid_n = std::min(size_t(4), static_cast<size_t>(W->N) - n_start);
-        for (uint32_t g = 0; g < num_groups; ++g) {
-            const uint8_t* panel = W->packed_indices + (nb * num_groups + g) * panel_bytes;
-            int8x16_t exp4[4][16];
+    const size_t panel_bytes = static_cast<size_t>(4) * pgb;
+    const uint8_t* panel = W->packed_indices + (nb * num_groups + g) * panel_bytes;
 
-            if (bits == 4) {
-                for (uint32_t v = 0; v < n_vecs; ++v) {
-                    const uint8_t* c0 = panel + (2 * v + 0) * 16;
-                    const uint8_t* c1 = panel + (2 * v + 1) * 16;
-                    uint32_t b0[4], b1[4];
-                    std::memcpy(b0, c0, 16);
-                    std::memcpy(b1, c1, 16);
-                    for (size_t r = 0; r < 4; ++r) {
-                        uint8x8_t bytes_r = vcreate_u8(
-                            static_cast<uint64_t>(b0[r]) |
-                            (static_cast<uint64_t>(b1[r]) << 32));
-                        uint8x8_t lo = vand_u8(bytes_r, vdup_n_u8(0x0F));
-                        uint8x8_t hi = vshr_n_u8(bytes_r, 4);
-                        uint8x16_t combined = vcombine_u8(lo, hi);
-                        uint8x16_t reordered = vqtbl1q_u8(combined, reorder4);
-                        exp4[r][v] = vqtbl1q_s8(cb_lut, reordered);
-                    }
-                }
-            } else if (bits == 2) {
-                const uint32_t chunks = gs / 16;
-                for (uint32_t c = 0; c < chunks; ++c) {
-                    uint8x16_t bytes = vld1q_u8(panel + c * 16);
-                    for (size_t r = 0; r < 4; ++r) {
-                        uint8x16_t pick_r = vaddq_u8(spread2, vdupq_n_u8(static_cast<uint8_t>(r)));
-                        uint8x16_t row_bytes = vqtbl1q_u8(bytes, pick_r);
-                        uint8x16_t shifted = vshlq_u8(row_bytes, shifts2);
-                        uint8x16_t idx = vandq_u8(shifted, mask2);
-                        exp4[r][c] = vqtbl1q_s8(cb_lut, idx);
-                    }
-                }
-            } else if (bits == 1) {
-                const uint32_t chunks = gs / 32;
-                alignas(16) uint8_t row_idx[4][256];
-                for (uint32_t c = 0; c < chunks; ++c) {
-                    const uint8_t* ch = panel + c * 16;
-                    for (size_t r = 0; r < 4; ++r) {
-                        for (uint32_t p = 0; p < 4; ++p) {
-                            uint8_t byte = ch[p * 4 + r];
-                            uint8_t* dst_p = row_idx[r] + c * 32 + p * 8;
-                            dst_p[0] = (byte >> 0) & 0x1;
-                            dst_p[1] = (byte >> 1) & 0x1;
-                            dst_p[2] = (byte >> 2) & 0x1;
-                            dst_p[3] = (byte >> 3) & 0x1;
-                            dst_p[4] = (byte >> 4) & 0x1;
-                            dst_p[5] = (byte >> 5) & 0x1;
-                            dst_p[6] = (byte >> 6) & 0x1;
-                            dst_p[7] = (byte >> 7) & 0x1;
-                        }
-                    }
-                }
-                for (size_t r = 0; r < 4; ++r)
-                    for (uint32_t v = 0; v < n_vecs; ++v)
-                        exp4[r][v] = vqtbl1q_s8(cb_lut, vld1q_u8(row_idx[r] + v * 16));
-            } else if (bits == 3) {
-                const uint32_t chunks = gs / 4;
-                alignas(16) uint8_t row_idx[4][256];
-                for (uint32_t c = 0; c < chunks; ++c) {
-                    const uint8_t* ch = panel + c * 6;
-                    uint64_t word = 0;
-                    std::memcpy(&word, ch, 6);
-                    for (size_t r = 0; r < 4; ++r) {
-                        uint32_t bit_pos = static_cast<uint32_t>(r) * 12;
-                        row_idx[r][c * 4 + 0] = static_cast<uint8_t>((word >> (bit_pos + 0)) & 0x7);
-                        row_idx[r][c * 4 + 1] = static_cast<uint8_t>((word >> (bit_pos + 3)) & 0x7);
-                        row_idx[r][c * 4 + 2] = static_cast<uint8_t>((word >> (bit_pos + 6)) & 0x7);
-                        row_idx[r][c * 4 + 3] = static_cast<uint8_t>((word >> (bit_pos + 9)) & 0x7);
-                    }
+    if (bits == 4) {
+        const uint8x16_t reorder4 = vld1q_u8(reorder4_tbl);
+        for (uint32_t v = 0; v < n_vecs; ++v) {
+            const uint8_t* c0 = panel + (2 * v + 0) * 16;
+            const uint8_t* c1 = panel + (2 * v + 1) * 16;
+            uint32_t b0[4], b1[4];
+            std::memcpy(b0, c0, 16);
+            std::memcpy(b1, c1, 16);
+            for (size_t r = 0; r < 4; ++r) {
+                uint8x8_t bytes_r = vcreate_u8(
+                    static_cast<uint64_t>(b0[r]) |
+                    (static_cast<uint64_t>(b1[r]) << 32));
+                uint8x8_t lo = vand_u8(bytes_r, vdup_n_u8(0x0F));
+                uint8x8_t hi = vshr_n_u8(bytes_r, 4);
+                uint8x16_t combined = vcombine_u8(lo, hi);
+                uint8x16_t reordered = vqtbl1q_u8(combined, reorder4);
+                exp4[r][v] = vqtbl1q_s8(cb_lut, reordered);
+            }
+        }
+    } else if (bits == 2) {
+        const uint8x16_t spread2 = vld1q_u8(spread2_tbl);
+        const int8x16_t  shifts2 = vld1q_s8(shifts2_tbl);
+        const uint8x16_t mask2   = vdupq_n_u8(0x03);
+        const uint32_t chunks = gs / 16;
+        for (uint32_t c = 0; c < chunks; ++c) {
+            uint8x16_t bytes = vld1q_u8(panel + c * 16);
+            for (size_t r = 0; r < 4; ++r) {
+                uint8x16_t pick_r = vaddq_u8(spread2, vdupq_n_u8(static_cast<uint8_t>(r)));
+                uint8x16_t row_bytes = vqtbl1q_u8(bytes, pick_r);
+                uint8x16_t shifted = vshlq_u8(row_bytes, shifts2);
+                uint8x16_t idx = vandq_u8(shifted, mask2);
+                exp4[r][c] = vqtbl1q_s8(cb_lut, idx);
+            }
+        }
+    } else if (bits == 1) {
+        const uint32_t chunks = gs / 32;
+        alignas(16) uint8_t row_idx[4][256];
+        for (uint32_t c = 0; c < chunks; ++c) {
+            const uint8_t* ch = panel + c * 16;
+            for (size_t r = 0; r < 4; ++r) {
+                for (uint32_t p = 0; p < 4; ++p) {
+                    uint8_t byte = ch[p * 4 + r];
+                    uint8_t* dst_p = row_idx[r] + c * 32 + p * 8;
+                    dst_p[0] = (byte >> 0) & 0x1;
+                    dst_p[1] = (byte >> 1) & 0x1;
+                    dst_p[2] = (byte >> 2) & 0x1;
+                    dst_p[3] = (byte >> 3) & 0x1;
+                    dst_p[4] = (byte >> 4) & 0x1;
+                    dst_p[5] = (byte >> 5) & 0x1;
+                    dst_p[6] = (byte >> 6) & 0x1;
+                    dst_p[7] = (byte >> 7) & 0x1;
                 }
-                for (size_t r = 0; r < 4; ++r)
-                    for (uint32_t v = 0; v < n_vecs; ++v)
-                        exp4[r][v] = vqtbl1q_s8(cb_lut, vld1q_u8(row_idx[r] + v * 16));
             }
-
-            for (size_t ni = valid_n; ni < 4; ++ni)
-                for (uint32_t v = 0; v < n_vecs; ++v) exp4[ni][v] = vdupq_n_s8(0);
-
-            int8_t* dst = w_il + (nb * num_groups + g) * gs * 4;
+        }
+        for (size_t r = 0; r < 4; ++r)
             for (uint32_t v = 0; v < n_vecs; ++v)
-                tq_interleave_4x_s8(exp4[0][v], exp4[1][v], exp4[2][v], exp4[3][v], dst + v * 64);
-
-            float* nd = n_f32 + (nb * num_groups + g) * 4;
-            for (size_t ni = 0; ni < 4; ++ni)
-                nd[ni] = (n_start + ni < W->N)
-                    ? static_cast<float>(W->norms[(nb * num_groups + g) * 4 + ni]) * cb_scale
-                    : 0.f;
+                exp4[r][v] = vqtbl1q_s8(cb_lut, vld1q_u8(row_idx[r] + v * 16));
+    } else if (bits == 3) {
+        const uint32_t chunks = gs / 4;
+        alignas(16) uint8_t row_idx[4][256];
+        for (uint32_t c = 0; c < chunks; ++c) {
+            const uint8_t* ch = panel + c * 6;
+            uint64_t word = 0;
+            std::memcpy(&word, ch, 6);
+            for (size_t r = 0; r < 4; ++r) {
+                uint32_t bit_pos = static_cast<uint32_t>(r) * 12;
+                row_idx[r][c * 4 + 0] = static_cast<uint8_t>((word >> (bit_pos + 0)) & 0x7);
+                row_idx[r][c * 4 + 1] = static_cast<uint8_t>((word >> (bit_pos + 3)) & 0x7);
+                row_idx[r][c * 4 + 2] = static_cast<uint8_t>((word >> (bit_pos + 6)) & 0x7);
+                row_idx[r][c * 4 + 3] = static_cast<uint8_t>((word >> (bit_pos + 9)) & 0x7);
+            }
         }
+        for (size_t r = 0; r < 4; ++r)
+            for (uint32_t v = 0; v < n_vecs; ++v)
+                exp4[r][v] = vqtbl1q_s8(cb_lut, vld1q_u8(row_idx[r] + v * 16));
     }
+
+    for (size_t ni = valid_n; ni < 4; ++ni)
+        for (uint32_t v = 0; v < n_vecs; ++v) exp4[ni][v] = vdupq_n_s8(0);
+
+    for (size_t ni = 0; ni < 4; ++ni)
+        nd[ni] = (n_start + ni < W->N)
+            ? static_cast<float>(W->norms[(nb * num_groups + g) * 4 + ni]) * cb_scale
+            : 0.f;
 }
 
 static void tq_preexpand_weights(
@@ -1488,39 +1514,242 @@ static void tq_preexpand_weights(
     const int8x16_t& cb_lut, float cb_scale,
     size_t N_blocks,
     int8_t* w_il, float* n_f32) {
-    if (W != nullptr
-        && (W->flags & CACTUS_QUANT_FLAG_INTERLEAVED_4ROW) != 0
-        && bits >= 1 && bits <= 4
-        && (W->N % 4) == 0
-        && (gs % 32) == 0
-        && gs <= 256) {
-        tq_preexpand_weights_interleaved(W, bits, num_groups, gs, pgb, cb_lut, cb_scale, N_blocks, w_il, n_f32);
-        return;
-    }
     const uint32_t n_vecs = gs / 16;
     for (size_t nb = 0; nb < N_blocks; ++nb) {
-        size_t n_start = nb * 4;
-        size_t valid_n = std::min(size_t(4), static_cast<size_t>(W->N) - n_start);
         for (uint32_t g = 0; g < num_groups; ++g) {
             int8x16_t exp4[4][16];
-            for (size_t ni = 0; ni < valid_n; ++ni) {
-                const uint8_t* p = W->packed_indices + (static_cast<size_t>(n_start+ni)*num_groups+g)*pgb;
-                for (uint32_t v = 0; v < n_vecs; ++v)
-                    exp4[ni][v] = tq_expand_i8_16(p + (v*16*bits)/8, bits, cb_lut);
-            }
-            for (size_t ni = valid_n; ni < 4; ++ni)
-                for (uint32_t v = 0; v < n_vecs; ++v) exp4[ni][v] = vdupq_n_s8(0);
+            tq_decode_panel_i8(W, bits, pgb, cb_lut, cb_scale, nb, g, exp4,
+                               n_f32 + (nb * num_groups + g) * 4);
+            int8_t* dst = w_il + (nb * num_groups + g) * gs * 4;
+            for (uint32_t v = 0; v < n_vecs; ++v)
+                tq_interleave_4x_s8(exp4[0][v], exp4[1][v], exp4[2][v], exp4[3][v], dst + v * 64);
+        }
+    }
+}
+
+static bool cactus_quant_small_m_supported(const CactusQuantMatrix* W, uint32_t M) {
+    return M >= 2 && M <= CACTUS_QUANT_SMALL_M_MAX
+        && W->bits >= 1 && W->bits <= 4
+        && (W->group_size % 32) == 0 && W->group_size <= 256;
+}
 
-            int8_t* dst = w_il + (nb*num_groups+g)*gs*4;
+static bool cactus_quant_small_m_use_i8mm() {
+#if defined(__ARM_FEATURE_MATMUL_INT8)
+    return cpu_has_i8mm();
+#else
+    return false;
+#endif
+}
+
+// SDOT variant: the decoded block is interleaved once into a stack panel and every activation row
+// streams over it, eight lane-dots per 32 K.
+static void cactus_quant_small_m_blocks_sdot(
+    const CactusQuantMatrix* W, uint32_t pgb, const int8x16_t& cb_lut, float cb_scale,
+    const int8_t* act_i8, const float* act_scales, uint32_t M,
+    size_t block_start, size_t block_end, __fp16* C) {
+    const uint32_t gs = W->group_size;
+    const uint32_t num_groups = W->num_groups;
+    const uint32_t n_vecs = gs / 16;
+    const size_t K = W->K;
+
+    for (size_t nb = block_start; nb < block_end; ++nb) {
+        float32x4_t acc[CACTUS_QUANT_SMALL_M_MAX];
+        for (uint32_t mi = 0; mi < M; ++mi) acc[mi] = vdupq_n_f32(0.f);
+
+        for (uint32_t g = 0; g < num_groups; ++g) {
+            int8x16_t exp4[4][16];
+            float nd[4];
+            tq_decode_panel_i8(W, W->bits, pgb, cb_lut, cb_scale, nb, g, exp4, nd);
+            alignas(16) int8_t panel[256 * 4];
             for (uint32_t v = 0; v < n_vecs; ++v)
-                tq_interleave_4x_s8(exp4[0][v], exp4[1][v], exp4[2][v], exp4[3][v], dst + v*64);
-            float* nd = n_f32 + (nb*num_groups+g)*4;
-            for (size_t ni = 0; ni < 4; ++ni)
-                nd[ni] = (n_start+ni < W->N) ? static_cast<float>(W->norms[(n_start+ni)*num_groups+g]) * cb_scale : 0.f;
+                tq_interleave_4x_s8(exp4[0][v], exp4[1][v], exp4[2][v], exp4[3][v], panel + v * 64);
+            const float32x4_t norms_v = vld1q_f32(nd);
+
+            int32x4_t dot[CACTUS_QUANT_SMALL_M_MAX];
+            for (uint32_t mi = 0; mi < M; ++mi) dot[mi] = vdupq_n_s32(0);
+
+            for (uint32_t k = 0; k < gs; k += 32) {
+                const int8_t* bk = panel + k * 4;
+                const int8x16_t b0 = vld1q_s8(bk),      b1 = vld1q_s8(bk + 16);
+                const int8x16_t b2 = vld1q_s8(bk + 32), b3 = vld1q_s8(bk + 48);
+                const int8x16_t b4 = vld1q_s8(bk + 64), b5 = vld1q_s8(bk + 80);
+                const int8x16_t b6 = vld1q_s8(bk + 96), b7 = vld1q_s8(bk + 112);
+                for (uint32_t mi = 0; mi < M; ++mi) {
+                    const int8_t* ap = act_i8 + mi * K + static_cast<size_t>(g) * gs + k;
+                    const int8x16_t a_lo = vld1q_s8(ap);
+                    const int8x16_t a_hi = vld1q_s8(ap + 16);
+                    dot[mi] = CACTUS_DOTQ_LANE(dot[mi], b0, a_lo, 0);
+                    dot[mi] = CACTUS_DOTQ_LANE(dot[mi], b1, a_lo, 1);
+                    dot[mi] = CACTUS_DOTQ_LANE(dot[mi], b2, a_lo, 2);
+                    dot[mi] = CACTUS_DOTQ_LANE(dot[mi], b3, a_lo, 3);
+                    dot[mi] = CACTUS_DOTQ_LANE(dot[mi], b4, a_hi, 0);
+                    dot[mi] = CACTUS_DOTQ_LANE(dot[mi], b5, a_hi, 1);
+                    dot[mi] = CACTUS_DOTQ_LANE(dot[mi], b6, a_hi, 2);
+                    dot[mi] = CACTUS_DOTQ_LANE(dot[mi], b7, a_hi, 3);
+                }
+            }
+
+            for (uint32_t mi = 0; mi < M; ++mi)
+                acc[mi] = vfmaq_f32(acc[mi], vcvtq_f32_s32(dot[mi]),
+                                    vmulq_n_f32(norms_v, act_scales[mi * num_groups + g]));
+        }
+
+        const size_t n_start = nb * 4;
+        const size_t actual_n = std::min(size_t(4), static_cast<size_t>(W->N) - n_start);
+        for (uint32_t mi = 0; mi < M; ++mi) {
+            float16x4_t r = vcvt_f16_f32(acc[mi]);
+            if (actual_n == 4) {
+                vst1_f16(C + mi * W->N + n_start, r);
+            } else {
+                for (size_t ni = 0; ni < actual_n; ni++) {
+                    C[mi * W->N + n_start + ni] = vget_lane_f16(r, 0);
+                    r = vext_f16(r, r, 1);
+                }
+            }
         }
     }
 }
 
+#if defined(__ARM_FEATURE_MATMUL_INT8)
+// SMMLA variant: activations are pre-paired as [row 2p | row 2p+1] x 8 K and the decoded block as
+// [n0 | n1] and [n2 | n3] x 8 K, so one instruction yields a 2x2 tile of dot products.
+static void cactus_quant_small_m_blocks_i8mm(
+    const CactusQuantMatrix* W, uint32_t pgb, const int8x16_t& cb_lut, float cb_scale,
+    const int8_t* act_pairs, const float* act_scales, uint32_t M,
+    size_t block_start, size_t block_end, __fp16* C) {
+    constexpr uint32_t MAX_PAIRS = CACTUS_QUANT_SMALL_M_MAX / 2;
+    const uint32_t gs = W->group_size;
+    const uint32_t num_groups = W->num_groups;
+    const uint32_t n_vecs = gs / 16;
+    const uint32_t n_pairs = (M + 1) / 2;
+    const size_t K = W->K;
+
+    for (size_t nb = block_start; nb < block_end; ++nb) {
+        float32x4_t acc[CACTUS_QUANT_SMALL_M_MAX];
+        for (uint32_t mi = 0; mi < M; ++mi) acc[mi] = vdupq_n_f32(0.f);
+
+        for (uint32_t g = 0; g < num_groups; ++g) {
+            int8x16_t exp4[4][16];
+            float nd[4];
+            tq_decode_panel_i8(W, W->bits, pgb, cb_lut, cb_scale, nb, g, exp4, nd);
+            const float32x4_t norms_v = vld1q_f32(nd);
+
+            int32x4_t mm01[MAX_PAIRS], mm23[MAX_PAIRS];
+            for (uint32_t p = 0; p < n_pairs; ++p) { mm01[p] = vdupq_n_s32(0); mm23[p] = vdupq_n_s32(0); }
+
+            for (uint32_t v = 0; v < n_vecs; ++v) {
+                const int64x2_t r0 = vreinterpretq_s64_s8(exp4[0][v]), r1 = vreinterpretq_s64_s8(exp4[1][v]);
+                const int64x2_t r2 = vreinterpretq_s64_s8(exp4[2][v]), r3 = vreinterpretq_s64_s8(exp4[3][v]);
+                const int8x16_t w01_lo = vreinterpretq_s8_s64(vzip1q_s64(r0, r1));
+                const int8x16_t w01_hi = vreinterpretq_s8_s64(vzip2q_s64(r0, r1));
+                const int8x16_t w23_lo = vreinterpretq_s8_s64(vzip1q_s64(r2, r3));
+                const int8x16_t w23_hi = vreinterpretq_s8_s64(vzip2q_s64(r2, r3));
+                for (uint32_t p = 0; p < n_pairs; ++p) {
+                    const int8_t* ap = act_pairs + (p * K + static_cast<size_t>(g) * gs + v * 16) * 2;
+                    const int8x16_t a_lo = vld1q_s8(ap);
+                    const int8x16_t a_hi = vld1q_s8(ap + 16);
+                    mm01[p] = vmmlaq_s32(mm01[p], a_lo, w01_lo);
+                    mm23[p] = vmmlaq_s32(mm23[p], a_lo, w23_lo);
+                    mm01[p] = vmmlaq_s32(mm01[p], a_hi, w01_hi);
+                    mm23[p] = vmmlaq_s32(mm23[p], a_hi, w23_hi);
+                }
+            }
+
+            for (uint32_t p = 0; p < n_pairs; ++p) {
+                const uint32_t m0 = 2 * p;
+                const int32x4_t row0 = vcombine_s32(vget_low_s32(mm01[p]), vget_low_s32(mm23[p]));
+                acc[m0] = vfmaq_f32(acc[m0], vcvtq_f32_s32(row0),
+                                    vmulq_n_f32(norms_v, act_scales[m0 * num_groups + g]));
+                if (m0 + 1 < M) {
+                    const int32x4_t row1 = vcombine_s32(vget_high_s32(mm01[p]), vget_high_s32(mm23[p]));
+                    acc[m0 + 1] = vfmaq_f32(acc[m0 + 1], vcvtq_f32_s32(row1),
+                                            vmulq_n_f32(norms_v, act_scales[(m0 + 1) * num_groups + g]));
+                }
+            }
+        }
+
+        const size_t n_start = nb * 4;
+        const size_t actual_n = std::min(size_t(4), static_cast<size_t>(W->N) - n_start);
+        for (uint32_t mi = 0; mi < M; ++mi) {
+            float16x4_t r = vcvt_f16_f32(acc[mi]);
+            if (actual_n == 4) {
+                vst1_f16(C + mi * W->N + n_start, r);
+            } else {
+                for (size_t ni = 0; ni < actual_n; ni++) {
+                    C[mi * W->N + n_start + ni] = vget_lane_f16(r, 0);
+                    r = vext_f16(r, r, 1);
+                }
+            }
+        }
+    }
+}
+#endif
+
+void cactus_quant_small_m_gemm(
+    const CactusQuantMatrix* W,
+    const __fp16* A,
+    uint32_t M,
+    __fp16* C) {
+    if (!cactus_quant_valid_common(W, A, C)) return;
+    if (!cactus_quant_small_m_supported(W, M)) return;
+
+    const uint32_t gs = W->group_size;
+    const uint32_t num_groups = W->num_groups;
+    const uint32_t pgb = cactus_quant_packed_group_bytes(W->bits, gs);
+    const size_t K = W->K;
+    const size_t N_blocks = (W->N + 3) / 4;
+
+    thread_local std::vector<__fp16> code_basis;
+    thread_local std::vector<int8_t> act_i8;
+    thread_local std::vector<float> act_scales;
+    if (code_basis.size() < M * K) code_basis.resize(M * K);
+    if (act_i8.size() < M * K) act_i8.resize(M * K);
+    if (act_scales.size() < static_cast<size_t>(M) * num_groups) act_scales.resize(static_cast<size_t>(M) * num_groups);
+
+    cactus_quant_transform_hadamard_activations(*W, A, M, code_basis.data());
+    for (uint32_t m = 0; m < M; ++m)
+        for (uint32_t g = 0; g < num_groups; ++g)
+            act_scales[m * num_groups + g] = tq_quantize_group_i8(
+                code_basis.data() + m * K + static_cast<size_t>(g) * gs,
+                act_i8.data() + m * K + static_cast<size_t>(g) * gs, gs);
+
+    int8_t cb_i8[16] = {};
+    const float cb_scale = tq_quantize_codebook_i8(W->codebook, cb_i8, 1u << W->bits);
+    const int8x16_t cb_lut = vld1q_s8(cb_i8);
+    const int8_t* act = act_i8.data();
+    const float* scales = act_scales.data();
+
+#if defined(__ARM_FEATURE_MATMUL_INT8)
+    if (cactus_quant_small_m_use_i8mm()) {
+        // Row pairs interleaved in 8-byte runs; an odd last row is paired with zeros.
+        thread_local std::vector<int8_t> act_pairs;
+        const uint32_t n_pairs = (M + 1) / 2;
+        if (act_pairs.size() < n_pairs * K * 2) act_pairs.resize(n_pairs * K * 2);
+        for (uint32_t p = 0; p < n_pairs; ++p) {
+            const int8_t* r0 = act + (2 * p) * K;
+            const int8_t* r1 = (2 * p + 1 < M) ? act + (2 * p + 1) * K : nullptr;
+            int8_t* dst = act_pairs.data() + p * K * 2;
+            for (size_t k = 0; k < K; k += 8) {
+                std::memcpy(dst + k * 2, r0 + k, 8);
+                if (r1) std::memcpy(dst + k * 2 + 8, r1 + k, 8);
+                else std::memset(dst + k * 2 + 8, 0, 8);
+            }
+        }
+        const int8_t* pairs = act_pairs.data();
+        cactus_quant_parallel_ranges(N_blocks, 16, [&](size_t block_start, size_t block_end) {
+            cactus_quant_small_m_blocks_i8mm(W, pgb, cb_lut, cb_scale, pairs, scales, M,
+                                             block_start, block_end, C);
+        });
+        return;
+    }
+#endif
+
+    cactus_quant_parallel_ranges(N_blocks, 16, [&](size_t block_start, size_t block_end) {
+        cactus_quant_small_m_blocks_sdot(W, pgb, cb_lut, cb_scale, act, scales, M,
+                                         block_start, block_end, C);
+    });
+}
+
 static void cactus_quant_4bit_gemm_interleaved(
     const CactusQuantMatrix* W, const __fp16* A, uint32_t M, __fp16* C);
 
@@ -1552,7 +1781,8 @@ void cactus_quant_matmul(
                 return;
             }
         } else if (W->bits == 4 && (W->group_size % 32) == 0 && W->group_size <= 256
-                   && (W->N % 4) == 0 && cactus_quant_valid_common(W, A, C)) {
+                   && (W->N % 4) == 0 && cactus_quant_valid_common(W, A, C)
+                   && !(cactus_quant_small_m_supported(W, M) && cactus_quant_small_m_use_i8mm())) {
             cactus_quant_4bit_gemm_interleaved(W, A, M, C);
             return;
         }
@@ -1722,6 +1952,11 @@ void cactus_quant_matmul(
         return;
     }
 
+    if (cactus_quant_small_m_supported(W, M)) {
+        cactus_quant_small_m_gemm(W, A, M, C);
+        return;
+    }
+
     if (!has_sdot_group_layout) {
         cactus_quant_dispatch_group_gemm(W, A, M, C);
         return;
@@ -2426,18 +2661,18 @@ static void cactus_quant_4bit_gemm_interleaved(
     });
 }
 
-void cactus_quant_4bit_gemv_interleaved(
+static bool cactus_quant_4bit_gemv_interleaved_supported(const CactusQuantMatrix* W) {
+    return W->bits == 4 && W->N % 4 == 0 && (W->group_size % 32) == 0 && W->group_size <= 256;
+}
+
+static void cactus_quant_4bit_gemv_interleaved_impl(
     const CactusQuantMatrix* W,
     const uint8_t* packed_interleaved,
     const __fp16* norms_interleaved,
     const __fp16* x,
-    __fp16* y) {
-    if (!cactus_quant_valid_common(W, x, y)) return;
-    if (W->bits != 4) return;
-    if (W->N % 4 != 0) return;
-    if ((W->group_size % 32) != 0) return;
-    if (W->group_size > 256) return;
-
+    __fp16* y,
+    const __fp16* norm_weight,
+    float inv_rms) {
     const uint32_t gs = W->group_size;
     const uint32_t num_groups = W->num_groups;
     const size_t N_blocks = W->N / 4;
@@ -2460,7 +2695,7 @@ void cactus_quant_4bit_gemv_interleaved(
 
     auto phase_a_group = [&](uint32_t g) {
         __fp16 basis[256];
-        cactus_quant_transform_hadamard_group(*W, x + static_cast<size_t>(g) * gs, g, basis);
+        cactus_quant_transform_hadamard_group(*W, x + static_cast<size_t>(g) * gs, g, basis, norm_weight, inv_rms);
         act_scales[g] = tq_quantize_group_i8(basis, act_i8 + static_cast<size_t>(g) * gs, gs);
     };
 
@@ -2482,6 +2717,65 @@ void cactus_quant_4bit_gemv_interleaved(
         });
 }
 
+void cactus_quant_4bit_gemv_interleaved(
+    const CactusQuantMatrix* W,
+    const uint8_t* packed_interleaved,
+    const __fp16* norms_interleaved,
+    const __fp16* x,
+    __fp16* y) {
+    if (!cactus_quant_valid_common(W, x, y)) return;
+    if (!cactus_quant_4bit_gemv_interleaved_supported(W)) return;
+    cactus_quant_4bit_gemv_interleaved_impl(W, packed_interleaved, norms_interleaved, x, y, nullptr, 1.0f);
+}
+
+static float cactus_quant_inv_rms(const __fp16* x, size_t K, float eps) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t k = 0;
+    for (; k + 8 <= K; k += 8) {
+        const float16x8_t v = vld1q_f16(x + k);
+        const float32x4_t lo = vcvt_f32_f16(vget_low_f16(v));
+        const float32x4_t hi = vcvt_f32_f16(vget_high_f16(v));
+        acc0 = vfmaq_f32(acc0, lo, lo);
+        acc1 = vfmaq_f32(acc1, hi, hi);
+    }
+    float sum_squares = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; k < K; ++k) {
+        const float v = static_cast<float>(x[k]);
+        sum_squares += v * v;
+    }
+    return 1.0f / sqrtf(sum_squares / static_cast<float>(K) + eps);
+}
+
+void cactus_quant_rms_norm_matmul(
+    const CactusQuantMatrix* W,
+    const __fp16* x,
+    const __fp16* norm_weight,
+    float eps,
+    uint32_t M,
+    __fp16* y) {
+    if (!cactus_quant_valid_common(W, x, y) || norm_weight == nullptr || M == 0) return;
+
+    const bool fused = M == 1 &&
+                       (W->flags & CACTUS_QUANT_FLAG_ORTHOGONAL) == 0 &&
+                       (W->flags & CACTUS_QUANT_FLAG_INTERLEAVED_4ROW) != 0 &&
+                       cactus_quant_4bit_gemv_interleaved_supported(W);
+    if (fused) {
+        cactus_quant_4bit_gemv_interleaved_impl(W, W->packed_indices, W->norms, x, y,
+                                                norm_weight, cactus_quant_inv_rms(x, W->K, eps));
+        return;
+    }
+
+    thread_local std::vector<__fp16> normed;
+    const size_t count = static_cast<size_t>(M) * W->K;
+    if (normed.size() < count) normed.resize(count);
+    cactus_rms_norm_f16(x, norm_weight, normed.data(), M, W->K, eps);
+    if (W->flags & CACTUS_QUANT_FLAG_ORTHOGONAL)
+        cactus_quant_orthogonal_matmul(W, normed.data(), M, y);
+    else
+        cactus_quant_matmul(W, normed.data(), M, y);
+}
+
 void cactus_quant_3bit_gemv_interleaved(
     const CactusQuantMatrix* W,
     const uint8_t* packed_interleaved,
@@ -277,6 +277,39 @@ void precompute_rope_tables_f16(size_t seq_len, size_t head_dim, float theta) {
 
 }
 
+// Rotates one head's halves [0, half_dim) and [half_dim, 2 * half_dim); input may alias output.
+static inline void rope_rotate_head_f16(const __fp16* input_ptr, __fp16* output_ptr,
+                                        const __fp16* cos_ptr, const __fp16* sin_ptr, size_t half_dim) {
+    constexpr size_t SIMD_WIDTH = 8;
+    const size_t vectorized_half_dim = (half_dim / SIMD_WIDTH) * SIMD_WIDTH;
+
+    for (size_t i = 0; i < vectorized_half_dim; i += SIMD_WIDTH) {
+        float16x8_t cos_vec = vld1q_f16(&cos_ptr[i]);
+        float16x8_t sin_vec = vld1q_f16(&sin_ptr[i]);
+
+        float16x8_t x_first_half = vld1q_f16(&input_ptr[i]);
+        float16x8_t x_second_half = vld1q_f16(&input_ptr[i + half_dim]);
+
+        float16x8_t first_result = vfmsq_f16(vmulq_f16(x_first_half, cos_vec), x_second_half, sin_vec);
+        float16x8_t second_result = vfmaq_f16(vmulq_f16(x_second_half, cos_vec), x_first_half, sin_vec);
+
+        vst1q_f16(&output_ptr[i], first_result);
+        vst1q_f16(&output_ptr[i + half_dim], second_result);
+    }
+
+    for (size_t i = vectorized_half_dim; i < half_dim; ++i) {
+        const __fp16 cos_val = cos_ptr[i];
+        const __fp16 sin_val = sin_ptr[i];
+
+        const __fp16 x_first_half = input_ptr[i];
+        const __fp16 x_second_half = input_ptr[i + half_dim];
+
+        output_ptr[i] = x_first_half * cos_val - x_second_half * sin_val;
+
+        output_ptr[i + half_dim] = x_second_half * cos_val + x_first_half * sin_val;
+    }
+}
+
 void cactus_rope_f16(
     const __fp16* input,
     __fp16* output,
@@ -303,45 +336,46 @@ void cactus_rope_f16(
                 
                 for (size_t head_idx = 0; head_idx < num_heads; ++head_idx) {
                     const size_t offset = ((batch_idx * seq_len + seq_idx) * num_heads + head_idx) * head_dim;
-                    const __fp16* input_ptr = input + offset;
-                    __fp16* output_ptr = output + offset;
-                    
-                    const __fp16* cos_ptr = cos_cache + seq_idx * half_dim;
-                    const __fp16* sin_ptr = sin_cache + seq_idx * half_dim;
-                    
-                    constexpr size_t SIMD_WIDTH = 8;
-                    const size_t vectorized_half_dim = (half_dim / SIMD_WIDTH) * SIMD_WIDTH;
-                    
-                    for (size_t i = 0; i < vectorized_half_dim; i += SIMD_WIDTH) {
-                        float16x8_t cos_vec = vld1q_f16(&cos_ptr[i]);
-                        float16x8_t sin_vec = vld1q_f16(&sin_ptr[i]);
-                        
-                        float16x8_t x_first_half = vld1q_f16(&input_ptr[i]);
-                        float16x8_t x_second_half = vld1q_f16(&input_ptr[i + half_dim]);
-                        
-                        float16x8_t first_result = vfmsq_f16(vmulq_f16(x_first_half, cos_vec), x_second_half, sin_vec);
-                        float16x8_t second_result = vfmaq_f16(vmulq_f16(x_second_half, cos_vec), x_first_half, sin_vec);
-                        
-                        vst1q_f16(&output_ptr[i], first_result);
-                        vst1q_f16(&output_ptr[i + half_dim], second_result);
-                    }
-                    
-                    for (size_t i = vectorized_half_dim; i < half_dim; ++i) {
-                        const __fp16 cos_val = cos_ptr[i];
-                        const __fp16 sin_val = sin_ptr[i];
-                        
-                        const __fp16 x_first_half = input_ptr[i];
-                        const __fp16 x_second_half = input_ptr[i + half_dim];
-                        
-                        output_ptr[i] = x_first_half * cos_val - x_second_half * sin_val;
-                        
-                        output_ptr[i + half_dim] = x_second_half * cos_val + x_first_half * sin_val;
-                    }
+                    rope_rotate_head_f16(input + offset, output + offset,
+                                         cos_cache + seq_idx * half_dim, sin_cache + seq_idx * half_dim, half_dim);
                 }
             }
         });
 } 
 
+void cactus_rope_qk_f16(
+    __fp16* query,
+    __fp16* key,
+    size_t seq_len,
+    size_t num_q_heads,
+    size_t num_kv_heads,
+    size_t head_dim,
+    size_t start_pos,
+    float theta
+) {
+    const size_t half_dim = head_dim / 2;
+    const size_t heads = num_q_heads + num_kv_heads;
+
+    CactusRoPEF16::precompute_rope_tables_f16(seq_len + start_pos, head_dim, theta);
+
+    const auto& cache = *CactusRoPEF16::active_rope_cache_f16;
+    const __fp16* cos_cache = cache.cos_table.data() + start_pos * half_dim;
+    const __fp16* sin_cache = cache.sin_table.data() + start_pos * half_dim;
+
+    // One work item per (token, head) over Q heads then K heads, both reading the token's table row.
+    CactusThreading::parallel_for(seq_len * heads, CactusThreading::Thresholds::SCALAR_EXPENSIVE,
+        [&](size_t start_idx, size_t end_idx) {
+            for (size_t idx = start_idx; idx < end_idx; ++idx) {
+                const size_t seq_idx = idx / heads;
+                const size_t head_idx = idx % heads;
+                __fp16* head = head_idx < num_q_heads
+                    ? query + (seq_idx * num_q_heads + head_idx) * head_dim
+                    : key + (seq_idx * num_kv_heads + head_idx - num_q_heads) * head_dim;
+                rope_rotate_head_f16(head, head, cos_cache + seq_idx * half_dim, sin_cache + seq_idx * half_dim, half_dim);
+            }
+        });
+}
+
 void cactus_gpt_j_rope_f16(
     const __fp16* input,
     __fp16* output,
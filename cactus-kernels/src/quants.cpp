@@ -293,3 +293,152 @@ void cactus_quantize_kv_fp16_to_int8(
         });
 }
 
+void cactus_kv_block_minmax_int8(
+    const int8_t* keys,
+    const float* scales,
+    __fp16* summary,
+    size_t rows,
+    size_t kv_heads,
+    size_t head_dim,
+    bool merge
+) {
+    const size_t num_groups = (head_dim + KV_QUANT_GROUP_SIZE - 1) / KV_QUANT_GROUP_SIZE;
+    for (size_t h = 0; h < kv_heads; ++h) {
+        __fp16* lo = summary + h * 2 * head_dim;
+        __fp16* hi = lo + head_dim;
+        for (size_t r = 0; r < rows; ++r) {
+            const int8_t* row = keys + (r * kv_heads + h) * head_dim;
+            const float* row_scales = scales + (r * kv_heads + h) * num_groups;
+            const bool first = !merge && r == 0;
+            for (size_t d = 0; d < head_dim; ++d) {
+                const float x = row[d] * row_scales[d / KV_QUANT_GROUP_SIZE];
+                lo[d] = static_cast<__fp16>(first ? x : std::min(x, static_cast<float>(lo[d])));
+                hi[d] = static_cast<__fp16>(first ? x : std::max(x, static_cast<float>(hi[d])));
+            }
+        }
+    }
+}
+
+// Asymmetric range [lo, hi] onto codes [0, 2^bits - 1]. Scale and min are rounded to the fp16
+// they are stored as before codes are chosen, so dequantization sees the same grid.
+static inline void lowbit_range(float lo, float hi, size_t bits, __fp16& scale, __fp16& min, float& inv_scale) {
+    const float levels = static_cast<float>((1u << bits) - 1);
+    scale = static_cast<__fp16>((hi - lo) / levels);
+    min = static_cast<__fp16>(lo);
+    const float s = static_cast<float>(scale);
+    inv_scale = s > 0.0f ? 1.0f / s : 0.0f;
+}
+
+static inline uint8_t lowbit_code(float x, float min, float inv_scale, size_t bits) {
+    const int32_t levels = (1 << bits) - 1;
+    int32_t q = static_cast<int32_t>(roundf((x - min) * inv_scale));
+    return static_cast<uint8_t>(std::max(0, std::min(levels, q)));
+}
+
+void cactus_quantize_kv_keys_lowbit(
+    const __fp16* src,
+    uint8_t* dst,
+    size_t kv_heads, size_t head_dim,
+    size_t bits
+) {
+    const size_t row_stride = kv_heads * head_dim;
+    const size_t code_bytes = head_dim * bits / 8;
+    const size_t head_bytes = kv_lowbit_key_block_bytes(1, head_dim, bits);
+
+    CactusThreading::parallel_for(kv_heads, CactusThreading::Thresholds::ELEMENT_WISE,
+        [=](size_t start, size_t end) {
+            for (size_t h = start; h < end; h++) {
+                uint8_t* out = dst + h * head_bytes;
+                __fp16* scales = reinterpret_cast<__fp16*>(out);
+                __fp16* mins = scales + head_dim;
+                uint8_t* codes = out + 2 * head_dim * sizeof(__fp16);
+                std::fill(codes, codes + KV_LOWBIT_BLOCK * code_bytes, uint8_t{0});
+
+                for (size_t c = 0; c < head_dim; c++) {
+                    const __fp16* col = src + h * head_dim + c;
+                    float lo = static_cast<float>(col[0]);
+                    float hi = lo;
+                    for (size_t t = 1; t < KV_LOWBIT_BLOCK; t++) {
+                        const float x = static_cast<float>(col[t * row_stride]);
+                        lo = std::min(lo, x);
+                        hi = std::max(hi, x);
+                    }
+                    float inv_scale;
+                    lowbit_range(lo, hi, bits, scales[c], mins[c], inv_scale);
+                    const float min = static_cast<float>(mins[c]);
+                    const size_t byte = c * bits / 8;
+                    const size_t shift = (c * bits) % 8;
+                    for (size_t t = 0; t < KV_LOWBIT_BLOCK; t++) {
+                        codes[t * code_bytes + byte] |= static_cast<uint8_t>(
+                            lowbit_code(static_cast<float>(col[t * row_stride]), min, inv_scale, bits) << shift);
+                    }
+                }
+            }
+        });
+}
+
+void cactus_dequantize_kv_keys_lowbit(
+    const uint8_t* src,
+    __fp16* dst,
+    size_t rows, size_t kv_heads, size_t head_dim,
+    size_t bits
+) {
+    const size_t row_stride = kv_heads * head_dim;
+    const size_t code_bytes = head_dim * bits / 8;
+    const size_t head_bytes = kv_lowbit_key_block_bytes(1, head_dim, bits);
+    const uint8_t mask = static_cast<uint8_t>((1u << bits) - 1);
+
+    for (size_t h = 0; h < kv_heads; h++) {
+        const uint8_t* in = src + h * head_bytes;
+        const __fp16* scales = reinterpret_cast<const __fp16*>(in);
+        const __fp16* mins = scales + head_dim;
+        const uint8_t* codes = in + 2 * head_dim * sizeof(__fp16);
+        for (size_t t = 0; t < rows; t++) {
+            for (size_t c = 0; c < head_dim; c++) {
+                const uint8_t q = (codes[t * code_bytes + c * bits / 8] >> ((c * bits) % 8)) & mask;
+                dst[t * row_stride + h * head_dim + c] = static_cast<__fp16>(
+                    static_cast<float>(mins[c]) + static_cast<float>(scales[c]) * q);
+            }
+        }
+    }
+}
+
+void cactus_quantize_kv_values_lowbit(
+    const __fp16* src,
+    uint8_t* dst,
+    size_t seq_len, size_t kv_heads, size_t head_dim,
+    size_t bits
+) {
+    const size_t num_groups = head_dim / KV_QUANT_GROUP_SIZE;
+    const size_t code_bytes = head_dim * bits / 8;
+    const size_t head_bytes = kv_lowbit_value_row_bytes(1, head_dim, bits);
+
+    CactusThreading::parallel_for(seq_len * kv_heads, CactusThreading::Thresholds::ELEMENT_WISE,
+        [=](size_t start, size_t end) {
+            for (size_t idx = start; idx < end; idx++) {
+                const __fp16* in = src + idx * head_dim;
+                uint8_t* codes = dst + idx * head_bytes;
+                __fp16* scales = reinterpret_cast<__fp16*>(codes + code_bytes);
+                __fp16* mins = scales + num_groups;
+                std::fill(codes, codes + code_bytes, uint8_t{0});
+
+                for (size_t g = 0; g < num_groups; g++) {
+                    const __fp16* grp = in + g * KV_QUANT_GROUP_SIZE;
+                    float lo = static_cast<float>(grp[0]);
+                    float hi = lo;
+                    for (size_t c = 1; c < KV_QUANT_GROUP_SIZE; c++) {
+                        lo = std::min(lo, static_cast<float>(grp[c]));
+                        hi = std::max(hi, static_cast<float>(grp[c]));
+                    }
+                    float inv_scale;
+                    lowbit_range(lo, hi, bits, scales[g], mins[g], inv_scale);
+                    const float min = static_cast<float>(mins[g]);
+                    for (size_t c = 0; c < KV_QUANT_GROUP_SIZE; c++) {
+                        const size_t ch = g * KV_QUANT_GROUP_SIZE + c;
+                        codes[ch * bits / 8] |= static_cast<uint8_t>(
+                            lowbit_code(static_cast<float>(grp[c]), min, inv_scale, bits) << ((ch * bits) % 8));
+                    }
+                }
+            }
+        });
+}
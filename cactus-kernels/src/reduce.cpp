@@ -2,6 +2,7 @@
 #include "threading.h"
 #include <arm_neon.h>
 #include <algorithm>
+#include <cmath>
 
 template<typename FinalizeFn>
 static void axis_reduce_f32_impl(const __fp16* input, __fp16* output,
@@ -325,3 +326,84 @@ void cactus_max_axis_f16(const __fp16* input, __fp16* output, size_t outer_size,
         [](float16x8_t a, float16x8_t b) { return vmaxq_f16(a, b); },
         [](__fp16 a, __fp16 b) { return std::max(a, b); });
 }
+
+template<typename T, typename WordMaxFn>
+static size_t masked_argmax_impl(const T* logits, const uint64_t* mask, size_t n, float* out_value,
+                                 WordMaxFn word_max_fn) {
+    const size_t full_words = n / 64;
+    float best_v = -INFINITY;
+    size_t best_word = full_words;
+
+    for (size_t w = 0; w < full_words; ++w) {
+        const uint64_t bits = mask[w];
+        if (bits == 0) continue;
+        const float word_max = word_max_fn(logits + w * 64, bits);
+        if (word_max > best_v) {
+            best_v = word_max;
+            best_word = w;
+        }
+    }
+
+    size_t best = n;
+    if (best_word < full_words) {
+        for (uint64_t bits = mask[best_word]; bits; bits &= bits - 1) {
+            const size_t i = best_word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+            if (static_cast<float>(logits[i]) == best_v) {
+                best = i;
+                break;
+            }
+        }
+    }
+    for (size_t i = full_words * 64; i < n; ++i) {
+        if (!((mask[i / 64] >> (i % 64)) & 1)) continue;
+        const float v = static_cast<float>(logits[i]);
+        if (v > best_v) {
+            best_v = v;
+            best = i;
+        }
+    }
+    // Every allowed logit is -inf: still answer with an allowed token, the first one.
+    for (size_t w = 0; best == n && w * 64 < n; ++w) {
+        if (mask[w] == 0) continue;
+        const size_t i = w * 64 + static_cast<size_t>(__builtin_ctzll(mask[w]));
+        if (i < n) best = i;
+        break;
+    }
+
+    if (out_value) *out_value = best_v;
+    return best;
+}
+
+size_t cactus_masked_argmax_f32(const float* logits, const uint64_t* mask, size_t n, float* out_value) {
+    const uint32x4_t lane_bits = {1, 2, 4, 8};
+    const float32x4_t neg_inf = vdupq_n_f32(-INFINITY);
+    return masked_argmax_impl(logits, mask, n, out_value, [&](const float* row, uint64_t bits) {
+        float32x4_t acc = neg_inf;
+        if (bits == ~0ULL) {
+            for (size_t j = 0; j < 64; j += 4) acc = vmaxq_f32(acc, vld1q_f32(row + j));
+        } else {
+            for (size_t j = 0; j < 64; j += 4) {
+                const uint32x4_t keep = vtstq_u32(vdupq_n_u32(static_cast<uint32_t>(bits >> j)), lane_bits);
+                acc = vmaxq_f32(acc, vbslq_f32(keep, vld1q_f32(row + j), neg_inf));
+            }
+        }
+        return vmaxvq_f32(acc);
+    });
+}
+
+size_t cactus_masked_argmax_f16(const __fp16* logits, const uint64_t* mask, size_t n, float* out_value) {
+    const uint16x8_t lane_bits = {1, 2, 4, 8, 16, 32, 64, 128};
+    const float16x8_t neg_inf = vdupq_n_f16(static_cast<__fp16>(-INFINITY));
+    return masked_argmax_impl(logits, mask, n, out_value, [&](const __fp16* row, uint64_t bits) {
+        float16x8_t acc = neg_inf;
+        if (bits == ~0ULL) {
+            for (size_t j = 0; j < 64; j += 8) acc = vmaxq_f16(acc, vld1q_f16(row + j));
+        } else {
+            for (size_t j = 0; j < 64; j += 8) {
+                const uint16x8_t keep = vtstq_u16(vdupq_n_u16(static_cast<uint16_t>(bits >> j)), lane_bits);
+                acc = vmaxq_f16(acc, vbslq_f16(keep, vld1q_f16(row + j), neg_inf));
+            }
+        }
+        return static_cast<float>(vmaxvq_f16(acc));
+    });
+}
@@ -382,6 +382,47 @@ namespace CactusThreading {
     inline void prepare_current_thread_for_cactus_work() {}
 #endif
 
+    // Nesting depth of SerialScope on this thread. While non-zero the pool reports a single worker, so
+    // kernels run inline instead of fanning out (and never block a pool worker on nested pool work).
+    inline size_t& serial_scope_depth() {
+        static thread_local size_t depth = 0;
+        return depth;
+    }
+
+    struct SerialScope {
+        SerialScope() { ++serial_scope_depth(); }
+        ~SerialScope() { --serial_scope_depth(); }
+        SerialScope(const SerialScope&) = delete;
+        SerialScope& operator=(const SerialScope&) = delete;
+    };
+
+    // Optional observer for parallel work chunks, installed by the graph profiler while a traced
+    // execute() is running. Costs one relaxed load per chunk when unset.
+    using ChunkTraceFn = void (*)(size_t start_idx, size_t end_idx, uint64_t begin_ns, uint64_t end_ns);
+
+    inline std::atomic<ChunkTraceFn>& chunk_trace_hook() {
+        static std::atomic<ChunkTraceFn> hook{nullptr};
+        return hook;
+    }
+
+    inline uint64_t trace_clock_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    template<typename F>
+    inline auto traced_chunk(F&& f, size_t start_idx, size_t end_idx) -> decltype(f(start_idx, end_idx)) {
+        ChunkTraceFn hook = chunk_trace_hook().load(std::memory_order_relaxed);
+        if (!hook) return f(start_idx, end_idx);
+        struct Span {
+            ChunkTraceFn hook;
+            size_t start_idx, end_idx;
+            uint64_t begin_ns;
+            ~Span() { hook(start_idx, end_idx, begin_ns, trace_clock_ns()); }
+        } span{hook, start_idx, end_idx, trace_clock_ns()};
+        return f(start_idx, end_idx);
+    }
+
     class ThreadPool {
     private:
         static constexpr size_t MAX_WORKERS = 16;
@@ -500,7 +541,7 @@ namespace CactusThreading {
                 for (size_t w = 0; w < num_tasks; ++w) {
                     size_t start = w * per_worker + std::min(w, remainder);
                     size_t end = start + per_worker + (w < remainder ? 1 : 0);
-                    tasks.emplace_back([=]() { task_func(start, end); });
+                    tasks.emplace_back([=]() { traced_chunk(task_func, start, end); });
                 }
             }
             work_available.notify_all();
@@ -534,13 +575,13 @@ namespace CactusThreading {
                 for (size_t t = 0; t < num_tasks; ++t) {
                     size_t start = t * per_task + std::min(t, remainder);
                     size_t end = start + per_task + (t < remainder ? 1 : 0);
-                    tasks.emplace_back([=]() { task_func(start, end); });
+                    tasks.emplace_back([=]() { traced_chunk(task_func, start, end); });
                 }
             }
             work_available.notify_all();
         }
 
-        size_t num_workers() const { return num_workers_; }
+        size_t num_workers() const { return serial_scope_depth() > 0 ? 1 : num_workers_; }
     };
 
     inline ThreadPool& get_thread_pool() {
@@ -679,12 +720,12 @@ namespace CactusThreading {
 
         if (num_threads == 1) {
             if (wait) {
-                work_func(0, total_work);
+                traced_chunk(work_func, 0, total_work);
                 return handle;
             }
             auto& pool = get_thread_pool();
             handle.add_future(pool.enqueue([work_func, total_work]() {
-                work_func(0, total_work);
+                traced_chunk(work_func, 0, total_work);
             }));
             return handle;
         }
@@ -704,7 +745,7 @@ namespace CactusThreading {
             handle.add_future(pool.enqueue([work_func, t, num_threads, work_per_thread, total_work]() {
                 const size_t start_idx = t * work_per_thread;
                 const size_t end_idx = (t == num_threads - 1) ? total_work : (t + 1) * work_per_thread;
-                work_func(start_idx, end_idx);
+                traced_chunk(work_func, start_idx, end_idx);
             }));
         }
 
@@ -732,7 +773,7 @@ namespace CactusThreading {
         const size_t num_threads = get_optimal_thread_count(total_work, config);
         
         if (num_threads == 1) {
-            return work_func(0, total_work);
+            return traced_chunk(work_func, 0, total_work);
         }
         
         auto& pool = get_thread_pool();
@@ -744,7 +785,7 @@ namespace CactusThreading {
             futures.push_back(pool.enqueue([work_func, t, num_threads, work_per_thread, total_work]() -> ResultType {
                 const size_t start_idx = t * work_per_thread;
                 const size_t end_idx = (t == num_threads - 1) ? total_work : (t + 1) * work_per_thread;
-                return work_func(start_idx, end_idx);
+                return traced_chunk(work_func, start_idx, end_idx);
             }));
         }
         
@@ -764,7 +805,7 @@ namespace CactusThreading {
         num_threads = std::min(num_threads, total_tiles);
 
         if (num_threads <= 1) {
-            work_func(0, total_tiles);
+            traced_chunk(work_func, 0, total_tiles);
             return;
         }
 
@@ -1,4 +1,5 @@
 #include "test_utils.h"
+#include <algorithm>
 #include <vector>
 #include <cmath>
 
@@ -76,6 +77,118 @@ bool test_attention_f16() {
     return true;
 }
 
+bool test_attention_ring_masked() {
+    // A masked call takes the general path, which must read ring-ordered rows in logical order.
+    const size_t seq = 1, kv_len = 12, heads = 2, kv_heads = 1, dim = 16;
+    std::vector<__fp16> q(seq * heads * dim), k(kv_len * kv_heads * dim), v(kv_len * kv_heads * dim);
+    fill_random_fp16(q, -0.5f, 0.5f); fill_random_fp16(k, -0.5f, 0.5f); fill_random_fp16(v, -0.5f, 0.5f);
+    CactusKVRing ring;
+    ring.sink = 2; ring.head = 3; ring.span = kv_len - ring.sink;
+    std::vector<__fp16> k_ring(k.size()), v_ring(v.size());
+    const size_t row = kv_heads * dim;
+    for (size_t i = 0; i < kv_len; i++) {
+        std::copy_n(k.begin() + i * row, row, k_ring.begin() + ring.row(i) * row);
+        std::copy_n(v.begin() + i * row, row, v_ring.begin() + ring.row(i) * row);
+    }
+    std::vector<__fp16> mask(heads * seq * kv_len, static_cast<__fp16>(0.0f));
+    std::vector<__fp16> expected(seq * heads * dim), actual(seq * heads * dim);
+    const float scale = 1.0f / std::sqrt(static_cast<float>(dim));
+    cactus_attention_f16(q.data(), k.data(), v.data(), expected.data(), 1, seq, kv_len, heads, kv_heads, dim, scale,
+                         mask.data(), kv_len - seq, 0, true, true, false, 0, 0.0f);
+    cactus_attention_f16(q.data(), k_ring.data(), v_ring.data(), actual.data(), 1, seq, kv_len, heads, kv_heads, dim, scale,
+                         mask.data(), kv_len - seq, 0, true, true, false, 0, 0.0f, ring);
+    return compare_arrays(expected.data(), actual.data(), expected.size(), 1e-3f);
+}
+
+bool test_attention_shared_prefix() {
+    // Rows [0, shared) read from a separate prefix buffer and the rest from the slot's own rows must
+    // attend exactly like one contiguous buffer, on both the fast and the masked path.
+    const size_t seq = 1, kv_len = 12, shared = 7, heads = 2, kv_heads = 1, dim = 16;
+    std::vector<__fp16> q(seq * heads * dim), k(kv_len * kv_heads * dim), v(kv_len * kv_heads * dim);
+    fill_random_fp16(q, -0.5f, 0.5f); fill_random_fp16(k, -0.5f, 0.5f); fill_random_fp16(v, -0.5f, 0.5f);
+    const size_t row = kv_heads * dim;
+    std::vector<__fp16> k_tail(k.begin() + shared * row, k.end()), v_tail(v.begin() + shared * row, v.end());
+    CactusKVRing ring;
+    ring.shared = shared; ring.shared_keys = k.data(); ring.shared_values = v.data();
+    std::vector<__fp16> mask(heads * seq * kv_len, static_cast<__fp16>(0.0f));
+    std::vector<__fp16> expected(seq * heads * dim), actual(seq * heads * dim);
+    const float scale = 1.0f / std::sqrt(static_cast<float>(dim));
+    for (const __fp16* m : {static_cast<const __fp16*>(nullptr), static_cast<const __fp16*>(mask.data())}) {
+        cactus_attention_f16(q.data(), k.data(), v.data(), expected.data(), 1, seq, kv_len, heads, kv_heads, dim, scale,
+                             m, kv_len - seq, 0, true, true, false, 0, 0.0f);
+        cactus_attention_f16(q.data(), k_tail.data(), v_tail.data(), actual.data(), 1, seq, kv_len, heads, kv_heads, dim,
+                             scale, m, kv_len - seq, 0, true, true, false, 0, 0.0f, ring);
+        if (!compare_arrays(expected.data(), actual.data(), expected.size(), 1e-3f)) return false;
+    }
+    return true;
+}
+
+bool test_gated_deltanet() {
+    // Reference is the per-token recurrence (chunk size 1). T spans several chunks plus a tail and
+    // V is not a multiple of the column block, so both the chunked prefill and the split decode
+    // exercise their edges.
+    const size_t B = 1, T = 45, Hq = 1, Hv = 2, K = 32, V = 40;
+    std::vector<__fp16> q(B * T * Hq * K), k(B * T * Hq * K), v(B * T * Hv * V);
+    std::vector<__fp16> g(B * T * Hv), beta(B * T * Hv), state(B * K * Hv * V);
+    fill_random_fp16(q, -0.3f, 0.3f); fill_random_fp16(k, -0.3f, 0.3f); fill_random_fp16(v);
+    fill_random_fp16(g, -0.5f, 0.0f); fill_random_fp16(beta, 0.0f, 1.0f); fill_random_fp16(state, -0.2f, 0.2f);
+    const float scale = 1.0f / std::sqrt(static_cast<float>(K));
+
+    std::vector<__fp16> ref(B * (T + K) * Hv * V), chunked(ref.size());
+    cactus_gated_deltanet_prefill_f16(q.data(), k.data(), v.data(), g.data(), beta.data(), state.data(), ref.data(),
+                                      B, T, Hq, Hv, K, V, 1, scale);
+    cactus_gated_deltanet_prefill_f16(q.data(), k.data(), v.data(), g.data(), beta.data(), state.data(), chunked.data(),
+                                      B, T, Hq, Hv, K, V, 16, scale);
+    if (!compare_arrays(ref.data(), chunked.data(), ref.size(), 2e-2f)) return false;
+
+    std::vector<__fp16> step(B * (1 + K) * Hv * V), decoded(step.size());
+    cactus_gated_deltanet_prefill_f16(q.data(), k.data(), v.data(), g.data(), beta.data(), state.data(), step.data(),
+                                      B, 1, Hq, Hv, K, V, 1, scale);
+    cactus_gated_deltanet_decode_f16(q.data(), k.data(), v.data(), g.data(), beta.data(), state.data(), decoded.data(),
+                                     B, Hq, Hv, K, V, scale);
+    return compare_arrays(step.data(), decoded.data(), step.size(), 1e-2f);
+}
+
+bool test_bilstm_sequence() {
+    // H is neither a multiple of the 4-unit gate block nor of the 8-wide dot product, and B = 2
+    // gives four independent direction tasks.
+    const size_t B = 2, T = 19, I = 24, H = 22, G = 4 * H;
+    std::vector<__fp16> x(B * T * I), out(B * T * 2 * H);
+    std::vector<__fp16> w_ih[2], w_hh[2], b_ih[2], b_hh[2];
+    fill_random_fp16(x);
+    for (int d = 0; d < 2; ++d) {
+        w_ih[d].resize(G * I); w_hh[d].resize(G * H); b_ih[d].resize(G); b_hh[d].resize(G);
+        fill_random_fp16(w_ih[d], -0.3f, 0.3f); fill_random_fp16(w_hh[d], -0.3f, 0.3f);
+        fill_random_fp16(b_ih[d], -0.2f, 0.2f); fill_random_fp16(b_hh[d], -0.2f, 0.2f);
+    }
+    cactus_bilstm_sequence_f16(x.data(), w_ih[0].data(), w_hh[0].data(), b_ih[0].data(), b_hh[0].data(),
+                               w_ih[1].data(), w_hh[1].data(), b_ih[1].data(), b_hh[1].data(),
+                               out.data(), B, T, I, H);
+
+    auto sigmoid = [](double v) { return 1.0 / (1.0 + std::exp(-v)); };
+    for (size_t b = 0; b < B; ++b) {
+        for (size_t d = 0; d < 2; ++d) {
+            std::vector<double> h(H, 0.0), c(H, 0.0), pre(G);
+            for (size_t step = 0; step < T; ++step) {
+                const size_t t = d ? T - 1 - step : step;
+                for (size_t g = 0; g < G; ++g) {
+                    double acc = static_cast<double>(b_ih[d][g]) + static_cast<double>(b_hh[d][g]);
+                    for (size_t i = 0; i < I; ++i) acc += static_cast<double>(w_ih[d][g * I + i]) * static_cast<double>(x[(b * T + t) * I + i]);
+                    for (size_t k = 0; k < H; ++k) acc += static_cast<double>(w_hh[d][g * H + k]) * h[k];
+                    pre[g] = acc;
+                }
+                for (size_t j = 0; j < H; ++j) {
+                    c[j] = sigmoid(pre[H + j]) * c[j] + sigmoid(pre[j]) * std::tanh(pre[2 * H + j]);
+                    h[j] = sigmoid(pre[3 * H + j]) * std::tanh(c[j]);
+                    const float got = static_cast<float>(out[(b * T + t) * 2 * H + d * H + j]);
+                    if (std::abs(got - static_cast<float>(h[j])) > 1e-2f) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
 bool run_benchmarks() {
     auto bench = [](const char* label, auto fn) {
         fn();
@@ -131,6 +244,10 @@ int main() {
     runner.run_test("softmax", test_softmax());
     runner.run_test("rope", test_rope());
     runner.run_test("attention_f16", test_attention_f16());
+    runner.run_test("attention_ring_masked", test_attention_ring_masked());
+    runner.run_test("attention_shared_prefix", test_attention_shared_prefix());
+    runner.run_test("gated_deltanet", test_gated_deltanet());
+    runner.run_test("bilstm_sequence", test_bilstm_sequence());
     runner.print_benchmarks_header();
     runner.run_bench("benchmarks", run_benchmarks());
     runner.print_summary();
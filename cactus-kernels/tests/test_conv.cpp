@@ -4,6 +4,10 @@
 
 using namespace TestUtils;
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 bool test_conv1d_k3() {
     const size_t N = 1, L = 32, C_in = 8, C_out = 16, stride = 1;
     const size_t L_out = ((L - 1) / stride) + 1;
@@ -60,6 +64,48 @@ bool test_stft_complex() {
     return true;
 }
 
+static std::vector<__fp16> make_stft_dft_basis(size_t K, size_t n_fft, size_t num_fft_bins) {
+    std::vector<__fp16> weight(2 * num_fft_bins * K);
+    for (size_t bin = 0; bin < num_fft_bins; bin++) {
+        for (size_t k = 0; k < K; k++) {
+            const double w = 0.5 - 0.5 * std::cos(2.0 * M_PI * k / K);
+            const double angle = 2.0 * M_PI * static_cast<double>((bin * k) % n_fft) / n_fft;
+            weight[bin * K + k] = static_cast<__fp16>(w * std::cos(angle));
+            weight[(bin + num_fft_bins) * K + k] = static_cast<__fp16>(-w * std::sin(angle));
+        }
+    }
+    return weight;
+}
+
+bool test_stft_dft_basis() {
+    const size_t N = 2, L = 2000, C_in = 1, K = 400, stride = 160, n_fft = 512;
+    const size_t num_fft_bins = n_fft / 2 + 1;
+    const size_t num_frames = (L - K) / stride + 1;
+    std::vector<__fp16> input(N * L);
+    fill_random_fp16(input, -1.0f, 1.0f);
+    std::vector<__fp16> weight = make_stft_dft_basis(K, n_fft, num_fft_bins);
+    std::vector<__fp16> output(N * num_frames * num_fft_bins * 2);
+
+    cactus_stft_f16(input.data(), weight.data(), output.data(), N, L, C_in, 2 * num_fft_bins, K, stride, num_fft_bins);
+
+    for (size_t n = 0; n < N; n++) {
+        for (size_t c = 0; c < 2 * num_fft_bins; c++) {
+            for (size_t t = 0; t < num_frames; t++) {
+                double expected = 0.0;
+                for (size_t k = 0; k < K; k++)
+                    expected += static_cast<double>(input[n * L + t * stride + k]) * static_cast<double>(weight[c * K + k]);
+                const float got = static_cast<float>(output[(n * 2 * num_fft_bins + c) * num_frames + t]);
+                if (std::abs(got - expected) > 0.05 + 0.01 * std::abs(expected)) {
+                    std::cerr << "  stft dft basis: mismatch at n=" << n << " c=" << c << " t=" << t
+                              << ": " << got << " vs " << expected << "\n";
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
 bool test_maxpool1d() {
     const size_t batch = 1, channels = 4, length = 16, kernel = 3, stride = 2;
     const size_t out_len = (length - kernel) / stride + 1;
@@ -86,6 +132,88 @@ bool test_maxpool1d() {
     return true;
 }
 
+struct Conv2dCase {
+    size_t N, C_in, H, W, C_out, KH, KW, stride, padding, dilation, groups;
+    bool nhwc_input, nhwc_output;
+};
+
+// Direct convolution in double precision over NCHW/OIHW, the reference for every engine path.
+static std::vector<double> conv2d_reference(const Conv2dCase& c, const std::vector<__fp16>& x_nchw,
+                                            const std::vector<__fp16>& w, const std::vector<__fp16>& b,
+                                            size_t H_out, size_t W_out) {
+    const size_t cig = c.C_in / c.groups, cog = c.C_out / c.groups;
+    std::vector<double> y(c.N * c.C_out * H_out * W_out);
+    for (size_t n = 0; n < c.N; n++)
+        for (size_t oc = 0; oc < c.C_out; oc++)
+            for (size_t oy = 0; oy < H_out; oy++)
+                for (size_t ox = 0; ox < W_out; ox++) {
+                    double acc = static_cast<double>(b[oc]);
+                    const size_t g = oc / cog;
+                    for (size_t ic = 0; ic < cig; ic++)
+                        for (size_t kh = 0; kh < c.KH; kh++)
+                            for (size_t kw = 0; kw < c.KW; kw++) {
+                                const long iy = static_cast<long>(oy * c.stride + kh * c.dilation) - static_cast<long>(c.padding);
+                                const long ix = static_cast<long>(ox * c.stride + kw * c.dilation) - static_cast<long>(c.padding);
+                                if (iy < 0 || ix < 0 || iy >= static_cast<long>(c.H) || ix >= static_cast<long>(c.W)) continue;
+                                acc += static_cast<double>(x_nchw[((n * c.C_in + g * cig + ic) * c.H + iy) * c.W + ix]) *
+                                       static_cast<double>(w[((oc * cig + ic) * c.KH + kh) * c.KW + kw]);
+                            }
+                    y[((n * c.C_out + oc) * H_out + oy) * W_out + ox] = acc;
+                }
+    return y;
+}
+
+static bool check_conv2d(const Conv2dCase& c) {
+    const size_t H_out = (c.H + 2 * c.padding - c.dilation * (c.KH - 1) - 1) / c.stride + 1;
+    const size_t W_out = (c.W + 2 * c.padding - c.dilation * (c.KW - 1) - 1) / c.stride + 1;
+    std::vector<__fp16> x(c.N * c.C_in * c.H * c.W), w(c.C_out * (c.C_in / c.groups) * c.KH * c.KW), b(c.C_out);
+    fill_random_fp16(x, -1.0f, 1.0f);
+    fill_random_fp16(w, -0.3f, 0.3f);
+    fill_random_fp16(b, -0.5f, 0.5f);
+    const auto ref = conv2d_reference(c, x, w, b, H_out, W_out);
+
+    std::vector<__fp16> x_in(x.size());
+    for (size_t n = 0; n < c.N; n++)
+        for (size_t ch = 0; ch < c.C_in; ch++)
+            for (size_t hw = 0; hw < c.H * c.W; hw++) {
+                const size_t src = (n * c.C_in + ch) * c.H * c.W + hw;
+                x_in[c.nhwc_input ? (n * c.H * c.W + hw) * c.C_in + ch : src] = x[src];
+            }
+    std::vector<__fp16> y(ref.size());
+    cactus_conv2d_f16(x_in.data(), w.data(), b.data(), y.data(), c.N, c.C_in, c.H, c.W, c.C_out, c.KH, c.KW,
+                      c.stride, c.padding, c.dilation, c.groups, c.nhwc_input, c.nhwc_output);
+
+    for (size_t n = 0; n < c.N; n++)
+        for (size_t oc = 0; oc < c.C_out; oc++)
+            for (size_t hw = 0; hw < H_out * W_out; hw++) {
+                const size_t ref_idx = (n * c.C_out + oc) * H_out * W_out + hw;
+                const size_t got_idx = c.nhwc_output ? (n * H_out * W_out + hw) * c.C_out + oc : ref_idx;
+                const double got = static_cast<double>(y[got_idx]);
+                if (std::abs(got - ref[ref_idx]) > 0.05 + 0.01 * std::abs(ref[ref_idx])) {
+                    std::cerr << "  conv2d " << c.KH << "x" << c.KW << " s" << c.stride << " d" << c.dilation
+                              << " g" << c.groups << ": mismatch at oc=" << oc << " hw=" << hw << ": "
+                              << got << " vs " << ref[ref_idx] << "\n";
+                    return false;
+                }
+            }
+    return true;
+}
+
+bool test_conv2d_winograd() {
+    // Odd spatial sizes leave partial 4x4 output tiles; odd channel counts exercise the lane padding.
+    return check_conv2d({2, 13, 11, 9, 10, 3, 3, 1, 1, 1, 1, false, false}) &&
+           check_conv2d({1, 16, 8, 8, 12, 3, 3, 1, 1, 1, 1, true, true}) &&
+           check_conv2d({1, 9, 7, 10, 8, 3, 3, 1, 0, 1, 1, false, true});
+}
+
+bool test_conv2d_im2col() {
+    return check_conv2d({1, 6, 15, 13, 7, 5, 5, 2, 2, 1, 1, false, false}) &&
+           check_conv2d({1, 8, 12, 12, 8, 3, 3, 1, 2, 2, 1, true, false}) &&
+           check_conv2d({2, 8, 9, 9, 6, 3, 3, 1, 1, 1, 2, false, false}) &&
+           check_conv2d({1, 24, 10, 10, 16, 1, 1, 1, 0, 1, 1, true, true}) &&
+           check_conv2d({1, 3, 33, 31, 8, 3, 3, 2, 1, 1, 1, false, false});
+}
+
 bool run_benchmarks() {
     {
         const size_t N = 1, L = 3000, C_in = 80, C_out = 512, stride = 1;
@@ -136,6 +264,22 @@ bool run_benchmarks() {
                   << std::fixed << std::setprecision(3) << ms << "ms  "
                   << std::setprecision(1) << ms << " ms\n";
     }
+    {
+        const size_t N = 1, L = 16000 * 10, C_in = 1, K = 400, stride = 160, n_fft = 512;
+        const size_t num_fft_bins = n_fft / 2 + 1;
+        const size_t num_frames = (L - K) / stride + 1;
+        std::vector<__fp16> input(N * L);
+        fill_random_fp16(input, -1.0f, 1.0f);
+        std::vector<__fp16> weight = make_stft_dft_basis(K, n_fft, num_fft_bins);
+        std::vector<__fp16> output(N * num_frames * num_fft_bins * 2);
+        cactus_stft_f16(input.data(), weight.data(), output.data(), N, L, C_in, 2 * num_fft_bins, K, stride, num_fft_bins);
+        Timer t;
+        for (int i = 0; i < 10; i++)
+            cactus_stft_f16(input.data(), weight.data(), output.data(), N, L, C_in, 2 * num_fft_bins, K, stride, num_fft_bins);
+        double ms = t.elapsed_ms() / 10.0;
+        std::cout << "  ⚡ " << std::left << std::setw(28) << "stft 10s k400 n_fft512 (fft)"
+                  << std::fixed << std::setprecision(3) << ms << "ms\n";
+    }
     return true;
 }
 
@@ -144,7 +288,10 @@ int main() {
     runner.run_test("conv1d_k3", test_conv1d_k3());
     runner.run_test("conv1d_causal_depthwise", test_conv1d_causal_depthwise());
     runner.run_test("stft_complex", test_stft_complex());
+    runner.run_test("stft_dft_basis", test_stft_dft_basis());
     runner.run_test("maxpool1d", test_maxpool1d());
+    runner.run_test("conv2d_winograd", test_conv2d_winograd());
+    runner.run_test("conv2d_im2col", test_conv2d_im2col());
     runner.print_benchmarks_header();
     runner.run_bench("benchmarks", run_benchmarks());
     runner.print_summary();
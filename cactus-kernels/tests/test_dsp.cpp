@@ -2,6 +2,8 @@
 #include <vector>
 #include <cmath>
 #include <cstring>
+#include <random>
+#include <string>
 
 using namespace TestUtils;
 
@@ -54,6 +56,69 @@ bool test_rfft_dc_signal() {
     return true;
 }
 
+static void naive_rfft(const std::vector<float>& input, std::vector<double>& out) {
+    const size_t n = input.size();
+    out.assign((n / 2 + 1) * 2, 0.0);
+    for (size_t k = 0; k <= n / 2; k++) {
+        for (size_t t = 0; t < n; t++) {
+            const double angle = -2.0 * M_PI * static_cast<double>((k * t) % n) / static_cast<double>(n);
+            out[k * 2] += input[t] * std::cos(angle);
+            out[k * 2 + 1] += input[t] * std::sin(angle);
+        }
+    }
+}
+
+bool test_rfft_mixed_radix_matches_dft() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (size_t n : {2, 3, 30, 77, 160, 321, 320, 400, 480, 512, 1024}) {
+        std::vector<float> input(n);
+        for (auto& v : input) v = dist(rng);
+
+        std::vector<double> expected;
+        naive_rfft(input, expected);
+        std::vector<float> freq((n / 2 + 1) * 2);
+        cactus_rfft_f32_1d(input.data(), freq.data(), n, "backward");
+
+        const double tol = 1e-4 * static_cast<double>(n);
+        for (size_t i = 0; i < freq.size(); i++) {
+            if (std::abs(freq[i] - expected[i]) > tol) {
+                std::cerr << "  n=" << n << " mismatch at " << i << ": " << freq[i] << " vs " << expected[i] << "\n";
+                return false;
+            }
+        }
+
+        std::vector<float> recovered(n);
+        cactus_irfft_f32_1d(freq.data(), recovered.data(), n, "backward");
+        for (size_t i = 0; i < n; i++) {
+            if (std::abs(recovered[i] - input[i]) > 1e-4f) {
+                std::cerr << "  n=" << n << " roundtrip mismatch at " << i << ": " << recovered[i] << " vs " << input[i] << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool test_rfft_batch_matches_single() {
+    const size_t n = 400, stride = 416, num_frames = 37, out_stride = (n / 2 + 1) * 2;
+    std::vector<float> input(num_frames * stride);
+    for (size_t i = 0; i < input.size(); i++) input[i] = std::sin(0.013f * static_cast<float>(i * i % 977));
+
+    std::vector<float> batch(num_frames * out_stride);
+    cactus_rfft_f32_batch(input.data(), stride, batch.data(), out_stride, n, num_frames, "ortho");
+
+    std::vector<float> single(out_stride);
+    for (size_t f = 0; f < num_frames; f++) {
+        cactus_rfft_f32_1d(input.data() + f * stride, single.data(), n, "ortho");
+        if (std::memcmp(single.data(), batch.data() + f * out_stride, out_stride * sizeof(float)) != 0) {
+            std::cerr << "  batch frame " << f << " differs from single-frame rfft\n";
+            return false;
+        }
+    }
+    return true;
+}
+
 bool test_mel_filter_bank() {
     const int num_freq_bins = 257;
     const int num_mel_filters = 80;
@@ -166,6 +231,85 @@ bool test_spectrogram_to_db() {
     return true;
 }
 
+static bool check_stream_matches_batch(
+    size_t n_fft, size_t fft_length, bool center, const char* pad_mode,
+    const float* preemphasis, const char* log_mel, size_t num_samples) {
+
+    const size_t hop = 160;
+    const size_t num_freq_bins = fft_length / 2 + 1;
+    const size_t num_mel_bins = 80;
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dis(-0.5f, 0.5f);
+    std::vector<float> waveform(num_samples);
+    for (auto& x : waveform) x = dis(gen);
+
+    std::vector<float> mel_filters(num_mel_bins * num_freq_bins);
+    cactus_generate_mel_filter_bank(
+        mel_filters.data(), static_cast<int>(num_freq_bins), static_cast<int>(num_mel_bins),
+        0.0f, 8000.0f, 16000, "slaney", "slaney", false);
+
+    const size_t padded_length = num_samples + (center ? 2 * (n_fft / 2) : 0);
+    const size_t num_frames = 1 + (padded_length - n_fft) / hop;
+    std::vector<float> batch(num_mel_bins * num_frames);
+    cactus_compute_spectrogram_f32(
+        waveform.data(), num_samples, nullptr, 0,
+        n_fft, hop, &fft_length,
+        batch.data(), 2.0f,
+        center, pad_mode, true,
+        0.0f, preemphasis,
+        mel_filters.data(), mel_filters.size(),
+        1e-10f, log_mel,
+        1.0f, 1e-10f, nullptr, false);
+
+    CactusSpectrogramStream* stream = cactus_spectrogram_stream_create(
+        nullptr, 0, n_fft, hop, &fft_length,
+        2.0f, center, pad_mode, preemphasis,
+        mel_filters.data(), mel_filters.size(),
+        1e-10f, log_mel, 1.0f, 1e-10f, false);
+
+    std::vector<float> streamed;
+    std::vector<float> frames;
+    std::uniform_int_distribution<size_t> chunk_dist(1, 1200);
+    size_t offset = 0;
+    auto drain = [&](size_t ready) {
+        frames.resize(ready * num_mel_bins);
+        size_t got = cactus_spectrogram_stream_read(stream, frames.data(), ready);
+        streamed.insert(streamed.end(), frames.begin(), frames.begin() + got * num_mel_bins);
+    };
+    while (offset < num_samples) {
+        size_t chunk = std::min(chunk_dist(gen), num_samples - offset);
+        drain(cactus_spectrogram_stream_push(stream, waveform.data() + offset, chunk));
+        offset += chunk;
+    }
+    drain(cactus_spectrogram_stream_finish(stream));
+    cactus_spectrogram_stream_destroy(stream);
+
+    if (streamed.size() != batch.size()) {
+        std::cerr << "  stream produced " << streamed.size() / num_mel_bins
+                  << " frames, batch " << num_frames << "\n";
+        return false;
+    }
+    for (size_t t = 0; t < num_frames; t++) {
+        for (size_t m = 0; m < num_mel_bins; m++) {
+            float a = streamed[t * num_mel_bins + m];
+            float b = batch[m * num_frames + t];
+            if (std::memcmp(&a, &b, sizeof(float)) != 0) {
+                std::cerr << "  frame " << t << " mel " << m << ": " << a << " vs " << b << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool test_spectrogram_stream_matches_batch() {
+    const float preemph = 0.97f;
+    return check_stream_matches_batch(400, 400, true, "reflect", nullptr, "log10", 16000 * 2 + 37)
+        && check_stream_matches_batch(400, 512, true, "constant", &preemph, "log", 16000 + 5)
+        && check_stream_matches_batch(400, 512, false, "constant", nullptr, nullptr, 8000);
+}
+
 bool run_benchmarks() {
     auto bench = [](const char* label, auto fn) {
         fn();
@@ -176,11 +320,21 @@ bool run_benchmarks() {
                   << std::fixed << std::setprecision(3) << ms << " ms\n";
     };
 
-    {
-        const size_t n = 512;
+    for (size_t n : {256, 320, 400, 480, 512, 1024}) {
         std::vector<float> input(n, 1.0f);
         std::vector<float> output((n / 2 + 1) * 2);
-        bench("rfft 512", [&]{ cactus_rfft_f32_1d(input.data(), output.data(), n, "backward"); });
+        const std::string label = "rfft " + std::to_string(n);
+        bench(label.c_str(), [&]{ cactus_rfft_f32_1d(input.data(), output.data(), n, "backward"); });
+    }
+
+    for (size_t n : {400, 512}) {
+        const size_t num_frames = 1001;
+        std::vector<float> input(num_frames * n, 1.0f);
+        std::vector<float> output(num_frames * (n / 2 + 1) * 2);
+        const std::string label = "rfft batch " + std::to_string(num_frames) + "x" + std::to_string(n);
+        bench(label.c_str(), [&]{
+            cactus_rfft_f32_batch(input.data(), n, output.data(), (n / 2 + 1) * 2, n, num_frames, "backward");
+        });
     }
 
     {
@@ -191,6 +345,41 @@ bool run_benchmarks() {
         bench("irfft 512", [&]{ cactus_irfft_f32_1d(input.data(), output.data(), n, "backward"); });
     }
 
+    {
+        const size_t window_samples = 16000 * 10;
+        const size_t chunk_samples = 1600;
+        const size_t n_fft = 400, hop = 160, fft_length = 512, num_mel_bins = 80;
+        const size_t num_freq_bins = fft_length / 2 + 1;
+        std::vector<float> waveform(window_samples + chunk_samples);
+        for (size_t i = 0; i < waveform.size(); i++) waveform[i] = std::sin(0.01f * static_cast<float>(i));
+        std::vector<float> mel_filters(num_mel_bins * num_freq_bins);
+        cactus_generate_mel_filter_bank(
+            mel_filters.data(), static_cast<int>(num_freq_bins), static_cast<int>(num_mel_bins),
+            0.0f, 8000.0f, 16000, "slaney", "slaney", false);
+
+        const size_t num_frames = 1 + window_samples / hop;
+        std::vector<float> batch(num_mel_bins * num_frames);
+        bench("log-mel 10s window recompute", [&]{
+            cactus_compute_spectrogram_f32(
+                waveform.data(), window_samples, nullptr, 0, n_fft, hop, &fft_length,
+                batch.data(), 2.0f, true, "constant", true, 0.0f, nullptr,
+                mel_filters.data(), mel_filters.size(), 1e-10f, "log", 1.0f, 1e-10f, nullptr, false);
+        });
+
+        CactusSpectrogramStream* stream = cactus_spectrogram_stream_create(
+            nullptr, 0, n_fft, hop, &fft_length, 2.0f, true, "constant", nullptr,
+            mel_filters.data(), mel_filters.size(), 1e-10f, "log", 1.0f, 1e-10f, false);
+        std::vector<float> frames((chunk_samples / hop + 1) * num_mel_bins);
+        size_t offset = 0;
+        bench("log-mel 100ms stream push", [&]{
+            if (offset + chunk_samples > waveform.size()) offset = 0;
+            size_t ready = cactus_spectrogram_stream_push(stream, waveform.data() + offset, chunk_samples);
+            cactus_spectrogram_stream_read(stream, frames.data(), ready);
+            offset += chunk_samples;
+        });
+        cactus_spectrogram_stream_destroy(stream);
+    }
+
     return true;
 }
 
@@ -199,10 +388,13 @@ int main() {
 
     runner.run_test("RFFT/IRFFT Roundtrip", test_rfft_irfft_roundtrip());
     runner.run_test("RFFT DC Signal", test_rfft_dc_signal());
+    runner.run_test("RFFT Mixed Radix = DFT", test_rfft_mixed_radix_matches_dft());
+    runner.run_test("RFFT Batch = Single", test_rfft_batch_matches_single());
     runner.run_test("Mel Filter Bank", test_mel_filter_bank());
     runner.run_test("Hertz/Mel Roundtrip", test_hertz_mel_roundtrip());
     runner.run_test("Spectrogram Basic", test_spectrogram_basic());
     runner.run_test("Spectrogram to dB", test_spectrogram_to_db());
+    runner.run_test("Spectrogram Stream = Batch", test_spectrogram_stream_matches_batch());
     runner.print_benchmarks_header();
     runner.run_bench("benchmarks", run_benchmarks());
     runner.print_summary();
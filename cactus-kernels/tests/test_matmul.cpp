@@ -574,6 +574,50 @@ static bool test_cq4_interleaved(double& mse_out,
     return mse_out <= 0.1;
 }
 
+// Fused RMSNorm + IL CQ4 decode must match the unfused rms_norm -> quant_matmul pair; M > 1
+// takes the fallback path and is checked the same way.
+static bool test_cq4_rms_norm_fused(uint32_t M) {
+    const uint32_t K = 1024, N = 192, gs = 128;
+    SyntheticCQ cq(4, K, N, gs, 901);
+    CactusQuantMatrix mat = cq.matrix_interleaved();
+
+    std::vector<__fp16> x(size_t(M) * K), w(K), normed(x.size());
+    fill_random_fp16(x, -4.0f, 4.0f);
+    fill_random_fp16(w, 0.5f, 1.5f);
+    cactus_rms_norm_f16(x.data(), w.data(), normed.data(), M, K, 1e-6f);
+
+    std::vector<__fp16> ref(size_t(M) * N), fused(ref.size());
+    for (uint32_t m = 0; m < M; m++)
+        cactus_quant_matmul(&mat, normed.data() + size_t(m) * K, 1, ref.data() + size_t(m) * N);
+    cactus_quant_rms_norm_matmul(&mat, x.data(), w.data(), 1e-6f, M, fused.data());
+    return compare_arrays(ref.data(), fused.data(), ref.size(), 1e-2f);
+}
+
+// Small-M kernel (M = 2..8) through the real dispatch: every row must match the M = 1 decode of
+// the same row and stay within the FP32-oracle MSE bound. N = 66 leaves a partial 4-row block.
+static bool test_cq_small_m(uint32_t bits, bool interleaved) {
+    const uint32_t K = 512, N = interleaved ? 64 : 66, gs = 128;
+    SyntheticCQ cq(bits, K, N, gs, 300 + bits);
+    CactusQuantMatrix mat = interleaved ? cq.matrix_interleaved() : cq.matrix();
+
+    for (uint32_t M : {2u, 3u, 8u}) {
+        std::vector<__fp16> x(size_t(M) * K), batched(size_t(M) * N), single(size_t(M) * N);
+        fill_random_fp16(x, -1.0f, 1.0f);
+        cactus_quant_matmul(&mat, x.data(), M, batched.data());
+        for (uint32_t m = 0; m < M; m++)
+            cactus_quant_matmul(&mat, x.data() + size_t(m) * K, 1, single.data() + size_t(m) * N);
+        if (!compare_arrays(single.data(), batched.data(), batched.size(), 1e-2f)) return false;
+
+        for (uint32_t m = 0; m < M; m++) {
+            std::vector<float> x_f32(K), ref(N, 0.f);
+            for (uint32_t k = 0; k < K; k++) x_f32[k] = static_cast<float>(x[size_t(m) * K + k]);
+            cq_reference_gemv_f32(cq, x_f32.data(), ref.data());
+            if (compute_mse(ref.data(), batched.data() + size_t(m) * N, N) > 0.1) return false;
+        }
+    }
+    return true;
+}
+
 int main() {
     TestRunner runner("Matrix Multiplication");
     runner.run_test("matmul_f16", test_matmul_f16());
@@ -588,6 +632,13 @@ int main() {
         double m_mt = 0;
         runner.run_test("matmul_cq4_il_mt", test_cq4_interleaved(m_mt, 1024, 4164, 128));
     }
+    runner.run_test("matmul_cq1_small_m", test_cq_small_m(1, false));
+    runner.run_test("matmul_cq2_small_m", test_cq_small_m(2, false));
+    runner.run_test("matmul_cq3_small_m", test_cq_small_m(3, false));
+    runner.run_test("matmul_cq4_small_m", test_cq_small_m(4, false));
+    runner.run_test("matmul_cq4_il_small_m", test_cq_small_m(4, true));
+    runner.run_test("cq4_rms_norm_fused", test_cq4_rms_norm_fused(1));
+    runner.run_test("cq4_rms_norm_fallback", test_cq4_rms_norm_fused(3));
     runner.print_benchmarks_header();
     runner.run_bench("benchmarks", run_benchmarks());
     print_mse_report();
@@ -1,6 +1,7 @@
 #include "test_utils.h"
 #include <vector>
 #include <cmath>
+#include <random>
 
 using namespace TestUtils;
 
@@ -185,6 +186,58 @@ bool test_neon_variance_axis_non_inner1_correctness() {
     return TestUtils::compare_arrays(output.data(), expected.data(), expected.size(), 0.05f);
 }
 
+bool test_masked_argmax() {
+    std::mt19937 rng(7);
+    for (size_t n : {64ul, 1000ul, 4096ul + 37}) {
+        std::vector<float> logits(n);
+        std::vector<__fp16> logits_h(n);
+        std::uniform_real_distribution<float> dist(-8.0f, 8.0f);
+        for (size_t i = 0; i < n; i++) {
+            logits_h[i] = static_cast<__fp16>(dist(rng));
+            logits[i] = static_cast<float>(logits_h[i]);
+        }
+
+        for (int pattern = 0; pattern < 4; pattern++) {
+            std::vector<uint64_t> mask((n + 63) / 64, 0);
+            for (size_t i = 0; i < n; i++) {
+                bool keep = pattern == 0 ? true : pattern == 1 ? (rng() % 7 == 0) : pattern == 2 ? (i / 64) % 3 == 1 : i == n - 1;
+                if (keep) mask[i / 64] |= 1ULL << (i % 64);
+            }
+
+            size_t expected = n;
+            float expected_v = -INFINITY;
+            for (size_t i = 0; i < n; i++) {
+                if (((mask[i / 64] >> (i % 64)) & 1) && logits[i] > expected_v) {
+                    expected_v = logits[i];
+                    expected = i;
+                }
+            }
+
+            float v32 = 0.0f, v16 = 0.0f;
+            size_t got32 = cactus_masked_argmax_f32(logits.data(), mask.data(), n, &v32);
+            size_t got16 = cactus_masked_argmax_f16(logits_h.data(), mask.data(), n, &v16);
+            if (got32 != expected || got16 != expected || v32 != expected_v || v16 != expected_v) {
+                std::cerr << "  masked_argmax n=" << n << " pattern=" << pattern << ": got " << got32 << "/" << got16
+                          << " expected " << expected << "\n";
+                return false;
+            }
+        }
+    }
+
+    std::vector<float> logits(128, 1.0f);
+    std::vector<uint64_t> empty(2, 0);
+    if (cactus_masked_argmax_f32(logits.data(), empty.data(), logits.size(), nullptr) != logits.size()) return false;
+
+    std::vector<float> banned(200, -INFINITY);
+    std::vector<__fp16> banned_h(banned.size(), static_cast<__fp16>(-INFINITY));
+    banned[3] = banned_h[3] = 5.0f;
+    std::vector<uint64_t> allowed(4, 0);
+    allowed[1] = 1ULL << 9;
+    allowed[3] = 1ULL << 2;
+    return cactus_masked_argmax_f32(banned.data(), allowed.data(), banned.size(), nullptr) == 73 &&
+           cactus_masked_argmax_f16(banned_h.data(), allowed.data(), banned_h.size(), nullptr) == 73;
+}
+
 bool run_benchmarks(TestRunner& runner) {
     (void)runner;
     auto benchmark = [&](const std::string& label, size_t n, auto fn) {
@@ -249,7 +302,20 @@ bool run_benchmarks(TestRunner& runner) {
         );
     });
 
-    (void)sink_d; (void)sink_h;
+    const size_t vocab = 262144;
+    std::vector<uint64_t> sparse_mask(vocab / 64, 0);
+    for (size_t i = 0; i < vocab; i += 997) sparse_mask[i / 64] |= 1ULL << (i % 64);
+    std::vector<uint64_t> dense_mask(vocab / 64, ~0ULL);
+    volatile size_t sink_i = 0;
+
+    benchmark("masked_argmax 256K sparse", vocab, [&]{
+        sink_i = cactus_masked_argmax_f16(data.data(), sparse_mask.data(), vocab, nullptr);
+    });
+    benchmark("masked_argmax 256K dense", vocab, [&]{
+        sink_i = cactus_masked_argmax_f16(data.data(), dense_mask.data(), vocab, nullptr);
+    });
+
+    (void)sink_d; (void)sink_h; (void)sink_i;
     return true;
 }
 
@@ -263,6 +329,7 @@ int main() {
     runner.run_test("Kernel Sum/Mean/Min/Max Axis Inner1 FP16 Correctness", test_neon_axis_inner1_correctness());
     runner.run_test("Kernel Variance Axis Inner1 FP16 Correctness", test_neon_variance_axis_inner1_correctness());
     runner.run_test("Kernel Variance Axis Non-Inner1 FP16 Correctness", test_neon_variance_axis_non_inner1_correctness());
+    runner.run_test("masked_argmax", test_masked_argmax());
     runner.print_benchmarks_header();
     runner.run_bench("benchmarks", run_benchmarks(runner));
     runner.print_summary();
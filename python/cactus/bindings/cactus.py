@@ -382,6 +382,11 @@ _lib.cactus_graph_rms_norm.argtypes = [
     cactus_graph_t, cactus_node_t, cactus_node_t, ctypes.c_float, ctypes.POINTER(cactus_node_t)
 ]
 _lib.cactus_graph_rms_norm.restype = ctypes.c_int
+_bind_optional(
+    "cactus_graph_rms_norm_matmul",
+    [cactus_graph_t, cactus_node_t, cactus_node_t, cactus_node_t, ctypes.c_float, ctypes.POINTER(cactus_node_t)],
+    ctypes.c_int,
+)
 _lib.cactus_graph_topk.argtypes = [
     cactus_graph_t, cactus_node_t, ctypes.c_size_t, ctypes.POINTER(cactus_node_t)
 ]
@@ -424,6 +429,25 @@ _lib.cactus_graph_kv_cache_append.argtypes = [
     ctypes.POINTER(cactus_node_t),
 ]
 _lib.cactus_graph_kv_cache_append.restype = ctypes.c_int
+_bind_optional(
+    "cactus_graph_qkv_rope_cache_append",
+    [
+        cactus_graph_t,
+        cactus_node_t,
+        cactus_node_t,
+        cactus_node_t,
+        cactus_node_t,
+        cactus_node_t,
+        cactus_node_t,
+        ctypes.c_size_t,
+        ctypes.c_float,
+        ctypes.c_size_t,
+        ctypes.c_size_t,
+        ctypes.c_size_t,
+        ctypes.POINTER(cactus_node_t),
+    ],
+    ctypes.c_int,
+)
 _lib.cactus_graph_attention_cached.argtypes = [
     cactus_graph_t,
     cactus_node_t,
@@ -573,6 +597,8 @@ _bind_optional(
         ctypes.c_size_t,
         ctypes.c_size_t,
         ctypes.c_size_t,
+        ctypes.c_bool,
+        ctypes.c_bool,
         ctypes.POINTER(cactus_node_t),
     ],
     ctypes.c_int,
@@ -2074,6 +2100,23 @@ class Graph:
             raise RuntimeError(_err("graph_rms_norm failed"))
         return self._tensor_from_node(out.value)
 
+    def rms_norm_matmul(self, x, norm_weight, weight, eps=1e-5):
+        x = self._ensure_tensor(x)
+        norm_weight = self._ensure_tensor(norm_weight)
+        weight = self._ensure_tensor(weight)
+        out = cactus_node_t()
+        rc = _lib.cactus_graph_rms_norm_matmul(
+            self.h,
+            cactus_node_t(x.id),
+            cactus_node_t(norm_weight.id),
+            cactus_node_t(weight.id),
+            ctypes.c_float(float(eps)),
+            ctypes.byref(out),
+        )
+        if rc != 0:
+            raise RuntimeError(_err("graph_rms_norm_matmul failed"))
+        return self._tensor_from_node(out.value)
+
     def topk(self, x, k):
         x = self._ensure_tensor(x)
         out = cactus_node_t()
@@ -2204,6 +2247,36 @@ class Graph:
             raise RuntimeError(_err("graph_kv_cache_append failed"))
         return self._tensor_from_node(out.value)
 
+    def qkv_rope_cache_append(
+        self,
+        x,
+        q_weight,
+        k_weight,
+        v_weight,
+        k_cache_state,
+        v_cache_state,
+        head_dim,
+        theta,
+        position_offset,
+        window_size=0,
+        sink_size=4,
+    ):
+        nodes = [self._ensure_tensor(t) for t in (x, q_weight, k_weight, v_weight, k_cache_state, v_cache_state)]
+        out = cactus_node_t()
+        rc = _lib.cactus_graph_qkv_rope_cache_append(
+            self.h,
+            *[cactus_node_t(t.id) for t in nodes],
+            ctypes.c_size_t(int(head_dim)),
+            ctypes.c_float(float(theta)),
+            ctypes.c_size_t(int(position_offset)),
+            ctypes.c_size_t(int(window_size)),
+            ctypes.c_size_t(int(sink_size)),
+            ctypes.byref(out),
+        )
+        if rc != 0:
+            raise RuntimeError(_err("graph_qkv_rope_cache_append failed"))
+        return self._tensor_from_node(out.value)
+
     def attention_cached(
         self,
         query,
@@ -2463,7 +2536,7 @@ class Graph:
     def conv2d_k3s1p1(self, x, weight, bias=None):
         return self._conv_with_optional_bias("cactus_graph_conv2d_k3s1p1", x, weight, bias)
 
-    def conv2d(self, x, weight, bias=None, stride=1, padding=0, dilation=1, groups=1):
+    def conv2d(self, x, weight, bias=None, stride=1, padding=0, dilation=1, groups=1, nhwc_input=False, nhwc_output=False):
         return self._conv_with_optional_bias(
             "cactus_graph_conv2d",
             x,
@@ -2473,6 +2546,8 @@ class Graph:
             ctypes.c_size_t(int(padding)),
             ctypes.c_size_t(int(dilation)),
             ctypes.c_size_t(int(groups)),
+            ctypes.c_bool(bool(nhwc_input)),
+            ctypes.c_bool(bool(nhwc_output)),
         )
 
     def _conv_with_optional_bias(self, fn_name, x, weight, bias=None, *extra):